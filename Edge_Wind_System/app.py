@@ -61,6 +61,25 @@ from edgewind.models import db, User
 app = Flask(__name__)
 app.config.from_object(Config)
 
+
+class _ChunkedInputMiddleware:
+    """
+    设备端上报默认用 Transfer-Encoding: chunked（边生成边发，不带 Content-Length）。
+    eventlet 的 WSGI 服务器会解开分块，但不设置 wsgi.input_terminated，
+    Werkzeug 见不到 Content-Length 时就把请求体当成空的；这里补上该标志，让 request.get_data() 读到结尾。
+    """
+
+    def __init__(self, wsgi_app):
+        self.wsgi_app = wsgi_app
+
+    def __call__(self, environ, start_response):
+        if 'chunked' in environ.get('HTTP_TRANSFER_ENCODING', '').lower():
+            environ.setdefault('wsgi.input_terminated', True)
+        return self.wsgi_app(environ, start_response)
+
+
+app.wsgi_app = _ChunkedInputMiddleware(app.wsgi_app)
+
 # ==================== CSRF 保护（浏览器会话安全） ====================
 # 说明：
 # - CSRF 主要针对“浏览器携带 Cookie 的后台操作”（例如设置页/故障管理页的 POST 请求）。
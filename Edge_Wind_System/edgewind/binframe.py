@@ -0,0 +1,337 @@
+"""
+二进制遥测帧参考解码器（节点全量上报的 JSON 替代格式，POST /api/node/frame）
+
+说明：
+- 帧格式与下位机 Core/Inc/ad_frame.h 一一对应：固定头 + node_id + 若干段 + CRC32（小端）。
+- decode_frame() 只做结构解析与反量化，返回工程量；to_heartbeat_payload() 再转换成
+  与 /api/node/heartbeat JSON 完全相同的结构（waveform/value ×200 取整、fft_spectrum 1 位小数），
+  这样心跳处理、快照、历史曲线、前端都不需要区分上报格式。
+- 不认识的段类型按段长跳过（向前兼容新增段）；版本号不同或 CRC 不符直接拒收。
+- WAVE_Z / EVENT_Z 段是无损压缩的整数波形（下位机 Core/Src/ad_codec.c：分块 0/1/2 阶预测 + zigzag + Rice/定宽），
+  解出的整数与 JSON 上报逐点相同。
+- 帧头 flags 带 FLAG_SPOOL 的是断线期间写进 SD 缓存、恢复后补传的历史帧（附 TIME 段）；
+  实时帧附 SPOOL 段报告补传进度。
+"""
+
+from __future__ import annotations
+
+import math
+import struct
+import sys
+import zlib
+from array import array
+
+MAGIC = 0x46425745  # b'EWBF'
+VERSION = 1
+HDR_LEN = 32
+
+SEC_CHAN = 0x01
+SEC_WAVE = 0x02
+SEC_SPEC = 0x03
+SEC_HARM = 0x04
+SEC_CLASS = 0x05
+SEC_ISO = 0x06
+SEC_EVENT = 0x07
+SEC_WAVE_Z = 0x08
+SEC_EVENT_Z = 0x09
+SEC_SPOOL = 0x0A
+SEC_TIME = 0x0B
+
+# 帧头 flags
+FLAG_SPOOL = 0x01
+
+# ad_codec.h：Rice 一元部分上限（达到即逃逸为 32 位原值）
+CODEC_QMAX = 16
+CODEC_K_MAX = 23
+
+CH_NONE = 0xFF
+
+# 与 JSON 上报一致的定点缩放（esp8266.c ESP_UPLOAD_SCALE）
+UPLOAD_SCALE = 200
+
+# 物理通道元数据（与 esp8266.c s_ch_meta 一致，后端按 label 识别通道含义）
+CHANNEL_META = (
+    ("直流母线(+)", "V"),
+    ("直流母线(-)", "V"),
+    ("负载电流", "A"),
+    ("漏电流", "mA"),
+    ("组串电流1", "A"),
+    ("组串电流2", "A"),
+    ("漏电流2", "mA"),
+    ("漏电流3", "mA"),
+)
+
+# 与 ad_trigger.c AD_Trig_TypeName 一致
+TRIG_TYPE_NAMES = ("off", "above", "below", "rise", "fall", "dvdt", "spike", "soft")
+
+STATS_KEYS = ("mean", "rms", "min", "max", "p2p", "std", "crest", "skew", "kurt")
+
+_HDR = struct.Struct("<IBBBBIIIBBBB4sHH")
+_SEC = struct.Struct("<BBHI")
+_EVENT_HDR = struct.Struct("<IIIIIIBBBB4s")
+_EVENT_CH = struct.Struct("<BBHff")
+_WAVE_Z_HDR = struct.Struct("<fHHHH")
+_SPOOL = struct.Struct("<IIIIIB3x")
+
+
+class FrameError(ValueError):
+    """帧结构/校验错误（接口返回 400）。"""
+
+
+def _cstr(b: bytes) -> str:
+    return b.split(b"\0", 1)[0].decode("ascii", "replace")
+
+
+def _i16(buf, off: int, n: int) -> array:
+    a = array("h")
+    a.frombytes(bytes(buf[off:off + 2 * n]))
+    if sys.byteorder != "little":
+        a.byteswap()
+    return a
+
+
+def _codec_decode(buf, n: int, block: int) -> list:
+    """
+    解一条 ad_codec 码流（段首清历史，每块 ≤ block 个样本、字节对齐），返回 n 个整数。
+    位串用 str 处理：一元部分用 find 定位结束位 0，比逐位移位快一个数量级。
+    """
+    if block <= 0:
+        raise FrameError("bad codec block size")
+    data = bytes(buf)
+    bits = format(int.from_bytes(data, "big"), f"0{8 * len(data)}b") if data else ""
+    total = len(bits)
+    out = []
+    pos = 0
+    h1 = h2 = 0
+    while len(out) < n:
+        cnt = min(block, n - len(out))
+        if pos + 8 > total:
+            raise FrameError("truncated codec block")
+        hdr = int(bits[pos:pos + 8], 2)
+        pos += 8
+        order = hdr & 3
+        k = (hdr >> 2) & 0x1F
+        fixed = hdr & 0x80
+        if order > 2 or (not fixed and k > CODEC_K_MAX):
+            raise FrameError(f"bad codec block header 0x{hdr:02X}")
+        for _ in range(cnt):
+            if fixed:
+                z = int(bits[pos:pos + k] or "0", 2) if k else 0
+                pos += k
+            else:
+                j = bits.find("0", pos, pos + CODEC_QMAX)
+                if j < 0:
+                    z = int(bits[pos + CODEC_QMAX:pos + CODEC_QMAX + 32] or "0", 2)
+                    pos += CODEC_QMAX + 32
+                else:
+                    z = (j - pos) << k
+                    pos = j + 1
+                    if k:
+                        z |= int(bits[pos:pos + k] or "0", 2)
+                        pos += k
+            r = (z >> 1) ^ -(z & 1)
+            v = r + (0 if order == 0 else h1 if order == 1 else 2 * h1 - h2)
+            v = (v + 0x80000000) % 0x100000000 - 0x80000000
+            out.append(v)
+            h2, h1 = h1, v
+        if pos > total:
+            raise FrameError("truncated codec block")
+        pos = (pos + 7) & ~7
+    return out
+
+
+def _finite(v: float):
+    return v if math.isfinite(v) else None
+
+
+def decode_frame(buf: bytes) -> dict:
+    """
+    解析一帧，返回：
+    {'version','seq','sample_rate','tick_ms','ch_count','ch_mask','os_mode','acq_profile','fault_code','node_id',
+     'flags','spooled'(补传的缓存帧),
+     'channels': {phys: {'value','stats','waveform','wave_step','wave_codec'(WAVE_Z 时),'spectrum','harmonics'}},
+     'class': {...}|None, 'iso': {...}|None, 'event': {...}|None,
+     'spool': {...}|None（补传进度）, 'rtc_ts': int|None（缓存帧的采集 RTC 秒）, 'unknown_sections': int}
+    波形/频谱/事件均为工程量 float 列表。
+    """
+    mv = memoryview(buf)
+    n = len(mv)
+    if n < HDR_LEN + 4:
+        raise FrameError(f"frame too short ({n} bytes)")
+    (magic, version, hdr_len, node_len, flags, seq, sample_rate, tick_ms,
+     ch_count, ch_mask, os_mode, profile, fault_code, sections, _rsv) = _HDR.unpack_from(mv, 0)
+    if magic != MAGIC:
+        raise FrameError(f"bad magic 0x{magic:08X}")
+    if version != VERSION:
+        raise FrameError(f"unsupported frame version {version}")
+    if hdr_len < HDR_LEN or hdr_len + node_len + 4 > n:
+        raise FrameError("bad header length")
+    crc = struct.unpack_from("<I", mv, n - 4)[0]
+    if zlib.crc32(mv[:n - 4]) != crc:
+        raise FrameError("CRC mismatch")
+
+    out = {
+        'version': version,
+        'seq': seq,
+        'sample_rate': sample_rate,
+        'tick_ms': tick_ms,
+        'ch_count': ch_count,
+        'ch_mask': ch_mask,
+        'os_mode': os_mode,
+        'acq_profile': profile,
+        'fault_code': _cstr(fault_code) or 'E00',
+        'node_id': bytes(mv[hdr_len:hdr_len + node_len]).decode("utf-8", "replace"),
+        'flags': flags,
+        'spooled': bool(flags & FLAG_SPOOL),
+        'channels': {},
+        'class': None,
+        'iso': None,
+        'event': None,
+        'spool': None,
+        'rtc_ts': None,
+        'unknown_sections': 0,
+    }
+
+    off = hdr_len + node_len
+    end = n - 4
+    for _ in range(sections):
+        if off + _SEC.size > end:
+            raise FrameError("truncated section header")
+        stype, ch, _r, slen = _SEC.unpack_from(mv, off)
+        off += _SEC.size
+        if off + slen > end:
+            raise FrameError(f"truncated section type {stype}")
+        body = mv[off:off + slen]
+        off += slen
+
+        if stype in (SEC_CHAN, SEC_WAVE, SEC_WAVE_Z, SEC_SPEC, SEC_HARM):
+            c = out['channels'].setdefault(ch, {})
+            if stype == SEC_CHAN:
+                v = struct.unpack_from("<10f", body, 0)
+                c['value'] = v[0]
+                c['stats'] = dict(zip(STATS_KEYS, v[1:]))
+            elif stype == SEC_WAVE:
+                scale, offset, cnt, step = struct.unpack_from("<ffHH", body, 0)
+                q = _i16(body, 12, cnt)
+                c['waveform'] = [offset + x * scale for x in q]
+                c['wave_step'] = step
+            elif stype == SEC_WAVE_Z:
+                qscale, cnt, step, block, _r2 = _WAVE_Z_HDR.unpack_from(body, 0)
+                if not qscale:
+                    raise FrameError("bad WAVE_Z scale")
+                q = _codec_decode(body[_WAVE_Z_HDR.size:], cnt, block)
+                c['waveform'] = [x / qscale for x in q]
+                c['wave_step'] = step
+                c['wave_codec'] = True
+            elif stype == SEC_SPEC:
+                ref, db_step, cnt, step = struct.unpack_from("<ffHH", body, 0)
+                lut = [0.0] + [ref * 10.0 ** (-(255 - k) * db_step / 20.0) for k in range(1, 256)]
+                c['spectrum'] = [lut[k] for k in bytes(body[12:12 + cnt])]
+                c['spec_step'] = step
+            else:
+                c['harmonics'] = list(struct.unpack_from(f"<{slen // 4}f", body, 0))
+        elif stype == SEC_CLASS:
+            idx, code, _p, score, cyc = struct.unpack_from("<b4sBfI", body, 0)
+            out['class'] = {'idx': idx, 'code': _cstr(code), 'score': _finite(score), 'cyc': cyc}
+        elif stype == SEC_ISO:
+            mode, _p1, _p2, rp, rn, r, trend, rate = struct.unpack_from("<BBHfffff", body, 0)
+            out['iso'] = {'mode': 'bridge' if mode == 1 else 'passive', 'rp': rp, 'rn': rn, 'r': r,
+                          'trend': _finite(trend), 'rate': _finite(rate)}
+        elif stype in (SEC_EVENT, SEC_EVENT_Z):
+            (eseq, fs, pre, post, frames, step, trig_ch, trig_type, eos,
+             nch, ecode) = _EVENT_HDR.unpack_from(body, 0)
+            pts = (frames + step - 1) // step if step else 0
+            eoff = _EVENT_HDR.size
+            block = 0
+            if stype == SEC_EVENT_Z:
+                block, _r2 = struct.unpack_from("<HH", body, eoff)
+                eoff += 4
+            chans = []
+            for _i in range(nch):
+                phys, _a, _b, scale, offset = _EVENT_CH.unpack_from(body, eoff)
+                eoff += _EVENT_CH.size
+                if stype == SEC_EVENT_Z:
+                    nbytes = struct.unpack_from("<I", body, eoff)[0]
+                    eoff += 4
+                    if eoff + nbytes > len(body):
+                        raise FrameError("truncated EVENT_Z channel")
+                    q = _codec_decode(body[eoff:eoff + nbytes], pts, block)
+                    eoff += nbytes
+                else:
+                    q = _i16(body, eoff, pts)
+                    eoff += 2 * pts
+                chans.append({'id': phys, 'waveform': [offset + x * scale for x in q]})
+            out['event'] = {
+                'seq': eseq, 'fault_code': _cstr(ecode), 'trig_ch': trig_ch,
+                'trig_type': TRIG_TYPE_NAMES[trig_type] if trig_type < len(TRIG_TYPE_NAMES) else '?',
+                'fs': fs, 'os_mode': eos, 'pre': pre, 'post': post, 'frames': frames, 'step': step,
+                'channels': chans,
+            }
+        elif stype == SEC_SPOOL:
+            pending, pending_ev, kb, replayed, dropped, replaying = _SPOOL.unpack_from(body, 0)
+            out['spool'] = {'pending': pending, 'pending_ev': pending_ev, 'kb': kb, 'replayed': replayed,
+                            'dropped': dropped, 'replaying': replaying}
+        elif stype == SEC_TIME:
+            out['rtc_ts'] = struct.unpack_from("<I", body, 0)[0]
+        else:
+            out['unknown_sections'] += 1
+    return out
+
+
+def _scaled(v: float) -> int:
+    # 与 ESP_FloatToI32Scaled 相同的四舍五入（远离 0）
+    x = v * UPLOAD_SCALE
+    return int(x + 0.5) if x >= 0 else int(x - 0.5)
+
+
+def _meta(phys: int):
+    return CHANNEL_META[phys] if 0 <= phys < len(CHANNEL_META) else (f"CH{phys}", "")
+
+
+def to_heartbeat_payload(frame: dict) -> dict:
+    """把 decode_frame() 的结果转换为 /api/node/heartbeat 的 JSON 结构（与 ESP_Post_Data 输出一致）。"""
+    channels = []
+    for phys in sorted(frame['channels']):
+        c = frame['channels'][phys]
+        label, unit = _meta(phys)
+        value = _scaled(c.get('value', 0.0))
+        ch = {
+            'id': phys, 'channel_id': phys,
+            'label': label, 'name': label,
+            'value': value, 'current_value': value,
+            'unit': unit,
+            'waveform': [_scaled(v) for v in c.get('waveform', [])],
+            'fft_spectrum': [round(v, 1) for v in c.get('spectrum', [])],
+            'harmonics': [round(v, 4) for v in c.get('harmonics', [])],
+        }
+        if 'stats' in c:
+            ch['stats'] = {k: (round(v, 4) if math.isfinite(v) else 0.0) for k, v in c['stats'].items() if k != 'mean'}
+        channels.append(ch)
+
+    payload = {
+        'node_id': frame['node_id'],
+        'status': 'online',
+        'fault_code': frame['fault_code'],
+        'seq': frame['seq'],
+        'sample_rate': frame['sample_rate'],
+        'os_mode': frame['os_mode'],
+        'acq_profile': frame['acq_profile'],
+        'channels': channels,
+        'frame_format': 'binary',
+    }
+    if frame.get('class'):
+        payload['class'] = dict(frame['class'])
+    if frame.get('iso'):
+        payload['iso'] = dict(frame['iso'])
+    if frame.get('spool'):
+        payload['spool'] = dict(frame['spool'])
+    ev = frame.get('event')
+    if ev:
+        payload['event'] = {
+            **{k: v for k, v in ev.items() if k != 'channels'},
+            'channels': [{
+                'id': c['id'], 'label': _meta(c['id'])[0], 'unit': _meta(c['id'])[1],
+                'waveform': [_scaled(v) for v in c['waveform']],
+            } for c in ev['channels']],
+        }
+    return payload
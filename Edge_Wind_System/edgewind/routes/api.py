@@ -4,18 +4,20 @@ API路由蓝图
 """
 from flask import Blueprint, request, jsonify
 from flask_login import login_required
-from datetime import datetime, timedelta
+from datetime import datetime, timedelta, timezone
 from edgewind.models import db, Device, DataPoint, WorkOrder, SystemConfig, FaultSnapshot, HistoryData
 from edgewind.knowledge_graph import FAULT_KNOWLEDGE_GRAPH, FAULT_CODE_MAP, generate_ai_report, get_fault_knowledge_graph
+from edgewind.binframe import FrameError, decode_frame, to_heartbeat_payload
 from edgewind.utils import (
     save_to_buffer, get_latest_normal_data, get_latest_fault_data,
     node_fault_states, node_snapshot_saved, save_fault_snapshot, create_work_order_from_fault
 )
 import time
 import json
+import struct
 import logging
 from urllib.parse import unquote
-from collections import defaultdict
+from collections import defaultdict, deque
 import os
 import sys
 from pathlib import Path
@@ -25,7 +27,7 @@ from urllib.parse import quote
 import re
 
 from flask import send_file
-from edgewind.time_utils import fmt_beijing, iso_beijing, to_beijing
+from edgewind.time_utils import BEIJING_TZ, fmt_beijing, iso_beijing, to_beijing
 
 api_bp = Blueprint('api', __name__, url_prefix='/api')
 logger = logging.getLogger(__name__)
@@ -36,12 +38,18 @@ _last_hb_log_ts = {}
 _last_perf_log_ts = {}  # {node_id: ts}
 _last_processed_cache = {}  # {node_id: processed_data}：用于兜底填充空波形/频谱，避免前端周期性卡顿
 _last_bad_frame_log_ts = {}  # {node_id: ts}：坏帧诊断限频日志
+_spool_seen = {}  # {node_id: deque[(seq, tick_ms)]}：断线缓存补传帧去重（节点没收到回包会重发同一条）
+SPOOL_SEEN_MAX = 512
 
 # 全局变量（将从app传入）
 active_nodes = {}  # 将在app.py中初始化并传入
 node_commands = {}  # 将在app.py中初始化并传入
 node_report_modes = {}  # {node_id: 'summary'|'full'}
 DEFAULT_REPORT_MODE = 'summary'
+# 待下发的采样档位（与下位机 ad_acq_buffers.c 档位表一致：0=25.6kHz/OSx1 1=12.8kHz/OSx2 2=6.4kHz/OSx4 3=3.2kHz/OSx8）
+# 心跳上报的 acq_profile 与之相同即视为已生效并清除，之后节点本地改档位不会被服务器拉回
+node_acq_profiles = {}  # {node_id: int}
+ACQ_PROFILE_COUNT = 4
 
 # 节点超时时间（秒）
 # 说明：此前为 10s，网络/设备偶发抖动（或一次心跳解析失败）就会导致节点被清空，前端表现为“运行一段时间后停机/无节点”。
@@ -539,16 +547,131 @@ def upload_data():
 
 # ==================== 节点心跳API ====================
 
+@api_bp.route('/node/frame', methods=['POST'])
+def node_frame():
+    """
+    节点全量上报（二进制帧，application/octet-stream）：
+    解码为与 JSON 心跳相同的结构后走同一套心跳处理，回包也相同（命令/上报模式/采样档位）。
+    帧格式见 edgewind/binframe.py 与下位机 ad_frame.h。
+    """
+    auth_resp = _device_auth_or_401()
+    if auth_resp:
+        return auth_resp
+    raw = request.get_data(cache=False)
+    try:
+        frame = decode_frame(raw)
+        payload = to_heartbeat_payload(frame)
+    except (FrameError, struct.error, IndexError) as e:
+        logger.warning(f"[/api/node/frame] bad frame: len={len(raw)} {e}")
+        return jsonify({'error': f'Bad frame: {e}'}), 400
+    if frame.get('spooled'):
+        return _node_spool_replay(frame, payload)
+    return node_heartbeat(payload)
+
+
+def _spool_capture_time(frame: dict):
+    """
+    补传帧的采集时刻（UTC，naive）：
+    1) X-Spool-Age-Ms：节点本次上电写的记录，按节点 tick 算出的采集距今毫秒数（不依赖 RTC）
+    2) TIME 段的 RTC 秒（节点 RTC 按北京时间走；未校时的明显不合理值不用）
+    3) 都没有就按收到时刻
+    """
+    now = datetime.utcnow()
+    age = request.headers.get('X-Spool-Age-Ms')
+    if age and age.isdigit():
+        return now - timedelta(milliseconds=int(age)), 'age'
+    rtc = frame.get('rtc_ts')
+    if isinstance(rtc, int) and rtc > 0:
+        ts = (datetime(1970, 1, 1) + timedelta(seconds=rtc)).replace(tzinfo=BEIJING_TZ)
+        ts = ts.astimezone(timezone.utc).replace(tzinfo=None)
+        if now - timedelta(days=400) <= ts <= now + timedelta(days=1):
+            return ts, 'rtc'
+    return now, 'recv'
+
+
+def _node_spool_replay(frame: dict, data: dict):
+    """
+    断线缓存补传的历史帧（帧头 FLAG_SPOOL）：按采集时刻落历史曲线与快照，
+    不刷新实时状态、不推送前端、不参与故障发生/恢复判定，也不下发命令（命令走实时上报的回包）。
+    回显 seq，节点据此确认送达后推进 SD 读游标；同一 seq 重发（回包丢失）只回包不重复落库。
+    """
+    node_id = _normalize_node_id(data.get('node_id'))
+    if not node_id:
+        return jsonify({'error': 'Missing node_id'}), 400
+    seq = data.get('seq')
+    resp = {'success': True, 'node_id': node_id, 'seq': seq, 'replay': True,
+            'report_mode': _get_report_mode(node_id)}
+
+    key = (seq, frame.get('tick_ms'))
+    seen = _spool_seen.setdefault(node_id, deque(maxlen=SPOOL_SEEN_MAX))
+    if key in seen:
+        resp['duplicate'] = True
+        return jsonify(resp)
+    seen.append(key)
+
+    ts, ts_src = _spool_capture_time(frame)
+    fault_code = (data.get('fault_code') or 'E00').strip() or 'E00'
+    logger.info(f"[/api/node/frame] spool replay node_id={node_id} seq={seq} fault={fault_code} "
+                f"captured={fmt_beijing(ts)}({ts_src})")
+
+    values = {'voltage': 0.0, 'voltage_neg': 0.0, 'current': 0.0, 'leakage': 0.0}
+    mapped = set()
+    for ch in data.get('channels') or []:
+        kind = _channel_kind((ch.get('label') or '').strip(), ch.get('id'))
+        if kind and kind not in mapped:
+            mapped.add(kind)
+            try:
+                values[kind] = float(ch.get('value', 0) or 0)
+            except Exception:
+                pass
+    try:
+        db.session.add(HistoryData(
+            device_id=node_id, timestamp=ts,
+            voltage_pos=values['voltage'], voltage_neg=values['voltage_neg'],
+            current=values['current'], leakage=values['leakage']))
+        db.session.commit()
+    except Exception as e:
+        db.session.rollback()
+        logger.warning(f"[HistoryData] 保存补传历史数据失败: {node_id} - {e}")
+
+    event = data.pop('event', None)
+    if db_executor:
+        if isinstance(event, dict) and isinstance(event.get('channels'), list):
+            ev_code = (str(event.get('fault_code') or '').strip() or fault_code)[:10]
+            db_executor.submit(save_fault_snapshot, db, app_instance, node_id, ev_code, 'transient', event, ts)
+        if fault_code != 'E00':
+            # 断线期间的故障现场：单独标为 'spooled'，不触发建单（故障发生/恢复由实时上报判定）
+            db_executor.submit(save_fault_snapshot, db, app_instance, node_id, fault_code, 'spooled', data, ts)
+    return jsonify(resp)
+
+
+def _channel_kind(label: str, ch_id):
+    """通道含义：先按 label 识别（中文优先），识别不了按通道 id 兜底"""
+    kind = None
+    if "直流" in label:
+        # 兼容：label=“直流母线” 未标注正负时，默认当作正母线
+        kind = 'voltage_neg' if (("-" in label) or ("负" in label)) else 'voltage'
+    elif "漏" in label:
+        kind = 'leakage'
+    elif ("负载" in label or "电流" in label) and "漏" not in label:
+        kind = 'current'
+
+    # label 无法识别时，按通道 id 做兜底映射（与你给的示例结构一致）
+    if (kind is None) and isinstance(ch_id, int):
+        kind = {0: 'voltage', 1: 'current', 2: 'leakage'}.get(ch_id)
+    return kind
+
+
 @api_bp.route('/node/heartbeat', methods=['POST'])
-def node_heartbeat():
-    """节点心跳接口 - 接收STM32节点的实时数据"""
+def node_heartbeat(payload=None):
+    """节点心跳接口 - 接收STM32节点的实时数据（payload：/api/node/frame 已解码的二进制帧）"""
     try:
         t0 = time.perf_counter()
         auth_resp = _device_auth_or_401()
         if auth_resp:
             return auth_resp
 
-        data = _get_json_payload()
+        data = payload if payload is not None else _get_json_payload()
         t_json = time.perf_counter()
         node_id = _normalize_node_id(data.get('node_id') or data.get('device_id'))
         fault_code = (data.get('fault_code') or 'E00').strip() or 'E00'
@@ -564,6 +687,20 @@ def node_heartbeat():
         if current_timestamp - last >= 5:
             _last_hb_log_ts[node_id] = current_timestamp
             logger.info(f"[/api/node/heartbeat] node_id={node_id} fault={fault_code} ch={len(data.get('channels') or [])}")
+            spool = data.get('spool')
+            if isinstance(spool, dict) and spool.get('pending'):
+                logger.info(f"[/api/node/heartbeat] node_id={node_id} SD 断线缓存待补传 {spool.get('pending')} 条"
+                            f"（事件 {spool.get('pending_ev')}）{spool.get('kb')} KB，已补传 {spool.get('replayed')}")
+
+        # 0.1 瞬态录波事件（节点按触发条件录制的预/后触发波形，随心跳附带一次）
+        # 单独落库为 'transient' 快照，不放进 active_nodes，避免推送/内存开销
+        event = data.pop('event', None)
+        if isinstance(event, dict) and isinstance(event.get('channels'), list):
+            ev_code = (str(event.get('fault_code') or '').strip() or fault_code)[:10]
+            logger.info(f"[/api/node/heartbeat] node_id={node_id} transient event seq={event.get('seq')} "
+                        f"code={ev_code} trig_ch={event.get('trig_ch')} type={event.get('trig_type')} "
+                        f"frames={event.get('frames')} step={event.get('step')}")
+            db_executor.submit(save_fault_snapshot, db, app_instance, node_id, ev_code, 'transient', event)
 
         # 1. Update Active Node
         # 1. Update Active Node（可选：轻量化存储，避免多节点时内存/序列化成本过高）
@@ -589,7 +726,12 @@ def node_heartbeat():
             }
 
         # 2. Initialize Data Structure
+        # 采样参数随每个块上报（档位可运行期切换），前端据此换算时间轴/频率轴
+        sample_rate = data.get('sample_rate')
+        os_mode = data.get('os_mode')
         processed_data = {
+            'sample_rate': sample_rate if isinstance(sample_rate, int) and sample_rate > 0 else None,
+            'os_mode': os_mode if isinstance(os_mode, int) else None,
             'voltage': 0, 'voltage_neg': 0, 'current': 0, 'leakage': 0,
             'voltage_waveform': [], 'voltage_spectrum': [],
             'voltage_neg_waveform': [], 'voltage_neg_spectrum': [],
@@ -605,6 +747,7 @@ def node_heartbeat():
         bad_spec_type = 0
         bad_id_type = 0
         bad_val = 0
+        mapped_kinds = set()
         for ch in raw_channels:
             if not isinstance(ch, dict):
                 continue
@@ -634,44 +777,15 @@ def node_heartbeat():
                 val_float = 0.0
                 bad_val += 1
 
-            # 先按 label 识别（中文优先）
-            mapped = False
-            if "直流" in label:
-                # 兼容：label=“直流母线” 未标注正负时，默认当作正母线
-                if ("-" in label) or ("负" in label):
-                    processed_data['voltage_neg'] = val_float
-                    processed_data['voltage_neg_waveform'] = wave
-                    processed_data['voltage_neg_spectrum'] = spec
-                else:
-                    processed_data['voltage'] = val_float
-                    processed_data['voltage_waveform'] = wave
-                    processed_data['voltage_spectrum'] = spec
-                mapped = True
-            elif "漏" in label:
-                processed_data['leakage'] = val_float
-                processed_data['leakage_waveform'] = wave
-                processed_data['leakage_spectrum'] = spec
-                mapped = True
-            elif ("负载" in label or "电流" in label) and "漏" not in label:
-                processed_data['current'] = val_float
-                processed_data['current_waveform'] = wave
-                processed_data['current_spectrum'] = spec
-                mapped = True
-
-            # label 无法识别时，按通道 id 做兜底映射（与你给的示例结构一致）
-            if (not mapped) and isinstance(ch_id, int):
-                if ch_id == 0:
-                    processed_data['voltage'] = val_float
-                    processed_data['voltage_waveform'] = wave
-                    processed_data['voltage_spectrum'] = spec
-                elif ch_id == 1:
-                    processed_data['current'] = val_float
-                    processed_data['current_waveform'] = wave
-                    processed_data['current_spectrum'] = spec
-                elif ch_id == 2:
-                    processed_data['leakage'] = val_float
-                    processed_data['leakage_waveform'] = wave
-                    processed_data['leakage_spectrum'] = spec
+            kind = _channel_kind(label, ch_id)
+
+            # 8 通道节点会有多路同类通道（组串电流1/2、漏电流2/3）：
+            # 汇总字段只取同类中的第一路，其余通道仍保留在原始 channels 中
+            if kind and kind not in mapped_kinds:
+                mapped_kinds.add(kind)
+                processed_data[kind] = val_float
+                processed_data[kind + '_waveform'] = wave
+                processed_data[kind + '_spectrum'] = spec
 
         t_parse = time.perf_counter()
 
@@ -823,6 +937,10 @@ def node_heartbeat():
             'node_id': node_id, 
             'timestamp': current_timestamp
         }
+        # 回显上报序号：节点流水线上报（多个请求在途）按它把回包对应到请求、统计 RTT
+        seq = data.get('seq')
+        if isinstance(seq, int) and not isinstance(seq, bool):
+            response_payload['seq'] = seq
         # 命令下发（不要 pop，避免命令丢失；fault_code=E00 时视为已执行并清除）
         cmd = node_commands.get(node_id)
         if cmd:
@@ -830,6 +948,13 @@ def node_heartbeat():
             if cmd == 'reset' and fault_code == 'E00':
                 node_commands.pop(node_id, None)
         response_payload['report_mode'] = _get_report_mode(node_id)
+        want_profile = node_acq_profiles.get(node_id)
+        if want_profile is not None:
+            if data.get('acq_profile') == want_profile:
+                node_acq_profiles.pop(node_id, None)
+                logger.info(f"[/api/node/heartbeat] node_id={node_id} acq_profile={want_profile} 已生效")
+            else:
+                response_payload['acq_profile'] = want_profile
         
         # 9. 节流更新数据库设备心跳（避免 50Hz 高频心跳把 SQLite 打爆）
         last_db = _last_db_heartbeat_ts.get(node_id, 0)
@@ -1003,6 +1128,30 @@ def set_node_report_mode():
         return jsonify({'success': False, 'error': str(e)}), 500
 
 
+@api_bp.route('/nodes/acq_profile', methods=['POST'])
+@login_required
+def set_node_acq_profile():
+    """设置节点采样档位（采样率 + 过采样），随下一次心跳回包下发，节点在下一个采样块切换"""
+    try:
+        payload = request.get_json() or {}
+        node_id = _normalize_node_id(payload.get('node_id') or payload.get('device_id'))
+        profile = payload.get('profile')
+
+        if not node_id:
+            return jsonify({'success': False, 'error': 'Missing node_id'}), 400
+        if len(node_id) > 100:
+            return jsonify({'success': False, 'error': 'node_id too long (max 100)'}), 400
+        if isinstance(profile, bool) or not isinstance(profile, int) or not (0 <= profile < ACQ_PROFILE_COUNT):
+            return jsonify({'success': False, 'error': f'Invalid profile (0..{ACQ_PROFILE_COUNT - 1})'}), 400
+
+        node_acq_profiles[node_id] = profile
+        return jsonify({'success': True, 'node_id': node_id, 'acq_profile': profile}), 200
+
+    except Exception as e:
+        logger.exception(f"[/api/nodes/acq_profile] 失败: {e}")
+        return jsonify({'success': False, 'error': str(e)}), 500
+
+
 # ==================== 知识图谱API ====================
 
 def _infer_fault_code_from_fault_type(fault_type: str | None) -> str:
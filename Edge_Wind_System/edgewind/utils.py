@@ -67,7 +67,7 @@ def calculate_statistics(waveform):
     }
 
 
-def save_fault_snapshot(db, app, device_id, fault_code, snapshot_type, data):
+def save_fault_snapshot(db, app, device_id, fault_code, snapshot_type, data, timestamp=None):
     """
     保存故障快照到数据库（在后台线程中执行）
     
@@ -78,6 +78,7 @@ def save_fault_snapshot(db, app, device_id, fault_code, snapshot_type, data):
         fault_code: 故障代码 (E01-E05)
         snapshot_type: 'before' 或 'after'
         data: 完整的数据包（包含channels数组）
+        timestamp: 采集时刻（UTC，naive）；None 为当前时间（断线缓存补传的帧用还原出的采集时刻）
     """
     # 导入模型（延迟导入避免循环依赖）
     from edgewind.models import FaultSnapshot
@@ -104,7 +105,7 @@ def save_fault_snapshot(db, app, device_id, fault_code, snapshot_type, data):
                     device_id=device_id,
                     fault_code=fault_code,
                     snapshot_type=snapshot_type,
-                    timestamp=datetime.utcnow(),
+                    timestamp=timestamp or datetime.utcnow(),
                     channel_id=channel.get('id', 0),
                     channel_label=channel.get('label', ''),
                     channel_type=channel.get('type', ''),
@@ -5,25 +5,162 @@
 extern "C" {
 #endif
 
-/* 采样双缓冲（4通道×4096点）与填充状态。
- * 说明：为尽量少改动现有 FFT/UI/上报链路，继续沿用历史变量名。 */
+#include <stdint.h>
+#include "main.h" /* AD_ACQ_POINTS / AD_ACQ_CH_MASK 在 main.h 统一配置 */
+
+/* 采样块环形缓冲（单生产者/多消费者，无锁）
+ * - 槽内保存 AD7606 原始码（int16，两补码），中断里不做任何浮点换算
+ * - 生产者：采样中断逐帧写入当前槽，写满 AD_ACQ_POINTS 点后发布（分配块序号 + 时间戳）
+ * - 消费者：AD_Acq_AcquireLatest/AcquireNext 取得块后持有只读引用，用完 AD_Acq_Release
+ * - 生产者永远不会覆盖被持有的槽；找不到空闲槽时丢弃新帧并计入 dropped_frames
+ * - 消费者跟不上时，通过块序号差值计入各自的 skipped */
 
 #ifndef AD_ACQ_POINTS
 #define AD_ACQ_POINTS 4096
 #endif
 
-extern float ADSA_B[4][AD_ACQ_POINTS];
-extern float ADSA_B2[4][AD_ACQ_POINTS];
-extern float ADS131A04_Buf[4];
+/* 启用的物理通道掩码（bit n = AD7606 V(n+1)），未启用的通道不占缓冲、不进任何循环 */
+#ifndef AD_ACQ_CH_MASK
+#define AD_ACQ_CH_MASK 0x0Fu
+#endif
+
+#if ((AD_ACQ_CH_MASK) == 0u) || (((AD_ACQ_CH_MASK) & ~0xFFu) != 0u)
+#error "AD_ACQ_CH_MASK 必须是 1..0xFF"
+#endif
+
+#define AD_ACQ_BIT(m, n) (((m) >> (n)) & 1u)
+#define AD_ACQ_POPCNT8(m) (AD_ACQ_BIT(m, 0) + AD_ACQ_BIT(m, 1) + AD_ACQ_BIT(m, 2) + AD_ACQ_BIT(m, 3) + \
+                           AD_ACQ_BIT(m, 4) + AD_ACQ_BIT(m, 5) + AD_ACQ_BIT(m, 6) + AD_ACQ_BIT(m, 7))
+
+/* 启用通道数 = 缓冲区/上报中的逻辑通道数（按物理通道号升序排列） */
+#define AD_ACQ_CHANNELS AD_ACQ_POPCNT8(AD_ACQ_CH_MASK)
+
+/* 物理通道 n 的逻辑序号（编译期常量，仅对已启用的 n 有意义） */
+#define AD_ACQ_LOGICAL(n) AD_ACQ_POPCNT8((AD_ACQ_CH_MASK) & ((1u << (n)) - 1u))
+
+/* 从一帧 8 通道原始码中取出启用通道，写到 dst[逻辑通道 * stride]（stride=1 为帧内交织）
+ * 条件与下标都是编译期常量，未启用的通道不生成任何指令 */
+static inline void AD_Acq_Gather(int16_t *dst, uint32_t stride, const uint16_t raw[8])
+{
+    if (AD_ACQ_BIT(AD_ACQ_CH_MASK, 0)) dst[AD_ACQ_LOGICAL(0) * stride] = (int16_t)raw[0];
+    if (AD_ACQ_BIT(AD_ACQ_CH_MASK, 1)) dst[AD_ACQ_LOGICAL(1) * stride] = (int16_t)raw[1];
+    if (AD_ACQ_BIT(AD_ACQ_CH_MASK, 2)) dst[AD_ACQ_LOGICAL(2) * stride] = (int16_t)raw[2];
+    if (AD_ACQ_BIT(AD_ACQ_CH_MASK, 3)) dst[AD_ACQ_LOGICAL(3) * stride] = (int16_t)raw[3];
+    if (AD_ACQ_BIT(AD_ACQ_CH_MASK, 4)) dst[AD_ACQ_LOGICAL(4) * stride] = (int16_t)raw[4];
+    if (AD_ACQ_BIT(AD_ACQ_CH_MASK, 5)) dst[AD_ACQ_LOGICAL(5) * stride] = (int16_t)raw[5];
+    if (AD_ACQ_BIT(AD_ACQ_CH_MASK, 6)) dst[AD_ACQ_LOGICAL(6) * stride] = (int16_t)raw[6];
+    if (AD_ACQ_BIT(AD_ACQ_CH_MASK, 7)) dst[AD_ACQ_LOGICAL(7) * stride] = (int16_t)raw[7];
+}
+
+/* 环形缓冲槽数：总量固定约 128KB（每槽 通道数 × AD_ACQ_POINTS 点 int16），4 通道 4 槽，8 通道 2 槽 */
+#ifndef AD_ACQ_RING_SLOTS
+#define AD_ACQ_RING_SLOTS ((AD_ACQ_CHANNELS > 4u) ? 2u : 4u)
+#endif
+
+#if (AD_ACQ_RING_SLOTS < 2)
+#error "AD_ACQ_RING_SLOTS 至少为 2（一个写入、一个可读）"
+#endif
+
+/* 采样档位：采样率与 AD7606 过采样倍率成对切换
+ * - 任务里 AD_Acq_RequestProfile 提交；采样中断在下一个块的第一帧之前写定时器/OS 引脚，
+ *   并丢弃 AD_ACQ_PROFILE_SETTLE_FRAMES 个过渡帧（切换瞬间那一帧可能仍按旧参数转换）
+ * - 因此每个块只对应一种档位，块元数据里的 sample_rate/os_mode 就是这块数据的实际参数 */
+#define AD_ACQ_PROFILE_COUNT 4u
+
+#ifndef AD_ACQ_PROFILE_DEFAULT
+#define AD_ACQ_PROFILE_DEFAULT 0u
+#endif
+
+#ifndef AD_ACQ_PROFILE_SETTLE_FRAMES
+#define AD_ACQ_PROFILE_SETTLE_FRAMES 4u
+#endif
 
-extern int ADS131A04_flag;
-extern int ADS131A04_flag2;
-extern int number;
-extern int number2;
+typedef struct
+{
+    const char *name;      /* 界面/日志显示名 */
+    uint32_t sample_rate;  /* 目标采样率（实际值按定时器整数分频，见 AD_Acq_SampleRate） */
+    uint8_t os_mode;       /* AD7606 过采样：0..6 = 1x..64x */
+} AD_AcqProfile_t;
+
+/* 已发布块的只读视图（由 Acquire 填充） */
+typedef struct
+{
+    uint32_t seq;         /* 块序号（从 1 开始递增，不回绕） */
+    uint32_t tick_ms;     /* 块写满时刻 HAL_GetTick() */
+    uint32_t first_frame; /* 块首帧的全局帧号（含被丢弃帧），可换算精确采样时刻 */
+    uint32_t slot;        /* 内部槽号（Release 使用） */
+    uint32_t sample_rate; /* 本块实际采样率（Hz） */
+    uint8_t os_mode;      /* 本块过采样倍率 */
+    uint8_t profile;      /* 本块所属档位 */
+    const int16_t (*data)[AD_ACQ_POINTS]; /* data[ch][i]：原始码 */
+} AD_AcqBlock_t;
+
+/* 每个消费者各持有一份读取状态 */
+typedef struct
+{
+    uint32_t last_seq;    /* 最近一次取得的块序号 */
+    uint32_t skipped;     /* 因消费过慢而错过的块数 */
+} AD_AcqReader_t;
+
+typedef struct
+{
+    uint32_t blocks;         /* 已发布块数 */
+    uint32_t frames;         /* 生产者收到的总帧数 */
+    uint32_t dropped_frames; /* 无空闲槽而丢弃的帧数 */
+    uint32_t drop_events;    /* 进入丢帧状态的次数 */
+} AD_AcqStats_t;
+
+void AD_Acq_Init(void);
+
+/* 生产者（采样中断上下文）：写入一帧原始码（只取 AD_ACQ_CH_MASK 中的通道）
+ * 返回 1=该帧属于采样流，0=档位切换后的过渡帧（已丢弃，下游逐帧处理也应跳过） */
+int AD_Acq_PushFrame(const uint16_t raw[8]);
+
+/* 生产者发布一个块后调用（采样中断上下文，只能做 ISR 安全的通知，如 osThreadFlagsSet）
+ * 弱定义默认为空，由 DSP 模块覆盖 */
+void AD_Acq_OnBlockReady(uint32_t seq);
+
+/* 消费者：取最新的未读块（中间跳过的块计入 rd->skipped）；无新块返回 0 */
+int AD_Acq_AcquireLatest(AD_AcqReader_t *rd, AD_AcqBlock_t *blk);
+
+/* 消费者：取序号最小的未读块（需要连续数据时使用）；无新块返回 0 */
+int AD_Acq_AcquireNext(AD_AcqReader_t *rd, AD_AcqBlock_t *blk);
+
+/* 消费者：释放 Acquire 得到的块 */
+void AD_Acq_Release(const AD_AcqBlock_t *blk);
+
+void AD_Acq_GetStats(AD_AcqStats_t *st);
+
+/* 逻辑通道号 -> 物理通道号（0..7） */
+uint32_t AD_Acq_PhysChannel(uint32_t ch);
+
+/* 档位表（idx 越界返回 NULL） */
+const AD_AcqProfile_t *AD_Acq_GetProfile(uint32_t idx);
+
+/* 任务上下文：请求切换档位，下一个块边界生效；
+ * 返回 1=已提交，0=越界或 转换+读出时间 超过采样周期（见 AD7606_TimingPrepare） */
+int AD_Acq_RequestProfile(uint32_t idx);
+
+/* 当前生效的档位参数（中断侧切换后更新） */
+uint32_t AD_Acq_ActiveProfile(void);
+uint32_t AD_Acq_SampleRate(void);
+uint8_t AD_Acq_OsMode(void);
+/* 档位切换计数：每生效一次 +1，下游用来发现采样率变化 */
+uint32_t AD_Acq_ProfileSeq(void);
+
+/* 消费者侧批量换算（持有块期间调用），系数取自标定表（ad7606_calib.h）：
+ * - ToVolts: 输出工程量（零点/增益/分段线性修正后）
+ * - ToQ15  : 输出扣零点后的 q15（1.0 = 满量程），乘 AD7606_Cal_Q15Scale(ch) 得工程量 */
+void AD_Acq_BlockToVolts(const AD_AcqBlock_t *blk, uint32_t ch, float *dst);
+void AD_Acq_BlockToQ15(const AD_AcqBlock_t *blk, uint32_t ch, int16_t *dst);
+
+/* 现场零点标定（任务上下文，阻塞）：输入短接后调用，
+ * 取之后 blocks 个完整块求 ch_mask（物理通道掩码，与 AD_ACQ_CH_MASK 取交集）内各通道原始码均值作为新零点，立即生效（需另行 AD7606_Cal_SaveToSD 持久化）
+ * 返回 1=成功，0=超时/参数错误 */
+int AD_Acq_LearnZero(uint32_t ch_mask, uint32_t blocks, uint32_t timeout_ms);
 
 #ifdef __cplusplus
 }
 #endif
 
 #endif /* AD_ACQ_BUFFERS_H */
-
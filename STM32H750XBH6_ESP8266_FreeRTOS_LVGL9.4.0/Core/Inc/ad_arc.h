@@ -0,0 +1,114 @@
+#ifndef AD_ARC_H
+#define AD_ARC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "arm_math.h"
+
+/* 直流串联电弧检测（kHz 频段宽带噪声）
+ * - 全速流逐块处理（Decim 任务，与抽取级联共用同一份工程量换算）：
+ *     带通：Butterworth 高通 + 低通级联（arm_biquad_cascade_df2T_f32，系数按当前采样率设计）
+ *     包络：|y| 按 env_ms 分段平均（段长远大于带内载波周期，平稳的单频干扰包络几乎是直线）
+ *     能量：判定窗内 Σy²（arm_power_f32）
+ * - 每个判定窗（window_ms）出一次结论：
+ *     带内 RMS ≥ max(ratio × 基线, floor) 且 包络峰值 / 包络均值 ≥ crest_min 记为“热窗”
+ *     （电弧噪声的包络起伏大；开关频率谐波等落入带内的单频干扰 RMS 再大，包络也是平的）；
+ *     最近 hist_n 个窗中热窗 ≥ hot_n 判为电弧，热窗 ≤ clear_n 解除（N 取 M，单次开关瞬态不报）
+ * - 基线 = 非热窗带内均方值的一阶低通（baseline_tau_s），电弧期间冻结；
+ *   开始（或采样率变化）后 learn_windows 个窗只学基线不判定
+ * - 每点开销 = AD_ARC_SECTIONS 个 biquad + 平方和 + 绝对值和，只处理一个通道，不做 FFT；
+ *   状态只有滤波器延迟线与一个 AD_ARC_CHUNK 点的输出缓冲 */
+
+/* biquad 节数：一半高通、一半低通（2 = 4 阶带通，4 = 8 阶带通） */
+#ifndef AD_ARC_SECTIONS
+#define AD_ARC_SECTIONS 2u
+#endif
+
+#if (AD_ARC_SECTIONS < 2u) || (AD_ARC_SECTIONS % 2u) != 0u
+#error "AD_ARC_SECTIONS 须为 ≥ 2 的偶数"
+#endif
+
+/* 每次滤波调用的点数（输出缓冲长度） */
+#ifndef AD_ARC_CHUNK
+#define AD_ARC_CHUNK 256u
+#endif
+
+/* 滤波器清零（开始/跳块/采样率变化）后丢弃的判定窗数 */
+#ifndef AD_ARC_SETTLE_WINDOWS
+#define AD_ARC_SETTLE_WINDOWS 2u
+#endif
+
+#define AD_ARC_HIST_MAX 32u
+
+typedef struct
+{
+    uint8_t enable;
+    uint8_t phys;           /* 检测通道（物理，默认负载电流） */
+    float f_lo_hz;          /* 带通下限 */
+    float f_hi_hz;          /* 带通上限（超过 0.45 × fs 时按 0.45 × fs） */
+    float window_ms;        /* 判定窗长（取整到包络段的整数倍） */
+    float env_ms;           /* 包络段长（≤ window_ms） */
+    float ratio;            /* 带内 RMS / 基线 RMS 门限 */
+    float floor;            /* 带内 RMS 绝对下限（工程量），低于此值不算热窗 */
+    float crest_min;        /* 包络峰均比下限（0 = 不看包络） */
+    uint8_t hist_n;         /* 计数窗数（≤ AD_ARC_HIST_MAX） */
+    uint8_t hot_n;          /* 置位所需热窗数 */
+    uint8_t clear_n;        /* 解除：热窗数 ≤ clear_n */
+    uint16_t learn_windows; /* 开始后只学基线的窗数 */
+    float baseline_tau_s;   /* 基线学习时间常数 */
+} AD_ArcConfig_t;
+
+typedef struct
+{
+    uint32_t sample_rate;   /* 当前设计所用采样率（0 = 尚未处理） */
+    float f_lo_hz;          /* 实际带通下限/上限 */
+    float f_hi_hz;
+    uint32_t window_len;    /* 判定窗点数（0 = 频段在当前采样率下不可用） */
+    uint32_t windows;       /* 已判定窗数 */
+    float rms;              /* 最近一窗带内 RMS */
+    float base_rms;         /* 基线 RMS（0 = 尚未学到） */
+    float crest;            /* 最近一窗包络峰均比 */
+    uint8_t hot;            /* 最近 hist_n 窗中的热窗数 */
+    uint8_t arc;            /* 当前判定：1 = 电弧 */
+    uint16_t learn_left;    /* 剩余学习窗数 */
+    uint32_t detections;    /* 置位次数 */
+    uint32_t resets;        /* 不连续（跳块/采样率变化）导致的滤波器复位次数 */
+} AD_ArcStatus_t;
+
+void AD_Arc_DefaultConfig(AD_ArcConfig_t *cfg);
+
+/* 任意任务：提交配置（检测侧下一块 AD_Arc_BeginBlock 时生效，基线重新学习）；参数非法返回 false
+ * GetConfig 取最近一次提交的配置（可能尚未生效） */
+bool AD_Arc_SetConfig(const AD_ArcConfig_t *cfg);
+void AD_Arc_GetConfig(AD_ArcConfig_t *cfg);
+
+/* 检测侧：每块开头调用一次，取用已提交的新配置并输出本块所用的配置（cfg 可为 NULL） */
+void AD_Arc_BeginBlock(AD_ArcConfig_t *cfg);
+
+/* 提交配置与检测任务之间的临界区（整表拷贝用）：固件在 ad_arc_port.c 里用 PRIMASK 实现，
+ * 主机验证单线程，给空实现即可 */
+uint32_t AD_Arc_Lock(void);
+void AD_Arc_Unlock(uint32_t key);
+
+/* 配置文件的一项 KEY=VALUE（SD 文件与主机工具共用）；未知键返回 false */
+bool AD_Arc_ParseKV(AD_ArcConfig_t *cfg, const char *key, const char *val);
+
+/* 恢复默认配置并清空状态（调度器启动前调用） */
+void AD_Arc_Init(void);
+
+/* 检测侧（单任务）：送入检测通道连续的 n 点工程量（配置取自最近一次 AD_Arc_BeginBlock）；fs 变化时重新设计滤波器并重学基线，
+ * gap = 与上一次调用不连续（只清滤波器状态）。返回本次调用中新置位的电弧次数 */
+uint32_t AD_Arc_Process(const float *x, uint32_t n, uint32_t fs, bool gap);
+
+/* 任意任务：最近状态（仅供显示，不加锁） */
+void AD_Arc_GetStatus(AD_ArcStatus_t *st);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AD_ARC_H */
@@ -0,0 +1,39 @@
+#ifndef AD_ARC_PORT_H
+#define AD_ARC_PORT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "ad_arc.h"
+#include "ad_acq_buffers.h"
+
+/* 电弧检测的板级接入：Decim 任务按块序号连续消费采样环，换算出每个通道的工程量后逐通道调用
+ * AD_Arc_OnBlock，这里只处理配置的检测通道；新置位时打印并请求一次软件触发录波（触发通道 = 检测通道）。
+ * 判出时刻比电弧起始晚 hot_n 个判定窗 + 块时长 + Decim 轮询周期，录波的预触发深度按此配置 */
+
+#define AD_ARC_CFG_FILE "0:/config/ad_arc.cfg"
+
+typedef struct
+{
+    uint32_t blocks;      /* 已处理块数 */
+    uint32_t cyc;         /* 最近一块耗时（周期） */
+    uint32_t cyc_max;
+    uint32_t captures;    /* 已请求的录波次数 */
+} AD_ArcPortStats_t;
+
+/* Decim 任务上下文：逻辑通道 ch 的一块工程量 x（AD_ACQ_POINTS 点），blk 尚未释放 */
+void AD_Arc_OnBlock(const AD_AcqBlock_t *blk, uint32_t ch, const float *x);
+
+/* 从 SD 读取配置（KEY=VALUE，见 AD_Arc_ParseKV），以编译期默认值为底 */
+bool AD_Arc_LoadFromSD(void);
+
+void AD_Arc_GetPortStats(AD_ArcPortStats_t *st);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AD_ARC_PORT_H */
@@ -0,0 +1,55 @@
+#ifndef AD_ATOMIC_H
+#define AD_ATOMIC_H
+
+#include <stdint.h>
+#include "main.h" /* __DMB / __LDREXW / __STREXW */
+
+/* 采样块环 / DSP 结果缓冲共用的原子操作（单核、中断与任务或任务与任务之间）
+ * - 编译器支持 C11 原子（且未定义 __STDC_NO_ATOMICS__）时用 <stdatomic.h>
+ * - 否则用 Cortex-M 的 LDREX/STREX + DMB（Keil C99 模式走这条路径）
+ * 生产者在中断（或高优先级任务）、消费者在任务，单核上二者交错只发生在抢占点，
+ * 读写计数与状态字的“先写后查”必须有全屏障，保证双方至少一方能看见对方。 */
+#if defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 201112L) && !defined(__STDC_NO_ATOMICS__)
+#include <stdatomic.h>
+typedef atomic_uint acq_atomic_t;
+#define ACQ_LOAD(p)      atomic_load_explicit((p), memory_order_acquire)
+#define ACQ_STORE(p, v)  atomic_store_explicit((p), (v), memory_order_release)
+#define ACQ_ADD(p, d)    atomic_fetch_add_explicit((p), (d), memory_order_acq_rel)
+#define ACQ_SUB(p, d)    atomic_fetch_sub_explicit((p), (d), memory_order_acq_rel)
+#define ACQ_FENCE()      atomic_thread_fence(memory_order_seq_cst)
+#else
+typedef volatile uint32_t acq_atomic_t;
+
+static inline uint32_t acq_load(acq_atomic_t *p)
+{
+    uint32_t v = *p;
+    __DMB();
+    return v;
+}
+
+static inline void acq_store(acq_atomic_t *p, uint32_t v)
+{
+    __DMB();
+    *p = v;
+}
+
+static inline uint32_t acq_add(acq_atomic_t *p, int32_t d)
+{
+    uint32_t old;
+    __DMB();
+    do
+    {
+        old = __LDREXW(p);
+    } while (__STREXW(old + (uint32_t)d, p) != 0u);
+    __DMB();
+    return old;
+}
+
+#define ACQ_LOAD(p)      acq_load(p)
+#define ACQ_STORE(p, v)  acq_store((p), (v))
+#define ACQ_ADD(p, d)    acq_add((p), (int32_t)(d))
+#define ACQ_SUB(p, d)    acq_add((p), -(int32_t)(d))
+#define ACQ_FENCE()      __DMB()
+#endif
+
+#endif /* AD_ATOMIC_H */
@@ -0,0 +1,118 @@
+#ifndef AD_CLASS_H
+#define AD_CLASS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "arm_math.h"
+#include "ad_stats.h"
+
+/* 特征向量 -> 故障类别推理（CMSIS-DSP BayesFunctions / SVMFunctions）
+ * - 每个 DSP 结果快照算一次：每通道 AD_CLASS_FEATS_PER_CH 个特征（统计量 + 工频 1/2/3 次谐波幅值），
+ *   按快照里的逻辑通道顺序拼接；先按模型里的均值/标准差标准化，再交给 CMSIS 预测
+ * - 模型：高斯朴素贝叶斯（多类，最多 AD_CLASS_MAX_CLASSES 类）或 RBF 核 SVM（CMSIS 只支持两类）
+ * - 模型文件是小端二进制：AD_ClassFileHeader_t + float 负载，负载布局见 AD_ClassFileHeader_t；
+ *   由主机训练脚本生成（tools/class_check/train_model.py），类别到故障码的映射写在文件头里
+ * - 本文件是纯 C（只依赖 CMSIS-DSP），主机比对工具直接链接（tools/class_check）；
+ *   板级接入（模型文件加载、DSP 任务调用、计时）在 ad_class_port.c */
+
+#define AD_CLASS_MAGIC        0x4C434441u /* "ADCL" */
+#define AD_CLASS_VERSION      1u
+#define AD_CLASS_FEATS_PER_CH 8u
+#define AD_CLASS_MAX_CLASSES  8u
+#define AD_CLASS_DIM_MAX      (8u * AD_CLASS_FEATS_PER_CH)
+
+/* 谐波特征的基波频率（与 AD_PSD_FUND_HZ 一致） */
+#ifndef AD_CLASS_FUND_HZ
+#define AD_CLASS_FUND_HZ 50.0f
+#endif
+
+typedef enum
+{
+    AD_CLASS_GNB = 1,     /* 高斯朴素贝叶斯 */
+    AD_CLASS_SVM_RBF = 2, /* RBF 核 SVM（两类） */
+} AD_ClassKind_t;
+
+/* 每通道特征顺序（特征向量下标 = 逻辑通道 × AD_CLASS_FEATS_PER_CH + 序号） */
+typedef enum
+{
+    AD_CLASS_F_MEAN = 0,
+    AD_CLASS_F_STD,
+    AD_CLASS_F_CREST,
+    AD_CLASS_F_SKEW,
+    AD_CLASS_F_KURT,
+    AD_CLASS_F_H1, /* 基波幅值（单边幅值谱在 k ± 1 内取最大，标度同 AD_DspResult_t.spec） */
+    AD_CLASS_F_H2,
+    AD_CLASS_F_H3,
+} AD_ClassFeat_t;
+
+/* 文件头（76 字节），其后紧跟 payload_bytes 字节的 float：
+ *   mu[dim], inv_sd[dim]                                  标准化 z = (x - mu) × inv_sd
+ *   GNB：theta[nclass][dim], sigma[nclass][dim], prior[nclass]   （sigma 为方差）
+ *   SVM：dual[nsv], sv[nsv][dim]                          决策值 > 0 判为类别 1
+ * checksum 覆盖 checksum 之前的头部字段与全部负载（按 32 位字，见 AD_Class_Checksum） */
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t kind;          /* AD_ClassKind_t */
+    uint32_t nclass;
+    uint32_t dim;           /* = 通道数 × AD_CLASS_FEATS_PER_CH */
+    uint32_t nsv;           /* SVM 支持向量数（GNB 为 0） */
+    uint32_t ch_mask;       /* 训练时的采集通道掩码，须与 AD_ACQ_CH_MASK 相同 */
+    float param;            /* GNB：方差附加量 epsilon；SVM：gamma */
+    float intercept;        /* SVM 截距 */
+    uint32_t payload_bytes;
+    uint32_t checksum;
+    char code[AD_CLASS_MAX_CLASSES][4]; /* 类别 -> 故障码 "E00".."E99" */
+} AD_ClassFileHeader_t;
+
+/* 解析后的模型（指针指向调用者提供的文件缓冲，缓冲须 4 字节对齐且在模型使用期间保持不变；
+ * 结构体本身可以整体拷贝） */
+typedef struct
+{
+    uint8_t kind;
+    uint8_t nclass;
+    uint16_t dim;
+    uint32_t nsv;
+    uint32_t ch_mask;
+    char code[AD_CLASS_MAX_CLASSES][4];
+    const float32_t *mu;
+    const float32_t *inv_sd;
+    arm_gaussian_naive_bayes_instance_f32 gnb;
+    arm_svm_rbf_instance_f32 svm;
+} AD_ClassModel_t;
+
+/* 一块的推理结果（随 DSP 快照发布） */
+typedef struct
+{
+    int8_t cls;      /* 类别序号，-1 = 未加载模型 */
+    char code[4];    /* 对应故障码（未加载为空串） */
+    float score;     /* GNB：最大与次大对数似然之差（越大越确定）；SVM：NaN（CMSIS 不输出决策值） */
+} AD_ClassResult_t;
+
+/* 预测工作区（float 个数）：标准化向量 + 各类对数似然 + CMSIS 暂存 */
+#define AD_CLASS_WORK_FLOATS (AD_CLASS_DIM_MAX + 2u * AD_CLASS_MAX_CLASSES)
+
+/* 一块的特征向量：st/spec 按逻辑通道给出 nch 路，返回维数（nch × AD_CLASS_FEATS_PER_CH） */
+uint32_t AD_Class_Features(const AD_Stats_t *st, const float *const *spec, uint32_t nch, uint32_t bins,
+                           uint32_t sample_rate, float *x);
+
+uint32_t AD_Class_Checksum(const AD_ClassFileHeader_t *h, const float *payload);
+
+/* 从文件缓冲解析模型；失败返回 false 并给出原因（静态字符串） */
+bool AD_Class_Parse(AD_ClassModel_t *m, const void *buf, uint32_t len, const char **why);
+
+/* 预测：返回类别序号；work 至少 AD_CLASS_WORK_FLOATS 个 float，score 可为 NULL */
+int32_t AD_Class_Predict(const AD_ClassModel_t *m, const float *x, float *work, float *score);
+
+const char *AD_Class_KindName(uint8_t kind);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AD_CLASS_H */
@@ -0,0 +1,57 @@
+#ifndef AD_CLASS_PORT_H
+#define AD_CLASS_PORT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "ad_class.h"
+#include "ad_dsp.h"
+
+/* 故障分类推理的板级接入：模型文件加载 + DSP 任务每块调用一次
+ * - 模型文件先找 SD，再找 QSPI FatFs（出厂预置），都没有则不推理（结果 cls = -1）
+ * - 模型放 SDRAM 双缓冲：加载写非活动缓冲并解析，DSP 任务在下一块开始前切换，
+ *   加载过程中 DSP 任务照常用旧模型推理，不需要停任务 */
+
+#define AD_CLASS_MODEL_FILE_SD   "0:/config/ad_class.bin"
+#define AD_CLASS_MODEL_FILE_QSPI "1:/config/ad_class.bin"
+
+/* 模型缓冲：SDRAM 中 PSD 状态区（0xC0900000，8 通道最多 272KB）之后，两个缓冲各 AD_CLASS_MODEL_MAX_BYTES */
+#ifndef AD_CLASS_MODEL_SDRAM_ADDR
+#define AD_CLASS_MODEL_SDRAM_ADDR 0xC0980000u
+#endif
+
+#ifndef AD_CLASS_MODEL_MAX_BYTES
+#define AD_CLASS_MODEL_MAX_BYTES (128u * 1024u)
+#endif
+
+typedef struct
+{
+    uint8_t loaded;       /* DSP 任务正在使用的模型是否有效 */
+    uint8_t kind;         /* AD_ClassKind_t */
+    uint8_t nclass;
+    uint16_t dim;
+    uint32_t nsv;
+    uint32_t bytes;       /* 模型文件字节数 */
+    const char *src;      /* 模型文件路径 */
+    uint32_t infers;      /* 已推理块数 */
+    uint32_t count[AD_CLASS_MAX_CLASSES]; /* 各类别预测次数 */
+    char code[AD_CLASS_MAX_CLASSES][4];
+    AD_ClassResult_t last;
+} AD_ClassStatus_t;
+
+/* 任意任务：加载模型文件（SD 优先，其次 QSPI），成功后下一块生效；失败时保留当前模型 */
+bool AD_Class_Load(void);
+
+/* DSP 任务：对正在填写的快照推理一次，结果写入 r->cls（统计量与频谱须已算好） */
+void AD_Class_OnBlock(AD_DspResult_t *r);
+
+void AD_Class_GetStatus(AD_ClassStatus_t *st);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AD_CLASS_PORT_H */
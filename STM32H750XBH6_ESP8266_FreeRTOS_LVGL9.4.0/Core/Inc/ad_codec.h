@@ -0,0 +1,74 @@
+#ifndef AD_CODEC_H
+#define AD_CODEC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/* 无损整数波形编解码（上传帧 WAVE_Z / EVENT_Z 段、SD 压缩录波文件共用）
+ * - 分块：每块 ≤ AD_CODEC_BLOCK 个样本，块内选 0/1/2 阶固定预测（Σ|残差| 最小），
+ *   残差 zigzag 后按 Rice(k) 编码，k 在估计值附近取实际比特数最小者；
+ *   若某阶定宽打包更省（尖峰、噪声块）则整块改用定宽，最坏情况不超过 int16 原样 + 1 字节（int16 数据）
+ * - 每块字节对齐，块头 1 字节：bit0..1 预测阶数，bit2..6 = k（Rice）或 w（定宽位数），bit7 = 1 表示定宽
+ * - Rice 码字：q = z >> k，q < AD_CODEC_QMAX 时写 q 个 1 + 0 + 低 k 位；否则写 AD_CODEC_QMAX 个 1 + z 的 32 位（逃逸）
+ * - 位序 MSB 先出；预测历史（每路最近两个样本）跨块保留，流式逐块编码，解码端按同样顺序逐块解
+ * - 工作区只有本结构体里的两个块缓冲（2 KB），不依赖 HAL，可在主机上直接编译（tools/codec_bench）
+ * 样本绝对值须 < AD_CODEC_MAX_ABS（超出部分饱和），保证 2 阶残差的 zigzag 不超过 32 位 */
+
+#ifndef AD_CODEC_BLOCK
+#define AD_CODEC_BLOCK 256u
+#endif
+
+#define AD_CODEC_MAX_CH  8u
+#define AD_CODEC_QMAX    16u
+#define AD_CODEC_MAX_ABS (1L << 28)
+
+/* 一块编码后的最大字节数（任意 int32 输入）；int16 输入不超过 1 + 2n */
+#define AD_CODEC_WORST_BYTES(n) (1u + 4u * (n))
+
+/* 累计统计；压缩比 = int16 原样字节（2 字节/样本）/ 编码字节 */
+typedef struct
+{
+    uint32_t blocks;
+    uint32_t samples;
+    uint32_t bytes_out;
+    uint32_t fixed_blocks;   /* 走定宽打包的块 */
+    uint32_t escapes;        /* Rice 逃逸样本 */
+    uint32_t order_hist[3];  /* 各预测阶数被选中的块数 */
+    float last_ratio;        /* 最近一块 */
+    float min_ratio;
+    float max_ratio;
+} AD_CodecStats_t;
+
+typedef struct
+{
+    int32_t hist[AD_CODEC_MAX_CH][2]; /* 每路最近两个样本：[0] = x[-1]，[1] = x[-2] */
+    int32_t in[AD_CODEC_BLOCK];       /* 输入暂存：调用方可直接填好后把它传给 Encode */
+    uint32_t z[AD_CODEC_BLOCK];       /* 残差 zigzag */
+    AD_CodecStats_t st;
+} AD_Codec_t;
+
+/* 清预测历史与统计 */
+void AD_Codec_Init(AD_Codec_t *c);
+/* 只清预测历史（新的独立码流开始，编解码两端须在同一位置调用） */
+void AD_Codec_Reset(AD_Codec_t *c);
+
+/*
+ * 编码一块：ch 为预测历史的路号（< AD_CODEC_MAX_CH），x 连续 n（1..AD_CODEC_BLOCK）个样本
+ * 返回写出的字节数；cap 不足返回 0，此时预测历史与统计都不变
+ */
+uint32_t AD_Codec_Encode(AD_Codec_t *c, uint32_t ch, const int32_t *x, uint32_t n, uint8_t *out, uint32_t cap);
+
+/* 解码一块（n 须与编码时相同）；返回消耗的字节数，数据不足或块头非法返回 0 */
+uint32_t AD_Codec_Decode(AD_Codec_t *c, uint32_t ch, const uint8_t *in, uint32_t len, int32_t *x, uint32_t n);
+
+/* 累计压缩比（没有数据时为 0） */
+float AD_Codec_Ratio(const AD_CodecStats_t *st);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AD_CODEC_H */
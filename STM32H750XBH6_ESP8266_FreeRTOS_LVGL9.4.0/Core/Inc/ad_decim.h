@@ -0,0 +1,90 @@
+#ifndef AD_DECIM_H
+#define AD_DECIM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "ad_acq_buffers.h"
+
+/* 多速率抽取：采样块环 -> 多级 FIR 抽取级联（arm_fir_decimate_f32）-> 并行的低速输出流
+ * - 全速流就是采样块环本身（AD_AcqReader_t 订阅），这里只产生抽取后的两路：
+ *     MID  ：÷4 ÷8     （25.6kHz 档 -> 800 SPS，用于 ~1kSPS 的中速观察）
+ *     TREND：÷4 ÷8 ÷8 ÷8（25.6kHz 档 -> 12.5 SPS，用于 ~10SPS 的长时趋势）
+ *   各级因子都整除 AD_ACQ_POINTS，每个采样块在每一级都产出整数个点，块与块之间滤波器状态连续
+ * - 级联在独立任务里按块序号连续消费（AcquireNext），与全速 FFT/上报路径互不等待：
+ *   全速路径处理不过来只会让它自己跳块，趋势流照常连续
+ * - 块不连续（跳块/丢帧/档位切换）时清空滤波器状态并计数，输出流的采样率随档位变化
+ * - 每路输出是帧内按逻辑通道交织的 float 环（工程量，已按标定表换算），放 SDRAM；
+ *   订阅者各持一份 AD_DecimReader_t，读取不加锁，落后超过环容量时跳到最新并计入 lost
+ * - 全速电弧检测（ad_arc_port.h）也在这个任务里逐块连续运行，复用同一份工程量换算 */
+
+typedef enum
+{
+    AD_DECIM_MID = 0,
+    AD_DECIM_TREND,
+    AD_DECIM_STREAMS
+} AD_DecimStream_t;
+
+/* 输出环容量（帧）：MID 2048 帧 ≈ 2.5s@800SPS，TREND 8192 帧 ≈ 11min@12.5SPS */
+#ifndef AD_DECIM_MID_FRAMES
+#define AD_DECIM_MID_FRAMES 2048u
+#endif
+
+#ifndef AD_DECIM_TREND_FRAMES
+#define AD_DECIM_TREND_FRAMES 8192u
+#endif
+
+/* 输出环：SDRAM 中紧接事件池（0xC0680000 + 512KB）之后
+ * 占用 (MID + TREND) × AD_ACQ_CHANNELS × 4 字节（4 通道默认 160KB） */
+#ifndef AD_DECIM_POOL_SDRAM_ADDR
+#define AD_DECIM_POOL_SDRAM_ADDR 0xC0700000u
+#endif
+
+/* 抽取任务轮询周期：须明显小于 采样环槽数 × 块时长（25.6kHz 档 4 槽 = 640ms） */
+#ifndef AD_DECIM_POLL_MS
+#define AD_DECIM_POLL_MS 20u
+#endif
+
+/* 每个订阅者各持一份读取状态 */
+typedef struct
+{
+    uint32_t next;  /* 下一次要读的帧号（输出流内全局编号） */
+    uint32_t lost;  /* 因读取过慢被覆盖而跳过的帧数 */
+} AD_DecimReader_t;
+
+typedef struct
+{
+    uint32_t blocks;                      /* 已处理的采样块数 */
+    uint32_t gaps;                        /* 块不连续（跳块/丢帧/档位切换）次数，每次都会清空滤波器状态 */
+    uint32_t frames[AD_DECIM_STREAMS];    /* 各输出流累计写入帧数 */
+} AD_DecimStats_t;
+
+/* 计算滤波器系数、清空状态（须在 AD_Acq_Init 之后、调度器启动之前调用） */
+void AD_Decim_Init(void);
+
+/* 任务上下文：处理所有未读采样块，返回本次处理的块数（由专用 Decim 任务周期调用） */
+uint32_t AD_Decim_Service(void);
+
+/* 订阅：从当前写位置往前 backlog 帧开始读（0 = 只读之后的新数据；超过已有数据时取全部） */
+void AD_Decim_ReaderInit(AD_DecimStream_t stream, AD_DecimReader_t *rd, uint32_t backlog);
+
+/* 读取至多 max_frames 帧到 dst（每帧 AD_ACQ_CHANNELS 个 float），返回实际帧数；
+ * first_index 非 NULL 时返回首帧的全局帧号 */
+uint32_t AD_Decim_Read(AD_DecimStream_t stream, AD_DecimReader_t *rd, float *dst, uint32_t max_frames,
+                       uint32_t *first_index);
+
+/* 输出流当前采样率（Hz）；尚未处理过采样块时返回 0 */
+float AD_Decim_SampleRate(AD_DecimStream_t stream);
+
+/* 输出流总抽取倍数 */
+uint32_t AD_Decim_Factor(AD_DecimStream_t stream);
+
+void AD_Decim_GetStats(AD_DecimStats_t *st);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AD_DECIM_H */
@@ -0,0 +1,133 @@
+#ifndef AD_DSP_H
+#define AD_DSP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "ad_acq_buffers.h"
+#include "ad_psd.h"
+#include "ad_stats.h"
+#include "ad_class.h"
+
+/* DSP 任务：波形换算 + 统计量 + 频谱 + Welch PSD/谐波 + 故障分类推理，结果以只读快照发布
+ * - 采样中断每发布一个块就给 DSP 任务发线程标志（AD_Acq_OnBlockReady），DSP 任务取最新块计算
+ * - 结果放在 AD_DSP_SLOTS 个快照槽里（默认 3 槽 = 三缓冲）：写者只写“既不是最新、也没人持有”的槽，
+ *   读者 AcquireLatest 拿到指针后直接读（不拷贝、不加锁），用完 Release
+ * - 与采样块环同一套 seq/readers 协议（见 ad_atomic.h）；找不到可写槽时本次结果丢弃并计数
+ * - 长期持有快照的读者（如上报链路持有到下一次取新结果）每多一个，槽数应加 1 */
+
+#define AD_DSP_POINTS AD_ACQ_POINTS        /* 波形点数 */
+#define AD_DSP_BINS   (AD_DSP_POINTS / 2u) /* 频谱点数（实 FFT 输出 N/2 个幅值） */
+
+#ifndef AD_DSP_SLOTS
+#define AD_DSP_SLOTS 3u
+#endif
+
+#if (AD_DSP_SLOTS < 3)
+#error "AD_DSP_SLOTS 至少为 3（一个写入、一个最新、一个被读者持有）"
+#endif
+
+/* 快照池：SDRAM 中抽取输出环（0xC0700000，最多 320KB）之后，须在 PSD 状态区（AD_PSD_STATE_SDRAM_ADDR）之前
+ * 每槽约 通道数 × (波形 + 频谱 + PSD) × 4 字节（4 通道 128KB，3 槽 384KB） */
+#ifndef AD_DSP_POOL_SDRAM_ADDR
+#define AD_DSP_POOL_SDRAM_ADDR 0xC0780000u
+#endif
+
+/* 频谱引擎（编译期选择），三者输出同一标度的单边幅值谱（工程量）：
+ * 沿用原上报链路的标度 |X[k]| / (N/2) × 2（正弦幅值 A 的谱峰为 2A）
+ * - F32：工程量波形 -> 两通道打包一次复 FFT 再拆分（ad_spec.h，奇数通道最后一路走 rfft）；
+ *        经过完整标定（含分段线性修正）
+ * - Q15：原始码 -> 扣零点 q15（AD_Acq_BlockToQ15）-> arm_rfft_q15 -> arm_cmplx_mag_q15
+ *        rfft_q15 每级右移 1 位，N 点输出为 X[k]/N；cmplx_mag_q15 输出 2.14 格式再减半，
+ *        故 |X[k]|/N(满量程分数) = mag × 2 / 32768，谱值 = mag × 8 × AD7606_Cal_Q15Scale(ch)
+ *        工作区 8KB 输入 + 16KB 输出（rfft_q15 输出含共轭镜像 2N 点），浮点路径为 16KB + 16KB；
+ *        输出只保留 log2(N)=12 位以下的动态余量，小信号（< 满量程 1%）的谐波精度明显下降
+ * - Q31：同 Q15，输入左移 16 位为 q31，|X[k]|/N = mag × 2 / 2^31；精度接近浮点，工作区 48KB
+ * 定点路径直接从采样块原始码计算，标定只含零点与增益（不含分段线性）。
+ * 三者的 SNR/耗时/内存对比见 tools/dsp_bench（主机上用录波文件跑） */
+#define AD_DSP_FFT_F32 0
+#define AD_DSP_FFT_Q15 1
+#define AD_DSP_FFT_Q31 2
+
+#ifndef AD_DSP_FFT_ENGINE
+#define AD_DSP_FFT_ENGINE AD_DSP_FFT_F32
+#endif
+
+/* 成对频谱内核对照（仅 F32 引擎）：置 1 后每块发布后再按逐通道 rfft 重算一遍，
+ * 统计两种做法的周期数与最大偏差（串口 [DSP] bench 行），额外占用一份频谱计算时间 */
+#ifndef AD_DSP_SPEC_BENCH
+#define AD_DSP_SPEC_BENCH 0
+#endif
+
+/* 块就绪线程标志；等待超时后也会检查一次（通知丢失时兜底） */
+#define AD_DSP_FLAG_BLOCK 0x0001u
+
+#ifndef AD_DSP_WAIT_MS
+#define AD_DSP_WAIT_MS 200u
+#endif
+
+/* 每通道统计量（单趟内核，见 ad_stats.h） */
+typedef AD_Stats_t AD_DspChStats_t;
+
+/* 结果快照（发布后只读） */
+typedef struct
+{
+    uint32_t seq;          /* 结果序号（从 1 递增） */
+    uint32_t block_seq;    /* 来源采样块序号 */
+    uint32_t tick_ms;      /* 来源块写满时刻 */
+    uint32_t first_frame;  /* 来源块首帧全局帧号 */
+    uint32_t sample_rate;  /* 来源块采样率（频率轴 = k × sample_rate / AD_DSP_POINTS） */
+    uint8_t os_mode;
+    uint8_t profile;
+    AD_DspChStats_t stats[AD_ACQ_CHANNELS];
+    AD_PsdInfo_t psd_info;                          /* Welch 平均状态（段数/分辨率/窗） */
+    float harm[AD_ACQ_CHANNELS][AD_PSD_HARMONICS];  /* 1..H 次谐波幅值（峰值，工程量，已做窗修正） */
+    AD_ClassResult_t cls;                           /* 故障分类推理结果（ad_class_port.h） */
+    float wave[AD_ACQ_CHANNELS][AD_DSP_POINTS];  /* 工程量波形 */
+    float spec[AD_ACQ_CHANNELS][AD_DSP_BINS];    /* 单边幅值谱（bin0 置 0） */
+    float psd[AD_ACQ_CHANNELS][AD_PSD_BINS];     /* Welch 平均单边 PSD（工程量²/Hz，见 ad_psd.h） */
+} AD_DspResult_t;
+
+/* 每个读者各持有一份读取状态 */
+typedef struct
+{
+    uint32_t last_seq;  /* 最近一次取得的结果序号 */
+    uint32_t skipped;   /* 两次读取之间错过的结果数 */
+} AD_DspReader_t;
+
+typedef struct
+{
+    uint32_t results;        /* 已发布结果数 */
+    uint32_t no_slot;        /* 无可写槽而丢弃的次数（读者持有过多） */
+    uint32_t blocks_skipped; /* DSP 来不及处理而跳过的采样块数 */
+    uint32_t last_ms;        /* 最近一次计算耗时（毫秒） */
+    uint32_t fft_cyc;        /* 最近一块全部通道频谱计算的 CPU 周期数（DWT） */
+    uint32_t stats_cyc;      /* 最近一块全部通道统计量计算的 CPU 周期数（DWT） */
+    uint32_t class_cyc;      /* 最近一块故障分类推理（特征 + 预测）的 CPU 周期数（DWT，无模型时约为 0） */
+    uint32_t ref_cyc;        /* AD_DSP_SPEC_BENCH：同一块逐通道 rfft 的周期数 */
+    float ref_maxrel;        /* AD_DSP_SPEC_BENCH：两种做法的最大偏差 / 谱峰 */
+} AD_DspStats_t;
+
+/* 在 DSP 任务开头调用一次：登记任务句柄（用于块就绪通知）、初始化 FFT */
+void AD_Dsp_TaskInit(void);
+
+/* DSP 任务循环：等待块就绪标志，取最新块计算并发布（没有新块直接返回） */
+void AD_Dsp_Service(void);
+
+/* 读者：取最新的、比 rd->last_seq 新的结果；rd 为 NULL 时不论新旧取当前最新结果
+ * 成功返回 1 且 *res 指向快照（持有期间不会被改写），用完必须 AD_Dsp_Release */
+int AD_Dsp_AcquireLatest(AD_DspReader_t *rd, const AD_DspResult_t **res);
+void AD_Dsp_Release(const AD_DspResult_t *res);
+
+void AD_Dsp_GetStats(AD_DspStats_t *st);
+
+/* 当前频谱引擎名（"f32" / "q15" / "q31"） */
+const char *AD_Dsp_EngineName(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AD_DSP_H */
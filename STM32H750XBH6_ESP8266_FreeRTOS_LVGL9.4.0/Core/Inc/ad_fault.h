@@ -0,0 +1,152 @@
+#ifndef AD_FAULT_H
+#define AD_FAULT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "ad_stats.h"
+#include "ad_iso.h"
+
+/* 本地故障判定（规则/门限引擎）
+ * - 每个 DSP 结果快照（一块 AD_ACQ_POINTS 点）提取一组特征，逐条规则比较门限，命中即置故障码，
+ *   需要时请求一次瞬态录波：判定延迟 = 一个块周期 + DSP 计算时间，不经服务器往返
+ * - 规则：特征 + 方向 + 置位门限/复位门限（回差）+ 连续命中/连续解除块数（去抖）+ 故障码 + 是否录波；
+ *   多条规则同时成立时取序号最小的一条的故障码（序号即优先级）
+ * - 引擎本身是纯 C（不依赖 HAL/RTOS/FatFs），主机回放工具直接链接（tools/fault_replay）；
+ *   板级接入（SD 配置、DSP 结果、录波、故障码）在 ad_fault_port.c
+ * - 配置/复位请求由其他任务写入请求区：配置在块开头 AD_Fault_BeginBlock 取用（临界区内整表拷贝），
+ *   复位在下一次 AD_Fault_Eval 开头取用 */
+
+#ifndef AD_FAULT_RULES
+#define AD_FAULT_RULES 8u
+#endif
+
+#define AD_FAULT_CFG_FILE "0:/config/ad_fault.cfg"
+
+/* 特征（单位随标定表：母线 V，漏电流 mA） */
+typedef enum
+{
+    AD_FEAT_BUS_V = 0,       /* 母线总电压 |mean(+)| + |mean(-)| */
+    AD_FEAT_BUS_IMB,         /* 正负母线不平衡度 %：||V+| - |V-|| / (|V+| + |V-|) × 100 */
+    AD_FEAT_RIPPLE,          /* 母线纹波（交流有效值 = 标准差，正负母线取大） */
+    AD_FEAT_RIPPLE_GROWTH,   /* 纹波 / 正常运行期间学到的纹波基线 */
+    AD_FEAT_LEAK_RMS,        /* 漏电流有效值（含直流） */
+    AD_FEAT_LEAK_SPIKE_RATE, /* 漏电流尖峰率（次/秒）：|x - 均值| 上穿 max(spike_level, spike_sigma × σ) 的次数 */
+    AD_FEAT_LEAK_KURT,       /* 漏电流峭度（正态 = 3） */
+    AD_FEAT_ISO_KOHM,        /* 对地绝缘电阻 R+ ∥ R− kΩ（ad_iso.h 估计，电桥法每轮更新一次） */
+    AD_FEAT_ISO_RATE,        /* 绝缘电阻趋势的相对变化率 %/h（负 = 下降；慢低通稳定前为 NaN） */
+    AD_FEAT_COUNT
+} AD_FaultFeat_t;
+
+typedef enum
+{
+    AD_FAULT_OFF = 0,
+    AD_FAULT_ABOVE, /* v >= set 置位，v < clear 解除（clear <= set） */
+    AD_FAULT_BELOW, /* v <= set 置位，v > clear 解除（clear >= set） */
+} AD_FaultOp_t;
+
+typedef struct
+{
+    uint8_t op;       /* AD_FaultOp_t */
+    uint8_t feat;     /* AD_FaultFeat_t */
+    uint8_t on_n;     /* 连续命中块数后置位（≥1） */
+    uint8_t off_n;    /* 连续解除块数后复位（≥1） */
+    uint8_t capture;  /* 置位时请求一次录波 */
+    char code[4];     /* 故障码 "E01".."E99" */
+    float set;
+    float clear;
+} AD_FaultRule_t;
+
+typedef struct
+{
+    uint8_t ch_bus_p;     /* 物理通道：正母线 / 负母线 / 漏电流（0xFF = 无） */
+    uint8_t ch_bus_n;
+    uint8_t ch_leak;
+    uint8_t latch;        /* 1 = 故障码保持到 AD_Fault_Reset（服务器 reset），0 = 规则解除即恢复 E00 */
+    float bus_min_v;      /* 母线总电压低于此值时不平衡度/绝缘电阻不判（停机/未上电） */
+    float spike_level;    /* 尖峰门限（漏电流工程量，相对块均值） */
+    float spike_sigma;    /* 尖峰门限下限 = spike_sigma × 块标准差，工频漏电流的正常波动不计为尖峰 */
+    float ripple_tau_s;   /* 纹波基线学习时间常数（秒，只在无故障时学习） */
+    AD_IsoConfig_t iso;   /* 绝缘电阻估计（改动后估计与趋势重新开始） */
+    AD_FaultRule_t rule[AD_FAULT_RULES];
+} AD_FaultConfig_t;
+
+/* 特征提取输入：统计量/波形按角色给出，缺的通道给 NULL（相关特征为 NaN，任何规则都不命中） */
+typedef struct
+{
+    const AD_Stats_t *bus_p;
+    const AD_Stats_t *bus_n;
+    const AD_Stats_t *leak;
+    const float *leak_wave;
+    uint32_t n;            /* 波形点数 */
+    uint32_t sample_rate;
+    float dt_s;            /* 距上一块的时间（绝缘电阻趋势） */
+    uint8_t bridge_hw;     /* 板上有不平衡电桥切换硬件 */
+} AD_FaultInput_t;
+
+typedef struct
+{
+    float v[AD_FEAT_COUNT];
+} AD_FaultFeatures_t;
+
+/* 一次判定的输出 */
+typedef struct
+{
+    char code[4];        /* 当前故障码（"E00" = 正常） */
+    int8_t rule;         /* 给出该故障码的规则序号，-1 = 无 */
+    uint8_t changed;     /* 故障码与上一次不同 */
+    int8_t capture;      /* 本次刚置位且要求录波的规则序号（多条取最小），-1 = 无 */
+    uint32_t active;     /* 已置位规则位图 */
+} AD_FaultVerdict_t;
+
+/* 状态快照（仅供显示，可能与正在进行的判定交错） */
+typedef struct
+{
+    uint32_t evals;             /* 已判定块数 */
+    uint32_t raised;            /* 规则置位次数 */
+    AD_FaultFeatures_t feat;    /* 最近一次特征 */
+    float ripple_base;          /* 纹波基线 */
+    AD_IsoResult_t iso;         /* 最近一次绝缘电阻估计 */
+    AD_FaultVerdict_t verdict;  /* 最近一次结果 */
+} AD_FaultStatus_t;
+
+void AD_Fault_DefaultConfig(AD_FaultConfig_t *cfg);
+void AD_Fault_Init(void);
+
+/* 任意任务：提交新配置（下一块 AD_Fault_BeginBlock 生效）/ 复位请求（下一次 AD_Fault_Eval 生效）；配置非法返回 false
+ * GetConfig 取最近一次提交的配置（可能尚未生效） */
+bool AD_Fault_SetConfig(const AD_FaultConfig_t *cfg);
+void AD_Fault_GetConfig(AD_FaultConfig_t *cfg);
+void AD_Fault_Reset(void);
+
+/* 判定任务：每块开头调用一次，取用已提交的新配置并输出本块所用的配置（cfg 可为 NULL） */
+void AD_Fault_BeginBlock(AD_FaultConfig_t *cfg);
+
+/* 提交配置与判定任务之间的临界区（整表拷贝用）：固件在 ad_fault_port.c 里用 PRIMASK 实现，
+ * 主机回放单线程，给空实现即可 */
+uint32_t AD_Fault_Lock(void);
+void AD_Fault_Unlock(uint32_t key);
+
+/* 配置文件的一项 KEY=VALUE（SD 文件与主机回放共用）；未知键返回 false */
+bool AD_Fault_ParseKV(AD_FaultConfig_t *cfg, const char *key, const char *val);
+
+/* 提取一块的特征，同时推进绝缘电阻估计（每块恰好调用一次）；iso 可为 NULL，
+ * 非 NULL 时输出本块估计结果，其中 bridge 为下一块要求的桥臂状态 */
+void AD_Fault_Extract(const AD_FaultInput_t *in, AD_FaultFeatures_t *f, AD_IsoResult_t *iso);
+
+/* 判定一块（补填 f 的纹波增长倍数）；dt_s = 距上一次判定的时间（用于纹波基线学习） */
+void AD_Fault_Eval(AD_FaultFeatures_t *f, float dt_s, AD_FaultVerdict_t *out);
+
+void AD_Fault_GetStatus(AD_FaultStatus_t *st);
+
+const char *AD_Fault_FeatName(uint8_t feat);
+const char *AD_Fault_OpName(uint8_t op);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AD_FAULT_H */
@@ -0,0 +1,32 @@
+#ifndef AD_FAULT_PORT_H
+#define AD_FAULT_PORT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include "ad_fault.h"
+#include "ad_dsp.h"
+
+/* 本地故障判定的板级接入：DSP 任务每块调用一次（统计量算完即判，不等频谱），
+ * 故障码变化经 AD_Fault_SetCode 交给上报模块，需要录波的规则置位时请求软件触发 */
+
+/* DSP 任务上下文：r 的 wave/stats/sample_rate 已就绪 */
+void AD_Fault_OnBlock(const AD_DspResult_t *r);
+
+/* 从 SD 读取规则（KEY=VALUE，见 AD_Fault_ParseKV），以编译期默认规则为底 */
+bool AD_Fault_LoadFromSD(void);
+
+/* 故障码变化（DSP 任务上下文；弱定义为空，由上报模块覆盖） */
+void AD_Fault_SetCode(const char code[4]);
+
+/* 不平衡电桥切换（DSP 任务上下文，state = AD_IsoBridge_t）：弱定义返回 false 表示板上没有切换硬件，
+ * 绝缘电阻走被动法；有继电器/光耦的板子覆盖它，切换成功返回 true */
+bool AD_Iso_SetBridge(uint8_t state);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AD_FAULT_PORT_H */
@@ -0,0 +1,144 @@
+#ifndef AD_FRAME_H
+#define AD_FRAME_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "ad_stats.h"
+#include "ad_codec.h"
+
+/* 二进制遥测帧（全量上报的 JSON 替代格式，POST /api/node/frame，application/octet-stream）
+ * - 全部小端；帧 = 固定头 + node_id + 若干段 + CRC32（IEEE，与 zlib.crc32 相同，覆盖其前全部字节）
+ * - 只做定点量化与字节拷贝，不做任何文本格式化；参考解码器见服务器 edgewind/binframe.py
+ * - 解码端按段长跳过不认识的段类型，新增段不必升版本；已有段的布局变化才升 AD_FRAME_VERSION
+ * - 不依赖 HAL，可在主机上直接编译（tools/frame_check）
+ *
+ * 固定头（AD_FRAME_HDR_LEN 字节）：
+ *   0  u32 magic "EWBF"        4  u8 version      5  u8 hdr_len     6  u8 node_len   7  u8 flags（AD_FRAME_FLAG_*）
+ *   8  u32 seq                 12 u32 sample_rate 16 u32 tick_ms（来源块时刻）
+ *   20 u8  ch_count            21 u8  ch_mask（物理通道位图）       22 u8 os_mode    23 u8 acq_profile
+ *   24 char fault_code[4]      28 u16 sections    30 u16 保留 0
+ * 之后 node_len 字节 node_id（不含结尾 0）
+ *
+ * 段 = u8 type + u8 ch（物理通道，与段无关时 0xFF）+ u16 保留 0 + u32 len + len 字节负载：
+ *   CHAN  f32 value, AD_Stats_t 的 9 个 f32（mean rms min max p2p std crest skew kurt）
+ *   WAVE  f32 scale, f32 offset, u16 n, u16 step, i16[n]       x = offset + q × scale
+ *   SPEC  f32 ref, f32 db_step, u16 n, u16 step, u8[n]          c = 0 -> 0；否则 ref × 10^(−(255 − c) × db_step / 20)
+ *   HARM  f32[len / 4]                                          1..H 次谐波幅值
+ *   CLASS i8 idx, char code[4], u8 保留, f32 score（NaN = 无）, u32 cyc
+ *   ISO   u8 mode, u8 保留[3], f32 rp, rn, r, trend, rate（kΩ、%/h，NaN = 未稳定）
+ *   EVENT u32 seq, sample_rate, pre, post, frames, step；u8 trig_ch, trig_type, os_mode, nch；char fault_code[4]；
+ *         每通道 u8 phys, u8 保留[3], f32 scale, f32 offset, i16[⌈frames / step⌉]（原始码，x = offset + q × scale）
+ *   WAVE_Z  f32 qscale, u16 n, u16 step, u16 block, u16 保留 0，之后 ⌈n / block⌉ 个 ad_codec 块（每段独立码流，历史清零）
+ *           x = q / qscale；qscale 取 ESP_UPLOAD_SCALE 时 q 就是 JSON 里的 ×200 整数，相对 JSON 无损
+ *   EVENT_Z 与 EVENT 相同的头 + u16 block + u16 保留 0；每通道 u8 phys, u8 保留[3], f32 scale, f32 offset, u32 nbytes,
+ *           nbytes 字节 ad_codec 块（原始码无损，每通道独立码流）
+ *   SPOOL 实时帧里的 SD 缓存补传进度：u32 pending, pending_ev（其中故障/事件帧）, kb（待补传千字节）, replayed, dropped；
+ *         u8 replaying（1 = 正在补传）, u8 保留[3]
+ *   TIME  u32 unix（采集时的 RTC 秒，未校时可能不准）, u32 保留 0；只出现在 SD 缓存帧（flags 带 AD_FRAME_FLAG_SPOOL） */
+
+#define AD_FRAME_MAGIC   0x46425745u /* "EWBF" */
+#define AD_FRAME_VERSION 1u
+#define AD_FRAME_HDR_LEN 32u
+#define AD_FRAME_SEC_HDR_LEN 8u
+#define AD_FRAME_CRC_LEN 4u
+#define AD_FRAME_NODE_MAX 64u
+#define AD_FRAME_CH_NONE 0xFFu
+
+#define AD_FRAME_SEC_CHAN  0x01u
+#define AD_FRAME_SEC_WAVE  0x02u
+#define AD_FRAME_SEC_SPEC  0x03u
+#define AD_FRAME_SEC_HARM  0x04u
+#define AD_FRAME_SEC_CLASS 0x05u
+#define AD_FRAME_SEC_ISO   0x06u
+#define AD_FRAME_SEC_EVENT 0x07u
+#define AD_FRAME_SEC_WAVE_Z  0x08u
+#define AD_FRAME_SEC_EVENT_Z 0x09u
+#define AD_FRAME_SEC_SPOOL   0x0Au
+#define AD_FRAME_SEC_TIME    0x0Bu
+
+/* 帧头 flags */
+#define AD_FRAME_FLAG_SPOOL 0x01u /* 断线期间写进 SD 缓存、恢复后补传的历史帧（非实时） */
+
+/* 频谱对数量化步长（dB/码）：0.5 dB 时动态范围 127 dB，相对误差 ≤ ±2.9%（谱峰 ref 本身无误差） */
+#ifndef AD_FRAME_SPEC_DB_STEP
+#define AD_FRAME_SPEC_DB_STEP 0.5f
+#endif
+
+typedef struct
+{
+    uint32_t seq;
+    uint32_t sample_rate;
+    uint32_t tick_ms;
+    uint8_t ch_count;
+    uint8_t ch_mask;
+    uint8_t os_mode;
+    uint8_t profile;
+    uint8_t flags;      /* AD_FRAME_FLAG_* */
+    char fault_code[4];
+} AD_FrameHeader_t;
+
+/* 写入器：缓冲不足后 ok 置 0，之后的写入全部忽略，End 返回 0 */
+typedef struct
+{
+    uint8_t *buf;
+    uint32_t cap;
+    uint32_t len;
+    uint32_t sec_off;   /* 当前段头位置（SecBegin 之后有效） */
+    uint16_t sections;
+    uint8_t ok;
+    uint8_t in_sec;
+    /* 流式输出（BeginStream 之后有效） */
+    uint16_t sections_decl; /* 帧头里声明的段数 */
+    uint32_t crc;           /* 已换出的缓冲累加的 CRC */
+    uint32_t flushed;       /* 已换出的字节数（帧总长 = flushed + len） */
+} AD_FrameWriter_t;
+
+/* 帧头 + node_id（超过 AD_FRAME_NODE_MAX 截断） */
+void AD_Frame_Begin(AD_FrameWriter_t *w, uint8_t *buf, uint32_t cap, const AD_FrameHeader_t *h, const char *node_id);
+
+/* 通用段：SecBegin 后用 Put* 写负载，SecEnd 回填段长 */
+void AD_Frame_SecBegin(AD_FrameWriter_t *w, uint8_t type, uint8_t ch);
+void AD_Frame_SecEnd(AD_FrameWriter_t *w);
+void AD_Frame_PutU8(AD_FrameWriter_t *w, uint8_t v);
+void AD_Frame_PutU16(AD_FrameWriter_t *w, uint16_t v);
+void AD_Frame_PutU32(AD_FrameWriter_t *w, uint32_t v);
+void AD_Frame_PutF32(AD_FrameWriter_t *w, float v);
+void AD_Frame_PutBytes(AD_FrameWriter_t *w, const void *p, uint32_t n);
+
+/* 常用段 */
+void AD_Frame_AddChan(AD_FrameWriter_t *w, uint8_t ch, float value, const AD_Stats_t *st);
+/* 波形：每 step 点取 1 点，按本段极值自适应量化到 int16（满量程 ±32767） */
+void AD_Frame_AddWave(AD_FrameWriter_t *w, uint8_t ch, const float *x, uint32_t n, uint32_t step);
+/* 幅值谱：以本段最大值为 ref 对数量化到 u8（≤ 0 的点记 0） */
+void AD_Frame_AddSpec(AD_FrameWriter_t *w, uint8_t ch, const float *s, uint32_t n, uint32_t step);
+/* 无损压缩波形：每 step 点取 1 点，q = round(x × qscale) 后按 ad_codec 分块编码（c 的第 0 路，段首清历史） */
+void AD_Frame_AddWaveZ(AD_FrameWriter_t *w, AD_Codec_t *c, uint8_t ch, const float *x, uint32_t n, uint32_t step,
+                       float qscale);
+/* 在当前段里追加一个 ad_codec 块（n ≤ AD_CODEC_BLOCK，预测历史用 c 的第 slot 路）；返回写入字节数 */
+uint32_t AD_Frame_PutCodecBlock(AD_FrameWriter_t *w, AD_Codec_t *c, uint32_t slot, const int32_t *x, uint32_t n);
+void AD_Frame_AddFloats(AD_FrameWriter_t *w, uint8_t type, uint8_t ch, const float *v, uint32_t n);
+
+/* 回填段数、追加 CRC；返回整帧长度，缓冲不足（或段未结束）返回 0 */
+uint32_t AD_Frame_End(AD_FrameWriter_t *w);
+
+/* 流式输出：整帧不在内存里驻留，一段一段写进调用方轮换的小缓冲（上报发送的乒乓 DMA 段）
+ * - BeginStream 事先给定段数写进帧头（帧格式不变，解码端无区别）
+ * - 一块缓冲交出去之前不用做什么；换下一块时调 Rebase，写入器把上一块的内容累加进 CRC
+ * - 段不能跨缓冲：段写到一半缓冲不足（ok = 0）时，调用方恢复写段前的写入器副本，Rebase 到空缓冲后重写该段
+ * - EndStream 核对段数，在当前缓冲追加 CRC；返回当前缓冲的长度，失败返回 0 */
+void AD_Frame_BeginStream(AD_FrameWriter_t *w, uint8_t *buf, uint32_t cap, const AD_FrameHeader_t *h,
+                          const char *node_id, uint16_t sections);
+void AD_Frame_Rebase(AD_FrameWriter_t *w, uint8_t *buf, uint32_t cap);
+uint32_t AD_Frame_EndStream(AD_FrameWriter_t *w);
+
+/* CRC32（IEEE 802.3，反射多项式 0xEDB88320）；首次调用 crc 传 0，可分段累加 */
+uint32_t AD_Frame_Crc32(uint32_t crc, const void *p, uint32_t n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AD_FRAME_H */
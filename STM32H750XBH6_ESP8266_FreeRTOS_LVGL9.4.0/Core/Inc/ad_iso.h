@@ -0,0 +1,99 @@
+#ifndef AD_ISO_H
+#define AD_ISO_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/* 直流母线对地绝缘电阻 R+ / R− 流式估计（每块一次，只用块均值，O(1)，不另开缓冲）
+ *
+ * 量：U+ = 正极对地电压，U− = 负极对地电压（都取正值），i = 漏电流直流分量（mA，正 = 从正极经绝缘入地）
+ *     电阻单位 kΩ（V / mA），电导 mS
+ *
+ * 不平衡电桥法（需要板上有可切换的桥臂电阻，见 AD_Iso_SetBridge）：
+ *   每极对地有已知桥臂电阻 Rb（测量分压的对地电阻），轮流在正极 / 负极对地并入已知电阻 Rs，
+ *   每个状态丢弃 settle 块后取 avg 块的 U+ / U− 均值，大地节点 KCL 给出两个方程：
+ *     状态1（Rs 在正极）：U1+ (G+ + Gb + Gs) = U1− (G− + Gb)
+ *     状态2（Rs 在负极）：U2+ (G+ + Gb)      = U2− (G− + Gb + Gs)
+ *   解 2×2 线性方程得 G+ / G−，每完成一轮（2 个状态）更新一次；行列式过小（切换没生效）本轮作废
+ * 被动法（没有切换硬件时）：
+ *   单一直流工况只有一个方程，R+ / R− 不可分；按单极接地假设，漏电流方向判断故障极：
+ *     i > 0：R+ = U+ / i，R− 视为无穷；i < 0：R− = U− / |i|，R+ 视为无穷（|i| 小于 AD_ISO_I_MIN_MA 时两极都为无穷）
+ *   双极同时劣化时被动法给出的是偏大的估计
+ * 趋势与变化率：对 G = 1 / (R+ ∥ R−) 做快/慢两个一阶低通（电导随漏电流线性，接近无穷大时不跳变），
+ *   趋势 = 1 / 快低通；线性变化时两个低通的差 = 斜率 × (τ慢 − τ快)，由此得相对变化率 %/h（负 = 绝缘下降）；
+ *   趋势值高于 rate_gate_kohm 时变化率记 0（绝缘良好时的大数值波动不报） */
+
+#ifndef AD_ISO_R_MAX_KOHM
+#define AD_ISO_R_MAX_KOHM 1.0e6f /* 1GΩ，视为无穷 */
+#endif
+
+#ifndef AD_ISO_I_MIN_MA
+#define AD_ISO_I_MIN_MA 1.0e-3f
+#endif
+
+typedef enum
+{
+    AD_ISO_BRIDGE_OFF = 0, /* 不并入 Rs */
+    AD_ISO_BRIDGE_POS,     /* Rs 并在正极对地 */
+    AD_ISO_BRIDGE_NEG,     /* Rs 并在负极对地 */
+} AD_IsoBridge_t;
+
+typedef enum
+{
+    AD_ISO_MODE_PASSIVE = 0,
+    AD_ISO_MODE_BRIDGE,
+} AD_IsoMode_t;
+
+typedef struct
+{
+    float r_bridge_kohm;  /* 每极对地桥臂电阻 Rb（0 = 不计） */
+    float r_switch_kohm;  /* 切入电阻 Rs */
+    uint8_t settle_blocks; /* 切换后丢弃的块数 */
+    uint8_t avg_blocks;    /* 每个状态平均的块数（≥1） */
+    float trend_tau_s;     /* 趋势（快）低通时间常数 */
+    float rate_tau_s;      /* 慢低通时间常数（> trend_tau_s） */
+    float rate_gate_kohm;  /* 趋势值高于此值时变化率记 0 */
+} AD_IsoConfig_t;
+
+/* 一块的输入（块均值） */
+typedef struct
+{
+    float u_p;          /* V */
+    float u_n;          /* V */
+    float i_leak;       /* mA，NaN = 无漏电流通道 */
+    float dt_s;         /* 距上一块的时间 */
+    uint8_t powered;    /* 母线已上电（否则本块不估计、趋势不更新） */
+    uint8_t bridge_hw;  /* 有切换硬件：走不平衡电桥法 */
+} AD_IsoInput_t;
+
+typedef struct
+{
+    uint8_t mode;        /* AD_IsoMode_t */
+    uint8_t valid;       /* 已有估计 */
+    uint8_t bridge;      /* 下一块要求的桥臂状态（AD_IsoBridge_t），由板级执行 */
+    float r_p_kohm;      /* 最近一次估计（无穷 = AD_ISO_R_MAX_KOHM） */
+    float r_n_kohm;
+    float r_iso_kohm;    /* R+ ∥ R− */
+    float trend_kohm;    /* 趋势（NaN = 尚无估计） */
+    float rate_pct_h;    /* 相对变化率 %/h（NaN = 慢低通未稳定） */
+    uint32_t updates;    /* 估计更新次数 */
+    uint32_t rejected;   /* 电桥法作废轮数 */
+} AD_IsoResult_t;
+
+void AD_Iso_DefaultConfig(AD_IsoConfig_t *cfg);
+int AD_Iso_ConfigValid(const AD_IsoConfig_t *cfg);
+
+/* 清空估计、趋势与电桥状态机（配置变化时由调用者负责） */
+void AD_Iso_Reset(void);
+
+/* 每块调用一次（单任务）；out->bridge 为下一块要求的桥臂状态 */
+void AD_Iso_Update(const AD_IsoConfig_t *cfg, const AD_IsoInput_t *in, AD_IsoResult_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AD_ISO_H */
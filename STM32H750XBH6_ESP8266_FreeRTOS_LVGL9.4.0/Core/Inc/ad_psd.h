@@ -0,0 +1,108 @@
+#ifndef AD_PSD_H
+#define AD_PSD_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "ad_acq_buffers.h"
+#include "arm_math.h"
+
+/* 流式 Welch 功率谱（DSP 任务内随块增量更新）
+ * - 每来一个块就把工程量波形追加到各通道的段缓冲，凑满 AD_PSD_NFFT 点算一段：
+ *   加窗（CMSIS WindowFunctions：Hann / HFT95 平顶）-> rfft -> |X|² -> 单边 PSD，
+ *   然后按重叠率左移（hop = NFFT × (1 - 重叠率)），一个块可能产出 0..多段
+ * - 平均：指数（前 avg_n 段等权，之后权重 1/avg_n 的指数遗忘）或 线性 N 段（满 N 段出一次结果再清零）
+ * - 块不连续只丢弃未凑满的段，已有平均保留；采样率变化或改配置时整体重来
+ * - 内存固定：窗表 + 每通道（段缓冲 NFFT + 累加 NFFT/2 + 线性平均结果 NFFT/2）个 float，放 SDRAM
+ * PSD 单位：工程量²/Hz，P[k] = 2|X[k]|² / (fs × Σw²)（k=0 不乘 2），bin 宽 fs / NFFT
+ * 谐波幅值（峰值，工程量）从平均后的 PSD 取：
+ * - Hann：峰值 bin ±2 的带内功率 Σ P × Δf（窗的 ENBW 已由 Σw² 归一化抵消），A = √(2 × 带内功率)
+ * - 平顶：峰值 bin 的幅值 × 相干增益修正，A = √(2 × P × fs × Σw²) / Σw（平顶窗扇贝损失 < 0.01dB） */
+
+#ifndef AD_PSD_NFFT
+#define AD_PSD_NFFT AD_ACQ_POINTS
+#endif
+
+#define AD_PSD_BINS (AD_PSD_NFFT / 2u)
+
+/* 谐波：基波频率 × 1..AD_PSD_HARMONICS */
+#ifndef AD_PSD_FUND_HZ
+#define AD_PSD_FUND_HZ 50.0f
+#endif
+
+#ifndef AD_PSD_HARMONICS
+#define AD_PSD_HARMONICS 8u
+#endif
+
+/* 状态区：SDRAM 中 DSP 快照池（0xC0780000，预留 1.5MB）之后
+ * 占用 (NFFT + 通道数 × 2 × NFFT) × 4 字节（4 通道 4096 点 144KB） */
+#ifndef AD_PSD_STATE_SDRAM_ADDR
+#define AD_PSD_STATE_SDRAM_ADDR 0xC0900000u
+#endif
+
+typedef enum
+{
+    AD_PSD_WIN_HANN = 0,
+    AD_PSD_WIN_FLATTOP,
+    AD_PSD_WIN_COUNT
+} AD_PsdWindow_t;
+
+typedef enum
+{
+    AD_PSD_AVG_EXP = 0,
+    AD_PSD_AVG_LINEAR,
+    AD_PSD_AVG_COUNT
+} AD_PsdAvg_t;
+
+typedef struct
+{
+    uint8_t window;      /* AD_PsdWindow_t */
+    uint8_t avg_mode;    /* AD_PsdAvg_t */
+    uint8_t overlap_pct; /* 段重叠率 0..75（%） */
+    uint16_t avg_n;      /* 平均段数 1..1000 */
+} AD_PsdConfig_t;
+
+/* 默认：Hann、50% 重叠、指数平均 8 段 */
+#define AD_PSD_CONFIG_DEFAULT {AD_PSD_WIN_HANN, AD_PSD_AVG_EXP, 50u, 8u}
+
+typedef struct
+{
+    uint32_t segments;  /* 当前结果对应的平均段数（0 = 还没有结果） */
+    float bin_hz;       /* 频率分辨率 */
+    uint8_t window;     /* 结果所用的窗 */
+    uint8_t avg_mode;
+} AD_PsdInfo_t;
+
+typedef struct
+{
+    uint32_t segments;  /* 累计计算段数 */
+    uint32_t gaps;      /* 块不连续次数 */
+    uint32_t resets;    /* 采样率变化/改配置导致的整体重来次数 */
+} AD_PsdStats_t;
+
+/* DSP 任务初始化时调用；work 为至少 2 × AD_PSD_NFFT 个 float 的工作区（可与其它频谱计算共用） */
+void AD_Psd_Init(float32_t *work);
+
+/* 任意任务：提交新配置，DSP 任务下一个块生效；返回 0=参数非法 */
+int AD_Psd_Configure(const AD_PsdConfig_t *cfg);
+void AD_Psd_GetConfig(AD_PsdConfig_t *cfg);
+
+/* DSP 任务：喂一个块（wave[ch] 各 n 点工程量） */
+void AD_Psd_Feed(const float *const wave[], uint32_t n, uint32_t block_seq, uint32_t sample_rate);
+
+/* DSP 任务：导出逻辑通道 ch 当前的平均 PSD（AD_PSD_BINS 点）与谐波幅值（AD_PSD_HARMONICS 个）
+ * psd / harm 可为 NULL（只要其一） */
+void AD_Psd_Export(uint32_t ch, float *psd, float *harm);
+void AD_Psd_GetInfo(AD_PsdInfo_t *info);
+
+void AD_Psd_GetStats(AD_PsdStats_t *st);
+
+const char *AD_Psd_WindowName(uint32_t window);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AD_PSD_H */
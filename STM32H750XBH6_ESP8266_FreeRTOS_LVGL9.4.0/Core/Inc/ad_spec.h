@@ -0,0 +1,49 @@
+#ifndef AD_SPEC_H
+#define AD_SPEC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "arm_math.h"
+
+/* 多通道幅值谱内核：两路实信号打包成一次复 FFT
+ * - z[n] = a[n] + j·b[n]，Z = CFFT(z)，再按共轭对称拆开：
+ *     A[k] = (Z[k] + conj(Z[N-k])) / 2      B[k] = (Z[k] - conj(Z[N-k])) / 2j
+ *   每两路通道只做一次 N 点复 FFT，省掉一次 rfft 的后处理（split）与一半的调用/取数开销
+ * - 通道数为奇数时最后一路走单路 rfft（AD_Spec_MagSingle），2/4/8 通道全部成对
+ * - 输出 out[k] = |X[k]| × scale，k = 0..N/2-1；bin0 为 |X[0]|（rfft 打包格式里混入的 Nyquist 已剔除），
+ *   单路与成对两条路径的定义一致，差异只在浮点舍入（最大偏差约为谱峰的 2e-7，见 tools/dsp_bench/spec_pair_bench.c）
+ * - 不带任何静态缓冲：工作区由调用者提供（2N 个 float，建议放 AXI SRAM），内核可在主机上直接编译 */
+
+#define AD_SPEC_MAX_POINTS 4096u
+
+typedef struct
+{
+    arm_cfft_instance_f32 cfft;      /* N 点复 FFT（成对） */
+    arm_rfft_fast_instance_f32 rfft; /* N 点实 FFT（落单通道） */
+    uint32_t n;
+    float32_t *work;                 /* 2N 个 float */
+} AD_SpecKernel_t;
+
+/* n：2 的幂，32..AD_SPEC_MAX_POINTS；work：至少 2n 个 float
+ * 返回 1=成功，0=点数不支持 */
+int AD_Spec_Init(AD_SpecKernel_t *k, uint32_t n, float32_t *work);
+
+/* 两路实信号 -> 两路幅值谱（输入只读） */
+void AD_Spec_MagPair(AD_SpecKernel_t *k, const float32_t *a, const float32_t *b,
+                     float32_t *mag_a, float32_t *mag_b, float32_t scale);
+
+/* 单路实信号 -> 幅值谱（逐通道 rfft，与原处理方式相同） */
+void AD_Spec_MagSingle(AD_SpecKernel_t *k, const float32_t *x, float32_t *mag, float32_t scale);
+
+/* nch 路：两两成对，奇数时最后一路单独算 */
+void AD_Spec_MagMulti(AD_SpecKernel_t *k, const float32_t *const in[], float32_t *const out[],
+                      uint32_t nch, float32_t scale);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AD_SPEC_H */
@@ -0,0 +1,41 @@
+#ifndef AD_STATS_H
+#define AD_STATS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/* 单趟统计内核：一次遍历得到均值/RMS/极值/峰峰值/峰值因数/偏度/峭度
+ * - 先减去基准点再累加 Σd、Σd²、Σd³、Σd⁴，最后换算为中心矩：
+ *   直流母线这类大直流小纹波的信号不会因 float 累加相消丢精度
+ * - 基准点：逐块处理时传同一通道上一块的均值（ComputeRef）；没有时取首/中/尾三点的中位数，
+ *   块首恰好是尖峰也不会被选作基准（否则 μ2/μ4 换算时大量相消）
+ * - 4 路独立累加器展开，循环体内无跨迭代依赖，M7 双发射流水线可并行；
+ *   累加为单精度，每块一次的原点矩→中心矩换算用双精度
+ * - 峭度为 Pearson 定义（正态分布 = 3，尖峰/冲击使其明显增大）；方差为 0 时偏度/峭度/峰值因数置 0
+ * - 不依赖 HAL，可在主机上直接编译（tools/dsp_bench/stats_bench.c） */
+
+typedef struct
+{
+    float mean;
+    float rms;    /* √(mean(x²))，含直流 */
+    float min;
+    float max;
+    float p2p;    /* max - min */
+    float std;    /* 标准差（总体） */
+    float crest;  /* max(|min|, |max|) / rms */
+    float skew;   /* μ3 / σ³ */
+    float kurt;   /* μ4 / σ⁴ */
+} AD_Stats_t;
+
+/* ref：基准点（同一通道上一块的均值）；传 NAN 等同 AD_Stats_Compute */
+void AD_Stats_ComputeRef(const float *x, uint32_t n, float ref, AD_Stats_t *st);
+void AD_Stats_Compute(const float *x, uint32_t n, AD_Stats_t *st);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AD_STATS_H */
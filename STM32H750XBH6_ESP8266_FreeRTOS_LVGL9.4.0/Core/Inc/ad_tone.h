@@ -0,0 +1,83 @@
+#ifndef AD_TONE_H
+#define AD_TONE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "ad_acq_buffers.h"
+
+/* 纹波单频跟踪（Goertzel 组）
+ * - 在采样中断里逐帧更新（与 AD_Trig_OnFrame 同一路径），每个跟踪器每帧 1 次乘法、几次加减（单精度 FPU），
+ *   递推前扣除上一窗均值，直流母线的大直流分量不会吃掉单精度的有效位
+ * - 每个跟踪器独立的窗长 N：取最接近 AD_TONE_WINDOW_MS 的整周期数 m，N = round(m × fs / f)，
+ *   实际跟踪频率 m × fs / N（与目标差 < 0.5 个采样点对应的频率），窗内直流与 fs/N 整数倍的分量正交不泄漏
+ * - 每满 N 点发布一次复数结果（序号锁，读者不关中断），任务侧换算为幅值（峰值，工程量）与相位
+ *   延迟 = 一个窗长（默认 20ms），远低于 4096 点 FFT 的块周期
+ * - 配置在任务里编译（系数/窗长/标定系数），关中断拷贝；采样档位或标定表变化后由 AD_Tone_Service 重算，
+ *   重算完成前中断侧暂停累加 */
+
+#ifndef AD_TONE_MAX
+#define AD_TONE_MAX 8u
+#endif
+
+/* 目标窗长（毫秒），每个跟踪器按整周期取整 */
+#ifndef AD_TONE_WINDOW_MS
+#define AD_TONE_WINDOW_MS 20u
+#endif
+
+/* 默认跟踪：直流母线(+)（物理通道 0）的 50/100/150/300Hz 与变换器开关频率 */
+#ifndef AD_TONE_DEFAULT_CH
+#define AD_TONE_DEFAULT_CH 0u
+#endif
+
+#ifndef AD_TONE_FSW_HZ
+#define AD_TONE_FSW_HZ 10000.0f
+#endif
+
+typedef struct
+{
+    uint8_t phys;  /* 物理通道 0..7（须在 AD_ACQ_CH_MASK 中） */
+    float hz;      /* 目标频率，0 = 空位 */
+} AD_ToneChCfg_t;
+
+typedef struct
+{
+    uint32_t window_ms;          /* 目标窗长 */
+    AD_ToneChCfg_t t[AD_TONE_MAX];
+} AD_ToneConfig_t;
+
+typedef struct
+{
+    uint32_t seq;        /* 该跟踪器第几次输出（0 = 尚无结果） */
+    uint32_t tick_ms;    /* 窗结束时刻 */
+    uint32_t frame;      /* 窗首帧的帧号（AD_Tone 自己的计数，从 AD_Tone_Init 起） */
+    uint32_t len;        /* 窗长（点） */
+    float hz;            /* 实际跟踪频率 */
+    float amp;           /* 幅值（峰值，工程量） */
+    float phase_deg;     /* 相对窗首帧的相位（余弦基准，-180..180） */
+    uint8_t phys;
+} AD_ToneResult_t;
+
+void AD_Tone_Init(void);
+
+/* 采样中断上下文：每帧调用一次（紧跟 AD_Trig_OnFrame） */
+void AD_Tone_OnFrame(const uint16_t raw[8]);
+
+/* 任务上下文：配置；返回 false = 参数非法。频率 ≥ fs/2 或窗长不可行的跟踪器被跳过（Get 返回 false） */
+bool AD_Tone_SetConfig(const AD_ToneConfig_t *cfg);
+void AD_Tone_GetConfig(AD_ToneConfig_t *cfg);
+
+/* 任务上下文周期调用：标定表版本或采样档位变化时重算 */
+void AD_Tone_Service(void);
+
+/* 任意任务：取第 idx 个配置位的最新结果；未配置/不可行/尚无结果返回 false */
+bool AD_Tone_Get(uint32_t idx, AD_ToneResult_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AD_TONE_H */
@@ -0,0 +1,138 @@
+#ifndef AD_TRIGGER_H
+#define AD_TRIGGER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "ad_acq_buffers.h"
+
+/* 瞬态录波（故障触发捕获）
+ * - 触发判定在采样中断里逐帧进行（与 AD_Acq_PushFrame 同一路径），不丢帧、不降采样
+ * - 每个事件槽本身就是预触发环：待触发期间持续写入，触发后再写 post 帧即冻结，无需搬运
+ * - 事件池放 SDRAM；冻结后的事件交给各消费者（SD 写盘 / 上报），全部释放后槽位回收
+ * - 没有空闲槽时新的触发被忽略并计数，采样本身不受影响 */
+
+/* 单个事件最大帧数（预触发 + 触发帧 + 后触发） */
+#ifndef AD_TRIG_MAX_FRAMES
+#define AD_TRIG_MAX_FRAMES 8192u
+#endif
+
+#ifndef AD_TRIG_EVENT_SLOTS
+#define AD_TRIG_EVENT_SLOTS 4u
+#endif
+
+/* 事件池：SDRAM 0xC0600000 起 512KB 原为 HTTP 整包缓冲，现只有开头约 41KB 的上报发送段，地址保持不变
+ * 占用 AD_TRIG_EVENT_SLOTS × AD_TRIG_MAX_FRAMES × AD_ACQ_CHANNELS × 2 字节（4 通道默认 256KB） */
+#ifndef AD_TRIG_POOL_SDRAM_ADDR
+#define AD_TRIG_POOL_SDRAM_ADDR 0xC0680000u
+#endif
+
+/* 尖峰触发的基线跟踪：一阶 IIR，时间常数 = 2^SHIFT 个采样点（8 -> 10ms@25.6kHz）
+ * 采样率取当前采样档位（AD_Acq_SampleRate）；档位切换时正在录的事件提前冻结（post 截短），
+ * 预触发环与检测器状态清空，dV/dt 门限与保持帧数在 AD_Trig_Service 里按新采样率重算 */
+#ifndef AD_TRIG_SPIKE_SHIFT
+#define AD_TRIG_SPIKE_SHIFT 8u
+#endif
+
+#define AD_TRIG_CFG_FILE "0:/config/ad_trigger.cfg"
+
+typedef enum
+{
+    AD_TRIG_OFF = 0,
+    AD_TRIG_LEVEL_ABOVE, /* x >= level */
+    AD_TRIG_LEVEL_BELOW, /* x <= level */
+    AD_TRIG_SLOPE_RISE,  /* 上穿 level */
+    AD_TRIG_SLOPE_FALL,  /* 下穿 level */
+    AD_TRIG_DVDT,        /* |dx/dt| >= level（工程量/秒） */
+    AD_TRIG_SPIKE,       /* |x - 基线| >= level（漏电流尖峰） */
+    AD_TRIG_SOFT,        /* 软件触发（AD_Trig_Force，本地故障判定），不可作为通道配置 */
+} AD_TrigType_t;
+
+typedef struct
+{
+    uint8_t type;  /* AD_TrigType_t */
+    float level;   /* 工程量（经标定表换算为原始码门限） */
+} AD_TrigChCfg_t;
+
+typedef struct
+{
+    uint32_t pre_frames;   /* 预触发深度 */
+    uint32_t post_frames;  /* 后触发深度（pre + 1 + post <= AD_TRIG_MAX_FRAMES） */
+    uint32_t holdoff_ms;   /* 两次触发的最小间隔 */
+    AD_TrigChCfg_t ch[8];  /* 按物理通道；未启用的通道忽略 */
+} AD_TrigConfig_t;
+
+/* 消费者位：事件冻结时挂上当前已登记的消费者，全部 Release 后槽位回收 */
+#define AD_TRIG_CONSUMER_SD     (1u << 0)
+#define AD_TRIG_CONSUMER_UPLINK (1u << 1)
+
+/* 冻结事件的只读描述 */
+typedef struct
+{
+    uint32_t seq;          /* 事件序号（从 1 递增） */
+    uint32_t tick_ms;      /* 触发时刻 HAL_GetTick() */
+    uint32_t trig_frame;   /* 触发帧的全局帧号 */
+    uint32_t sample_rate;  /* 事件数据的实际采样率 */
+    uint8_t os_mode;       /* 事件数据的过采样倍率 */
+    uint32_t pre;          /* 实际预触发帧数（开机/刚复位时可能不足配置值） */
+    uint32_t post;
+    uint32_t frames;       /* pre + 1 + post */
+    uint8_t trig_ch;       /* 触发通道（物理） */
+    uint8_t trig_type;     /* AD_TrigType_t */
+    char fault_code[4];    /* 触发时的故障码 */
+    uint32_t slot;         /* 内部槽号 */
+} AD_TrigEvent_t;
+
+typedef struct
+{
+    uint32_t events;       /* 已冻结事件数 */
+    uint32_t no_slot;      /* 触发时无空闲槽被忽略的次数 */
+    uint32_t fired_ch[8];  /* 各物理通道触发次数 */
+    uint32_t forced;       /* 软件触发次数 */
+} AD_TrigStats_t;
+
+void AD_Trig_Init(void);
+
+/* 采样中断上下文：每帧调用一次（紧跟 AD_Acq_PushFrame，其返回 0 的过渡帧不调用） */
+void AD_Trig_OnFrame(const uint16_t raw[8]);
+
+/* 任务上下文：修改/读取配置（门限按当前标定表换算；正在待触发的槽会重新开始积累预触发） */
+bool AD_Trig_SetConfig(const AD_TrigConfig_t *cfg);
+void AD_Trig_GetConfig(AD_TrigConfig_t *cfg);
+bool AD_Trig_LoadFromSD(void);
+
+/* 任务上下文：请求一次软件触发，下一帧生效（不受保持期限制；正在录后触发时顺延到其冻结之后）
+ * phys 记入事件的触发通道；在 AD_Trig_Force 之前更新故障码，事件即带上新的故障码 */
+void AD_Trig_Force(uint8_t phys);
+
+/* 登记/注销消费者（注销时同时释放该消费者未处理的事件） */
+void AD_Trig_SetConsumer(uint32_t consumer, bool enable);
+
+/* 消费者：取最早一个尚未处理的事件；无事件返回 false */
+bool AD_Trig_Acquire(uint32_t consumer, AD_TrigEvent_t *ev);
+void AD_Trig_Release(uint32_t consumer, const AD_TrigEvent_t *ev);
+
+/* 事件数据（原始码，帧内按逻辑通道交织）：环形存放，最多两段 */
+uint32_t AD_Trig_Segments(const AD_TrigEvent_t *ev, const int16_t **seg0, uint32_t *frames0,
+                          const int16_t **seg1, uint32_t *frames1);
+/* 取第 frame 帧、逻辑通道 ch 的原始码 */
+int16_t AD_Trig_Sample(const AD_TrigEvent_t *ev, uint32_t frame, uint32_t ch);
+
+void AD_Trig_GetStats(AD_TrigStats_t *st);
+
+/* 任务上下文周期调用：标定表/采样档位变化时重算门限，并把新事件写入 SD */
+void AD_Trig_Service(void);
+
+/* 触发时读取当前故障码（弱定义默认 "E00"，由上报模块覆盖） */
+void AD_Trig_GetFaultCode(char code[4]);
+
+const char *AD_Trig_TypeName(uint8_t type);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AD_TRIGGER_H */
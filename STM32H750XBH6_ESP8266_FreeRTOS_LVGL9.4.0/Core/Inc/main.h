@@ -91,6 +91,10 @@ void Error_Handler(void);
 /* 采样点数（双缓冲采集长度）：4096 点（降低以减轻 FFT/UI 负载，缓解卡顿） */
 #define AD_ACQ_POINTS 4096
 
+/* 启用的 AD7606 通道掩码（bit n = V(n+1)）：缓冲区、DSP 循环、上报与 UI 通道数都由它决定
+ * 0x0F = 母线+/母线-/负载电流/漏电流；0xFF = 再加组串电流 1/2 与漏电流 2/3 */
+#define AD_ACQ_CH_MASK 0x0Fu
+
 /* AD7606 过采样模式：
  * 25.6kHz 下必须使用 OS=0（无过采样）才能避免 BUSY 过长导致 miss≈frames、UI卡顿。 */
 #define AD7606_OS_MODE 0u
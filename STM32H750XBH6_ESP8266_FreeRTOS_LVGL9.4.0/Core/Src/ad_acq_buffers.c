@@ -1,15 +1,381 @@
 #include "ad_acq_buffers.h"
+#include "main.h"
+#include "SPI_AD7606.h"
+#include "ad7606_calib.h"
+#include "cmsis_os.h"
+#include "ad_atomic.h"
 
 #define AXI_SRAM_SECTION __attribute__((section(".axi_sram")))
 #define DMA_ALIGN32 __attribute__((aligned(32)))
 
-/* 4096 点双缓冲：放 AXI SRAM，避免 DTCM(128KB) 溢出导致启动卡死/HardFault */
-float ADSA_B[4][AD_ACQ_POINTS] AXI_SRAM_SECTION DMA_ALIGN32;
-float ADSA_B2[4][AD_ACQ_POINTS] AXI_SRAM_SECTION DMA_ALIGN32;
-float ADS131A04_Buf[4] = {0};
+/* 槽元数据：seq=0 表示空或正在写；readers=持有该槽的消费者数 */
+typedef struct
+{
+    acq_atomic_t seq;
+    acq_atomic_t readers;
+    uint32_t tick_ms;
+    uint32_t first_frame;
+    uint32_t sample_rate;
+    uint8_t os_mode;
+    uint8_t profile;
+} AcqSlotMeta_t;
 
-int ADS131A04_flag = 0;
-int ADS131A04_flag2 = 2;
-int number = 0;
-int number2 = 0;
+/* 槽数据放 AXI SRAM，避免 DTCM(128KB) 溢出导致启动卡死/HardFault */
+static int16_t s_acq_data[AD_ACQ_RING_SLOTS][AD_ACQ_CHANNELS][AD_ACQ_POINTS] AXI_SRAM_SECTION DMA_ALIGN32;
+static AcqSlotMeta_t s_slot[AD_ACQ_RING_SLOTS];
 
+static acq_atomic_t s_pub_slot = 0;   /* 最新发布的槽号 */
+static uint32_t s_seq = 0;            /* 最近一次发布的块序号（仅生产者写） */
+static int32_t s_wr_slot = -1;        /* 正在写的槽，-1=无空闲槽（丢帧中） */
+static uint32_t s_wr_pos = 0;
+static uint32_t s_frame_no = 0;
+static uint32_t s_wr_first_frame = 0;
+static volatile AD_AcqStats_t s_stats;
+static uint8_t s_phys[AD_ACQ_CHANNELS]; /* 逻辑通道 -> 物理通道 */
+
+/* 档位 0 与 main.h 中的上电配置一致（TIM2 25.6kHz、AD7606_OS_MODE=0） */
+static const AD_AcqProfile_t s_profiles[AD_ACQ_PROFILE_COUNT] = {
+    {"25.6kHz OSx1", 25600u, 0u},
+    {"12.8kHz OSx2", 12800u, 1u},
+    {"6.4kHz OSx4", 6400u, 2u},
+    {"3.2kHz OSx8", 3200u, 3u},
+};
+
+#define ACQ_PROFILE_NONE 0xFFFFFFFFu
+
+static acq_atomic_t s_prof_req = ACQ_PROFILE_NONE; /* 待生效档位（任务写，中断取走） */
+static AD7606_Timing_t s_prof_timing;               /* 待生效档位的定时参数（与 s_prof_req 一起在关中断下写） */
+static volatile uint32_t s_prof_active = 0;
+static volatile uint32_t s_prof_rate = 0;
+static volatile uint8_t s_prof_os = 0;
+static volatile uint32_t s_prof_seq = 0;
+static uint32_t s_settle = 0;
+
+/* 生产者占用一个空闲槽：先把 seq 清 0（让新来的消费者放弃），再确认无人持有 */
+static int32_t AD_Acq_ClaimSlot(uint32_t start)
+{
+    for (uint32_t k = 0; k < AD_ACQ_RING_SLOTS; k++)
+    {
+        uint32_t i = (start + k) % AD_ACQ_RING_SLOTS;
+        if (s_seq != 0u && i == ACQ_LOAD(&s_pub_slot))
+            continue; /* 最新块留给消费者 */
+        if (ACQ_LOAD(&s_slot[i].readers) != 0u)
+            continue;
+        uint32_t old = ACQ_LOAD(&s_slot[i].seq);
+        ACQ_STORE(&s_slot[i].seq, 0u);
+        ACQ_FENCE();
+        if (ACQ_LOAD(&s_slot[i].readers) == 0u)
+            return (int32_t)i;
+        ACQ_STORE(&s_slot[i].seq, old); /* 刚好被消费者抢到，恢复后换下一个 */
+    }
+    return -1;
+}
+
+void AD_Acq_Init(void)
+{
+    for (uint32_t i = 0; i < AD_ACQ_RING_SLOTS; i++)
+    {
+        ACQ_STORE(&s_slot[i].seq, 0u);
+        ACQ_STORE(&s_slot[i].readers, 0u);
+        s_slot[i].tick_ms = 0;
+        s_slot[i].first_frame = 0;
+    }
+    ACQ_STORE(&s_pub_slot, 0u);
+    s_seq = 0;
+    s_wr_slot = 0;
+    s_wr_pos = 0;
+    s_frame_no = 0;
+    s_wr_first_frame = 0;
+    s_stats.blocks = 0;
+    s_stats.frames = 0;
+    s_stats.dropped_frames = 0;
+    s_stats.drop_events = 0;
+
+    /* 上电档位：元数据先按默认档位填好，硬件参数在第一帧到来时由中断写入（此时 AD7606_Init 已完成） */
+    s_prof_active = AD_ACQ_PROFILE_DEFAULT;
+    s_prof_rate = s_profiles[AD_ACQ_PROFILE_DEFAULT].sample_rate;
+    s_prof_os = s_profiles[AD_ACQ_PROFILE_DEFAULT].os_mode;
+    s_prof_seq = 0;
+    s_settle = 0;
+    ACQ_STORE(&s_prof_req, ACQ_PROFILE_NONE);
+    if (AD7606_TimingPrepare(s_prof_rate, s_prof_os, &s_prof_timing))
+    {
+        s_prof_rate = s_prof_timing.rate_hz;
+        ACQ_STORE(&s_prof_req, AD_ACQ_PROFILE_DEFAULT);
+    }
+
+    uint32_t lc = 0;
+    for (uint32_t n = 0; n < 8u; n++)
+    {
+        if (AD_ACQ_BIT(AD_ACQ_CH_MASK, n))
+            s_phys[lc++] = (uint8_t)n;
+    }
+}
+
+uint32_t AD_Acq_PhysChannel(uint32_t ch)
+{
+    return (ch < AD_ACQ_CHANNELS) ? s_phys[ch] : 0u;
+}
+
+const AD_AcqProfile_t *AD_Acq_GetProfile(uint32_t idx)
+{
+    return (idx < AD_ACQ_PROFILE_COUNT) ? &s_profiles[idx] : NULL;
+}
+
+int AD_Acq_RequestProfile(uint32_t idx)
+{
+    AD7606_Timing_t t;
+
+    if (idx >= AD_ACQ_PROFILE_COUNT)
+        return 0;
+    if (!AD7606_TimingPrepare(s_profiles[idx].sample_rate, s_profiles[idx].os_mode, &t))
+        return 0;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    s_prof_timing = t;
+    ACQ_STORE(&s_prof_req, idx);
+    __set_PRIMASK(primask);
+    return 1;
+}
+
+uint32_t AD_Acq_ActiveProfile(void)
+{
+    return s_prof_active;
+}
+
+uint32_t AD_Acq_SampleRate(void)
+{
+    return s_prof_rate;
+}
+
+uint8_t AD_Acq_OsMode(void)
+{
+    return s_prof_os;
+}
+
+uint32_t AD_Acq_ProfileSeq(void)
+{
+    return s_prof_seq;
+}
+
+/* 弱定义：块发布通知默认不做任何事（DSP 模块覆盖为唤醒 DSP 任务） */
+__weak void AD_Acq_OnBlockReady(uint32_t seq)
+{
+    (void)seq;
+}
+
+/* 采样中断、块边界：写定时器与 OS 引脚，随后若干帧作为过渡帧丢弃 */
+static void AD_Acq_ApplyProfile(void)
+{
+    uint32_t idx = ACQ_LOAD(&s_prof_req);
+    ACQ_STORE(&s_prof_req, ACQ_PROFILE_NONE);
+
+    AD7606_TimingApply(&s_prof_timing);
+    s_prof_active = idx;
+    s_prof_rate = s_prof_timing.rate_hz;
+    s_prof_os = s_prof_timing.os_mode;
+    s_prof_seq++;
+    s_settle = AD_ACQ_PROFILE_SETTLE_FRAMES;
+}
+
+int AD_Acq_PushFrame(const uint16_t raw[8])
+{
+    uint32_t frame = s_frame_no++;
+    s_stats.frames++;
+
+    if (s_wr_pos == 0u && ACQ_LOAD(&s_prof_req) != ACQ_PROFILE_NONE)
+        AD_Acq_ApplyProfile();
+    if (s_settle != 0u)
+    {
+        s_settle--;
+        return 0;
+    }
+
+    if (s_wr_slot < 0)
+    {
+        s_wr_slot = AD_Acq_ClaimSlot(ACQ_LOAD(&s_pub_slot) + 1u);
+        if (s_wr_slot < 0)
+        {
+            s_stats.dropped_frames++;
+            return 1;
+        }
+        s_wr_pos = 0;
+    }
+
+    if (s_wr_pos == 0u)
+        s_wr_first_frame = frame;
+
+    /* 按掩码逐通道展开（通道优先存放，步长 = AD_ACQ_POINTS） */
+    AD_Acq_Gather(&s_acq_data[s_wr_slot][0][s_wr_pos], AD_ACQ_POINTS, raw);
+
+    if (++s_wr_pos < AD_ACQ_POINTS)
+        return 1;
+
+    /* 发布：先写元数据，最后写 seq（release），消费者以 seq 非 0 判定可读 */
+    AcqSlotMeta_t *m = &s_slot[s_wr_slot];
+    m->tick_ms = HAL_GetTick();
+    m->first_frame = s_wr_first_frame;
+    m->sample_rate = s_prof_rate;
+    m->os_mode = s_prof_os;
+    m->profile = (uint8_t)s_prof_active;
+    ACQ_STORE(&m->seq, ++s_seq);
+    ACQ_STORE(&s_pub_slot, (uint32_t)s_wr_slot);
+    s_stats.blocks++;
+    AD_Acq_OnBlockReady(s_seq);
+
+    s_wr_pos = 0;
+    s_wr_slot = AD_Acq_ClaimSlot((uint32_t)s_wr_slot + 1u);
+    if (s_wr_slot < 0)
+        s_stats.drop_events++;
+    return 1;
+}
+
+/* 尝试持有槽 i 中序号为 seq 的块；持有失败返回 0 */
+static int AD_Acq_TryHold(uint32_t i, uint32_t seq, AD_AcqReader_t *rd, AD_AcqBlock_t *blk)
+{
+    ACQ_ADD(&s_slot[i].readers, 1u);
+    ACQ_FENCE();
+    if (ACQ_LOAD(&s_slot[i].seq) != seq)
+    {
+        ACQ_SUB(&s_slot[i].readers, 1u);
+        return 0;
+    }
+
+    if (rd->last_seq != 0u && seq > rd->last_seq + 1u)
+        rd->skipped += seq - rd->last_seq - 1u;
+    rd->last_seq = seq;
+
+    blk->seq = seq;
+    blk->tick_ms = s_slot[i].tick_ms;
+    blk->first_frame = s_slot[i].first_frame;
+    blk->sample_rate = s_slot[i].sample_rate;
+    blk->os_mode = s_slot[i].os_mode;
+    blk->profile = s_slot[i].profile;
+    blk->slot = i;
+    blk->data = (const int16_t (*)[AD_ACQ_POINTS])s_acq_data[i];
+    return 1;
+}
+
+int AD_Acq_AcquireLatest(AD_AcqReader_t *rd, AD_AcqBlock_t *blk)
+{
+    if (!rd || !blk)
+        return 0;
+    for (int retry = 0; retry < 3; retry++)
+    {
+        uint32_t i = ACQ_LOAD(&s_pub_slot);
+        uint32_t seq = ACQ_LOAD(&s_slot[i].seq);
+        if (seq == 0u || seq <= rd->last_seq)
+            return 0;
+        if (AD_Acq_TryHold(i, seq, rd, blk))
+            return 1;
+    }
+    return 0;
+}
+
+int AD_Acq_AcquireNext(AD_AcqReader_t *rd, AD_AcqBlock_t *blk)
+{
+    if (!rd || !blk)
+        return 0;
+    for (int retry = 0; retry < 3; retry++)
+    {
+        uint32_t best_i = 0, best_seq = 0;
+        for (uint32_t i = 0; i < AD_ACQ_RING_SLOTS; i++)
+        {
+            uint32_t seq = ACQ_LOAD(&s_slot[i].seq);
+            if (seq > rd->last_seq && (best_seq == 0u || seq < best_seq))
+            {
+                best_seq = seq;
+                best_i = i;
+            }
+        }
+        if (best_seq == 0u)
+            return 0;
+        if (AD_Acq_TryHold(best_i, best_seq, rd, blk))
+            return 1;
+    }
+    return 0;
+}
+
+void AD_Acq_Release(const AD_AcqBlock_t *blk)
+{
+    if (!blk || blk->slot >= AD_ACQ_RING_SLOTS)
+        return;
+    ACQ_SUB(&s_slot[blk->slot].readers, 1u);
+}
+
+void AD_Acq_GetStats(AD_AcqStats_t *st)
+{
+    if (!st)
+        return;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    st->blocks = s_stats.blocks;
+    st->frames = s_stats.frames;
+    st->dropped_frames = s_stats.dropped_frames;
+    st->drop_events = s_stats.drop_events;
+    __set_PRIMASK(primask);
+}
+
+void AD_Acq_BlockToVolts(const AD_AcqBlock_t *blk, uint32_t ch, float *dst)
+{
+    if (!blk || !dst || ch >= AD_ACQ_CHANNELS)
+        return;
+    AD7606_Cal_ApplyF(s_phys[ch], blk->data[ch], dst, AD_ACQ_POINTS);
+}
+
+void AD_Acq_BlockToQ15(const AD_AcqBlock_t *blk, uint32_t ch, int16_t *dst)
+{
+    if (!blk || !dst || ch >= AD_ACQ_CHANNELS)
+        return;
+    AD7606_Cal_ApplyQ15(s_phys[ch], blk->data[ch], dst, AD_ACQ_POINTS);
+}
+
+/* 零点学习：输入短接/无负载时调用，连续取 blocks 个新块求各通道原始码均值，写入标定表 */
+int AD_Acq_LearnZero(uint32_t ch_mask, uint32_t blocks, uint32_t timeout_ms)
+{
+    AD_AcqReader_t rd = {0, 0};
+    AD_AcqBlock_t blk;
+    int64_t sum[AD_ACQ_CHANNELS] = {0};
+    float offset[AD7606_CAL_CHANNELS] = {0};
+    uint32_t got = 0;
+    uint32_t t0 = HAL_GetTick();
+
+    if (blocks == 0u)
+        blocks = 1u;
+    ch_mask &= AD_ACQ_CH_MASK;
+    if (ch_mask == 0u)
+        return 0;
+
+    /* 跳过调用前已发布的块，只用之后采到的数据 */
+    rd.last_seq = s_seq;
+
+    while (got < blocks)
+    {
+        if ((HAL_GetTick() - t0) >= timeout_ms)
+            return 0;
+        if (!AD_Acq_AcquireNext(&rd, &blk))
+        {
+            osDelay(5);
+            continue;
+        }
+        for (uint32_t ch = 0; ch < AD_ACQ_CHANNELS; ch++)
+        {
+            if ((ch_mask & (1u << s_phys[ch])) == 0u)
+                continue;
+            const int16_t *p = blk.data[ch];
+            int32_t acc = 0;
+            for (uint32_t i = 0; i < AD_ACQ_POINTS; i++)
+                acc += p[i];
+            sum[ch] += acc;
+        }
+        AD_Acq_Release(&blk);
+        got++;
+    }
+
+    for (uint32_t ch = 0; ch < AD_ACQ_CHANNELS; ch++)
+    {
+        offset[s_phys[ch]] = (float)((double)sum[ch] / (double)(got * AD_ACQ_POINTS));
+    }
+    return AD7606_Cal_SetOffsets(ch_mask, offset) ? 1 : 0;
+}
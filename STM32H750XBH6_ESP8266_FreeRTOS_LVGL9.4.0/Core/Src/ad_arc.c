@@ -0,0 +1,389 @@
+#include "ad_arc.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * 处理顺序（每个 AD_ARC_CHUNK 段，且不跨判定窗边界）：
+ *   arm_biquad_cascade_df2T_f32 -> s_y；arm_power_f32(s_y) 累加窗能量；
+ *   |y| 按包络段（env_len 点）求平均得包络点，记峰值与和（段内求和没有递推依赖，编译器可展开）。
+ * 判定窗长取包络段的整数倍，窗满时出结论并把窗累加量清零；滤波器状态与包络段跨块连续，只在不连续时清零，
+ * 清零后先丢 AD_ARC_SETTLE_WINDOWS 个窗（高通对直流阶跃的暂态）再学习/判定。
+ * 采样率变化（含首次）时重新设计系数、清基线、重新学习；配置变化同样处理。
+ */
+
+static AD_ArcConfig_t s_cfg;
+/* 请求区：与 s_cfg_req_seq 一起只在 AD_Arc_Lock 临界区内读写，检测侧在 AD_Arc_BeginBlock 里整表取用 */
+static AD_ArcConfig_t s_cfg_req;
+static uint32_t s_cfg_req_seq = 0;
+static uint32_t s_cfg_seq = 0;
+
+static arm_biquad_cascade_df2T_instance_f32 s_iir;
+static float s_coef[5u * AD_ARC_SECTIONS];
+static float s_state[2u * AD_ARC_SECTIONS];
+static float s_y[AD_ARC_CHUNK];
+
+static uint8_t s_ready = 0;      /* 当前采样率下频段可用 */
+static uint8_t s_settle = 0;     /* 滤波器清零后待丢弃的窗数 */
+static uint32_t s_env_len = 1;   /* 包络段点数 */
+static float s_a_base = 0.0f;
+static float s_env_acc = 0.0f;   /* 当前包络段 Σ|y| */
+static uint32_t s_env_n = 0;
+static uint32_t s_win_n = 0;
+static float s_win_e = 0.0f;
+static float s_env_peak = 0.0f;
+static float s_env_sum = 0.0f;
+static float s_base_ms = 0.0f;   /* 基线均方值 */
+static uint32_t s_hist = 0;      /* 热窗历史，bit0 = 最近一窗 */
+
+static AD_ArcStatus_t s_status;
+
+void AD_Arc_DefaultConfig(AD_ArcConfig_t *cfg)
+{
+    cfg->enable = 1u;
+    cfg->phys = 2u;
+    cfg->f_lo_hz = 2000.0f;
+    cfg->f_hi_hz = 8000.0f;
+    cfg->window_ms = 10.0f;
+    cfg->env_ms = 1.0f;
+    cfg->ratio = 4.0f;
+    cfg->floor = 0.005f;
+    cfg->crest_min = 1.3f;
+    cfg->hist_n = 16u;
+    cfg->hot_n = 8u;
+    cfg->clear_n = 2u;
+    cfg->learn_windows = 100u;
+    cfg->baseline_tau_s = 10.0f;
+}
+
+bool AD_Arc_SetConfig(const AD_ArcConfig_t *cfg)
+{
+    if (!cfg || cfg->phys > 7u || !(cfg->f_lo_hz > 0.0f) || !(cfg->f_hi_hz > cfg->f_lo_hz) ||
+        !(cfg->window_ms > 0.0f) || !(cfg->env_ms > 0.0f) || !(cfg->env_ms <= cfg->window_ms) || !(cfg->ratio > 1.0f) || !(cfg->floor >= 0.0f) ||
+        !(cfg->crest_min >= 0.0f) || cfg->hist_n == 0u || cfg->hist_n > AD_ARC_HIST_MAX || cfg->hot_n == 0u ||
+        cfg->hot_n > cfg->hist_n || cfg->clear_n >= cfg->hot_n || !(cfg->baseline_tau_s > 0.0f))
+        return false;
+    uint32_t key = AD_Arc_Lock();
+    s_cfg_req = *cfg;
+    s_cfg_req_seq++; /* 检测侧看到序号变化才拷贝 */
+    AD_Arc_Unlock(key);
+    return true;
+}
+
+void AD_Arc_GetConfig(AD_ArcConfig_t *cfg)
+{
+    if (!cfg)
+        return;
+    uint32_t key = AD_Arc_Lock();
+    *cfg = s_cfg_req;
+    AD_Arc_Unlock(key);
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD_Arc_BeginBlock
+* 功能说明: 块开头取用已提交的新配置
+* 形    参: cfg - 输出本块所用的配置（可为 NULL）
+* 返 回 值: 无
+* 说    明: 仅在检测任务中调用，每块一次，先于该块的 AD_Arc_Process；临界区内只做整表拷贝，
+*           配置变了则下一次 AD_Arc_Process 重新设计滤波器并重学基线
+*********************************************************************************************************
+*/
+void AD_Arc_BeginBlock(AD_ArcConfig_t *cfg)
+{
+    static AD_ArcConfig_t req; /* 只在检测任务里用，放静态区省栈 */
+    bool fresh = false;
+
+    uint32_t key = AD_Arc_Lock();
+    if (s_cfg_req_seq != s_cfg_seq)
+    {
+        s_cfg_seq = s_cfg_req_seq;
+        req = s_cfg_req;
+        fresh = true;
+    }
+    AD_Arc_Unlock(key);
+
+    if (fresh)
+    {
+        s_cfg = req;
+        s_status.sample_rate = 0u; /* 强制重新设计 */
+        s_status.arc = 0u;
+        s_status.hot = 0u;
+    }
+    if (cfg)
+        *cfg = s_cfg;
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD_Arc_ParseKV
+* 功能说明: 解析一项电弧检测配置
+* 形    参: cfg - 被修改的配置；key/val - 已去掉首尾空白
+* 返 回 值: true=已识别
+* 说    明: ENABLE=0|1，CH=物理通道，F_LO_HZ，F_HI_HZ，WINDOW_MS，ENV_MS，RATIO，FLOOR，CREST_MIN，
+*           HIST_N，HOT_N，CLEAR_N，LEARN_WINDOWS，BASELINE_TAU_S；取值合法性由 AD_Arc_SetConfig 检查
+*********************************************************************************************************
+*/
+bool AD_Arc_ParseKV(AD_ArcConfig_t *cfg, const char *key, const char *val)
+{
+    if (strcmp(key, "ENABLE") == 0)
+        cfg->enable = (uint8_t)(strtoul(val, NULL, 0) != 0u);
+    else if (strcmp(key, "CH") == 0)
+        cfg->phys = (uint8_t)strtoul(val, NULL, 0);
+    else if (strcmp(key, "F_LO_HZ") == 0)
+        cfg->f_lo_hz = strtof(val, NULL);
+    else if (strcmp(key, "F_HI_HZ") == 0)
+        cfg->f_hi_hz = strtof(val, NULL);
+    else if (strcmp(key, "WINDOW_MS") == 0)
+        cfg->window_ms = strtof(val, NULL);
+    else if (strcmp(key, "ENV_MS") == 0)
+        cfg->env_ms = strtof(val, NULL);
+    else if (strcmp(key, "RATIO") == 0)
+        cfg->ratio = strtof(val, NULL);
+    else if (strcmp(key, "FLOOR") == 0)
+        cfg->floor = strtof(val, NULL);
+    else if (strcmp(key, "CREST_MIN") == 0)
+        cfg->crest_min = strtof(val, NULL);
+    else if (strcmp(key, "HIST_N") == 0)
+        cfg->hist_n = (uint8_t)strtoul(val, NULL, 0);
+    else if (strcmp(key, "HOT_N") == 0)
+        cfg->hot_n = (uint8_t)strtoul(val, NULL, 0);
+    else if (strcmp(key, "CLEAR_N") == 0)
+        cfg->clear_n = (uint8_t)strtoul(val, NULL, 0);
+    else if (strcmp(key, "LEARN_WINDOWS") == 0)
+        cfg->learn_windows = (uint16_t)strtoul(val, NULL, 0);
+    else if (strcmp(key, "BASELINE_TAU_S") == 0)
+        cfg->baseline_tau_s = strtof(val, NULL);
+    else
+        return false;
+    return true;
+}
+
+/* RBJ 二阶节（CMSIS 系数顺序 b0 b1 b2 -a1 -a2，已除 a0） */
+static void arc_section(float *c, float fc, float fs, float q, bool highpass)
+{
+    const float w0 = 2.0f * PI * fc / fs;
+    const float cw = cosf(w0);
+    const float alpha = sinf(w0) / (2.0f * q);
+    const float a0 = 1.0f + alpha;
+    const float k = highpass ? (1.0f + cw) : (1.0f - cw);
+
+    c[0] = 0.5f * k / a0;
+    c[1] = (highpass ? -k : k) / a0;
+    c[2] = 0.5f * k / a0;
+    c[3] = 2.0f * cw / a0;
+    c[4] = -(1.0f - alpha) / a0;
+}
+
+static void arc_clear_window(void)
+{
+    s_win_n = 0;
+    s_win_e = 0.0f;
+    s_env_peak = 0.0f;
+    s_env_sum = 0.0f;
+}
+
+static void arc_clear_filter(void)
+{
+    memset(s_state, 0, sizeof(s_state));
+    s_env_acc = 0.0f;
+    s_env_n = 0;
+    s_settle = AD_ARC_SETTLE_WINDOWS;
+    arc_clear_window();
+}
+
+/* 按采样率设计带通（各半 Butterworth 高通/低通，阶数 AD_ARC_SECTIONS），并清基线重新学习 */
+static void arc_design(uint32_t fs)
+{
+    const uint32_t half = AD_ARC_SECTIONS / 2u;
+    float f_hi = s_cfg.f_hi_hz;
+    const float f_max = 0.45f * (float)fs;
+
+    if (f_hi > f_max)
+        f_hi = f_max;
+    s_ready = (fs > 0u && s_cfg.f_lo_hz < f_hi) ? 1u : 0u;
+    for (uint32_t i = 0; s_ready && i < half; i++)
+    {
+        /* 2·half 阶 Butterworth 的各二阶节 Q */
+        float q = 1.0f / (2.0f * cosf(PI * (float)(2u * i + 1u) / (float)(4u * half)));
+        arc_section(&s_coef[5u * i], s_cfg.f_lo_hz, (float)fs, q, true);
+        arc_section(&s_coef[5u * (half + i)], f_hi, (float)fs, q, false);
+    }
+    arm_biquad_cascade_df2T_init_f32(&s_iir, (uint8_t)AD_ARC_SECTIONS, s_coef, s_state);
+    arc_clear_filter();
+
+    uint32_t env = (uint32_t)(s_cfg.env_ms * 1e-3f * (float)fs + 0.5f);
+    s_env_len = (env > 0u) ? env : 1u;
+    uint32_t segs = (uint32_t)(s_cfg.window_ms / s_cfg.env_ms + 0.5f);
+    uint32_t win = s_env_len * ((segs > 0u) ? segs : 1u);
+    float win_s = (fs > 0u) ? (float)win / (float)fs : 0.0f;
+    float a_base = win_s / s_cfg.baseline_tau_s;
+    s_a_base = (a_base < 1.0f) ? a_base : 1.0f;
+    s_base_ms = 0.0f;
+    s_hist = 0u;
+
+    s_status.sample_rate = fs;
+    s_status.f_lo_hz = s_cfg.f_lo_hz;
+    s_status.f_hi_hz = f_hi;
+    s_status.window_len = (s_ready && win > 0u) ? win : 0u;
+    s_status.base_rms = 0.0f;
+    s_status.hot = 0u;
+    s_status.arc = 0u;
+    s_status.learn_left = s_cfg.learn_windows;
+}
+
+void AD_Arc_Init(void)
+{
+    AD_ArcConfig_t cfg;
+
+    AD_Arc_DefaultConfig(&cfg);
+    memset(&s_status, 0, sizeof(s_status));
+    s_cfg = cfg;
+    s_cfg_req = cfg;
+    s_cfg_seq = s_cfg_req_seq;
+    s_ready = 0u;
+    arc_clear_filter();
+}
+
+/* 热窗计数（最近 hist_n 窗） */
+static uint8_t arc_hot_count(void)
+{
+    uint32_t m = (s_cfg.hist_n >= 32u) ? 0xFFFFFFFFu : ((1u << s_cfg.hist_n) - 1u);
+    uint32_t v = s_hist & m;
+    uint8_t c = 0;
+    while (v)
+    {
+        v &= v - 1u;
+        c++;
+    }
+    return c;
+}
+
+/* 一个判定窗结束：出结论并学习基线，返回 1 = 本窗新置位 */
+static uint32_t arc_window_done(void)
+{
+    const float n = (float)s_win_n;
+    const float ms = s_win_e / n;
+    const float env_mean = s_env_sum / (n / (float)s_env_len);
+    const float crest = (env_mean > 0.0f) ? s_env_peak / env_mean : 0.0f;
+    uint32_t raised = 0;
+
+    s_status.windows++;
+    s_status.rms = sqrtf(ms);
+    s_status.crest = crest;
+
+    if (s_settle > 0u)
+        s_settle--;
+    else if (s_status.learn_left > 0u)
+    {
+        /* 学习期：窗均方值的算术平均作为初始基线 */
+        uint32_t k = (uint32_t)s_cfg.learn_windows - s_status.learn_left + 1u;
+        s_base_ms += (ms - s_base_ms) / (float)k;
+        s_status.learn_left--;
+    }
+    else
+    {
+        const float ratio2 = s_cfg.ratio * s_cfg.ratio;
+        const float thr = (ratio2 * s_base_ms > s_cfg.floor * s_cfg.floor) ? ratio2 * s_base_ms : s_cfg.floor * s_cfg.floor;
+        const bool hot = (ms >= thr) && (crest >= s_cfg.crest_min);
+
+        s_hist = (s_hist << 1) | (hot ? 1u : 0u);
+        s_status.hot = arc_hot_count();
+        if (!s_status.arc && s_status.hot >= s_cfg.hot_n)
+        {
+            s_status.arc = 1u;
+            s_status.detections++;
+            raised = 1u;
+        }
+        else if (s_status.arc && s_status.hot <= s_cfg.clear_n)
+            s_status.arc = 0u;
+        /* 基线只学非热窗，且电弧期间冻结 */
+        if (!hot && !s_status.arc)
+            s_base_ms += (ms - s_base_ms) * s_a_base;
+    }
+    s_status.base_rms = sqrtf(s_base_ms);
+    arc_clear_window();
+    return raised;
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD_Arc_Process
+* 功能说明: 对检测通道的一段连续数据做带通、包络与窗能量积分，窗满即判定
+* 形    参: x   - 工程量
+*           n   - 点数
+*           fs  - 采样率
+*           gap - 与上一段不连续
+* 返 回 值: 本次新置位的电弧次数
+* 说    明: 仅在检测任务中调用，用 AD_Arc_BeginBlock 取用的配置；采样率或配置变化时重新设计并重学基线，
+*           频段在当前采样率下不可用时直接返回
+*********************************************************************************************************
+*/
+uint32_t AD_Arc_Process(const float *x, uint32_t n, uint32_t fs, bool gap)
+{
+    uint32_t raised = 0;
+
+    if (!s_cfg.enable)
+        return 0;
+    if (fs != s_status.sample_rate)
+    {
+        arc_design(fs);
+        if (s_status.resets || s_status.windows)
+            s_status.resets++;
+    }
+    else if (gap)
+    {
+        arc_clear_filter();
+        s_status.resets++;
+    }
+    if (!s_ready)
+        return 0;
+
+    while (n > 0u)
+    {
+        uint32_t len = s_status.window_len - s_win_n;
+        if (len > AD_ARC_CHUNK)
+            len = AD_ARC_CHUNK;
+        if (len > n)
+            len = n;
+
+        float e;
+        arm_biquad_cascade_df2T_f32(&s_iir, x, s_y, len);
+        arm_power_f32(s_y, len, &e);
+        s_win_e += e;
+
+        for (uint32_t i = 0; i < len;)
+        {
+            uint32_t m = s_env_len - s_env_n;
+            if (m > len - i)
+                m = len - i;
+            float acc = 0.0f;
+            for (uint32_t j = 0; j < m; j++)
+                acc += fabsf(s_y[i + j]);
+            s_env_acc += acc;
+            s_env_n += m;
+            i += m;
+            if (s_env_n == s_env_len)
+            {
+                float env = s_env_acc / (float)s_env_len;
+                s_env_peak = (env > s_env_peak) ? env : s_env_peak;
+                s_env_sum += env;
+                s_env_acc = 0.0f;
+                s_env_n = 0;
+            }
+        }
+
+        s_win_n += len;
+        x += len;
+        n -= len;
+        if (s_win_n >= s_status.window_len)
+            raised += arc_window_done();
+    }
+    return raised;
+}
+
+void AD_Arc_GetStatus(AD_ArcStatus_t *st)
+{
+    if (st)
+        *st = s_status;
+}
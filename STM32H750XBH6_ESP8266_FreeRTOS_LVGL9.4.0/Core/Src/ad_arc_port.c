@@ -0,0 +1,122 @@
+#include "ad_arc_port.h"
+#include "main.h"
+#include "ad_trigger.h"
+#include "SD.h"
+#include "ff.h"
+#include <stdio.h>
+#include <string.h>
+
+static uint32_t s_next_frame = 0;
+static uint8_t s_primed = 0;
+static uint32_t s_cfg_blk = 0;   /* 已取用配置的块序号 */
+static AD_ArcConfig_t s_cfg;     /* 本块所用的配置（AD_Arc_BeginBlock 输出） */
+static AD_ArcPortStats_t s_stats;
+
+/* 配置交接临界区：提交配置的界面/控制台任务可能在整表拷贝中途被 Decim 任务抢占，关中断期间只做这一次拷贝 */
+uint32_t AD_Arc_Lock(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    return primask;
+}
+
+void AD_Arc_Unlock(uint32_t key)
+{
+    __set_PRIMASK(key);
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD_Arc_OnBlock
+* 功能说明: 把检测通道的一块工程量送入电弧检测，新置位时请求录波
+* 形    参: blk - 当前采样块（取首帧号与采样率）
+*           ch  - 逻辑通道
+*           x   - 该通道的工程量
+* 返 回 值: 无
+* 说    明: 每块第一次调用时取用新配置，同一块的各通道、判定与日志都用这一张表；非检测通道直接返回；
+*           首帧号与上一块不衔接时按不连续处理（只清滤波器，基线保留）
+*********************************************************************************************************
+*/
+void AD_Arc_OnBlock(const AD_AcqBlock_t *blk, uint32_t ch, const float *x)
+{
+    if (blk->seq != s_cfg_blk)
+    {
+        s_cfg_blk = blk->seq;
+        AD_Arc_BeginBlock(&s_cfg);
+    }
+    const AD_ArcConfig_t *cfg = &s_cfg;
+    if (!cfg->enable || AD_Acq_PhysChannel(ch) != cfg->phys)
+        return;
+
+    bool gap = s_primed && blk->first_frame != s_next_frame;
+    s_primed = 1;
+    s_next_frame = blk->first_frame + AD_ACQ_POINTS;
+
+    uint32_t c0 = DWT->CYCCNT;
+    uint32_t raised = AD_Arc_Process(x, AD_ACQ_POINTS, blk->sample_rate, gap);
+    s_stats.cyc = DWT->CYCCNT - c0;
+    if (s_stats.cyc > s_stats.cyc_max)
+        s_stats.cyc_max = s_stats.cyc;
+    s_stats.blocks++;
+
+    if (raised)
+    {
+        AD_ArcStatus_t st;
+        AD_Arc_GetStatus(&st);
+        printf("[ARC] CH%u arc detected: band rms %.4f (base %.4f) crest %.2f hot %u/%u\r\n", (unsigned)cfg->phys,
+               (double)st.rms, (double)st.base_rms, (double)st.crest, (unsigned)st.hot, (unsigned)cfg->hist_n);
+        AD_Trig_Force(cfg->phys);
+        s_stats.captures++;
+    }
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD_Arc_LoadFromSD
+* 功能说明: 从 SD 读取电弧检测配置并生效
+* 形    参: 无
+* 返 回 值: true=已加载
+* 说    明: 文件里没写的项取编译期默认值（不是当前值），删掉一行即恢复默认；未知键打印后忽略
+*********************************************************************************************************
+*/
+bool AD_Arc_LoadFromSD(void)
+{
+    extern volatile uint8_t g_qspi_sd_sync_in_progress;
+    AD_ArcConfig_t cfg;
+    FIL fil;
+    char line[96];
+
+    if (g_qspi_sd_sync_in_progress || SD_Init() != FR_OK)
+        return false;
+    if (f_open(&fil, AD_ARC_CFG_FILE, FA_READ) != FR_OK)
+        return false;
+
+    AD_Arc_DefaultConfig(&cfg);
+    while (f_gets(line, sizeof(line), &fil))
+    {
+        size_t n = strlen(line);
+        while (n > 0 && (line[n - 1] == '\r' || line[n - 1] == '\n' || line[n - 1] == ' ' || line[n - 1] == '\t'))
+            line[--n] = '\0';
+        char *val = strchr(line, '=');
+        if (line[0] == '#' || !val)
+            continue;
+        *val++ = '\0';
+        if (!AD_Arc_ParseKV(&cfg, line, val))
+            printf("[ARC] %s: unknown key %s\r\n", AD_ARC_CFG_FILE, line);
+    }
+    (void)f_close(&fil);
+
+    if (!AD_Arc_SetConfig(&cfg))
+    {
+        printf("[ARC] %s: invalid config, ignored\r\n", AD_ARC_CFG_FILE);
+        return false;
+    }
+    printf("[ARC] loaded %s\r\n", AD_ARC_CFG_FILE);
+    return true;
+}
+
+void AD_Arc_GetPortStats(AD_ArcPortStats_t *st)
+{
+    if (st)
+        *st = s_stats;
+}
@@ -0,0 +1,234 @@
+#include "ad_class.h"
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+
+/* SVM 两类即类别 0/1（文件头 code[0]/code[1]），CMSIS 按决策值符号取 classes[0/1] */
+static const int32_t s_svm_classes[2] = {0, 1};
+
+const char *AD_Class_KindName(uint8_t kind)
+{
+    if (kind == AD_CLASS_GNB)
+        return "gnb";
+    if (kind == AD_CLASS_SVM_RBF)
+        return "svm_rbf";
+    return "none";
+}
+
+/* 单边幅值谱在 k-1..k+1 内的最大值（频率不落在 bin 中心、采样率微调时都能取到峰值） */
+static float cls_harm(const float *spec, uint32_t bins, float hz, uint32_t sample_rate)
+{
+    if (sample_rate == 0u || bins < 4u)
+        return 0.0f;
+    float kf = hz * (float)(2u * bins) / (float)sample_rate;
+    if (kf < 1.0f || kf > (float)(bins - 2u))
+        return 0.0f;
+    uint32_t k = (uint32_t)(kf + 0.5f);
+    float a = spec[k - 1u];
+    if (spec[k] > a)
+        a = spec[k];
+    if (spec[k + 1u] > a)
+        a = spec[k + 1u];
+    return a;
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD_Class_Features
+* 功能说明: 由一块的统计量与幅值谱组成特征向量
+* 形    参: st          - 各逻辑通道统计量（nch 个）
+*           spec        - 各逻辑通道单边幅值谱（nch 路，每路 bins 点）
+*           nch         - 通道数
+*           bins        - 谱点数（= 块点数 / 2）
+*           sample_rate - 采样率
+*           x           - 输出，nch × AD_CLASS_FEATS_PER_CH 个
+* 返 回 值: 维数
+* 说    明: 板上与主机比对工具共用，保证两边的特征逐位一致
+*********************************************************************************************************
+*/
+uint32_t AD_Class_Features(const AD_Stats_t *st, const float *const *spec, uint32_t nch, uint32_t bins,
+                           uint32_t sample_rate, float *x)
+{
+    for (uint32_t ch = 0; ch < nch; ch++)
+    {
+        float *f = &x[ch * AD_CLASS_FEATS_PER_CH];
+        f[AD_CLASS_F_MEAN] = st[ch].mean;
+        f[AD_CLASS_F_STD] = st[ch].std;
+        f[AD_CLASS_F_CREST] = st[ch].crest;
+        f[AD_CLASS_F_SKEW] = st[ch].skew;
+        f[AD_CLASS_F_KURT] = st[ch].kurt;
+        for (uint32_t h = 0; h < 3u; h++)
+            f[AD_CLASS_F_H1 + h] = cls_harm(spec[ch], bins, AD_CLASS_FUND_HZ * (float)(h + 1u), sample_rate);
+    }
+    return nch * AD_CLASS_FEATS_PER_CH;
+}
+
+/* 与 GUI 资源头同样的 ×31 滚动和，主机脚本按同一算法生成 */
+uint32_t AD_Class_Checksum(const AD_ClassFileHeader_t *h, const float *payload)
+{
+    const uint32_t *w = (const uint32_t *)h;
+    uint32_t sum = 0;
+    for (uint32_t i = 0; i < offsetof(AD_ClassFileHeader_t, checksum) / 4u; i++)
+        sum = (sum << 5) - sum + w[i];
+    w = (const uint32_t *)payload;
+    for (uint32_t i = 0; i < h->payload_bytes / 4u; i++)
+        sum = (sum << 5) - sum + w[i];
+    return sum;
+}
+
+static uint32_t cls_popcnt(uint32_t v)
+{
+    uint32_t n = 0;
+    for (; v != 0u; v &= v - 1u)
+        n++;
+    return n;
+}
+
+static bool cls_code_ok(const char *c)
+{
+    return c[0] == 'E' && c[1] >= '0' && c[1] <= '9' && c[2] >= '0' && c[2] <= '9' && c[3] == '\0';
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD_Class_Parse
+* 功能说明: 校验模型文件并建立 CMSIS 实例
+* 形    参: m   - 输出模型
+*           buf - 文件内容（4 字节对齐，解析后仍被模型引用）
+*           len - 文件字节数
+*           why - 失败原因（可为 NULL）
+* 返 回 值: true=成功
+* 说    明: 任何一项不符都不改动 m；负载里的参数不做数值检查（由校验和保证与训练输出一致）
+*********************************************************************************************************
+*/
+bool AD_Class_Parse(AD_ClassModel_t *m, const void *buf, uint32_t len, const char **why)
+{
+    const AD_ClassFileHeader_t *h = (const AD_ClassFileHeader_t *)buf;
+    const char *err = NULL;
+    uint32_t expect = 0;
+
+    if (!m || !buf || ((uintptr_t)buf & 3u) != 0u)
+        err = "bad buffer";
+    else if (len < sizeof(*h) || h->magic != AD_CLASS_MAGIC)
+        err = "bad magic";
+    else if (h->version != AD_CLASS_VERSION)
+        err = "unsupported version";
+    else if (h->dim == 0u || h->dim > AD_CLASS_DIM_MAX || h->dim != cls_popcnt(h->ch_mask & 0xFFu) * AD_CLASS_FEATS_PER_CH)
+        err = "dim/ch_mask mismatch";
+    else if (h->nclass < 2u || h->nclass > AD_CLASS_MAX_CLASSES)
+        err = "bad class count";
+    else if (h->kind == AD_CLASS_GNB)
+    {
+        expect = 2u * h->dim + 2u * h->nclass * h->dim + h->nclass;
+        if (!(h->param >= 0.0f))
+            err = "bad epsilon";
+    }
+    else if (h->kind == AD_CLASS_SVM_RBF)
+    {
+        expect = 2u * h->dim + h->nsv + h->nsv * h->dim;
+        if (h->nclass != 2u)
+            err = "svm needs 2 classes";
+        else if (h->nsv == 0u || h->nsv > (1u << 20))
+            err = "bad support vector count";
+        else if (!(h->param > 0.0f))
+            err = "bad gamma";
+    }
+    else
+        err = "unknown kind";
+
+    if (!err && (h->payload_bytes != expect * 4u || len < sizeof(*h) + h->payload_bytes))
+        err = "payload size mismatch";
+    if (!err)
+    {
+        for (uint32_t c = 0; c < h->nclass && !err; c++)
+        {
+            if (!cls_code_ok(h->code[c]))
+                err = "bad fault code";
+        }
+    }
+    const float32_t *p = (const float32_t *)(h + 1);
+    if (!err && AD_Class_Checksum(h, p) != h->checksum)
+        err = "checksum mismatch";
+    if (err)
+    {
+        if (why)
+            *why = err;
+        return false;
+    }
+
+    memset(m, 0, sizeof(*m));
+    m->kind = (uint8_t)h->kind;
+    m->nclass = (uint8_t)h->nclass;
+    m->dim = (uint16_t)h->dim;
+    m->nsv = h->nsv;
+    m->ch_mask = h->ch_mask;
+    memcpy(m->code, h->code, sizeof(m->code));
+    m->mu = p;
+    m->inv_sd = p + h->dim;
+    p += 2u * h->dim;
+    if (h->kind == AD_CLASS_GNB)
+    {
+        m->gnb.vectorDimension = h->dim;
+        m->gnb.numberOfClasses = h->nclass;
+        m->gnb.theta = p;
+        m->gnb.sigma = p + h->nclass * h->dim;
+        m->gnb.classPriors = p + 2u * h->nclass * h->dim;
+        m->gnb.epsilon = h->param;
+    }
+    else
+    {
+        arm_svm_rbf_init_f32(&m->svm, h->nsv, h->dim, h->intercept, p, p + h->nsv, s_svm_classes, h->param);
+    }
+    if (why)
+        *why = "ok";
+    return true;
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD_Class_Predict
+* 功能说明: 标准化特征向量并预测类别
+* 形    参: m     - 模型
+*           x     - 特征向量（m->dim 个）
+*           work  - 工作区（AD_CLASS_WORK_FLOATS 个 float）
+*           score - 输出置信度（可为 NULL，含义见 AD_ClassResult_t）
+* 返 回 值: 类别序号 0..nclass-1
+* 说    明: 非有限特征（NaN/Inf）按训练均值处理（标准化后为 0）
+*********************************************************************************************************
+*/
+int32_t AD_Class_Predict(const AD_ClassModel_t *m, const float *x, float *work, float *score)
+{
+    float32_t *z = work;
+    int32_t cls = 0;
+
+    arm_sub_f32(x, m->mu, z, m->dim);
+    arm_mult_f32(z, m->inv_sd, z, m->dim);
+    for (uint32_t i = 0; i < m->dim; i++)
+    {
+        if (!isfinite(z[i]))
+            z[i] = 0.0f;
+    }
+
+    if (m->kind == AD_CLASS_GNB)
+    {
+        float32_t *prob = &work[AD_CLASS_DIM_MAX];
+        cls = (int32_t)arm_gaussian_naive_bayes_predict_f32(&m->gnb, z, prob, prob + AD_CLASS_MAX_CLASSES);
+        if (score)
+        {
+            float32_t second = -INFINITY;
+            for (uint32_t c = 0; c < m->nclass; c++)
+            {
+                if ((int32_t)c != cls && prob[c] > second)
+                    second = prob[c];
+            }
+            *score = prob[cls] - second;
+        }
+    }
+    else
+    {
+        arm_svm_rbf_predict_f32(&m->svm, z, &cls);
+        if (score)
+            *score = NAN;
+    }
+    return cls;
+}
@@ -0,0 +1,205 @@
+#include "ad_class_port.h"
+#include "main.h"
+#include "SD.h"
+#include "ff.h"
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * 模型双缓冲（缓冲在 SDRAM，描述符在内部 RAM）：
+ * - DSP 任务只读 s_active 号缓冲；加载者只写另一个缓冲
+ * - 加载者先在临界区里置 s_loading，DSP 任务看到 s_loading 就不切换；
+ *   解析成功后在临界区里写待切换描述符、序号加 1、清 s_loading
+ * - DSP 任务每块开头（临界区内）发现序号变化且不在加载中，才拷贝描述符并切换缓冲
+ * 连续加载两次而 DSP 任务还没切换（例如采集停止）时，后一次直接覆盖前一次的待切换模型。
+ */
+
+#if (AD_PSD_STATE_SDRAM_ADDR + (AD_PSD_NFFT + AD_ACQ_CHANNELS * 2u * AD_PSD_NFFT) * 4u) > AD_CLASS_MODEL_SDRAM_ADDR
+#error "AD_CLASS model buffers overlap AD_PSD state"
+#endif
+
+#if (AD_CLASS_MODEL_SDRAM_ADDR + 2u * AD_CLASS_MODEL_MAX_BYTES) > 0xC1000000u
+#error "AD_CLASS model buffers exceed SDRAM"
+#endif
+
+static uint8_t *const s_buf[2] = {(uint8_t *)AD_CLASS_MODEL_SDRAM_ADDR,
+                                  (uint8_t *)(AD_CLASS_MODEL_SDRAM_ADDR + AD_CLASS_MODEL_MAX_BYTES)};
+
+/* DSP 任务使用 */
+static AD_ClassModel_t s_model;
+static uint8_t s_loaded = 0;
+static uint8_t s_active = 0;
+static uint32_t s_ack_seq = 0;
+static float s_work[AD_CLASS_WORK_FLOATS];
+static float s_x[AD_CLASS_DIM_MAX];
+
+/* 加载者写、DSP 任务读 */
+static AD_ClassModel_t s_pend;
+static volatile uint8_t s_pend_idx = 0;
+static volatile uint8_t s_loading = 0;
+static volatile uint32_t s_pend_seq = 0;
+static volatile uint32_t s_pend_bytes = 0;
+static const char *volatile s_pend_src = NULL;
+
+/* 状态（DSP 任务写，其他任务读，仅供显示） */
+static volatile AD_ClassStatus_t s_status;
+
+/* 读一个模型文件到 buf，返回字节数（0 = 失败） */
+static uint32_t class_read_file(const char *path, uint8_t *buf)
+{
+    FIL fil;
+    UINT br = 0;
+
+    if (f_open(&fil, path, FA_READ) != FR_OK)
+        return 0;
+    FSIZE_t size = f_size(&fil);
+    if (size < sizeof(AD_ClassFileHeader_t) || size > AD_CLASS_MODEL_MAX_BYTES ||
+        f_read(&fil, buf, (UINT)size, &br) != FR_OK || br != (UINT)size)
+    {
+        printf("[CLASS] %s: read failed (size=%lu)\r\n", path, (unsigned long)size);
+        br = 0;
+    }
+    (void)f_close(&fil);
+    return (uint32_t)br;
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD_Class_Load
+* 功能说明: 加载推理模型文件，解析成功后交给 DSP 任务在下一块切换
+* 形    参: 无
+* 返 回 值: true=已加载
+* 说    明: 先 SD（0:/config/ad_class.bin），再 QSPI（1:/config/ad_class.bin）；
+*           文件的通道掩码须与 AD_ACQ_CH_MASK 一致（特征向量按逻辑通道拼接）；失败时保留当前模型
+*********************************************************************************************************
+*/
+bool AD_Class_Load(void)
+{
+    extern volatile uint8_t g_qspi_sd_sync_in_progress;
+    AD_ClassModel_t m;
+    const char *src = AD_CLASS_MODEL_FILE_SD;
+    const char *why = NULL;
+    uint32_t len = 0;
+
+    if (g_qspi_sd_sync_in_progress)
+        return false;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (s_loading)
+    {
+        __set_PRIMASK(primask);
+        return false; /* 另一个任务正在加载 */
+    }
+    s_loading = 1;
+    uint8_t idx = (uint8_t)(s_active ^ 1u);
+    __set_PRIMASK(primask);
+
+    if (SD_Init() == FR_OK)
+        len = class_read_file(src, s_buf[idx]);
+    if (len == 0u)
+    {
+        src = AD_CLASS_MODEL_FILE_QSPI;
+        len = class_read_file(src, s_buf[idx]);
+    }
+
+    bool ok = (len != 0u) && AD_Class_Parse(&m, s_buf[idx], len, &why);
+    if (ok && m.ch_mask != AD_ACQ_CH_MASK)
+    {
+        why = "ch_mask differs from AD_ACQ_CH_MASK";
+        ok = false;
+    }
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    if (ok)
+    {
+        s_pend = m;
+        s_pend_idx = idx;
+        s_pend_bytes = len;
+        s_pend_src = src;
+        s_pend_seq++;
+    }
+    s_loading = 0;
+    __set_PRIMASK(primask);
+
+    if (len == 0u)
+        printf("[CLASS] no model file (%s / %s)\r\n", AD_CLASS_MODEL_FILE_SD, AD_CLASS_MODEL_FILE_QSPI);
+    else if (!ok)
+        printf("[CLASS] %s: %s, ignored\r\n", src, why);
+    else
+        printf("[CLASS] loaded %s: %s classes=%u dim=%u sv=%lu (%lu bytes)\r\n", src, AD_Class_KindName(m.kind),
+               (unsigned)m.nclass, (unsigned)m.dim, (unsigned long)m.nsv, (unsigned long)len);
+    return ok;
+}
+
+/* 有待切换的模型且不在加载中就切换（DSP 任务上下文） */
+static void class_adopt(void)
+{
+    if (s_pend_seq == s_ack_seq)
+        return;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (!s_loading)
+    {
+        s_model = s_pend;
+        s_active = s_pend_idx;
+        s_ack_seq = s_pend_seq;
+        s_loaded = 1;
+        s_status.bytes = s_pend_bytes;
+        s_status.src = s_pend_src;
+    }
+    __set_PRIMASK(primask);
+    if (s_ack_seq == s_pend_seq)
+    {
+        s_status.loaded = 1;
+        s_status.kind = s_model.kind;
+        s_status.nclass = s_model.nclass;
+        s_status.dim = s_model.dim;
+        s_status.nsv = s_model.nsv;
+        s_status.infers = 0;
+        memset((void *)s_status.count, 0, sizeof(s_status.count));
+        memcpy((void *)s_status.code, s_model.code, sizeof(s_status.code));
+    }
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD_Class_OnBlock
+* 功能说明: 对一块数据做一次故障分类推理
+* 形    参: r - 正在填写的结果快照（统计量与频谱已算好）
+* 返 回 值: 无
+* 说    明: 仅在 DSP 任务中调用；特征向量与主机比对工具用同一函数（AD_Class_Features）
+*********************************************************************************************************
+*/
+void AD_Class_OnBlock(AD_DspResult_t *r)
+{
+    AD_ClassResult_t *out = &r->cls;
+    const float *spec[AD_ACQ_CHANNELS];
+
+    class_adopt();
+    if (!s_loaded)
+    {
+        out->cls = -1;
+        out->code[0] = '\0';
+        out->score = 0.0f;
+        return;
+    }
+
+    for (uint32_t ch = 0; ch < AD_ACQ_CHANNELS; ch++)
+        spec[ch] = r->spec[ch];
+    (void)AD_Class_Features(r->stats, spec, AD_ACQ_CHANNELS, AD_DSP_BINS, r->sample_rate, s_x);
+    int32_t c = AD_Class_Predict(&s_model, s_x, s_work, &out->score);
+
+    out->cls = (int8_t)c;
+    memcpy(out->code, s_model.code[c], sizeof(out->code));
+    s_status.infers++;
+    s_status.count[c]++;
+    s_status.last = *out;
+}
+
+void AD_Class_GetStatus(AD_ClassStatus_t *st)
+{
+    if (st)
+        memcpy(st, (const void *)&s_status, sizeof(*st));
+}
@@ -0,0 +1,360 @@
+#include "ad_codec.h"
+#include <string.h>
+
+#define CODEC_K_MAX   23u /* Rice 余数位数上限：q + 1 + k ≤ 24 时一次写出 */
+#define CODEC_FIXED   0x80u
+
+typedef struct
+{
+    uint8_t *p;
+    uint32_t acc;
+    uint32_t cnt;
+} codec_wr_t;
+
+/* nb ≤ 24，写入前 cnt ≤ 7，acc 不会溢出 */
+static inline void wr_put(codec_wr_t *w, uint32_t v, uint32_t nb)
+{
+    w->acc = (w->acc << nb) | v;
+    w->cnt += nb;
+    while (w->cnt >= 8u)
+    {
+        w->cnt -= 8u;
+        *w->p++ = (uint8_t)(w->acc >> w->cnt);
+    }
+}
+
+static inline void wr_put32(codec_wr_t *w, uint32_t v, uint32_t nb)
+{
+    if (nb > 16u)
+    {
+        wr_put(w, v >> 16, nb - 16u);
+        wr_put(w, v & 0xFFFFu, 16u);
+    }
+    else if (nb > 0u)
+        wr_put(w, v, nb);
+}
+
+static inline void wr_flush(codec_wr_t *w)
+{
+    if (w->cnt > 0u)
+        *w->p++ = (uint8_t)(w->acc << (8u - w->cnt));
+    w->cnt = 0u;
+}
+
+typedef struct
+{
+    const uint8_t *buf;
+    uint32_t len;
+    uint32_t pos;   /* 下一个装入的字节 */
+    uint64_t acc;   /* 高位对齐 */
+    uint32_t cnt;
+    uint32_t used;  /* 已消耗的位数 */
+} codec_rd_t;
+
+static inline void rd_fill(codec_rd_t *r)
+{
+    while (r->cnt <= 56u)
+    {
+        uint64_t b = (r->pos < r->len) ? r->buf[r->pos] : 0u;
+        r->pos++;
+        r->acc |= b << (56u - r->cnt);
+        r->cnt += 8u;
+    }
+}
+
+/* nb 1..32 */
+static inline uint32_t rd_get(codec_rd_t *r, uint32_t nb)
+{
+    rd_fill(r);
+    uint32_t v = (uint32_t)(r->acc >> (64u - nb));
+    r->acc <<= nb;
+    r->cnt -= nb;
+    r->used += nb;
+    return v;
+}
+
+static inline uint32_t zigzag(int32_t r)
+{
+    return ((uint32_t)r << 1) ^ (uint32_t)(r >> 31);
+}
+
+static inline int32_t unzigzag(uint32_t z)
+{
+    return (int32_t)((z >> 1) ^ (0u - (z & 1u)));
+}
+
+static inline uint32_t bit_len(uint32_t v)
+{
+    uint32_t n = 0;
+    while (v)
+    {
+        n++;
+        v >>= 1;
+    }
+    return n;
+}
+
+static inline int32_t predict(uint32_t order, int32_t h1, int32_t h2)
+{
+    return (order == 0u) ? 0 : (order == 1u) ? h1 : (int32_t)((uint32_t)h1 * 2u - (uint32_t)h2);
+}
+
+void AD_Codec_Reset(AD_Codec_t *c)
+{
+    memset(c->hist, 0, sizeof(c->hist));
+}
+
+void AD_Codec_Init(AD_Codec_t *c)
+{
+    memset(c, 0, sizeof(*c));
+}
+
+float AD_Codec_Ratio(const AD_CodecStats_t *st)
+{
+    return (st->bytes_out > 0u) ? (float)st->samples * 2.0f / (float)st->bytes_out : 0.0f;
+}
+
+/* 用 order 阶预测把 in[] 变成 z[]（历史取块前的 h1/h2） */
+static void codec_residual(AD_Codec_t *c, uint32_t n, uint32_t order, int32_t h1, int32_t h2)
+{
+    for (uint32_t i = 0; i < n; i++)
+    {
+        int32_t v = c->in[i];
+        c->z[i] = zigzag(v - predict(order, h1, h2));
+        h2 = h1;
+        h1 = v;
+    }
+}
+
+static uint32_t codec_rice_bits(const uint32_t *z, uint32_t n, uint32_t k)
+{
+    uint32_t bits = 0;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        uint32_t q = z[i] >> k;
+        bits += (q < AD_CODEC_QMAX) ? q + 1u + k : AD_CODEC_QMAX + 32u;
+    }
+    return bits;
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD_Codec_Encode
+* 功能说明: 无损编码一块整数样本
+* 形    参: c   - 编解码器（预测历史 + 工作区）
+*           ch  - 预测历史路号
+*           x   - 样本（可以就是 c->in）
+*           n   - 样本数，1..AD_CODEC_BLOCK
+*           out - 输出
+*           cap - 输出容量
+* 返 回 值: 写出的字节数，0 = 参数非法或 cap 不足（历史与统计不变）
+* 说    明: 第一趟同时算出 0/1/2 阶残差的 Σ|r| 与最大位宽；Rice 取 Σ|r| 最小的阶，
+*           k 由均值估计后在 k0−1..k0+1 里按实际比特数取最小；再与各阶定宽打包比较，取总比特数最小者
+*********************************************************************************************************
+*/
+uint32_t AD_Codec_Encode(AD_Codec_t *c, uint32_t ch, const int32_t *x, uint32_t n, uint8_t *out, uint32_t cap)
+{
+    if (!c || !x || !out || ch >= AD_CODEC_MAX_CH || n == 0u || n > AD_CODEC_BLOCK)
+        return 0u;
+
+    const int32_t h1_0 = c->hist[ch][0];
+    const int32_t h2_0 = c->hist[ch][1];
+    int32_t h1 = h1_0;
+    int32_t h2 = h2_0;
+    uint64_t sum[3] = {0u, 0u, 0u};
+    uint32_t orr[3] = {0u, 0u, 0u};
+
+    for (uint32_t i = 0; i < n; i++)
+    {
+        int32_t v = x[i];
+        if (v >= (int32_t)AD_CODEC_MAX_ABS)
+            v = (int32_t)AD_CODEC_MAX_ABS - 1;
+        else if (v <= -(int32_t)AD_CODEC_MAX_ABS)
+            v = 1 - (int32_t)AD_CODEC_MAX_ABS;
+        c->in[i] = v;
+
+        int32_t r1 = v - h1;
+        int32_t r2 = r1 - h1 + h2;
+        sum[0] += (uint32_t)((v < 0) ? -v : v);
+        sum[1] += (uint32_t)((r1 < 0) ? -r1 : r1);
+        sum[2] += (uint32_t)((r2 < 0) ? -r2 : r2);
+        orr[0] |= zigzag(v);
+        orr[1] |= zigzag(r1);
+        orr[2] |= zigzag(r2);
+        h2 = h1;
+        h1 = v;
+    }
+
+    /* Rice 候选：Σ|r| 最小的阶（并列取低阶） */
+    uint32_t order = 0u;
+    for (uint32_t o = 1; o < 3u; o++)
+    {
+        if (sum[o] < sum[order])
+            order = o;
+    }
+    codec_residual(c, n, order, h1_0, h2_0);
+
+    /* zigzag 均值 ≈ 2·mean|r|；k0 = floor(log2(均值)) */
+    uint64_t zsum = sum[order] * 2u;
+    uint32_t k0 = 0u;
+    while (k0 < CODEC_K_MAX && ((uint64_t)n << (k0 + 1u)) <= zsum)
+        k0++;
+    uint32_t best_k = k0;
+    uint32_t best_bits = codec_rice_bits(c->z, n, k0);
+    for (uint32_t k = (k0 > 0u) ? k0 - 1u : 0u; k <= k0 + 1u && k <= CODEC_K_MAX; k++)
+    {
+        if (k == k0)
+            continue;
+        uint32_t b = codec_rice_bits(c->z, n, k);
+        if (b < best_bits)
+        {
+            best_bits = b;
+            best_k = k;
+        }
+    }
+
+    /* 定宽候选 */
+    uint32_t fixed_order = 0u;
+    uint32_t fixed_w = bit_len(orr[0]);
+    for (uint32_t o = 1; o < 3u; o++)
+    {
+        uint32_t wb = bit_len(orr[o]);
+        if (wb < fixed_w)
+        {
+            fixed_w = wb;
+            fixed_order = o;
+        }
+    }
+    uint8_t fixed = (fixed_w * n <= best_bits) ? 1u : 0u;
+    uint32_t bits = fixed ? fixed_w * n : best_bits;
+    uint32_t bytes = 1u + (bits + 7u) / 8u;
+    if (bytes > cap)
+        return 0u;
+
+    codec_wr_t w = {out, 0u, 0u};
+    uint32_t escapes = 0u;
+    if (fixed)
+    {
+        if (fixed_order != order)
+            codec_residual(c, n, fixed_order, h1_0, h2_0);
+        order = fixed_order;
+        *w.p++ = (uint8_t)(CODEC_FIXED | (fixed_w << 2) | order);
+        for (uint32_t i = 0; i < n; i++)
+            wr_put32(&w, c->z[i], fixed_w);
+    }
+    else
+    {
+        const uint32_t k = best_k;
+        const uint32_t mask = (1u << k) - 1u;
+        *w.p++ = (uint8_t)((k << 2) | order);
+        for (uint32_t i = 0; i < n; i++)
+        {
+            uint32_t z = c->z[i];
+            uint32_t q = z >> k;
+            if (q < AD_CODEC_QMAX)
+            {
+                /* q 个 1 + 0 + 低 k 位 */
+                uint32_t unary = ((1u << q) - 1u) << 1;
+                if (q + 1u + k <= 24u)
+                    wr_put(&w, (unary << k) | (z & mask), q + 1u + k);
+                else
+                {
+                    wr_put(&w, unary, q + 1u);
+                    wr_put(&w, z & mask, k);
+                }
+            }
+            else
+            {
+                wr_put(&w, (1u << AD_CODEC_QMAX) - 1u, AD_CODEC_QMAX);
+                wr_put32(&w, z, 32u);
+                escapes++;
+            }
+        }
+    }
+    wr_flush(&w);
+
+    c->hist[ch][0] = c->in[n - 1u];
+    c->hist[ch][1] = (n >= 2u) ? c->in[n - 2u] : h1_0;
+
+    AD_CodecStats_t *st = &c->st;
+    float ratio = (float)(2u * n) / (float)bytes;
+    if (st->blocks == 0u || ratio < st->min_ratio)
+        st->min_ratio = ratio;
+    if (st->blocks == 0u || ratio > st->max_ratio)
+        st->max_ratio = ratio;
+    st->last_ratio = ratio;
+    st->blocks++;
+    st->samples += n;
+    st->bytes_out += bytes;
+    st->fixed_blocks += fixed;
+    st->escapes += escapes;
+    st->order_hist[order]++;
+    return bytes;
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD_Codec_Decode
+* 功能说明: 解码 AD_Codec_Encode 输出的一块
+* 形    参: c   - 编解码器（只用预测历史）
+*           ch  - 预测历史路号（与编码时相同）
+*           in  - 码流
+*           len - 码流可用字节数
+*           x   - 输出样本
+*           n   - 样本数（与编码时相同）
+* 返 回 值: 消耗的字节数，0 = 块头非法或数据不足（此时 x 内容无效、历史不变）
+*********************************************************************************************************
+*/
+uint32_t AD_Codec_Decode(AD_Codec_t *c, uint32_t ch, const uint8_t *in, uint32_t len, int32_t *x, uint32_t n)
+{
+    if (!c || !in || !x || ch >= AD_CODEC_MAX_CH || len == 0u || n == 0u || n > AD_CODEC_BLOCK)
+        return 0u;
+
+    const uint8_t hdr = in[0];
+    const uint32_t order = hdr & 3u;
+    const uint32_t k = (hdr >> 2) & 0x1Fu;
+    const uint8_t fixed = (hdr & CODEC_FIXED) ? 1u : 0u;
+    if (order > 2u || (!fixed && k > CODEC_K_MAX))
+        return 0u;
+
+    codec_rd_t r = {in + 1, len - 1u, 0u, 0u, 0u, 0u};
+    int32_t h1 = c->hist[ch][0];
+    int32_t h2 = c->hist[ch][1];
+    for (uint32_t i = 0; i < n; i++)
+    {
+        uint32_t z;
+        if (fixed)
+            z = (k > 0u) ? rd_get(&r, k) : 0u;
+        else
+        {
+            uint32_t q = 0u;
+            rd_fill(&r);
+            while (q < AD_CODEC_QMAX && (r.acc >> 63))
+            {
+                r.acc <<= 1;
+                q++;
+            }
+            r.cnt -= q;
+            r.used += q;
+            if (q < AD_CODEC_QMAX)
+            {
+                r.acc <<= 1; /* 结束位 0 */
+                r.cnt--;
+                r.used++;
+                z = (q << k) | ((k > 0u) ? rd_get(&r, k) : 0u);
+            }
+            else
+                z = rd_get(&r, 32u);
+        }
+        int32_t v = (int32_t)((uint32_t)unzigzag(z) + (uint32_t)predict(order, h1, h2));
+        x[i] = v;
+        h2 = h1;
+        h1 = v;
+        if (r.used > 8u * r.len)
+            return 0u;
+    }
+
+    c->hist[ch][0] = h1;
+    c->hist[ch][1] = h2;
+    return 1u + (r.used + 7u) / 8u;
+}
@@ -0,0 +1,287 @@
+#include "ad_decim.h"
+#include "ad_arc_port.h"
+#include "main.h"
+#include "arm_math.h"
+#include <math.h>
+#include <string.h>
+
+#define AXI_SRAM_SECTION __attribute__((section(".axi_sram")))
+
+/*
+ * 级联结构（每个逻辑通道一套状态，系数各通道共享）：
+ *   块(4096) -S1 ÷4,32阶-> 1024 -S2 ÷8,64阶-> 128 [MID] -S3 ÷8,64阶-> 16 -S4 ÷8,64阶-> 2 [TREND]
+ * S1/S2 按 256 点分段调用，限制状态缓冲大小（状态长度 = 阶数 + 段长 - 1）。
+ * 输出环只有 Decim 任务一个写者：先写数据、DMB，再推进写计数；
+ * 读者拷贝前后各查一次写计数，保证拷走的帧在拷贝期间没有被覆盖（不加锁，写者永不等待读者）。
+ */
+
+#if (AD_DECIM_POOL_SDRAM_ADDR + (AD_DECIM_MID_FRAMES + AD_DECIM_TREND_FRAMES) * AD_ACQ_CHANNELS * 4u) > 0xC1000000u
+#error "AD_DECIM pool exceeds SDRAM (reduce AD_DECIM_MID_FRAMES or AD_DECIM_TREND_FRAMES)"
+#endif
+
+#define DECIM_STAGES 4u
+
+typedef struct
+{
+    uint16_t factor;  /* 抽取倍数 */
+    uint16_t taps;    /* FIR 阶数 */
+    uint16_t chunk;   /* 每次调用的输入点数（factor 的整数倍） */
+    uint16_t in_len;  /* 每个采样块送入本级的点数 */
+} DecimStageCfg_t;
+
+static const DecimStageCfg_t s_stage_cfg[DECIM_STAGES] = {
+    {4u, 32u, 256u, AD_ACQ_POINTS},
+    {8u, 64u, 256u, AD_ACQ_POINTS / 4u},
+    {8u, 64u, 128u, AD_ACQ_POINTS / 32u},
+    {8u, 64u, 16u, AD_ACQ_POINTS / 256u},
+};
+
+#if (AD_ACQ_POINTS % 4096) != 0
+#error "AD_ACQ_POINTS 须为 4096 的整数倍（抽取级联总倍数 2048，且各级都能按 chunk 整段处理）"
+#endif
+
+/* 各级输出在缓冲中的位置：S1 输出写 s_lvl1，S2 输出即 MID，S3 输出写 s_lvl3，S4 输出即 TREND */
+#define DECIM_MID_PER_BLOCK   (AD_ACQ_POINTS / 32u)
+#define DECIM_TREND_PER_BLOCK (AD_ACQ_POINTS / 2048u)
+
+#define DECIM_STATE_LEN(i) (s_stage_cfg[i].taps + s_stage_cfg[i].chunk - 1u)
+#define DECIM_STATE_TOTAL  ((32u + 256u - 1u) + (64u + 256u - 1u) + (64u + 128u - 1u) + (64u + 16u - 1u))
+
+static float s_coef_s1[32];
+static float s_coef_s8[64];  /* S2..S4 同为 ÷8、64 阶，共用一组系数 */
+
+static arm_fir_decimate_instance_f32 s_fir[AD_ACQ_CHANNELS][DECIM_STAGES];
+static float s_state[AD_ACQ_CHANNELS][DECIM_STATE_TOTAL] AXI_SRAM_SECTION;
+
+/* 单通道换算结果与中间级输出 */
+static float s_in[AD_ACQ_POINTS] AXI_SRAM_SECTION;
+static float s_lvl1[AD_ACQ_POINTS / 4u] AXI_SRAM_SECTION;
+static float s_lvl2[AD_ACQ_CHANNELS][DECIM_MID_PER_BLOCK] AXI_SRAM_SECTION;
+static float s_lvl3[AD_ACQ_POINTS / 256u];
+static float s_lvl4[AD_ACQ_CHANNELS][DECIM_TREND_PER_BLOCK];
+
+/* 输出环（SDRAM），帧内按逻辑通道交织 */
+static float *const s_ring[AD_DECIM_STREAMS] = {
+    (float *)AD_DECIM_POOL_SDRAM_ADDR,
+    (float *)(AD_DECIM_POOL_SDRAM_ADDR + AD_DECIM_MID_FRAMES * AD_ACQ_CHANNELS * 4u),
+};
+static const uint32_t s_ring_cap[AD_DECIM_STREAMS] = {AD_DECIM_MID_FRAMES, AD_DECIM_TREND_FRAMES};
+static const uint32_t s_per_block[AD_DECIM_STREAMS] = {DECIM_MID_PER_BLOCK, DECIM_TREND_PER_BLOCK};
+static const uint32_t s_factor[AD_DECIM_STREAMS] = {32u, 2048u};
+
+static volatile uint32_t s_wr[AD_DECIM_STREAMS];  /* 已发布帧数（不回绕使用，差值比较） */
+static volatile uint32_t s_rate;                  /* 当前输入采样率，0=尚未处理过块 */
+
+static AD_AcqReader_t s_rd;
+static uint32_t s_next_frame;  /* 下一块应有的首帧号，用于发现不连续 */
+static uint8_t s_primed;
+static AD_DecimStats_t s_stats;
+
+/* 加窗 sinc 低通（Hamming），截止 = 0.4 / factor（归一化到输入采样率），直流增益归一为 1 */
+static void decim_design(float *h, uint32_t taps, uint32_t factor)
+{
+    const float fc = 0.4f / (float)factor;
+    const float mid = 0.5f * (float)(taps - 1u);
+    float sum = 0.0f;
+
+    for (uint32_t n = 0; n < taps; n++)
+    {
+        float x = (float)n - mid;
+        float s = (fabsf(x) < 1e-6f) ? (2.0f * fc) : (sinf(2.0f * PI * fc * x) / (PI * x));
+        float w = 0.54f - 0.46f * cosf(2.0f * PI * (float)n / (float)(taps - 1u));
+        h[n] = s * w;
+        sum += h[n];
+    }
+    for (uint32_t n = 0; n < taps; n++)
+        h[n] /= sum;
+}
+
+static void decim_reset_states(void)
+{
+    for (uint32_t ch = 0; ch < AD_ACQ_CHANNELS; ch++)
+    {
+        float *st = s_state[ch];
+        for (uint32_t i = 0; i < DECIM_STAGES; i++)
+        {
+            const DecimStageCfg_t *c = &s_stage_cfg[i];
+            arm_fir_decimate_init_f32(&s_fir[ch][i], c->taps, (uint8_t)c->factor,
+                                      (i == 0u) ? s_coef_s1 : s_coef_s8, st, c->chunk);
+            st += DECIM_STATE_LEN(i);
+        }
+    }
+}
+
+/* 一级抽取：按 chunk 分段处理 in_len 点 */
+static void decim_stage(arm_fir_decimate_instance_f32 *fir, uint32_t stage, const float *src, float *dst)
+{
+    const DecimStageCfg_t *c = &s_stage_cfg[stage];
+    for (uint32_t off = 0; off < c->in_len; off += c->chunk)
+        arm_fir_decimate_f32(fir, src + off, dst + off / c->factor, c->chunk);
+}
+
+/* 把 frames 帧（各通道 src[ch][i]）交织写入输出环并发布 */
+static void decim_publish(uint32_t stream, const float *src, uint32_t stride, uint32_t frames)
+{
+    uint32_t cap = s_ring_cap[stream];
+    uint32_t wr = s_wr[stream];
+    float *ring = s_ring[stream];
+
+    for (uint32_t i = 0; i < frames; i++)
+    {
+        float *dst = &ring[((wr + i) % cap) * AD_ACQ_CHANNELS];
+        for (uint32_t ch = 0; ch < AD_ACQ_CHANNELS; ch++)
+            dst[ch] = src[ch * stride + i];
+    }
+    __DMB();
+    s_wr[stream] = wr + frames;
+    s_stats.frames[stream] += frames;
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD_Decim_Init
+* 功能说明: 计算抽取滤波器系数、清空状态与输出环
+* 形    参: 无
+* 返 回 值: 无
+* 说    明: 须在 AD_Acq_Init 之后、调度器启动之前调用（SDRAM 已初始化）
+*********************************************************************************************************
+*/
+void AD_Decim_Init(void)
+{
+    decim_design(s_coef_s1, 32u, 4u);
+    decim_design(s_coef_s8, 64u, 8u);
+    decim_reset_states();
+
+    memset(s_ring[AD_DECIM_MID], 0, AD_DECIM_MID_FRAMES * AD_ACQ_CHANNELS * sizeof(float));
+    memset(s_ring[AD_DECIM_TREND], 0, AD_DECIM_TREND_FRAMES * AD_ACQ_CHANNELS * sizeof(float));
+    memset((void *)s_wr, 0, sizeof(s_wr));
+    memset(&s_stats, 0, sizeof(s_stats));
+    memset(&s_rd, 0, sizeof(s_rd));
+    s_rate = 0;
+    s_primed = 0;
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD_Decim_Service
+* 功能说明: 按块序号连续消费采样环，逐通道过抽取级联并写入 MID/TREND 输出环
+* 形    参: 无
+* 返 回 值: 本次处理的块数
+* 说    明: 仅在 Decim 任务中调用；块不连续或采样率变化时先清空滤波器状态（输出流帧号保持连续）；
+*           电弧检测（ad_arc_port.c）挂在这里，同样逐块连续处理
+*********************************************************************************************************
+*/
+uint32_t AD_Decim_Service(void)
+{
+    AD_AcqBlock_t blk;
+    uint32_t n = 0;
+
+    while (AD_Acq_AcquireNext(&s_rd, &blk))
+    {
+        if (s_primed && (blk.first_frame != s_next_frame || blk.sample_rate != s_rate))
+        {
+            decim_reset_states();
+            s_stats.gaps++;
+        }
+        s_primed = 1;
+        s_next_frame = blk.first_frame + AD_ACQ_POINTS;
+        s_rate = blk.sample_rate;
+
+        for (uint32_t ch = 0; ch < AD_ACQ_CHANNELS; ch++)
+        {
+            AD_Acq_BlockToVolts(&blk, ch, s_in);
+            AD_Arc_OnBlock(&blk, ch, s_in); /* 电弧检测与抽取共用同一份全速工程量 */
+            decim_stage(&s_fir[ch][0], 0u, s_in, s_lvl1);
+            decim_stage(&s_fir[ch][1], 1u, s_lvl1, s_lvl2[ch]);
+            decim_stage(&s_fir[ch][2], 2u, s_lvl2[ch], s_lvl3);
+            decim_stage(&s_fir[ch][3], 3u, s_lvl3, s_lvl4[ch]);
+        }
+        AD_Acq_Release(&blk);
+
+        decim_publish(AD_DECIM_MID, &s_lvl2[0][0], DECIM_MID_PER_BLOCK, DECIM_MID_PER_BLOCK);
+        decim_publish(AD_DECIM_TREND, &s_lvl4[0][0], DECIM_TREND_PER_BLOCK, DECIM_TREND_PER_BLOCK);
+        s_stats.blocks++;
+        n++;
+    }
+    return n;
+}
+
+void AD_Decim_ReaderInit(AD_DecimStream_t stream, AD_DecimReader_t *rd, uint32_t backlog)
+{
+    uint32_t wr = s_wr[stream];
+    uint32_t avail = wr;
+    uint32_t keep = s_ring_cap[stream] - s_per_block[stream];
+
+    if (avail > keep)
+        avail = keep;
+    if (backlog > avail)
+        backlog = avail;
+    rd->next = wr - backlog;
+    rd->lost = 0;
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD_Decim_Read
+* 功能说明: 从输出环读取订阅者尚未读过的帧
+* 形    参: stream      输出流
+*           rd          订阅者读取状态
+*           dst         输出缓冲，至少 max_frames × AD_ACQ_CHANNELS 个 float
+*           max_frames  最多读取帧数
+*           first_index 非 NULL 时返回首帧的全局帧号
+* 返 回 值: 实际读取帧数（0 = 无新数据）
+* 说    明: 写者每块最多再写 s_per_block 帧，故只在“落后不超过 容量 - 每块帧数”的范围内读取；
+*           拷贝后若写计数已推进到可能覆盖已拷贝的帧，丢弃本次结果并从新位置重读
+*********************************************************************************************************
+*/
+uint32_t AD_Decim_Read(AD_DecimStream_t stream, AD_DecimReader_t *rd, float *dst, uint32_t max_frames,
+                       uint32_t *first_index)
+{
+    const uint32_t cap = s_ring_cap[stream];
+    const uint32_t keep = cap - s_per_block[stream];
+    const float *ring = s_ring[stream];
+
+    for (;;)
+    {
+        uint32_t wr = s_wr[stream];
+        __DMB();
+        if (wr - rd->next > keep)
+        {
+            rd->lost += (wr - rd->next) - keep;
+            rd->next = wr - keep;
+        }
+
+        uint32_t n = wr - rd->next;
+        if (n > max_frames)
+            n = max_frames;
+        for (uint32_t i = 0; i < n; i++)
+        {
+            memcpy(&dst[i * AD_ACQ_CHANNELS], &ring[((rd->next + i) % cap) * AD_ACQ_CHANNELS],
+                   AD_ACQ_CHANNELS * sizeof(float));
+        }
+
+        __DMB();
+        if (s_wr[stream] - rd->next > keep)
+            continue;  /* 拷贝期间被写者追上 */
+
+        if (first_index)
+            *first_index = rd->next;
+        rd->next += n;
+        return n;
+    }
+}
+
+float AD_Decim_SampleRate(AD_DecimStream_t stream)
+{
+    return (float)s_rate / (float)s_factor[stream];
+}
+
+uint32_t AD_Decim_Factor(AD_DecimStream_t stream)
+{
+    return s_factor[stream];
+}
+
+void AD_Decim_GetStats(AD_DecimStats_t *st)
+{
+    *st = s_stats;
+}
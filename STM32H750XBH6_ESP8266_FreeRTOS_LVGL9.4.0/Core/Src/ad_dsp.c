@@ -0,0 +1,364 @@
+#include "ad_dsp.h"
+#include "main.h"
+#include "cmsis_os.h"
+#include "arm_math.h"
+#include "ad_atomic.h"
+#include "ad7606_calib.h"
+#include "ad_spec.h"
+#include "ad_fault_port.h"
+#include "ad_class_port.h"
+#include <string.h>
+
+#define AXI_SRAM_SECTION __attribute__((section(".axi_sram")))
+
+/*
+ * 快照槽协议（与采样块环相同，只是生产者换成了 DSP 任务）：
+ * - 写者：ClaimSlot 先把 seq 清 0 让新读者放弃，再确认 readers==0；写完元数据与数据后最后写 seq、pub
+ * - 读者：readers+1 后复查 seq 未变才算持有；持有期间写者不会选中该槽
+ * 快照本体在 SDRAM（体积大），元数据与计数在内部 RAM。
+ */
+
+/* 每槽 = 头部（< 4KB）+ 通道数 × (波形 + 频谱 + PSD) × 4 字节 */
+#define DSP_SLOT_BYTES_MAX (4096u + AD_ACQ_CHANNELS * (AD_DSP_POINTS + AD_DSP_BINS + AD_PSD_BINS) * 4u)
+
+#if (AD_DSP_POOL_SDRAM_ADDR + AD_DSP_SLOTS * DSP_SLOT_BYTES_MAX) > AD_PSD_STATE_SDRAM_ADDR
+#error "AD_DSP pool overlaps AD_PSD state (reduce AD_DSP_SLOTS)"
+#endif
+
+#if (AD_PSD_NFFT > AD_DSP_POINTS)
+#error "AD_PSD_NFFT 不能超过 AD_DSP_POINTS（共用频谱工作区）"
+#endif
+
+typedef struct
+{
+    acq_atomic_t seq;
+    acq_atomic_t readers;
+} DspSlotMeta_t;
+
+static AD_DspResult_t *const s_pool = (AD_DspResult_t *)AD_DSP_POOL_SDRAM_ADDR;
+static DspSlotMeta_t s_slot[AD_DSP_SLOTS];
+static acq_atomic_t s_pub_slot = 0;
+static uint32_t s_seq = 0;
+
+static osThreadId_t s_thread = NULL;
+static AD_AcqReader_t s_rd;
+static volatile AD_DspStats_t s_stats;
+
+/* 统计内核的基准点：各通道上一块的均值；档位切换（量程/采样率变了）后作废，由内核自选 */
+static float s_stats_ref[AD_ACQ_CHANNELS];
+static uint8_t s_stats_ref_ok = 0;
+static uint8_t s_stats_ref_profile = 0;
+
+#if (AD_DSP_FFT_ENGINE == AD_DSP_FFT_Q15)
+static arm_rfft_instance_q15 s_rfft;
+static q15_t s_fft_in[AD_DSP_POINTS] AXI_SRAM_SECTION;       /* 输入（rfft 会改写）；算完后复用为幅值 */
+static q15_t s_fft_out[AD_DSP_POINTS * 2u] AXI_SRAM_SECTION; /* 2N：含共轭镜像 */
+static float32_t s_psd_work[AD_PSD_NFFT * 2u] AXI_SRAM_SECTION;
+#define DSP_PSD_WORK s_psd_work
+#elif (AD_DSP_FFT_ENGINE == AD_DSP_FFT_Q31)
+static arm_rfft_instance_q31 s_rfft;
+static q31_t s_fft_in[AD_DSP_POINTS] AXI_SRAM_SECTION;
+static q31_t s_fft_out[AD_DSP_POINTS * 2u] AXI_SRAM_SECTION; /* 后半段兼作 q15 暂存 */
+#define DSP_PSD_WORK ((float32_t *)s_fft_out)                     /* PSD 与频谱串行执行，共用 */
+#else
+static AD_SpecKernel_t s_spec;                                   /* 两通道一组的复 FFT 内核 */
+static float32_t s_spec_work[AD_DSP_POINTS * 2u] AXI_SRAM_SECTION; /* N 点复数工作区 */
+#define DSP_PSD_WORK s_spec_work                                     /* PSD 与频谱串行执行，共用 */
+#if (AD_DSP_SPEC_BENCH)
+static float32_t s_bench_mag[AD_DSP_BINS] AXI_SRAM_SECTION;
+#endif
+#endif
+
+/* 采样中断里调用：唤醒 DSP 任务（覆盖 ad_acq_buffers.c 的弱定义） */
+void AD_Acq_OnBlockReady(uint32_t seq)
+{
+    (void)seq;
+    if (s_thread != NULL)
+        (void)osThreadFlagsSet(s_thread, AD_DSP_FLAG_BLOCK);
+}
+
+/* 全部通道的幅值谱（标度见 ad_dsp.h）；定点引擎逐通道直接读采样块原始码，
+ * 浮点引擎读已换算的波形，两通道一组走一次复 FFT（ad_spec.c） */
+static void AD_Dsp_Spectra(const AD_AcqBlock_t *blk, AD_DspResult_t *r)
+{
+#if (AD_DSP_FFT_ENGINE == AD_DSP_FFT_Q15)
+    for (uint32_t ch = 0; ch < AD_ACQ_CHANNELS; ch++)
+    {
+        float *spec = r->spec[ch];
+        AD_Acq_BlockToQ15(blk, ch, s_fft_in);
+        arm_rfft_q15(&s_rfft, s_fft_in, s_fft_out);
+        arm_cmplx_mag_q15(s_fft_out, s_fft_in, AD_DSP_BINS);
+        arm_q15_to_float(s_fft_in, spec, AD_DSP_BINS);
+        arm_scale_f32(spec, 8.0f * AD7606_Cal_Q15Scale(AD_Acq_PhysChannel(ch)), spec, AD_DSP_BINS);
+        spec[0] = 0.0f;
+    }
+#elif (AD_DSP_FFT_ENGINE == AD_DSP_FFT_Q31)
+    q15_t *tmp = (q15_t *)&s_fft_out[AD_DSP_POINTS];
+    for (uint32_t ch = 0; ch < AD_ACQ_CHANNELS; ch++)
+    {
+        float *spec = r->spec[ch];
+        AD_Acq_BlockToQ15(blk, ch, tmp);
+        arm_q15_to_q31(tmp, s_fft_in, AD_DSP_POINTS);
+        arm_rfft_q31(&s_rfft, s_fft_in, s_fft_out);
+        arm_cmplx_mag_q31(s_fft_out, s_fft_in, AD_DSP_BINS);
+        arm_q31_to_float(s_fft_in, spec, AD_DSP_BINS);
+        arm_scale_f32(spec, 8.0f * AD7606_Cal_Q15Scale(AD_Acq_PhysChannel(ch)), spec, AD_DSP_BINS);
+        spec[0] = 0.0f;
+    }
+#else
+    /* 幅度 = |X[k]| / (N/2) × 2，与原上报链路的频谱标度一致 */
+    const float32_t *in[AD_ACQ_CHANNELS];
+    float32_t *out[AD_ACQ_CHANNELS];
+    (void)blk;
+    for (uint32_t ch = 0; ch < AD_ACQ_CHANNELS; ch++)
+    {
+        in[ch] = r->wave[ch];
+        out[ch] = r->spec[ch];
+    }
+    AD_Spec_MagMulti(&s_spec, in, out, AD_ACQ_CHANNELS, 2.0f / (float)AD_DSP_BINS);
+    for (uint32_t ch = 0; ch < AD_ACQ_CHANNELS; ch++)
+        r->spec[ch][0] = 0.0f;
+#endif
+}
+
+#if (AD_DSP_SPEC_BENCH) && (AD_DSP_FFT_ENGINE == AD_DSP_FFT_F32)
+/* 对照：同一快照按原来的逐通道 rfft 再算一遍，记录周期数与最大偏差（相对该通道谱峰） */
+static void AD_Dsp_SpecBench(const AD_DspResult_t *r)
+{
+    uint32_t cyc = 0;
+    float32_t worst = 0.0f;
+
+    for (uint32_t ch = 0; ch < AD_ACQ_CHANNELS; ch++)
+    {
+        float32_t peak = 0.0f;
+        float32_t diff = 0.0f;
+        uint32_t c0 = DWT->CYCCNT;
+        AD_Spec_MagSingle(&s_spec, r->wave[ch], s_bench_mag, 2.0f / (float)AD_DSP_BINS);
+        cyc += DWT->CYCCNT - c0;
+        for (uint32_t k = 1; k < AD_DSP_BINS; k++)
+        {
+            float32_t d = fabsf(s_bench_mag[k] - r->spec[ch][k]);
+            if (s_bench_mag[k] > peak)
+                peak = s_bench_mag[k];
+            if (d > diff)
+                diff = d;
+        }
+        if (peak > 0.0f && diff / peak > worst)
+            worst = diff / peak;
+    }
+    s_stats.ref_cyc = cyc;
+    s_stats.ref_maxrel = worst;
+}
+#endif
+
+const char *AD_Dsp_EngineName(void)
+{
+#if (AD_DSP_FFT_ENGINE == AD_DSP_FFT_Q15)
+    return "q15";
+#elif (AD_DSP_FFT_ENGINE == AD_DSP_FFT_Q31)
+    return "q31";
+#else
+    return "f32";
+#endif
+}
+
+static int32_t AD_Dsp_ClaimSlot(void)
+{
+    uint32_t pub = ACQ_LOAD(&s_pub_slot);
+    for (uint32_t k = 1; k <= AD_DSP_SLOTS; k++)
+    {
+        uint32_t i = (pub + k) % AD_DSP_SLOTS;
+        if (s_seq != 0u && i == pub)
+            continue; /* 最新结果留给读者 */
+        if (ACQ_LOAD(&s_slot[i].readers) != 0u)
+            continue;
+        uint32_t old = ACQ_LOAD(&s_slot[i].seq);
+        ACQ_STORE(&s_slot[i].seq, 0u);
+        ACQ_FENCE();
+        if (ACQ_LOAD(&s_slot[i].readers) == 0u)
+            return (int32_t)i;
+        ACQ_STORE(&s_slot[i].seq, old);
+    }
+    return -1;
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD_Dsp_TaskInit
+* 功能说明: 初始化快照槽与 FFT，登记当前任务为块就绪通知的接收者
+* 形    参: 无
+* 返 回 值: 无
+* 说    明: 在 DSP 任务开头调用一次；登记之前发布的块不会丢，第一次 Service 会取到最新块
+*********************************************************************************************************
+*/
+void AD_Dsp_TaskInit(void)
+{
+    for (uint32_t i = 0; i < AD_DSP_SLOTS; i++)
+    {
+        ACQ_STORE(&s_slot[i].seq, 0u);
+        ACQ_STORE(&s_slot[i].readers, 0u);
+    }
+    ACQ_STORE(&s_pub_slot, 0u);
+    s_seq = 0;
+    memset((void *)&s_stats, 0, sizeof(s_stats));
+    memset(&s_rd, 0, sizeof(s_rd));
+    s_stats_ref_ok = 0;
+#if (AD_DSP_FFT_ENGINE == AD_DSP_FFT_Q15)
+    (void)arm_rfft_init_q15(&s_rfft, AD_DSP_POINTS, 0, 1);
+#elif (AD_DSP_FFT_ENGINE == AD_DSP_FFT_Q31)
+    (void)arm_rfft_init_q31(&s_rfft, AD_DSP_POINTS, 0, 1);
+#else
+    (void)AD_Spec_Init(&s_spec, AD_DSP_POINTS, s_spec_work);
+#endif
+    AD_Psd_Init(DSP_PSD_WORK);
+
+    /* DWT 周期计数器（频谱耗时统计；AD7606_ISR_PROFILE 打开时采样驱动也会使能） */
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->LAR = 0xC5ACCE55;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    s_thread = osThreadGetId();
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD_Dsp_Service
+* 功能说明: 等待块就绪，取最新采样块换算波形、计算统计量、频谱、Welch PSD 与故障分类，发布为新快照
+* 形    参: 无
+* 返 回 值: 无
+* 说    明: 仅在 DSP 任务中循环调用；浮点引擎在换算完波形后立即释放采样块，
+*           定点引擎直接读原始码，持有采样块到频谱算完（每通道约数百微秒）；
+*           AD_DSP_SPEC_BENCH 打开时发布后再做一次逐通道对照计算
+*********************************************************************************************************
+*/
+void AD_Dsp_Service(void)
+{
+    AD_AcqBlock_t blk;
+
+    (void)osThreadFlagsWait(AD_DSP_FLAG_BLOCK, osFlagsWaitAny, AD_DSP_WAIT_MS);
+
+    uint32_t skipped = s_rd.skipped;
+    if (!AD_Acq_AcquireLatest(&s_rd, &blk))
+        return;
+    s_stats.blocks_skipped += s_rd.skipped - skipped;
+
+    int32_t slot = AD_Dsp_ClaimSlot();
+    if (slot < 0)
+    {
+        AD_Acq_Release(&blk);
+        s_stats.no_slot++;
+        return;
+    }
+
+    uint32_t t0 = HAL_GetTick();
+    AD_DspResult_t *r = &s_pool[slot];
+    r->block_seq = blk.seq;
+    r->tick_ms = blk.tick_ms;
+    r->first_frame = blk.first_frame;
+    r->sample_rate = blk.sample_rate;
+    r->os_mode = blk.os_mode;
+    r->profile = blk.profile;
+    for (uint32_t ch = 0; ch < AD_ACQ_CHANNELS; ch++)
+        AD_Acq_BlockToVolts(&blk, ch, r->wave[ch]);
+#if (AD_DSP_FFT_ENGINE == AD_DSP_FFT_F32)
+    AD_Acq_Release(&blk);
+#endif
+
+    /* 刚转换完的波形还在 D-Cache 里，趁热一趟算完全部统计量 */
+    uint32_t c0 = DWT->CYCCNT;
+    if (s_stats_ref_ok && s_stats_ref_profile != r->profile)
+        s_stats_ref_ok = 0;
+    for (uint32_t ch = 0; ch < AD_ACQ_CHANNELS; ch++)
+    {
+        AD_Stats_ComputeRef(r->wave[ch], AD_DSP_POINTS, s_stats_ref_ok ? s_stats_ref[ch] : NAN, &r->stats[ch]);
+        s_stats_ref[ch] = r->stats[ch].mean;
+    }
+    s_stats_ref_ok = 1;
+    s_stats_ref_profile = r->profile;
+    s_stats.stats_cyc = DWT->CYCCNT - c0;
+    AD_Fault_OnBlock(r);
+
+    c0 = DWT->CYCCNT;
+    AD_Dsp_Spectra(&blk, r);
+    s_stats.fft_cyc = DWT->CYCCNT - c0;
+#if (AD_DSP_FFT_ENGINE != AD_DSP_FFT_F32)
+    AD_Acq_Release(&blk);
+#endif
+
+    /* Welch PSD：按块增量更新，快照里带当前平均结果与谐波 */
+    const float *waves[AD_ACQ_CHANNELS];
+    for (uint32_t ch = 0; ch < AD_ACQ_CHANNELS; ch++)
+        waves[ch] = r->wave[ch];
+    AD_Psd_Feed(waves, AD_DSP_POINTS, r->block_seq, r->sample_rate);
+    AD_Psd_GetInfo(&r->psd_info);
+    for (uint32_t ch = 0; ch < AD_ACQ_CHANNELS; ch++)
+        AD_Psd_Export(ch, r->psd[ch], r->harm[ch]);
+
+    /* 故障分类：统计量 + 频谱特征，模型由 AD_Class_Load 加载 */
+    c0 = DWT->CYCCNT;
+    AD_Class_OnBlock(r);
+    s_stats.class_cyc = DWT->CYCCNT - c0;
+
+    /* 发布：先写 seq（release），再切换最新槽 */
+    r->seq = ++s_seq;
+    ACQ_STORE(&s_slot[slot].seq, s_seq);
+    ACQ_STORE(&s_pub_slot, (uint32_t)slot);
+    s_stats.results++;
+    s_stats.last_ms = HAL_GetTick() - t0;
+
+#if (AD_DSP_SPEC_BENCH) && (AD_DSP_FFT_ENGINE == AD_DSP_FFT_F32)
+    AD_Dsp_SpecBench(r); /* 发布后只读快照，不影响读者 */
+#endif
+}
+
+int AD_Dsp_AcquireLatest(AD_DspReader_t *rd, const AD_DspResult_t **res)
+{
+    if (!res)
+        return 0;
+    for (int retry = 0; retry < 3; retry++)
+    {
+        uint32_t i = ACQ_LOAD(&s_pub_slot);
+        uint32_t seq = ACQ_LOAD(&s_slot[i].seq);
+        if (seq == 0u || (rd && seq <= rd->last_seq))
+            return 0;
+
+        ACQ_ADD(&s_slot[i].readers, 1u);
+        ACQ_FENCE();
+        if (ACQ_LOAD(&s_slot[i].seq) != seq)
+        {
+            ACQ_SUB(&s_slot[i].readers, 1u);
+            continue;
+        }
+        if (rd)
+        {
+            if (rd->last_seq != 0u && seq > rd->last_seq + 1u)
+                rd->skipped += seq - rd->last_seq - 1u;
+            rd->last_seq = seq;
+        }
+        *res = &s_pool[i];
+        return 1;
+    }
+    return 0;
+}
+
+void AD_Dsp_Release(const AD_DspResult_t *res)
+{
+    if (!res || res < s_pool || res >= s_pool + AD_DSP_SLOTS)
+        return;
+    ACQ_SUB(&s_slot[res - s_pool].readers, 1u);
+}
+
+void AD_Dsp_GetStats(AD_DspStats_t *st)
+{
+    if (!st)
+        return;
+    st->results = s_stats.results;
+    st->no_slot = s_stats.no_slot;
+    st->blocks_skipped = s_stats.blocks_skipped;
+    st->last_ms = s_stats.last_ms;
+    st->fft_cyc = s_stats.fft_cyc;
+    st->stats_cyc = s_stats.stats_cyc;
+    st->class_cyc = s_stats.class_cyc;
+    st->ref_cyc = s_stats.ref_cyc;
+    st->ref_maxrel = s_stats.ref_maxrel;
+}
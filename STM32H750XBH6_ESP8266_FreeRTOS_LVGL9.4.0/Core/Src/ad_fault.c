@@ -0,0 +1,497 @@
+#include "ad_fault.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * 规则状态机（每条规则独立）：
+ *   空闲：命中置位门限的块连续计数，达到 on_n 即置位（非命中块清零计数）
+ *   置位：越过复位门限的块连续计数，达到 off_n 即复位（未越过的块清零计数）
+ * 特征为 NaN（通道缺失/母线未上电）的块两种计数都不动，规则保持原状态。
+ * 纹波基线只在没有任何规则置位时学习，故障期间的纹波不会被学成"正常"。
+ */
+
+typedef struct
+{
+    uint8_t active;
+    uint8_t hit_n;
+    uint8_t rel_n;
+} RuleState_t;
+
+/* s_cfg：判定所用配置，只在判定任务里读写；s_cfg_req：各任务提交的新配置，
+ * 与 s_cfg_req_seq 一起只在 AD_Fault_Lock 临界区内读写（整表拷贝期间不会被判定任务读到半张表） */
+static AD_FaultConfig_t s_cfg;
+static AD_FaultConfig_t s_cfg_req;
+static uint32_t s_cfg_req_seq = 0;
+static uint32_t s_cfg_seq = 0;
+static volatile uint32_t s_reset_req = 0;
+static uint32_t s_reset_ack = 0;
+
+static RuleState_t s_rs[AD_FAULT_RULES];
+static float s_ripple_base = 0.0f;  /* 0 = 尚未学到 */
+static char s_code[4] = "E00";
+static int8_t s_code_rule = -1;
+static AD_FaultStatus_t s_status;
+
+const char *AD_Fault_FeatName(uint8_t feat)
+{
+    static const char *const names[AD_FEAT_COUNT] = {"bus_v",    "bus_imb",    "ripple",    "ripple_growth",
+                                                     "leak_rms", "spike_rate", "leak_kurt", "iso_kohm",
+                                                     "iso_rate"};
+    return (feat < AD_FEAT_COUNT) ? names[feat] : "?";
+}
+
+const char *AD_Fault_OpName(uint8_t op)
+{
+    static const char *const names[] = {"off", "above", "below"};
+    return (op <= AD_FAULT_BELOW) ? names[op] : "?";
+}
+
+static void fault_rule(AD_FaultRule_t *r, uint8_t feat, uint8_t op, float set, float clear, uint8_t on_n,
+                       uint8_t off_n, const char *code, uint8_t capture)
+{
+    r->op = op;
+    r->feat = feat;
+    r->set = set;
+    r->clear = clear;
+    r->on_n = on_n;
+    r->off_n = off_n;
+    r->capture = capture;
+    memcpy(r->code, code, 4);
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD_Fault_DefaultConfig
+* 功能说明: 编译期默认规则表
+* 形    参: cfg - 输出
+* 返 回 值: 无
+* 说    明: 故障码与服务器约定一致：E02 绝缘故障、E03 直流母线电容老化、E05 直流母线接地；
+*           顺序即优先级（接地 > 漏电流超限 > 漏电尖峰 > 绝缘下降 > 纹波增长 > 绝缘快速劣化）
+*********************************************************************************************************
+*/
+void AD_Fault_DefaultConfig(AD_FaultConfig_t *cfg)
+{
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->ch_bus_p = 0u;
+    cfg->ch_bus_n = 1u;
+    cfg->ch_leak = 3u;
+    cfg->latch = 0u;
+    cfg->bus_min_v = 50.0f;
+    cfg->spike_level = 5.0f;
+    cfg->spike_sigma = 4.0f;
+    cfg->ripple_tau_s = 600.0f;
+    AD_Iso_DefaultConfig(&cfg->iso);
+    fault_rule(&cfg->rule[0], AD_FEAT_BUS_IMB, AD_FAULT_ABOVE, 30.0f, 15.0f, 2u, 10u, "E05", 1u);
+    fault_rule(&cfg->rule[1], AD_FEAT_LEAK_RMS, AD_FAULT_ABOVE, 30.0f, 20.0f, 2u, 10u, "E02", 1u);
+    fault_rule(&cfg->rule[2], AD_FEAT_LEAK_SPIKE_RATE, AD_FAULT_ABOVE, 5.0f, 1.0f, 2u, 20u, "E02", 1u);
+    fault_rule(&cfg->rule[3], AD_FEAT_ISO_KOHM, AD_FAULT_BELOW, 100.0f, 150.0f, 3u, 10u, "E02", 0u);
+    fault_rule(&cfg->rule[4], AD_FEAT_RIPPLE_GROWTH, AD_FAULT_ABOVE, 2.0f, 1.5f, 5u, 20u, "E03", 0u);
+    fault_rule(&cfg->rule[5], AD_FEAT_ISO_RATE, AD_FAULT_BELOW, -50.0f, -20.0f, 5u, 20u, "E02", 0u);
+}
+
+static bool fault_code_ok(const char *c)
+{
+    return c[0] == 'E' && c[1] >= '0' && c[1] <= '9' && c[2] >= '0' && c[2] <= '9' && c[3] == '\0';
+}
+
+bool AD_Fault_SetConfig(const AD_FaultConfig_t *cfg)
+{
+    if (!cfg || !(cfg->bus_min_v >= 0.0f) || !(cfg->spike_level > 0.0f) || !(cfg->spike_sigma >= 0.0f) ||
+        !(cfg->ripple_tau_s > 0.0f) || !AD_Iso_ConfigValid(&cfg->iso))
+        return false;
+    for (uint32_t i = 0; i < AD_FAULT_RULES; i++)
+    {
+        const AD_FaultRule_t *r = &cfg->rule[i];
+        if (r->op == AD_FAULT_OFF)
+            continue;
+        if (r->op > AD_FAULT_BELOW || r->feat >= AD_FEAT_COUNT || r->on_n == 0u || r->off_n == 0u ||
+            !fault_code_ok(r->code))
+            return false;
+        /* 回差方向必须与比较方向一致，否则规则会在置位/复位之间每块翻转 */
+        if ((r->op == AD_FAULT_ABOVE) ? (r->clear > r->set) : (r->clear < r->set))
+            return false;
+    }
+    uint32_t key = AD_Fault_Lock();
+    s_cfg_req = *cfg;
+    s_cfg_req_seq++; /* 判定任务看到序号变化才拷贝 */
+    AD_Fault_Unlock(key);
+    return true;
+}
+
+void AD_Fault_GetConfig(AD_FaultConfig_t *cfg)
+{
+    if (!cfg)
+        return;
+    uint32_t key = AD_Fault_Lock();
+    *cfg = s_cfg_req;
+    AD_Fault_Unlock(key);
+}
+
+void AD_Fault_Reset(void)
+{
+    s_reset_req++;
+}
+
+void AD_Fault_Init(void)
+{
+    AD_FaultConfig_t cfg;
+
+    AD_Fault_DefaultConfig(&cfg);
+    memset(s_rs, 0, sizeof(s_rs));
+    memset(&s_status, 0, sizeof(s_status));
+    s_ripple_base = 0.0f;
+    AD_Iso_Reset();
+    memcpy(s_code, "E00", 4);
+    s_code_rule = -1;
+    s_reset_ack = s_reset_req;
+    s_cfg = cfg;
+    uint32_t key = AD_Fault_Lock();
+    s_cfg_req = cfg;
+    s_cfg_seq = s_cfg_req_seq;
+    AD_Fault_Unlock(key);
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD_Fault_BeginBlock
+* 功能说明: 块边界取用已提交的新配置
+* 形    参: cfg - 输出本块判定所用的配置（可为 NULL）
+* 返 回 值: 无
+* 说    明: 只在判定任务里、每块 Extract 之前调用一次；本块的通道选择、Extract/Eval 与日志都以它为准。
+*           规则表变了，去抖计数与置位状态一并作废；绝缘估计参数变了则估计重来
+*********************************************************************************************************
+*/
+void AD_Fault_BeginBlock(AD_FaultConfig_t *cfg)
+{
+    static AD_FaultConfig_t req; /* 只在判定任务里用，放静态区省栈 */
+    bool fresh = false;
+
+    uint32_t key = AD_Fault_Lock();
+    if (s_cfg_req_seq != s_cfg_seq)
+    {
+        s_cfg_seq = s_cfg_req_seq;
+        req = s_cfg_req;
+        fresh = true;
+    }
+    AD_Fault_Unlock(key);
+
+    if (fresh)
+    {
+        if (memcmp(&s_cfg.iso, &req.iso, sizeof(s_cfg.iso)) != 0)
+            AD_Iso_Reset();
+        s_cfg = req;
+        memset(s_rs, 0, sizeof(s_rs));
+    }
+    if (cfg)
+        *cfg = s_cfg;
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD_Fault_ParseKV
+* 功能说明: 解析配置文件的一项
+* 形    参: cfg - 被修改的配置；key/val - 已去掉首尾空白
+* 返 回 值: true=已识别
+* 说    明: CH_BUS_P/CH_BUS_N/CH_LEAK=物理通道(none=无)，LATCH=0|1，BUS_MIN_V，SPIKE_LEVEL，SPIKE_SIGMA，
+*           RIPPLE_TAU_S；ISO_BRIDGE_KOHM，ISO_SWITCH_KOHM，ISO_SETTLE，ISO_AVG，ISO_TREND_TAU_S，ISO_RATE_TAU_S，
+*           ISO_RATE_GATE_KOHM（见 ad_iso.h）；RULEn_OP=off|above|below，RULEn_FEAT=bus_v|bus_imb|ripple|ripple_growth|
+*           leak_rms|spike_rate|leak_kurt|iso_kohm|iso_rate，RULEn_SET/RULEn_CLEAR=门限，RULEn_ON/RULEn_OFF=去抖块数，RULEn_CODE=E02，
+*           RULEn_CAPTURE=0|1（n = 0..AD_FAULT_RULES-1）
+*********************************************************************************************************
+*/
+bool AD_Fault_ParseKV(AD_FaultConfig_t *cfg, const char *key, const char *val)
+{
+    if (strncmp(key, "CH_", 3) == 0)
+    {
+        uint8_t ch = (strcmp(val, "none") == 0) ? 0xFFu : (uint8_t)strtoul(val, NULL, 0);
+        if (strcmp(key + 3, "BUS_P") == 0)
+            cfg->ch_bus_p = ch;
+        else if (strcmp(key + 3, "BUS_N") == 0)
+            cfg->ch_bus_n = ch;
+        else if (strcmp(key + 3, "LEAK") == 0)
+            cfg->ch_leak = ch;
+        else
+            return false;
+        return true;
+    }
+    if (strcmp(key, "LATCH") == 0)
+        cfg->latch = (uint8_t)(strtoul(val, NULL, 0) != 0u);
+    else if (strcmp(key, "BUS_MIN_V") == 0)
+        cfg->bus_min_v = strtof(val, NULL);
+    else if (strcmp(key, "SPIKE_LEVEL") == 0)
+        cfg->spike_level = strtof(val, NULL);
+    else if (strcmp(key, "SPIKE_SIGMA") == 0)
+        cfg->spike_sigma = strtof(val, NULL);
+    else if (strcmp(key, "RIPPLE_TAU_S") == 0)
+        cfg->ripple_tau_s = strtof(val, NULL);
+    else if (strcmp(key, "ISO_BRIDGE_KOHM") == 0)
+        cfg->iso.r_bridge_kohm = strtof(val, NULL);
+    else if (strcmp(key, "ISO_SWITCH_KOHM") == 0)
+        cfg->iso.r_switch_kohm = strtof(val, NULL);
+    else if (strcmp(key, "ISO_SETTLE") == 0)
+        cfg->iso.settle_blocks = (uint8_t)strtoul(val, NULL, 0);
+    else if (strcmp(key, "ISO_AVG") == 0)
+        cfg->iso.avg_blocks = (uint8_t)strtoul(val, NULL, 0);
+    else if (strcmp(key, "ISO_TREND_TAU_S") == 0)
+        cfg->iso.trend_tau_s = strtof(val, NULL);
+    else if (strcmp(key, "ISO_RATE_TAU_S") == 0)
+        cfg->iso.rate_tau_s = strtof(val, NULL);
+    else if (strcmp(key, "ISO_RATE_GATE_KOHM") == 0)
+        cfg->iso.rate_gate_kohm = strtof(val, NULL);
+    else if (strncmp(key, "RULE", 4) == 0)
+    {
+        char *k;
+        unsigned long n = strtoul(key + 4, &k, 10);
+        if (k == key + 4 || *k != '_' || n >= AD_FAULT_RULES)
+            return false;
+        AD_FaultRule_t *r = &cfg->rule[n];
+        k++;
+        if (strcmp(k, "OP") == 0)
+        {
+            for (uint8_t op = AD_FAULT_OFF; op <= AD_FAULT_BELOW; op++)
+            {
+                if (strcmp(val, AD_Fault_OpName(op)) == 0)
+                    r->op = op;
+            }
+        }
+        else if (strcmp(k, "FEAT") == 0)
+        {
+            r->feat = AD_FEAT_COUNT;
+            for (uint8_t f = 0; f < AD_FEAT_COUNT; f++)
+            {
+                if (strcmp(val, AD_Fault_FeatName(f)) == 0)
+                    r->feat = f;
+            }
+        }
+        else if (strcmp(k, "SET") == 0)
+            r->set = strtof(val, NULL);
+        else if (strcmp(k, "CLEAR") == 0)
+            r->clear = strtof(val, NULL);
+        else if (strcmp(k, "ON") == 0)
+            r->on_n = (uint8_t)strtoul(val, NULL, 0);
+        else if (strcmp(k, "OFF") == 0)
+            r->off_n = (uint8_t)strtoul(val, NULL, 0);
+        else if (strcmp(k, "CAPTURE") == 0)
+            r->capture = (uint8_t)(strtoul(val, NULL, 0) != 0u);
+        else if (strcmp(k, "CODE") == 0)
+        {
+            memset(r->code, 0, sizeof(r->code));
+            strncpy(r->code, val, sizeof(r->code) - 1u);
+            if (r->code[0] == 'e')
+                r->code[0] = 'E';
+        }
+        else
+            return false;
+    }
+    else
+        return false;
+    return true;
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD_Fault_Extract
+* 功能说明: 由一块的统计量与漏电流波形提取判定特征，并推进绝缘电阻估计
+* 形    参: in  - 按角色给出的统计量/波形
+*           f   - 输出
+*           iso - 绝缘电阻估计结果（可为 NULL）
+* 返 回 值: 无
+* 说    明: 纹波增长倍数依赖基线，由 AD_Fault_Eval 填写；尖峰门限取 spike_level 与 spike_sigma × σ 的大者
+*           （稀疏尖峰对 σ 贡献很小），计数带 50% 回差（回落到门限一半以下才重新计数）；
+*           绝缘电阻用正/负母线与漏电流的块均值（ad_iso.c），缺正负母线任一通道时不估计
+*********************************************************************************************************
+*/
+void AD_Fault_Extract(const AD_FaultInput_t *in, AD_FaultFeatures_t *f, AD_IsoResult_t *iso)
+{
+    for (uint32_t i = 0; i < AD_FEAT_COUNT; i++)
+        f->v[i] = NAN;
+
+    float vp = in->bus_p ? fabsf(in->bus_p->mean) : NAN;
+    float vn = in->bus_n ? fabsf(in->bus_n->mean) : NAN;
+    float bus = in->bus_p ? (in->bus_n ? vp + vn : vp) : vn;
+    bool powered = (bus >= s_cfg.bus_min_v);
+
+    f->v[AD_FEAT_BUS_V] = bus;
+    if (in->bus_p && in->bus_n && powered && bus > 0.0f)
+        f->v[AD_FEAT_BUS_IMB] = fabsf(vp - vn) / bus * 100.0f;
+    if (in->bus_p || in->bus_n)
+    {
+        float rp = in->bus_p ? in->bus_p->std : 0.0f;
+        float rn = in->bus_n ? in->bus_n->std : 0.0f;
+        f->v[AD_FEAT_RIPPLE] = (rp > rn) ? rp : rn;
+    }
+
+    if (in->bus_p && in->bus_n)
+    {
+        AD_IsoInput_t ii;
+        AD_IsoResult_t ir;
+        ii.u_p = vp;
+        ii.u_n = vn;
+        ii.i_leak = in->leak ? in->leak->mean : NAN;
+        ii.dt_s = in->dt_s;
+        ii.powered = powered ? 1u : 0u;
+        ii.bridge_hw = in->bridge_hw;
+        AD_Iso_Update(&s_cfg.iso, &ii, &ir);
+        if (powered && ir.valid)
+        {
+            f->v[AD_FEAT_ISO_KOHM] = ir.r_iso_kohm;
+            f->v[AD_FEAT_ISO_RATE] = ir.rate_pct_h;
+        }
+        s_status.iso = ir;
+        if (iso)
+            *iso = ir;
+    }
+    else if (iso)
+        memset(iso, 0, sizeof(*iso));
+
+    if (in->leak)
+    {
+        f->v[AD_FEAT_LEAK_RMS] = in->leak->rms;
+        f->v[AD_FEAT_LEAK_KURT] = in->leak->kurt;
+        if (in->leak_wave && in->n > 0u && in->sample_rate > 0u)
+        {
+            const float mean = in->leak->mean;
+            const float k = s_cfg.spike_sigma * in->leak->std;
+            const float hi = (k > s_cfg.spike_level) ? k : s_cfg.spike_level;
+            const float lo = 0.5f * hi;
+            uint32_t cnt = 0;
+            bool inside = false;
+            for (uint32_t i = 0; i < in->n; i++)
+            {
+                float d = fabsf(in->leak_wave[i] - mean);
+                if (!inside && d >= hi)
+                {
+                    cnt++;
+                    inside = true;
+                }
+                else if (inside && d < lo)
+                    inside = false;
+            }
+            f->v[AD_FEAT_LEAK_SPIKE_RATE] = (float)cnt * (float)in->sample_rate / (float)in->n;
+        }
+    }
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD_Fault_Eval
+* 功能说明: 用一块的特征推进全部规则，得出当前故障码
+* 形    参: f    - 特征（AD_Fault_Extract 输出；纹波增长倍数在此补上）
+*           dt_s - 距上一次判定的时间（秒）
+*           out  - 判定结果
+* 返 回 值: 无
+* 说    明: 只在一个任务里调用；LATCH=1 时规则全部解除后仍保持最后的故障码，直到 AD_Fault_Reset
+*********************************************************************************************************
+*/
+void AD_Fault_Eval(AD_FaultFeatures_t *f, float dt_s, AD_FaultVerdict_t *out)
+{
+    uint32_t active = 0;
+    int8_t best = -1;
+    int8_t capture = -1;
+
+    uint32_t rst = s_reset_req;
+    if (rst != s_reset_ack)
+    {
+        s_reset_ack = rst;
+        memset(s_rs, 0, sizeof(s_rs));
+        memcpy(s_code, "E00", 4);
+        s_code_rule = -1;
+    }
+
+    float ripple = f->v[AD_FEAT_RIPPLE];
+    f->v[AD_FEAT_RIPPLE_GROWTH] = (s_ripple_base > 0.0f) ? ripple / s_ripple_base : NAN;
+
+    for (uint32_t i = 0; i < AD_FAULT_RULES; i++)
+    {
+        const AD_FaultRule_t *r = &s_cfg.rule[i];
+        RuleState_t *st = &s_rs[i];
+        if (r->op == AD_FAULT_OFF || r->feat >= AD_FEAT_COUNT)
+            continue;
+        float v = f->v[r->feat];
+        if (!isnan(v))
+        {
+            bool above = (r->op == AD_FAULT_ABOVE);
+            if (!st->active)
+            {
+                bool hit = above ? (v >= r->set) : (v <= r->set);
+                st->hit_n = hit ? (uint8_t)(st->hit_n + 1u) : 0u;
+                if (st->hit_n >= r->on_n)
+                {
+                    st->active = 1u;
+                    st->hit_n = 0;
+                    st->rel_n = 0;
+                    s_status.raised++;
+                    if (r->capture && capture < 0)
+                        capture = (int8_t)i;
+                }
+            }
+            else
+            {
+                bool rel = above ? (v < r->clear) : (v > r->clear);
+                st->rel_n = rel ? (uint8_t)(st->rel_n + 1u) : 0u;
+                if (st->rel_n >= r->off_n)
+                {
+                    st->active = 0;
+                    st->hit_n = 0;
+                    st->rel_n = 0;
+                }
+            }
+        }
+        if (st->active)
+        {
+            active |= 1u << i;
+            if (best < 0)
+                best = (int8_t)i;
+        }
+    }
+
+    /* 纹波基线：无规则置位时一阶低通学习，首块直接取值 */
+    if (active == 0u && ripple > 0.0f && !isnan(ripple))
+    {
+        if (s_ripple_base <= 0.0f)
+            s_ripple_base = ripple;
+        else
+        {
+            float a = dt_s / s_cfg.ripple_tau_s;
+            s_ripple_base += (ripple - s_ripple_base) * ((a < 1.0f) ? a : 1.0f);
+        }
+    }
+
+    char code[4];
+    int8_t code_rule;
+    if (best >= 0)
+    {
+        memcpy(code, s_cfg.rule[best].code, 4);
+        code_rule = best;
+    }
+    else if (s_cfg.latch)
+    {
+        memcpy(code, s_code, 4);
+        code_rule = s_code_rule;
+    }
+    else
+    {
+        memcpy(code, "E00", 4);
+        code_rule = -1;
+    }
+
+    memcpy(out->code, code, 4);
+    out->rule = code_rule;
+    out->changed = (memcmp(code, s_code, 4) != 0) ? 1u : 0u;
+    out->capture = capture;
+    out->active = active;
+    memcpy(s_code, code, 4);
+    s_code_rule = code_rule;
+
+    s_status.evals++;
+    s_status.feat = *f;
+    s_status.ripple_base = s_ripple_base;
+    s_status.verdict = *out;
+}
+
+void AD_Fault_GetStatus(AD_FaultStatus_t *st)
+{
+    if (st)
+        *st = s_status;
+}
@@ -0,0 +1,167 @@
+#include "ad_fault_port.h"
+#include "main.h"
+#include "ad_trigger.h"
+#include "SD.h"
+#include "ff.h"
+#include <stdio.h>
+#include <string.h>
+
+static uint32_t s_last_tick = 0;
+static uint8_t s_bridge_hw = 0xFFu; /* 0xFF = 尚未探测 */
+static uint8_t s_bridge = AD_ISO_BRIDGE_OFF;
+
+__weak void AD_Fault_SetCode(const char code[4])
+{
+    (void)code;
+}
+
+__weak bool AD_Iso_SetBridge(uint8_t state)
+{
+    (void)state;
+    return false;
+}
+
+/* 配置交接临界区：提交配置的界面/控制台任务可能在整表拷贝中途被 DSP 任务抢占，关中断期间只做这一次拷贝 */
+uint32_t AD_Fault_Lock(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    return primask;
+}
+
+void AD_Fault_Unlock(uint32_t key)
+{
+    __set_PRIMASK(key);
+}
+
+/* 物理通道 -> 快照里的逻辑通道，未采集返回 -1 */
+static int32_t fault_logical(uint8_t phys)
+{
+    for (uint32_t ch = 0; ch < AD_ACQ_CHANNELS; ch++)
+    {
+        if (AD_Acq_PhysChannel(ch) == phys)
+            return (int32_t)ch;
+    }
+    return -1;
+}
+
+/* 录波事件记到规则所看的通道上 */
+static uint8_t fault_capture_ch(const AD_FaultConfig_t *cfg, uint8_t feat)
+{
+    uint8_t ch = (feat >= AD_FEAT_LEAK_RMS) ? cfg->ch_leak : cfg->ch_bus_p;
+    return (ch < 8u) ? ch : 0u;
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD_Fault_OnBlock
+* 功能说明: 对一块数据做本地故障判定
+* 形    参: r - 正在填写的结果快照（统计量已算好）
+* 返 回 值: 无
+* 说    明: 在频谱之前调用，判定到录波请求的延迟只有统计量的计算时间；
+*           先改故障码再请求触发，录下的事件头里就是新故障码；绝缘电阻估计也在这里每块推进一次
+*********************************************************************************************************
+*/
+void AD_Fault_OnBlock(const AD_DspResult_t *r)
+{
+    AD_FaultConfig_t cfg;
+    AD_FaultInput_t in;
+    AD_FaultFeatures_t f;
+    AD_FaultVerdict_t v;
+    AD_IsoResult_t iso;
+
+    if (s_bridge_hw == 0xFFu)
+        s_bridge_hw = AD_Iso_SetBridge(AD_ISO_BRIDGE_OFF) ? 1u : 0u;
+
+    AD_Fault_BeginBlock(&cfg); /* 通道选择、判定与下面的日志用同一张已生效的表 */
+    int32_t bp = fault_logical(cfg.ch_bus_p);
+    int32_t bn = fault_logical(cfg.ch_bus_n);
+    int32_t lk = fault_logical(cfg.ch_leak);
+
+    memset(&in, 0, sizeof(in));
+    in.bus_p = (bp >= 0) ? &r->stats[bp] : NULL;
+    in.bus_n = (bn >= 0) ? &r->stats[bn] : NULL;
+    in.leak = (lk >= 0) ? &r->stats[lk] : NULL;
+    in.leak_wave = (lk >= 0) ? r->wave[lk] : NULL;
+    in.n = AD_DSP_POINTS;
+    in.sample_rate = r->sample_rate;
+
+    uint32_t now = HAL_GetTick();
+    float dt = (s_last_tick != 0u) ? (float)(now - s_last_tick) / 1000.0f
+                                   : (float)AD_DSP_POINTS / (float)((r->sample_rate != 0u) ? r->sample_rate : 1u);
+    s_last_tick = now;
+    in.dt_s = dt;
+    in.bridge_hw = s_bridge_hw;
+    AD_Fault_Extract(&in, &f, &iso);
+    AD_Fault_Eval(&f, dt, &v);
+
+    /* 电桥状态在下一块生效（估计里丢弃切换后的 settle 块）；切换失败视为没有硬件，改走被动法 */
+    if (s_bridge_hw && iso.bridge != s_bridge)
+    {
+        if (AD_Iso_SetBridge(iso.bridge))
+            s_bridge = iso.bridge;
+        else
+        {
+            s_bridge_hw = 0u;
+            printf("[ISO] bridge switch failed, fallback to passive estimate\r\n");
+        }
+    }
+
+    if (v.changed)
+    {
+        AD_Fault_SetCode(v.code);
+        if (v.rule >= 0)
+            printf("[FAULT] %s <- rule%d %s %s %.3f\r\n", v.code, (int)v.rule,
+                   AD_Fault_FeatName(cfg.rule[v.rule].feat), AD_Fault_OpName(cfg.rule[v.rule].op),
+                   (double)f.v[cfg.rule[v.rule].feat]);
+        else
+            printf("[FAULT] %s（规则全部解除）\r\n", v.code);
+    }
+    if (v.capture >= 0)
+        AD_Trig_Force(fault_capture_ch(&cfg, cfg.rule[v.capture].feat));
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD_Fault_LoadFromSD
+* 功能说明: 从 SD 读取判定规则并生效
+* 形    参: 无
+* 返 回 值: true=已加载
+* 说    明: 文件里没写的项取编译期默认值（不是当前值），删掉一行即恢复默认；格式错误的行打印后忽略
+*********************************************************************************************************
+*/
+bool AD_Fault_LoadFromSD(void)
+{
+    extern volatile uint8_t g_qspi_sd_sync_in_progress;
+    AD_FaultConfig_t cfg;
+    FIL fil;
+    char line[96];
+
+    if (g_qspi_sd_sync_in_progress || SD_Init() != FR_OK)
+        return false;
+    if (f_open(&fil, AD_FAULT_CFG_FILE, FA_READ) != FR_OK)
+        return false;
+
+    AD_Fault_DefaultConfig(&cfg);
+    while (f_gets(line, sizeof(line), &fil))
+    {
+        size_t n = strlen(line);
+        while (n > 0 && (line[n - 1] == '\r' || line[n - 1] == '\n' || line[n - 1] == ' ' || line[n - 1] == '\t'))
+            line[--n] = '\0';
+        char *val = strchr(line, '=');
+        if (line[0] == '#' || !val)
+            continue;
+        *val++ = '\0';
+        if (!AD_Fault_ParseKV(&cfg, line, val))
+            printf("[FAULT] %s: unknown key %s\r\n", AD_FAULT_CFG_FILE, line);
+    }
+    (void)f_close(&fil);
+
+    if (!AD_Fault_SetConfig(&cfg))
+    {
+        printf("[FAULT] %s: invalid rule table, ignored\r\n", AD_FAULT_CFG_FILE);
+        return false;
+    }
+    printf("[FAULT] loaded %s\r\n", AD_FAULT_CFG_FILE);
+    return true;
+}
@@ -0,0 +1,385 @@
+#include "ad_frame.h"
+#include <math.h>
+#include <string.h>
+
+static uint32_t s_crc_table[256];
+static uint8_t s_crc_ready = 0;
+
+/* 非有限值按 0 处理（与 JSON 路径的 ESP_SafeFloat 口径一致） */
+static float frame_finite(float v)
+{
+    return (v == v && v < 1.0e20f && v > -1.0e20f) ? v : 0.0f;
+}
+
+static void frame_put(AD_FrameWriter_t *w, const void *p, uint32_t n)
+{
+    if (!w->ok)
+        return;
+    if (w->cap - w->len < n)
+    {
+        w->ok = 0u;
+        return;
+    }
+    memcpy(w->buf + w->len, p, n);
+    w->len += n;
+}
+
+static void frame_poke_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void frame_poke_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+void AD_Frame_PutU8(AD_FrameWriter_t *w, uint8_t v)
+{
+    frame_put(w, &v, 1u);
+}
+
+void AD_Frame_PutU16(AD_FrameWriter_t *w, uint16_t v)
+{
+    uint8_t b[2];
+    frame_poke_u16(b, v);
+    frame_put(w, b, 2u);
+}
+
+void AD_Frame_PutU32(AD_FrameWriter_t *w, uint32_t v)
+{
+    uint8_t b[4];
+    frame_poke_u32(b, v);
+    frame_put(w, b, 4u);
+}
+
+void AD_Frame_PutF32(AD_FrameWriter_t *w, float v)
+{
+    uint32_t u;
+    memcpy(&u, &v, 4u);
+    AD_Frame_PutU32(w, u);
+}
+
+void AD_Frame_PutBytes(AD_FrameWriter_t *w, const void *p, uint32_t n)
+{
+    frame_put(w, p, n);
+}
+
+void AD_Frame_Begin(AD_FrameWriter_t *w, uint8_t *buf, uint32_t cap, const AD_FrameHeader_t *h, const char *node_id)
+{
+    uint32_t node_len = node_id ? (uint32_t)strlen(node_id) : 0u;
+    if (node_len > AD_FRAME_NODE_MAX)
+        node_len = AD_FRAME_NODE_MAX;
+
+    w->buf = buf;
+    w->cap = cap;
+    w->len = 0;
+    w->sec_off = 0;
+    w->sections = 0;
+    w->ok = (buf != NULL) ? 1u : 0u;
+    w->in_sec = 0u;
+    w->sections_decl = 0u;
+    w->crc = 0u;
+    w->flushed = 0u;
+
+    AD_Frame_PutU32(w, AD_FRAME_MAGIC);
+    AD_Frame_PutU8(w, (uint8_t)AD_FRAME_VERSION);
+    AD_Frame_PutU8(w, (uint8_t)AD_FRAME_HDR_LEN);
+    AD_Frame_PutU8(w, (uint8_t)node_len);
+    AD_Frame_PutU8(w, h->flags);
+    AD_Frame_PutU32(w, h->seq);
+    AD_Frame_PutU32(w, h->sample_rate);
+    AD_Frame_PutU32(w, h->tick_ms);
+    AD_Frame_PutU8(w, h->ch_count);
+    AD_Frame_PutU8(w, h->ch_mask);
+    AD_Frame_PutU8(w, h->os_mode);
+    AD_Frame_PutU8(w, h->profile);
+    AD_Frame_PutBytes(w, h->fault_code, 4u);
+    AD_Frame_PutU16(w, 0u); /* 段数，End 回填 */
+    AD_Frame_PutU16(w, 0u);
+    AD_Frame_PutBytes(w, node_id, node_len);
+}
+
+void AD_Frame_SecBegin(AD_FrameWriter_t *w, uint8_t type, uint8_t ch)
+{
+    if (w->in_sec)
+        w->ok = 0u;
+    w->sec_off = w->len;
+    w->in_sec = 1u;
+    AD_Frame_PutU8(w, type);
+    AD_Frame_PutU8(w, ch);
+    AD_Frame_PutU16(w, 0u);
+    AD_Frame_PutU32(w, 0u); /* 段长，SecEnd 回填 */
+}
+
+void AD_Frame_SecEnd(AD_FrameWriter_t *w)
+{
+    if (!w->in_sec)
+        w->ok = 0u;
+    w->in_sec = 0u;
+    if (!w->ok)
+        return;
+    frame_poke_u32(w->buf + w->sec_off + 4u, w->len - w->sec_off - AD_FRAME_SEC_HDR_LEN);
+    w->sections++;
+}
+
+void AD_Frame_AddChan(AD_FrameWriter_t *w, uint8_t ch, float value, const AD_Stats_t *st)
+{
+    AD_Frame_SecBegin(w, AD_FRAME_SEC_CHAN, ch);
+    AD_Frame_PutF32(w, frame_finite(value));
+    AD_Frame_PutF32(w, frame_finite(st->mean));
+    AD_Frame_PutF32(w, frame_finite(st->rms));
+    AD_Frame_PutF32(w, frame_finite(st->min));
+    AD_Frame_PutF32(w, frame_finite(st->max));
+    AD_Frame_PutF32(w, frame_finite(st->p2p));
+    AD_Frame_PutF32(w, frame_finite(st->std));
+    AD_Frame_PutF32(w, frame_finite(st->crest));
+    AD_Frame_PutF32(w, frame_finite(st->skew));
+    AD_Frame_PutF32(w, frame_finite(st->kurt));
+    AD_Frame_SecEnd(w);
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD_Frame_AddWave
+* 功能说明: 追加一段 int16 量化波形
+* 形    参: w    - 写入器
+*           ch   - 物理通道
+*           x    - 工程量波形
+*           n    - 点数
+*           step - 抽取步长（每 step 点取 1 点，0 按 1）
+* 返 回 值: 无
+* 说    明: offset 取区间中点、scale = 半峰峰值 / 32767，量化误差 ≤ scale / 2；
+*           直流母线这类大直流小纹波的信号，分辨率只由本块的峰峰值决定，与直流电平无关
+*********************************************************************************************************
+*/
+void AD_Frame_AddWave(AD_FrameWriter_t *w, uint8_t ch, const float *x, uint32_t n, uint32_t step)
+{
+    if (step == 0u)
+        step = 1u;
+    uint32_t m = (n + step - 1u) / step;
+    if (m > 0xFFFFu)
+        m = 0xFFFFu;
+
+    float lo = 0.0f;
+    float hi = 0.0f;
+    for (uint32_t i = 0; i < m; i++)
+    {
+        float v = frame_finite(x[i * step]);
+        if (i == 0u || v < lo)
+            lo = v;
+        if (i == 0u || v > hi)
+            hi = v;
+    }
+    float offset = 0.5f * (lo + hi);
+    float scale = 0.5f * (hi - lo) / 32767.0f;
+    float inv = (scale > 0.0f) ? 1.0f / scale : 0.0f;
+
+    AD_Frame_SecBegin(w, AD_FRAME_SEC_WAVE, ch);
+    AD_Frame_PutF32(w, scale);
+    AD_Frame_PutF32(w, offset);
+    AD_Frame_PutU16(w, (uint16_t)m);
+    AD_Frame_PutU16(w, (uint16_t)step);
+    if (w->ok && w->cap - w->len >= m * 2u)
+    {
+        uint8_t *p = w->buf + w->len;
+        for (uint32_t i = 0; i < m; i++)
+        {
+            float q = (frame_finite(x[i * step]) - offset) * inv;
+            int32_t qi = (int32_t)((q >= 0.0f) ? (q + 0.5f) : (q - 0.5f));
+            if (qi > 32767)
+                qi = 32767;
+            else if (qi < -32767)
+                qi = -32767;
+            frame_poke_u16(p, (uint16_t)(int16_t)qi);
+            p += 2;
+        }
+        w->len += m * 2u;
+    }
+    else
+        w->ok = 0u;
+    AD_Frame_SecEnd(w);
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD_Frame_AddSpec
+* 功能说明: 追加一段对数量化幅值谱
+* 形    参: w    - 写入器
+*           ch   - 物理通道
+*           s    - 幅值谱
+*           n    - 点数
+*           step - 抽取步长（0 按 1）
+* 返 回 值: 无
+* 说    明: c = round(255 + 20·log10(s / ref) / db_step)，低于 1 的记 0；
+*           谱峰（ref）原样保存，谐波精确值另走 HARM 段
+*********************************************************************************************************
+*/
+void AD_Frame_AddSpec(AD_FrameWriter_t *w, uint8_t ch, const float *s, uint32_t n, uint32_t step)
+{
+    if (step == 0u)
+        step = 1u;
+    uint32_t m = (n + step - 1u) / step;
+    if (m > 0xFFFFu)
+        m = 0xFFFFu;
+
+    float ref = 0.0f;
+    for (uint32_t i = 0; i < m; i++)
+    {
+        float v = frame_finite(s[i * step]);
+        if (v > ref)
+            ref = v;
+    }
+    const float k = 20.0f / AD_FRAME_SPEC_DB_STEP;
+
+    AD_Frame_SecBegin(w, AD_FRAME_SEC_SPEC, ch);
+    AD_Frame_PutF32(w, ref);
+    AD_Frame_PutF32(w, AD_FRAME_SPEC_DB_STEP);
+    AD_Frame_PutU16(w, (uint16_t)m);
+    AD_Frame_PutU16(w, (uint16_t)step);
+    if (w->ok && w->cap - w->len >= m)
+    {
+        uint8_t *p = w->buf + w->len;
+        const float inv_ref = (ref > 0.0f) ? 1.0f / ref : 0.0f;
+        for (uint32_t i = 0; i < m; i++)
+        {
+            float v = frame_finite(s[i * step]);
+            float c = (v > 0.0f) ? 255.0f + k * log10f(v * inv_ref) + 0.5f : 0.0f;
+            p[i] = (c >= 1.0f) ? (uint8_t)((c < 255.0f) ? c : 255.0f) : 0u;
+        }
+        w->len += m;
+    }
+    else
+        w->ok = 0u;
+    AD_Frame_SecEnd(w);
+}
+
+uint32_t AD_Frame_PutCodecBlock(AD_FrameWriter_t *w, AD_Codec_t *c, uint32_t slot, const int32_t *x, uint32_t n)
+{
+    if (!w->ok)
+        return 0u;
+    uint32_t nb = AD_Codec_Encode(c, slot, x, n, w->buf + w->len, w->cap - w->len);
+    if (nb == 0u)
+        w->ok = 0u;
+    w->len += nb;
+    return nb;
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD_Frame_AddWaveZ
+* 功能说明: 追加一段无损压缩波形（WAVE_Z）
+* 形    参: w      - 写入器
+*           c      - 编解码器（用第 0 路，段首清历史）
+*           ch     - 物理通道
+*           x      - 工程量波形
+*           n      - 点数
+*           step   - 抽取步长（0 按 1）
+*           qscale - 定点倍率，q = round(x × qscale)
+* 返 回 值: 无
+* 说    明: 取整方式与 ESP_FloatToI32Scaled 相同，qscale = ESP_UPLOAD_SCALE 时整数序列与 JSON 逐点一致；
+*           边量化边编码，每次只占 c->in 一块，不需要整段的中间缓冲
+*********************************************************************************************************
+*/
+void AD_Frame_AddWaveZ(AD_FrameWriter_t *w, AD_Codec_t *c, uint8_t ch, const float *x, uint32_t n, uint32_t step,
+                       float qscale)
+{
+    if (step == 0u)
+        step = 1u;
+    uint32_t m = (n + step - 1u) / step;
+    if (m > 0xFFFFu)
+        m = 0xFFFFu;
+
+    AD_Frame_SecBegin(w, AD_FRAME_SEC_WAVE_Z, ch);
+    AD_Frame_PutF32(w, qscale);
+    AD_Frame_PutU16(w, (uint16_t)m);
+    AD_Frame_PutU16(w, (uint16_t)step);
+    AD_Frame_PutU16(w, (uint16_t)AD_CODEC_BLOCK);
+    AD_Frame_PutU16(w, 0u);
+    AD_Codec_Reset(c);
+    for (uint32_t i = 0; w->ok && i < m; i += AD_CODEC_BLOCK)
+    {
+        uint32_t cnt = (m - i < AD_CODEC_BLOCK) ? m - i : AD_CODEC_BLOCK;
+        for (uint32_t j = 0; j < cnt; j++)
+        {
+            float q = frame_finite(x[(i + j) * step]) * qscale;
+            c->in[j] = (int32_t)((q >= 0.0f) ? (q + 0.5f) : (q - 0.5f));
+        }
+        (void)AD_Frame_PutCodecBlock(w, c, 0u, c->in, cnt);
+    }
+    AD_Frame_SecEnd(w);
+}
+
+void AD_Frame_AddFloats(AD_FrameWriter_t *w, uint8_t type, uint8_t ch, const float *v, uint32_t n)
+{
+    AD_Frame_SecBegin(w, type, ch);
+    for (uint32_t i = 0; i < n; i++)
+        AD_Frame_PutF32(w, frame_finite(v[i]));
+    AD_Frame_SecEnd(w);
+}
+
+uint32_t AD_Frame_End(AD_FrameWriter_t *w)
+{
+    if (!w->ok || w->in_sec)
+        return 0u;
+    frame_poke_u16(w->buf + 28u, w->sections);
+    uint32_t crc = AD_Frame_Crc32(0u, w->buf, w->len);
+    AD_Frame_PutU32(w, crc);
+    return w->ok ? w->len : 0u;
+}
+
+void AD_Frame_BeginStream(AD_FrameWriter_t *w, uint8_t *buf, uint32_t cap, const AD_FrameHeader_t *h,
+                          const char *node_id, uint16_t sections)
+{
+    AD_Frame_Begin(w, buf, cap, h, node_id);
+    w->sections_decl = sections;
+    if (w->ok)
+        frame_poke_u16(w->buf + 28u, sections);
+}
+
+void AD_Frame_Rebase(AD_FrameWriter_t *w, uint8_t *buf, uint32_t cap)
+{
+    if (w->in_sec)
+        w->ok = 0u;
+    if (!w->ok)
+        return;
+    w->crc = AD_Frame_Crc32(w->crc, w->buf, w->len);
+    w->flushed += w->len;
+    w->buf = buf;
+    w->cap = cap;
+    w->len = 0u;
+    w->ok = (buf != NULL) ? 1u : 0u;
+}
+
+uint32_t AD_Frame_EndStream(AD_FrameWriter_t *w)
+{
+    if (!w->ok || w->in_sec || w->sections != w->sections_decl)
+        return 0u;
+    AD_Frame_PutU32(w, AD_Frame_Crc32(w->crc, w->buf, w->len));
+    return w->ok ? w->len : 0u;
+}
+
+uint32_t AD_Frame_Crc32(uint32_t crc, const void *p, uint32_t n)
+{
+    const uint8_t *b = (const uint8_t *)p;
+
+    if (!s_crc_ready)
+    {
+        for (uint32_t i = 0; i < 256u; i++)
+        {
+            uint32_t c = i;
+            for (uint32_t j = 0; j < 8u; j++)
+                c = (c & 1u) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+            s_crc_table[i] = c;
+        }
+        s_crc_ready = 1u;
+    }
+    crc = ~crc;
+    while (n--)
+        crc = s_crc_table[(crc ^ *b++) & 0xFFu] ^ (crc >> 8);
+    return ~crc;
+}
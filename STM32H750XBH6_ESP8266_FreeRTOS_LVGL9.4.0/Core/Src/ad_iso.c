@@ -0,0 +1,215 @@
+#include "ad_iso.h"
+#include <math.h>
+#include <string.h>
+
+/*
+ * 电桥状态机（不平衡电桥法）：OFF -> POS -> NEG -> POS -> ...
+ *   切到一个状态后先丢 settle 块（切换发生在块中间、分压/对地电容要充放电），再累加 avg 块的 U+ / U−；
+ *   POS 平均完记下，NEG 平均完与之联立求解。掉电或模式变化时回到 OFF 重来。
+ * 被动法每块都给出估计，电桥法每轮给一次，两次之间沿用上一轮的电导更新趋势。
+ */
+
+static AD_IsoResult_t s_res;
+static uint8_t s_state = AD_ISO_BRIDGE_OFF;
+static uint32_t s_blk = 0;
+static uint32_t s_n = 0;
+static float s_sum_p = 0.0f;
+static float s_sum_n = 0.0f;
+static float s_u1p = 0.0f;
+static float s_u1n = 0.0f;
+static float s_g = 0.0f;      /* 最近一次估计的总电导 G+ + G− */
+static float s_g_fast = 0.0f;
+static float s_g_slow = 0.0f;
+static float s_elapsed = 0.0f;
+
+void AD_Iso_DefaultConfig(AD_IsoConfig_t *cfg)
+{
+    cfg->r_bridge_kohm = 0.0f;
+    cfg->r_switch_kohm = 100.0f;
+    cfg->settle_blocks = 2u;
+    cfg->avg_blocks = 4u;
+    cfg->trend_tau_s = 60.0f;
+    cfg->rate_tau_s = 600.0f;
+    cfg->rate_gate_kohm = 2000.0f;
+}
+
+int AD_Iso_ConfigValid(const AD_IsoConfig_t *cfg)
+{
+    return cfg && cfg->r_bridge_kohm >= 0.0f && cfg->r_switch_kohm > 0.0f && cfg->avg_blocks > 0u &&
+           cfg->trend_tau_s > 0.0f && cfg->rate_tau_s > cfg->trend_tau_s && cfg->rate_gate_kohm > 0.0f;
+}
+
+static void iso_restart_bridge(void)
+{
+    s_state = AD_ISO_BRIDGE_OFF;
+    s_blk = 0;
+    s_n = 0;
+    s_sum_p = 0.0f;
+    s_sum_n = 0.0f;
+}
+
+void AD_Iso_Reset(void)
+{
+    memset(&s_res, 0, sizeof(s_res));
+    s_res.trend_kohm = NAN;
+    s_res.rate_pct_h = NAN;
+    iso_restart_bridge();
+    s_g = 0.0f;
+    s_g_fast = 0.0f;
+    s_g_slow = 0.0f;
+    s_elapsed = 0.0f;
+}
+
+static float iso_r(float g)
+{
+    return (g > 1.0f / AD_ISO_R_MAX_KOHM) ? 1.0f / g : AD_ISO_R_MAX_KOHM;
+}
+
+/* 两个状态的平均电压联立求 G+ / G−；切换没生效（两状态几乎相同）返回 0 */
+static int iso_solve(const AD_IsoConfig_t *cfg, float u2p, float u2n, float *gp, float *gn)
+{
+    const float gb = (cfg->r_bridge_kohm > 0.0f) ? 1.0f / cfg->r_bridge_kohm : 0.0f;
+    const float gs = 1.0f / cfg->r_switch_kohm;
+    const float b1 = s_u1n * gb - s_u1p * (gb + gs);
+    const float b2 = u2n * (gb + gs) - u2p * gb;
+    const float det = s_u1n * u2p - s_u1p * u2n;
+
+    if (!(fabsf(det) > 1.0e-4f * (s_u1p + s_u1n) * (u2p + u2n)))
+        return 0;
+    *gp = (s_u1n * b2 - u2n * b1) / det;
+    *gn = (s_u1p * b2 - u2p * b1) / det;
+    /* 噪声使极大电阻的一极解出负电导，按无穷处理 */
+    if (*gp < 0.0f)
+        *gp = 0.0f;
+    if (*gn < 0.0f)
+        *gn = 0.0f;
+    return 1;
+}
+
+/* 被动法：单极接地假设 */
+static int iso_passive(const AD_IsoInput_t *in, float *gp, float *gn)
+{
+    float i = in->i_leak;
+    *gp = 0.0f;
+    *gn = 0.0f;
+    if (isnan(i))
+        return 0;
+    if (i > AD_ISO_I_MIN_MA && in->u_p > 0.0f)
+        *gp = i / in->u_p;
+    else if (i < -AD_ISO_I_MIN_MA && in->u_n > 0.0f)
+        *gn = -i / in->u_n;
+    return 1;
+}
+
+/* 电桥法推进一块，完成一轮时给出估计 */
+static int iso_bridge(const AD_IsoConfig_t *cfg, const AD_IsoInput_t *in, float *gp, float *gn)
+{
+    if (s_state == AD_ISO_BRIDGE_OFF)
+    {
+        s_state = AD_ISO_BRIDGE_POS; /* 本块还没有切入 Rs，不计 */
+        return 0;
+    }
+    if (++s_blk <= cfg->settle_blocks)
+        return 0;
+    s_sum_p += in->u_p;
+    s_sum_n += in->u_n;
+    if (++s_n < cfg->avg_blocks)
+        return 0;
+
+    float up = s_sum_p / (float)s_n;
+    float un = s_sum_n / (float)s_n;
+    int ok = 0;
+    if (s_state == AD_ISO_BRIDGE_POS)
+    {
+        s_u1p = up;
+        s_u1n = un;
+        s_state = AD_ISO_BRIDGE_NEG;
+    }
+    else
+    {
+        ok = iso_solve(cfg, up, un, gp, gn);
+        if (!ok)
+            s_res.rejected++;
+        s_state = AD_ISO_BRIDGE_POS;
+    }
+    s_blk = 0;
+    s_n = 0;
+    s_sum_p = 0.0f;
+    s_sum_n = 0.0f;
+    return ok;
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD_Iso_Update
+* 功能说明: 用一块的均值推进绝缘电阻估计、趋势与变化率
+* 形    参: cfg - 配置（调用者保证已通过 AD_Iso_ConfigValid）
+*           in  - 本块输入
+*           out - 当前结果（含下一块要求的桥臂状态）
+* 返 回 值: 无
+* 说    明: 每块固定几十次浮点运算；未上电时电桥退回 OFF，估计与趋势保持不变
+*********************************************************************************************************
+*/
+void AD_Iso_Update(const AD_IsoConfig_t *cfg, const AD_IsoInput_t *in, AD_IsoResult_t *out)
+{
+    uint8_t mode = in->bridge_hw ? AD_ISO_MODE_BRIDGE : AD_ISO_MODE_PASSIVE;
+    float gp = 0.0f;
+    float gn = 0.0f;
+    int est;
+
+    if (mode != s_res.mode)
+    {
+        s_res.mode = mode;
+        iso_restart_bridge();
+    }
+    if (!in->powered || !(in->u_p >= 0.0f) || !(in->u_n >= 0.0f))
+    {
+        iso_restart_bridge();
+        s_res.bridge = s_state;
+        *out = s_res;
+        return;
+    }
+
+    est = (mode == AD_ISO_MODE_BRIDGE) ? iso_bridge(cfg, in, &gp, &gn) : iso_passive(in, &gp, &gn);
+    if (est)
+    {
+        s_res.r_p_kohm = iso_r(gp);
+        s_res.r_n_kohm = iso_r(gn);
+        s_res.r_iso_kohm = iso_r(gp + gn);
+        s_g = gp + gn;
+        if (s_g < 1.0f / AD_ISO_R_MAX_KOHM)
+            s_g = 1.0f / AD_ISO_R_MAX_KOHM;
+        if (!s_res.valid)
+        {
+            s_g_fast = s_g;
+            s_g_slow = s_g;
+            s_elapsed = 0.0f;
+        }
+        s_res.valid = 1u;
+        s_res.updates++;
+    }
+
+    if (s_res.valid)
+    {
+        float dt = (in->dt_s > 0.0f) ? in->dt_s : 0.0f;
+        float af = dt / cfg->trend_tau_s;
+        float as = dt / cfg->rate_tau_s;
+        s_g_fast += (s_g - s_g_fast) * ((af < 1.0f) ? af : 1.0f);
+        s_g_slow += (s_g - s_g_slow) * ((as < 1.0f) ? as : 1.0f);
+        s_elapsed += dt;
+        s_res.trend_kohm = iso_r(s_g_fast);
+        if (s_elapsed < cfg->rate_tau_s)
+            s_res.rate_pct_h = NAN;
+        else if (s_res.trend_kohm > cfg->rate_gate_kohm)
+            s_res.rate_pct_h = 0.0f;
+        else
+        {
+            /* 电导斜率 -> 电阻相对变化率：dR/R = −dG/G */
+            float slope = (s_g_fast - s_g_slow) / (cfg->rate_tau_s - cfg->trend_tau_s);
+            s_res.rate_pct_h = -slope / s_g_fast * 3600.0f * 100.0f;
+        }
+    }
+
+    s_res.bridge = s_state;
+    *out = s_res;
+}
@@ -0,0 +1,314 @@
+#include "ad_psd.h"
+#include "main.h"
+#include <string.h>
+
+/* 状态区在 SDRAM（体积与通道数成正比），配置与计数在内部 RAM */
+typedef struct
+{
+    float win[AD_PSD_NFFT];
+    float seg[AD_ACQ_CHANNELS][AD_PSD_NFFT]; /* 段缓冲：前 s_fill 点有效 */
+    float acc[AD_ACQ_CHANNELS][AD_PSD_BINS]; /* 指数：当前平均；线性：本轮累加和 */
+    float out[AD_ACQ_CHANNELS][AD_PSD_BINS]; /* 线性：最近一轮完整平均 */
+} PsdState_t;
+
+#if (AD_PSD_STATE_SDRAM_ADDR + (AD_PSD_NFFT + AD_ACQ_CHANNELS * 2u * AD_PSD_NFFT) * 4u) > 0xC1000000u
+#error "AD_PSD state exceeds SDRAM"
+#endif
+
+#if (AD_PSD_NFFT < 32) || (AD_PSD_NFFT > 4096) || ((AD_PSD_NFFT & (AD_PSD_NFFT - 1)) != 0)
+#error "AD_PSD_NFFT 必须是 32..4096 的 2 的幂（arm_rfft_fast_f32）"
+#endif
+
+static PsdState_t *const s_st = (PsdState_t *)AD_PSD_STATE_SDRAM_ADDR;
+static float32_t *s_work = NULL;
+static arm_rfft_fast_instance_f32 s_rfft;
+
+static AD_PsdConfig_t s_cfg = AD_PSD_CONFIG_DEFAULT;     /* DSP 任务正在使用的配置 */
+static AD_PsdConfig_t s_cfg_req = AD_PSD_CONFIG_DEFAULT; /* 待生效配置，与序号一起只在关中断时读写 */
+static uint32_t s_cfg_req_seq = 0;
+static uint32_t s_cfg_seq = 0;
+
+static uint32_t s_fill = 0;        /* 段缓冲已有点数（各通道相同） */
+static uint32_t s_hop = AD_PSD_NFFT / 2u;
+static uint32_t s_count = 0;       /* 指数：已平均段数；线性：本轮已累加段数 */
+static uint32_t s_out_n = 0;       /* 线性：out 对应的段数（0 = 还没有完整一轮） */
+static uint32_t s_last_seq = 0;
+static uint32_t s_rate = 0;
+static float s_norm = 0.0f;        /* 2 / (fs × Σw²) */
+static float s_win_s1 = 1.0f;      /* Σw */
+static float s_win_s2 = 1.0f;      /* Σw² */
+static volatile AD_PsdStats_t s_stats;
+
+const char *AD_Psd_WindowName(uint32_t window)
+{
+    return (window == AD_PSD_WIN_FLATTOP) ? "flattop" : "hann";
+}
+
+/* 按当前配置生成窗表并清空平均（DSP 任务上下文） */
+static void AD_Psd_Restart(void)
+{
+    if (s_cfg.window == AD_PSD_WIN_FLATTOP)
+        arm_hft95_f32(s_st->win, AD_PSD_NFFT);
+    else
+        arm_hanning_f32(s_st->win, AD_PSD_NFFT);
+
+    float s1 = 0.0f;
+    float s2 = 0.0f;
+    for (uint32_t i = 0; i < AD_PSD_NFFT; i++)
+    {
+        s1 += s_st->win[i];
+        s2 += s_st->win[i] * s_st->win[i];
+    }
+    s_win_s1 = s1;
+    s_win_s2 = s2;
+    s_norm = (s_rate != 0u) ? 2.0f / ((float)s_rate * s2) : 0.0f;
+
+    s_hop = (AD_PSD_NFFT * (100u - s_cfg.overlap_pct)) / 100u;
+    s_fill = 0;
+    s_count = 0;
+    s_out_n = 0;
+    memset(s_st->acc, 0, sizeof(s_st->acc));
+    s_stats.resets++;
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD_Psd_Init
+* 功能说明: 初始化 rfft 与默认配置（Hann、50% 重叠、指数平均 8 段）
+* 形    参: work : 工作区，至少 2 × AD_PSD_NFFT 个 float，只在 Feed 内部临时使用
+* 返 回 值: 无
+* 说    明: 在 DSP 任务初始化时调用
+*********************************************************************************************************
+*/
+void AD_Psd_Init(float32_t *work)
+{
+    static const AD_PsdConfig_t def = AD_PSD_CONFIG_DEFAULT;
+
+    s_work = work;
+    arm_rfft_fast_init_f32(&s_rfft, AD_PSD_NFFT);
+    memset((void *)&s_stats, 0, sizeof(s_stats));
+    s_cfg = def;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    s_cfg_req = def;
+    s_cfg_seq = s_cfg_req_seq;
+    __set_PRIMASK(primask);
+    s_rate = 0;
+    s_last_seq = 0;
+    AD_Psd_Restart();
+    s_stats.resets = 0;
+}
+
+int AD_Psd_Configure(const AD_PsdConfig_t *cfg)
+{
+    if (!cfg || cfg->window >= AD_PSD_WIN_COUNT || cfg->avg_mode >= AD_PSD_AVG_COUNT ||
+        cfg->overlap_pct > 75u || cfg->avg_n == 0u || cfg->avg_n > 1000u)
+        return 0;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    s_cfg_req = *cfg;
+    s_cfg_req_seq++; /* DSP 任务看到序号变化才拷贝 */
+    __set_PRIMASK(primask);
+    return 1;
+}
+
+void AD_Psd_GetConfig(AD_PsdConfig_t *cfg)
+{
+    if (!cfg)
+        return;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *cfg = s_cfg_req;
+    __set_PRIMASK(primask);
+}
+
+/* 一段：加窗 -> rfft -> 单边 PSD -> 平均 */
+static void AD_Psd_Segment(uint32_t ch)
+{
+    float32_t *x = s_work;
+    float32_t *p = &s_work[AD_PSD_NFFT];
+    float *acc = s_st->acc[ch];
+
+    arm_mult_f32(s_st->seg[ch], s_st->win, x, AD_PSD_NFFT);
+    arm_rfft_fast_f32(&s_rfft, x, p, 0);
+    float x0 = p[0]; /* 打包格式 p[0]=X[0]，p[1]=X[N/2] */
+    arm_cmplx_mag_squared_f32(p, x, AD_PSD_BINS);
+    x[0] = x0 * x0 * 0.5f; /* 直流不折叠 */
+    arm_scale_f32(x, s_norm, x, AD_PSD_BINS);
+
+    if (s_cfg.avg_mode == AD_PSD_AVG_LINEAR)
+    {
+        arm_add_f32(acc, x, acc, AD_PSD_BINS);
+    }
+    else
+    {
+        /* acc += a × (P - acc)，前 avg_n 段 a = 1/段数（等权），之后固定 1/avg_n */
+        uint32_t n = s_count + 1u;
+        float a = 1.0f / (float)((n < s_cfg.avg_n) ? n : s_cfg.avg_n);
+        arm_sub_f32(x, acc, x, AD_PSD_BINS);
+        arm_scale_f32(x, a, x, AD_PSD_BINS);
+        arm_add_f32(acc, x, acc, AD_PSD_BINS);
+    }
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD_Psd_Feed
+* 功能说明: 追加一个块的工程量波形，凑满的段逐段计算并计入平均
+* 形    参: wave        : 各逻辑通道波形
+*           n           : 每通道点数
+*           block_seq   : 采样块序号（判断连续）
+*           sample_rate : 本块采样率
+* 返 回 值: 无
+* 说    明: 仅在 DSP 任务中调用；块不连续时丢弃未凑满的段，采样率或配置变化时清空平均
+*********************************************************************************************************
+*/
+void AD_Psd_Feed(const float *const wave[], uint32_t n, uint32_t block_seq, uint32_t sample_rate)
+{
+    if (!s_work || !wave || sample_rate == 0u)
+        return;
+
+    uint8_t fresh = 0;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (s_cfg_req_seq != s_cfg_seq)
+    {
+        s_cfg_seq = s_cfg_req_seq;
+        s_cfg = s_cfg_req; /* 提交方可能在整表拷贝中途被抢占，取用也在关中断时做 */
+        fresh = 1;
+    }
+    __set_PRIMASK(primask);
+
+    if (fresh || sample_rate != s_rate)
+    {
+        s_rate = sample_rate;
+        AD_Psd_Restart();
+    }
+    else if (s_last_seq != 0u && block_seq != s_last_seq + 1u)
+    {
+        s_fill = 0;
+        s_stats.gaps++;
+    }
+    s_last_seq = block_seq;
+
+    uint32_t pos = 0;
+    while (pos < n)
+    {
+        uint32_t take = AD_PSD_NFFT - s_fill;
+        if (take > n - pos)
+            take = n - pos;
+        for (uint32_t ch = 0; ch < AD_ACQ_CHANNELS; ch++)
+            memcpy(&s_st->seg[ch][s_fill], &wave[ch][pos], take * sizeof(float));
+        s_fill += take;
+        pos += take;
+        if (s_fill < AD_PSD_NFFT)
+            break;
+
+        for (uint32_t ch = 0; ch < AD_ACQ_CHANNELS; ch++)
+        {
+            AD_Psd_Segment(ch);
+            memmove(s_st->seg[ch], &s_st->seg[ch][s_hop], (AD_PSD_NFFT - s_hop) * sizeof(float));
+        }
+        s_fill = AD_PSD_NFFT - s_hop;
+        s_count++;
+        s_stats.segments++;
+
+        if (s_cfg.avg_mode == AD_PSD_AVG_LINEAR && s_count >= s_cfg.avg_n)
+        {
+            float k = 1.0f / (float)s_count;
+            for (uint32_t ch = 0; ch < AD_ACQ_CHANNELS; ch++)
+            {
+                arm_scale_f32(s_st->acc[ch], k, s_st->out[ch], AD_PSD_BINS);
+                memset(s_st->acc[ch], 0, sizeof(s_st->acc[ch]));
+            }
+            s_out_n = s_count;
+            s_count = 0;
+        }
+    }
+}
+
+/* 当前结果的来源与系数：线性平均优先用完整一轮，否则用本轮部分累加 */
+static const float *AD_Psd_Source(uint32_t ch, float *k, uint32_t *segments)
+{
+    if (s_cfg.avg_mode == AD_PSD_AVG_LINEAR)
+    {
+        if (s_out_n != 0u)
+        {
+            *k = 1.0f;
+            *segments = s_out_n;
+            return s_st->out[ch];
+        }
+        *k = (s_count != 0u) ? 1.0f / (float)s_count : 0.0f;
+        *segments = s_count;
+        return s_st->acc[ch];
+    }
+    *k = 1.0f;
+    *segments = (s_count < s_cfg.avg_n) ? s_count : s_cfg.avg_n;
+    return s_st->acc[ch];
+}
+
+/* 谐波幅值（峰值）：在理论 bin ±2 内找峰，再按窗类型换算（见 ad_psd.h） */
+static float AD_Psd_Harmonic(const float *src, float k, float fund_hz)
+{
+    const float bin_hz = (float)s_rate / (float)AD_PSD_NFFT;
+    uint32_t c = (uint32_t)(fund_hz / bin_hz + 0.5f);
+    if (c < 3u || c + 3u >= AD_PSD_BINS)
+        return 0.0f;
+
+    uint32_t pk = c;
+    for (uint32_t i = c - 2u; i <= c + 2u; i++)
+    {
+        if (src[i] > src[pk])
+            pk = i;
+    }
+
+    float amp = 0.0f;
+    if (s_cfg.window == AD_PSD_WIN_FLATTOP)
+    {
+        arm_sqrt_f32(2.0f * src[pk] * k * (float)s_rate * s_win_s2, &amp);
+        return amp / s_win_s1;
+    }
+
+    float band = 0.0f; /* pk ≥ 1 且 pk + 2 < BINS（上面已限定 c 的范围） */
+    for (uint32_t i = pk - 2u; i <= pk + 2u; i++)
+        band += src[i];
+    arm_sqrt_f32(2.0f * band * k * bin_hz, &amp);
+    return amp;
+}
+
+void AD_Psd_Export(uint32_t ch, float *psd, float *harm)
+{
+    float k;
+    uint32_t segments;
+    if (ch >= AD_ACQ_CHANNELS)
+        return;
+    const float *src = AD_Psd_Source(ch, &k, &segments);
+
+    if (psd)
+        arm_scale_f32(src, k, psd, AD_PSD_BINS);
+    if (harm)
+    {
+        for (uint32_t h = 0; h < AD_PSD_HARMONICS; h++)
+            harm[h] = (segments != 0u) ? AD_Psd_Harmonic(src, k, AD_PSD_FUND_HZ * (float)(h + 1u)) : 0.0f;
+    }
+}
+
+void AD_Psd_GetInfo(AD_PsdInfo_t *info)
+{
+    float k;
+    if (!info)
+        return;
+    (void)AD_Psd_Source(0, &k, &info->segments);
+    info->bin_hz = (float)s_rate / (float)AD_PSD_NFFT;
+    info->window = s_cfg.window;
+    info->avg_mode = s_cfg.avg_mode;
+}
+
+void AD_Psd_GetStats(AD_PsdStats_t *st)
+{
+    if (!st)
+        return;
+    st->segments = s_stats.segments;
+    st->gaps = s_stats.gaps;
+    st->resets = s_stats.resets;
+}
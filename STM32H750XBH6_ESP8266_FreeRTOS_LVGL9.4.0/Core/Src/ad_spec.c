@@ -0,0 +1,107 @@
+#include "ad_spec.h"
+#include <string.h>
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD_Spec_Init
+* 功能说明: 初始化复 FFT（成对）与实 FFT（落单通道）实例，登记工作区
+* 形    参: k    : 内核实例
+*           n    : 点数（2 的幂，32..AD_SPEC_MAX_POINTS）
+*           work : 工作区，至少 2n 个 float
+* 返 回 值: 1=成功，0=参数不支持
+*********************************************************************************************************
+*/
+int AD_Spec_Init(AD_SpecKernel_t *k, uint32_t n, float32_t *work)
+{
+    if (!k || !work || n < 32u || n > AD_SPEC_MAX_POINTS || (n & (n - 1u)) != 0u)
+        return 0;
+    if (arm_cfft_init_f32(&k->cfft, (uint16_t)n) != ARM_MATH_SUCCESS)
+        return 0;
+    if (arm_rfft_fast_init_f32(&k->rfft, (uint16_t)n) != ARM_MATH_SUCCESS)
+        return 0;
+    k->n = n;
+    k->work = work;
+    return 1;
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD_Spec_MagPair
+* 功能说明: 两路实信号打包为一次 N 点复 FFT，拆分后输出两路单边幅值谱
+* 形    参: k            : 内核实例
+*           a, b         : 两路输入（各 N 点，只读）
+*           mag_a, mag_b : 两路输出（各 N/2 点）
+*           scale        : 幅值系数（out = |X[k]| × scale）
+* 返 回 值: 无
+* 说    明: 拆分时 |A[k]| = |Z[k] + conj(Z[N-k])| / 2，|B[k]| = |Z[k] - conj(Z[N-k])| / 2，
+*           1/2 并入 scale；bin0 的 Z[0] 实部即 A[0]、虚部即 B[0]
+*********************************************************************************************************
+*/
+void AD_Spec_MagPair(AD_SpecKernel_t *k, const float32_t *a, const float32_t *b,
+                     float32_t *mag_a, float32_t *mag_b, float32_t scale)
+{
+    float32_t *w = k->work;
+    const uint32_t n = k->n;
+    const float32_t half = 0.5f * scale;
+
+    for (uint32_t i = 0; i < n; i++)
+    {
+        w[2u * i] = a[i];
+        w[2u * i + 1u] = b[i];
+    }
+    arm_cfft_f32(&k->cfft, w, 0, 1);
+
+    mag_a[0] = fabsf(w[0]) * scale;
+    mag_b[0] = fabsf(w[1]) * scale;
+    for (uint32_t i = 1; i < n / 2u; i++)
+    {
+        const float32_t *zk = &w[2u * i];
+        const float32_t *zn = &w[2u * (n - i)];
+        float32_t re = zk[0] + zn[0];
+        float32_t im = zk[1] - zn[1];
+        float32_t m;
+
+        arm_sqrt_f32(re * re + im * im, &m);
+        mag_a[i] = m * half;
+
+        re = zk[1] + zn[1];
+        im = zk[0] - zn[0];
+        arm_sqrt_f32(re * re + im * im, &m);
+        mag_b[i] = m * half;
+    }
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD_Spec_MagSingle
+* 功能说明: 单路实信号 rfft 幅值谱
+* 形    参: k     : 内核实例
+*           x     : 输入（N 点，只读）
+*           mag   : 输出（N/2 点）
+*           scale : 幅值系数
+* 返 回 值: 无
+* 说    明: rfft 会改写输入，先拷贝到工作区前半段，结果放后半段；
+*           打包输出的第 0 对是 (X[0], X[N/2])，bin0 只取 X[0]，与成对路径一致
+*********************************************************************************************************
+*/
+void AD_Spec_MagSingle(AD_SpecKernel_t *k, const float32_t *x, float32_t *mag, float32_t scale)
+{
+    float32_t *w = k->work;
+    const uint32_t n = k->n;
+
+    memcpy(w, x, n * sizeof(float32_t));
+    arm_rfft_fast_f32(&k->rfft, w, &w[n], 0);
+    arm_cmplx_mag_f32(&w[n], mag, n / 2u);
+    arm_scale_f32(mag, scale, mag, n / 2u);
+    mag[0] = fabsf(w[n]) * scale;
+}
+
+void AD_Spec_MagMulti(AD_SpecKernel_t *k, const float32_t *const in[], float32_t *const out[],
+                      uint32_t nch, float32_t scale)
+{
+    uint32_t ch = 0;
+    for (; ch + 1u < nch; ch += 2u)
+        AD_Spec_MagPair(k, in[ch], in[ch + 1u], out[ch], out[ch + 1u], scale);
+    if (ch < nch)
+        AD_Spec_MagSingle(k, in[ch], out[ch], scale);
+}
@@ -0,0 +1,127 @@
+#include "ad_stats.h"
+#include <math.h>
+#include <string.h>
+
+/* 首/中/尾三点的中位数：没有外部基准时的备选，单个尖峰落在其中一点也选不上它 */
+static float AD_Stats_Median3(const float *x, uint32_t n)
+{
+    float a = x[0];
+    float b = x[n / 2u];
+    float c = x[n - 1u];
+    if (a > b)
+    {
+        float t = a;
+        a = b;
+        b = t;
+    }
+    /* 此时 a <= b，中位数 = clamp(c, a, b) */
+    return (c < a) ? a : ((c > b) ? b : c);
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD_Stats_ComputeRef
+* 功能说明: 单趟计算一个通道的全部统计量（指定基准点）
+* 形    参: x   : 输入（工程量）
+*           n   : 点数
+*           ref : 基准点，取同一通道上一块的均值最好；非有限值（NAN）时取首/中/尾三点的中位数
+*           st  : 输出
+* 返 回 值: 无
+* 说    明: d = x - ref，4 路累加器并行累加 d 的 1~4 次幂与极值（单精度）；
+*           中心矩 μk 由原点矩按二项式换算（m = Σd/n），换算在双精度下做（每块一次，M7 有双精度 FPU）：
+*             μ2 = S2/n - m²，μ3 = S3/n - 3m·S2/n + 2m³，μ4 = S4/n - 4m·S3/n + 6m²·S2/n - 3m⁴
+*           基准越接近本块均值，m 越小、相消越少；以首点为基准时首点若是尖峰，m 与 S2/n 同量级，μ2/μ4 会丢有效位
+*********************************************************************************************************
+*/
+void AD_Stats_ComputeRef(const float *x, uint32_t n, float ref, AD_Stats_t *st)
+{
+    memset(st, 0, sizeof(*st));
+    if (!x || n == 0u)
+        return;
+
+    const float pivot = isfinite(ref) ? ref : AD_Stats_Median3(x, n);
+    float s1[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    float s2[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    float s3[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    float s4[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    float lo[4] = {x[0], x[0], x[0], x[0]};
+    float hi[4] = {x[0], x[0], x[0], x[0]};
+    uint32_t i = 0;
+
+    for (; i + 4u <= n; i += 4u)
+    {
+        for (uint32_t l = 0; l < 4u; l++)
+        {
+            float v = x[i + l];
+            float d = v - pivot;
+            float d2 = d * d;
+            s1[l] += d;
+            s2[l] += d2;
+            s3[l] += d2 * d;
+            s4[l] += d2 * d2;
+            lo[l] = (v < lo[l]) ? v : lo[l];
+            hi[l] = (v > hi[l]) ? v : hi[l];
+        }
+    }
+    for (; i < n; i++)
+    {
+        float v = x[i];
+        float d = v - pivot;
+        float d2 = d * d;
+        s1[0] += d;
+        s2[0] += d2;
+        s3[0] += d2 * d;
+        s4[0] += d2 * d2;
+        lo[0] = (v < lo[0]) ? v : lo[0];
+        hi[0] = (v > hi[0]) ? v : hi[0];
+    }
+
+    const double inv_n = 1.0 / (double)n;
+    double m = ((double)s1[0] + s1[1] + s1[2] + s1[3]) * inv_n;
+    double e2 = ((double)s2[0] + s2[1] + s2[2] + s2[3]) * inv_n;
+    double e3 = ((double)s3[0] + s3[1] + s3[2] + s3[3]) * inv_n;
+    double e4 = ((double)s4[0] + s4[1] + s4[2] + s4[3]) * inv_n;
+    double mm = m * m;
+    double mu2 = e2 - mm;
+    double mu3 = e3 - 3.0 * m * e2 + 2.0 * mm * m;
+    double mu4 = e4 - 4.0 * m * e3 + 6.0 * mm * e2 - 3.0 * mm * mm;
+    if (mu2 < 0.0)
+        mu2 = 0.0;
+    double mean = (double)pivot + m;
+
+    st->mean = (float)mean;
+    st->min = (lo[0] < lo[1]) ? lo[0] : lo[1];
+    st->min = (lo[2] < st->min) ? lo[2] : st->min;
+    st->min = (lo[3] < st->min) ? lo[3] : st->min;
+    st->max = (hi[0] > hi[1]) ? hi[0] : hi[1];
+    st->max = (hi[2] > st->max) ? hi[2] : st->max;
+    st->max = (hi[3] > st->max) ? hi[3] : st->max;
+    st->p2p = st->max - st->min;
+    st->rms = (float)sqrt(mu2 + mean * mean);
+    st->std = (float)sqrt(mu2);
+
+    float peak = fmaxf(fabsf(st->min), fabsf(st->max));
+    if (st->rms > 0.0f)
+        st->crest = peak / st->rms;
+    if (mu2 > 0.0)
+    {
+        st->skew = (float)(mu3 / (mu2 * sqrt(mu2)));
+        st->kurt = (float)(mu4 / (mu2 * mu2));
+    }
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD_Stats_Compute
+* 功能说明: 单趟计算一个通道的全部统计量（基准点由本块自选）
+* 形    参: x  : 输入（工程量）
+*           n  : 点数
+*           st : 输出
+* 返 回 值: 无
+* 说    明: 等同 AD_Stats_ComputeRef(x, n, NAN, st)；逐块连续处理同一通道时应改用 ComputeRef 传上一块均值
+*********************************************************************************************************
+*/
+void AD_Stats_Compute(const float *x, uint32_t n, AD_Stats_t *st)
+{
+    AD_Stats_ComputeRef(x, n, NAN, st);
+}
@@ -0,0 +1,263 @@
+#include "ad_tone.h"
+#include "main.h"
+#include "SPI_AD7606.h"
+#include "ad7606_calib.h"
+#include "arm_math.h"
+#include <math.h>
+#include <string.h>
+
+/*
+ * Goertzel：s[n] = x[n] + 2cos(ω)·s[n-1] - s[n-2]，N 点后
+ *   y = s[N-1] - e^{-jω}·s[N-2] = e^{jω(N-1)}·X(ω)，ω = 2πm/N（m 为整数）时 X = y·e^{jω}
+ * 中断里只做递推与发布 y（两次乘法），幅值/相位在读者侧换算。
+ * 直流虽与整周期窗正交，但直流母线上万码值的直流会让低频（ω 小）递推状态放大到 1e8 量级，
+ * 单精度下纹波分量被舍入误差淹没；故递推前先减去上一窗的均值（每帧多一次整数加法）。
+ * 发布用序号锁：lock 为奇数表示中断正在写，读者前后两次读到同一偶数才算拷贝成功。
+ */
+
+typedef struct
+{
+    uint8_t active;
+    uint8_t phys;
+    uint8_t primed;     /* 已用首个采样点初始化 dc */
+    uint32_t len;       /* 窗长 N */
+    uint32_t n;         /* 本窗已累加点数 */
+    uint32_t start;     /* 本窗首帧帧号 */
+    float coeff;        /* 2cos(ω) */
+    float cw;           /* cos(ω) */
+    float sw;           /* sin(ω) */
+    float k;            /* 2/N × 工程量系数（码值 -> 工程量，含增益符号） */
+    float hz;           /* 实际跟踪频率 */
+    float s1;
+    float s2;
+    float dc;           /* 上一窗均值（码值） */
+    int32_t sum;        /* 本窗码值和（len ≤ 65535，不溢出） */
+
+    volatile uint32_t lock;
+    uint32_t out_seq;
+    uint32_t out_tick;
+    uint32_t out_frame;
+    float out_re;
+    float out_im;
+} ToneDet_t;
+
+static ToneDet_t s_det[AD_TONE_MAX];
+static AD_ToneConfig_t s_cfg;
+static uint32_t s_cfg_cal_ver = 0;
+static uint32_t s_cfg_prof_seq = 0;
+static uint32_t s_frame = 0;
+
+/* 配置 -> 跟踪器参数（任务上下文；浮点三角函数不进中断） */
+static void tone_compile(const AD_ToneConfig_t *cfg, uint32_t rate, ToneDet_t det[AD_TONE_MAX])
+{
+    const AD7606_CalTable_t *t = AD7606_Cal_Acquire();
+    const float fs_k = AD7606_GetFullScaleVolts() / 32768.0f / AD7606_FRONTEND_GAIN;
+    const float n0 = (float)rate * (float)cfg->window_ms / 1000.0f;
+
+    memset(det, 0, sizeof(ToneDet_t) * AD_TONE_MAX);
+    for (uint32_t i = 0; i < AD_TONE_MAX; i++)
+    {
+        const AD_ToneChCfg_t *c = &cfg->t[i];
+        ToneDet_t *d = &det[i];
+        if (c->hz <= 0.0f || rate == 0u || c->hz >= 0.5f * (float)rate || c->phys > 7u ||
+            !(AD_ACQ_CH_MASK & (1u << c->phys)))
+            continue;
+
+        long m = lroundf(c->hz * n0 / (float)rate);
+        if (m < 1)
+            m = 1;
+        long len = lroundf((float)m * (float)rate / c->hz);
+        if (len < 8 || len > 65535)
+            continue;
+
+        float w = 2.0f * PI * (float)m / (float)len;
+        d->active = 1u;
+        d->phys = c->phys;
+        d->len = (uint32_t)len;
+        d->cw = cosf(w);
+        d->sw = sinf(w);
+        d->coeff = 2.0f * d->cw;
+        d->k = 2.0f / (float)len * fs_k * t->ch[c->phys].gain;
+        d->hz = (float)m * (float)rate / (float)len;
+    }
+    AD7606_Cal_Release(t);
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD_Tone_SetConfig
+* 功能说明: 设置跟踪频率表与窗长
+* 形    参: cfg - 新配置
+* 返 回 值: true=已生效，false=参数非法
+* 说    明: 参数在任务里算好，关中断只做拷贝；所有跟踪器从下一帧重新开窗，已有结果清空
+*********************************************************************************************************
+*/
+bool AD_Tone_SetConfig(const AD_ToneConfig_t *cfg)
+{
+    ToneDet_t det[AD_TONE_MAX];
+
+    if (!cfg || cfg->window_ms == 0u || cfg->window_ms > 1000u)
+        return false;
+
+    uint32_t ver = AD7606_Cal_Get()->version;
+    uint32_t prof_seq = AD_Acq_ProfileSeq();
+    tone_compile(cfg, AD_Acq_SampleRate(), det);
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    for (uint32_t i = 0; i < AD_TONE_MAX; i++)
+    {
+        det[i].lock = s_det[i].lock + 2u; /* 正在拷贝旧结果的读者会重试 */
+        det[i].start = s_frame;
+    }
+    memcpy(s_det, det, sizeof(det));
+    s_cfg = *cfg;
+    s_cfg_cal_ver = ver;
+    s_cfg_prof_seq = prof_seq;
+    __set_PRIMASK(primask);
+    return true;
+}
+
+void AD_Tone_GetConfig(AD_ToneConfig_t *cfg)
+{
+    if (!cfg)
+        return;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *cfg = s_cfg;
+    __set_PRIMASK(primask);
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD_Tone_Init
+* 功能说明: 装载默认跟踪表（50/100/150/300Hz + 开关频率）
+* 形    参: 无
+* 返 回 值: 无
+* 说    明: 须在 AD7606_Cal_Init、AD_Acq_Init 之后、采样启动之前调用
+*********************************************************************************************************
+*/
+void AD_Tone_Init(void)
+{
+    static const float def_hz[] = {50.0f, 100.0f, 150.0f, 300.0f, AD_TONE_FSW_HZ};
+    AD_ToneConfig_t cfg;
+    uint8_t ch = (AD_ACQ_CH_MASK & (1u << AD_TONE_DEFAULT_CH)) ? (uint8_t)AD_TONE_DEFAULT_CH
+                                                               : (uint8_t)AD_Acq_PhysChannel(0);
+
+    memset(s_det, 0, sizeof(s_det));
+    s_frame = 0;
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.window_ms = AD_TONE_WINDOW_MS;
+    for (uint32_t i = 0; i < sizeof(def_hz) / sizeof(def_hz[0]) && i < AD_TONE_MAX; i++)
+    {
+        cfg.t[i].phys = ch;
+        cfg.t[i].hz = def_hz[i];
+    }
+    (void)AD_Tone_SetConfig(&cfg);
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD_Tone_OnFrame
+* 功能说明: 逐帧 Goertzel 递推，满窗发布
+* 形    参: raw - 8 通道原始码
+* 返 回 值: 无
+* 说    明: 采样中断上下文；零点不影响结果（整周期窗内直流正交），递推前扣上一窗均值保精度；
+*           采样档位已切换但参数尚未重算时暂停
+*********************************************************************************************************
+*/
+void AD_Tone_OnFrame(const uint16_t raw[8])
+{
+    uint32_t frame = s_frame++;
+
+    if (AD_Acq_ProfileSeq() != s_cfg_prof_seq)
+        return;
+
+    for (uint32_t i = 0; i < AD_TONE_MAX; i++)
+    {
+        ToneDet_t *d = &s_det[i];
+        if (!d->active)
+            continue;
+        int32_t x = (int16_t)raw[d->phys];
+        if (!d->primed)
+        {
+            d->dc = (float)x;
+            d->primed = 1u;
+        }
+        d->sum += x;
+        float s0 = ((float)x - d->dc) + d->coeff * d->s1 - d->s2;
+        d->s2 = d->s1;
+        d->s1 = s0;
+        if (++d->n < d->len)
+            continue;
+
+        d->lock++;
+        __DMB();
+        d->out_re = d->s1 - d->cw * d->s2;
+        d->out_im = d->sw * d->s2;
+        d->out_frame = d->start;
+        d->out_tick = HAL_GetTick();
+        d->out_seq++;
+        __DMB();
+        d->lock++;
+
+        d->s1 = 0.0f;
+        d->s2 = 0.0f;
+        d->dc = (float)d->sum / (float)d->len;
+        d->sum = 0;
+        d->n = 0;
+        d->start = frame + 1u;
+    }
+}
+
+bool AD_Tone_Get(uint32_t idx, AD_ToneResult_t *out)
+{
+    ToneDet_t c;
+    uint32_t l0;
+
+    if (idx >= AD_TONE_MAX || !out)
+        return false;
+    const ToneDet_t *d = &s_det[idx];
+    do
+    {
+        l0 = d->lock;
+        __DMB();
+        memcpy(&c, (const void *)d, sizeof(c));
+        __DMB();
+    } while ((l0 & 1u) != 0u || l0 != d->lock);
+
+    if (!c.active || c.out_seq == 0u)
+        return false;
+
+    /* X = y·e^{jω}，再乘 2/N 与工程量系数 */
+    float xr = (c.out_re * c.cw - c.out_im * c.sw) * c.k;
+    float xi = (c.out_re * c.sw + c.out_im * c.cw) * c.k;
+    out->seq = c.out_seq;
+    out->tick_ms = c.out_tick;
+    out->frame = c.out_frame;
+    out->len = c.len;
+    out->hz = c.hz;
+    out->amp = sqrtf(xr * xr + xi * xi);
+    out->phase_deg = atan2f(xi, xr) * (180.0f / PI);
+    out->phys = c.phys;
+    return true;
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD_Tone_Service
+* 功能说明: 标定表版本或采样档位变化时按新系数/新采样率重算跟踪器
+* 形    参: 无
+* 返 回 值: 无
+* 说    明: 与 AD_Trig_Service 同一任务周期调用
+*********************************************************************************************************
+*/
+void AD_Tone_Service(void)
+{
+    if (AD7606_Cal_Get()->version != s_cfg_cal_ver || AD_Acq_ProfileSeq() != s_cfg_prof_seq)
+    {
+        AD_ToneConfig_t cfg;
+        AD_Tone_GetConfig(&cfg);
+        (void)AD_Tone_SetConfig(&cfg);
+    }
+}
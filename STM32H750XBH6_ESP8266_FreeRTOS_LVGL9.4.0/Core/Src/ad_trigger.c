@@ -0,0 +1,701 @@
+#include "ad_trigger.h"
+#include "main.h"
+#include "SPI_AD7606.h"
+#include "ad7606_calib.h"
+#include "sd_waveform.h"
+#include "sd_time.h"
+#include "SD.h"
+#include "ff.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * 事件槽状态：
+ *   FREE  -> ARMED（中断持续写入，作为预触发环）
+ *         -> POST （触发后再写 post 帧；同时新的 ARMED 槽已开始积累下一次的预触发）
+ *         -> READY（冻结，等待各消费者 Release）-> FREE
+ * 同一时刻最多一个 ARMED、一个 POST 槽。
+ * 状态切换 ARMED->POST->READY 只在采样中断里发生；READY->FREE 在任务里，并用 PRIMASK 保护，
+ * 中断里选空闲槽与任务里回收槽不会交错。
+ */
+
+#if (AD_TRIG_POOL_SDRAM_ADDR + AD_TRIG_EVENT_SLOTS * AD_TRIG_MAX_FRAMES * AD_ACQ_CHANNELS * 2u) > 0xC1000000u
+#error "AD_TRIG pool exceeds SDRAM (reduce AD_TRIG_MAX_FRAMES or AD_TRIG_EVENT_SLOTS)"
+#endif
+
+#define TRIG_SLOT_FRAMES_I16 (AD_TRIG_MAX_FRAMES * AD_ACQ_CHANNELS)
+
+enum
+{
+    TRIG_SLOT_FREE = 0,
+    TRIG_SLOT_ARMED,
+    TRIG_SLOT_POST,
+    TRIG_SLOT_READY,
+};
+
+typedef struct
+{
+    volatile uint32_t state;
+    volatile uint32_t pending;  /* 尚未 Release 的消费者 */
+    uint32_t cap;               /* 环容量（帧）= pre + 1 + post，布防时确定 */
+    uint32_t wr;                /* 下一帧写入位置 */
+    uint32_t filled;            /* 已写帧数（饱和于 cap） */
+    uint32_t start;             /* 冻结后最早一帧的位置 */
+    AD_TrigEvent_t ev;
+} TrigSlot_t;
+
+/* 编译后的检测器：门限已换算为原始码，只包含启用且非 OFF 的通道 */
+typedef struct
+{
+    uint8_t phys;
+    uint8_t type;
+    uint8_t latched;  /* 电平型：条件保持期间不重复触发 */
+    uint8_t primed;   /* 已有上一采样点 */
+    int32_t thr;      /* 电平/斜率：码值；dV/dt：码值/采样点；尖峰：偏离码值 */
+    int32_t prev;
+    int32_t base_q8;  /* 尖峰基线（Q8） */
+} TrigDet_t;
+
+static TrigSlot_t s_slots[AD_TRIG_EVENT_SLOTS];
+static TrigDet_t s_det[8];
+static uint32_t s_ndet = 0;
+
+static AD_TrigConfig_t s_cfg;
+static uint32_t s_cfg_cal_ver = 0;   /* 编译门限时的标定表版本 */
+static uint32_t s_cfg_prof_seq = 0;  /* 编译门限时的采样档位序号 */
+static uint32_t s_holdoff_frames = 0;
+static uint32_t s_prof_seq = 0;      /* 中断侧已跟上的采样档位序号 */
+
+static int32_t s_arm = -1;           /* ARMED 槽，-1=无空闲槽 */
+static int32_t s_post = -1;          /* POST 槽，-1=无 */
+static uint32_t s_post_left = 0;
+static uint32_t s_holdoff = 0;
+static uint32_t s_frame = 0;
+static uint32_t s_seq = 0;
+static volatile uint32_t s_consumers = 0;
+static volatile uint32_t s_force_req = 0;  /* 软件触发请求序号（任务写） */
+static uint32_t s_force_ack = 0;           /* 中断侧已处理的请求序号 */
+static volatile uint8_t s_force_ch = 0;
+static volatile AD_TrigStats_t s_stats;
+
+static inline int16_t *trig_slot_buf(uint32_t slot)
+{
+    return (int16_t *)AD_TRIG_POOL_SDRAM_ADDR + (size_t)slot * TRIG_SLOT_FRAMES_I16;
+}
+
+__weak void AD_Trig_GetFaultCode(char code[4])
+{
+    code[0] = 'E';
+    code[1] = '0';
+    code[2] = '0';
+    code[3] = 0;
+}
+
+const char *AD_Trig_TypeName(uint8_t type)
+{
+    static const char *const names[] = {"off", "above", "below", "rise", "fall", "dvdt", "spike", "soft"};
+    return (type < (sizeof(names) / sizeof(names[0]))) ? names[type] : "?";
+}
+
+/* 调用方已关中断或处于采样中断 */
+static void trig_arm_slot(uint32_t slot)
+{
+    TrigSlot_t *s = &s_slots[slot];
+    s->cap = s_cfg.pre_frames + 1u + s_cfg.post_frames;
+    s->wr = 0;
+    s->filled = 0;
+    s->pending = 0;
+    s->state = TRIG_SLOT_ARMED;
+    s_arm = (int32_t)slot;
+}
+
+static void trig_arm_next(void)
+{
+    s_arm = -1;
+    for (uint32_t i = 0; i < AD_TRIG_EVENT_SLOTS; i++)
+    {
+        if (s_slots[i].state == TRIG_SLOT_FREE)
+        {
+            trig_arm_slot(i);
+            return;
+        }
+    }
+}
+
+/* 槽回收；若当前没有布防槽（池满时）直接把它布防 */
+static void trig_free_slot(uint32_t slot)
+{
+    s_slots[slot].state = TRIG_SLOT_FREE;
+    if (s_arm < 0)
+        trig_arm_slot(slot);
+}
+
+static inline void trig_store(TrigSlot_t *s, uint32_t slot, const uint16_t raw[8])
+{
+    AD_Acq_Gather(trig_slot_buf(slot) + (size_t)s->wr * AD_ACQ_CHANNELS, 1u, raw);
+    if (++s->wr == s->cap)
+        s->wr = 0;
+    if (s->filled < s->cap)
+        s->filled++;
+}
+
+static void trig_freeze(uint32_t slot)
+{
+    TrigSlot_t *s = &s_slots[slot];
+    uint32_t frames = s->filled;
+
+    s->start = (s->wr + s->cap - frames) % s->cap;
+    s->ev.frames = frames;
+    s->ev.pre = frames - 1u - s->ev.post;
+    s->pending = s_consumers;
+    s_stats.events++;
+    __DMB();
+    if (s->pending == 0u)
+    {
+        trig_free_slot(slot);
+        return;
+    }
+    s->state = TRIG_SLOT_READY;
+}
+
+/* 采样档位刚切换（中断上下文）：正在录后触发的事件按已录帧数冻结，
+ * 旧采样率下的预触发与检测器历史作废 */
+static void trig_profile_changed(void)
+{
+    if (s_post >= 0)
+    {
+        uint32_t slot = (uint32_t)s_post;
+        s_slots[slot].ev.post -= s_post_left;
+        s_post = -1;
+        s_post_left = 0;
+        trig_freeze(slot);
+    }
+    if (s_arm >= 0)
+        trig_arm_slot((uint32_t)s_arm);
+    else
+        trig_arm_next();
+    for (uint32_t i = 0; i < s_ndet; i++)
+    {
+        s_det[i].primed = 0;
+        s_det[i].latched = 0;
+    }
+}
+
+/* 返回本帧是否命中；检测器状态每帧都更新（含保持期内） */
+static inline bool trig_eval(TrigDet_t *d, int32_t x)
+{
+    bool hit = false;
+    int32_t dev;
+
+    switch (d->type)
+    {
+    case AD_TRIG_LEVEL_ABOVE:
+    case AD_TRIG_LEVEL_BELOW:
+    {
+        bool in = (d->type == AD_TRIG_LEVEL_ABOVE) ? (x >= d->thr) : (x <= d->thr);
+        hit = in && !d->latched;
+        d->latched = in ? 1u : 0u;
+        break;
+    }
+    case AD_TRIG_SLOPE_RISE:
+        hit = d->primed && (d->prev < d->thr) && (x >= d->thr);
+        break;
+    case AD_TRIG_SLOPE_FALL:
+        hit = d->primed && (d->prev > d->thr) && (x <= d->thr);
+        break;
+    case AD_TRIG_DVDT:
+        dev = x - d->prev;
+        hit = d->primed && (((dev < 0) ? -dev : dev) >= d->thr);
+        break;
+    case AD_TRIG_SPIKE:
+        if (!d->primed)
+            d->base_q8 = x * 256;
+        dev = x - (d->base_q8 / 256);
+        hit = d->primed && (((dev < 0) ? -dev : dev) >= d->thr);
+        d->base_q8 += (x * 256 - d->base_q8) / (1 << AD_TRIG_SPIKE_SHIFT);
+        break;
+    default:
+        break;
+    }
+    d->prev = x;
+    d->primed = 1u;
+    return hit;
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD_Trig_OnFrame
+* 功能说明: 逐帧触发判定与事件录制
+* 形    参: raw - 8 通道原始码
+* 返 回 值: 无
+* 说    明: 采样中断上下文；每帧只做若干次比较和 1~2 次帧写入（4 通道 8 字节），不会拖慢采样
+*********************************************************************************************************
+*/
+void AD_Trig_OnFrame(const uint16_t raw[8])
+{
+    uint32_t frame = s_frame++;
+    int32_t fired = -1;
+    uint32_t prof_seq = AD_Acq_ProfileSeq();
+
+    if (prof_seq != s_prof_seq)
+    {
+        s_prof_seq = prof_seq;
+        trig_profile_changed();
+    }
+
+    for (uint32_t i = 0; i < s_ndet; i++)
+    {
+        TrigDet_t *d = &s_det[i];
+        if (trig_eval(d, (int32_t)(int16_t)raw[d->phys]) && fired < 0)
+            fired = (int32_t)i;
+    }
+
+    bool hw = false;
+    bool soft = (s_force_req != s_force_ack);
+    if (s_holdoff)
+        s_holdoff--;
+    else
+        hw = (fired >= 0);
+
+    if ((hw || soft) && s_post < 0)
+    {
+        uint8_t trig_ch, trig_type;
+        if (hw)
+        {
+            trig_ch = s_det[fired].phys;
+            trig_type = s_det[fired].type;
+            s_stats.fired_ch[trig_ch]++;
+        }
+        else
+        {
+            trig_ch = s_force_ch;
+            trig_type = AD_TRIG_SOFT;
+            s_stats.forced++;
+        }
+        s_force_ack = s_force_req; /* 同一帧硬件触发时软件请求一并消化 */
+        s_holdoff = s_holdoff_frames;
+        if (s_arm >= 0)
+        {
+            TrigSlot_t *s = &s_slots[s_arm];
+            s->ev.seq = ++s_seq;
+            s->ev.tick_ms = HAL_GetTick();
+            s->ev.trig_frame = frame;
+            s->ev.sample_rate = AD_Acq_SampleRate();
+            s->ev.os_mode = AD_Acq_OsMode();
+            s->ev.post = s->cap - 1u - s_cfg.pre_frames;
+            s->ev.trig_ch = trig_ch;
+            s->ev.trig_type = trig_type;
+            s->ev.slot = (uint32_t)s_arm;
+            AD_Trig_GetFaultCode(s->ev.fault_code);
+            s->state = TRIG_SLOT_POST;
+            s_post = s_arm;
+            s_post_left = s->ev.post + 1u; /* 含触发帧 */
+            trig_arm_next();
+        }
+        else
+        {
+            s_stats.no_slot++;
+        }
+    }
+
+    if (s_arm >= 0)
+        trig_store(&s_slots[s_arm], (uint32_t)s_arm, raw);
+    if (s_post >= 0)
+    {
+        trig_store(&s_slots[s_post], (uint32_t)s_post, raw);
+        if (--s_post_left == 0u)
+        {
+            uint32_t slot = (uint32_t)s_post;
+            s_post = -1;
+            trig_freeze(slot);
+        }
+    }
+}
+
+/* 工程量门限 -> 原始码门限（x = (code - offset) * k）；k<0 时比较方向取反 */
+static uint32_t trig_compile(const AD_TrigConfig_t *cfg, uint32_t rate, TrigDet_t det[8])
+{
+    const AD7606_CalTable_t *t = AD7606_Cal_Acquire();
+    const float fs = AD7606_GetFullScaleVolts() / 32768.0f / AD7606_FRONTEND_GAIN;
+    uint32_t n = 0;
+
+    for (uint32_t ch = 0; ch < 8u; ch++)
+    {
+        uint8_t type = cfg->ch[ch].type;
+        if (type == AD_TRIG_OFF || type > AD_TRIG_SPIKE || !(AD_ACQ_CH_MASK & (1u << ch)))
+            continue;
+
+        float k = fs * t->ch[ch].gain;
+        if (k == 0.0f)
+            continue;
+        float level = cfg->ch[ch].level;
+        float thr;
+        if (type == AD_TRIG_DVDT)
+            thr = fabsf(level / k) / (float)rate;
+        else if (type == AD_TRIG_SPIKE)
+            thr = fabsf(level / k);
+        else
+        {
+            thr = level / k + t->ch[ch].offset;
+            if (k < 0.0f)
+            {
+                static const uint8_t flip[] = {0, AD_TRIG_LEVEL_BELOW, AD_TRIG_LEVEL_ABOVE,
+                                               AD_TRIG_SLOPE_FALL, AD_TRIG_SLOPE_RISE};
+                type = flip[type];
+            }
+        }
+        if (thr > 40000.0f)
+            thr = 40000.0f;
+        if (thr < -40000.0f)
+            thr = -40000.0f;
+        /* 相对门限至少 1 LSB，否则每个采样点都会命中 */
+        if ((type == AD_TRIG_DVDT || type == AD_TRIG_SPIKE) && thr < 1.0f)
+            thr = 1.0f;
+
+        TrigDet_t *d = &det[n++];
+        memset(d, 0, sizeof(*d));
+        d->phys = (uint8_t)ch;
+        d->type = type;
+        d->thr = (int32_t)lroundf(thr);
+    }
+    AD7606_Cal_Release(t);
+    return n;
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD_Trig_SetConfig
+* 功能说明: 设置触发条件与预/后触发深度
+* 形    参: cfg - 新配置
+* 返 回 值: true=已生效，false=参数非法
+* 说    明: 门限在任务里换算好，关中断只做拷贝；正在录后触发的事件不受影响
+*********************************************************************************************************
+*/
+bool AD_Trig_SetConfig(const AD_TrigConfig_t *cfg)
+{
+    TrigDet_t det[8];
+
+    if (!cfg || cfg->pre_frames + 1u + cfg->post_frames > AD_TRIG_MAX_FRAMES ||
+        cfg->pre_frames >= AD_TRIG_MAX_FRAMES || cfg->post_frames >= AD_TRIG_MAX_FRAMES)
+        return false;
+
+    uint32_t ver = AD7606_Cal_Get()->version;
+    uint32_t prof_seq = AD_Acq_ProfileSeq();
+    uint32_t rate = AD_Acq_SampleRate();
+    uint32_t n = trig_compile(cfg, rate, det);
+    uint32_t holdoff = (uint32_t)(((uint64_t)cfg->holdoff_ms * rate) / 1000u);
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    s_cfg = *cfg;
+    memcpy(s_det, det, sizeof(det));
+    s_ndet = n;
+    s_holdoff_frames = holdoff;
+    s_cfg_cal_ver = ver;
+    s_cfg_prof_seq = prof_seq;
+    if (s_arm >= 0)
+        trig_arm_slot((uint32_t)s_arm); /* 按新深度重新积累预触发 */
+    else
+        trig_arm_next();
+    __set_PRIMASK(primask);
+    return true;
+}
+
+void AD_Trig_GetConfig(AD_TrigConfig_t *cfg)
+{
+    if (!cfg)
+        return;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *cfg = s_cfg;
+    __set_PRIMASK(primask);
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD_Trig_Init
+* 功能说明: 初始化事件池并装载默认配置
+* 形    参: 无
+* 返 回 值: 无
+* 说    明: 须在 AD7606_Cal_Init、AD_Acq_Init 之后、采样启动之前调用；默认所有通道不触发，SD 写盘消费者已登记
+*********************************************************************************************************
+*/
+void AD_Trig_Init(void)
+{
+    AD_TrigConfig_t cfg;
+
+    memset(s_slots, 0, sizeof(s_slots));
+    memset((void *)&s_stats, 0, sizeof(s_stats));
+    s_arm = -1;
+    s_post = -1;
+    s_post_left = 0;
+    s_holdoff = 0;
+    s_frame = 0;
+    s_seq = 0;
+    s_prof_seq = AD_Acq_ProfileSeq();
+    s_consumers = AD_TRIG_CONSUMER_SD;
+
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.pre_frames = AD_Acq_SampleRate() / 10u;   /* 100ms（按上电档位） */
+    cfg.post_frames = AD_Acq_SampleRate() / 5u;   /* 200ms */
+    cfg.holdoff_ms = 1000u;
+    (void)AD_Trig_SetConfig(&cfg);
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD_Trig_Force
+* 功能说明: 请求一次软件触发
+* 形    参: phys - 记入事件的触发通道（物理）
+* 返 回 值: 无
+* 说    明: 任务上下文；中断侧在下一帧按正常触发处理（预触发环照常），不受保持期限制，
+*           正在录后触发时等其冻结后再触发；没有空闲槽时与硬件触发一样计入 no_slot
+*********************************************************************************************************
+*/
+void AD_Trig_Force(uint8_t phys)
+{
+    s_force_ch = phys;
+    __DMB();
+    s_force_req++;
+}
+
+void AD_Trig_SetConsumer(uint32_t consumer, bool enable)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (enable)
+    {
+        s_consumers |= consumer;
+    }
+    else
+    {
+        s_consumers &= ~consumer;
+        for (uint32_t i = 0; i < AD_TRIG_EVENT_SLOTS; i++)
+        {
+            TrigSlot_t *s = &s_slots[i];
+            if (s->state == TRIG_SLOT_READY && (s->pending & consumer))
+            {
+                s->pending &= ~consumer;
+                if (s->pending == 0u)
+                    trig_free_slot(i);
+            }
+        }
+    }
+    __set_PRIMASK(primask);
+}
+
+bool AD_Trig_Acquire(uint32_t consumer, AD_TrigEvent_t *ev)
+{
+    int32_t best = -1;
+
+    if (!ev)
+        return false;
+    for (uint32_t i = 0; i < AD_TRIG_EVENT_SLOTS; i++)
+    {
+        const TrigSlot_t *s = &s_slots[i];
+        if (s->state != TRIG_SLOT_READY || !(s->pending & consumer))
+            continue;
+        if (best < 0 || (int32_t)(s->ev.seq - s_slots[best].ev.seq) < 0)
+            best = (int32_t)i;
+    }
+    if (best < 0)
+        return false;
+    __DMB();
+    *ev = s_slots[best].ev;
+    return true;
+}
+
+void AD_Trig_Release(uint32_t consumer, const AD_TrigEvent_t *ev)
+{
+    if (!ev || ev->slot >= AD_TRIG_EVENT_SLOTS)
+        return;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    TrigSlot_t *s = &s_slots[ev->slot];
+    if (s->state == TRIG_SLOT_READY && s->ev.seq == ev->seq && (s->pending & consumer))
+    {
+        s->pending &= ~consumer;
+        if (s->pending == 0u)
+            trig_free_slot(ev->slot);
+    }
+    __set_PRIMASK(primask);
+}
+
+uint32_t AD_Trig_Segments(const AD_TrigEvent_t *ev, const int16_t **seg0, uint32_t *frames0,
+                          const int16_t **seg1, uint32_t *frames1)
+{
+    if (!ev || ev->slot >= AD_TRIG_EVENT_SLOTS || !seg0 || !frames0 || !seg1 || !frames1)
+        return 0;
+    const TrigSlot_t *s = &s_slots[ev->slot];
+    const int16_t *buf = trig_slot_buf(ev->slot);
+    uint32_t n0 = s->cap - s->start;
+    if (n0 > ev->frames)
+        n0 = ev->frames;
+    *seg0 = buf + (size_t)s->start * AD_ACQ_CHANNELS;
+    *frames0 = n0;
+    *seg1 = (ev->frames > n0) ? buf : NULL;
+    *frames1 = ev->frames - n0;
+    return ev->frames;
+}
+
+int16_t AD_Trig_Sample(const AD_TrigEvent_t *ev, uint32_t frame, uint32_t ch)
+{
+    if (!ev || ev->slot >= AD_TRIG_EVENT_SLOTS || frame >= ev->frames || ch >= AD_ACQ_CHANNELS)
+        return 0;
+    const TrigSlot_t *s = &s_slots[ev->slot];
+    uint32_t pos = s->start + frame;
+    if (pos >= s->cap)
+        pos -= s->cap;
+    return trig_slot_buf(ev->slot)[(size_t)pos * AD_ACQ_CHANNELS + ch];
+}
+
+void AD_Trig_GetStats(AD_TrigStats_t *st)
+{
+    if (!st)
+        return;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    memcpy(st, (const void *)&s_stats, sizeof(*st));
+    __set_PRIMASK(primask);
+}
+
+static uint8_t trig_parse_type(const char *s)
+{
+    for (uint8_t t = AD_TRIG_OFF; t <= AD_TRIG_SPIKE; t++)
+    {
+        if (strcmp(s, AD_Trig_TypeName(t)) == 0)
+            return t;
+    }
+    return AD_TRIG_OFF;
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD_Trig_LoadFromSD
+* 功能说明: 从 SD 读取触发配置并生效
+* 形    参: 无
+* 返 回 值: true=已加载
+* 说    明: KEY=VALUE 每行一项，缺省项保持当前值：
+*           PRE=2560 / POST=5120（帧）/ HOLDOFF_MS=1000
+*           CHn_TYPE=off|above|below|rise|fall|dvdt|spike，CHn_LEVEL=工程量（dvdt 为 单位/秒）
+*********************************************************************************************************
+*/
+bool AD_Trig_LoadFromSD(void)
+{
+    extern volatile uint8_t g_qspi_sd_sync_in_progress;
+    AD_TrigConfig_t cfg;
+    FIL fil;
+    char line[96];
+
+    if (g_qspi_sd_sync_in_progress || SD_Init() != FR_OK)
+        return false;
+    if (f_open(&fil, AD_TRIG_CFG_FILE, FA_READ) != FR_OK)
+        return false;
+
+    AD_Trig_GetConfig(&cfg);
+    while (f_gets(line, sizeof(line), &fil))
+    {
+        size_t n = strlen(line);
+        while (n > 0 && (line[n - 1] == '\r' || line[n - 1] == '\n' || line[n - 1] == ' ' || line[n - 1] == '\t'))
+            line[--n] = '\0';
+        char *val = strchr(line, '=');
+        if (line[0] == '#' || !val)
+            continue;
+        *val++ = '\0';
+
+        if (strcmp(line, "PRE") == 0)
+            cfg.pre_frames = (uint32_t)strtoul(val, NULL, 0);
+        else if (strcmp(line, "POST") == 0)
+            cfg.post_frames = (uint32_t)strtoul(val, NULL, 0);
+        else if (strcmp(line, "HOLDOFF_MS") == 0)
+            cfg.holdoff_ms = (uint32_t)strtoul(val, NULL, 0);
+        else if (line[0] == 'C' && line[1] == 'H' && line[2] >= '0' && line[2] <= '7' && line[3] == '_')
+        {
+            AD_TrigChCfg_t *c = &cfg.ch[line[2] - '0'];
+            if (strcmp(line + 4, "TYPE") == 0)
+                c->type = trig_parse_type(val);
+            else if (strcmp(line + 4, "LEVEL") == 0)
+                c->level = strtof(val, NULL);
+        }
+    }
+    (void)f_close(&fil);
+
+    if (!AD_Trig_SetConfig(&cfg))
+    {
+        printf("[TRIG] %s: PRE+1+POST > %u, ignored\r\n", AD_TRIG_CFG_FILE, (unsigned)AD_TRIG_MAX_FRAMES);
+        return false;
+    }
+    printf("[TRIG] loaded %s (pre=%lu post=%lu holdoff=%lums)\r\n", AD_TRIG_CFG_FILE,
+           (unsigned long)cfg.pre_frames, (unsigned long)cfg.post_frames, (unsigned long)cfg.holdoff_ms);
+    return true;
+}
+
+static bool trig_save_event(const AD_TrigEvent_t *ev)
+{
+    const float fs = AD7606_GetFullScaleVolts() / 32768.0f / AD7606_FRONTEND_GAIN;
+    SD_EventHeader_t hdr;
+    const int16_t *seg0, *seg1;
+    uint32_t n0, n1;
+
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.magic = SD_EVENT_MAGIC;
+    hdr.version = SD_EVENT_VERSION;
+    hdr.timestamp = SD_Time_GetUnix();
+    hdr.seq = ev->seq;
+    hdr.trig_frame = ev->trig_frame;
+    hdr.sample_rate = ev->sample_rate;
+    hdr.pre = ev->pre;
+    hdr.post = ev->post;
+    hdr.frames = ev->frames;
+    hdr.channels = (uint8_t)AD_ACQ_CHANNELS;
+    hdr.trig_ch = ev->trig_ch;
+    hdr.trig_type = ev->trig_type;
+    hdr.os_mode = ev->os_mode;
+    memcpy(hdr.fault_code, ev->fault_code, sizeof(ev->fault_code));
+    const AD7606_CalTable_t *t = AD7606_Cal_Acquire(); /* 只在填表头时持有，写卡期间不占着标定表 */
+    for (uint32_t i = 0; i < AD_ACQ_CHANNELS; i++)
+    {
+        uint32_t phys = AD_Acq_PhysChannel(i);
+        hdr.ch_id[i] = (uint8_t)phys;
+        hdr.scale[i] = fs * t->ch[phys].gain;
+        hdr.offset[i] = t->ch[phys].offset;
+    }
+    AD7606_Cal_Release(t);
+
+    if (AD_Trig_Segments(ev, &seg0, &n0, &seg1, &n1) == 0u)
+        return false;
+    return SD_Wave_SaveEvent(&hdr, seg0, n0 * AD_ACQ_CHANNELS, seg1, n1 * AD_ACQ_CHANNELS);
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD_Trig_Service
+* 功能说明: 触发模块的任务侧维护
+* 形    参: 无
+* 返 回 值: 无
+* 说    明: 标定表版本或采样档位变化时按新系数/新采样率重算门限；把待写盘事件逐个写入 0:/events/<日期>/
+*           写盘失败也释放，避免事件池被占满导致后续故障录不到
+*********************************************************************************************************
+*/
+void AD_Trig_Service(void)
+{
+    AD_TrigEvent_t ev;
+
+    if (AD7606_Cal_Get()->version != s_cfg_cal_ver || AD_Acq_ProfileSeq() != s_cfg_prof_seq)
+    {
+        AD_TrigConfig_t cfg;
+        AD_Trig_GetConfig(&cfg);
+        (void)AD_Trig_SetConfig(&cfg);
+    }
+
+    while (AD_Trig_Acquire(AD_TRIG_CONSUMER_SD, &ev))
+    {
+        bool ok = trig_save_event(&ev);
+        printf("[TRIG] event #%lu %s CH%u %s pre=%lu post=%lu -> SD %s\r\n", (unsigned long)ev.seq,
+               ev.fault_code, (unsigned)ev.trig_ch, AD_Trig_TypeName(ev.trig_type),
+               (unsigned long)ev.pre, (unsigned long)ev.post, ok ? "OK" : "FAIL");
+        AD_Trig_Release(AD_TRIG_CONSUMER_SD, &ev);
+    }
+}
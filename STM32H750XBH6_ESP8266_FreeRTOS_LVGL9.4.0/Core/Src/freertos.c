@@ -41,6 +41,10 @@
 #include "esp8266.h"
 #include "qspi_w25q256.h"
 #include "GUI-Guider_Runtime/gui_assets_sync.h"
+#include "ad_trigger.h"
+#include "ad_decim.h"
+#include "ad_tone.h"
+#include "ad_dsp.h"
 #include <string.h>
 #include <stdio.h>
 
@@ -276,6 +280,23 @@ static int8_t W25Q256_SelfTest_CrossPageAndSector(void)
 
 /* Private variables ---------------------------------------------------------*/
 /* USER CODE BEGIN Variables */
+/* 多速率抽取任务：优先级高于 DSP 与 ESP8266（全速 FFT/上报），保证趋势流在全速路径饱和时也不断流；
+ * 每块计算量约 1ms 以内，且只在有新块时运行 */
+osThreadId_t DecimHandle;
+const osThreadAttr_t Decim_attributes = {
+  .name = "Decim",
+  .stack_size = 512 * 4,
+  .priority = (osPriority_t) osPriorityAboveNormal2,
+};
+/* DSP 任务：由采样块就绪通知唤醒，计算波形/统计量/频谱并发布结果快照；
+ * 独占 AboveNormal1：高于 UI 与 ESP8266（其初始化阶段临时升到 AboveNormal），不与任何任务同级轮转，
+ * FFT 不再与上报状态机分时间片，也不需要在计算中途 osDelay(0) 让出 */
+osThreadId_t DSPHandle;
+const osThreadAttr_t DSP_attributes = {
+  .name = "DSP",
+  .stack_size = 1024 * 4,
+  .priority = (osPriority_t) osPriorityAboveNormal1,
+};
 
 /* USER CODE END Variables */
 /* Definitions for LVGL940 */
@@ -310,6 +331,8 @@ const osThreadAttr_t ESP8266_attributes = {
 /* Private function prototypes -----------------------------------------------*/
 /* USER CODE BEGIN FunctionPrototypes */
 extern const osMutexAttr_t Thread_Mutex_attr;
+void Decim_Task(void *argument);
+void DSP_Task(void *argument);
 
 /* USER CODE END FunctionPrototypes */
 
@@ -378,6 +401,8 @@ void MX_FREERTOS_Init(void) {
 
   /* USER CODE BEGIN RTOS_THREADS */
   /* add threads, ... */
+  DecimHandle = osThreadNew(Decim_Task, NULL, &Decim_attributes);
+  DSPHandle = osThreadNew(DSP_Task, NULL, &DSP_attributes);
   /* USER CODE END RTOS_THREADS */
 
   /* USER CODE BEGIN RTOS_EVENTS */
@@ -523,10 +548,12 @@ void Main_Task(void *argument)
   }
 #endif
 
-  /* Infinite loop */
+  /* Infinite loop：瞬态录波事件写 SD（低优先级，不影响 UI/上报）；纹波跟踪器随档位/标定重算 */
   for(;;)
   {
-    osDelay(1);
+    AD_Trig_Service();
+    AD_Tone_Service();
+    osDelay(20);
   }
   /* USER CODE END Main_Task */
 }
@@ -575,5 +602,32 @@ void ESP8266_Task(void *argument)
 
 /* Private application code --------------------------------------------------*/
 /* USER CODE BEGIN Application */
+/**
+  * @brief  多速率抽取任务：连续消费采样块，产生 MID/TREND 输出流
+  * @param  argument: Not used
+  * @retval None
+  */
+void Decim_Task(void *argument)
+{
+  for(;;)
+  {
+    AD_Decim_Service();
+    osDelay(AD_DECIM_POLL_MS);
+  }
+}
+
+/**
+  * @brief  DSP 任务：等待采样块就绪，计算并发布结果快照
+  * @param  argument: Not used
+  * @retval None
+  */
+void DSP_Task(void *argument)
+{
+  AD_Dsp_TaskInit();
+  for(;;)
+  {
+    AD_Dsp_Service();
+  }
+}
 
 /* USER CODE END Application */
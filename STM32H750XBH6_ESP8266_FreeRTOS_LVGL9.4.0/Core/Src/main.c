@@ -54,7 +54,13 @@
 
 #include "esp8266.h"
 #include "SPI_AD7606.h"
+#include "ad7606_calib.h"
 #include "ad_acq_buffers.h"
+#include "ad_trigger.h"
+#include "ad_decim.h"
+#include "ad_tone.h"
+#include "ad_fault.h"
+#include "ad_arc.h"
 
 /* USER CODE END Includes */
 
@@ -88,8 +94,10 @@ const osMutexAttr_t Thread_Mutex_attr = {
 
 #if USE_AD7606
 static volatile uint8_t g_ad7606_started = 0;
+#if (AD7606_READ_BACKEND == AD7606_BACKEND_SOFT)
 static uint16_t g_ad7606_raw[8];
 #endif
+#endif
 
 /* USER CODE END PV */
 
@@ -170,10 +178,22 @@ int main(void)
   Touch_Init();                            //
 
 #if USE_AD7606
+  AD7606_Cal_Init(); /* 编译期默认标定表；SD 上的表在进入系统界面后加载 */
+  AD_Acq_Init();
+  AD_Trig_Init();
+  AD_Decim_Init();
+  AD_Tone_Init();
+  AD_Fault_Init(); /* 编译期默认规则；SD 上的规则在进入系统界面后加载 */
+  AD_Arc_Init();   /* 电弧检测配置同上 */
   AD7606_Init();
   g_ad7606_started = 0;
 #endif
+#if USE_AD7606 && (AD7606_READ_BACKEND == AD7606_BACKEND_STREAM)
+  /* 零 CPU 流水线：TIM2 改为 PWM 输出 CONVST，不再开更新中断 */
+  AD7606_Stream_Start();
+#else
   HAL_TIM_Base_Start_IT(&htim2);
+#endif
 
   printf("System Start...\r\n");
 
@@ -268,7 +288,23 @@ void SystemClock_Config(void)
 }
 
 /* USER CODE BEGIN 4 */
-
+#if USE_AD7606
+/**
+  * @brief  AD7606 一帧原始码就绪（中断上下文）：原始码直接写入采样块环形缓冲
+  * @note   软件后端在 TIM2 中断内调用；硬件 SPI 后端在 DMA 完成中断内调用
+  *         电压换算/通道修正在消费者侧批量完成（AD_Acq_BlockToVolts）
+  *         采样档位切换后的过渡帧不进入触发判定与纹波跟踪
+  */
+void AD7606_FrameReadyCallback(const uint16_t raw[8])
+{
+  g_ad7606_frames++;
+  if (AD_Acq_PushFrame(raw))
+  {
+    AD_Trig_OnFrame(raw);
+    AD_Tone_OnFrame(raw);
+  }
+}
+#endif
 /* USER CODE END 4 */
 
  /* MPU Configuration */
@@ -336,12 +372,26 @@ void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
   if (htim->Instance == TIM2)
   {
 #if USE_AD7606
+    uint32_t t0 = AD7606_CycNow();
     if (!g_ad7606_started)
     {
       AD7606_StartConv();
       g_ad7606_started = 1;
       return;
     }
+#if (AD7606_READ_BACKEND == AD7606_BACKEND_STREAM)
+    /* 流水线模式下 TIM2 不开更新中断，不会走到这里 */
+    (void)t0;
+#elif (AD7606_READ_BACKEND == AD7606_BACKEND_SPI_DMA)
+    /* 硬件 SPI 后端：TIM2 只负责启动转换，读取由 BUSY 下降沿 -> DMA 完成 */
+    if (READ_AD7606_BUSY || AD7606_SpiDma_Busy())
+    {
+      g_ad7606_miss++;
+      return;
+    }
+    AD7606_StartConv();
+    AD7606_CycAccum(t0);
+#else
     if (READ_AD7606_BUSY)
     {
       g_ad7606_miss++;
@@ -350,43 +400,10 @@ void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
 
     AD7606_ReadRaw8(g_ad7606_raw);
     AD7606_StartConv(); /* 立即启动下一次转换，缩短空档 */
-    g_ad7606_frames++;
-
-    ADS131A04_Buf[0] = AD7606_RawToVoltsF(g_ad7606_raw[0]);
-    ADS131A04_Buf[1] = AD7606_RawToVoltsF(g_ad7606_raw[1]);
-    ADS131A04_Buf[2] = AD7606_RawToVoltsF(g_ad7606_raw[2]) * 465.95f / 473.20f;
-    ADS131A04_Buf[3] = AD7606_RawToVoltsF(g_ad7606_raw[3]);
-
-    if (ADS131A04_flag == 0)
-    {
-      for (uint8_t ch = 0; ch < 4; ch++)
-      {
-        ADSA_B[ch][number] = ADS131A04_Buf[ch];
-      }
-      number++;
-      if (number == AD_ACQ_POINTS)
-      {
-        ADS131A04_flag = 1;
-        ADS131A04_flag2 = 0;
-        number = 0;
-        number2 = 0;
-      }
-    }
-    else if (ADS131A04_flag2 == 0)
-    {
-      for (uint8_t ch = 0; ch < 4; ch++)
-      {
-        ADSA_B2[ch][number2] = ADS131A04_Buf[ch];
-      }
-      number2++;
-      if (number2 == AD_ACQ_POINTS)
-      {
-        ADS131A04_flag2 = 2;
-        ADS131A04_flag = 0;
-        number = 0;
-        number2 = 0;
-      }
-    }
+    AD7606_FrameReadyCallback(g_ad7606_raw);
+    AD7606_CycAccum(t0);
+    AD7606_CycCommit();
+#endif
 #endif
   }
   /* USER CODE END Callback 1 */
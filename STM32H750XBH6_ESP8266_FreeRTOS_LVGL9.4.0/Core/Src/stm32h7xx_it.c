@@ -22,6 +22,7 @@
 #include "stm32h7xx_it.h"
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "SPI_AD7606.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -356,5 +357,33 @@ void MDMA_IRQHandler(void)
 }
 
 /* USER CODE BEGIN 1 */
+#if USE_AD7606 && (AD7606_READ_BACKEND == AD7606_BACKEND_SPI_DMA)
+/**
+  * @brief This function handles EXTI line3 interrupt (AD7606 BUSY falling edge).
+  */
+void EXTI3_IRQHandler(void)
+{
+  __HAL_GPIO_EXTI_CLEAR_IT(AD7606_BUSY_Pin);
+  AD7606_SpiDma_OnBusyFall();
+}
+
+/**
+  * @brief This function handles DMA1 stream4 global interrupt (AD7606 SPI1 RX).
+  */
+void DMA1_Stream4_IRQHandler(void)
+{
+  AD7606_SpiDma_IRQHandler();
+}
+#endif
+
+#if USE_AD7606 && (AD7606_READ_BACKEND == AD7606_BACKEND_STREAM)
+/**
+  * @brief This function handles DMA2 stream0 global interrupt (AD7606 block ring).
+  */
+void DMA2_Stream0_IRQHandler(void)
+{
+  AD7606_Stream_IRQHandler();
+}
+#endif
 
 /* USER CODE END 1 */
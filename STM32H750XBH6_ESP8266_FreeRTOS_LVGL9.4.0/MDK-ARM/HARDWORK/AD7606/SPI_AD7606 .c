@@ -1,11 +1,23 @@
 #include "stm32h7xx_hal.h"
 #include <stdio.h>
 #include "SPI_AD7606.h"
+#include "ad7606_dual.h"
+#include "ad7606_conv.h"
+#include "tim.h"
 #include "Delay.h"
 
 volatile uint32_t g_ad7606_frames = 0;
 volatile uint32_t g_ad7606_miss = 0;
 
+#if AD7606_ISR_PROFILE
+/* 每帧中断耗时统计（CPU 周期） */
+static volatile uint32_t s_cyc_frame = 0;    /* 当前帧累加值 */
+static volatile uint32_t s_cyc_last = 0;
+static volatile uint32_t s_cyc_max = 0;
+static volatile uint32_t s_cyc_sum = 0;      /* 统计窗口内累加 */
+static volatile uint32_t s_cyc_cnt = 0;      /* 统计窗口内帧数 */
+#endif
+
 /*
 *********************************************************************************************************
 * 函 数 名: SPI_Delay
@@ -47,6 +59,19 @@ void AD7606_Init()
 	g_ad7606_frames = 0;
 	g_ad7606_miss = 0;
 
+#if AD7606_ISR_PROFILE
+	/* 0. 使能 DWT 周期计数器（M7 需先解锁 LAR） */
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->LAR = 0xC5ACCE55;
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+	s_cyc_frame = 0;
+	s_cyc_last = 0;
+	s_cyc_max = 0;
+	s_cyc_sum = 0;
+	s_cyc_cnt = 0;
+#endif
+
 	/* 1. 配置STM32的GPIO引脚模式（推挽输出、浮空输入等） */
 	// AD7606_ConfigGPIO(); // 如果此函数在其他地方定义，需取消注释
 
@@ -59,6 +84,17 @@ void AD7606_Init()
 	AD7606_SCLK_H;     // SPI时钟线默认拉高（空闲态为高，CPOL=1）
 	AD7606_CS_H;      // 片选信号拉高，取消选中
 
+#if (AD7606_SERIAL_LINES == 2u)
+	/* 2.1 DOUTB(DB8) 输入脚：与 DOUTA 同端口，双线读取时一次 IDR 取两位 */
+	{
+		GPIO_InitTypeDef GPIO_InitStruct = {0};
+		GPIO_InitStruct.Pin = AD7606_DB8_Pin;
+		GPIO_InitStruct.Mode = GPIO_MODE_INPUT;
+		GPIO_InitStruct.Pull = GPIO_NOPULL;
+		HAL_GPIO_Init(AD7606_DB8_GPIO_Port, &GPIO_InitStruct);
+	}
+#endif
+
 	/* 3. 设置过采样模式 (Oversampling) */
 	/* 默认先全部拉低 */
 	AD7606_OS2_L;
@@ -74,7 +110,15 @@ void AD7606_Init()
 	AD7606_CONVEST_A_H;
 	AD7606_CONVEST_B_H;
 
-	/* 6. 由外部采样调度触发转换 */
+#if (AD7606_READ_BACKEND == AD7606_BACKEND_SPI_DMA)
+	/* 6. 硬件 SPI1 + DMA + BUSY 中断 */
+	AD7606_SpiDma_Init();
+#elif (AD7606_READ_BACKEND == AD7606_BACKEND_STREAM)
+	/* 6. PWM CONVST + DMAMUX 触发链（由 AD7606_Stream_Start 启动） */
+	AD7606_Stream_Init();
+#endif
+
+	/* 7. 由外部采样调度触发转换 */
 }
 
 /*
@@ -94,6 +138,9 @@ void AD7606_Init()
 * |    5    |    32      |    140 μs        |   6.25 kSPS    | 
 * |    6    |    64      |    280 μs        |  3.125 kSPS    |
 *
+* 可达采样率还受读出时间限制：单线每帧 128 SCLK，双线(AD7606_SERIAL_LINES=2)每帧 64 SCLK，
+* 读出时间减半后，同一过采样倍率下转换+读取的总周期更短。
+*
 * 返 回 值: 无
 * 说    明: 通过控制 OS2, OS1, OS0 三个引脚的高低电平组合来选择模式
 *********************************************************************************************************
@@ -144,6 +191,90 @@ void AD7606_SetOS(uint8_t _ucMode)
 	}
 }
 
+/* 各过采样倍率的最大转换时间（ns，数据手册 t_CONV 上限） */
+static const uint32_t s_conv_ns[7] = {4150u, 9100u, 18800u, 39000u, 78000u, 158000u, 315000u};
+
+uint32_t AD7606_ConvTimeNs(uint8_t os_mode)
+{
+	return (os_mode < 7u) ? s_conv_ns[os_mode] : s_conv_ns[0];
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD7606_SampleTickHz
+* 功能说明: 取 TIM2 计数频率（定时器内核时钟 / (PSC+1)）
+* 返 回 值: Hz
+* 说    明: APB1 分频不为 1 时定时器时钟为 PCLK1 的 2 倍（TIMPRE=0）
+*********************************************************************************************************
+*/
+uint32_t AD7606_SampleTickHz(void)
+{
+	uint32_t clk = HAL_RCC_GetPCLK1Freq();
+	if ((RCC->D2CFGR & RCC_D2CFGR_D2PPRE1) != RCC_D2CFGR_D2PPRE1_DIV1)
+	{
+		clk *= 2u;
+	}
+	return clk / (TIM2->PSC + 1u);
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD7606_TimingPrepare
+* 功能说明: 把 目标采样率 + 过采样倍率 换算成定时器参数，并检查能否跑得下
+* 形    参: rate_hz : 目标采样率
+*           os_mode : 0..6
+*           t       : 输出
+* 返 回 值: 1=可行，0=参数越界或 转换+读出 超过采样周期
+* 说    明: 预分频保持不变，只改 ARR；实际采样率按整数分频取最接近值（见 t->rate_hz）。
+*           STREAM 后端 TIM4 为 16 位，ARR 上限统一取 0xFFFF。
+*********************************************************************************************************
+*/
+uint8_t AD7606_TimingPrepare(uint32_t rate_hz, uint8_t os_mode, AD7606_Timing_t *t)
+{
+	if (t == NULL || rate_hz == 0u || os_mode > 6u)
+	{
+		return 0;
+	}
+	uint32_t tick = AD7606_SampleTickHz();
+	uint32_t div = (tick + rate_hz / 2u) / rate_hz;
+	if (div < 2u || div > 0x10000u)
+	{
+		return 0;
+	}
+	t->arr = div - 1u;
+	t->rate_hz = (tick + div / 2u) / div;
+	t->os_mode = os_mode;
+
+	uint32_t period_ns = (uint32_t)(((uint64_t)div * 1000000000ull) / tick);
+	return (AD7606_ConvTimeNs(os_mode) + AD7606_READOUT_NS < period_ns) ? 1u : 0u;
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD7606_TimingApply
+* 功能说明: 写入采样周期与过采样引脚
+* 形    参: t : AD7606_TimingPrepare 的输出
+* 说    明: 可在采样中断里调用。ARR 开预装载（TIM2 是 32 位计数器，直接改小可能让 CNT 越过 ARR 一整圈）；
+*           过采样引脚在 BUSY 下降沿后才被芯片采样，正在进行的转换不受影响。
+*           切换后的首帧可能按旧参数转换，由上层丢弃过渡帧。
+*********************************************************************************************************
+*/
+void AD7606_TimingApply(const AD7606_Timing_t *t)
+{
+	if (t == NULL)
+	{
+		return;
+	}
+	TIM2->CR1 |= TIM_CR1_ARPE;
+	TIM2->ARR = t->arr;
+	htim2.Init.Period = t->arr;
+	htim2.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_ENABLE;
+#if (AD7606_READ_BACKEND == AD7606_BACKEND_STREAM)
+	AD7606_Stream_SetPeriod(t->arr);
+#endif
+	AD7606_SetOS(t->os_mode);
+}
+
 static uint16_t AD7606_Read16(void)
 {
 	uint16_t v = 0;
@@ -162,18 +293,56 @@ static uint16_t AD7606_Read16(void)
 	return v;
 }
 
+#if (AD7606_SERIAL_LINES == 2u)
+/*
+*********************************************************************************************************
+* 函 数 名: AD7606_ReadRaw8Dual
+* 功能说明: 双线串行读取：DOUTA 依次移出 V1~V4，DOUTB 同时移出 V5~V8
+* 形    参: raw : 输出 8 通道原始码
+* 返 回 值: 无
+* 说    明: 每个 SCLK 低电平期间只读一次 IDR，一帧 64 个 SCLK（单线为 128）；
+*           时钟循环只存 IDR，拆位与通道排序在 AD7606_DualDeinterleave（ad7606_dual.h）
+*********************************************************************************************************
+*/
+static void AD7606_ReadRaw8Dual(uint16_t raw[8])
+{
+	uint16_t idr[AD7606_DUAL_SCLKS];
+
+	for (uint32_t k = 0; k < AD7606_DUAL_SCLKS; k++)
+	{
+		AD7606_SCLK_L;
+		SPI_Delay();
+		idr[k] = (uint16_t)READ_AD7606_DOUT_IDR;
+		AD7606_SCLK_H;
+		SPI_Delay();
+	}
+	AD7606_DualDeinterleave(idr, AD7606_DB7_Pin, AD7606_DB8_Pin, raw);
+}
+#endif
+
 void AD7606_ReadRaw8(uint16_t raw[8])
 {
 	if (!raw)
 	{
 		return;
 	}
+#if (AD7606_READ_BACKEND == AD7606_BACKEND_SPI_DMA)
+	AD7606_SpiDma_ReadPolled(raw);
+#elif (AD7606_READ_BACKEND == AD7606_BACKEND_STREAM)
+	/* 流水线模式下总线由 DMA 独占，返回最近一帧 */
+	AD7606_Stream_ReadLatest(raw);
+#elif (AD7606_SERIAL_LINES == 2u)
+	AD7606_CS_L;
+	AD7606_ReadRaw8Dual(raw);
+	AD7606_CS_H;
+#else
 	AD7606_CS_L;
 	for (uint8_t i = 0; i < 8; i++)
 	{
 		raw[i] = AD7606_Read16();
 	}
 	AD7606_CS_H;
+#endif
 }
 
 /*
@@ -378,10 +547,39 @@ double AD7606_RawToVolts(uint16_t raw)
 
 float AD7606_RawToVoltsF(uint16_t raw)
 {
-	const int16_t code = AD7606_RawToS16(raw);
-	const float fs_v = AD7606_GetFullScaleVolts();
-	const float vin_adc_v = ((float)code * fs_v) / 32768.0f;
-	return vin_adc_v / AD7606_FRONTEND_GAIN;
+	return AD7606_ConvCodeToVoltsF(AD7606_RawToS16(raw), AD7606_GetFullScaleVolts(), AD7606_FRONTEND_GAIN);
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD7606_RawBlockToVoltsF
+* 功能说明: 批量把原始码换算为工程量：dst = (code - offset) * 满量程/32768 / 前端增益 * gain
+* 形    参: src    : 原始码（16bit 两补码）
+*           dst    : 输出
+*           n      : 点数
+*           gain   : 通道增益（传感器/分压系数，1.0 = 输出 ADC 输入端电压）
+*           offset : 零点（原始码，可为小数）
+* 返 回 值: 无
+* 说    明: 按当前量程调用 AD7606_ConvBlockToVoltsF（ad7606_conv.c，8 点展开、每点一次乘加）
+*********************************************************************************************************
+*/
+void AD7606_RawBlockToVoltsF(const int16_t *src, float *dst, uint32_t n, float gain, float offset)
+{
+	AD7606_ConvBlockToVoltsF(src, dst, n, AD7606_GetFullScaleVolts(), AD7606_FRONTEND_GAIN, gain, offset);
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD7606_RawBlockToQ15
+* 功能说明: 批量扣零点并按增益缩放为 q15（1.0 = AD7606 满量程）
+* 形    参: src/dst/n 同上；gain : 额外增益；offset : 零点（原始码，四舍五入到整数 LSB）
+* 返 回 值: 无
+* 说    明: 见 AD7606_ConvBlockToQ15（ad7606_conv.c，arm_offset_q15 + arm_scale_q15，饱和输出）
+*********************************************************************************************************
+*/
+void AD7606_RawBlockToQ15(const int16_t *src, int16_t *dst, uint32_t n, float gain, float offset)
+{
+	AD7606_ConvBlockToQ15(src, dst, n, gain, offset);
 }
 
 void AD7606_GetStats(uint32_t *frames, uint32_t *miss)
@@ -392,3 +590,100 @@ void AD7606_GetStats(uint32_t *frames, uint32_t *miss)
 	if (miss) *miss = g_ad7606_miss;
 	__set_PRIMASK(primask);
 }
+
+void AD7606_GetStatsEx(AD7606_Stats_t *st)
+{
+	if (!st)
+	{
+		return;
+	}
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	st->frames = g_ad7606_frames;
+	st->miss = g_ad7606_miss;
+#if AD7606_ISR_PROFILE
+	st->isr_cyc_last = s_cyc_last;
+	st->isr_cyc_max = s_cyc_max;
+	st->isr_cyc_avg = (s_cyc_cnt > 0u) ? (s_cyc_sum / s_cyc_cnt) : 0u;
+	/* 平均值按“两次查询之间”的窗口统计，读取后清零窗口 */
+	s_cyc_sum = 0;
+	s_cyc_cnt = 0;
+#else
+	st->isr_cyc_last = 0;
+	st->isr_cyc_max = 0;
+	st->isr_cyc_avg = 0;
+#endif
+	__set_PRIMASK(primask);
+
+#if (AD7606_READ_BACKEND == AD7606_BACKEND_STREAM)
+	AD7606_Stream_GetJitter(&st->jitter_pp_ns, &st->jitter_rms_ns);
+#else
+	st->jitter_pp_ns = 0;
+	st->jitter_rms_ns = 0;
+#endif
+}
+
+#if AD7606_ISR_PROFILE
+/*
+*********************************************************************************************************
+* 函 数 名: AD7606_CycAccum / AD7606_CycCommit
+* 功能说明: 累加当前帧的中断耗时 / 帧结束时提交统计
+* 形    参: t0 : 进入中断时的 AD7606_CycNow() 值
+* 返 回 值: 无
+* 说    明: 只在中断上下文调用（TIM2/EXTI/DMA 同优先级，互不抢占），无需关中断
+*********************************************************************************************************
+*/
+void AD7606_CycAccum(uint32_t t0)
+{
+	s_cyc_frame += (DWT->CYCCNT - t0);
+}
+
+void AD7606_CycCommit(void)
+{
+	uint32_t c = s_cyc_frame;
+	s_cyc_frame = 0;
+	s_cyc_last = c;
+	if (c > s_cyc_max)
+	{
+		s_cyc_max = c;
+	}
+	/* 窗口累加防溢出：最多累计 65536 帧 */
+	if (s_cyc_cnt < 65536u)
+	{
+		s_cyc_sum += c;
+		s_cyc_cnt++;
+	}
+}
+#endif
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD7606_FrameReadyCallback
+* 功能说明: 一帧（8通道）原始码读取完成回调（弱定义）
+* 形    参: raw : 8 通道原始码
+* 返 回 值: 无
+* 说    明: 在中断上下文中调用，由采样调度层重写
+*********************************************************************************************************
+*/
+__weak void AD7606_FrameReadyCallback(const uint16_t raw[8])
+{
+	(void)raw;
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD7606_BlockReadyCallback
+* 功能说明: 一块（多帧）原始码就绪回调（弱定义）
+* 形    参: frames  : 帧数组，每帧 8 通道
+*           nframes : 帧数
+* 返 回 值: 无
+* 说    明: 默认逐帧转调 AD7606_FrameReadyCallback，保持与单帧后端一致的上层处理
+*********************************************************************************************************
+*/
+__weak void AD7606_BlockReadyCallback(const uint16_t (*frames)[8], uint32_t nframes)
+{
+	for (uint32_t i = 0; i < nframes; i++)
+	{
+		AD7606_FrameReadyCallback(frames[i]);
+	}
+}
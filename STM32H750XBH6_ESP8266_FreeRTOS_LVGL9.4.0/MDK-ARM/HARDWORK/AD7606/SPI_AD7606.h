@@ -27,6 +27,44 @@
 #define AD7606_OS_MODE (3u)
 #endif
 
+/* ==========================================
+ * 读出后端选择（编译期）
+ * - AD7606_BACKEND_SOFT   : 软件模拟 SPI（PE5 SCLK + PA0 DOUTA），在 TIM2 ISR 内逐位读取
+ * - AD7606_BACKEND_SPI_DMA: 硬件 SPI1 + DMA，BUSY 下降沿(EXTI3)启动，8 通道直接搬运到 AXI SRAM
+ *   （需要把 SCLK 跳线到 PA5(SPI1_SCK)、DOUTA 跳线到 PA6(SPI1_MISO)，见文件末尾连线说明）
+ * - AD7606_BACKEND_STREAM : 零 CPU 采样流水线：TIM2/TIM4 PWM 直接输出 CONVST，
+ *   BUSY 下降沿经 DMAMUX 请求发生器触发 SPI1 读取，DMA 填充环形多帧缓冲，每块只中断一次
+ * ========================================== */
+#define AD7606_BACKEND_SOFT     (0u)
+#define AD7606_BACKEND_SPI_DMA  (1u)
+#define AD7606_BACKEND_STREAM   (2u)
+
+#ifndef AD7606_READ_BACKEND
+#define AD7606_READ_BACKEND AD7606_BACKEND_SOFT
+#endif
+
+/* 串行数据线数（仅软件后端）
+ * - 1: 只用 DOUTA，8 通道串行移出，每帧 128 个 SCLK
+ * - 2: DOUTA 输出 V1~V4、DOUTB 输出 V5~V8，同一 SCLK 边沿一次读 IDR 取两位，每帧 64 个 SCLK
+ *   DOUTB(DB8) 需接到与 DOUTA 同一端口（默认 PA1），才能一次 IDR 读到两条线 */
+#ifndef AD7606_SERIAL_LINES
+#define AD7606_SERIAL_LINES (1u)
+#endif
+
+#if (AD7606_SERIAL_LINES == 2u) && (AD7606_READ_BACKEND != AD7606_BACKEND_SOFT)
+#error "AD7606_SERIAL_LINES=2 仅支持软件后端（硬件后端只接了一路 SPI MISO）"
+#endif
+
+#ifndef AD7606_DB8_Pin
+#define AD7606_DB8_Pin GPIO_PIN_1
+#define AD7606_DB8_GPIO_Port GPIOA
+#endif
+
+/* ISR 周期计数（DWT->CYCCNT）：1=统计每帧采样中断耗时，用于对比不同后端的 CPU 占用 */
+#ifndef AD7606_ISR_PROFILE
+#define AD7606_ISR_PROFILE 1
+#endif
+
 /* * 获取满量程电压范围
  * AD7606 的 Range 引脚决定输入范围是 ±5V 还是 ±10V。
  * 当设置为 ±10V 范围时，相当于内部基准的 4 倍 (4 * 2.5V = 10V)。
@@ -82,6 +120,9 @@ static inline float AD7606_GetFullScaleVolts(void)
  */
 #define READ_AD7606_DB7       ((AD7606_DB7_GPIO_Port->IDR & AD7606_DB7_Pin) || 0)
 
+/* * 双线模式：DB7(DOUTA) 与 DB8(DOUTB) 在同一端口，一次读取整个 IDR，再分别取位 */
+#define READ_AD7606_DOUT_IDR  (AD7606_DB7_GPIO_Port->IDR)
+
 /* * 读取 BUSY 状态引脚
  * BUSY 为高电平时表示正在转换，低电平时表示转换完成，可以读取数据。
  */
@@ -134,12 +175,107 @@ void AD7606_Scan(uint16_t * DB_data);
  */
 void AD7606_SetOS(uint8_t _ucMode);
 
-/* 读取8通道原始数据（串行模式，DOUTA） */
+/* ==========================================
+ * 运行期切换采样率/过采样倍率
+ * - AD7606_TimingPrepare: 任务上下文，按 TIM2 计数时钟换算 ARR，并检查 转换时间 + 读出时间 < 采样周期
+ * - AD7606_TimingApply  : 可在采样中断里调用，只写寄存器；ARR 开预装载，从下一个更新事件起生效
+ * ========================================== */
+
+/* 每帧读出 + 中断处理的预留时间（ns），仅用于可行性检查 */
+#ifndef AD7606_READOUT_NS
+#if (AD7606_READ_BACKEND == AD7606_BACKEND_SOFT)
+#define AD7606_READOUT_NS (20000u / AD7606_SERIAL_LINES)
+#else
+#define AD7606_READOUT_NS (6000u)
+#endif
+#endif
+
+typedef struct
+{
+	uint32_t arr;      /* TIM2（STREAM 后端同时 TIM4）自动重装值 */
+	uint32_t rate_hz;  /* 实际采样率 = 计数时钟 / (arr + 1) */
+	uint8_t os_mode;   /* 0..6 */
+} AD7606_Timing_t;
+
+uint32_t AD7606_ConvTimeNs(uint8_t os_mode);                  /* 过采样倍率对应的最大转换时间 */
+uint32_t AD7606_SampleTickHz(void);                            /* TIM2 计数时钟（预分频之后） */
+uint8_t AD7606_TimingPrepare(uint32_t rate_hz, uint8_t os_mode, AD7606_Timing_t *t); /* 1=可行 */
+void AD7606_TimingApply(const AD7606_Timing_t *t);
+
+/* 读取8通道原始数据（串行模式，DOUTA；AD7606_SERIAL_LINES=2 时 DOUTA+DOUTB） */
 void AD7606_ReadRaw8(uint16_t raw[8]);
 
 /* 运行期统计 */
 void AD7606_GetStats(uint32_t *frames, uint32_t *miss);
 
+/* 扩展统计（含每帧中断耗时，单位：CPU 周期） */
+typedef struct
+{
+    uint32_t frames;       /* 已完成帧数 */
+    uint32_t miss;         /* 丢帧数（TIM2 到来时上一帧仍未完成） */
+    uint32_t isr_cyc_last; /* 最近一帧的中断总耗时 */
+    uint32_t isr_cyc_max;  /* 启动以来单帧最大耗时 */
+    uint32_t isr_cyc_avg;  /* 最近一次统计窗口内的平均耗时 */
+    uint32_t jitter_pp_ns; /* 采样时钟抖动峰峰值（仅 STREAM 后端，按 BUSY 下降沿时间戳统计） */
+    uint32_t jitter_rms_ns;/* 采样时钟抖动均方根（同上，统计窗口同 isr_cyc_avg） */
+} AD7606_Stats_t;
+
+void AD7606_GetStatsEx(AD7606_Stats_t *st);
+
+/* ==========================================
+ * ISR 耗时统计（DWT 周期计数器）
+ * 用法：t0 = AD7606_CycNow(); ...; AD7606_CycAccum(t0);  一帧结束时 AD7606_CycCommit()
+ * 说明：DMA 后端一帧横跨 TIM2/EXTI/DMA 三个中断，因此先累加再在帧结束时提交。
+ * ========================================== */
+#if AD7606_ISR_PROFILE
+static inline uint32_t AD7606_CycNow(void)
+{
+    return DWT->CYCCNT;
+}
+void AD7606_CycAccum(uint32_t t0);
+void AD7606_CycCommit(void);
+#else
+static inline uint32_t AD7606_CycNow(void)
+{
+    return 0u;
+}
+#define AD7606_CycAccum(t0) ((void)(t0))
+#define AD7606_CycCommit()  ((void)0)
+#endif
+
+/* 帧就绪回调：后端读完 8 通道原始码后调用（中断上下文）。
+ * 驱动内为弱定义，由采样调度层（main.c）重写。 */
+void AD7606_FrameReadyCallback(const uint16_t raw[8]);
+
+#if (AD7606_READ_BACKEND == AD7606_BACKEND_SPI_DMA)
+/* 硬件 SPI1 + DMA 后端（ad7606_spi_dma.c） */
+void AD7606_SpiDma_Init(void);
+void AD7606_SpiDma_ReadPolled(uint16_t raw[8]);  /* 轮询读一帧（非中断路径，如 AD7606_Scan） */
+uint8_t AD7606_SpiDma_Busy(void);                /* 1=上一帧 DMA 读取尚未完成 */
+void AD7606_SpiDma_OnBusyFall(void);             /* EXTI3(BUSY 下降沿) 中调用 */
+void AD7606_SpiDma_IRQHandler(void);             /* DMA1_Stream4 中断中调用 */
+#endif
+
+/* 块就绪回调：STREAM 后端每凑满一块（半个环形缓冲）调用一次（中断上下文）。
+ * 弱定义默认逐帧转调 AD7606_FrameReadyCallback()，采样调度层可按需整块重写。 */
+void AD7606_BlockReadyCallback(const uint16_t (*frames)[8], uint32_t nframes);
+
+#if (AD7606_READ_BACKEND == AD7606_BACKEND_STREAM)
+/* 每块帧数（环形缓冲共 2 块，半满/全满各中断一次） */
+#ifndef AD7606_STREAM_BLOCK_FRAMES
+#define AD7606_STREAM_BLOCK_FRAMES (64u)
+#endif
+
+/* 零 CPU 采样流水线（ad7606_stream.c） */
+void AD7606_Stream_Init(void);
+void AD7606_Stream_Start(void);                  /* 启动 PWM/DMA，替代 HAL_TIM_Base_Start_IT(&htim2) */
+void AD7606_Stream_Stop(void);
+void AD7606_Stream_ReadLatest(uint16_t raw[8]);  /* 取最近一帧（非阻塞） */
+void AD7606_Stream_GetJitter(uint32_t *pp_ns, uint32_t *rms_ns); /* 读取并清零统计窗口 */
+void AD7606_Stream_IRQHandler(void);             /* DMA2_Stream0 中断中调用 */
+void AD7606_Stream_SetPeriod(uint32_t arr);      /* 同步 TIM4 周期与抖动统计的名义周期（中断上下文可调用） */
+#endif
+
 /* ==========================================
  * 原始码值 -> 电压换算（单位：V）
  * ========================================== */
@@ -153,6 +289,13 @@ double AD7606_RawToVolts(uint16_t raw);
 /* float 版本（减少双精度开销） */
 float AD7606_RawToVoltsF(uint16_t raw);
 
+/* 批量换算（消费者侧，任务上下文），offset 为零点（原始码）：
+ * - VoltsF: dst[i] = (code - offset) * 满量程/32768 / 前端增益 * gain
+ * - Q15   : 原始码本身即 q15（1.0 = 满量程），扣零点并按 gain 缩放后输出，供 q15 DSP 直接使用
+ * 各通道的 gain/offset 由标定表提供（见 ad7606_calib.h） */
+void AD7606_RawBlockToVoltsF(const int16_t *src, float *dst, uint32_t n, float gain, float offset);
+void AD7606_RawBlockToQ15(const int16_t *src, int16_t *dst, uint32_t n, float gain, float offset);
+
 /* 统计计数器（由采样调度层更新） */
 extern volatile uint32_t g_ad7606_frames;
 extern volatile uint32_t g_ad7606_miss;
@@ -182,7 +325,28 @@ DOUTA(DB7)   : PA0  -> DOUTA（串行数据输出，作为 MISO 读取）
 2) 量程固定：硬件已固定为 ±10V（RANGE 未由 MCU 控制/已移除相关引脚）
 
 // 说明
-- 本工程当前未使用：STBY、FRSTDATA、RD、DOUTB(DB8) 等引脚（若你的硬件接了也不影响本驱动）。
+- 本工程当前未使用：STBY、FRSTDATA、RD 等引脚（若你的硬件接了也不影响本驱动）。
+- DOUTB(DB8) 仅在 AD7606_SERIAL_LINES=2 时使用：PA1 -> DOUTB（与 DOUTA 同为 GPIOA）。
+
+// 硬件 SPI + DMA 后端（AD7606_READ_BACKEND = AD7606_BACKEND_SPI_DMA）
+SCLK         : PA5  -> SCLK   （SPI1_SCK, AF5；原 PE5 不再使用）
+DOUTA(DB7)   : PA6  -> DOUTA  （SPI1_MISO, AF5；原 PA0 不再使用）
+BUSY         : PC3  -> BUSY   （EXTI3 下降沿启动 DMA 读取）
+CS           : PB6  -> CS     （仍由 GPIO 控制）
+DMA          : DMA1_Stream4 <- DMAMUX SPI1_RX，目标缓冲在 AXI SRAM（32 字节对齐）
+
+// 零 CPU 采样流水线（AD7606_READ_BACKEND = AD7606_BACKEND_STREAM）
+CONVST_A     : PB3  -> CONVST A （TIM2_CH2 PWM, AF1）
+CONVST_B     : PB9  -> CONVST B （TIM4_CH4 PWM, AF2；TIM4 从模式复位于 TIM2 TRGO，两路同相）
+SCLK         : PA5  -> SCLK     （SPI1_SCK, AF5）
+DOUTA(DB7)   : PA6  -> DOUTA    （SPI1_MISO, AF5）
+CS           : PA4  -> CS       （SPI1_NSS 硬件输出, AF5；原 PB6 不再使用）
+BUSY         : PB0  -> BUSY     （EXTI0 -> DMAMUX 请求发生器；DMAMUX1 只支持 EXTI0 作为触发源，
+                                   PC3 可保留并联，仅作 READ_AD7606_BUSY 查询）
+DMA          : DMA2_Stream0 <- SPI1_RX（环形多帧缓冲，半满/全满中断）
+               DMA2_Stream1 <- 请求发生器0：依次写 SPI1->CR1（关 SPE -> 开 SPE -> CSTART）
+               DMA2_Stream2 <- 请求发生器1：清 EXTI0 挂起位，使下一次下降沿能再次触发
+               DMA2_Stream3 <- 请求发生器2：抓取 TIM5->CNT（240MHz 自由计数）作为每帧时间戳
 */
 
 #endif
@@ -0,0 +1,474 @@
+#include "ad7606_calib.h"
+#include "SPI_AD7606.h"
+#include "SD.h"
+#include "ff.h"
+#include "ad_atomic.h"
+#include "cmsis_os.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * 标定表双缓冲（与 AD_Dsp_ClaimSlot 同一套读者计数）：
+ *   读者：AD7606_Cal_Acquire 给当前表 readers+1，再复查 s_cal_active 未变才算持有，用完 Release；
+ *   写者（重载/学习零点）：切换 s_cal_active 之后，旧表成为备用表；下一次写之前先等备用表 readers==0
+ *   （新读者复查时已看到新表，不会再持有旧表），再把当前表复制过去、修改、DMB 后切换。
+ *   等不到（读者持有超过 CAL_SPARE_WAIT_MS）就放弃本次修改，返回 false。
+ * 写者之间用 s_cal_writing 互斥（PRIMASK 保护的测试-置位），拿不到直接返回 false。
+ */
+
+#define AD7606_CAL_TMP_FILE "0:/config/.ad_calib.cfg.tmp"
+
+/* 写者等待旧表读者退出的上限（读者只在换算一块/编译门限期间持有，毫秒级） */
+#define CAL_SPARE_WAIT_MS 200u
+
+static AD7606_CalTable_t s_cal[2];
+static AD7606_CalTable_t *volatile s_cal_active = &s_cal[0];
+static acq_atomic_t s_cal_readers[2];
+static volatile uint8_t s_cal_writing = 0;
+
+static bool cal_begin_write(void)
+{
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	bool ok = (s_cal_writing == 0u);
+	if (ok)
+	{
+		s_cal_writing = 1u;
+	}
+	__set_PRIMASK(primask);
+	return ok;
+}
+
+/* 取备用表并以当前表为底稿；仍有读者持有备用表（上一次切换前取到的旧表）时等其释放，超时返回 NULL */
+static AD7606_CalTable_t *cal_spare(void)
+{
+	AD7606_CalTable_t *cur = s_cal_active;
+	uint32_t idx = (cur == &s_cal[0]) ? 1u : 0u;
+	uint32_t t0 = HAL_GetTick();
+
+	ACQ_FENCE(); /* s_cal_active 的切换先于下面读 readers，与 Acquire 的 “+1 后复查” 配对 */
+	while (ACQ_LOAD(&s_cal_readers[idx]) != 0u)
+	{
+		if ((HAL_GetTick() - t0) >= CAL_SPARE_WAIT_MS)
+		{
+			return NULL;
+		}
+		osDelay(1);
+	}
+	memcpy(&s_cal[idx], cur, sizeof(s_cal[idx]));
+	return &s_cal[idx];
+}
+
+static void cal_commit(AD7606_CalTable_t *t)
+{
+	t->version = s_cal_active->version + 1u;
+	__DMB();
+	s_cal_active = t;
+	__DMB();
+	s_cal_writing = 0u;
+}
+
+static void cal_abort(void)
+{
+	s_cal_writing = 0u;
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD7606_Cal_Init
+* 功能说明: 装载编译期默认标定表
+* 形    参: 无
+* 返 回 值: 无
+* 说    明: 通道 2（负载电流）保留原固件的实测修正系数 465.95/473.20
+*********************************************************************************************************
+*/
+void AD7606_Cal_Init(void)
+{
+	AD7606_CalTable_t *t = &s_cal[0];
+
+	memset(s_cal, 0, sizeof(s_cal));
+	for (uint32_t ch = 0; ch < AD7606_CAL_CHANNELS; ch++)
+	{
+		t->ch[ch].gain = 1.0f;
+		t->ch[ch].offset = 0.0f;
+	}
+	t->ch[2].gain = 465.95f / 473.20f;
+	t->version = 1u;
+	s_cal_active = t;
+	ACQ_STORE(&s_cal_readers[0], 0u);
+	ACQ_STORE(&s_cal_readers[1], 0u);
+	s_cal_writing = 0u;
+}
+
+const AD7606_CalTable_t *AD7606_Cal_Get(void)
+{
+	return s_cal_active;
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD7606_Cal_Acquire
+* 功能说明: 持有当前标定表
+* 形    参: 无
+* 返 回 值: 当前表（持有期间写者不会改写它）
+* 说    明: readers+1 后复查 s_cal_active：期间发生过切换就退回重取，保证持有的表不会被选作备用表
+*********************************************************************************************************
+*/
+const AD7606_CalTable_t *AD7606_Cal_Acquire(void)
+{
+	for (;;)
+	{
+		AD7606_CalTable_t *t = s_cal_active;
+		uint32_t idx = (t == &s_cal[0]) ? 0u : 1u;
+		ACQ_ADD(&s_cal_readers[idx], 1u);
+		ACQ_FENCE();
+		if (s_cal_active == t)
+		{
+			return t;
+		}
+		ACQ_SUB(&s_cal_readers[idx], 1u);
+	}
+}
+
+void AD7606_Cal_Release(const AD7606_CalTable_t *t)
+{
+	if (t == &s_cal[0] || t == &s_cal[1])
+	{
+		ACQ_SUB(&s_cal_readers[(t == &s_cal[0]) ? 0u : 1u], 1u);
+	}
+}
+
+static void cal_rstrip(char *s)
+{
+	size_t n = strlen(s);
+	while (n > 0 && (s[n - 1] == '\r' || s[n - 1] == '\n' || s[n - 1] == ' ' || s[n - 1] == '\t'))
+	{
+		s[--n] = '\0';
+	}
+}
+
+static bool cal_parse_float(const char *s, float *out)
+{
+	char *end = NULL;
+	float v = strtof(s, &end);
+	if (end == s || v != v)
+	{
+		return false;
+	}
+	*out = v;
+	return true;
+}
+
+/* "x0:y0,x1:y1,..."，x 必须严格递增；格式错误时整条忽略 */
+static bool cal_parse_pwl(const char *s, AD7606_CalChannel_t *c)
+{
+	float x[AD7606_CAL_PWL_POINTS];
+	float y[AD7606_CAL_PWL_POINTS];
+	uint32_t n = 0;
+
+	while (*s)
+	{
+		char *end = NULL;
+		if (n >= AD7606_CAL_PWL_POINTS)
+		{
+			return false;
+		}
+		x[n] = strtof(s, &end);
+		if (end == s || *end != ':')
+		{
+			return false;
+		}
+		s = end + 1;
+		y[n] = strtof(s, &end);
+		if (end == s)
+		{
+			return false;
+		}
+		if (n > 0u && !(x[n] > x[n - 1u]))
+		{
+			return false;
+		}
+		n++;
+		s = end;
+		while (*s == ',' || *s == ' ' || *s == '\t')
+		{
+			s++;
+		}
+	}
+	if (n == 1u)
+	{
+		return false;
+	}
+	c->pwl_n = (uint8_t)n;
+	memcpy(c->pwl_x, x, n * sizeof(float));
+	memcpy(c->pwl_y, y, n * sizeof(float));
+	return true;
+}
+
+static void cal_parse_line(AD7606_CalTable_t *t, char *line)
+{
+	/* CHn_KEY=VALUE */
+	if (line[0] != 'C' || line[1] != 'H' || line[2] < '0' || line[2] > '7' || line[3] != '_')
+	{
+		return;
+	}
+	AD7606_CalChannel_t *c = &t->ch[line[2] - '0'];
+	char *key = line + 4;
+	char *val = strchr(key, '=');
+	if (!val)
+	{
+		return;
+	}
+	*val++ = '\0';
+	while (*val == ' ' || *val == '\t')
+	{
+		val++;
+	}
+
+	if (strcmp(key, "GAIN") == 0)
+	{
+		(void)cal_parse_float(val, &c->gain);
+	}
+	else if (strcmp(key, "OFFSET") == 0)
+	{
+		(void)cal_parse_float(val, &c->offset);
+	}
+	else if (strcmp(key, "UNIT") == 0)
+	{
+		strncpy(c->unit, val, sizeof(c->unit) - 1);
+		c->unit[sizeof(c->unit) - 1] = '\0';
+	}
+	else if (strcmp(key, "PWL") == 0)
+	{
+		if (val[0] == '\0')
+		{
+			c->pwl_n = 0;
+		}
+		else
+		{
+			(void)cal_parse_pwl(val, c);
+		}
+	}
+}
+
+static bool cal_sd_ready(void)
+{
+	/* 避免与 QSPI/SD 同步竞争（该标志在 GUI_Assets_SyncFromSD 期间置位） */
+	extern volatile uint8_t g_qspi_sd_sync_in_progress;
+	if (g_qspi_sd_sync_in_progress)
+	{
+		return false;
+	}
+	return (SD_Init() == FR_OK);
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD7606_Cal_LoadFromSD
+* 功能说明: 从 SD 读取标定表并切换为当前表
+* 形    参: 无
+* 返 回 值: true=已加载
+* 说    明: 以当前表为底稿，文件中出现的项才覆盖；可在运行中反复调用
+*********************************************************************************************************
+*/
+bool AD7606_Cal_LoadFromSD(void)
+{
+	FIL fil;
+	char line[160];
+
+	if (!cal_sd_ready())
+	{
+		return false;
+	}
+	if (f_open(&fil, AD7606_CAL_FILE, FA_READ) != FR_OK)
+	{
+		return false;
+	}
+	if (!cal_begin_write())
+	{
+		(void)f_close(&fil);
+		return false;
+	}
+
+	AD7606_CalTable_t *t = cal_spare();
+	if (t == NULL)
+	{
+		cal_abort();
+		(void)f_close(&fil);
+		printf("[CAL] %s: table still in use, reload skipped\r\n", AD7606_CAL_FILE);
+		return false;
+	}
+	while (f_gets(line, sizeof(line), &fil))
+	{
+		cal_rstrip(line);
+		if (line[0] == '#' || line[0] == '\0')
+		{
+			continue;
+		}
+		cal_parse_line(t, line);
+	}
+	(void)f_close(&fil);
+
+	cal_commit(t);
+	printf("[CAL] loaded %s (v%lu)\r\n", AD7606_CAL_FILE, (unsigned long)t->version);
+	return true;
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD7606_Cal_SaveToSD
+* 功能说明: 把当前标定表写回 SD
+* 形    参: 无
+* 返 回 值: true=成功
+* 说    明: 先写临时文件，再删旧文件并 rename，掉电时最多丢失本次修改
+*********************************************************************************************************
+*/
+bool AD7606_Cal_SaveToSD(void)
+{
+	FIL fil;
+	char buf[200];
+	UINT bw = 0;
+	bool ok = true;
+
+	if (!cal_sd_ready())
+	{
+		return false;
+	}
+	(void)SD_MkdirRecursive("0:/config");
+	if (f_open(&fil, AD7606_CAL_TMP_FILE, FA_CREATE_ALWAYS | FA_WRITE) != FR_OK)
+	{
+		return false;
+	}
+
+	const AD7606_CalTable_t *t = AD7606_Cal_Acquire();
+	for (uint32_t ch = 0; ch < AD7606_CAL_CHANNELS && ok; ch++)
+	{
+		const AD7606_CalChannel_t *c = &t->ch[ch];
+		int n = snprintf(buf, sizeof(buf), "CH%lu_GAIN=%.7g\r\nCH%lu_OFFSET=%.4f\r\nCH%lu_UNIT=%s\r\nCH%lu_PWL=",
+		                 (unsigned long)ch, (double)c->gain, (unsigned long)ch, (double)c->offset,
+		                 (unsigned long)ch, c->unit, (unsigned long)ch);
+		for (uint32_t i = 0; i < c->pwl_n && n > 0 && (size_t)n < sizeof(buf); i++)
+		{
+			n += snprintf(buf + n, sizeof(buf) - (size_t)n, "%s%.6g:%.6g", (i ? "," : ""),
+			              (double)c->pwl_x[i], (double)c->pwl_y[i]);
+		}
+		if (n > 0 && (size_t)n < sizeof(buf) - 2u)
+		{
+			buf[n++] = '\r';
+			buf[n++] = '\n';
+			ok = (f_write(&fil, buf, (UINT)n, &bw) == FR_OK && bw == (UINT)n);
+		}
+		else
+		{
+			ok = false;
+		}
+	}
+	AD7606_Cal_Release(t);
+	(void)f_close(&fil);
+
+	if (!ok)
+	{
+		(void)f_unlink(AD7606_CAL_TMP_FILE);
+		return false;
+	}
+	(void)f_unlink(AD7606_CAL_FILE);
+	if (f_rename(AD7606_CAL_TMP_FILE, AD7606_CAL_FILE) != FR_OK)
+	{
+		(void)f_unlink(AD7606_CAL_TMP_FILE);
+		return false;
+	}
+	return true;
+}
+
+bool AD7606_Cal_SetOffsets(uint32_t ch_mask, const float offset[AD7606_CAL_CHANNELS])
+{
+	if (!offset || !cal_begin_write())
+	{
+		return false;
+	}
+	AD7606_CalTable_t *t = cal_spare();
+	if (t == NULL)
+	{
+		cal_abort();
+		return false;
+	}
+	for (uint32_t ch = 0; ch < AD7606_CAL_CHANNELS; ch++)
+	{
+		if (ch_mask & (1u << ch))
+		{
+			t->ch[ch].offset = offset[ch];
+		}
+	}
+	cal_commit(t);
+	return true;
+}
+
+/* 分段线性修正（原地）：相邻样本通常落在同一段，从上一次的段号开始前后移动 */
+static void cal_pwl_apply(const AD7606_CalChannel_t *c, float *buf, uint32_t n)
+{
+	const uint32_t last = (uint32_t)c->pwl_n - 2u;
+	uint32_t seg = 0;
+	float slope = (c->pwl_y[1] - c->pwl_y[0]) / (c->pwl_x[1] - c->pwl_x[0]);
+
+	for (uint32_t i = 0; i < n; i++)
+	{
+		float x = buf[i];
+		uint32_t s = seg;
+		while (s > 0u && x < c->pwl_x[s])
+		{
+			s--;
+		}
+		while (s < last && x >= c->pwl_x[s + 1u])
+		{
+			s++;
+		}
+		if (s != seg)
+		{
+			seg = s;
+			slope = (c->pwl_y[s + 1u] - c->pwl_y[s]) / (c->pwl_x[s + 1u] - c->pwl_x[s]);
+		}
+		buf[i] = c->pwl_y[s] + (x - c->pwl_x[s]) * slope;
+	}
+}
+
+void AD7606_Cal_ApplyF(uint32_t ch, const int16_t *src, float *dst, uint32_t n)
+{
+	if (!src || !dst || ch >= AD7606_CAL_CHANNELS)
+	{
+		return;
+	}
+	const AD7606_CalTable_t *t = AD7606_Cal_Acquire();
+	const AD7606_CalChannel_t *c = &t->ch[ch];
+	AD7606_RawBlockToVoltsF(src, dst, n, c->gain, c->offset);
+	if (c->pwl_n >= 2u)
+	{
+		cal_pwl_apply(c, dst, n);
+	}
+	AD7606_Cal_Release(t);
+}
+
+void AD7606_Cal_ApplyQ15(uint32_t ch, const int16_t *src, int16_t *dst, uint32_t n)
+{
+	if (!src || !dst || ch >= AD7606_CAL_CHANNELS)
+	{
+		return;
+	}
+	/* 只读一个字段也要持有：不持有时写者可能已切走这张表并开始改写它 */
+	const AD7606_CalTable_t *t = AD7606_Cal_Acquire();
+	float offset = t->ch[ch].offset;
+	AD7606_Cal_Release(t);
+	AD7606_RawBlockToQ15(src, dst, n, 1.0f, offset);
+}
+
+float AD7606_Cal_Q15Scale(uint32_t ch)
+{
+	if (ch >= AD7606_CAL_CHANNELS)
+	{
+		return 0.0f;
+	}
+	const AD7606_CalTable_t *t = AD7606_Cal_Acquire();
+	float gain = t->ch[ch].gain;
+	AD7606_Cal_Release(t);
+	return AD7606_GetFullScaleVolts() / AD7606_FRONTEND_GAIN * gain;
+}
@@ -0,0 +1,77 @@
+#ifndef _AD7606_CALIB_H
+#define _AD7606_CALIB_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* ==========================================
+ * AD7606 通道标定表
+ * - 每个物理通道一组：增益、零点、可选分段线性修正、单位
+ * - 换算：x = (code - offset) * 满量程/32768 / AD7606_FRONTEND_GAIN * gain
+ *         若配置了分段线性表，再按 (PWL_X -> PWL_Y) 插值修正 x（两端外推）
+ * - 表存放在 SD 卡 AD7606_CAL_FILE，KEY=VALUE 每行一项（# 开头为注释）：
+ *     CH2_GAIN=0.98468
+ *     CH2_OFFSET=-3.5
+ *     CH2_UNIT=A
+ *     CH2_PWL=0:0,5:5.02,10:10.07
+ *   缺省的项保持编译期默认值（即未放 SD 卡时与旧固件行为一致）
+ * - 运行期可随时重载：新表写入备用缓冲后整体切换；备用缓冲要等持有它的读者全部释放才会被改写，
+ *   读表内容（哪怕只读一个系数）都在 AD7606_Cal_Acquire/Release 之间，持有期间不会读到半张表
+ * ========================================== */
+
+#define AD7606_CAL_CHANNELS   (8u)
+
+/* 分段线性修正最多点数 */
+#ifndef AD7606_CAL_PWL_POINTS
+#define AD7606_CAL_PWL_POINTS (8u)
+#endif
+
+#ifndef AD7606_CAL_FILE
+#define AD7606_CAL_FILE       "0:/config/ad_calib.cfg"
+#endif
+
+typedef struct
+{
+	float gain;                            /* 工程量 / ADC 输入伏特（霍尔/CT/分压系数） */
+	float offset;                          /* 零点（原始码，可为小数 LSB） */
+	uint8_t pwl_n;                         /* 分段线性点数（0=不修正，否则 2..AD7606_CAL_PWL_POINTS） */
+	float pwl_x[AD7606_CAL_PWL_POINTS];    /* 线性换算结果（严格递增） */
+	float pwl_y[AD7606_CAL_PWL_POINTS];    /* 修正后的工程量 */
+	char unit[8];                          /* 工程量单位（空=沿用上层默认） */
+} AD7606_CalChannel_t;
+
+typedef struct
+{
+	uint32_t version;                      /* 每次重载/修改 +1，上层可据此刷新缓存 */
+	AD7606_CalChannel_t ch[AD7606_CAL_CHANNELS];
+} AD7606_CalTable_t;
+
+/* 装载编译期默认表（上电调用一次，早于采样） */
+void AD7606_Cal_Init(void);
+
+/* 从 SD 重新读取标定表并切换（任务上下文；文件不存在返回 false，当前表不变） */
+bool AD7606_Cal_LoadFromSD(void);
+
+/* 把当前表写回 SD（临时文件 + rename 原子替换） */
+bool AD7606_Cal_SaveToSD(void);
+
+/* 当前生效的表（只读，不持有）：只用来读 version 判断表是否换过（读到旧值也只是晚一次重算）；
+ * 连续两次切换后该缓冲会被改写，增益/零点等系数一律用 Acquire/Release 读 */
+const AD7606_CalTable_t *AD7606_Cal_Get(void);
+
+/* 持有当前表（任务上下文）：持有期间写者不会改写它，用完尽快 Release（写者最多等 200ms，超时放弃修改） */
+const AD7606_CalTable_t *AD7606_Cal_Acquire(void);
+void AD7606_Cal_Release(const AD7606_CalTable_t *t);
+
+/* 按通道掩码修改零点（原始码），立即生效（不写 SD）；旧表仍被读者持有超时返回 false */
+bool AD7606_Cal_SetOffsets(uint32_t ch_mask, const float offset[AD7606_CAL_CHANNELS]);
+
+/* 批量换算（任务上下文）：
+ * - ApplyF  : 原始码 -> 工程量（含零点/增益/分段线性）
+ * - ApplyQ15: 原始码 -> 扣零点后的 q15（1.0 = 满量程），结果乘 AD7606_Cal_Q15Scale() 得工程量；
+ *             分段线性不作用于 q15 路径 */
+void AD7606_Cal_ApplyF(uint32_t ch, const int16_t *src, float *dst, uint32_t n);
+void AD7606_Cal_ApplyQ15(uint32_t ch, const int16_t *src, int16_t *dst, uint32_t n);
+float AD7606_Cal_Q15Scale(uint32_t ch);
+
+#endif /* _AD7606_CALIB_H */
@@ -0,0 +1,72 @@
+#include "ad7606_conv.h"
+#include "arm_math.h"
+
+float AD7606_ConvCodeToVoltsF(int16_t code, float fs_v, float fe_gain)
+{
+	const float vin_adc_v = ((float)code * fs_v) / 32768.0f;
+	return vin_adc_v / fe_gain;
+}
+
+/* 每次 32bit 读取两个样本（read_q15x2），8 点展开；零点折算成常数项，每点只做一次乘加 */
+void AD7606_ConvBlockToVoltsF(const int16_t *src, float *dst, uint32_t n, float fs_v, float fe_gain, float gain,
+							  float offset)
+{
+	const float k = (fs_v / 32768.0f) / fe_gain * gain;
+	const float c = -offset * k;
+	q15_t *p = (q15_t *)src;
+	uint32_t blk = n >> 3;
+
+	while (blk > 0u)
+	{
+		q31_t w0 = read_q15x2_ia(&p);
+		q31_t w1 = read_q15x2_ia(&p);
+		q31_t w2 = read_q15x2_ia(&p);
+		q31_t w3 = read_q15x2_ia(&p);
+		dst[0] = (float)(int16_t)w0 * k + c;
+		dst[1] = (float)(w0 >> 16) * k + c;
+		dst[2] = (float)(int16_t)w1 * k + c;
+		dst[3] = (float)(w1 >> 16) * k + c;
+		dst[4] = (float)(int16_t)w2 * k + c;
+		dst[5] = (float)(w2 >> 16) * k + c;
+		dst[6] = (float)(int16_t)w3 * k + c;
+		dst[7] = (float)(w3 >> 16) * k + c;
+		dst += 8;
+		blk--;
+	}
+	for (uint32_t i = n & ~7u; i < n; i++)
+	{
+		*dst++ = (float)(*p++) * k + c;
+	}
+}
+
+/* 扣零点用 arm_offset_q15，增益拆成 q15 小数 + 左移位数交给 arm_scale_q15（SIMD，饱和输出） */
+void AD7606_ConvBlockToQ15(const int16_t *src, int16_t *dst, uint32_t n, float gain, float offset)
+{
+	int8_t shift = 0;
+	q15_t off = (q15_t)__SSAT((int32_t)((offset >= 0.0f) ? (offset + 0.5f) : (offset - 0.5f)), 16);
+
+	if (off != 0)
+	{
+		arm_offset_q15((const q15_t *)src, (q15_t)-off, (q15_t *)dst, n);
+		src = dst;
+	}
+	if (gain == 1.0f)
+	{
+		if (dst != src)
+		{
+			arm_copy_q15((const q15_t *)src, (q15_t *)dst, n);
+		}
+		return;
+	}
+	if (gain < 0.0f)
+	{
+		gain = 0.0f;
+	}
+	while (gain >= 1.0f && shift < 15)
+	{
+		gain *= 0.5f;
+		shift++;
+	}
+	q15_t frac = (q15_t)__SSAT((int32_t)(gain * 32768.0f + 0.5f), 16);
+	arm_scale_q15((const q15_t *)src, frac, shift, (q15_t *)dst, n);
+}
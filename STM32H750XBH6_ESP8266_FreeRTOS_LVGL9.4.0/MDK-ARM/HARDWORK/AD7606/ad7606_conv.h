@@ -0,0 +1,52 @@
+#ifndef _AD7606_CONV_H
+#define _AD7606_CONV_H
+
+#include <stdint.h>
+
+/* ==========================================
+ * AD7606 原始码 -> 工程量换算内核
+ * - 纯计算，不依赖 HAL：满量程（RANGE 引脚决定 ±5V / ±10V）与前端增益由调用方传入，
+ *   固件里由 SPI_AD7606 .c 的 AD7606_RawToVoltsF / AD7606_RawBlockTo* 包一层传当前配置
+ * - 单点版是批量版的对照基准，主机测试见 tools/conv_check
+ * ========================================== */
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD7606_ConvCodeToVoltsF
+* 功能说明: 单点换算：code = -32768..+32767 映射到 -FS..+(FS-1LSB)，再还原成外部输入电压
+* 形    参: code    : 原始码（16bit 两补码）
+*           fs_v    : ADC 满量程（V）
+*           fe_gain : 模拟前端增益（Vin_adc = Vin_in * fe_gain）
+* 返 回 值: 输入电压（V）
+*********************************************************************************************************
+*/
+float AD7606_ConvCodeToVoltsF(int16_t code, float fs_v, float fe_gain);
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD7606_ConvBlockToVoltsF
+* 功能说明: 批量换算：dst = (code - offset) * fs_v/32768 / fe_gain * gain
+* 形    参: src/dst/n : 原始码、输出、点数
+*           fs_v/fe_gain : 同 AD7606_ConvCodeToVoltsF
+*           gain   : 通道增益（传感器/分压系数）
+*           offset : 零点（原始码，可为小数）
+* 返 回 值: 无
+*********************************************************************************************************
+*/
+void AD7606_ConvBlockToVoltsF(const int16_t *src, float *dst, uint32_t n, float fs_v, float fe_gain, float gain,
+							  float offset);
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD7606_ConvBlockToQ15
+* 功能说明: 批量扣零点并按增益缩放为 q15（1.0 = AD7606 满量程，与量程无关）
+* 形    参: src/dst/n : 原始码、输出、点数（dst 可与 src 相同）
+*           gain   : 额外增益（小于 0 按 0 处理）
+*           offset : 零点（原始码，四舍五入到整数 LSB）
+* 返 回 值: 无
+* 说    明: 结果饱和到 -32768..32767；缩放按 arm_scale_q15 截断，与单点换算最多差 1 LSB
+*********************************************************************************************************
+*/
+void AD7606_ConvBlockToQ15(const int16_t *src, int16_t *dst, uint32_t n, float gain, float offset);
+
+#endif /* _AD7606_CONV_H */
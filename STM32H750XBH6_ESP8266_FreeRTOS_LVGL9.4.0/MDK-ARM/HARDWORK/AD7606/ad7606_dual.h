@@ -0,0 +1,44 @@
+#ifndef _AD7606_DUAL_H
+#define _AD7606_DUAL_H
+
+#include <stdint.h>
+
+/* ==========================================
+ * AD7606 双线串行（DOUTA + DOUTB）位流拆分
+ * - 一帧 64 个 SCLK，每个 SCLK 低电平期间读一次端口 IDR（DOUTA/DOUTB 在同一端口）
+ * - DOUTA 依次移出 V1~V4，DOUTB 同时移出 V5~V8，每通道 16 位、高位在前
+ * - 纯计算，不访问寄存器：读 IDR 的循环只负责采样，拆分在此完成（主机测试见 tools/dual_check）
+ * ========================================== */
+
+#define AD7606_DUAL_SCLKS (64u)
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD7606_DualDeinterleave
+* 功能说明: 把 64 次 IDR 采样拆成 8 通道原始码
+* 形    参: idr   : 第 k 个 SCLK 读到的 IDR（k = 通道组 * 16 + 位序，位序 0 为 MSB）
+*           pin_a : DOUTA(DB7) 的引脚掩码
+*           pin_b : DOUTB(DB8) 的引脚掩码
+*           raw   : 输出 raw[0..3] = V1~V4（DOUTA），raw[4..7] = V5~V8（DOUTB）
+* 返 回 值: 无
+*********************************************************************************************************
+*/
+static inline void AD7606_DualDeinterleave(const uint16_t idr[AD7606_DUAL_SCLKS], uint32_t pin_a, uint32_t pin_b,
+										   uint16_t raw[8])
+{
+	for (uint32_t ch = 0; ch < 4u; ch++)
+	{
+		const uint16_t *p = &idr[ch * 16u];
+		uint16_t va = 0;
+		uint16_t vb = 0;
+		for (uint32_t i = 0; i < 16u; i++)
+		{
+			va = (uint16_t)((va << 1) | ((p[i] & pin_a) ? 1u : 0u));
+			vb = (uint16_t)((vb << 1) | ((p[i] & pin_b) ? 1u : 0u));
+		}
+		raw[ch] = va;
+		raw[ch + 4u] = vb;
+	}
+}
+
+#endif /* _AD7606_DUAL_H */
@@ -0,0 +1,261 @@
+#include "stm32h7xx_hal.h"
+#include "SPI_AD7606.h"
+
+/*
+ * AD7606 硬件 SPI + DMA 读出后端
+ *
+ * 时序（每个采样点）：
+ *   TIM2 更新中断 -> AD7606_StartConv()（CONVST 上升沿）
+ *   BUSY 下降沿   -> EXTI3 -> CS 拉低，启动 SPI1 主机只收 + DMA1_Stream4（8×16bit）
+ *   DMA 传输完成  -> CS 拉高，关闭 SPI，回调 AD7606_FrameReadyCallback()
+ *
+ * 与软件模拟相比，ISR 中不再有 128 个 SCLK 的逐位循环，CPU 只做几十条寄存器操作。
+ * 连线见 SPI_AD7606.h 末尾说明（SCLK->PA5，DOUTA->PA6）。
+ */
+
+#if (AD7606_READ_BACKEND == AD7606_BACKEND_SPI_DMA)
+
+#ifndef AXI_SRAM_SECTION
+#define AXI_SRAM_SECTION __attribute__((section(".axi_sram")))
+#endif
+#ifndef DMA_ALIGN32
+#define DMA_ALIGN32 __attribute__((aligned(32)))
+#endif
+
+/* SPI1 内核时钟默认取 PLL1Q（当前时钟树 = 240MHz），MBR=3 -> /16 = 15MHz SCLK
+ * AD7606 串行模式 SCLK 上限约 17MHz(VDRIVE=3.3V)，留有余量 */
+#ifndef AD7606_SPI_MBR
+#define AD7606_SPI_MBR (3u)
+#endif
+
+#define AD7606_SPI            SPI1
+#define AD7606_SPI_GPIO_Port  GPIOA
+#define AD7606_SPI_SCK_Pin    GPIO_PIN_5
+#define AD7606_SPI_MISO_Pin   GPIO_PIN_6
+
+/* 一帧 8×16bit = 16 字节，按 Cache 行(32B)整行占用，失效 Cache 时不会波及相邻变量 */
+static uint16_t s_ad7606_dma_buf[16] AXI_SRAM_SECTION DMA_ALIGN32;
+
+static DMA_HandleTypeDef s_hdma_ad7606_rx;
+static volatile uint8_t s_dma_busy = 0;
+static volatile uint8_t s_frame_done = 0;
+
+static void AD7606_SpiDma_XferCplt(DMA_HandleTypeDef *hdma);
+static void AD7606_SpiDma_XferError(DMA_HandleTypeDef *hdma);
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD7606_SpiDma_Stop
+* 功能说明: 结束一次 SPI 传输：拉高 CS，清标志，关闭 SPI（TSIZE 模式下重新启动前必须 SPE=0）
+*********************************************************************************************************
+*/
+static void AD7606_SpiDma_Stop(void)
+{
+	AD7606_CS_H;
+	AD7606_SPI->IFCR = SPI_IFCR_EOTC | SPI_IFCR_TXTFC | SPI_IFCR_OVRC;
+	AD7606_SPI->CR1 &= ~SPI_CR1_SPE;
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD7606_SpiDma_Init
+* 功能说明: 配置 SPI1(主机只收, CPOL=1/CPHA=1, 16bit)、DMA1_Stream4、BUSY 下降沿中断
+* 形    参: 无
+* 返 回 值: 无
+*********************************************************************************************************
+*/
+void AD7606_SpiDma_Init(void)
+{
+	GPIO_InitTypeDef GPIO_InitStruct = {0};
+
+	__HAL_RCC_GPIOA_CLK_ENABLE();
+	__HAL_RCC_GPIOC_CLK_ENABLE();
+	__HAL_RCC_SPI1_CLK_ENABLE();
+	__HAL_RCC_DMA1_CLK_ENABLE();
+
+	/* 1. SPI1 引脚：PA5=SCK, PA6=MISO */
+	GPIO_InitStruct.Pin = AD7606_SPI_SCK_Pin | AD7606_SPI_MISO_Pin;
+	GPIO_InitStruct.Mode = GPIO_MODE_AF_PP;
+	GPIO_InitStruct.Pull = GPIO_NOPULL;
+	GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_VERY_HIGH;
+	GPIO_InitStruct.Alternate = GPIO_AF5_SPI1;
+	HAL_GPIO_Init(AD7606_SPI_GPIO_Port, &GPIO_InitStruct);
+
+	/* 2. SPI1 寄存器配置（SPE=0 时才能写 CFG1/CFG2） */
+	AD7606_SPI->CR1 = 0;
+	AD7606_SPI->CFG1 = (15u << SPI_CFG1_DSIZE_Pos)          /* 16bit 数据帧 */
+					 | (AD7606_SPI_MBR << SPI_CFG1_MBR_Pos)  /* 分频 */
+					 | SPI_CFG1_RXDMAEN;                     /* RXP -> DMA 请求 */
+	AD7606_SPI->CFG2 = SPI_CFG2_MASTER
+					 | SPI_CFG2_COMM_1                       /* 单工只收 */
+					 | SPI_CFG2_CPOL | SPI_CFG2_CPHA         /* 与软件时序一致：空闲高，上升沿采样 */
+					 | SPI_CFG2_SSM                          /* 片选由 GPIO(PB6) 控制 */
+					 | SPI_CFG2_AFCNTR;                      /* SPE=0 时仍保持 SCK 空闲电平 */
+	AD7606_SPI->CR1 = SPI_CR1_SSI;
+	AD7606_SPI->CR2 = 8u << SPI_CR2_TSIZE_Pos;               /* 每次传输 8 个通道 */
+
+	/* 3. DMA1_Stream4 <- SPI1_RX */
+	s_hdma_ad7606_rx.Instance = DMA1_Stream4;
+	s_hdma_ad7606_rx.Init.Request = DMA_REQUEST_SPI1_RX;
+	s_hdma_ad7606_rx.Init.Direction = DMA_PERIPH_TO_MEMORY;
+	s_hdma_ad7606_rx.Init.PeriphInc = DMA_PINC_DISABLE;
+	s_hdma_ad7606_rx.Init.MemInc = DMA_MINC_ENABLE;
+	s_hdma_ad7606_rx.Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD;
+	s_hdma_ad7606_rx.Init.MemDataAlignment = DMA_MDATAALIGN_HALFWORD;
+	s_hdma_ad7606_rx.Init.Mode = DMA_NORMAL;
+	s_hdma_ad7606_rx.Init.Priority = DMA_PRIORITY_VERY_HIGH;
+	s_hdma_ad7606_rx.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+	if (HAL_DMA_Init(&s_hdma_ad7606_rx) != HAL_OK)
+	{
+		Error_Handler();
+	}
+	s_hdma_ad7606_rx.XferCpltCallback = AD7606_SpiDma_XferCplt;
+	s_hdma_ad7606_rx.XferErrorCallback = AD7606_SpiDma_XferError;
+
+	/* 4. BUSY(PC3) 下降沿中断 */
+	GPIO_InitStruct.Pin = AD7606_BUSY_Pin;
+	GPIO_InitStruct.Mode = GPIO_MODE_IT_FALLING;
+	GPIO_InitStruct.Pull = GPIO_NOPULL;
+	GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
+	GPIO_InitStruct.Alternate = 0;
+	HAL_GPIO_Init(AD7606_BUSY_GPIO_Port, &GPIO_InitStruct);
+
+	/* 与 TIM2 同优先级：三段中断互不抢占，帧内状态无需额外保护 */
+	HAL_NVIC_SetPriority(DMA1_Stream4_IRQn, 5, 0);
+	HAL_NVIC_EnableIRQ(DMA1_Stream4_IRQn);
+	HAL_NVIC_SetPriority(EXTI3_IRQn, 5, 0);
+	HAL_NVIC_EnableIRQ(EXTI3_IRQn);
+
+	s_dma_busy = 0;
+	s_frame_done = 0;
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD7606_SpiDma_Busy
+* 功能说明: 查询上一帧 DMA 读取是否仍在进行
+* 返 回 值: 1=进行中，0=空闲
+*********************************************************************************************************
+*/
+uint8_t AD7606_SpiDma_Busy(void)
+{
+	return s_dma_busy;
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD7606_SpiDma_OnBusyFall
+* 功能说明: BUSY 下降沿（转换完成）：拉低 CS，启动 DMA + SPI 读取 8 通道
+* 说    明: 在 EXTI3 中断中调用
+*********************************************************************************************************
+*/
+void AD7606_SpiDma_OnBusyFall(void)
+{
+	uint32_t t0 = AD7606_CycNow();
+
+	if (s_dma_busy)
+	{
+		/* 上一帧还没读完又来了下降沿：按丢帧处理 */
+		g_ad7606_miss++;
+		AD7606_CycAccum(t0);
+		return;
+	}
+	s_dma_busy = 1;
+
+	AD7606_CS_L;
+	/* 顺序：先使能 DMA 流，再 SPE，最后 CSTART（RM0433 推荐顺序） */
+	if (HAL_DMA_Start_IT(&s_hdma_ad7606_rx, (uint32_t)&AD7606_SPI->RXDR,
+						 (uint32_t)s_ad7606_dma_buf, 8u) != HAL_OK)
+	{
+		AD7606_CS_H;
+		s_dma_busy = 0;
+		g_ad7606_miss++;
+		AD7606_CycAccum(t0);
+		return;
+	}
+	AD7606_SPI->CR1 |= SPI_CR1_SPE;
+	AD7606_SPI->CR1 |= SPI_CR1_CSTART;
+
+	AD7606_CycAccum(t0);
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD7606_SpiDma_IRQHandler
+* 功能说明: DMA1_Stream4 中断入口（统计本段耗时，并在帧结束时提交统计）
+*********************************************************************************************************
+*/
+void AD7606_SpiDma_IRQHandler(void)
+{
+	uint32_t t0 = AD7606_CycNow();
+
+	HAL_DMA_IRQHandler(&s_hdma_ad7606_rx);
+
+	AD7606_CycAccum(t0);
+	if (s_frame_done)
+	{
+		s_frame_done = 0;
+		AD7606_CycCommit();
+	}
+}
+
+static void AD7606_SpiDma_XferCplt(DMA_HandleTypeDef *hdma)
+{
+	uint16_t raw[8];
+
+	(void)hdma;
+	AD7606_SpiDma_Stop();
+
+	/* DMA 写 AXI SRAM，CPU 读取前先失效 Cache */
+	SCB_InvalidateDCache_by_Addr((uint32_t *)s_ad7606_dma_buf, sizeof(s_ad7606_dma_buf));
+	for (uint8_t i = 0; i < 8; i++)
+	{
+		raw[i] = s_ad7606_dma_buf[i];
+	}
+	s_dma_busy = 0;
+	s_frame_done = 1;
+
+	AD7606_FrameReadyCallback(raw);
+}
+
+static void AD7606_SpiDma_XferError(DMA_HandleTypeDef *hdma)
+{
+	(void)hdma;
+	AD7606_SpiDma_Stop();
+	s_dma_busy = 0;
+	g_ad7606_miss++;
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD7606_SpiDma_ReadPolled
+* 功能说明: 轮询方式读取一帧（临时关闭 RXDMAEN）
+* 形    参: raw : 输出 8 通道原始码
+* 说    明: 供 AD7606_Scan 等非中断路径使用，不要与 DMA 采样流程并发调用
+*********************************************************************************************************
+*/
+void AD7606_SpiDma_ReadPolled(uint16_t raw[8])
+{
+	if (s_dma_busy)
+	{
+		return;
+	}
+	AD7606_SPI->CFG1 &= ~SPI_CFG1_RXDMAEN;
+
+	AD7606_CS_L;
+	AD7606_SPI->CR1 |= SPI_CR1_SPE;
+	AD7606_SPI->CR1 |= SPI_CR1_CSTART;
+	for (uint8_t i = 0; i < 8; i++)
+	{
+		while ((AD7606_SPI->SR & SPI_SR_RXP) == 0u)
+			;
+		raw[i] = *(__IO uint16_t *)&AD7606_SPI->RXDR;
+	}
+	while ((AD7606_SPI->SR & SPI_SR_EOT) == 0u)
+		;
+	AD7606_SpiDma_Stop();
+
+	AD7606_SPI->CFG1 |= SPI_CFG1_RXDMAEN;
+}
+
+#endif /* AD7606_READ_BACKEND == AD7606_BACKEND_SPI_DMA */
@@ -0,0 +1,432 @@
+#include "stm32h7xx_hal.h"
+#include <math.h>
+#include "SPI_AD7606.h"
+#include "tim.h"
+
+/*
+ * AD7606 零 CPU 采样流水线
+ *
+ * 每个采样点全部由硬件完成，不进任何中断：
+ *   TIM2_CH2 / TIM4_CH4 PWM   -> CONVST A/B 上升沿（TIM4 复位于 TIM2 TRGO，两路同相）
+ *   BUSY 下降沿(PB0, EXTI0)    -> DMAMUX 请求发生器 0/1/2 同时触发：
+ *       gen0 -> DMA2_Stream1：向 SPI1->CR1 依次写 {0, SPE, SPE|CSTART}，启动 8×16bit 读取
+ *       gen1 -> DMA2_Stream2：写 EXTI->PR1 清 EXTI0 挂起位（否则触发信号保持高电平，只能触发一次）
+ *       gen2 -> DMA2_Stream3：抓取 TIM5->CNT 作为本帧时间戳
+ *   SPI1 RXP                   -> DMA2_Stream0：写入环形多帧缓冲
+ *
+ * DMA2_Stream0 半满/全满时才中断一次：失效 Cache -> 统计抖动/丢帧 -> AD7606_BlockReadyCallback()
+ * CS 使用 SPI1 硬件 NSS（SSOE=1, SSOM=0）：SPE 置位后拉低，EOT 后释放。
+ */
+
+#if (AD7606_READ_BACKEND == AD7606_BACKEND_STREAM)
+
+#ifndef AXI_SRAM_SECTION
+#define AXI_SRAM_SECTION __attribute__((section(".axi_sram")))
+#endif
+#ifndef DMA_ALIGN32
+#define DMA_ALIGN32 __attribute__((aligned(32)))
+#endif
+
+/* SPI1 内核时钟 = PLL1Q(240MHz)，MBR=3 -> 15MHz；一帧 128 SCLK ≈ 8.5us */
+#ifndef AD7606_SPI_MBR
+#define AD7606_SPI_MBR (3u)
+#endif
+
+/* BUSY 触发脚：DMAMUX1 请求发生器只接受 EXTI0，因此必须是 Px0 */
+#define AD7606_TRIG_GPIO_Port  GPIOB
+#define AD7606_TRIG_Pin        GPIO_PIN_0
+
+#define AD7606_STREAM_FRAMES   (2u * AD7606_STREAM_BLOCK_FRAMES)
+
+/* 环形多帧缓冲 + 同步时间戳（每个 BUSY 事件各写一项，两者下标一一对应） */
+static uint16_t s_stream_buf[AD7606_STREAM_FRAMES][8] AXI_SRAM_SECTION DMA_ALIGN32;
+static uint32_t s_stream_ts[AD7606_STREAM_FRAMES] AXI_SRAM_SECTION DMA_ALIGN32;
+
+/* DMA 源数据：SPI1->CR1 启动序列、EXTI0 清除字（CPU 只在初始化时写，写后 Clean Cache） */
+static uint32_t s_spi_kick[8] AXI_SRAM_SECTION DMA_ALIGN32;
+static uint32_t s_exti_clear[8] AXI_SRAM_SECTION DMA_ALIGN32;
+
+static DMA_HandleTypeDef s_hdma_rx;    /* DMA2_Stream0: SPI1_RX -> s_stream_buf */
+static DMA_HandleTypeDef s_hdma_kick;  /* DMA2_Stream1: gen0 -> SPI1->CR1 */
+static DMA_HandleTypeDef s_hdma_exti;  /* DMA2_Stream2: gen1 -> EXTI->PR1 */
+static DMA_HandleTypeDef s_hdma_ts;    /* DMA2_Stream3: gen2 -> s_stream_ts */
+static TIM_HandleTypeDef s_htim4;      /* CONVST_B */
+static TIM_HandleTypeDef s_htim5;      /* 时间戳计数器 */
+
+static uint32_t s_period_ticks = 0;    /* 名义采样周期（TIM5 计数） */
+static uint32_t s_ts_prev = 0;
+static uint8_t s_ts_valid = 0;
+static volatile uint16_t s_latest_idx = 0;
+
+/* 抖动统计窗口（中断写，任务读后清零） */
+static volatile int32_t s_jit_min = 0;
+static volatile int32_t s_jit_max = 0;
+static volatile uint64_t s_jit_sq_sum = 0;
+static volatile uint32_t s_jit_cnt = 0;
+
+static void AD7606_Stream_HalfCplt(DMA_HandleTypeDef *hdma);
+static void AD7606_Stream_Cplt(DMA_HandleTypeDef *hdma);
+static void AD7606_Stream_Error(DMA_HandleTypeDef *hdma);
+
+static void AD7606_Stream_DmaInit(DMA_HandleTypeDef *h, DMA_Stream_TypeDef *inst, uint32_t request,
+								  uint32_t dir, uint32_t minc, uint32_t align)
+{
+	h->Instance = inst;
+	h->Init.Request = request;
+	h->Init.Direction = dir;
+	h->Init.PeriphInc = DMA_PINC_DISABLE;
+	h->Init.MemInc = minc;
+	h->Init.PeriphDataAlignment = (align == 2u) ? DMA_PDATAALIGN_HALFWORD : DMA_PDATAALIGN_WORD;
+	h->Init.MemDataAlignment = (align == 2u) ? DMA_MDATAALIGN_HALFWORD : DMA_MDATAALIGN_WORD;
+	h->Init.Mode = DMA_CIRCULAR;
+	h->Init.Priority = DMA_PRIORITY_VERY_HIGH;
+	h->Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+	if (HAL_DMA_Init(h) != HAL_OK)
+	{
+		Error_Handler();
+	}
+}
+
+static void AD7606_Stream_ReqGen(DMA_HandleTypeDef *h, uint32_t nreq)
+{
+	HAL_DMA_MuxRequestGeneratorConfigTypeDef cfg = {0};
+
+	cfg.SignalID = HAL_DMAMUX1_REQ_GEN_EXTI0;
+	cfg.Polarity = HAL_DMAMUX_REQ_GEN_RISING;
+	cfg.RequestNumber = nreq;
+	if (HAL_DMAEx_ConfigMuxRequestGenerator(h, &cfg) != HAL_OK)
+	{
+		Error_Handler();
+	}
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD7606_Stream_Init
+* 功能说明: 配置 PWM CONVST、SPI1(硬件 NSS)、TIM5 时间戳、EXTI0 与 4 路 DMA
+* 形    参: 无
+* 返 回 值: 无
+* 说    明: 只做配置，不启动；采样由 AD7606_Stream_Start() 开始
+*********************************************************************************************************
+*/
+void AD7606_Stream_Init(void)
+{
+	GPIO_InitTypeDef GPIO_InitStruct = {0};
+	TIM_OC_InitTypeDef sConfigOC = {0};
+	TIM_MasterConfigTypeDef sMasterConfig = {0};
+	TIM_SlaveConfigTypeDef sSlaveConfig = {0};
+
+	__HAL_RCC_GPIOA_CLK_ENABLE();
+	__HAL_RCC_GPIOB_CLK_ENABLE();
+	__HAL_RCC_SPI1_CLK_ENABLE();
+	__HAL_RCC_TIM4_CLK_ENABLE();
+	__HAL_RCC_TIM5_CLK_ENABLE();
+	__HAL_RCC_DMA2_CLK_ENABLE();
+
+	/* 1. 引脚：PA4/5/6 = SPI1 NSS/SCK/MISO，PB3 = TIM2_CH2，PB9 = TIM4_CH4 */
+	GPIO_InitStruct.Pin = GPIO_PIN_4 | GPIO_PIN_5 | GPIO_PIN_6;
+	GPIO_InitStruct.Mode = GPIO_MODE_AF_PP;
+	GPIO_InitStruct.Pull = GPIO_NOPULL;
+	GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_VERY_HIGH;
+	GPIO_InitStruct.Alternate = GPIO_AF5_SPI1;
+	HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
+
+	GPIO_InitStruct.Pin = AD7606_CONVEST_A_Pin;
+	GPIO_InitStruct.Alternate = GPIO_AF1_TIM2;
+	HAL_GPIO_Init(AD7606_CONVEST_A_GPIO_Port, &GPIO_InitStruct);
+
+	GPIO_InitStruct.Pin = AD7606_CONVEST_B_Pin;
+	GPIO_InitStruct.Alternate = GPIO_AF2_TIM4;
+	HAL_GPIO_Init(AD7606_CONVEST_B_GPIO_Port, &GPIO_InitStruct);
+
+	/* BUSY 触发脚：下降沿置位 EXTI0 挂起位，仅供 DMAMUX 使用，不使能 NVIC */
+	GPIO_InitStruct.Pin = AD7606_TRIG_Pin;
+	GPIO_InitStruct.Mode = GPIO_MODE_IT_FALLING;
+	GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
+	GPIO_InitStruct.Alternate = 0;
+	HAL_GPIO_Init(AD7606_TRIG_GPIO_Port, &GPIO_InitStruct);
+	HAL_NVIC_DisableIRQ(EXTI0_IRQn);
+
+	/* 2. TIM2：沿用 CubeMX 的 PSC/ARR（25.6kHz），CH2 PWM2 -> 周期开头输出 1 个计数的低电平 */
+	HAL_TIM_Base_Stop_IT(&htim2);
+	if (HAL_TIM_PWM_Init(&htim2) != HAL_OK)
+	{
+		Error_Handler();
+	}
+	sConfigOC.OCMode = TIM_OCMODE_PWM2;
+	sConfigOC.Pulse = 1;
+	sConfigOC.OCPolarity = TIM_OCPOLARITY_HIGH;
+	sConfigOC.OCFastMode = TIM_OCFAST_DISABLE;
+	if (HAL_TIM_PWM_ConfigChannel(&htim2, &sConfigOC, TIM_CHANNEL_2) != HAL_OK)
+	{
+		Error_Handler();
+	}
+	sMasterConfig.MasterOutputTrigger = TIM_TRGO_UPDATE;
+	sMasterConfig.MasterSlaveMode = TIM_MASTERSLAVEMODE_ENABLE;
+	if (HAL_TIMEx_MasterConfigSynchronization(&htim2, &sMasterConfig) != HAL_OK)
+	{
+		Error_Handler();
+	}
+
+	/* 3. TIM4：与 TIM2 同 PSC/ARR，从模式复位于 ITR1(TIM2 TRGO) */
+	s_htim4.Instance = TIM4;
+	s_htim4.Init.Prescaler = htim2.Init.Prescaler;
+	s_htim4.Init.CounterMode = TIM_COUNTERMODE_UP;
+	s_htim4.Init.Period = htim2.Init.Period;
+	s_htim4.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+	s_htim4.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+	if (HAL_TIM_PWM_Init(&s_htim4) != HAL_OK)
+	{
+		Error_Handler();
+	}
+	sSlaveConfig.SlaveMode = TIM_SLAVEMODE_RESET;
+	sSlaveConfig.InputTrigger = TIM_TS_ITR1;
+	if (HAL_TIM_SlaveConfigSynchro(&s_htim4, &sSlaveConfig) != HAL_OK)
+	{
+		Error_Handler();
+	}
+	if (HAL_TIM_PWM_ConfigChannel(&s_htim4, &sConfigOC, TIM_CHANNEL_4) != HAL_OK)
+	{
+		Error_Handler();
+	}
+
+	/* 4. TIM5：32bit 自由计数，与 TIM2 同一时钟源，计数值即时间戳 */
+	s_htim5.Instance = TIM5;
+	s_htim5.Init.Prescaler = 0;
+	s_htim5.Init.CounterMode = TIM_COUNTERMODE_UP;
+	s_htim5.Init.Period = 0xFFFFFFFFu;
+	s_htim5.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+	s_htim5.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+	if (HAL_TIM_Base_Init(&s_htim5) != HAL_OK)
+	{
+		Error_Handler();
+	}
+	s_period_ticks = (htim2.Init.Prescaler + 1u) * (htim2.Init.Period + 1u);
+
+	/* 5. SPI1：主机只收，16bit，CPOL=1/CPHA=1，硬件 NSS 输出，TSIZE=8 */
+	SPI1->CR1 = 0;
+	SPI1->CFG1 = (15u << SPI_CFG1_DSIZE_Pos)
+			   | (AD7606_SPI_MBR << SPI_CFG1_MBR_Pos)
+			   | SPI_CFG1_RXDMAEN;
+	SPI1->CFG2 = SPI_CFG2_MASTER
+			   | SPI_CFG2_COMM_1
+			   | SPI_CFG2_CPOL | SPI_CFG2_CPHA
+			   | SPI_CFG2_SSOE
+			   | SPI_CFG2_AFCNTR;
+	SPI1->CR2 = 8u << SPI_CR2_TSIZE_Pos;
+
+	/* 6. DMA 源数据：先关 SPE（复位状态机/释放 NSS），再开 SPE，最后 CSTART */
+	s_spi_kick[0] = 0u;
+	s_spi_kick[1] = SPI_CR1_SPE;
+	s_spi_kick[2] = SPI_CR1_SPE | SPI_CR1_CSTART;
+	s_exti_clear[0] = AD7606_TRIG_Pin;
+	SCB_CleanDCache_by_Addr(s_spi_kick, sizeof(s_spi_kick));
+	SCB_CleanDCache_by_Addr(s_exti_clear, sizeof(s_exti_clear));
+
+	/* 7. DMA 通道 */
+	AD7606_Stream_DmaInit(&s_hdma_rx, DMA2_Stream0, DMA_REQUEST_SPI1_RX,
+						  DMA_PERIPH_TO_MEMORY, DMA_MINC_ENABLE, 2u);
+	AD7606_Stream_DmaInit(&s_hdma_kick, DMA2_Stream1, DMA_REQUEST_GENERATOR0,
+						  DMA_MEMORY_TO_PERIPH, DMA_MINC_ENABLE, 4u);
+	AD7606_Stream_DmaInit(&s_hdma_exti, DMA2_Stream2, DMA_REQUEST_GENERATOR1,
+						  DMA_MEMORY_TO_PERIPH, DMA_MINC_DISABLE, 4u);
+	AD7606_Stream_DmaInit(&s_hdma_ts, DMA2_Stream3, DMA_REQUEST_GENERATOR2,
+						  DMA_PERIPH_TO_MEMORY, DMA_MINC_ENABLE, 4u);
+	AD7606_Stream_ReqGen(&s_hdma_kick, 3u);
+	AD7606_Stream_ReqGen(&s_hdma_exti, 1u);
+	AD7606_Stream_ReqGen(&s_hdma_ts, 1u);
+
+	s_hdma_rx.XferHalfCpltCallback = AD7606_Stream_HalfCplt;
+	s_hdma_rx.XferCpltCallback = AD7606_Stream_Cplt;
+	s_hdma_rx.XferErrorCallback = AD7606_Stream_Error;
+
+	HAL_NVIC_SetPriority(DMA2_Stream0_IRQn, 5, 0);
+	HAL_NVIC_EnableIRQ(DMA2_Stream0_IRQn);
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD7606_Stream_Start
+* 功能说明: 启动流水线：先挂好全部 DMA，再启动时间戳与 PWM
+*********************************************************************************************************
+*/
+void AD7606_Stream_Start(void)
+{
+	s_ts_valid = 0;
+	s_latest_idx = 0;
+	__HAL_GPIO_EXTI_CLEAR_IT(AD7606_TRIG_Pin);
+
+	HAL_DMA_Start_IT(&s_hdma_rx, (uint32_t)&SPI1->RXDR, (uint32_t)s_stream_buf,
+					 AD7606_STREAM_FRAMES * 8u);
+	HAL_DMA_Start(&s_hdma_ts, (uint32_t)&TIM5->CNT, (uint32_t)s_stream_ts, AD7606_STREAM_FRAMES);
+	HAL_DMA_Start(&s_hdma_exti, (uint32_t)s_exti_clear, (uint32_t)&EXTI->PR1, 1u);
+	HAL_DMA_Start(&s_hdma_kick, (uint32_t)s_spi_kick, (uint32_t)&SPI1->CR1, 3u);
+	HAL_DMAEx_EnableMuxRequestGenerator(&s_hdma_ts);
+	HAL_DMAEx_EnableMuxRequestGenerator(&s_hdma_exti);
+	HAL_DMAEx_EnableMuxRequestGenerator(&s_hdma_kick);
+
+	HAL_TIM_Base_Start(&s_htim5);
+	HAL_TIM_PWM_Start(&s_htim4, TIM_CHANNEL_4);
+	HAL_TIM_PWM_Start(&htim2, TIM_CHANNEL_2);
+}
+
+void AD7606_Stream_Stop(void)
+{
+	HAL_TIM_PWM_Stop(&htim2, TIM_CHANNEL_2);
+	HAL_TIM_PWM_Stop(&s_htim4, TIM_CHANNEL_4);
+	HAL_DMAEx_DisableMuxRequestGenerator(&s_hdma_kick);
+	HAL_DMAEx_DisableMuxRequestGenerator(&s_hdma_exti);
+	HAL_DMAEx_DisableMuxRequestGenerator(&s_hdma_ts);
+	HAL_DMA_Abort(&s_hdma_kick);
+	HAL_DMA_Abort(&s_hdma_exti);
+	HAL_DMA_Abort(&s_hdma_ts);
+	HAL_DMA_Abort_IT(&s_hdma_rx);
+	HAL_TIM_Base_Stop(&s_htim5);
+	SPI1->CR1 = 0;
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD7606_Stream_Block
+* 功能说明: 处理半个环形缓冲：统计采样间隔抖动与丢帧，然后交给上层
+* 形    参: first : 起始帧下标
+* 说    明: 相邻时间戳差按名义周期取整 n：n>1 说明漏掉了 n-1 次转换；
+*           差值与 n×周期 之差即采样时钟抖动（含 BUSY 转换时间的波动）
+*********************************************************************************************************
+*/
+static void AD7606_Stream_Block(uint32_t first)
+{
+	uint32_t t0 = AD7606_CycNow();
+	const uint32_t n = AD7606_STREAM_BLOCK_FRAMES;
+
+	SCB_InvalidateDCache_by_Addr((uint32_t *)s_stream_buf[first], n * 8u * sizeof(uint16_t));
+	SCB_InvalidateDCache_by_Addr(&s_stream_ts[first], n * sizeof(uint32_t));
+
+	if (s_period_ticks > 0u)
+	{
+		for (uint32_t i = 0; i < n; i++)
+		{
+			uint32_t ts = s_stream_ts[first + i];
+			if (s_ts_valid)
+			{
+				uint32_t d = ts - s_ts_prev;
+				uint32_t k = (d + s_period_ticks / 2u) / s_period_ticks;
+				if (k > 1u)
+				{
+					g_ad7606_miss += (k - 1u);
+				}
+				if (k > 0u)
+				{
+					int32_t e = (int32_t)(d - k * s_period_ticks);
+					if (s_jit_cnt == 0u || e < s_jit_min)
+						s_jit_min = e;
+					if (s_jit_cnt == 0u || e > s_jit_max)
+						s_jit_max = e;
+					s_jit_sq_sum += (uint64_t)((int64_t)e * e);
+					s_jit_cnt++;
+				}
+			}
+			s_ts_prev = ts;
+			s_ts_valid = 1;
+		}
+	}
+	s_latest_idx = (uint16_t)(first + n - 1u);
+
+	AD7606_BlockReadyCallback((const uint16_t (*)[8])s_stream_buf[first], n);
+
+	AD7606_CycAccum(t0);
+	AD7606_CycCommit();
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD7606_Stream_SetPeriod
+* 功能说明: 运行期修改采样周期（由 AD7606_TimingApply 调用，TIM2 的 ARR 已由调用方写入）
+* 形    参: arr : 新的自动重装值
+* 说    明: TIM4 由 TIM2 TRGO 复位，两者都开预装载，在同一个更新事件换周期；
+*           时间戳基准清零，避免新旧周期交界处被误计为丢帧/抖动
+*********************************************************************************************************
+*/
+void AD7606_Stream_SetPeriod(uint32_t arr)
+{
+	TIM4->CR1 |= TIM_CR1_ARPE;
+	TIM4->ARR = arr;
+	s_htim4.Init.Period = arr;
+	s_period_ticks = (TIM2->PSC + 1u) * (arr + 1u);
+	s_ts_valid = 0;
+}
+
+static void AD7606_Stream_HalfCplt(DMA_HandleTypeDef *hdma)
+{
+	(void)hdma;
+	AD7606_Stream_Block(0u);
+}
+
+static void AD7606_Stream_Cplt(DMA_HandleTypeDef *hdma)
+{
+	(void)hdma;
+	AD7606_Stream_Block(AD7606_STREAM_BLOCK_FRAMES);
+}
+
+static void AD7606_Stream_Error(DMA_HandleTypeDef *hdma)
+{
+	(void)hdma;
+	/* 总线错误：整条流水线重启，帧与时间戳重新对齐 */
+	g_ad7606_miss++;
+	AD7606_Stream_Stop();
+	AD7606_Stream_Start();
+}
+
+void AD7606_Stream_IRQHandler(void)
+{
+	HAL_DMA_IRQHandler(&s_hdma_rx);
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD7606_Stream_ReadLatest
+* 功能说明: 读取最近一块中的最后一帧（非阻塞，不触碰 SPI）
+*********************************************************************************************************
+*/
+void AD7606_Stream_ReadLatest(uint16_t raw[8])
+{
+	uint16_t idx = s_latest_idx;
+	for (uint8_t i = 0; i < 8; i++)
+	{
+		raw[i] = s_stream_buf[idx][i];
+	}
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: AD7606_Stream_GetJitter
+* 功能说明: 读取并清零抖动统计窗口
+* 形    参: pp_ns  : 峰峰值（ns）
+*           rms_ns : 均方根（ns）
+*********************************************************************************************************
+*/
+void AD7606_Stream_GetJitter(uint32_t *pp_ns, uint32_t *rms_ns)
+{
+	int32_t jmin, jmax;
+	uint64_t sq;
+	uint32_t cnt;
+	uint32_t primask = __get_PRIMASK();
+
+	__disable_irq();
+	jmin = s_jit_min;
+	jmax = s_jit_max;
+	sq = s_jit_sq_sum;
+	cnt = s_jit_cnt;
+	s_jit_sq_sum = 0;
+	s_jit_cnt = 0;
+	__set_PRIMASK(primask);
+
+	/* TIM5 计数时钟 = APB1 定时器时钟（PCLK1×2） */
+	const float ns_per_tick = 1.0e9f / (float)(HAL_RCC_GetPCLK1Freq() * 2u);
+	if (pp_ns)
+		*pp_ns = (cnt > 0u) ? (uint32_t)((float)(jmax - jmin) * ns_per_tick) : 0u;
+	if (rms_ns)
+		*rms_ns = (cnt > 0u) ? (uint32_t)(sqrtf((float)sq / (float)cnt) * ns_per_tick) : 0u;
+}
+
+#endif /* AD7606_READ_BACKEND == AD7606_BACKEND_STREAM */
@@ -13,7 +13,19 @@
 
 #include "esp8266.h"
 #include "SPI_AD7606.h"
+#include "ad7606_calib.h"
 #include "ad_acq_buffers.h"
+#include "ad_trigger.h"
+#include "ad_decim.h"
+#include "ad_tone.h"
+#include "ad_fault_port.h"
+#include "ad_arc_port.h"
+#include "ad_class_port.h"
+#include "ad_dsp.h"
+#include "ad_frame.h"
+#include "sd_waveform.h"
+#include "sd_spool.h"
+#include "sd_time.h"
 #include "usart.h"
 #include "arm_math.h"
 #include "cmsis_os.h"
@@ -56,6 +68,16 @@ static inline float ESP_SafeFloat(float v)
 #define ESP_UPLOAD_SCALE 200
 #endif
 
+/* 二进制帧的波形/录波是否走无损压缩段（WAVE_Z / EVENT_Z）：
+ * 1 = 波形按 ×ESP_UPLOAD_SCALE 定点（与 JSON 逐点相同）、录波按原始码，ad_codec 分块编码；0 = WAVE / EVENT 原样 int16 */
+#ifndef ESP_FRAME_WAVE_CODEC
+#define ESP_FRAME_WAVE_CODEC 1
+#endif
+
+#if ESP_FRAME_WAVE_CODEC
+static AD_Codec_t s_frame_codec; /* 只在组帧（ESP 任务）里使用，统计见控制台 bin */
+#endif
+
 /* 串口打印开关（默认关闭，避免影响 UI/上报性能）
  * 需求：打印“瞬时值(每点)”：printf("%f,%f,%f,%f", ch1,ch2,ch3,ch4)
  * 注意：若 STEP=1 且采样点很多，会显著占用 CPU/串口带宽，调试用即可。 */
@@ -75,7 +97,7 @@ static inline int32_t ESP_FloatToI32Scaled(float v)
     return (int32_t)((x >= 0.0f) ? (x + 0.5f) : (x - 0.5f));
 }
 
-/* 安全追加格式化字符串到缓冲区（防止 http_packet_buf 越界导致“偶发坏帧/服务器解析失败/节点重连”） */
+/* 安全追加格式化字符串到缓冲区（防止发送段越界导致“偶发坏帧/服务器解析失败/节点重连”） */
 static inline int ESP_Appendf(char **pp, const char *end, const char *fmt, ...)
 {
     if (!pp || !*pp || !end || *pp >= end)
@@ -165,15 +187,27 @@ static void DCache_InvalidateByAddr_Any(void *addr, uint32_t len)
 
 /* ================= 内存分配 ================= */
 
-/* 发送缓冲区：512KB 放 SDRAM（LVGL 池之后 0xC0600000），支持 4 通道全量上传（4096 波形 + 1024 FFT/通道，step=1），且不占 AXI 避免 UI 卡死。 */
-#define HTTP_PACKET_BUF_SIZE      (524288u)
-#define HTTP_PACKET_BUF_SDRAM_ADDR ((uint8_t *)0xC0600000)
-static uint8_t *http_packet_buf;
+/* 上报发送缓冲：不再整包缓存正文，生成器按段填两块乒乓段，一段在 DMA 发的同时填另一段。
+ * 放 SDRAM（LVGL 池之后 0xC0600000，原 512KB 整包缓冲的位置，现只用开头约 41KB），不占 AXI 避免 UI 卡死。
+ * 每段前后留几字节给 chunked 的块头 "xxxx\r\n" / 块尾 "\r\n" 与终止块 "0\r\n\r\n"，加框架不用搬数据；
+ * 段长须放得下最大的一个二进制帧段（WAVE_Z 全量 4096 点最坏约 16.4KB，见 ad_codec.h 的 AD_CODEC_WORST_BYTES） */
+#ifndef ESP_TX_SEG_SIZE
+#define ESP_TX_SEG_SIZE 20480u
+#endif
+#define ESP_TX_SEG_PRE    8u
+#define ESP_TX_SEG_POST   8u
+#define ESP_TX_SEG_STRIDE ((ESP_TX_SEG_PRE + ESP_TX_SEG_SIZE + ESP_TX_SEG_POST + 31u) & ~31u)
+#define ESP_TX_HDR_SIZE   256u
+#define ESP_TX_SDRAM_ADDR ((uint8_t *)0xC0600000)
+
+static inline uint8_t *ESP_TxHdrBuf(void)
+{
+    return ESP_TX_SDRAM_ADDR;
+}
 
-static void ensure_http_packet_buf(void)
+static inline uint8_t *ESP_TxSegData(uint32_t i)
 {
-    if (http_packet_buf == NULL)
-        http_packet_buf = HTTP_PACKET_BUF_SDRAM_ADDR;
+    return ESP_TX_SDRAM_ADDR + ESP_TX_HDR_SIZE + i * ESP_TX_SEG_STRIDE + ESP_TX_SEG_PRE;
 }
 
 /* 简单的接收缓冲，用于 AT 指令阻塞接收 (AT模式下数据量小，且使用轮询，不需要DMA) */
@@ -186,9 +220,9 @@ static inline uint8_t ESP_RxBusyDetected(void)
            (strstr((char *)esp_rx_buf, "BUSY") != NULL);
 }
 
-/* 4 个通道的传感器数据结构体实例，用于存储电压、电流、FFT结果等
- * 4096 点波形 + 2048 点 FFT 时该结构体较大，放 AXI SRAM 避免 DTCM 溢出导致卡死。 */
-Channel_Data_t node_channels[4] AXI_SRAM_SECTION;
+/* 各启用通道的元数据与显示值（id/标签/单位/均值）
+ * 波形与 FFT 结果在 DSP 任务的结果快照里（SDRAM，见 ad_dsp.h），这里不再各存一份。 */
+Channel_Data_t node_channels[NODE_CHANNEL_COUNT];
 volatile uint8_t g_esp_ready = 0; // 全局标志：1 表示 WiFi/TCP 就绪，可以发送
 /* UI“开始/停止上报”开关：用于门控后台自动重连等行为 */
 static volatile uint8_t g_report_enabled = 0;
@@ -226,40 +260,42 @@ void ESP_Config_Apply(const SystemConfig_t *cfg)
     g_sys_cfg_loaded = 1;
 }
 
-/* DSP 相关变量：用于 FFT 计算 */
-static arm_rfft_fast_instance_f32 S;
-static uint8_t fft_initialized = 0;
-static float32_t fft_input_buf[WAVEFORM_POINTS] AXI_SRAM_SECTION;  // FFT 输入缓冲（避免破坏原波形）
-static float32_t fft_output_buf[WAVEFORM_POINTS] AXI_SRAM_SECTION; // FFT 输出复数数组
-static float32_t fft_mag_buf[WAVEFORM_POINTS] AXI_SRAM_SECTION;    // FFT 幅值数组
+/* 物理通道元数据（按 AD7606 V1~V8 排列），label 关键字与 api.py 识别规则对应：
+ * "直流"+"负/-" -> voltage_neg，"直流" -> voltage，"漏" -> leakage，"负载/电流" -> current */
+static const struct
+{
+    const char *label;
+    const char *unit;
+} s_ch_meta[8] = {
+    {"直流母线(+)", "V"},
+    {"直流母线(-)", "V"},
+    {"负载电流", "A"},
+    {"漏电流", "mA"},
+    {"组串电流1", "A"},
+    {"组串电流2", "A"},
+    {"漏电流2", "mA"},
+    {"漏电流3", "mA"},
+};
+
+static void ESP_Init_Channel_Meta(void)
+{
+    for (uint32_t i = 0; i < NODE_CHANNEL_COUNT; i++)
+    {
+        uint32_t phys = AD_Acq_PhysChannel(i);
+        node_channels[i].id = (uint8_t)phys;
+        strncpy(node_channels[i].label, s_ch_meta[phys].label, sizeof(node_channels[i].label) - 1);
+        strncpy(node_channels[i].unit, s_ch_meta[phys].unit, sizeof(node_channels[i].unit) - 1);
+    }
+}
 
 /* UI 模式/非 ESP_Init 路径也必须初始化通道元数据，否则后端会把 4 个通道都当成 id=0 覆盖成“一个通道” */
 static void ESP_Init_Channels_And_DSP(void)
 {
-    /* FFT init */
-    if (!fft_initialized)
-    {
-        arm_rfft_fast_init_f32(&S, WAVEFORM_POINTS);
-        fft_initialized = 1;
-    }
+    /* FFT 由 DSP 任务完成（ad_dsp.c），这里只准备通道元数据 */
 
     /* 通道元数据（与后端识别规则对应） */
     memset(node_channels, 0, sizeof(node_channels));
-    node_channels[0].id = 0;
-    strncpy(node_channels[0].label, "直流母线(+)", 31);
-    strncpy(node_channels[0].unit, "V", 7);
-
-    node_channels[1].id = 1;
-    strncpy(node_channels[1].label, "直流母线(-)", 31);
-    strncpy(node_channels[1].unit, "V", 7);
-
-    node_channels[2].id = 2;
-    strncpy(node_channels[2].label, "负载电流", 31);
-    strncpy(node_channels[2].unit, "A", 7);
-
-    node_channels[3].id = 3;
-    strncpy(node_channels[3].label, "漏电流", 31);
-    strncpy(node_channels[3].unit, "mA", 7);
+    ESP_Init_Channel_Meta();
 }
 
 /* 内部函数声明 */
@@ -267,8 +303,9 @@ static void ESP_Log(const char *format, ...);
 static uint8_t ESP_Send_Cmd(const char *cmd, const char *reply, uint32_t timeout);
 static uint8_t ESP_Send_Cmd_Any(const char *cmd, const char *reply1, const char *reply2, uint32_t timeout);
 static void ESP_Clear_Error_Flags(void);
-static int Helper_FloatArray_To_String(char **pp, const char *end, const float *data, int count, int step);
-static int Helper_FloatArray1dp_To_String(char **pp, const char *end, const float *data, int count, int step);
+static void ESP_Tx_Pump(void);
+static void ESP_Tx_Abort(const char *why);
+static uint8_t ESP_Spool_LinkDown(void);
 static void ESP_Exit_Transparent_Mode(void);
 static uint8_t ESP_Exit_Transparent_Mode_Strict(uint32_t timeout_ms);
 static void ESP_Uart2_Drain(uint32_t ms);
@@ -296,6 +333,22 @@ static uint8_t ESP_BufContains(const uint8_t *buf, uint16_t len, const char *nee
 // 当前上报的故障码（默认正常 E00），可通过串口控制台动态修改
 static char g_fault_code[4] = "E00";
 
+/* 瞬态录波触发时取当前故障码（采样中断上下文，只拷贝 3 个字符） */
+void AD_Trig_GetFaultCode(char code[4])
+{
+    code[0] = g_fault_code[0];
+    code[1] = g_fault_code[1];
+    code[2] = g_fault_code[2];
+    code[3] = 0;
+}
+
+/* 本地故障判定改变故障码（DSP 任务上下文，只改数字两位） */
+void AD_Fault_SetCode(const char code[4])
+{
+    g_fault_code[1] = code[1];
+    g_fault_code[2] = code[2];
+}
+
 // ---------- 串口控制台（调试串口 RX 中断） ----------
 static uint8_t g_console_rx_byte = 0;
 static volatile uint8_t g_console_line_ready = 0;
@@ -308,6 +361,9 @@ static volatile uint8_t g_server_reset_pending = 0;
 // 服务器请求的上报模式：0=summary, 1=full
 static volatile uint8_t g_server_report_full = 0;
 static volatile uint8_t g_server_report_full_dirty = 0;
+// 服务器请求的采样档位（0xFF=无），变化时置 dirty，由 ESP_Console_Poll 在任务里切换
+static volatile uint8_t g_server_acq_profile = 0xFFU;
+static volatile uint8_t g_server_acq_profile_dirty = 0;
 // 当检测到链路异常关键字（CLOSED/ERROR）时置 1，主循环触发软重连
 static volatile uint8_t g_link_reconnect_pending = 0;
 
@@ -336,30 +392,169 @@ static volatile uint32_t g_last_rx_tick = 0;     // 上次收到数据的时间
 static volatile uint8_t g_link_reconnecting = 0; // 是否正在重连中
 static uint8_t g_boot_hardreset_done = 0;        // 启动时是否已执行过硬复位
 
-/* HTTP 发送流控门控
- * 作用：发送 HTTP 请求后置为 1，收到回复或超时后置为 0。
- * 防止请求发送过快淹没服务器，导致 TCP 拥塞或解析错误。 */
-static volatile uint8_t g_waiting_http_response = 0;
-static volatile uint32_t g_waiting_http_tick = 0;
-
-/* 分段发送状态（仅用于 ESP_Post_Data 的大包上报） */
-typedef struct {
-    uint32_t total_len;
-    uint32_t offset;
-    uint32_t next_tick;
-    uint8_t  active;
-} esp_tx_chunk_t;
-static esp_tx_chunk_t g_tx_chunk = {0};
-
-/* 非分段 HTTP 发送链状态：header DMA -> body DMA */
-typedef enum {
-    ESP_HTTP_TX_IDLE = 0,
-    ESP_HTTP_TX_HEADER_INFLIGHT = 1,
-    ESP_HTTP_TX_BODY_INFLIGHT = 2,
-} esp_http_tx_phase_t;
-static volatile esp_http_tx_phase_t g_http_tx_phase = ESP_HTTP_TX_IDLE;
-static uint8_t *g_http_tx_body_ptr = NULL;
-static uint32_t g_http_tx_body_len = 0;
+#include "esp_http_win.h"
+
+/* ================= 上报流式发送（拉取式生成器 -> 乒乓段 -> UART DMA） =================
+ * 正文不整包缓存：生成器每次往空闲段里写到写满为止，TxCplt 发完一段接着发另一段，
+ * 任务循环（ESP_Post_* 每轮调用）把发空的段再填上。请求头在决定发送时立刻发出（chunked 模式）。 */
+typedef enum
+{
+    ESP_UP_SUMMARY = 0, /* 轻量 JSON -> /api/node/heartbeat */
+    ESP_UP_FULL_JSON,   /* 全量 JSON -> /api/node/heartbeat */
+    ESP_UP_FULL_BIN,    /* 全量二进制帧 -> /api/node/frame */
+    ESP_UP_SPOOL,       /* SD 缓存里的二进制帧原样补传 -> /api/node/frame */
+} esp_up_kind_t;
+
+typedef enum
+{
+    ESP_GEN_HEAD = 0,
+    ESP_GEN_CH_HEAD,  /* JSON 通道头（轻量上报含 stats）；二进制 CHAN 段 */
+    ESP_GEN_CH_WAVE,  /* 波形数组；二进制 WAVE / WAVE_Z 段 */
+    ESP_GEN_CH_SPEC,  /* 频谱数组；二进制 SPEC 段 */
+    ESP_GEN_CH_TAIL,  /* 谐波 + 通道收尾；二进制 HARM 段 */
+    ESP_GEN_CH_END,   /* channels 数组收尾 */
+    ESP_GEN_TONES,
+    ESP_GEN_CLASS,
+    ESP_GEN_ISO,
+    ESP_GEN_EV_HEAD,  /* 录波事件头；二进制 EVENT / EVENT_Z 整段 */
+    ESP_GEN_EV_CH_HEAD,
+    ESP_GEN_EV_CH_DATA,
+    ESP_GEN_EV_END,
+    ESP_GEN_SPOOL,    /* 二进制 SPOOL（实时帧的补传进度）/ TIME（缓存帧的采集时刻）段 */
+    ESP_GEN_TAIL,     /* JSON 结尾；二进制 CRC */
+    ESP_GEN_DONE,
+} esp_gen_stage_t;
+
+/* 发送开始时冻结的上报内容：Content-Length 模式要把正文生成两遍（先量长度再发），两遍必须逐字节相同，
+ * 会变的量（故障码、纹波跟踪、绝缘电阻、分类耗时、录波事件）都在这里取一次；DSP 快照在发送期间不换 */
+typedef struct
+{
+    uint32_t seq;
+    uint32_t tick;        /* 开始时刻：tones 的 age_ms 以此为准 */
+    char fault_code[4];
+    uint32_t wave_step;
+    uint32_t class_cyc;
+    uint32_t ntone;
+    AD_ToneResult_t tone[AD_TONE_MAX];
+    AD_IsoResult_t iso;
+    uint8_t has_ev;       /* 持有一个录波事件（发送结束后 Release） */
+    AD_TrigEvent_t ev;
+    uint32_t ev_step;
+    float ev_k[NODE_CHANNEL_COUNT];   /* 原始码 -> 工程量：(q - off) × k */
+    float ev_off[NODE_CHANNEL_COUNT];
+    uint8_t spooled;      /* 写进 SD 缓存的帧：帧头带 AD_FRAME_FLAG_SPOOL，附 TIME 段 */
+    uint8_t has_sp;       /* 附补传进度（缓存已就绪的实时上报） */
+    uint8_t sp_replaying;
+    uint32_t rtc_sec;
+    uint32_t sp_pending;
+    uint32_t sp_pending_ev;
+    uint32_t sp_kb;
+    uint32_t sp_replayed;
+    uint32_t sp_dropped;
+} esp_up_snap_t;
+
+/* 生成器游标：stage + 通道序号 + 数组内位置，任意位置可中断、下一段接着写 */
+typedef struct
+{
+    uint8_t kind;         /* esp_up_kind_t */
+    uint8_t stage;        /* esp_gen_stage_t */
+    uint8_t ch;
+    uint8_t err;          /* 单元放不进空段（不应发生） */
+    uint32_t pos;
+    uint16_t sections;    /* 二进制帧段数（开始时按快照算好写进帧头） */
+    AD_FrameWriter_t w;
+} esp_up_gen_t;
+
+/* 一块待发区：请求头或一个发送段（chunked 时已含块头块尾） */
+typedef struct
+{
+    uint8_t *tx;
+    uint32_t tx_len;
+    uint32_t tx_off;          /* 已交给 DMA 的字节 */
+    volatile uint8_t ready;   /* 任务填好置 1，发完由 TxCplt 清 0 */
+    uint8_t last;             /* 本请求的最后一块 */
+} esp_tx_span_t;
+
+typedef struct
+{
+    volatile uint8_t active;  /* 有请求在发：期间 DSP 快照冻结，不开始新请求 */
+    volatile uint8_t dma_busy;
+    volatile uint8_t done;    /* 最后一块已发完，等任务收尾 */
+    uint8_t chunked;
+    uint8_t gen_done;         /* 生成器已写完（最后一段已交出） */
+    uint8_t fill;             /* 下一个要填的段 */
+    volatile uint8_t send;    /* 下一个要发的段 */
+    uint8_t kind;
+    esp_tx_span_t hdr;
+    esp_tx_span_t seg[2];
+    esp_tx_span_t *volatile cur;
+    volatile uint32_t burst;
+    uint32_t burst_max;       /* 每次 DMA 最多字节：chunk_kb × 1024；0 = 不限（≤ 65535） */
+    uint32_t delay_ms;        /* 两次 DMA 之间的间隔：chunk_delay_ms；0 = TxCplt 里直接续发 */
+    volatile uint32_t next_tick;
+    volatile uint32_t progress_tick;
+    uint32_t t0_cyc;          /* 决定发送时刻（DWT 周期），统计首字节延迟 */
+    uint32_t t0_tick;
+    uint8_t first_sent;
+    uint32_t body_len;        /* 正文字节（生成器输出，不含 chunked 框架） */
+    uint32_t segs;
+    esp_up_snap_t snap;
+    esp_up_gen_t gen;
+} esp_tx_stream_t;
+
+/* 流式发送统计（控制台 tx） */
+typedef struct
+{
+    uint32_t requests;
+    uint32_t aborts;
+    uint32_t busy;            /* 决定发送时 UART 仍忙，本轮放弃 */
+    volatile uint32_t underruns; /* DMA 发完一段时下一段还没填好（UART 空等） */
+    uint32_t bytes;
+    uint32_t last_body;
+    uint32_t last_segs;
+    uint32_t last_ms;         /* 最近一次从决定发送到最后一字节交给 DMA */
+    uint32_t first_us;        /* 最近一次首字节延迟 */
+    uint32_t first_us_max;
+    uint32_t fill_us_max;     /* 填一段的最长耗时 */
+    uint32_t measure_us;      /* Content-Length 模式最近一次量长度的耗时 */
+} esp_tx_stats_t;
+
+static esp_tx_stream_t s_tx;
+static esp_tx_stats_t s_tx_stats;
+/* 上报序号：轻量/全量共用一个计数，回包里的 "seq" 按它对应在途请求（0 留给不带序号的最小心跳） */
+static uint32_t s_up_seq = 0;
+
+/* 断线缓存（store-and-forward）：链路断开/停滞期间把二进制帧写进 SD（sd_spool.c），恢复后限速补传。
+ * 写缓存和补传都在上报任务里；补传请求复用流式发送，正文从 SD 边读边发，回包按 seq 在在途窗口里对上 */
+typedef struct
+{
+    uint8_t ready;             /* SD_Spool_Init 成功 */
+    uint8_t inflight;          /* 有一条补传请求在发或在途 */
+    volatile uint8_t result;   /* 在途补传的结果：0=未出 1=送达 2=失败（窗口出队时写，关中断/中断里） */
+    uint8_t tries;             /* 当前记录已失败次数 */
+    char last_fault[4];        /* 上次写缓存/上报时的故障码：变化即写事件级记录 */
+    uint32_t seq_boot;         /* 上电扫描时盘上的最大序号：更大的记录是本次上电写的，tick 可直接比 */
+    uint8_t cap_err;           /* 上次写缓存失败：事件不再立即写，等下一个间隔 */
+    uint32_t ack_tick;         /* 最近一次 2xx 回包（窗口出队时写） */
+    uint32_t ack_sent;         /* 那时已发出的请求数：之后又发过请求且久未回包 = 链路停滞 */
+    uint32_t init_tick;
+    uint32_t cap_tick;
+    uint32_t replay_tick;
+    uint32_t backoff_ms;
+    uint32_t captured;
+    uint32_t cap_fail;
+    uint32_t replay_ok;
+    uint32_t replay_fail;
+    SD_SpoolRec_t rec;         /* 正在补传的记录 */
+} esp_spool_t;
+
+static esp_spool_t s_spool;
+static volatile uint32_t g_spool_interval_ms = (uint32_t)ESP_SPOOL_INTERVAL_MS;
+static volatile uint32_t g_spool_replay_ms = (uint32_t)ESP_SPOOL_REPLAY_MS;
+
+static void ESP_Up_Snapshot(esp_up_snap_t *sn, esp_up_kind_t kind, uint32_t seq);
+static void ESP_Up_GenReset(esp_up_gen_t *g, esp_up_kind_t kind, const esp_up_snap_t *sn);
+static uint32_t ESP_Up_GenFill(esp_up_gen_t *g, const esp_up_snap_t *sn, uint8_t *buf, uint32_t cap);
 
 /* ================= 通讯参数（运行时缓存） =================
  * 由 SD 文件 0:/config/ui_param.cfg 加载；若未加载则使用宏默认值。
@@ -372,6 +567,9 @@ static volatile uint32_t g_comm_hardreset_sec   = (uint32_t)ESP_NO_SERVER_RX_HAR
 static volatile uint32_t g_comm_wave_step       = (uint32_t)WAVEFORM_SEND_STEP;
 static volatile uint32_t g_comm_chunk_kb        = (uint32_t)ESP_CHUNK_KB_DEFAULT;
 static volatile uint32_t g_comm_chunk_delay_ms  = (uint32_t)ESP_CHUNK_DELAY_MS_DEFAULT;
+static volatile uint32_t g_comm_frame_fmt       = (uint32_t)ESP_FRAME_FMT_DEFAULT;
+static volatile uint32_t g_comm_http_chunked    = (uint32_t)ESP_HTTP_CHUNKED_DEFAULT;
+static volatile uint32_t g_comm_http_window     = (uint32_t)ESP_HTTP_WINDOW_DEFAULT;
 
 /* USART2 流式接收：DMA Circular + IDLE/TC/HT 回调中按“写指针”增量取数据，避免每次回调停/启 DMA 产生空窗导致 ORE。 */
 static volatile uint16_t g_stream_rx_last_pos = 0;
@@ -390,6 +588,9 @@ uint32_t ESP_CommParams_HardResetSec(void)  { return (uint32_t)g_comm_hardreset_
 uint32_t ESP_CommParams_WaveStep(void)      { return (uint32_t)g_comm_wave_step; }
 uint32_t ESP_CommParams_ChunkKb(void)       { return (uint32_t)g_comm_chunk_kb; }
 uint32_t ESP_CommParams_ChunkDelayMs(void)  { return (uint32_t)g_comm_chunk_delay_ms; }
+uint32_t ESP_CommParams_FrameFmt(void)      { return (uint32_t)g_comm_frame_fmt; }
+uint32_t ESP_CommParams_HttpChunked(void)   { return (uint32_t)g_comm_http_chunked; }
+uint32_t ESP_CommParams_HttpWindow(void)    { return (uint32_t)g_comm_http_window; }
 
 void ESP_CommParams_Get(ESP_CommParams_t *out)
 {
@@ -401,6 +602,9 @@ void ESP_CommParams_Get(ESP_CommParams_t *out)
     out->wave_step       = (uint32_t)g_comm_wave_step;
     out->chunk_kb        = (uint32_t)g_comm_chunk_kb;
     out->chunk_delay_ms  = (uint32_t)g_comm_chunk_delay_ms;
+    out->frame_fmt       = (uint32_t)g_comm_frame_fmt;
+    out->http_chunked    = (uint32_t)g_comm_http_chunked;
+    out->http_window     = (uint32_t)g_comm_http_window;
 }
 
 static uint32_t clamp_u32(uint32_t v, uint32_t lo, uint32_t hi)
@@ -422,6 +626,9 @@ void ESP_CommParams_Apply(const ESP_CommParams_t *p)
     uint32_t ckb   = p->chunk_kb;
     if (ckb > 16u) ckb = 16u; /* 允许 0 表示“关闭分段” */
     uint32_t cdly  = clamp_u32(p->chunk_delay_ms,  0u,   200u);
+    uint32_t fmt   = (p->frame_fmt == ESP_FRAME_FMT_BINARY) ? ESP_FRAME_FMT_BINARY : ESP_FRAME_FMT_JSON;
+    uint32_t chunked = (p->http_chunked != 0u) ? 1u : 0u;
+    uint32_t win   = clamp_u32(p->http_window,     1u,   (uint32_t)ESP_HTTP_WINDOW_MAX);
 
     g_comm_heartbeat_ms    = hb;
     g_comm_min_interval_ms = minit;
@@ -430,11 +637,15 @@ void ESP_CommParams_Apply(const ESP_CommParams_t *p)
     g_comm_wave_step       = step;
     g_comm_chunk_kb        = ckb;
     g_comm_chunk_delay_ms  = cdly;
+    g_comm_frame_fmt       = fmt;
+    g_comm_http_chunked    = chunked;
+    g_comm_http_window     = win;
 
 #if (ESP_DEBUG)
-    ESP_Log("[PARAM] apply hb=%lums min=%lums http=%lums hrs=%lus step=%lu chunk=%luKB delay=%lums\r\n",
+    ESP_Log("[PARAM] apply hb=%lums min=%lums http=%lums hrs=%lus step=%lu chunk=%luKB delay=%lums fmt=%s body=%s win=%lu\r\n",
             (unsigned long)hb, (unsigned long)minit, (unsigned long)http, (unsigned long)hrs,
-            (unsigned long)step, (unsigned long)ckb, (unsigned long)cdly);
+            (unsigned long)step, (unsigned long)ckb, (unsigned long)cdly, fmt ? "bin" : "json",
+            chunked ? "chunked" : "length", (unsigned long)win);
 #endif
 }
 
@@ -523,6 +734,33 @@ bool ESP_CommParams_LoadFromSD(void)
         } else if (strncmp(line, "CHUNK_DELAY_MS=", 15) == 0) {
             uint32_t v;
             if (cfg_parse_u32_relaxed(line + 15, &v)) p.chunk_delay_ms = v;
+        } else if (strncmp(line, "FRAME_FMT=", 10) == 0) {
+            /* 0=JSON 1=二进制帧（服务器需支持 /api/node/frame） */
+            uint32_t v;
+            if (cfg_parse_u32_relaxed(line + 10, &v)) p.frame_fmt = v;
+        } else if (strncmp(line, "HTTP_CHUNKED=", 13) == 0) {
+            /* 1=分块传输 0=Content-Length（服务器不支持分块请求体时） */
+            uint32_t v;
+            if (cfg_parse_u32_relaxed(line + 13, &v)) p.http_chunked = v;
+        } else if (strncmp(line, "HTTP_WINDOW=", 12) == 0) {
+            /* 在途请求窗口（1=发一个等一个） */
+            uint32_t v;
+            if (cfg_parse_u32_relaxed(line + 12, &v)) p.http_window = v;
+        } else if (strncmp(line, "ACQ_PROFILE=", 12) == 0) {
+            /* 采样档位不属于通讯参数缓存，读到即提交切换（下一个采样块生效） */
+            uint32_t v;
+            if (cfg_parse_u32_relaxed(line + 12, &v) && v != AD_Acq_ActiveProfile())
+                (void)AD_Acq_RequestProfile(v);
+        } else if (strncmp(line, "SPOOL_QUOTA_MB=", 15) == 0) {
+            /* 断线缓存参数同样不在通讯参数缓存里，读到即生效 */
+            uint32_t v;
+            if (cfg_parse_u32_relaxed(line + 15, &v)) SD_Spool_SetQuotaMb(v);
+        } else if (strncmp(line, "SPOOL_INTERVAL_MS=", 18) == 0) {
+            uint32_t v;
+            if (cfg_parse_u32_relaxed(line + 18, &v)) g_spool_interval_ms = clamp_u32(v, 1000u, 600000u);
+        } else if (strncmp(line, "SPOOL_REPLAY_MS=", 16) == 0) {
+            uint32_t v;
+            if (cfg_parse_u32_relaxed(line + 16, &v)) g_spool_replay_ms = clamp_u32(v, 100u, 60000u);
         }
     }
     (void)f_close(&fil);
@@ -781,11 +1019,9 @@ static void ESP_ForceStop_DMA(void)
 
     // 5) 更新软件状态标志
     g_usart2_rx_started = 0;
-    g_waiting_http_response = 0;
     g_stream_rx_last_pos = 0;
-    g_http_tx_phase = ESP_HTTP_TX_IDLE;
-    g_http_tx_body_ptr = NULL;
-    g_http_tx_body_len = 0;
+    ESP_HttpWin_Reset();
+    ESP_Tx_Abort("强制停止 DMA");
 }
 
 /**
@@ -852,14 +1088,7 @@ void ESP_Init(void)
     HAL_GPIO_WritePin(ESP8266_RST_GPIO_Port, ESP8266_RST_Pin, GPIO_PIN_SET);
 #endif
 
-    // 初始化 DSP 库 (FFT)
-    if (!fft_initialized)
-    {
-        arm_rfft_fast_init_f32(&S, WAVEFORM_POINTS);
-        fft_initialized = 1;
-    }
-
-    ESP_Log("\r\n[ESP] 初始化（4通道模式）...\r\n");
+    ESP_Log("\r\n[ESP] 初始化（%u通道模式）...\r\n", (unsigned)NODE_CHANNEL_COUNT);
     ESP_Log("[ESP] WiFi 名称(SSID): %s\r\n", g_sys_cfg.wifi_ssid);
     ESP_Log("[ESP] 服务器地址: %s:%d\r\n", g_sys_cfg.server_ip, g_sys_cfg.server_port);
     ESP_Clear_Error_Flags();
@@ -998,7 +1227,7 @@ void ESP_Init(void)
     // 发送注册包 (告诉服务器我是谁)
     ESP_Register();
     g_esp_ready = 1;
-    ESP_Log("[ESP] 系统就绪（4通道）,开始上报数据。\r\n");
+    ESP_Log("[ESP] 系统就绪（%u通道）,开始上报数据。\r\n", (unsigned)NODE_CHANNEL_COUNT);
 
     // 步骤 5: 启动 USART2 接收（DMA + IDLE）
     // 用于接收 /api/node/heartbeat 的响应中的 command/reset
@@ -1006,26 +1235,8 @@ void ESP_Init(void)
     g_uart2_at_mode = 0;
     ESP_StreamRx_Start();
 
-    /* === 初始化 4 个通道的元数据 (与 api.py 逻辑严格对应) === */
-    // Channel 0: 直流母线(+) -> api.py 识别 "直流" 且无 "负/-" -> voltage
-    node_channels[0].id = 0;
-    strncpy(node_channels[0].label, "直流母线(+)", 31);
-    strncpy(node_channels[0].unit, "V", 7);
-
-    // Channel 1: 直流母线(-) -> api.py 识别 "直流" 且有 "负/-" -> voltage_neg
-    node_channels[1].id = 1;
-    strncpy(node_channels[1].label, "直流母线(-)", 31);
-    strncpy(node_channels[1].unit, "V", 7);
-
-    // Channel 2: 负载电流 -> api.py 识别 "负载" 或 "电流" -> current
-    node_channels[2].id = 2;
-    strncpy(node_channels[2].label, "负载电流", 31);
-    strncpy(node_channels[2].unit, "A", 7);
-
-    // Channel 3: 漏电流 -> api.py 识别 "漏" -> leakage
-    node_channels[3].id = 3;
-    strncpy(node_channels[3].label, "漏电流", 31);
-    strncpy(node_channels[3].unit, "mA", 7);
+    /* === 初始化各通道的元数据 (与 api.py 逻辑严格对应) === */
+    ESP_Init_Channel_Meta();
 }
 
 #if 0
@@ -1092,32 +1303,22 @@ static void Process_Channel_Data(int ch_id, float base_dc, float ripple_amp, flo
 }
 #endif
 
+/* 上报链路作为 DSP 结果快照的一个读者：持有最近一次取得的快照，直到取到更新的一份再释放 */
+static AD_DspReader_t s_dsp_reader = {0};
+static const AD_DspResult_t *s_dsp_res = NULL;
+/* 最近一次快照的采样参数（随波形/FFT 一起上报，频率轴 = k × sample_rate / WAVEFORM_POINTS） */
+static uint32_t s_blk_sample_rate = 0;
+static uint8_t s_blk_os_mode = 0;
+static uint8_t s_blk_profile = 0;
+
 void ESP_Update_Data_And_FFT(void)
 {
     static uint32_t last_calc_tick = 0;
-    static uint8_t last_ready = 0;
     uint32_t min_itv = ESP_CommParams_MinIntervalMs();
     uint32_t now = HAL_GetTick();
 
-    if (!fft_initialized)
-    {
-        arm_rfft_fast_init_f32(&S, WAVEFORM_POINTS);
-        fft_initialized = 1;
-    }
-
-    uint8_t ready = 0;
-    float (*src)[WAVEFORM_POINTS] = NULL;
-    if (ADS131A04_flag == 1 && last_ready != 1)
-    {
-        ready = 1;
-        src = ADSA_B;
-    }
-    else if (ADS131A04_flag2 == 2 && last_ready != 2)
-    {
-        ready = 2;
-        src = ADSA_B2;
-    }
-    else
+    /* 上报正在边生成边发送：正文引用着当前快照，发完之前不换 */
+    if (s_tx.active)
     {
         return;
     }
@@ -1129,55 +1330,50 @@ void ESP_Update_Data_And_FFT(void)
             return;
         }
     }
+
+    /* 取 DSP 任务发布的最新快照（波形/频谱/统计量都已算好，这里不拷贝也不计算） */
+    const AD_DspResult_t *res;
+    if (!AD_Dsp_AcquireLatest(&s_dsp_reader, &res))
+    {
+        return;
+    }
+    if (s_dsp_res)
+    {
+        AD_Dsp_Release(s_dsp_res);
+    }
+    s_dsp_res = res;
     last_calc_tick = now;
+    s_blk_sample_rate = res->sample_rate;
+    s_blk_os_mode = res->os_mode;
+    s_blk_profile = res->profile;
 
-    double sum0 = 0.0, sum1 = 0.0, sum2 = 0.0, sum3 = 0.0;
+#if (ESP_PRINT_WAVEFORM_POINTS)
+    /* 瞬时值(每点)：默认每点都打；可通过 ESP_PRINT_POINT_STEP 降频 */
     for (int i = 0; i < WAVEFORM_POINTS; i++)
     {
-        float v0 = src[0][i];
-        float v1 = src[1][i];
-        float v2 = src[2][i];
-        float v3 = src[3][i];
-#if (ESP_PRINT_WAVEFORM_POINTS)
-        /* 瞬时值(每点)：默认每点都打；可通过 ESP_PRINT_POINT_STEP 降频 */
         if ((ESP_PRINT_POINT_STEP <= 1) || ((i % ESP_PRINT_POINT_STEP) == 0))
         {
-            printf("%f,%f,%f,%f\r\n", (double)v0, (double)v1, (double)v2, (double)v3);
+            for (int ch = 0; ch < NODE_CHANNEL_COUNT; ch++)
+            {
+                printf((ch == 0) ? "%f" : ",%f", (double)res->wave[ch][i]);
+            }
+            printf("\r\n");
         }
-#endif
-        node_channels[0].waveform[i] = v0;
-        node_channels[1].waveform[i] = v1;
-        node_channels[2].waveform[i] = v2;
-        node_channels[3].waveform[i] = v3;
-        sum0 += (double)v0;
-        sum1 += (double)v1;
-        sum2 += (double)v2;
-        sum3 += (double)v3;
-        /* 每 1024 点让出 CPU，避免长时间占用导致 UI 卡死（4096 点波形） */
-        if ((i + 1) % 1024 == 0)
-            osDelay(0);
     }
+#endif
 
-    node_channels[0].current_value = ESP_SafeFloat((float)(sum0 / (double)WAVEFORM_POINTS));
-    node_channels[1].current_value = ESP_SafeFloat((float)(sum1 / (double)WAVEFORM_POINTS));
-    node_channels[2].current_value = ESP_SafeFloat((float)(sum2 / (double)WAVEFORM_POINTS));
-    node_channels[3].current_value = ESP_SafeFloat((float)(sum3 / (double)WAVEFORM_POINTS));
-
-    for (int ch = 0; ch < 4; ch++)
+    const AD7606_CalTable_t *cal = AD7606_Cal_Acquire();
+    for (int ch = 0; ch < NODE_CHANNEL_COUNT; ch++)
     {
-        memcpy(fft_input_buf, node_channels[ch].waveform, sizeof(fft_input_buf));
-        arm_rfft_fast_f32(&S, fft_input_buf, fft_output_buf, 0);
-        arm_cmplx_mag_f32(fft_output_buf, fft_mag_buf, WAVEFORM_POINTS / 2);
-        node_channels[ch].fft_data[0] = 0;
-        for (int i = 1; i < FFT_POINTS; i++)
+        node_channels[ch].current_value = ESP_SafeFloat(res->stats[ch].mean);
+        /* 标定表指定了单位时覆盖默认单位 */
+        const char *unit = cal->ch[node_channels[ch].id].unit;
+        if (unit[0] != '\0')
         {
-            node_channels[ch].fft_data[i] = (fft_mag_buf[i] / (float)(WAVEFORM_POINTS / 2)) * 2.0f;
+            strncpy(node_channels[ch].unit, unit, sizeof(node_channels[ch].unit) - 1);
         }
-        /* 每通道 FFT 完成后让出 CPU，避免 4 通道连续计算导致 UI 卡死 */
-        osDelay(0);
     }
-
-    last_ready = ready;
+    AD7606_Cal_Release(cal);
 }
 
 static void StrTrimInPlace(char *s)
@@ -1239,593 +1435,1423 @@ static void ESP_Console_HandleLine(char *line)
     {
         ESP_Log("[控制台] 可用命令：\r\n");
         ESP_Log("  - E00/E01/E02... ：切换上报故障码\r\n");
+        ESP_Log("  - cal            ：从 SD 重新加载通道标定表\r\n");
+        ESP_Log("  - cal zero [掩码]：输入短接后学习零点（默认全部通道，如 cal zero 3）\r\n");
+        ESP_Log("  - cal save       ：把当前标定表写回 SD\r\n");
+        ESP_Log("  - trig [reload]  ：瞬态录波统计 / 从 SD 重载触发配置\r\n");
+        ESP_Log("  - acq [档位]     ：查看 / 切换采样档位（采样率 + 过采样）\r\n");
+        ESP_Log("  - decim          ：多速率抽取统计与最新趋势值\r\n");
+        ESP_Log("  - psd [参数]     ：Welch PSD 状态与谐波 / psd hann|flattop|ov 50|exp 8|lin 16\r\n");
+        ESP_Log("  - tone [参数]    ：纹波跟踪结果 / tone 序号 物理通道 频率(0=删除) / tone win 毫秒\r\n");
+        ESP_Log("  - fault [参数]   ：本地故障判定状态 / fault reload（SD 重载规则）/ fault reset\r\n");
+        ESP_Log("  - class [reload] ：故障分类模型状态与推理耗时 / class reload（重新加载模型文件）\r\n");
+        ESP_Log("  - arc [reload]   ：电弧检测状态与每块耗时 / arc reload（SD 重载配置）\r\n");
+        ESP_Log("  - bin [on|off]   ：全量上报格式（二进制帧 /api/node/frame 或 JSON）与波形压缩统计\r\n");
+        ESP_Log("  - tx [chunked|length]：上报发送统计（首字节延迟、欠载、在途窗口、RTT、吞吐）/ 切换 chunked 或 Content-Length\r\n");
+        ESP_Log("  - tx win N       ：在途请求窗口（1..%u，1=发一个等一个）\r\n", (unsigned)ESP_HTTP_WINDOW_MAX);
+        ESP_Log("  - spool [rescan] ：断线缓存（SD 存储转发）待补传 / 已补传 / 丢弃统计 / 重新扫描缓存目录\r\n");
         ESP_Log("  - help 或 ?      ：显示帮助\r\n");
         return;
     }
 
-    // 格式: E01
-    if ((line[0] == 'E' || line[0] == 'e') && strlen(line) == 3)
+    // 格式: cal / cal zero [mask] / cal save
+    if (strncmp(line, "cal", 3) == 0 && (line[3] == 0 || line[3] == ' ' || line[3] == '\t'))
     {
-        ESP_SetFaultCode(line);
+        char *p = line + 3;
+        while (*p == ' ' || *p == '\t')
+            p++;
+        if (*p == 0 || strcmp(p, "reload") == 0)
+        {
+            bool ok = AD7606_Cal_LoadFromSD();
+            ESP_Log("[控制台] 标定表重载%s\r\n", ok ? "成功" : "失败（无文件或 SD 不可用）");
+        }
+        else if (strncmp(p, "zero", 4) == 0)
+        {
+            uint32_t mask = (uint32_t)strtoul(p + 4, NULL, 0);
+            if (mask == 0U)
+                mask = AD_ACQ_CH_MASK;
+            ESP_Log("[控制台] 学习零点 mask=0x%02lX，请保持输入短接...\r\n", (unsigned long)mask);
+            if (AD_Acq_LearnZero(mask, 4U, 3000U))
+            {
+                const AD7606_CalTable_t *t = AD7606_Cal_Acquire();
+                for (int ch = 0; ch < NODE_CHANNEL_COUNT; ch++)
+                {
+                    uint32_t phys = AD_Acq_PhysChannel((uint32_t)ch);
+                    ESP_Log("  CH%lu offset=%.2f LSB\r\n", (unsigned long)phys, (double)t->ch[phys].offset);
+                }
+                AD7606_Cal_Release(t);
+                ESP_Log("[控制台] 已生效；输入 cal save 持久化\r\n");
+            }
+            else
+            {
+                ESP_Log("[控制台] 零点学习超时（采样未运行？）\r\n");
+            }
+        }
+        else if (strcmp(p, "save") == 0)
+        {
+            ESP_Log("[控制台] 标定表保存%s\r\n", AD7606_Cal_SaveToSD() ? "成功" : "失败");
+        }
+        else
+        {
+            ESP_Log("[控制台] 用法: cal | cal zero [mask] | cal save\r\n");
+        }
         return;
     }
 
-    // 格式: fault E01
-    if (strncmp(line, "fault", 5) == 0)
+    // 格式: trig / trig reload
+    if (strncmp(line, "trig", 4) == 0)
     {
-        char *p = line + 5;
+        char *p = line + 4;
         while (*p == ' ' || *p == '\t')
             p++;
-        if (strlen(p) == 3 && (p[0] == 'E' || p[0] == 'e'))
+        if (strcmp(p, "reload") == 0)
         {
-            ESP_SetFaultCode(p);
+            ESP_Log("[控制台] 触发配置重载%s\r\n", AD_Trig_LoadFromSD() ? "成功" : "失败（无文件、参数非法或 SD 不可用）");
             return;
         }
-    }
-
-    ESP_Log("[控制台] 未识别命令: %s（输入 help 查看帮助）\r\n", line);
-}
-
-static void ESP_SetServerReportMode(uint8_t full)
-{
-    full = (full != 0U) ? 1U : 0U;
-    if (g_server_report_full != full)
-    {
-        g_server_report_full = full;
-        g_server_report_full_dirty = 1U;
-    }
-}
-
-void ESP_Console_Init(void)
-{
-#if (ESP_CONSOLE_ENABLE)
-    UART_HandleTypeDef *hu = ESP_GetLogUart(); // 默认 USART1
-    if (!hu)
+        AD_TrigConfig_t cfg;
+        AD_TrigStats_t st;
+        AD_Trig_GetConfig(&cfg);
+        AD_Trig_GetStats(&st);
+        ESP_Log("[控制台] 录波 pre=%lu post=%lu holdoff=%lums，事件=%lu，无空槽丢弃=%lu\r\n",
+                (unsigned long)cfg.pre_frames, (unsigned long)cfg.post_frames, (unsigned long)cfg.holdoff_ms,
+                (unsigned long)st.events, (unsigned long)st.no_slot);
+        for (int ch = 0; ch < NODE_CHANNEL_COUNT; ch++)
+        {
+            uint32_t phys = AD_Acq_PhysChannel((uint32_t)ch);
+            ESP_Log("  CH%lu %s level=%.3f fired=%lu\r\n", (unsigned long)phys,
+                    AD_Trig_TypeName(cfg.ch[phys].type), (double)cfg.ch[phys].level,
+                    (unsigned long)st.fired_ch[phys]);
+        }
         return;
-
-    // 启动 1 字节 RX 中断（比主循环轮询稳定，避免“输入了但没反应”）
-    HAL_UART_Receive_IT(hu, &g_console_rx_byte, 1);
-    ESP_Log("[控制台] 已启用：输入 E01 回车注入故障；输入 E00 回车清除。\r\n");
-#endif
-}
-
-/**
- * @brief  控制台轮询任务
- * @note   在主循环中调用，处理用户输入和服务器指令
- */
-void ESP_Console_Poll(void)
-{
-#if (ESP_CONSOLE_ENABLE)
-    uint32_t now = HAL_GetTick();
-    // 1) 处理“已收到的一整行”控制台指令
-    if (g_console_line_ready)
-    {
-        g_console_line_ready = 0;
-        g_console_line[g_console_line_len] = 0;
-        ESP_Console_HandleLine(g_console_line);
-        g_console_line_len = 0;
-    }
-
-    // 2) 处理“服务器下发 reset”指令
-    if (g_server_reset_pending)
-    {
-        g_server_reset_pending = 0;
-        ESP_Log("[服务器命令] 收到 reset：清除故障码 -> E00\r\n");
-        ESP_SetFaultCode("E00");
     }
 
-    // 2.0) 处理“服务器下发 report_mode”指令
-    if (g_server_report_full_dirty)
+    // 格式: acq / acq 2
+    if (strncmp(line, "acq", 3) == 0)
     {
-        g_server_report_full_dirty = 0;
-        if (g_server_report_full)
+        char *p = line + 3;
+        while (*p == ' ' || *p == '\t')
+            p++;
+        if (*p != 0)
         {
-            ESP_Log("[服务器命令] report_mode=full：请求全量上报\r\n");
+            uint32_t idx = (uint32_t)strtoul(p, NULL, 10);
+            const AD_AcqProfile_t *prof = AD_Acq_GetProfile(idx);
+            if (prof && AD_Acq_RequestProfile(idx))
+                ESP_Log("[控制台] 采样档位 -> %lu (%s)，下一个采样块生效\r\n", (unsigned long)idx, prof->name);
+            else
+                ESP_Log("[控制台] 采样档位 %s 无效或时序不可行\r\n", p);
+            return;
         }
-        else
+        ESP_Log("[控制台] 当前采样档位 %lu：%luHz，OS=%u\r\n", (unsigned long)AD_Acq_ActiveProfile(),
+                (unsigned long)AD_Acq_SampleRate(), (unsigned)AD_Acq_OsMode());
+        for (uint32_t i = 0; i < AD_ACQ_PROFILE_COUNT; i++)
         {
-            ESP_Log("[服务器命令] report_mode=summary：关闭全量上报\r\n");
+            const AD_AcqProfile_t *prof = AD_Acq_GetProfile(i);
+            ESP_Log("  %lu: %s\r\n", (unsigned long)i, prof->name);
         }
+        return;
     }
 
-    // 2.1) 链路异常：尽快软重连，避免长时间“卡住”
-    if (g_report_enabled && g_link_reconnect_pending && g_esp_ready && !g_link_reconnecting && !g_uart2_at_mode)
+    // 格式: decim
+    if (strcmp(line, "decim") == 0)
     {
-        g_link_reconnect_pending = 0;
-        ESP_Log("[ESP] 侦测到链路异常关键字,触发软重连...\r\n");
-        ESP_SoftReconnect();
+        AD_DecimStats_t st;
+        AD_DecimReader_t rd;
+        float v[AD_ACQ_CHANNELS];
+        uint32_t idx = 0;
+        AD_Decim_GetStats(&st);
+        ESP_Log("[控制台] 抽取 块=%lu 不连续=%lu，MID %.1fSPS 帧=%lu，TREND %.2fSPS 帧=%lu\r\n",
+                (unsigned long)st.blocks, (unsigned long)st.gaps,
+                (double)AD_Decim_SampleRate(AD_DECIM_MID), (unsigned long)st.frames[AD_DECIM_MID],
+                (double)AD_Decim_SampleRate(AD_DECIM_TREND), (unsigned long)st.frames[AD_DECIM_TREND]);
+        AD_Decim_ReaderInit(AD_DECIM_TREND, &rd, 1U);
+        if (AD_Decim_Read(AD_DECIM_TREND, &rd, v, 1U, &idx) == 1U)
+        {
+            for (int ch = 0; ch < NODE_CHANNEL_COUNT; ch++)
+                ESP_Log("  CH%lu trend[%lu]=%.4f\r\n", (unsigned long)AD_Acq_PhysChannel((uint32_t)ch),
+                        (unsigned long)idx, (double)v[ch]);
+        }
+        return;
     }
 
-#if (ESP_DEBUG && ESP_DEBUG_STATS)
-    // 3) 调试：每 1 秒输出一次统计信息 (确认 RX 是否存活)
-    static uint32_t last_dbg = 0;
-    if ((now - last_dbg) >= 1000)
+    // 格式: psd / psd hann / psd flattop / psd ov 50 / psd exp 8 / psd lin 16
+    if (strncmp(line, "psd", 3) == 0)
     {
-        last_dbg = now;
-        ESP_Log("[调试] USART2 RX: started=%d, events=%lu, bytes=%lu, restart=%lu\r\n",
-                (int)g_usart2_rx_started,
-                (unsigned long)g_usart2_rx_events,
-                (unsigned long)g_usart2_rx_bytes,
-                (unsigned long)g_usart2_rx_restart);
-        ESP_Log("[调试] USART2 ERR: total=%lu, ORE=%lu, FE=%lu, NE=%lu, PE=%lu\r\n",
-                (unsigned long)g_uart2_err,
-                (unsigned long)g_uart2_err_ore,
-                (unsigned long)g_uart2_err_fe,
-                (unsigned long)g_uart2_err_ne,
-                (unsigned long)g_uart2_err_pe);
+        char *p = line + 3;
+        AD_PsdConfig_t cfg;
+        while (*p == ' ' || *p == '\t')
+            p++;
+        AD_Psd_GetConfig(&cfg);
+        if (*p != 0)
+        {
+            if (strcmp(p, "hann") == 0)
+                cfg.window = AD_PSD_WIN_HANN;
+            else if (strcmp(p, "flattop") == 0)
+                cfg.window = AD_PSD_WIN_FLATTOP;
+            else if (strncmp(p, "ov", 2) == 0)
+                cfg.overlap_pct = (uint8_t)strtoul(p + 2, NULL, 10);
+            else if (strncmp(p, "exp", 3) == 0)
+            {
+                cfg.avg_mode = AD_PSD_AVG_EXP;
+                cfg.avg_n = (uint16_t)strtoul(p + 3, NULL, 10);
+            }
+            else if (strncmp(p, "lin", 3) == 0)
+            {
+                cfg.avg_mode = AD_PSD_AVG_LINEAR;
+                cfg.avg_n = (uint16_t)strtoul(p + 3, NULL, 10);
+            }
+            else
+                cfg.avg_n = 0; /* 触发参数非法 */
+            if (AD_Psd_Configure(&cfg))
+                ESP_Log("[控制台] PSD 配置已提交，下一个块生效（平均重新开始）\r\n");
+            else
+                ESP_Log("[控制台] 用法: psd hann|flattop | psd ov 0..75 | psd exp|lin 1..1000\r\n");
+            return;
+        }
+
+        AD_PsdStats_t st;
+        const AD_DspResult_t *res = NULL;
+        AD_Psd_GetStats(&st);
+        ESP_Log("[控制台] PSD %s 重叠 %u%% %s平均 %u 段，累计段=%lu 不连续=%lu 重来=%lu\r\n",
+                AD_Psd_WindowName(cfg.window), (unsigned)cfg.overlap_pct,
+                (cfg.avg_mode == AD_PSD_AVG_LINEAR) ? "线性" : "指数", (unsigned)cfg.avg_n,
+                (unsigned long)st.segments, (unsigned long)st.gaps, (unsigned long)st.resets);
+        if (AD_Dsp_AcquireLatest(NULL, &res))
+        {
+            ESP_Log("  分辨率 %.3fHz，当前结果 %lu 段，谐波幅值（%.0fHz × 1..%u）：\r\n",
+                    (double)res->psd_info.bin_hz, (unsigned long)res->psd_info.segments,
+                    (double)AD_PSD_FUND_HZ, (unsigned)AD_PSD_HARMONICS);
+            for (int ch = 0; ch < NODE_CHANNEL_COUNT; ch++)
+            {
+                char buf[160];
+                int n = snprintf(buf, sizeof(buf), "  CH%lu", (unsigned long)AD_Acq_PhysChannel((uint32_t)ch));
+                for (uint32_t h = 0; h < AD_PSD_HARMONICS && n > 0 && n < (int)sizeof(buf); h++)
+                    n += snprintf(buf + n, sizeof(buf) - (size_t)n, " %.4f", (double)res->harm[ch][h]);
+                ESP_Log("%s\r\n", buf);
+            }
+            AD_Dsp_Release(res);
+        }
+        return;
     }
-#endif
 
-    // 4) 链路自恢复：如果长时间收不到服务器任何响应，先软重连（更快）
-    // 这是为了应对极端情况下 TCP 假死或模组死机
-    static uint32_t last_link_check = 0;
-    static uint8_t no_rx_miss = 0;
-    static uint32_t last_rx_bytes_snapshot = 0;
-    if ((now - last_link_check) >= 1000)
+    // 格式: tone / tone 4 0 12000 / tone win 40
+    if (strncmp(line, "tone", 4) == 0)
     {
-        last_link_check = now;
-        // 只有当“已连接”、“非重连中”且“非AT模式”时才检查
-        if (g_report_enabled && g_esp_ready && !g_link_reconnecting && !g_uart2_at_mode)
+        char *p = line + 4;
+        AD_ToneConfig_t cfg;
+        while (*p == ' ' || *p == '\t')
+            p++;
+        AD_Tone_GetConfig(&cfg);
+        if (*p != 0)
         {
-            // 正常情况下服务器会对每次心跳返回 HTTP 响应
-            uint32_t no_rx_ms = (uint32_t)ESP_CommParams_HardResetSec() * 1000u;
-            if (no_rx_ms < 5000u)
-                no_rx_ms = 5000u; // 最小阈值 5s（避免过短导致抖动）
-
-            // 如果 RX 字节数在增长，说明链路正常
-            if (g_usart2_rx_bytes != last_rx_bytes_snapshot)
+            bool ok;
+            if (strncmp(p, "win", 3) == 0)
             {
-                last_rx_bytes_snapshot = g_usart2_rx_bytes;
-                g_last_rx_tick = now;
-                no_rx_miss = 0;
+                cfg.window_ms = (uint32_t)strtoul(p + 3, NULL, 10);
+                ok = AD_Tone_SetConfig(&cfg);
             }
-            // 否则检查是否超时
-            else if (g_last_rx_tick != 0 && (now - g_last_rx_tick) > no_rx_ms)
+            else
             {
-                no_rx_miss++;
-                // 连续 3 次检测都超时，才判定为断线
-                if (no_rx_miss >= 3)
+                char *q = p;
+                uint32_t idx = (uint32_t)strtoul(q, &q, 10);
+                uint32_t phys = (uint32_t)strtoul(q, &q, 10);
+                float hz = strtof(q, NULL);
+                ok = (idx < AD_TONE_MAX && phys < 8u && hz >= 0.0f);
+                if (ok)
                 {
-                    ESP_Log("[ESP] 警告：%lus 无服务器响应(Δt=%lums, miss=%u) -> 软重连\r\n",
-                            (unsigned long)(no_rx_ms / 1000u),
-                            (unsigned long)(now - g_last_rx_tick),
-                            (unsigned)no_rx_miss);
-                    no_rx_miss = 0;
-                    ESP_SoftReconnect();
+                    cfg.t[idx].phys = (uint8_t)phys;
+                    cfg.t[idx].hz = hz;
+                    ok = AD_Tone_SetConfig(&cfg);
                 }
             }
+            ESP_Log(ok ? "[控制台] 纹波跟踪配置已生效\r\n" : "[控制台] 用法: tone 序号 物理通道 频率 | tone win 1..1000\r\n");
+            return;
         }
-        else
+
+        uint32_t now = HAL_GetTick();
+        ESP_Log("[控制台] 纹波跟踪 目标窗长 %lums\r\n", (unsigned long)cfg.window_ms);
+        for (uint32_t i = 0; i < AD_TONE_MAX; i++)
         {
-            /* 停止上报后：禁止后台自动重连/硬复位重连，仅清空计数避免下次误触发 */
-            no_rx_miss = 0;
+            AD_ToneResult_t r;
+            if (cfg.t[i].hz <= 0.0f)
+                continue;
+            if (AD_Tone_Get(i, &r))
+                ESP_Log("  #%lu CH%u %.2fHz(N=%lu) amp=%.5f phase=%.1f age=%lums\r\n", (unsigned long)i,
+                        (unsigned)r.phys, (double)r.hz, (unsigned long)r.len, (double)r.amp,
+                        (double)r.phase_deg, (unsigned long)(now - r.tick_ms));
+            else
+                ESP_Log("  #%lu CH%u %.2fHz：无结果（未启用通道/超出 fs/2/等待首个窗）\r\n", (unsigned long)i,
+                        (unsigned)cfg.t[i].phys, (double)cfg.t[i].hz);
         }
+        return;
     }
-#else
-    (void)0;
-#endif
 
-#if (ADS_BADFRAME_MONITOR)
-    /* 每 1s 输出一次采样统计（在任务上下文输出，避免在TIM2 ISR里printf影响时序） */
-    {
-        static uint32_t last_print = 0;
-        uint32_t now2 = HAL_GetTick();
-        if ((now2 - last_print) >= 1000u)
+    // 格式: E01
+    if ((line[0] == 'E' || line[0] == 'e') && strlen(line) == 3)
+    {
+        ESP_SetFaultCode(line);
+        return;
+    }
+
+    // 格式: fault E01 / fault / fault reload / fault reset
+    if (strncmp(line, "fault", 5) == 0)
+    {
+        char *p = line + 5;
+        while (*p == ' ' || *p == '\t')
+            p++;
+        if (strlen(p) == 3 && (p[0] == 'E' || p[0] == 'e'))
         {
-            last_print = now2;
-            static uint32_t last_frames = 0, last_miss = 0;
-            uint32_t frames = 0, miss = 0;
-            AD7606_GetStats(&frames, &miss);
-            uint32_t df = frames - last_frames;
-            uint32_t dm = miss - last_miss;
-            printf("[AD7606] frames=%lu (+%lu/s) miss=%lu (+%lu/s)\r\n",
-                   (unsigned long)frames, (unsigned long)df,
-                   (unsigned long)miss, (unsigned long)dm);
-            last_frames = frames;
-            last_miss = miss;
+            ESP_SetFaultCode(p);
+            return;
+        }
+        if (strcmp(p, "reload") == 0)
+        {
+            ESP_Log("[控制台] 故障规则重载%s\r\n", AD_Fault_LoadFromSD() ? "成功" : "失败（无文件、规则非法或 SD 不可用）");
+            return;
+        }
+        if (strcmp(p, "reset") == 0)
+        {
+            AD_Fault_Reset();
+            ESP_Log("[控制台] 本地故障判定已复位（下一块重新判定）\r\n");
+            return;
+        }
+        if (*p == 0)
+        {
+            AD_FaultConfig_t cfg;
+            AD_FaultStatus_t st;
+            char buf[200];
+            AD_Fault_GetConfig(&cfg);
+            AD_Fault_GetStatus(&st);
+            ESP_Log("[控制台] 本地判定 %s（规则%d）已判定 %lu 块，置位 %lu 次，纹波基线 %.4f\r\n",
+                    st.verdict.code, (int)st.verdict.rule, (unsigned long)st.evals, (unsigned long)st.raised,
+                    (double)st.ripple_base);
+            int n = snprintf(buf, sizeof(buf), " ");
+            for (uint32_t i = 0; i < AD_FEAT_COUNT && n > 0 && n < (int)sizeof(buf); i++)
+                n += snprintf(buf + n, sizeof(buf) - (size_t)n, " %s=%.3f", AD_Fault_FeatName((uint8_t)i),
+                              (double)st.feat.v[i]);
+            ESP_Log("%s\r\n", buf);
+            ESP_Log("  绝缘(%s%s) R+=%.1f R-=%.1f R=%.1f kΩ 趋势 %.1f kΩ 变化率 %.2f %%/h 更新 %lu 作废 %lu\r\n",
+                    (st.iso.mode == AD_ISO_MODE_BRIDGE) ? "电桥" : "被动", st.iso.valid ? "" : "，无估计",
+                    (double)st.iso.r_p_kohm, (double)st.iso.r_n_kohm, (double)st.iso.r_iso_kohm,
+                    (double)st.iso.trend_kohm, (double)st.iso.rate_pct_h, (unsigned long)st.iso.updates,
+                    (unsigned long)st.iso.rejected);
+            for (uint32_t i = 0; i < AD_FAULT_RULES; i++)
+            {
+                const AD_FaultRule_t *r = &cfg.rule[i];
+                if (r->op == AD_FAULT_OFF)
+                    continue;
+                ESP_Log("  #%lu %s %s %.3f/%.3f on=%u off=%u -> %s%s%s\r\n", (unsigned long)i,
+                        AD_Fault_FeatName(r->feat), AD_Fault_OpName(r->op), (double)r->set, (double)r->clear,
+                        (unsigned)r->on_n, (unsigned)r->off_n, r->code, r->capture ? " +录波" : "",
+                        (st.verdict.active & (1u << i)) ? " [置位]" : "");
+            }
+            return;
         }
     }
-#endif
-}
-
-/**
- * @brief  数据发送主函数
- * @note   负责打包 JSON，通过 DMA 发送
- */
-void ESP_Post_Summary(void)
-{
-    if (g_esp_ready == 0)
-        return;
-
-    /* 发送节流统计 */
-    static uint32_t last_send_time = 0;
-    static uint32_t tx_try = 0, tx_ok = 0, tx_busy = 0, tx_err = 0;
-    static uint32_t last_tx_log = 0;
-
-    uint32_t now_tick = HAL_GetTick();
 
-    /* 如果正在分段发送，优先推进下一段 */
-    if (g_tx_chunk.active) {
-        if (now_tick < g_tx_chunk.next_tick) {
+    // 格式: arc / arc reload
+    if (strncmp(line, "arc", 3) == 0)
+    {
+        char *p = line + 3;
+        while (*p == ' ' || *p == '\t')
+            p++;
+        if (strcmp(p, "reload") == 0)
+        {
+            ESP_Log("[控制台] 电弧检测配置重载%s\r\n", AD_Arc_LoadFromSD() ? "成功" : "失败（无文件、参数非法或 SD 不可用）");
             return;
         }
-        HAL_UART_StateTypeDef st_uart = HAL_UART_GetState(&huart2);
-        if (st_uart == HAL_UART_STATE_BUSY_TX || st_uart == HAL_UART_STATE_BUSY_TX_RX) {
+        if (*p == 0)
+        {
+            AD_ArcConfig_t cfg;
+            AD_ArcStatus_t st;
+            AD_ArcPortStats_t ps;
+            AD_Arc_GetConfig(&cfg);
+            AD_Arc_GetStatus(&st);
+            AD_Arc_GetPortStats(&ps);
+            if (!cfg.enable)
+            {
+                ESP_Log("[控制台] 电弧检测未启用（%s ENABLE=1）\r\n", AD_ARC_CFG_FILE);
+                return;
+            }
+            ESP_Log("[控制台] 电弧检测 CH%u %s，带通 %.0f-%.0fHz @%luHz，窗 %lu 点，已判定 %lu 窗%s\r\n", (unsigned)cfg.phys,
+                    st.arc ? "[电弧]" : "正常", (double)st.f_lo_hz, (double)st.f_hi_hz, (unsigned long)st.sample_rate,
+                    (unsigned long)st.window_len, (unsigned long)st.windows,
+                    (st.sample_rate != 0u && st.window_len == 0u) ? "（频段超出当前采样率，暂停）" : "");
+            ESP_Log("  带内 RMS %.4f 基线 %.4f（门限 ×%.1f，下限 %.4f）包络峰均比 %.2f（≥%.2f）热窗 %u/%u（置位 %u，解除 %u）\r\n",
+                    (double)st.rms, (double)st.base_rms, (double)cfg.ratio, (double)cfg.floor, (double)st.crest,
+                    (double)cfg.crest_min, (unsigned)st.hot, (unsigned)cfg.hist_n, (unsigned)cfg.hot_n, (unsigned)cfg.clear_n);
+            ESP_Log("  学习剩余 %u 窗，置位 %lu 次，录波请求 %lu 次，复位 %lu 次，每块 %lucyc（最大 %lucyc，%.1fus）\r\n",
+                    (unsigned)st.learn_left, (unsigned long)st.detections, (unsigned long)ps.captures,
+                    (unsigned long)st.resets, (unsigned long)ps.cyc, (unsigned long)ps.cyc_max,
+                    (double)ps.cyc * 1e6 / (double)SystemCoreClock);
             return;
         }
-        goto send_next_chunk;
     }
 
-    /* 非分段 DMA 链发送期间，禁止再次进入发送流程 */
-    if (g_http_tx_phase != ESP_HTTP_TX_IDLE) {
+    // 格式: bin / bin on / bin off
+    if (strncmp(line, "bin", 3) == 0 && (line[3] == 0 || line[3] == ' ' || line[3] == '\t'))
+    {
+        char *p = line + 3;
+        while (*p == ' ' || *p == '\t')
+            p++;
+        if (strcmp(p, "on") == 0 || strcmp(p, "off") == 0)
+        {
+            ESP_CommParams_t cp;
+            ESP_CommParams_Get(&cp);
+            cp.frame_fmt = (p[1] == 'n') ? ESP_FRAME_FMT_BINARY : ESP_FRAME_FMT_JSON;
+            ESP_CommParams_Apply(&cp);
+        }
+        else if (*p != 0)
+        {
+            ESP_Log("[控制台] 用法: bin [on|off]\r\n");
+            return;
+        }
+        ESP_Log("[控制台] 全量上报格式: %s\r\n", (ESP_CommParams_FrameFmt() == ESP_FRAME_FMT_BINARY)
+                                                        ? "二进制帧 -> /api/node/frame"
+                                                        : "JSON -> /api/node/heartbeat");
+        AD_CodecStats_t cs[2];
+#if ESP_FRAME_WAVE_CODEC
+        cs[0] = s_frame_codec.st;
+#else
+        memset(&cs[0], 0, sizeof(cs[0]));
+#endif
+        SD_Wave_GetEventCodecStats(&cs[1]);
+        for (int k = 0; k < 2; k++)
+        {
+            if (cs[k].blocks == 0u)
+                continue;
+            ESP_Log("  %s无损压缩: %lu 块 %lu 点，累计 x%.2f（最近 x%.2f，最小 x%.2f，最大 x%.2f），"
+                    "定宽块 %lu，逃逸 %lu，预测阶 %lu/%lu/%lu\r\n",
+                    k ? "SD 录波" : "上报波形", (unsigned long)cs[k].blocks, (unsigned long)cs[k].samples,
+                    (double)AD_Codec_Ratio(&cs[k]), (double)cs[k].last_ratio, (double)cs[k].min_ratio,
+                    (double)cs[k].max_ratio, (unsigned long)cs[k].fixed_blocks, (unsigned long)cs[k].escapes,
+                    (unsigned long)cs[k].order_hist[0], (unsigned long)cs[k].order_hist[1],
+                    (unsigned long)cs[k].order_hist[2]);
+        }
         return;
     }
 
-    /* HTTP 门控：发送后等待回包，避免连续请求淹没服务器；超时后自动放行。 */
-    if (g_waiting_http_response)
+    // 格式: tx / tx chunked / tx length / tx win N
+    if (strncmp(line, "tx", 2) == 0 && (line[2] == 0 || line[2] == ' ' || line[2] == '\t'))
     {
-        uint32_t now_gate = HAL_GetTick();
-        uint32_t to_ms = ESP_CommParams_HttpTimeoutMs();
-        if ((now_gate - g_waiting_http_tick) < to_ms)
+        char *p = line + 2;
+        while (*p == ' ' || *p == '\t')
+            p++;
+        if (strcmp(p, "chunked") == 0 || strcmp(p, "length") == 0)
+        {
+            ESP_CommParams_t cp;
+            ESP_CommParams_Get(&cp);
+            cp.http_chunked = (p[0] == 'c') ? 1u : 0u;
+            ESP_CommParams_Apply(&cp);
+        }
+        else if (strncmp(p, "win", 3) == 0 && strtoul(p + 3, NULL, 10) > 0u)
+        {
+            ESP_CommParams_t cp;
+            ESP_CommParams_Get(&cp);
+            cp.http_window = (uint32_t)strtoul(p + 3, NULL, 10);
+            ESP_CommParams_Apply(&cp);
+        }
+        else if (*p != 0)
+        {
+            ESP_Log("[控制台] 用法: tx [chunked|length|win N]\r\n");
             return;
-        g_waiting_http_response = 0;
-    }
-
-    // 发送频率限制
-    uint32_t min_itv = ESP_CommParams_MinIntervalMs();
-    if (min_itv && (now_tick - last_send_time < min_itv))
+        }
+        ESP_Log("[控制台] 上报正文: %s，发送段 2 x %lu B，%s\r\n",
+                ESP_CommParams_HttpChunked() ? "Transfer-Encoding: chunked" : "Content-Length（先量长度）",
+                (unsigned long)ESP_TX_SEG_SIZE, s_tx.active ? "正在发送" : "空闲");
+        ESP_Log("  请求 %lu，中止 %lu，UART 忙 %lu，欠载 %lu，累计正文 %lu B\r\n", (unsigned long)s_tx_stats.requests,
+                (unsigned long)s_tx_stats.aborts, (unsigned long)s_tx_stats.busy, (unsigned long)s_tx_stats.underruns,
+                (unsigned long)s_tx_stats.bytes);
+        ESP_Log("  最近正文 %lu B / %lu 段，首字节 %lu us（最大 %lu us），发完 %lu ms，填段最长 %lu us，量长度 %lu us\r\n",
+                (unsigned long)s_tx_stats.last_body, (unsigned long)s_tx_stats.last_segs,
+                (unsigned long)s_tx_stats.first_us, (unsigned long)s_tx_stats.first_us_max,
+                (unsigned long)s_tx_stats.last_ms, (unsigned long)s_tx_stats.fill_us_max,
+                (unsigned long)s_tx_stats.measure_us);
+        (void)ESP_HttpWin_CanSend(); /* 先把超时的出队、刷新每秒吞吐 */
+        esp_http_win_stats_t ws = s_win_stats;
+        ESP_Log("  在途窗口 %u/%lu（最多到过 %lu），RTT 最近 %lu ms 平均 %lu ms（%lu..%lu），吞吐 %lu 请求/s %lu B/s\r\n",
+                (unsigned)s_win.count, (unsigned long)ESP_CommParams_HttpWindow(), (unsigned long)ws.inflight_max,
+                (unsigned long)ws.rtt_last, (unsigned long)(ws.rtt_avg_x8 / 8u), (unsigned long)ws.rtt_min,
+                (unsigned long)ws.rtt_max, (unsigned long)ws.req_per_s, (unsigned long)ws.bytes_per_s);
+        ESP_Log("  已发 %lu，回包 %lu，非 2xx %lu，超时 %lu，丢失 %lu，对不上 %lu\r\n", (unsigned long)ws.sent,
+                (unsigned long)ws.acked, (unsigned long)ws.errors, (unsigned long)ws.timeouts, (unsigned long)ws.lost,
+                (unsigned long)ws.late);
         return;
+    }
 
-    ensure_http_packet_buf();
-    const uint32_t header_reserve_len = 256;
-    char *body = (char *)http_packet_buf + header_reserve_len;
-    char *p = body;
-    const char *end = (const char *)http_packet_buf + HTTP_PACKET_BUF_SIZE;
-    uint32_t body_len = 0;
-    int header_len = 0;
-    uint32_t total_len = 0;
-    static uint32_t s_seq = 0;
-    uint32_t seq = ++s_seq;
-
-    // JSON Header
-    if (!ESP_Appendf(&p, end, "{\"node_id\":\"%s\",\"status\":\"online\",\"fault_code\":\"%s\",\"seq\":%lu,\"channels\":[",
-                     g_sys_cfg.node_id, g_fault_code, (unsigned long)seq))
+    // 格式: spool / spool rescan
+    if (strncmp(line, "spool", 5) == 0 && (line[5] == 0 || line[5] == ' ' || line[5] == '\t'))
+    {
+        char *p = line + 5;
+        while (*p == ' ' || *p == '\t')
+            p++;
+        if (strcmp(p, "rescan") == 0)
+        {
+            if (s_spool.inflight)
+            {
+                ESP_Log("[控制台] 正在补传，稍后再试\r\n");
+                return;
+            }
+            s_spool.ready = SD_Spool_Init() ? 1u : 0u;
+            s_spool.init_tick = HAL_GetTick();
+        }
+        else if (*p != 0)
+        {
+            ESP_Log("[控制台] 用法: spool [rescan]\r\n");
+            return;
+        }
+        SD_SpoolStats_t st;
+        SD_Spool_GetStats(&st);
+        if (!st.ready)
+        {
+            ESP_Log("[控制台] 断线缓存未就绪（%s，SD 未挂载或目录 %s 不可用）\r\n",
+                    ESP_SPOOL_ENABLE ? "已启用" : "编译关闭", SD_SPOOL_DIR);
+            return;
+        }
+        ESP_Log("[控制台] 断线缓存 %s：待补传 %lu 条（事件 %lu）%lu KB，占用 %lu/%lu KB，%lu 个段文件\r\n", SD_SPOOL_DIR,
+                (unsigned long)(st.pending[SD_SPOOL_PRIO_EVENT] + st.pending[SD_SPOOL_PRIO_NORMAL]),
+                (unsigned long)st.pending[SD_SPOOL_PRIO_EVENT], (unsigned long)(st.pending_bytes / 1024u),
+                (unsigned long)(st.disk_bytes / 1024u), (unsigned long)(st.quota_bytes / 1024u), (unsigned long)st.segs);
+        ESP_Log("  写入 %lu（失败 %lu），补传 %lu（失败重试 %lu），丢弃 %lu 条 / %lu 段，修复 %lu，SD 错误 %lu\r\n",
+                (unsigned long)st.written, (unsigned long)s_spool.cap_fail, (unsigned long)st.replayed,
+                (unsigned long)s_spool.replay_fail, (unsigned long)st.dropped, (unsigned long)st.dropped_segs,
+                (unsigned long)st.repaired, (unsigned long)st.errors);
+        ESP_Log("  断线写入间隔 %lu ms，补传间隔 %lu ms，%s\r\n", (unsigned long)g_spool_interval_ms,
+                (unsigned long)g_spool_replay_ms,
+                s_spool.inflight ? "正在补传" : (ESP_Spool_LinkDown() ? "链路断开/停滞，正在缓存" : "空闲"));
         return;
+    }
 
-    for (int i = 0; i < 4; i++)
+    // 格式: class / class reload
+    if (strncmp(line, "class", 5) == 0)
     {
-        int32_t cv_i = ESP_FloatToI32Scaled(node_channels[i].current_value);
-        if (!ESP_Appendf(&p, end,
-                         "{"
-                         "\"id\":%d,\"channel_id\":%d,"
-                         "\"label\":\"%s\",\"name\":\"%s\","
-                         "\"value\":%ld,\"current_value\":%ld,"
-                         "\"unit\":\"%s\"}"
-                         ,
-                         node_channels[i].id, node_channels[i].id,
-                         node_channels[i].label, node_channels[i].label,
-                         (long)cv_i, (long)cv_i,
-                         node_channels[i].unit))
+        char *p = line + 5;
+        while (*p == ' ' || *p == '\t')
+            p++;
+        if (strcmp(p, "reload") == 0)
+        {
+            ESP_Log("[控制台] 分类模型加载%s\r\n", AD_Class_Load() ? "成功（下一块生效）" : "失败（无文件、校验失败或正在同步）");
             return;
-        if (i < 3)
+        }
+        if (*p == 0)
         {
-            if (!ESP_Appendf(&p, end, ","))
+            AD_ClassStatus_t st;
+            AD_DspStats_t ds;
+            char buf[160];
+            AD_Class_GetStatus(&st);
+            AD_Dsp_GetStats(&ds);
+            if (!st.loaded)
+            {
+                ESP_Log("[控制台] 未加载分类模型（%s / %s）\r\n", AD_CLASS_MODEL_FILE_SD, AD_CLASS_MODEL_FILE_QSPI);
                 return;
+            }
+            ESP_Log("[控制台] 分类模型 %s：%s 类别=%u 维数=%u 支持向量=%lu %lu 字节\r\n", st.src ? st.src : "?",
+                    AD_Class_KindName(st.kind), (unsigned)st.nclass, (unsigned)st.dim, (unsigned long)st.nsv,
+                    (unsigned long)st.bytes);
+            ESP_Log("  已推理 %lu 块，最近 %s（类别%d score=%.3f），耗时 %lucyc（%.1fus）\r\n", (unsigned long)st.infers,
+                    st.last.code, (int)st.last.cls, (double)st.last.score, (unsigned long)ds.class_cyc,
+                    (double)ds.class_cyc * 1e6 / (double)SystemCoreClock);
+            int n = snprintf(buf, sizeof(buf), " ");
+            for (uint32_t i = 0; i < st.nclass && n > 0 && n < (int)sizeof(buf); i++)
+                n += snprintf(buf + n, sizeof(buf) - (size_t)n, " %s=%lu", st.code[i], (unsigned long)st.count[i]);
+            ESP_Log("%s\r\n", buf);
+            return;
         }
     }
 
-    if (!ESP_Appendf(&p, end, "]}"))
-        return;
+    ESP_Log("[控制台] 未识别命令: %s（输入 help 查看帮助）\r\n", line);
+}
 
-    body_len = (uint32_t)(p - body);
-    if (body_len == 0 || body_len > (HTTP_PACKET_BUF_SIZE - header_reserve_len - 64u))
+static void ESP_SetServerReportMode(uint8_t full)
+{
+    full = (full != 0U) ? 1U : 0U;
+    if (g_server_report_full != full)
+    {
+        g_server_report_full = full;
+        g_server_report_full_dirty = 1U;
+    }
+}
+
+static void ESP_SetServerAcqProfile(int idx)
+{
+    if (idx < 0 || idx >= (int)AD_ACQ_PROFILE_COUNT)
         return;
+    if (g_server_acq_profile != (uint8_t)idx)
+    {
+        g_server_acq_profile = (uint8_t)idx;
+        g_server_acq_profile_dirty = 1U;
+    }
+}
+
+/* 从回包文本中取 "acq_profile":N（单个数字），没有返回 -1 */
+static int ESP_ParseAcqProfile(const char *s)
+{
+    const char *p = strstr(s, "\"acq_profile\"");
+    if (!p)
+        return -1;
+    p += 13;
+    while (*p == ' ' || *p == ':')
+        p++;
+    if (*p < '0' || *p > '9')
+        return -1;
+    return *p - '0';
+}
 
-    header_len = snprintf((char *)http_packet_buf, header_reserve_len,
-                          "POST /api/node/heartbeat HTTP/1.1\r\n"
-                          "Host: %s:%d\r\n"
-                          "Content-Type: application/json\r\n"
-                          "Content-Length: %lu\r\n"
-                          "\r\n",
-                          g_sys_cfg.server_ip, g_sys_cfg.server_port, (unsigned long)body_len);
-    if (header_len <= 0 || (uint32_t)header_len >= header_reserve_len)
+void ESP_Console_Init(void)
+{
+#if (ESP_CONSOLE_ENABLE)
+    UART_HandleTypeDef *hu = ESP_GetLogUart(); // 默认 USART1
+    if (!hu)
         return;
 
-    uint32_t total_len_check = (uint32_t)header_len + body_len;
-    if (ESP_CommParams_ChunkKb() == 0u && total_len_check <= 65535u)
+    // 启动 1 字节 RX 中断（比主循环轮询稳定，避免“输入了但没反应”）
+    HAL_UART_Receive_IT(hu, &g_console_rx_byte, 1);
+    ESP_Log("[控制台] 已启用：输入 E01 回车注入故障；输入 E00 回车清除。\r\n");
+#endif
+}
+
+/**
+ * @brief  控制台轮询任务
+ * @note   在主循环中调用，处理用户输入和服务器指令
+ */
+void ESP_Console_Poll(void)
+{
+#if (ESP_CONSOLE_ENABLE)
+    uint32_t now = HAL_GetTick();
+    // 1) 处理“已收到的一整行”控制台指令
+    if (g_console_line_ready)
     {
-        DCache_CleanByAddr_Any(http_packet_buf, (uint32_t)header_len);
-        DCache_CleanByAddr_Any(body, body_len);
-        HAL_StatusTypeDef st = HAL_UART_Transmit_DMA(&huart2, (uint8_t *)http_packet_buf, (uint16_t)header_len);
-        tx_try++;
-        if (st == HAL_OK) {
-            tx_ok++;
-            g_http_tx_body_ptr = (uint8_t *)body;
-            g_http_tx_body_len = body_len;
-            g_http_tx_phase = ESP_HTTP_TX_HEADER_INFLIGHT;
-            last_send_time = now_tick;
-        } else if (st == HAL_BUSY) {
-            tx_busy++;
-        } else {
-            tx_err++;
+        g_console_line_ready = 0;
+        g_console_line[g_console_line_len] = 0;
+        ESP_Console_HandleLine(g_console_line);
+        g_console_line_len = 0;
+    }
+
+    // 2) 处理“服务器下发 reset”指令
+    if (g_server_reset_pending)
+    {
+        g_server_reset_pending = 0;
+        ESP_Log("[服务器命令] 收到 reset：清除故障码 -> E00\r\n");
+        AD_Fault_Reset();
+        ESP_SetFaultCode("E00");
+    }
+
+    // 2.0) 处理“服务器下发 report_mode”指令
+    if (g_server_report_full_dirty)
+    {
+        g_server_report_full_dirty = 0;
+        if (g_server_report_full)
+        {
+            ESP_Log("[服务器命令] report_mode=full：请求全量上报\r\n");
+        }
+        else
+        {
+            ESP_Log("[服务器命令] report_mode=summary：关闭全量上报\r\n");
         }
-        return;
     }
 
-    memmove(http_packet_buf + header_len, body, body_len);
-    total_len = (uint32_t)header_len + body_len;
-    if (total_len > HTTP_PACKET_BUF_SIZE)
-        return;
-    DCache_CleanByAddr_Any(http_packet_buf, total_len);
+    // 2.0.1) 处理“服务器下发 acq_profile”指令
+    if (g_server_acq_profile_dirty)
+    {
+        g_server_acq_profile_dirty = 0;
+        uint32_t idx = g_server_acq_profile;
+        const AD_AcqProfile_t *prof = AD_Acq_GetProfile(idx);
+        if (prof && AD_Acq_RequestProfile(idx))
+        {
+            ESP_Log("[服务器命令] acq_profile=%lu：切换为 %s\r\n", (unsigned long)idx, prof->name);
+        }
+        else
+        {
+            ESP_Log("[服务器命令] acq_profile=%lu：无效或时序不可行，忽略\r\n", (unsigned long)idx);
+        }
+    }
+
+    // 2.1) 链路异常：尽快软重连，避免长时间“卡住”
+    if (g_report_enabled && g_link_reconnect_pending && g_esp_ready && !g_link_reconnecting && !g_uart2_at_mode)
+    {
+        g_link_reconnect_pending = 0;
+        ESP_Log("[ESP] 侦测到链路异常关键字,触发软重连...\r\n");
+        ESP_SoftReconnect();
+    }
 
-    g_tx_chunk.total_len = total_len;
-    g_tx_chunk.offset = 0;
-    g_tx_chunk.next_tick = 0;
-    g_tx_chunk.active = 1;
-    now_tick = HAL_GetTick();
+#if (ESP_DEBUG && ESP_DEBUG_STATS)
+    // 3) 调试：每 1 秒输出一次统计信息 (确认 RX 是否存活)
+    static uint32_t last_dbg = 0;
+    if ((now - last_dbg) >= 1000)
+    {
+        last_dbg = now;
+        ESP_Log("[调试] USART2 RX: started=%d, events=%lu, bytes=%lu, restart=%lu\r\n",
+                (int)g_usart2_rx_started,
+                (unsigned long)g_usart2_rx_events,
+                (unsigned long)g_usart2_rx_bytes,
+                (unsigned long)g_usart2_rx_restart);
+        ESP_Log("[调试] USART2 ERR: total=%lu, ORE=%lu, FE=%lu, NE=%lu, PE=%lu\r\n",
+                (unsigned long)g_uart2_err,
+                (unsigned long)g_uart2_err_ore,
+                (unsigned long)g_uart2_err_fe,
+                (unsigned long)g_uart2_err_ne,
+                (unsigned long)g_uart2_err_pe);
+    }
+#endif
 
-send_next_chunk:
-    if (!g_tx_chunk.active) {
+    // 4) 链路自恢复：如果长时间收不到服务器任何响应，先软重连（更快）
+    // 这是为了应对极端情况下 TCP 假死或模组死机
+    static uint32_t last_link_check = 0;
+    static uint8_t no_rx_miss = 0;
+    static uint32_t last_rx_bytes_snapshot = 0;
+    if ((now - last_link_check) >= 1000)
+    {
+        last_link_check = now;
+        // 只有当“已连接”、“非重连中”且“非AT模式”时才检查
+        if (g_report_enabled && g_esp_ready && !g_link_reconnecting && !g_uart2_at_mode)
+        {
+            // 正常情况下服务器会对每次心跳返回 HTTP 响应
+            uint32_t no_rx_ms = (uint32_t)ESP_CommParams_HardResetSec() * 1000u;
+            if (no_rx_ms < 5000u)
+                no_rx_ms = 5000u; // 最小阈值 5s（避免过短导致抖动）
+
+            // 如果 RX 字节数在增长，说明链路正常
+            if (g_usart2_rx_bytes != last_rx_bytes_snapshot)
+            {
+                last_rx_bytes_snapshot = g_usart2_rx_bytes;
+                g_last_rx_tick = now;
+                no_rx_miss = 0;
+            }
+            // 否则检查是否超时
+            else if (g_last_rx_tick != 0 && (now - g_last_rx_tick) > no_rx_ms)
+            {
+                no_rx_miss++;
+                // 连续 3 次检测都超时，才判定为断线
+                if (no_rx_miss >= 3)
+                {
+                    ESP_Log("[ESP] 警告：%lus 无服务器响应(Δt=%lums, miss=%u) -> 软重连\r\n",
+                            (unsigned long)(no_rx_ms / 1000u),
+                            (unsigned long)(now - g_last_rx_tick),
+                            (unsigned)no_rx_miss);
+                    no_rx_miss = 0;
+                    ESP_SoftReconnect();
+                }
+            }
+        }
+        else
+        {
+            /* 停止上报后：禁止后台自动重连/硬复位重连，仅清空计数避免下次误触发 */
+            no_rx_miss = 0;
+        }
+    }
+#else
+    (void)0;
+#endif
+
+#if (ADS_BADFRAME_MONITOR)
+    /* 每 1s 输出一次采样统计（在任务上下文输出，避免在TIM2 ISR里printf影响时序） */
+    {
+        static uint32_t last_print = 0;
+        uint32_t now2 = HAL_GetTick();
+        if ((now2 - last_print) >= 1000u)
+        {
+            last_print = now2;
+            static uint32_t last_frames = 0, last_miss = 0;
+            AD7606_Stats_t st;
+            AD7606_GetStatsEx(&st);
+            uint32_t frames = st.frames, miss = st.miss;
+            uint32_t df = frames - last_frames;
+            uint32_t dm = miss - last_miss;
+            printf("[AD7606] frames=%lu (+%lu/s) miss=%lu (+%lu/s) isr_cyc last=%lu avg=%lu max=%lu jitter pp=%luns rms=%luns\r\n",
+                   (unsigned long)frames, (unsigned long)df,
+                   (unsigned long)miss, (unsigned long)dm,
+                   (unsigned long)st.isr_cyc_last, (unsigned long)st.isr_cyc_avg,
+                   (unsigned long)st.isr_cyc_max,
+                   (unsigned long)st.jitter_pp_ns, (unsigned long)st.jitter_rms_ns);
+            last_frames = frames;
+            last_miss = miss;
+
+            AD_AcqStats_t as;
+            AD_DspStats_t ds;
+            AD_Acq_GetStats(&as);
+            AD_Dsp_GetStats(&ds);
+            printf("[ACQ] blocks=%lu dropped_frames=%lu drop_events=%lu dsp_skipped=%lu\r\n",
+                   (unsigned long)as.blocks, (unsigned long)as.dropped_frames,
+                   (unsigned long)as.drop_events, (unsigned long)ds.blocks_skipped);
+            printf("[DSP] results=%lu no_slot=%lu calc=%lums fft(%s)=%lucyc stats=%lucyc class=%lucyc uplink_skipped=%lu\r\n",
+                   (unsigned long)ds.results, (unsigned long)ds.no_slot, (unsigned long)ds.last_ms,
+                   AD_Dsp_EngineName(), (unsigned long)ds.fft_cyc, (unsigned long)ds.stats_cyc,
+                   (unsigned long)ds.class_cyc, (unsigned long)s_dsp_reader.skipped);
+#if (AD_DSP_SPEC_BENCH)
+            printf("[DSP] bench: pair=%lucyc per-channel=%lucyc maxdiff=%.2e\r\n",
+                   (unsigned long)ds.fft_cyc, (unsigned long)ds.ref_cyc, (double)ds.ref_maxrel);
+#endif
+        }
+    }
+#endif
+}
+
+/* ================= 流水线上报：在途请求窗口（esp_http_win.h） ================= */
+
+/* 请求出队：补传中的那条记成功/失败；2xx 回包刷新“最近一次确认”（断线缓存按它判断回包是否停滞） */
+static void ESP_HttpWin_OnRetire(const esp_http_req_t *r, uint8_t ok, uint32_t now)
+{
+    if (s_spool.inflight && r->seq != 0u && r->seq == s_spool.rec.seq)
+        s_spool.result = ok ? 1u : 2u;
+    if (ok)
+    {
+        s_spool.ack_tick = now;
+        s_spool.ack_sent = s_win_stats.sent;
+    }
+}
+
+/* ================= 上报流式发送 ================= */
+
+/* 当前该发的一块：请求头优先，然后按顺序轮流两段 */
+static esp_tx_span_t *ESP_Tx_NextSpan(void)
+{
+    if (s_tx.hdr.ready)
+        return &s_tx.hdr;
+    return s_tx.seg[s_tx.send].ready ? &s_tx.seg[s_tx.send] : NULL;
+}
+
+/* 启动下一次 DMA（须在关中断或 USART2 中断里调用） */
+static void ESP_Tx_KickLocked(void)
+{
+    if (!s_tx.active || s_tx.dma_busy)
         return;
+    esp_tx_span_t *sp = ESP_Tx_NextSpan();
+    if (!sp)
+        return;
+    uint32_t n = sp->tx_len - sp->tx_off;
+    if (n > s_tx.burst_max)
+        n = s_tx.burst_max;
+    if (HAL_UART_Transmit_DMA(&huart2, sp->tx + sp->tx_off, (uint16_t)n) != HAL_OK)
+        return;
+
+    uint32_t now = HAL_GetTick();
+    s_tx.dma_busy = 1;
+    s_tx.cur = sp;
+    s_tx.burst = n;
+    s_tx.next_tick = now + s_tx.delay_ms;
+    s_tx.progress_tick = now;
+    if (!s_tx.first_sent)
+    {
+        s_tx.first_sent = 1;
+        s_tx_stats.first_us = (DWT->CYCCNT - s_tx.t0_cyc) / (SystemCoreClock / 1000000u);
+        if (s_tx_stats.first_us > s_tx_stats.first_us_max)
+            s_tx_stats.first_us_max = s_tx_stats.first_us;
+    }
+    if (sp->last && sp->tx_off + n >= sp->tx_len)
+    {
+        /* 最后一次 DMA：回包可能在 TxCplt 之前就到，在这里就进在途窗口 */
+        s_tx_stats.last_ms = now - s_tx.t0_tick;
+        g_last_heartbeat_tick = now;
+        ESP_HttpWin_PushLocked(s_tx.snap.seq, s_tx.body_len, now);
     }
-    uint32_t chunk_bytes = ESP_CommParams_ChunkKb() * 1024u;
-    if (chunk_bytes == 0u) chunk_bytes = 65535u;
-    uint32_t remain = g_tx_chunk.total_len - g_tx_chunk.offset;
-    if (remain == 0u) {
-        g_tx_chunk.active = 0;
+}
+
+static void ESP_Tx_Kick(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    ESP_Tx_KickLocked();
+    __set_PRIMASK(primask);
+}
+
+/* 给一段加 chunked 框架（块头右对齐写进段前预留，块尾/终止块写进段后预留），不搬数据 */
+static void ESP_Tx_SealSeg(esp_tx_span_t *sp, uint8_t *data, uint32_t n, uint8_t last)
+{
+    if (!s_tx.chunked)
+    {
+        sp->tx = data;
+        sp->tx_len = n;
         return;
     }
-    if (chunk_bytes > remain) chunk_bytes = remain;
-    if (chunk_bytes > 65535u) chunk_bytes = 65535u;
+    uint8_t *q = data + n;
+    sp->tx = data;
+    if (n > 0u)
+    {
+        char head[ESP_TX_SEG_PRE];
+        int h = snprintf(head, sizeof(head), "%lX\r\n", (unsigned long)n);
+        sp->tx = data - h;
+        memcpy(sp->tx, head, (size_t)h);
+        *q++ = '\r';
+        *q++ = '\n';
+    }
+    if (last)
+    {
+        memcpy(q, "0\r\n\r\n", 5u);
+        q += 5;
+    }
+    sp->tx_len = (uint32_t)(q - sp->tx);
+}
 
-    HAL_StatusTypeDef st = HAL_UART_Transmit_DMA(&huart2,
-                                                 (uint8_t *)http_packet_buf + g_tx_chunk.offset,
-                                                 (uint16_t)chunk_bytes);
-    tx_try++;
-    if (st == HAL_OK) {
-        tx_ok++;
-        g_tx_chunk.offset += chunk_bytes;
-        g_tx_chunk.next_tick = now_tick + ESP_CommParams_ChunkDelayMs();
-        if (g_tx_chunk.offset >= g_tx_chunk.total_len) {
-            g_tx_chunk.active = 0;
-            last_send_time = now_tick;
-            g_last_heartbeat_tick = now_tick;
-            g_waiting_http_response = 1;
-            g_waiting_http_tick = now_tick;
-        }
-    } else if (st == HAL_BUSY) {
-        tx_busy++;
-    } else {
-        tx_err++;
+/* 收尾：放开录波事件、记统计；ok=0 为中途放弃 */
+static void ESP_Tx_Finish(uint8_t ok)
+{
+    if (s_tx.snap.has_ev)
+    {
+        AD_Trig_Release(AD_TRIG_CONSUMER_UPLINK, &s_tx.snap.ev);
+        if (ok)
+            ESP_Log("[TRIG] event #%lu %s attached (%lu frames, step %lu%s)\r\n", (unsigned long)s_tx.snap.ev.seq,
+                    s_tx.snap.ev.fault_code, (unsigned long)s_tx.snap.ev.frames, (unsigned long)s_tx.snap.ev_step,
+                    (s_tx.kind == ESP_UP_FULL_BIN) ? ", binary" : "");
+        s_tx.snap.has_ev = 0;
+    }
+    if (ok)
+    {
+        s_tx_stats.requests++;
+        s_tx_stats.bytes += s_tx.body_len;
+        s_tx_stats.last_body = s_tx.body_len;
+        s_tx_stats.last_segs = s_tx.segs;
     }
+    else
+    {
+        s_tx_stats.aborts++;
+        if (s_tx.kind == ESP_UP_SPOOL)
+            s_spool.result = 2u;
+    }
+    s_tx.active = 0;
 
 #if (ESP_DEBUG)
+    static uint32_t last_tx_log = 0;
     uint32_t now = HAL_GetTick();
-    if ((now - last_tx_log) >= 1000)
+    if (ok && (now - last_tx_log) >= 1000u)
     {
         last_tx_log = now;
-        ESP_Log("[调试] Summary TX: try=%lu ok=%lu busy=%lu err=%lu total=%lu off=%lu chunk=%lu gState=%d rxStarted=%d\r\n",
-                (unsigned long)tx_try, (unsigned long)tx_ok, (unsigned long)tx_busy, (unsigned long)tx_err,
-                (unsigned long)g_tx_chunk.total_len,
-                (unsigned long)g_tx_chunk.offset,
-                (unsigned long)chunk_bytes,
-                (int)huart2.gState,
-                (int)g_usart2_rx_started);
+        ESP_Log("[调试] TX %s: body=%lu %s segs=%lu first=%luus total=%lums underrun=%lu\r\n",
+                (s_tx.kind == ESP_UP_SUMMARY) ? "summary" :
+                ((s_tx.kind == ESP_UP_FULL_BIN) ? "frame" : ((s_tx.kind == ESP_UP_SPOOL) ? "spool" : "full")),
+                (unsigned long)s_tx.body_len, s_tx.chunked ? "chunked" : "length", (unsigned long)s_tx.segs,
+                (unsigned long)s_tx_stats.first_us, (unsigned long)s_tx_stats.last_ms,
+                (unsigned long)s_tx_stats.underruns);
     }
 #endif
 }
 
-/**
- * @brief  数据发送主函数
- * @note   负责打包 JSON，通过 DMA 发送
- */
-void ESP_Post_Data(void)
+/*
+*********************************************************************************************************
+* 函 数 名: ESP_Tx_Abort
+* 功能说明: 放弃正在发送的上报请求（强制停 DMA、发送卡死）
+* 形    参: why - 日志里的原因
+* 返 回 值: 无
+* 说    明: 只在任务上下文调用；已发出的半截请求留在连接上，正文生成失败时 ESP_Tx_Pump 随即重建连接，
+*           强制停 DMA 的调用方本身就在重连，DMA 超时由服务器按超时丢弃
+*********************************************************************************************************
+*/
+static void ESP_Tx_Abort(const char *why)
 {
-    if (g_esp_ready == 0)
+    if (!s_tx.active)
         return;
+    if (s_tx.dma_busy)
+        (void)HAL_UART_AbortTransmit(&huart2);
+    s_tx.dma_busy = 0;
+    s_tx.hdr.ready = 0;
+    s_tx.seg[0].ready = 0;
+    s_tx.seg[1].ready = 0;
+    ESP_Log("[TX] 上报请求中止（%s）：已生成 %lu 字节\r\n", why, (unsigned long)s_tx.body_len);
+    ESP_Tx_Finish(0);
+}
 
-    /* 发送节流统计 */
-    static uint32_t last_send_time = 0;
-    static uint32_t tx_try = 0, tx_ok = 0, tx_busy = 0, tx_err = 0;
-    static uint32_t last_tx_log = 0;
-
-    uint32_t now_tick = HAL_GetTick();
+/*
+*********************************************************************************************************
+* 函 数 名: ESP_Tx_Pump
+* 功能说明: 推进正在发送的上报请求：填空闲段、到点续发、收尾、卡死检测
+* 形    参: 无
+* 返 回 值: 无
+* 说    明: 任务循环每轮调用（ESP_Post_Summary / ESP_Post_Data 入口）；
+*           不节流时 DMA 在 TxCplt 里直接接续，这里只负责把发空的段填上
+*********************************************************************************************************
+*/
+static void ESP_Tx_Pump(void)
+{
+    if (!s_tx.active)
+        return;
 
-    /* 如果正在分段发送，优先推进下一段 */
-    if (g_tx_chunk.active) {
-        if (now_tick < g_tx_chunk.next_tick) {
+    while (!s_tx.gen_done && !s_tx.seg[s_tx.fill].ready)
+    {
+        esp_tx_span_t *sp = &s_tx.seg[s_tx.fill];
+        uint8_t *data = ESP_TxSegData(s_tx.fill);
+        uint32_t c0 = DWT->CYCCNT;
+        uint32_t n = ESP_Up_GenFill(&s_tx.gen, &s_tx.snap, data, ESP_TX_SEG_SIZE);
+        uint32_t us = (DWT->CYCCNT - c0) / (SystemCoreClock / 1000000u);
+        if (us > s_tx_stats.fill_us_max)
+            s_tx_stats.fill_us_max = us;
+        if (s_tx.gen.err)
+        {
+            /* 单元放不进一整段（段长配置过小）：不能把残缺正文当成完整请求结束。
+             * 请求头（和前面的段）已经发出，服务器还在等后续块 / 剩余长度，同一连接上再发的请求会被当成正文，
+             * 所以中止后关掉连接重建（ESP_SoftReconnect 里 CIPCLOSE，在途窗口随之作废） */
+            ESP_Log("[TX] 正文生成失败（stage=%u），本次上报中止\r\n", (unsigned)s_tx.gen.stage);
+            ESP_Tx_Abort("生成失败");
+            ESP_SoftReconnect();
             return;
         }
-        HAL_UART_StateTypeDef st_uart = HAL_UART_GetState(&huart2);
-        if (st_uart == HAL_UART_STATE_BUSY_TX || st_uart == HAL_UART_STATE_BUSY_TX_RX) {
-            return;
+        uint8_t last = (s_tx.gen.stage == ESP_GEN_DONE) ? 1u : 0u;
+        s_tx.body_len += n;
+        s_tx.segs++;
+        ESP_Tx_SealSeg(sp, data, n, last);
+        sp->tx_off = 0;
+        sp->last = last;
+        s_tx.fill ^= 1u;
+        s_tx.gen_done = last;
+        if (sp->tx_len == 0u)
+        {
+            s_tx.done = 1;
+            break;
         }
-        goto send_next_chunk;
+        DCache_CleanByAddr_Any(sp->tx, sp->tx_len);
+        __DMB();
+        sp->ready = 1;
     }
 
-    /* 非分段 DMA 链发送期间，禁止再次进入发送流程 */
-    if (g_http_tx_phase != ESP_HTTP_TX_IDLE) {
+    uint32_t now = HAL_GetTick();
+    if (!s_tx.dma_busy && (int32_t)(now - s_tx.next_tick) >= 0)
+        ESP_Tx_Kick();
+
+    if (s_tx.done && !s_tx.dma_busy)
+    {
+        ESP_Tx_Finish(1);
         return;
     }
+    /* DMA 迟迟不完成（UART 错误导致 HAL 中止发送）：放弃本次，避免永远占着发送通道 */
+    if (s_tx.dma_busy && (now - s_tx.progress_tick) > ESP_CommParams_HttpTimeoutMs())
+        ESP_Tx_Abort("DMA 超时");
+}
 
-    /* HTTP 门控：发送后等待回包，避免连续请求淹没服务器；超时后自动放行。 */
-    if (g_waiting_http_response)
+/*
+*********************************************************************************************************
+* 函 数 名: ESP_Tx_Begin
+* 功能说明: 开始一次上报请求：冻结上报内容，发请求头，填前两段并启动 DMA
+* 形    参: kind - esp_up_kind_t
+*           seq  - 上报序号
+* 返 回 值: 1=已开始
+* 说    明: chunked 模式下请求头在这里立即交给 DMA（首字节延迟 = 取快照 + 格式化请求头，几十 us）；
+*           Content-Length 模式先在发送段里空跑一遍生成器量出正文长度（不发送），再发请求头；
+*           ESP_UP_SPOOL 补传 s_spool.rec（已 SD_Spool_Peek），长度就是记录长度，不取快照也不空跑
+*********************************************************************************************************
+*/
+static uint8_t ESP_Tx_Begin(esp_up_kind_t kind, uint32_t seq)
+{
+    uint32_t c0 = DWT->CYCCNT;
+    HAL_UART_StateTypeDef st_uart = HAL_UART_GetState(&huart2);
+    if (st_uart == HAL_UART_STATE_BUSY_TX || st_uart == HAL_UART_STATE_BUSY_TX_RX)
     {
-        uint32_t now_gate = HAL_GetTick();
-        uint32_t to_ms = ESP_CommParams_HttpTimeoutMs();
-        if ((now_gate - g_waiting_http_tick) < to_ms)
-            return;
-        g_waiting_http_response = 0;
+        s_tx_stats.busy++;
+        return 0;
     }
 
-    // 发送频率限制
-    uint32_t min_itv = ESP_CommParams_MinIntervalMs();
-    if (min_itv && (now_tick - last_send_time < min_itv))
-        return;
+    memset(&s_tx.hdr, 0, sizeof(s_tx.hdr));
+    memset(s_tx.seg, 0, sizeof(s_tx.seg));
+    s_tx.t0_cyc = c0;
+    s_tx.t0_tick = HAL_GetTick();
+    s_tx.kind = (uint8_t)kind;
+    s_tx.chunked = ESP_CommParams_HttpChunked() ? 1u : 0u;
+    s_tx.dma_busy = 0;
+    s_tx.done = 0;
+    s_tx.gen_done = 0;
+    s_tx.fill = 0;
+    s_tx.send = 0;
+    s_tx.first_sent = 0;
+    s_tx.body_len = 0;
+    s_tx.segs = 0;
+    s_tx.burst_max = ESP_CommParams_ChunkKb() * 1024u;
+    if (s_tx.burst_max == 0u || s_tx.burst_max > 65535u)
+        s_tx.burst_max = 65535u; /* HAL_UART_Transmit_DMA 长度为 uint16_t */
+    s_tx.delay_ms = ESP_CommParams_ChunkKb() ? ESP_CommParams_ChunkDelayMs() : 0u;
+    s_tx.next_tick = s_tx.t0_tick;
+
+    if (kind == ESP_UP_SPOOL)
+    {
+        memset(&s_tx.snap, 0, sizeof(s_tx.snap));
+        s_tx.snap.seq = seq;
+        s_tx.snap.tick = s_tx.t0_tick;
+    }
+    else
+    {
+        ESP_Up_Snapshot(&s_tx.snap, kind, seq);
+    }
+    ESP_Up_GenReset(&s_tx.gen, kind, &s_tx.snap);
 
-    ensure_http_packet_buf();
-    /* 开始构建 JSON：把 body 放到偏移处，避免对大 body 做 memmove */
-    const uint32_t header_reserve_len = 256;
-    char *body = (char *)http_packet_buf + header_reserve_len;
-    char *p = body;
-    const char *end = (const char *)http_packet_buf + HTTP_PACKET_BUF_SIZE;
-    uint32_t body_len = 0;
-    int header_len = 0;
-    uint32_t total_len = 0;
-    static uint32_t s_seq = 0;
-    uint32_t seq = ++s_seq;
+    char len_line[40];
+    if (s_tx.chunked)
+    {
+        (void)snprintf(len_line, sizeof(len_line), "Transfer-Encoding: chunked\r\n");
+    }
+    else if (kind == ESP_UP_SPOOL)
+    {
+        (void)snprintf(len_line, sizeof(len_line), "Content-Length: %lu\r\n", (unsigned long)s_spool.rec.len);
+    }
+    else
+    {
+        /* 空跑：输出写进发送段后丢弃；压缩统计不计这一遍 */
+        uint32_t m0 = DWT->CYCCNT;
+        uint32_t total = 0;
+#if ESP_FRAME_WAVE_CODEC
+        AD_CodecStats_t cst = s_frame_codec.st;
+#endif
+        while (s_tx.gen.stage != ESP_GEN_DONE && !s_tx.gen.err)
+            total += ESP_Up_GenFill(&s_tx.gen, &s_tx.snap, ESP_TxSegData(0), ESP_TX_SEG_SIZE);
+#if ESP_FRAME_WAVE_CODEC
+        s_frame_codec.st = cst;
+#endif
+        s_tx_stats.measure_us = (DWT->CYCCNT - m0) / (SystemCoreClock / 1000000u);
+        if (s_tx.gen.err || total == 0u)
+        {
+            if (s_tx.snap.has_ev)
+                AD_Trig_Release(AD_TRIG_CONSUMER_UPLINK, &s_tx.snap.ev);
+            s_tx.snap.has_ev = 0;
+            s_tx_stats.aborts++;
+            ESP_Log("[TX] 正文生成失败（stage=%u），本次不发送\r\n", (unsigned)s_tx.gen.stage);
+            return 0;
+        }
+        ESP_Up_GenReset(&s_tx.gen, kind, &s_tx.snap);
+        (void)snprintf(len_line, sizeof(len_line), "Content-Length: %lu\r\n", (unsigned long)total);
+    }
+
+    /* 补传帧：本次上电写的记录带上采集距今的毫秒数，服务器据此还原采集时刻（RTC 未校时也不受影响） */
+    char age_line[40];
+    age_line[0] = 0;
+    if (kind == ESP_UP_SPOOL && s_spool.rec.seq > s_spool.seq_boot)
+        (void)snprintf(age_line, sizeof(age_line), "X-Spool-Age-Ms: %lu\r\n",
+                       (unsigned long)(s_tx.t0_tick - s_spool.rec.tick));
+
+    /* 两种格式的回包相同，命令/上报模式解析不变 */
+    const uint8_t bin = (kind == ESP_UP_FULL_BIN || kind == ESP_UP_SPOOL) ? 1u : 0u;
+    int h = snprintf((char *)ESP_TxHdrBuf(), ESP_TX_HDR_SIZE,
+                     "POST %s HTTP/1.1\r\n"
+                     "Host: %s:%d\r\n"
+                     "Content-Type: %s\r\n"
+                     "%s%s"
+                     "\r\n",
+                     bin ? "/api/node/frame" : "/api/node/heartbeat", g_sys_cfg.server_ip, g_sys_cfg.server_port,
+                     bin ? "application/octet-stream" : "application/json", len_line, age_line);
+    if (h <= 0 || h >= (int)ESP_TX_HDR_SIZE)
+    {
+        if (s_tx.snap.has_ev)
+            AD_Trig_Release(AD_TRIG_CONSUMER_UPLINK, &s_tx.snap.ev);
+        s_tx.snap.has_ev = 0;
+        return 0;
+    }
+    s_tx.hdr.tx = ESP_TxHdrBuf();
+    s_tx.hdr.tx_len = (uint32_t)h;
+    DCache_CleanByAddr_Any(s_tx.hdr.tx, s_tx.hdr.tx_len);
+    s_tx.hdr.ready = 1;
+    s_tx.active = 1;
 
-    // JSON Header
-    if (!ESP_Appendf(&p, end, "{\"node_id\":\"%s\",\"status\":\"online\",\"fault_code\":\"%s\",\"seq\":%lu,\"channels\":[",
-                    g_sys_cfg.node_id, g_fault_code, (unsigned long)seq))
-        return;
+    ESP_Tx_Kick();
+    ESP_Tx_Pump();
+    return 1;
+}
+
+/* 链路断开（未就绪/重连中）或停滞（发出的请求 ESP_SPOOL_SLOW_MS 内没有任何 2xx 回包）：实时上报多半送不到 */
+static uint8_t ESP_Spool_LinkDown(void)
+{
+    if (!g_esp_ready || g_link_reconnecting)
+        return 1u;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint8_t stalled = (s_win_stats.sent != s_spool.ack_sent && (HAL_GetTick() - s_spool.ack_tick) >= ESP_SPOOL_SLOW_MS) ? 1u : 0u;
+    __set_PRIMASK(primask);
+    return stalled;
+}
 
-    // 循环写入 4 个通道的数据
-    for (int i = 0; i < 4; i++)
+/*
+*********************************************************************************************************
+* 函 数 名: ESP_Spool_Capture
+* 功能说明: 把当前 DSP 快照编成一帧二进制帧写进 SD 缓存
+* 形    参: prio - SD_SPOOL_PRIO_*（带录波事件或故障码非 E00 时自动提为事件级）
+* 返 回 值: 1=已写入
+* 说    明: 借用发送快照与生成器（只在没有请求在发时调用），每段生成完直接 f_write，不经 UART；
+*           帧头 flags 带 AD_FRAME_FLAG_SPOOL 并附 TIME 段；占用一个上报序号，补传时服务器按它去重
+*********************************************************************************************************
+*/
+static uint8_t ESP_Spool_Capture(uint8_t prio)
+{
+    uint32_t seq = s_up_seq + 1u;
+    uint32_t c0 = DWT->CYCCNT;
+
+    ESP_Up_Snapshot(&s_tx.snap, ESP_UP_FULL_BIN, seq);
+    s_tx.snap.spooled = 1;
+    s_tx.snap.has_sp = 0;
+    s_tx.snap.rtc_sec = SD_Time_GetUnix();
+    if (s_tx.snap.has_ev || strncmp(s_tx.snap.fault_code, "E00", 3) != 0)
+        prio = SD_SPOOL_PRIO_EVENT;
+    ESP_Up_GenReset(&s_tx.gen, ESP_UP_FULL_BIN, &s_tx.snap);
+
+    uint32_t total = 0;
+    uint8_t ok = SD_Spool_AppendBegin(prio, seq, s_tx.snap.tick) ? 1u : 0u;
+    while (ok && s_tx.gen.stage != ESP_GEN_DONE)
     {
-        int32_t cv_i = ESP_FloatToI32Scaled(node_channels[i].current_value);
-        if (!ESP_Appendf(&p, end,
-                         "{"
-                         "\"id\":%d,\"channel_id\":%d,"
-                         "\"label\":\"%s\",\"name\":\"%s\","
-                         "\"value\":%ld,\"current_value\":%ld,"
-                         "\"unit\":\"%s\","
-                         "\"waveform\":[",
-                         node_channels[i].id, node_channels[i].id,
-                         node_channels[i].label, node_channels[i].label, // name冗余label
-                         (long)cv_i, (long)cv_i,
-                         node_channels[i].unit))
-            return;
+        uint32_t n = ESP_Up_GenFill(&s_tx.gen, &s_tx.snap, ESP_TxSegData(0), ESP_TX_SEG_SIZE);
+        ok = (!s_tx.gen.err && SD_Spool_AppendData(ESP_TxSegData(0), n)) ? 1u : 0u;
+        total += n;
+    }
+    if (ok)
+        ok = SD_Spool_AppendEnd() ? 1u : 0u;
+    else
+        SD_Spool_AppendAbort();
 
-        // 波形数据（运行时降采样：step=1全量，step=4每4点取1点）
-        if (!Helper_FloatArray_To_String(&p, end, node_channels[i].waveform, WAVEFORM_POINTS, (int)ESP_CommParams_WaveStep()))
-            return;
+    if (s_tx.snap.has_ev)
+    {
+        /* 写进缓存才算交出去；失败则留给下一次（Acquire 只是查看） */
+        if (ok)
+        {
+            AD_Trig_Release(AD_TRIG_CONSUMER_UPLINK, &s_tx.snap.ev);
+            ESP_Log("[SPOOL] 录波事件 #%lu %s 已写入断线缓存\r\n", (unsigned long)s_tx.snap.ev.seq, s_tx.snap.ev.fault_code);
+        }
+        s_tx.snap.has_ev = 0;
+    }
+    if (!ok)
+    {
+        s_spool.cap_fail++;
+        s_spool.cap_err = 1;
+        return 0;
+    }
+    s_up_seq = seq;
+    s_spool.captured++;
+    s_spool.cap_err = 0;
+#if (ESP_DEBUG)
+    ESP_Log("[SPOOL] 缓存 seq=%lu %s %lu B，%lu us\r\n", (unsigned long)seq,
+            (prio == SD_SPOOL_PRIO_EVENT) ? "事件" : "普通", (unsigned long)total,
+            (unsigned long)((DWT->CYCCNT - c0) / (SystemCoreClock / 1000000u)));
+#else
+    (void)c0;
+    (void)total;
+#endif
+    return 1;
+}
 
-        // 频谱数据
-        if (!ESP_Appendf(&p, end, "],\"fft_spectrum\":["))
-            return;
-        /* FFT 不乘 200：保持原始数值（1 位小数） */
-        if (!Helper_FloatArray1dp_To_String(&p, end, node_channels[i].fft_data, FFT_POINTS, 1))
-            return;
+/*
+*********************************************************************************************************
+* 函 数 名: ESP_Spool_Poll
+* 功能说明: 断线缓存的任务侧推进：懒初始化、处理补传结果、链路断开/停滞时按间隔写缓存
+* 形    参: 无
+* 返 回 值: 无
+* 说    明: ESP_Post_Summary / ESP_Post_Data 入口调用（在 g_esp_ready 判断之前，断线时也要跑）；
+*           普通帧每 SPOOL_INTERVAL_MS 一帧，待上报的录波事件或故障码变化立即写一帧（事件级）
+*********************************************************************************************************
+*/
+static void ESP_Spool_Poll(void)
+{
+    if (!ESP_SPOOL_ENABLE)
+        return;
 
-        // 结束当前 channel
-        if (!ESP_Appendf(&p, end, "]}"))
+    uint32_t now = HAL_GetTick();
+    if (!s_spool.ready)
+    {
+        extern volatile uint8_t g_qspi_sd_sync_in_progress;
+        if (g_qspi_sd_sync_in_progress || (s_spool.init_tick != 0u && (now - s_spool.init_tick) < 10000u))
             return;
-        if (i < 3)
+        s_spool.init_tick = now ? now : 1u;
+        if (!SD_Spool_Init())
+            return;
+        SD_SpoolStats_t st;
+        SD_Spool_GetStats(&st);
+        /* 实时序号接在盘上记录之后：补传帧与实时帧的 seq 不会撞（服务器按 seq 去重） */
+        if ((int32_t)(st.max_seq - s_up_seq) > 0)
+            s_up_seq = st.max_seq;
+        s_spool.seq_boot = st.max_seq;
+        memcpy(s_spool.last_fault, g_fault_code, sizeof(s_spool.last_fault));
+        s_spool.ready = 1;
+        ESP_Log("[SPOOL] 断线缓存就绪：待补传 %lu 条（事件 %lu）%lu KB，配额 %lu KB\r\n",
+                (unsigned long)(st.pending[SD_SPOOL_PRIO_EVENT] + st.pending[SD_SPOOL_PRIO_NORMAL]),
+                (unsigned long)st.pending[SD_SPOOL_PRIO_EVENT], (unsigned long)(st.pending_bytes / 1024u),
+                (unsigned long)(st.quota_bytes / 1024u));
+    }
+
+    /* 补传结果：窗口出队（回包 / 超时 / 丢失 / 链路重置）或发送中止时写 result */
+    if (s_spool.inflight && !(s_tx.active && s_tx.kind == ESP_UP_SPOOL))
+    {
+        uint8_t res = s_spool.result;
+        if (res == 0u && (now - s_spool.replay_tick) > ESP_CommParams_HttpTimeoutMs() * 2u + 1000u)
+            res = 2u; /* 兜底：请求没进窗口就没了 */
+        if (res == 1u)
         {
-            if (!ESP_Appendf(&p, end, ",")) // 逗号分隔
-                return;
+            (void)SD_Spool_Commit(true);
+            s_spool.replay_ok++;
+            s_spool.tries = 0;
+            s_spool.backoff_ms = 0;
+        }
+        else if (res == 2u)
+        {
+            s_spool.replay_fail++;
+            if (++s_spool.tries >= ESP_SPOOL_MAX_TRIES)
+            {
+                ESP_Log("[SPOOL] seq=%lu 补传 %u 次失败，放弃\r\n", (unsigned long)s_spool.rec.seq, (unsigned)s_spool.tries);
+                (void)SD_Spool_Commit(false);
+                s_spool.tries = 0;
+                s_spool.backoff_ms = 0;
+            }
+            else
+            {
+                /* 指数退避（1s、2s、4s … 最多 30s），期间实时上报照常 */
+                s_spool.backoff_ms = 1000u << s_spool.tries;
+                if (s_spool.backoff_ms > 30000u)
+                    s_spool.backoff_ms = 30000u;
+            }
+        }
+        if (res)
+        {
+            s_spool.inflight = 0;
+            s_spool.result = 0;
+            s_spool.replay_tick = now;
         }
     }
 
-    if (!ESP_Appendf(&p, end, "]}")) // JSON End
+    if (!ESP_Spool_LinkDown())
+    {
+        memcpy(s_spool.last_fault, g_fault_code, sizeof(s_spool.last_fault));
+        return;
+    }
+    if (s_tx.active || !s_dsp_res)
+        return;
+
+    AD_TrigEvent_t ev;
+    uint8_t urgent = (AD_Trig_Acquire(AD_TRIG_CONSUMER_UPLINK, &ev) ||
+                      strncmp(s_spool.last_fault, g_fault_code, 3) != 0) ? 1u : 0u;
+    uint32_t since = now - s_spool.cap_tick;
+    if (urgent && !s_spool.cap_err && since >= ESP_CommParams_MinIntervalMs())
+    {
+        memcpy(s_spool.last_fault, g_fault_code, sizeof(s_spool.last_fault));
+        s_spool.cap_tick = now;
+        (void)ESP_Spool_Capture(SD_SPOOL_PRIO_EVENT);
+    }
+    else if (since >= g_spool_interval_ms)
+    {
+        s_spool.cap_tick = now;
+        (void)ESP_Spool_Capture(SD_SPOOL_PRIO_NORMAL);
+    }
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: ESP_Spool_Replay
+* 功能说明: 链路正常、本轮没有实时上报要发时，补传一条缓存记录
+* 形    参: 无
+* 返 回 值: 无
+* 说    明: 一次只补传一条，间隔 SPOOL_REPLAY_MS；在途窗口至少给实时上报留一个空位
+*           （窗口为 1 时只在窗口空时补传）；送达后由 ESP_Spool_Poll 推进读游标
+*********************************************************************************************************
+*/
+static void ESP_Spool_Replay(void)
+{
+    uint32_t now = HAL_GetTick();
+    if (!s_spool.ready || s_spool.inflight || s_tx.active)
+        return;
+    if ((now - s_spool.replay_tick) < g_spool_replay_ms + s_spool.backoff_ms)
+        return;
+    uint32_t win = ESP_CommParams_HttpWindow();
+    if ((win > 1u) ? (s_win.count + 2u > win) : (s_win.count != 0u))
+        return;
+    if (ESP_Spool_LinkDown())
+        return;
+
+    SD_SpoolStats_t st;
+    SD_Spool_GetStats(&st);
+    if (st.pending[SD_SPOOL_PRIO_EVENT] + st.pending[SD_SPOOL_PRIO_NORMAL] == 0u)
+        return;
+
+    s_spool.replay_tick = now;
+    if (!SD_Spool_Peek(&s_spool.rec))
+        return;
+    s_spool.result = 0;
+    s_spool.inflight = 1;
+    if (!ESP_Tx_Begin(ESP_UP_SPOOL, s_spool.rec.seq))
+        s_spool.inflight = 0; /* UART 忙：下一轮重新 Peek */
+}
+
+/**
+ * @brief  数据发送主函数
+ * @note   轻量 JSON（无波形/FFT），边生成边经乒乓段 DMA 发送
+ */
+void ESP_Post_Summary(void)
+{
+    ESP_Spool_Poll();
+    if (g_esp_ready == 0)
         return;
 
-    body_len = (uint32_t)(p - body);
-    if (body_len == 0 || body_len > (HTTP_PACKET_BUF_SIZE - header_reserve_len - 64u))
+    /* 发送节流统计 */
+    static uint32_t last_send_time = 0;
+
+    uint32_t now_tick = HAL_GetTick();
+
+    /* 上一个请求还在发：推进生成/续发，本轮不开始新请求 */
+    if (s_tx.active)
     {
-        // 保护：长度异常直接丢弃，避免 memmove 越界导致后续随机坏帧
+        ESP_Tx_Pump();
         return;
     }
 
-    /* 生成 header 到预留区 */
-    header_len = snprintf((char *)http_packet_buf, header_reserve_len,
-                          "POST /api/node/heartbeat HTTP/1.1\r\n"
-                          "Host: %s:%d\r\n"
-                          "Content-Type: application/json\r\n"
-                          "Content-Length: %lu\r\n"
-                          "\r\n",
-                          g_sys_cfg.server_ip, g_sys_cfg.server_port, (unsigned long)body_len);
-    if (header_len <= 0 || (uint32_t)header_len >= header_reserve_len)
+    /* 在途请求窗口已满：等回包或超时出队，避免连续请求淹没服务器 */
+    if (!ESP_HttpWin_CanSend())
         return;
 
-    /* 非分段仅当整包 ≤ 64KB 时可用：HAL_UART_Transmit_DMA 长度为 uint16_t，超过 65535 会截断导致服务器收不全。 */
-    uint32_t total_len_check = (uint32_t)header_len + body_len;
-    if (ESP_CommParams_ChunkKb() == 0u && total_len_check <= 65535u)
+    // 发送频率限制（实时上报的间隙里补传断线缓存）
+    uint32_t min_itv = ESP_CommParams_MinIntervalMs();
+    if (min_itv && (now_tick - last_send_time < min_itv))
     {
-        DCache_CleanByAddr_Any(http_packet_buf, (uint32_t)header_len);
-        DCache_CleanByAddr_Any(body, body_len);
-        HAL_StatusTypeDef st = HAL_UART_Transmit_DMA(&huart2, (uint8_t *)http_packet_buf, (uint16_t)header_len);
-        tx_try++;
-        if (st == HAL_OK) {
-            tx_ok++;
-            g_http_tx_body_ptr = (uint8_t *)body;
-            g_http_tx_body_len = body_len;
-            g_http_tx_phase = ESP_HTTP_TX_HEADER_INFLIGHT;
-            last_send_time = now_tick;
-        } else if (st == HAL_BUSY) {
-            tx_busy++;
-        } else {
-            tx_err++;
-        }
+        ESP_Spool_Replay();
         return;
     }
 
-    /* 分段发送：需要把 header+body 变成连续缓冲（仍会 memmove 一次大包） */
-    memmove(http_packet_buf + header_len, body, body_len);
-    total_len = (uint32_t)header_len + body_len;
-    if (total_len > HTTP_PACKET_BUF_SIZE)
+    if (ESP_Tx_Begin(ESP_UP_SUMMARY, s_up_seq + 1u))
+    {
+        s_up_seq++;
+        last_send_time = now_tick;
+    }
+}
+
+/**
+ * @brief  数据发送主函数
+ * @note   全量 JSON 或二进制帧（按 FRAME_FMT），边生成边经乒乓段 DMA 发送
+ */
+void ESP_Post_Data(void)
+{
+    ESP_Spool_Poll();
+    if (g_esp_ready == 0)
         return;
-    DCache_CleanByAddr_Any(http_packet_buf, total_len);
 
-    /* 初始化分段发送上下文 */
-    g_tx_chunk.total_len = total_len;
-    g_tx_chunk.offset = 0;
-    g_tx_chunk.next_tick = 0;
-    g_tx_chunk.active = 1;
-    now_tick = HAL_GetTick();
+    /* 发送节流统计 */
+    static uint32_t last_send_time = 0;
+    static uint32_t last_dsp_tick = 0;
+
+    uint32_t now_tick = HAL_GetTick();
 
-send_next_chunk:
-    if (!g_tx_chunk.active) {
+    /* 上一个请求还在发：推进生成/续发，本轮不开始新请求 */
+    if (s_tx.active)
+    {
+        ESP_Tx_Pump();
         return;
     }
-    /* 每段 ≤ 65535（DMA 长度 uint16_t）；chunk_kb=0 时仅在全量包>64KB 会走分段，用 64KB 作为默认段大小 */
-    uint32_t chunk_bytes = ESP_CommParams_ChunkKb() * 1024u;
-    if (chunk_bytes == 0u) chunk_bytes = 65535u;
-    uint32_t remain = g_tx_chunk.total_len - g_tx_chunk.offset;
-    if (remain == 0u) {
-        g_tx_chunk.active = 0;
+
+    /* 在途请求窗口已满：等回包或超时出队，避免连续请求淹没服务器 */
+    if (!ESP_HttpWin_CanSend())
+        return;
+
+    // 发送频率限制（实时上报的间隙里补传断线缓存）
+    uint32_t min_itv = ESP_CommParams_MinIntervalMs();
+    if (min_itv && (now_tick - last_send_time < min_itv))
+    {
+        ESP_Spool_Replay();
         return;
     }
-    if (chunk_bytes > remain) chunk_bytes = remain;
-    if (chunk_bytes > 65535u) chunk_bytes = 65535u;
 
-    HAL_StatusTypeDef st = HAL_UART_Transmit_DMA(&huart2,
-                                                 (uint8_t *)http_packet_buf + g_tx_chunk.offset,
-                                                 (uint16_t)chunk_bytes);
-    tx_try++;
-    if (st == HAL_OK) {
-        tx_ok++;
-        g_tx_chunk.offset += chunk_bytes;
-        g_tx_chunk.next_tick = now_tick + ESP_CommParams_ChunkDelayMs();
-        if (g_tx_chunk.offset >= g_tx_chunk.total_len) {
-            g_tx_chunk.active = 0;
-            last_send_time = now_tick;
-            g_last_heartbeat_tick = now_tick;
-            g_waiting_http_response = 1;
-            g_waiting_http_tick = now_tick;
-        }
-    } else if (st == HAL_BUSY) {
-        tx_busy++;
-    } else {
-        tx_err++;
+    /* DSP 任务尚未发布过结果：没有波形/频谱可发 */
+    if (!s_dsp_res)
+        return;
+
+    /* 流水线只为新数据开新请求：上一份快照还在等回包时不重复发同一份（窗口空了照旧重发，保持在线） */
+    if (s_win.count && s_dsp_res->tick_ms == last_dsp_tick)
+    {
+        ESP_Spool_Replay();
+        return;
     }
 
-#if (ESP_DEBUG)
-    // 调试日志
-    uint32_t now = HAL_GetTick();
-    if ((now - last_tx_log) >= 1000)
+    /* 二进制帧：定点量化 + 字节拷贝，不经过 JSON 文本格式化 */
+    esp_up_kind_t kind = (ESP_CommParams_FrameFmt() == ESP_FRAME_FMT_BINARY) ? ESP_UP_FULL_BIN : ESP_UP_FULL_JSON;
+    if (ESP_Tx_Begin(kind, s_up_seq + 1u))
     {
-        last_tx_log = now;
-        ESP_Log("[调试] TX: try=%lu ok=%lu busy=%lu err=%lu total=%lu off=%lu chunk=%lu gState=%d rxStarted=%d\r\n",
-                (unsigned long)tx_try, (unsigned long)tx_ok, (unsigned long)tx_busy, (unsigned long)tx_err,
-                (unsigned long)g_tx_chunk.total_len,
-                (unsigned long)g_tx_chunk.offset,
-                (unsigned long)chunk_bytes,
-                (int)huart2.gState,
-                (int)g_usart2_rx_started);
+        s_up_seq++;
+        last_send_time = now_tick;
+        last_dsp_tick = s_dsp_res->tick_ms;
     }
-#endif
 }
 
 void ESP_Post_Heartbeat(void)
@@ -1834,18 +2860,17 @@ void ESP_Post_Heartbeat(void)
         return;
 
     uint32_t now = HAL_GetTick();
-    if (g_waiting_http_response)
-    {
-        /* 等待回包期间禁止继续发心跳；但超时后自动放行 */
-        uint32_t to_ms = ESP_CommParams_HttpTimeoutMs();
-        if ((now - g_waiting_http_tick) < to_ms)
-            return;
-        g_waiting_http_response = 0;
-    }
+    /* 在途窗口满时不发心跳（超时出队后自动放行） */
+    if (!ESP_HttpWin_CanSend())
+        return;
 
     if (now - g_last_heartbeat_tick < ESP_CommParams_HeartbeatMs())
         return;
 
+    /* 上报请求正在分段发送（节流间隙里 UART 空闲）：不能把心跳插进别人的正文 */
+    if (s_tx.active)
+        return;
+
     HAL_UART_StateTypeDef st = HAL_UART_GetState(&huart2);
     if (st == HAL_UART_STATE_BUSY_TX || st == HAL_UART_STATE_BUSY_TX_RX)
         return;
@@ -1870,8 +2895,10 @@ void ESP_Post_Heartbeat(void)
 
     if (HAL_UART_Transmit(&huart2, (uint8_t *)req, (uint16_t)req_len, 200) == HAL_OK)
     {
-        g_waiting_http_response = 1;
-        g_waiting_http_tick = now;
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        ESP_HttpWin_PushLocked(0u, (uint32_t)body_len, HAL_GetTick());
+        __set_PRIMASK(primask);
         g_last_heartbeat_tick = now;
 #if (ESP_DEBUG)
         ESP_Log("[调试] Heartbeat sent len=%d\r\n", req_len);
@@ -1879,47 +2906,37 @@ void ESP_Post_Heartbeat(void)
     }
 }
 
-// ---------------- USART2 TX DMA 完成回调：Header -> Body 链式发送 ----------------
+// ---------------- USART2 TX DMA 完成回调：请求头 -> 发送段链式发送 ----------------
 void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
 {
     if (!huart || huart->Instance != USART2)
         return;
+    if (!s_tx.active || !s_tx.dma_busy)
+        return;
 
-    if (g_http_tx_phase == ESP_HTTP_TX_HEADER_INFLIGHT)
-    {
-        if (!g_http_tx_body_ptr || g_http_tx_body_len == 0)
-        {
-            g_http_tx_phase = ESP_HTTP_TX_IDLE;
-            g_http_tx_body_ptr = NULL;
-            g_http_tx_body_len = 0;
-            return;
-        }
-        HAL_StatusTypeDef st = HAL_UART_Transmit_DMA(&huart2,
-                                                     g_http_tx_body_ptr,
-                                                     (uint16_t)g_http_tx_body_len);
-        if (st == HAL_OK)
-        {
-            g_http_tx_phase = ESP_HTTP_TX_BODY_INFLIGHT;
-            uint32_t now = HAL_GetTick();
-            g_last_heartbeat_tick = now;
-            g_waiting_http_response = 1;
-            g_waiting_http_tick = now;
-        }
-        else
+    esp_tx_span_t *sp = s_tx.cur;
+    sp->tx_off += s_tx.burst;
+    s_tx.dma_busy = 0;
+    s_tx.progress_tick = HAL_GetTick();
+    if (sp->tx_off >= sp->tx_len)
+    {
+        sp->ready = 0;
+        if (sp != &s_tx.hdr)
         {
-            g_http_tx_phase = ESP_HTTP_TX_IDLE;
-            g_http_tx_body_ptr = NULL;
-            g_http_tx_body_len = 0;
+            s_tx.send ^= 1u;
+            if (sp->last)
+            {
+                s_tx.done = 1;
+                return;
+            }
         }
-        return;
     }
-
-    if (g_http_tx_phase == ESP_HTTP_TX_BODY_INFLIGHT)
+    /* 不节流：下一块已填好就在中断里直接接上，UART 不留空档；没填好记一次欠载，由任务填好后启动 */
+    if (s_tx.delay_ms == 0u)
     {
-        g_http_tx_phase = ESP_HTTP_TX_IDLE;
-        g_http_tx_body_ptr = NULL;
-        g_http_tx_body_len = 0;
-        return;
+        if (!ESP_Tx_NextSpan())
+            s_tx_stats.underruns++;
+        ESP_Tx_KickLocked();
     }
 }
 
@@ -2004,12 +3021,8 @@ static void ESP_StreamRx_Feed(const uint8_t *data, uint16_t len)
     // ---------------- 关键修复：先扫描“原始数据块” ----------------
     // 避免因为滑动窗口截断（例如 "HTTP" 和 "/1.1" 在两包里）导致漏判
 
-    // 1) HTTP 响应检测：兼容 HTTP/1.0/1.1，出现 "HTTP/" 即认为收到响应头（辅助调试）
-    if (g_waiting_http_response && ESP_BufContains(data, len, "HTTP/"))
-    {
-        g_waiting_http_response = 0;
-        g_last_rx_tick = HAL_GetTick();
-    }
+    // 1) HTTP 响应：状态行 + 正文里的 "seq" 与在途请求对应（逐字节解析，跨块也不漏）
+    ESP_HttpWin_RxFeed(data, len);
     // 2) 服务器命令检测：优先在原始数据里扫一遍
     if (ESP_BufContains(data, len, "\"command\"") && ESP_BufContains(data, len, "reset"))
     {
@@ -2080,6 +3093,8 @@ static void ESP_StreamRx_Feed(const uint8_t *data, uint16_t len)
     {
         ESP_SetServerReportMode(0);
     }
+    // "acq_profile":N 带数值，只在滑动窗口里解析（原始块可能把数字截在下一包）
+    ESP_SetServerAcqProfile(ESP_ParseAcqProfile(g_stream_window));
     // 滑动窗口中检测链路异常关键字
     if (!g_link_reconnecting &&
         (strstr(g_stream_window, "CLOSED") ||
@@ -2090,12 +3105,6 @@ static void ESP_StreamRx_Feed(const uint8_t *data, uint16_t len)
         g_link_reconnect_pending = 1;
     }
 
-    // 识别 HTTP 响应头（辅助调试，兼容 HTTP/1.0/1.1）
-    if (g_waiting_http_response && strstr(g_stream_window, "HTTP/"))
-    {
-        g_waiting_http_response = 0;
-        g_last_rx_tick = HAL_GetTick();
-    }
 }
 
 /**
@@ -2126,14 +3135,8 @@ void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
                 uint32_t now = HAL_GetTick();
                 g_last_rx_tick = now;
 
-                /* 有新数据到达：直接解除门控。
-                 * 说明服务器/链路至少有回包字节到达，继续卡门控只会造成“超时放行刷屏”并降低吞吐。
-                 * 更严格的 HTTP 头检测仍由 ESP_StreamRx_Feed 负责（用于调试/统计）。 */
-                if (g_waiting_http_response)
-                {
-                    g_waiting_http_response = 0;
-                }
-
+                /* 回包与在途请求的对应由 ESP_StreamRx_Feed -> ESP_HttpWin_RxFeed 按状态行/seq 完成：
+                 * 不能再“来了字节就放行”，否则窗口 > 1 时一个回包会放出多个请求 */
                 if (pos > g_stream_rx_last_pos)
                 {
                     uint16_t len = (uint16_t)(pos - g_stream_rx_last_pos);
@@ -2194,11 +3197,8 @@ void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
         if (ec & HAL_UART_ERROR_PE)
             g_uart2_err_pe++;
 
-        // 发生错误时，当前这次 HTTP 回包很可能已经丢了；不要继续门控傻等
-        if (g_waiting_http_response)
-        {
-            g_waiting_http_response = 0;
-        }
+        // 发生错误时，正在收的那个 HTTP 回包很可能已经残缺；按丢失出队，不要继续占着窗口傻等
+        ESP_HttpWin_OnRxError();
 
         // 场景 A: AT(阻塞)阶段
         // 如果此时去重启 ReceiveToIdle_DMA，会把 HAL 的 RxState 锁死为 BUSY_RX，
@@ -2230,16 +3230,20 @@ void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
 
 void ESP_Register(void)
 {
-    ensure_http_packet_buf();
-    char *body_start = (char *)http_packet_buf + 256;
+    /* 注册包很小：栈上拼好阻塞发送（与 ESP_Post_Heartbeat 相同），不经过上报发送段 */
+    char body[256];
+    char req[512];
     ESP_Log("[ESP] 正在注册设备...\r\n");
-    sprintf(body_start, "{\"device_id\":\"%s\",\"location\":\"%s\",\"hw_version\":\"v1.0_4CH\"}", g_sys_cfg.node_id, g_sys_cfg.node_location);
-    uint32_t body_len = strlen(body_start);
-    int h_len = sprintf((char *)http_packet_buf,
-                        "POST /api/register HTTP/1.1\r\nHost: %s:%d\r\nContent-Type: application/json\r\nContent-Length: %u\r\n\r\n",
-                        g_sys_cfg.server_ip, g_sys_cfg.server_port, body_len);
-    memmove(http_packet_buf + h_len, body_start, body_len);
-    HAL_UART_Transmit(&huart2, http_packet_buf, h_len + body_len, 1000);
+    int body_len = snprintf(body, sizeof(body), "{\"device_id\":\"%s\",\"location\":\"%s\",\"hw_version\":\"v1.0_%uCH\"}",
+                            g_sys_cfg.node_id, g_sys_cfg.node_location, (unsigned)NODE_CHANNEL_COUNT);
+    if (body_len <= 0 || body_len >= (int)sizeof(body))
+        return;
+    int req_len = snprintf(req, sizeof(req),
+                           "POST /api/register HTTP/1.1\r\nHost: %s:%d\r\nContent-Type: application/json\r\nContent-Length: %d\r\n\r\n%s",
+                           g_sys_cfg.server_ip, g_sys_cfg.server_port, body_len, body);
+    if (req_len <= 0 || req_len >= (int)sizeof(req))
+        return;
+    HAL_UART_Transmit(&huart2, (uint8_t *)req, (uint16_t)req_len, 1000);
 
     // 关键：读一下服务器 HTTP 响应，确认注册是否真的到达后端
     memset(esp_rx_buf, 0, sizeof(esp_rx_buf));
@@ -2350,21 +3354,25 @@ static uint8_t ESP_TryReuseTransparent(void)
     (void)HAL_UART_AbortReceive(&huart2);
     ESP_Uart2_Drain(100);
 
-    ensure_http_packet_buf();
-    char *body = (char *)http_packet_buf + 256;
-    sprintf(body, "{\"node_id\":\"%s\",\"status\":\"online\",\"fault_code\":\"%s\"}", g_sys_cfg.node_id, g_fault_code);
-    uint32_t body_len = (uint32_t)strlen(body);
-    int h_len = sprintf((char *)http_packet_buf,
-                        "POST /api/node/heartbeat HTTP/1.1\r\n"
-                        "Host: %s:%d\r\n"
-                        "Content-Type: application/json\r\n"
-                        "Content-Length: %lu\r\n"
-                        "\r\n",
-                        g_sys_cfg.server_ip, g_sys_cfg.server_port, (unsigned long)body_len);
-    memmove(http_packet_buf + h_len, body, body_len);
+    char body[128];
+    char req[320];
+    int body_len = snprintf(body, sizeof(body), "{\"node_id\":\"%s\",\"status\":\"online\",\"fault_code\":\"%s\"}",
+                            g_sys_cfg.node_id, g_fault_code);
+    if (body_len <= 0 || body_len >= (int)sizeof(body))
+        return 0;
+    int req_len = snprintf(req, sizeof(req),
+                           "POST /api/node/heartbeat HTTP/1.1\r\n"
+                           "Host: %s:%d\r\n"
+                           "Content-Type: application/json\r\n"
+                           "Content-Length: %d\r\n"
+                           "\r\n"
+                           "%s",
+                           g_sys_cfg.server_ip, g_sys_cfg.server_port, body_len, body);
+    if (req_len <= 0 || req_len >= (int)sizeof(req))
+        return 0;
 
     // 探测包小，阻塞发送即可
-    HAL_UART_Transmit(&huart2, http_packet_buf, (uint16_t)(h_len + body_len), 500);
+    HAL_UART_Transmit(&huart2, (uint8_t *)req, (uint16_t)req_len, 500);
     if (ESP_Wait_Keyword("HTTP/1.1", 800))
     {
         // 复用成功：重启 RX DMA，用于接收 reset 指令 & 更新时间戳
@@ -2662,45 +3670,37 @@ static inline char *ESP_AppendI32(char *p, const char *end, int32_t x)
     return p;
 }
 
-static int Helper_FloatArray_To_String(char **pp, const char *end, const float *data, int count, int step)
-{
-    if (!pp || !*pp || !end || *pp >= end || !data || count <= 0 || step <= 0)
-        return 0;
+/* 数组写到段尾时至少留这么多字节再停：一个数（≤ 11 字符）+ 逗号 */
+#define ESP_GEN_NUM_ROOM 16
+/* JSON：段内剩余不少于此值才写下一单元（最大的单元是 tones 数组，8 个跟踪器约 700 字节） */
+#define ESP_GEN_JSON_UNIT 1024u
 
+/* 从第 i 点起（每 step 点取 1 点）输出 ×200 整数，逗号分隔、末点后不带逗号；
+ * 写到缓冲只剩不到 ESP_GEN_NUM_ROOM 字节为止，返回下一个要写的点（≥ count 表示写完） */
+static uint32_t Helper_FloatArray_To_String(char **pp, const char *end, const float *data, uint32_t i, uint32_t count,
+                                            uint32_t step)
+{
     char *p = *pp;
 
-    for (int i = 0; i < count; i += step)
+    for (; i < count && (end - p) >= ESP_GEN_NUM_ROOM; i += step)
     {
-        int32_t x = ESP_FloatToI32Scaled(data[i]);
-        char *np = ESP_AppendI32(p, end, x);
-        if (!np)
-            return 0;
-        p = np;
+        p = ESP_AppendI32(p, end, ESP_FloatToI32Scaled(data[i]));
         if (i + step < count)
-        {
-            if (p + 1 > (char *)end)
-                return 0;
             *p++ = ',';
-        }
     }
-
-    if (p >= (char *)end)
-        return 0;
-    *p = 0;
     *pp = p;
-    return 1;
+    return i;
 }
 
-/* 输出 float 数组（1 位小数），不做 ×200 缩放
+/* 输出 float 数组（1 位小数），不做 ×200 缩放，用法同上
  * - 仍不使用 snprintf，避免 CPU 开销
  * - 仅用于 fft_spectrum[]（你要求 FFT 不需要 ×200） */
-static int Helper_FloatArray1dp_To_String(char **pp, const char *end, const float *data, int count, int step)
+static uint32_t Helper_FloatArray1dp_To_String(char **pp, const char *end, const float *data, uint32_t i,
+                                               uint32_t count, uint32_t step)
 {
-    if (!pp || !*pp || !end || *pp >= end || !data || count <= 0 || step <= 0)
-        return 0;
-
     char *p = *pp;
-    for (int i = 0; i < count; i += step)
+
+    for (; i < count && (end - p) >= ESP_GEN_NUM_ROOM; i += step)
     {
         float vf = ESP_SafeFloat(data[i]);
         int32_t x10 = (int32_t)((vf >= 0.0f) ? (vf * 10.0f + 0.5f) : (vf * 10.0f - 0.5f));
@@ -2709,26 +3709,633 @@ static int Helper_FloatArray1dp_To_String(char **pp, const char *end, const floa
         if (fp < 0)
             fp = -fp;
 
-        char *np = ESP_AppendI32(p, end, ip);
-        if (!np || (end - np) < 2)
+        p = ESP_AppendI32(p, end, ip);
+        *p++ = '.';
+        *p++ = (char)('0' + (fp % 10));
+        if (i + step < count)
+            *p++ = ',';
+    }
+    *pp = p;
+    return i;
+}
+
+/* 纹波跟踪：在 channels 数组之后追加 ,"tones":[{"ch","hz","amp","phase","age_ms"},...]
+ * 只带已有结果的跟踪器（发送开始时取的快照）；amp 为峰值工程量（不 ×200），phase 为度
+ * 返回 1=已追加 */
+static int ESP_Append_Tones(char **pp, const char *end, const esp_up_snap_t *sn)
+{
+    char *p = *pp;
+
+    if (!ESP_Appendf(&p, end, ",\"tones\":["))
+        return 0;
+    for (uint32_t i = 0; i < sn->ntone; i++)
+    {
+        const AD_ToneResult_t *r = &sn->tone[i];
+        if (!ESP_Appendf(&p, end, "%s{\"ch\":%u,\"hz\":%.2f,\"amp\":%.5f,\"phase\":%.1f,\"age_ms\":%lu}",
+                         i ? "," : "", (unsigned)r->phys, (double)r->hz, (double)r->amp, (double)r->phase_deg,
+                         (unsigned long)(sn->tick - r->tick_ms)))
+            return 0;
+    }
+    if (!ESP_Appendf(&p, end, "]"))
+        return 0;
+    *pp = p;
+    return 1;
+}
+
+/* 故障分类：在 channels 数组之后追加 ,"class":{"code","idx","score","cyc"}
+ * 取自当前持有的 DSP 快照；未加载模型（cls = -1）时不追加，SVM 的 score 为 null
+ * 返回 1=已追加（或无需追加） */
+static int ESP_Append_Class(char **pp, const char *end, const esp_up_snap_t *sn)
+{
+    if (!s_dsp_res || s_dsp_res->cls.cls < 0)
+        return 1;
+    const AD_ClassResult_t *c = &s_dsp_res->cls;
+    char score[16];
+    if (isfinite(c->score))
+        (void)snprintf(score, sizeof(score), "%.3f", (double)c->score);
+    else
+        (void)snprintf(score, sizeof(score), "null");
+    return ESP_Appendf(pp, end, ",\"class\":{\"code\":\"%s\",\"idx\":%d,\"score\":%s,\"cyc\":%lu}", c->code,
+                       (int)c->cls, score, (unsigned long)sn->class_cyc);
+}
+
+/* 对地绝缘电阻：在 channels 数组之后追加 ,"iso":{"mode","rp","rn","r","trend","rate"}（kΩ、%/h）
+ * 还没有估计时不追加；变化率未稳定（NaN）时为 null
+ * 返回 1=已追加（或无需追加） */
+static int ESP_Append_Iso(char **pp, const char *end, const esp_up_snap_t *sn)
+{
+    const AD_IsoResult_t *iso = &sn->iso;
+
+    if (!iso->valid)
+        return 1;
+    char rate[16];
+    if (isfinite(iso->rate_pct_h))
+        (void)snprintf(rate, sizeof(rate), "%.2f", (double)iso->rate_pct_h);
+    else
+        (void)snprintf(rate, sizeof(rate), "null");
+    return ESP_Appendf(pp, end, ",\"iso\":{\"mode\":\"%s\",\"rp\":%.1f,\"rn\":%.1f,\"r\":%.1f,\"trend\":%.1f,\"rate\":%s}",
+                       (iso->mode == AD_ISO_MODE_BRIDGE) ? "bridge" : "passive", (double)iso->r_p_kohm,
+                       (double)iso->r_n_kohm, (double)iso->r_iso_kohm, (double)iso->trend_kohm, rate);
+}
+
+/* 瞬态录波事件：每通道最多 ESP_EVENT_MAX_POINTS 点（按整数步长抽取），JSON 数值同 waveform 一样 ×200；
+ * 取到即在发送结束时释放（至多一次）：发送失败只影响上报，SD 上仍有完整的原始码文件 */
+#ifndef ESP_EVENT_MAX_POINTS
+#define ESP_EVENT_MAX_POINTS 1024u
+#endif
+
+/*
+*********************************************************************************************************
+* 函 数 名: ESP_Up_Snapshot
+* 功能说明: 发送开始时冻结本次上报会用到的易变量
+* 形    参: sn   - 输出
+*           kind - esp_up_kind_t
+*           seq  - 上报序号
+* 返 回 值: 无
+* 说    明: 有待上报的录波事件时在这里 Acquire，发送结束（ESP_Tx_Finish）时 Release；
+*           断线缓存的补传进度也在这里取一次（Content-Length 模式两遍生成要一致）
+*********************************************************************************************************
+*/
+static void ESP_Up_Snapshot(esp_up_snap_t *sn, esp_up_kind_t kind, uint32_t seq)
+{
+    AD_DspStats_t ds;
+    AD_FaultStatus_t fst;
+    SD_SpoolStats_t sp;
+
+    sn->seq = seq;
+    sn->tick = HAL_GetTick();
+    memcpy(sn->fault_code, g_fault_code, sizeof(sn->fault_code));
+    sn->wave_step = ESP_CommParams_WaveStep();
+    AD_Dsp_GetStats(&ds);
+    sn->class_cyc = ds.class_cyc;
+    AD_Fault_GetStatus(&fst);
+    sn->iso = fst.iso;
+
+    sn->ntone = 0;
+    if (kind == ESP_UP_SUMMARY)
+    {
+        for (uint32_t i = 0; i < AD_TONE_MAX; i++)
+        {
+            if (AD_Tone_Get(i, &sn->tone[sn->ntone]))
+                sn->ntone++;
+        }
+    }
+
+    sn->has_ev = AD_Trig_Acquire(AD_TRIG_CONSUMER_UPLINK, &sn->ev) ? 1u : 0u;
+    if (sn->has_ev)
+    {
+        const AD7606_CalTable_t *cal = AD7606_Cal_Acquire();
+        const float k0 = AD7606_GetFullScaleVolts() / 32768.0f / AD7606_FRONTEND_GAIN;
+        sn->ev_step = (sn->ev.frames + ESP_EVENT_MAX_POINTS - 1u) / ESP_EVENT_MAX_POINTS;
+        if (sn->ev_step == 0u)
+            sn->ev_step = 1u;
+        for (int i = 0; i < NODE_CHANNEL_COUNT; i++)
+        {
+            uint32_t phys = AD_Acq_PhysChannel((uint32_t)i);
+            sn->ev_k[i] = k0 * cal->ch[phys].gain;
+            sn->ev_off[i] = cal->ch[phys].offset;
+        }
+        AD7606_Cal_Release(cal);
+    }
+
+    sn->spooled = 0;
+    sn->rtc_sec = 0;
+    sn->has_sp = s_spool.ready;
+    if (sn->has_sp)
+    {
+        SD_Spool_GetStats(&sp);
+        sn->sp_pending = sp.pending[SD_SPOOL_PRIO_EVENT] + sp.pending[SD_SPOOL_PRIO_NORMAL];
+        sn->sp_pending_ev = sp.pending[SD_SPOOL_PRIO_EVENT];
+        sn->sp_kb = (sp.pending_bytes + 1023u) / 1024u;
+        sn->sp_replayed = sp.replayed;
+        sn->sp_dropped = sp.dropped;
+        sn->sp_replaying = (sn->sp_pending && s_spool.inflight) ? 1u : 0u;
+    }
+}
+
+static void ESP_Up_GenReset(esp_up_gen_t *g, esp_up_kind_t kind, const esp_up_snap_t *sn)
+{
+    memset(g, 0, sizeof(*g));
+    g->kind = (uint8_t)kind;
+    g->stage = ESP_GEN_HEAD;
+    if (kind == ESP_UP_FULL_BIN)
+    {
+        g->sections = (uint16_t)(NODE_CHANNEL_COUNT * 4);
+        if (s_dsp_res && s_dsp_res->cls.cls >= 0)
+            g->sections++;
+        if (sn->iso.valid)
+            g->sections++;
+        if (sn->has_ev)
+            g->sections++;
+        if (sn->spooled || sn->has_sp)
+            g->sections++;
+    }
+}
+
+/* JSON 写一个单元并推进游标；数组单元写到段尾为止，写完后下一次调用写数组后面的收尾
+ * 返回 0 = 单元放不下（调用方保证剩余 ≥ ESP_GEN_JSON_UNIT，不应发生） */
+static int ESP_Up_JsonUnit(esp_up_gen_t *g, const esp_up_snap_t *sn, char **pp, const char *end)
+{
+    const uint8_t full = (g->kind != ESP_UP_SUMMARY) ? 1u : 0u;
+    const int i = g->ch;
+
+    switch (g->stage)
+    {
+    case ESP_GEN_HEAD:
+        if (!ESP_Appendf(pp, end, "{\"node_id\":\"%s\",\"status\":\"online\",\"fault_code\":\"%.4s\",\"seq\":%lu,"
+                         "\"sample_rate\":%lu,\"os_mode\":%u,\"acq_profile\":%u,",
+                         g_sys_cfg.node_id, sn->fault_code, (unsigned long)sn->seq,
+                         (unsigned long)s_blk_sample_rate, (unsigned)s_blk_os_mode, (unsigned)s_blk_profile))
+            return 0;
+        if (sn->has_sp &&
+            !ESP_Appendf(pp, end, "\"spool\":{\"pending\":%lu,\"pending_ev\":%lu,\"kb\":%lu,\"replayed\":%lu,"
+                         "\"dropped\":%lu,\"replaying\":%u},",
+                         (unsigned long)sn->sp_pending, (unsigned long)sn->sp_pending_ev, (unsigned long)sn->sp_kb,
+                         (unsigned long)sn->sp_replayed, (unsigned long)sn->sp_dropped, (unsigned)sn->sp_replaying))
             return 0;
-        *np++ = '.';
-        *np++ = (char)('0' + (fp % 10));
-        p = np;
+        if (!ESP_Appendf(pp, end, "\"channels\":["))
+            return 0;
+        g->ch = 0;
+        g->stage = (NODE_CHANNEL_COUNT > 0) ? ESP_GEN_CH_HEAD : ESP_GEN_CH_END;
+        return 1;
 
-        if (i + step < count)
+    case ESP_GEN_CH_HEAD:
+    {
+        int32_t cv_i = ESP_FloatToI32Scaled(node_channels[i].current_value);
+        if (!ESP_Appendf(pp, end,
+                         "%s{"
+                         "\"id\":%d,\"channel_id\":%d,"
+                         "\"label\":\"%s\",\"name\":\"%s\","
+                         "\"value\":%ld,\"current_value\":%ld,"
+                         "\"unit\":\"%s\"",
+                         i ? "," : "", node_channels[i].id, node_channels[i].id,
+                         node_channels[i].label, node_channels[i].label, // name冗余label
+                         (long)cv_i, (long)cv_i,
+                         node_channels[i].unit))
+            return 0;
+        if (full)
         {
-            if (p + 1 > (char *)end)
+            // 波形数据（运行时降采样：step=1全量，step=4每4点取1点）
+            if (!ESP_Appendf(pp, end, ",\"waveform\":["))
                 return 0;
-            *p++ = ',';
+            g->pos = 0;
+            g->stage = ESP_GEN_CH_WAVE;
+            return 1;
+        }
+        /* 单趟统计量（工程量，不乘 ESP_UPLOAD_SCALE）：峭度/峰值因数用于漏电流尖峰判别 */
+        if (s_dsp_res)
+        {
+            const AD_DspChStats_t *st = &s_dsp_res->stats[i];
+            if (!ESP_Appendf(pp, end,
+                             ",\"stats\":{\"rms\":%.4f,\"min\":%.4f,\"max\":%.4f,\"p2p\":%.4f,"
+                             "\"std\":%.4f,\"crest\":%.3f,\"skew\":%.3f,\"kurt\":%.3f}",
+                             (double)ESP_SafeFloat(st->rms), (double)ESP_SafeFloat(st->min),
+                             (double)ESP_SafeFloat(st->max), (double)ESP_SafeFloat(st->p2p),
+                             (double)ESP_SafeFloat(st->std), (double)ESP_SafeFloat(st->crest),
+                             (double)ESP_SafeFloat(st->skew), (double)ESP_SafeFloat(st->kurt)))
+                return 0;
+        }
+        if (!ESP_Appendf(pp, end, "}"))
+            return 0;
+        g->ch++;
+        g->stage = (g->ch < NODE_CHANNEL_COUNT) ? ESP_GEN_CH_HEAD : ESP_GEN_CH_END;
+        return 1;
+    }
+
+    case ESP_GEN_CH_WAVE:
+        if (g->pos < WAVEFORM_POINTS)
+        {
+            g->pos = Helper_FloatArray_To_String(pp, end, s_dsp_res->wave[i], g->pos, WAVEFORM_POINTS, sn->wave_step);
+            return 1;
+        }
+        // 频谱数据（FFT 不乘 200：保持原始数值，1 位小数）
+        if (!ESP_Appendf(pp, end, "],\"fft_spectrum\":["))
+            return 0;
+        g->pos = 0;
+        g->stage = ESP_GEN_CH_SPEC;
+        return 1;
+
+    case ESP_GEN_CH_SPEC:
+        if (g->pos < FFT_POINTS)
+        {
+            g->pos = Helper_FloatArray1dp_To_String(pp, end, s_dsp_res->spec[i], g->pos, FFT_POINTS, 1u);
+            return 1;
+        }
+        g->stage = ESP_GEN_CH_TAIL;
+        /* fall through */
+    case ESP_GEN_CH_TAIL:
+        // 谐波幅值（Welch 平均 + 窗修正，1..AD_PSD_HARMONICS 次），然后结束当前 channel
+        if (!ESP_Appendf(pp, end, "],\"harmonics\":["))
+            return 0;
+        for (uint32_t h = 0; h < AD_PSD_HARMONICS; h++)
+        {
+            if (!ESP_Appendf(pp, end, h ? ",%.4f" : "%.4f", (double)s_dsp_res->harm[i][h]))
+                return 0;
+        }
+        if (!ESP_Appendf(pp, end, "]}"))
+            return 0;
+        g->ch++;
+        g->stage = (g->ch < NODE_CHANNEL_COUNT) ? ESP_GEN_CH_HEAD : ESP_GEN_CH_END;
+        return 1;
+
+    case ESP_GEN_CH_END:
+        if (!ESP_Appendf(pp, end, "]"))
+            return 0;
+        g->stage = full ? ESP_GEN_CLASS : ESP_GEN_TONES;
+        return 1;
+
+    case ESP_GEN_TONES:
+        if (!ESP_Append_Tones(pp, end, sn))
+            return 0;
+        g->stage = ESP_GEN_CLASS;
+        return 1;
+
+    case ESP_GEN_CLASS:
+        if (!ESP_Append_Class(pp, end, sn)) // 故障分类推理结果（若已加载模型）
+            return 0;
+        g->stage = ESP_GEN_ISO;
+        return 1;
+
+    case ESP_GEN_ISO:
+        if (!ESP_Append_Iso(pp, end, sn)) // 对地绝缘电阻估计（若已有估计）
+            return 0;
+        g->stage = sn->has_ev ? ESP_GEN_EV_HEAD : ESP_GEN_TAIL;
+        return 1;
+
+    case ESP_GEN_EV_HEAD:
+    {
+        const AD_TrigEvent_t *ev = &sn->ev;
+        if (!ESP_Appendf(pp, end,
+                         ",\"event\":{\"seq\":%lu,\"fault_code\":\"%s\",\"trig_ch\":%u,\"trig_type\":\"%s\","
+                         "\"fs\":%lu,\"os_mode\":%u,\"pre\":%lu,\"post\":%lu,\"frames\":%lu,\"step\":%lu,\"channels\":[",
+                         (unsigned long)ev->seq, ev->fault_code, (unsigned)ev->trig_ch, AD_Trig_TypeName(ev->trig_type),
+                         (unsigned long)ev->sample_rate, (unsigned)ev->os_mode, (unsigned long)ev->pre,
+                         (unsigned long)ev->post, (unsigned long)ev->frames, (unsigned long)sn->ev_step))
+            return 0;
+        g->ch = 0;
+        g->stage = ESP_GEN_EV_CH_HEAD;
+        return 1;
+    }
+
+    case ESP_GEN_EV_CH_HEAD:
+        if (!ESP_Appendf(pp, end, "%s{\"id\":%d,\"label\":\"%s\",\"unit\":\"%s\",\"waveform\":[", (i ? "," : ""),
+                         node_channels[i].id, node_channels[i].label, node_channels[i].unit))
+            return 0;
+        g->pos = 0;
+        g->stage = ESP_GEN_EV_CH_DATA;
+        return 1;
+
+    case ESP_GEN_EV_CH_DATA:
+    {
+        const AD_TrigEvent_t *ev = &sn->ev;
+        if (g->pos < ev->frames)
+        {
+            char *p = *pp;
+            uint32_t f = g->pos;
+            for (; f < ev->frames && (end - p) >= ESP_GEN_NUM_ROOM; f += sn->ev_step)
+            {
+                float v = ((float)AD_Trig_Sample(ev, f, (uint32_t)i) - sn->ev_off[i]) * sn->ev_k[i];
+                p = ESP_AppendI32(p, end, ESP_FloatToI32Scaled(v));
+                if (f + sn->ev_step < ev->frames)
+                    *p++ = ',';
+            }
+            *pp = p;
+            g->pos = f;
+            return 1;
         }
+        if (!ESP_Appendf(pp, end, "]}"))
+            return 0;
+        g->ch++;
+        g->stage = (g->ch < NODE_CHANNEL_COUNT) ? ESP_GEN_EV_CH_HEAD : ESP_GEN_EV_END;
+        return 1;
     }
 
-    if (p >= (char *)end)
+    case ESP_GEN_EV_END:
+        if (!ESP_Appendf(pp, end, "]}"))
+            return 0;
+        g->stage = ESP_GEN_TAIL;
+        return 1;
+
+    case ESP_GEN_TAIL:
+        if (!ESP_Appendf(pp, end, "}")) // JSON End
+            return 0;
+        g->stage = ESP_GEN_DONE;
+        return 1;
+
+    default:
         return 0;
-    *p = 0;
-    *pp = p;
-    return 1;
+    }
+}
+
+/* 二进制帧的瞬态录波事件段：内容与 JSON 的 "event" 相同（同样按 ESP_EVENT_MAX_POINTS 抽取），
+ * 但直接带原始码 + 每通道标定（scale/offset），不在 MCU 上换算工程量 */
+static void ESP_Frame_AddTrigEvent(AD_FrameWriter_t *w, const esp_up_snap_t *sn)
+{
+    const AD_TrigEvent_t *ev = &sn->ev;
+    const uint32_t step = sn->ev_step;
+
+    AD_Frame_SecBegin(w, ESP_FRAME_WAVE_CODEC ? AD_FRAME_SEC_EVENT_Z : AD_FRAME_SEC_EVENT, ev->trig_ch);
+    AD_Frame_PutU32(w, ev->seq);
+    AD_Frame_PutU32(w, ev->sample_rate);
+    AD_Frame_PutU32(w, ev->pre);
+    AD_Frame_PutU32(w, ev->post);
+    AD_Frame_PutU32(w, ev->frames);
+    AD_Frame_PutU32(w, step);
+    AD_Frame_PutU8(w, ev->trig_ch);
+    AD_Frame_PutU8(w, ev->trig_type);
+    AD_Frame_PutU8(w, ev->os_mode);
+    AD_Frame_PutU8(w, (uint8_t)NODE_CHANNEL_COUNT);
+    AD_Frame_PutBytes(w, ev->fault_code, 4u);
+#if ESP_FRAME_WAVE_CODEC
+    AD_Frame_PutU16(w, (uint16_t)AD_CODEC_BLOCK);
+    AD_Frame_PutU16(w, 0u);
+#endif
+    for (int i = 0; w->ok && i < NODE_CHANNEL_COUNT; i++)
+    {
+        uint32_t phys = AD_Acq_PhysChannel((uint32_t)i);
+        float k = sn->ev_k[i];
+        AD_Frame_PutU8(w, (uint8_t)phys);
+        AD_Frame_PutU8(w, 0u);
+        AD_Frame_PutU16(w, 0u);
+        AD_Frame_PutF32(w, k);
+        AD_Frame_PutF32(w, -sn->ev_off[i] * k);
+#if ESP_FRAME_WAVE_CODEC
+        /* u32 nbytes 先占位，编完回填；每通道独立码流 */
+        uint32_t nb_off = w->len;
+        uint32_t nbytes = 0u;
+        AD_Frame_PutU32(w, 0u);
+        AD_Codec_Reset(&s_frame_codec);
+        for (uint32_t f = 0; w->ok && f < ev->frames;)
+        {
+            uint32_t cnt = 0u;
+            for (; cnt < AD_CODEC_BLOCK && f < ev->frames; f += step)
+                s_frame_codec.in[cnt++] = AD_Trig_Sample(ev, f, (uint32_t)i);
+            nbytes += AD_Frame_PutCodecBlock(w, &s_frame_codec, 0u, s_frame_codec.in, cnt);
+        }
+        if (w->ok)
+        {
+            w->buf[nb_off] = (uint8_t)nbytes;
+            w->buf[nb_off + 1u] = (uint8_t)(nbytes >> 8);
+            w->buf[nb_off + 2u] = (uint8_t)(nbytes >> 16);
+            w->buf[nb_off + 3u] = (uint8_t)(nbytes >> 24);
+        }
+#else
+        for (uint32_t f = 0; w->ok && f < ev->frames; f += step)
+            AD_Frame_PutU16(w, (uint16_t)AD_Trig_Sample(ev, f, (uint32_t)i));
+#endif
+    }
+    AD_Frame_SecEnd(w);
+}
+
+/* 二进制帧写一段（段序与 JSON 对应：每通道 CHAN + WAVE/WAVE_Z + SPEC + HARM，其后 CLASS / ISO / EVENT / SPOOL 或 TIME，最后 CRC）；
+ * 不推进游标，写不下时 w->ok = 0 由调用方回退 */
+static void ESP_Up_BinUnit(esp_up_gen_t *g, const esp_up_snap_t *sn)
+{
+    AD_FrameWriter_t *w = &g->w;
+    const int i = g->ch;
+    const uint8_t ch = (i < NODE_CHANNEL_COUNT) ? node_channels[i].id : AD_FRAME_CH_NONE;
+
+    switch (g->stage)
+    {
+    case ESP_GEN_CH_HEAD:
+        AD_Frame_AddChan(w, ch, node_channels[i].current_value, &s_dsp_res->stats[i]);
+        break;
+    case ESP_GEN_CH_WAVE:
+#if ESP_FRAME_WAVE_CODEC
+        AD_Frame_AddWaveZ(w, &s_frame_codec, ch, s_dsp_res->wave[i], WAVEFORM_POINTS, sn->wave_step,
+                          (float)ESP_UPLOAD_SCALE);
+#else
+        AD_Frame_AddWave(w, ch, s_dsp_res->wave[i], WAVEFORM_POINTS, sn->wave_step);
+#endif
+        break;
+    case ESP_GEN_CH_SPEC:
+        AD_Frame_AddSpec(w, ch, s_dsp_res->spec[i], FFT_POINTS, 1u);
+        break;
+    case ESP_GEN_CH_TAIL:
+        AD_Frame_AddFloats(w, AD_FRAME_SEC_HARM, ch, s_dsp_res->harm[i], AD_PSD_HARMONICS);
+        break;
+    case ESP_GEN_CLASS:
+        if (s_dsp_res->cls.cls < 0)
+            break;
+        AD_Frame_SecBegin(w, AD_FRAME_SEC_CLASS, AD_FRAME_CH_NONE);
+        AD_Frame_PutU8(w, (uint8_t)s_dsp_res->cls.cls);
+        AD_Frame_PutBytes(w, s_dsp_res->cls.code, 4u);
+        AD_Frame_PutU8(w, 0u);
+        AD_Frame_PutF32(w, s_dsp_res->cls.score);
+        AD_Frame_PutU32(w, sn->class_cyc);
+        AD_Frame_SecEnd(w);
+        break;
+    case ESP_GEN_ISO:
+        if (!sn->iso.valid)
+            break;
+        AD_Frame_SecBegin(w, AD_FRAME_SEC_ISO, AD_FRAME_CH_NONE);
+        AD_Frame_PutU8(w, sn->iso.mode);
+        AD_Frame_PutU8(w, 0u);
+        AD_Frame_PutU16(w, 0u);
+        AD_Frame_PutF32(w, sn->iso.r_p_kohm);
+        AD_Frame_PutF32(w, sn->iso.r_n_kohm);
+        AD_Frame_PutF32(w, sn->iso.r_iso_kohm);
+        AD_Frame_PutF32(w, sn->iso.trend_kohm);
+        AD_Frame_PutF32(w, sn->iso.rate_pct_h);
+        AD_Frame_SecEnd(w);
+        break;
+    case ESP_GEN_EV_HEAD:
+        if (sn->has_ev)
+            ESP_Frame_AddTrigEvent(w, sn);
+        break;
+    case ESP_GEN_SPOOL:
+        if (sn->spooled)
+        {
+            AD_Frame_SecBegin(w, AD_FRAME_SEC_TIME, AD_FRAME_CH_NONE);
+            AD_Frame_PutU32(w, sn->rtc_sec);
+            AD_Frame_PutU32(w, 0u);
+            AD_Frame_SecEnd(w);
+        }
+        else if (sn->has_sp)
+        {
+            AD_Frame_SecBegin(w, AD_FRAME_SEC_SPOOL, AD_FRAME_CH_NONE);
+            AD_Frame_PutU32(w, sn->sp_pending);
+            AD_Frame_PutU32(w, sn->sp_pending_ev);
+            AD_Frame_PutU32(w, sn->sp_kb);
+            AD_Frame_PutU32(w, sn->sp_replayed);
+            AD_Frame_PutU32(w, sn->sp_dropped);
+            AD_Frame_PutU8(w, sn->sp_replaying);
+            AD_Frame_PutU8(w, 0u);
+            AD_Frame_PutU16(w, 0u);
+            AD_Frame_SecEnd(w);
+        }
+        break;
+    case ESP_GEN_TAIL:
+        if (AD_Frame_EndStream(w) == 0u)
+            w->ok = 0u;
+        break;
+    default:
+        w->ok = 0u;
+        break;
+    }
+}
+
+static void ESP_Up_BinAdvance(esp_up_gen_t *g)
+{
+    switch (g->stage)
+    {
+    case ESP_GEN_CH_HEAD:
+    case ESP_GEN_CH_WAVE:
+    case ESP_GEN_CH_SPEC:
+        g->stage++;
+        break;
+    case ESP_GEN_CH_TAIL:
+        g->ch++;
+        g->stage = (g->ch < NODE_CHANNEL_COUNT) ? ESP_GEN_CH_HEAD : ESP_GEN_CLASS;
+        break;
+    case ESP_GEN_CLASS:
+        g->stage = ESP_GEN_ISO;
+        break;
+    case ESP_GEN_ISO:
+        g->stage = ESP_GEN_EV_HEAD;
+        break;
+    case ESP_GEN_EV_HEAD:
+        g->stage = ESP_GEN_SPOOL;
+        break;
+    case ESP_GEN_SPOOL:
+        g->stage = ESP_GEN_TAIL;
+        break;
+    default:
+        g->stage = ESP_GEN_DONE;
+        break;
+    }
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: ESP_Up_GenFill
+* 功能说明: 上报正文生成器：从游标处接着写，直到缓冲写满或正文写完
+* 形    参: g   - 游标（ESP_Up_GenReset 初始化）
+*           sn  - 发送开始时的快照
+*           buf - 一个发送段
+*           cap - 段长
+* 返 回 值: 写入字节数；g->stage == ESP_GEN_DONE 表示写完，g->err 置位表示有单元放不进一整段
+* 说    明: 内容与顺序同原整包 JSON / ESP_Build_BinFrame，输出逐字节相同，只是分段产出；
+*           JSON 按单元写（段内剩余 < ESP_GEN_JSON_UNIT 即停，数组在任意点断开）；
+*           二进制按段写（ad_frame 流式接口，写不下的段整段挪到下一个发送段，帧头段数事先算好）
+*********************************************************************************************************
+*/
+static uint32_t ESP_Up_GenFill(esp_up_gen_t *g, const esp_up_snap_t *sn, uint8_t *buf, uint32_t cap)
+{
+    if (g->kind == ESP_UP_SPOOL)
+    {
+        /* 缓存帧原样读出（写缓存时已是完整二进制帧），读不满说明 SD 出错：chunked 时正文残缺，服务器回 400 */
+        uint32_t n = SD_Spool_Read(buf, cap);
+        g->pos += n;
+        if (g->pos >= s_spool.rec.len)
+            g->stage = ESP_GEN_DONE;
+        else if (n == 0u)
+            g->err = 1;
+        return n;
+    }
+
+    if (g->kind != ESP_UP_FULL_BIN)
+    {
+        char *p = (char *)buf;
+        const char *end = (const char *)buf + cap;
+        while (g->stage != ESP_GEN_DONE && (uint32_t)(end - p) >= ESP_GEN_JSON_UNIT)
+        {
+            if (!ESP_Up_JsonUnit(g, sn, &p, end))
+            {
+                g->err = 1;
+                break;
+            }
+        }
+        return (uint32_t)(p - (char *)buf);
+    }
+
+    if (g->stage == ESP_GEN_HEAD)
+    {
+        AD_FrameHeader_t h;
+        memset(&h, 0, sizeof(h));
+        h.seq = sn->seq;
+        h.sample_rate = s_blk_sample_rate;
+        h.tick_ms = s_dsp_res->tick_ms;
+        h.ch_count = (uint8_t)NODE_CHANNEL_COUNT;
+        for (int i = 0; i < NODE_CHANNEL_COUNT; i++)
+            h.ch_mask |= (uint8_t)(1u << node_channels[i].id);
+        h.os_mode = s_blk_os_mode;
+        h.profile = s_blk_profile;
+        h.flags = sn->spooled ? (uint8_t)AD_FRAME_FLAG_SPOOL : 0u;
+        memcpy(h.fault_code, sn->fault_code, sizeof(h.fault_code));
+        AD_Frame_BeginStream(&g->w, buf, cap, &h, g_sys_cfg.node_id, g->sections);
+        g->ch = 0;
+        g->stage = ESP_GEN_CH_HEAD;
+    }
+    else
+    {
+        AD_Frame_Rebase(&g->w, buf, cap);
+    }
+
+    while (g->w.ok && g->stage != ESP_GEN_DONE)
+    {
+        const AD_FrameWriter_t saved = g->w;
+#if ESP_FRAME_WAVE_CODEC
+        const AD_CodecStats_t cst = s_frame_codec.st;
+#endif
+        ESP_Up_BinUnit(g, sn);
+        if (g->w.ok)
+        {
+            ESP_Up_BinAdvance(g);
+            continue;
+        }
+        /* 本段写不下：回退，留到下一个空段；空段也写不下说明段长配置过小 */
+        g->w = saved;
+#if ESP_FRAME_WAVE_CODEC
+        s_frame_codec.st = cst;
+#endif
+        if (saved.len == 0u)
+            g->err = 1;
+        break;
+    }
+    if (!g->w.ok)
+        g->err = 1;
+    return g->w.len;
 }
 
 static void ESP_Exit_Transparent_Mode(void)
@@ -3180,7 +4787,7 @@ static bool ESP_UI_DoRegister(void)
     HAL_Delay(500);
     ESP_Register();
 
-    /* 关键：进入“可上报”前初始化 4 通道与 FFT，否则后端只会看到 1 个通道 */
+    /* 关键：进入“可上报”前初始化各通道与 FFT，否则后端只会看到 1 个通道 */
     ESP_Init_Channels_And_DSP();
 
     /* 注册完成后，切换到数据监听模式 */
@@ -3203,6 +4810,7 @@ static void ESP_UI_ToggleReport(void)
             return;
         }
         g_report_enabled = 1U;
+        AD_Trig_SetConsumer(AD_TRIG_CONSUMER_UPLINK, true);
         ESP_Log("[UI] Started sensor data upload loop.\r\n");
         /* 记录上次上电前上报状态：开启 */
         (void)ESP_AutoReconnect_SetLastReporting(true);
@@ -3210,6 +4818,7 @@ static void ESP_UI_ToggleReport(void)
     else
     {
         g_report_enabled = 0U;
+        AD_Trig_SetConsumer(AD_TRIG_CONSUMER_UPLINK, false);
         ESP_Log("[UI] Data upload stopped.\r\n");
         /* 记录上次上电前上报状态：关闭 */
         (void)ESP_AutoReconnect_SetLastReporting(false);
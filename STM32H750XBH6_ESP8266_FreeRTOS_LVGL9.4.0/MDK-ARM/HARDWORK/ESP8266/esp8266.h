@@ -10,6 +10,7 @@ extern "C"
 #include <stdint.h>
 #include <stdbool.h>
 #include "sd_config.h"
+#include "ad_acq_buffers.h"
 
 /* ================= 用户配置区 ================= */
 // 引入用户具体的 WiFi 和服务器配置
@@ -97,6 +98,56 @@ extern "C"
 #define ESP_CHUNK_DELAY_MS_DEFAULT 10
 #endif
 
+/* 全量上报格式：JSON -> POST /api/node/heartbeat；二进制帧（ad_frame.h）-> POST /api/node/frame
+ * 二进制帧约为 JSON 的 1/3，编码不做文本格式化（tools/frame_check 实测）；轻量（summary）上报始终是 JSON */
+#define ESP_FRAME_FMT_JSON   0u
+#define ESP_FRAME_FMT_BINARY 1u
+
+#ifndef ESP_FRAME_FMT_DEFAULT
+#define ESP_FRAME_FMT_DEFAULT ESP_FRAME_FMT_JSON
+#endif
+
+/* 上报请求体的长度声明（正文都是边生成边经乒乓段 DMA 发出，不再整包缓存）：
+ * 1 = Transfer-Encoding: chunked，决定发送后立即发请求头，每个发送段一个块；
+ * 0 = Content-Length，先空跑一遍生成器量出长度（全量 JSON 约多花一次格式化的时间）再发，给不支持分块请求体的服务器用 */
+#ifndef ESP_HTTP_CHUNKED_DEFAULT
+#define ESP_HTTP_CHUNKED_DEFAULT 1
+#endif
+
+/* 流水线上报：最多同时有这么多个请求在等回包（同一条 TCP 连接上按序回包，回包里的 "seq" 与请求对应）；
+ * 1 = 发一个等一个（原行为）。服务器 RTT 大时加大窗口，吞吐不再受 RTT 限制；运行时值见 HTTP_WINDOW */
+#ifndef ESP_HTTP_WINDOW_MAX
+#define ESP_HTTP_WINDOW_MAX 4
+#endif
+
+#ifndef ESP_HTTP_WINDOW_DEFAULT
+#define ESP_HTTP_WINDOW_DEFAULT 2
+#endif
+
+/* 断线缓存（sd_spool.h）：链路断开或回包停滞期间，按 SPOOL_INTERVAL_MS 把二进制帧写进 SD，
+ * 录波事件/故障码变化立即写（事件级，先补传）；恢复后按 SPOOL_REPLAY_MS 限速补传，且始终给实时上报留一个窗口位 */
+#ifndef ESP_SPOOL_ENABLE
+#define ESP_SPOOL_ENABLE 1
+#endif
+
+#ifndef ESP_SPOOL_INTERVAL_MS
+#define ESP_SPOOL_INTERVAL_MS 10000u
+#endif
+
+#ifndef ESP_SPOOL_REPLAY_MS
+#define ESP_SPOOL_REPLAY_MS 1000u
+#endif
+
+/* 在途队首等回包超过这么久视为链路停滞，开始写缓存、暂停补传 */
+#ifndef ESP_SPOOL_SLOW_MS
+#define ESP_SPOOL_SLOW_MS 3000u
+#endif
+
+/* 同一条记录补传失败这么多次就放弃（计入 dropped） */
+#ifndef ESP_SPOOL_MAX_TRIES
+#define ESP_SPOOL_MAX_TRIES 5u
+#endif
+
 typedef struct
 {
     uint32_t heartbeat_ms;      /* 心跳间隔 ms */
@@ -106,6 +157,9 @@ typedef struct
     uint32_t wave_step;         /* 波形降采样步进：1=全量，4=每4点取1点 */
     uint32_t chunk_kb;          /* 分段发送：每段 KB（0=关闭分段） */
     uint32_t chunk_delay_ms;    /* 分段发送：每段后延时 ms */
+    uint32_t frame_fmt;         /* 全量上报格式：ESP_FRAME_FMT_JSON / ESP_FRAME_FMT_BINARY */
+    uint32_t http_chunked;      /* 请求体：1=分块传输（chunked） 0=Content-Length */
+    uint32_t http_window;       /* 在途请求窗口：1..ESP_HTTP_WINDOW_MAX */
 } ESP_CommParams_t;
 
 /* 读取/写入运行时缓存（线程安全：内部使用 32-bit 原子写） */
@@ -123,6 +177,9 @@ uint32_t ESP_CommParams_HardResetSec(void);
 uint32_t ESP_CommParams_WaveStep(void);
 uint32_t ESP_CommParams_ChunkKb(void);
 uint32_t ESP_CommParams_ChunkDelayMs(void);
+uint32_t ESP_CommParams_FrameFmt(void);
+uint32_t ESP_CommParams_HttpChunked(void);
+uint32_t ESP_CommParams_HttpWindow(void);
 
 /* ================= 断电重连/上报状态持久化（SD 标志位） =================
  * 文件：0:/config/ui_autoreport.cfg
@@ -165,22 +222,24 @@ bool ESP_Config_LoadFromSD_UIFiles(void);
     /* 单个通道的数据结构 */
     typedef struct
     {
-        uint8_t id;                      // 通道编号 (0~3)
+        uint8_t id;                      // 物理通道编号 (0~7，对应 AD7606 V1~V8)
         char label[32];                  // 标签 (如 "直流母线(+)")，后端依据此字段识别数据含义
         char unit[8];                    // 单位 (V, A, mA)
         char type[16];                   // 类型 (预留字段)
         float current_value;             // 当前显示的有效值/瞬时值
-        float waveform[WAVEFORM_POINTS]; // 时域波形数组 (源数据)
-        float fft_data[FFT_POINTS];      // 频域数据数组 (FFT 计算结果)
+        /* 波形与频谱不再放在这里：由 DSP 任务写入结果快照（ad_dsp.h），上报时直接引用 */
     } Channel_Data_t;
 
     /* 全局变量声明 */
-    extern Channel_Data_t node_channels[4]; // 4个通道实例：母线+, 母线-, 电流, 漏电
+    /* 上报通道数 = 采集启用的通道数（AD_ACQ_CH_MASK，见 main.h） */
+#define NODE_CHANNEL_COUNT AD_ACQ_CHANNELS
+
+    extern Channel_Data_t node_channels[NODE_CHANNEL_COUNT]; // 默认 4 通道：母线+, 母线-, 电流, 漏电
     extern volatile uint8_t g_esp_ready;    // 标志位：1表示WiFi/TCP已连接，可以发送数据
 
     /* ================= 函数声明 ================= */
     void ESP_Init(void);                // 初始化 ESP8266 (AT指令序列)
-    void ESP_Update_Data_And_FFT(void); // 更新模拟数据并计算 FFT
+    void ESP_Update_Data_And_FFT(void); // 取 DSP 任务最新结果快照（不再在本任务里计算 FFT）
     void ESP_Post_Data(void);           // 打包 JSON 并通过 HTTP POST 发送
     void ESP_Post_Summary(void);        // 发送轻量数据（无波形/FFT）
     void ESP_Post_Heartbeat(void);      // 发送最小心跳包（保活）
@@ -0,0 +1,300 @@
+#ifndef ESP_HTTP_WIN_H
+#define ESP_HTTP_WIN_H
+
+/* ==========================================
+ * 流水线上报：在途请求窗口与回包解析（esp8266.c 包含，tools/httpwin_check 在主机上包含同一份）
+ * - 只供一个源文件包含：状态与函数都是 static，直接落在包含方的编译单元里
+ * - 包含方须先提供：HAL_GetTick、__get_PRIMASK/__disable_irq/__set_PRIMASK、
+ *   ESP_CommParams_HttpTimeoutMs/ESP_CommParams_HttpWindow、ESP_HTTP_WINDOW_MAX（esp8266.h），
+ *   并定义 ESP_HttpWin_OnRetire（请求出队时回调，固件用来给断线补传记结果）
+ * ========================================== */
+
+#include <stdint.h>
+#include <string.h>
+
+/* HTTP 发送流控：在途请求窗口（替代原“发一个等一个”的门控）
+ * 请求最后一字节交给 DMA 时入队，收到回包出队，队列满（HTTP_WINDOW）时不再开始新请求；超时未回的出队记超时。
+ * 同一条 TCP 连接上 HTTP/1.1 按请求顺序回包：回包正文里带 "seq" 的按序号对上（它之前还没回的记丢失），
+ * 不带的（最小心跳、4xx/5xx）对上最早的一个。入队在 TxCplt 中断或关中断里，回包解析在 USART2 接收中断里，
+ * 任务侧访问都关中断。 */
+typedef struct
+{
+    uint32_t seq;   /* 0 = 回包不带 seq（ESP_Post_Heartbeat） */
+    uint32_t tick;  /* 最后一字节交给 DMA 的时刻 */
+    uint32_t bytes; /* 正文字节数 */
+} esp_http_req_t;
+
+typedef struct
+{
+    esp_http_req_t q[ESP_HTTP_WINDOW_MAX];
+    uint8_t head;
+    uint8_t count;
+    /* 回包逐字节解析（跨接收块保持状态） */
+    uint8_t m_http;    /* "HTTP/1." 已匹配的字符数 */
+    uint8_t m_seq;     /* "\"seq\":" 已匹配的字符数 */
+    uint8_t st_state;  /* 1=跳过版本号到空格 2=读状态码 */
+    uint8_t seq_state; /* 1=等序号数字 2=读序号数字 */
+    uint8_t open;      /* 收到 2xx 状态行，等正文里的 "seq" */
+    uint16_t status;
+    uint32_t seq_val;
+    uint32_t open_tick;
+} esp_http_win_t;
+
+typedef struct
+{
+    uint32_t sent;
+    uint32_t acked;        /* 2xx 回包 */
+    uint32_t errors;       /* 非 2xx 回包 */
+    uint32_t timeouts;     /* HTTP_TIMEOUT_MS 内没有回包 */
+    uint32_t lost;         /* 后面的请求先回了 / 接收出错 / 链路重置 */
+    uint32_t late;         /* 对不上在途请求的回包（已按超时出队） */
+    uint32_t inflight_max;
+    uint32_t rtt_last;     /* ms：最后一字节交给 DMA -> 回包 */
+    uint32_t rtt_min;
+    uint32_t rtt_max;
+    uint32_t rtt_avg_x8;   /* 指数平均（1/8），×8 定点 */
+    uint32_t acked_bytes;
+    uint32_t rate_tick;    /* 每秒吞吐（任务侧统计） */
+    uint32_t rate_acked0;
+    uint32_t rate_bytes0;
+    uint32_t req_per_s;
+    uint32_t bytes_per_s;
+} esp_http_win_stats_t;
+
+static esp_http_win_t s_win;
+static esp_http_win_stats_t s_win_stats;
+
+/* 回包到了 2xx 状态行后等 "seq" 的时长：超过即按先进先出对上（服务器未回显 seq 时） */
+#ifndef ESP_HTTP_SEQ_WAIT_MS
+#define ESP_HTTP_SEQ_WAIT_MS 20u
+#endif
+
+/* 请求出队（回包对上、超时、丢失、链路重置）时调用，与出队在同一临界区/中断里；ok=1 表示 2xx 回包 */
+static void ESP_HttpWin_OnRetire(const esp_http_req_t *r, uint8_t ok, uint32_t now);
+
+/* 出队最早的在途请求；ok=1 记一次 2xx 回包并更新 RTT（须在关中断或 USART2 中断里调用） */
+static void ESP_HttpWin_PopLocked(uint8_t ok, uint32_t now)
+{
+    if (s_win.count == 0u)
+        return;
+    const esp_http_req_t *r = &s_win.q[s_win.head];
+    ESP_HttpWin_OnRetire(r, ok, now);
+    if (ok)
+    {
+        uint32_t rtt = now - r->tick;
+        s_win_stats.acked++;
+        s_win_stats.acked_bytes += r->bytes;
+        s_win_stats.rtt_last = rtt;
+        if (s_win_stats.rtt_min == 0u || rtt < s_win_stats.rtt_min)
+            s_win_stats.rtt_min = rtt;
+        if (rtt > s_win_stats.rtt_max)
+            s_win_stats.rtt_max = rtt;
+        if (s_win_stats.rtt_avg_x8 == 0u)
+            s_win_stats.rtt_avg_x8 = rtt * 8u;
+        else
+            s_win_stats.rtt_avg_x8 = s_win_stats.rtt_avg_x8 - (s_win_stats.rtt_avg_x8 >> 3) + rtt;
+    }
+    s_win.head = (uint8_t)((s_win.head + 1u) % ESP_HTTP_WINDOW_MAX);
+    s_win.count--;
+}
+
+/* 请求最后一字节交给 DMA：入队（窗口由调用方保证不满；满了说明回包丢了，挤掉最早的一个） */
+static void ESP_HttpWin_PushLocked(uint32_t seq, uint32_t bytes, uint32_t now)
+{
+    if (s_win.count >= ESP_HTTP_WINDOW_MAX)
+    {
+        ESP_HttpWin_PopLocked(0, now);
+        s_win_stats.lost++;
+    }
+    esp_http_req_t *r = &s_win.q[(s_win.head + s_win.count) % ESP_HTTP_WINDOW_MAX];
+    r->seq = seq;
+    r->tick = now;
+    r->bytes = bytes;
+    s_win.count++;
+    s_win_stats.sent++;
+    if (s_win.count > s_win_stats.inflight_max)
+        s_win_stats.inflight_max = s_win.count;
+}
+
+/* 收到完整状态行 */
+static void ESP_HttpWin_OnStatus(uint16_t status, uint32_t now)
+{
+    if (s_win.open)
+    {
+        /* 上一个 2xx 回包没带 seq（服务器未回显）：按顺序对上 */
+        ESP_HttpWin_PopLocked(1, now);
+        s_win.open = 0;
+    }
+    if (s_win.count == 0u)
+    {
+        s_win_stats.late++;
+        return;
+    }
+    if (status < 200u || status >= 300u)
+    {
+        ESP_HttpWin_PopLocked(0, now);
+        s_win_stats.errors++;
+        return;
+    }
+    if (s_win.q[s_win.head].seq == 0u)
+    {
+        ESP_HttpWin_PopLocked(1, now);
+        return;
+    }
+    s_win.open = 1;
+    s_win.open_tick = now;
+}
+
+/* 2xx 回包正文里的 "seq":N：对上该请求，排在它前面的记丢失 */
+static void ESP_HttpWin_OnSeq(uint32_t seq, uint32_t now)
+{
+    if (!s_win.open)
+        return;
+    s_win.open = 0;
+    for (uint32_t i = 0; i < s_win.count; i++)
+    {
+        if (s_win.q[(s_win.head + i) % ESP_HTTP_WINDOW_MAX].seq != seq)
+            continue;
+        for (; i > 0u; i--)
+        {
+            ESP_HttpWin_PopLocked(0, now);
+            s_win_stats.lost++;
+        }
+        ESP_HttpWin_PopLocked(1, now);
+        return;
+    }
+    s_win_stats.late++;
+}
+
+/* USART2 接收中断里逐字节找 "HTTP/1.x NNN" 与 "seq":N（同一回包内 seq 在状态行之后） */
+static void ESP_HttpWin_RxFeed(const uint8_t *data, uint16_t len)
+{
+    static const char k_http[] = "HTTP/1.";
+    static const char k_seq[] = "\"seq\":";
+    uint32_t now = HAL_GetTick();
+
+    for (uint16_t i = 0; i < len; i++)
+    {
+        char c = (char)data[i];
+
+        if (s_win.st_state == 1u)
+        {
+            if (c == ' ')
+            {
+                s_win.st_state = 2;
+                s_win.status = 0;
+            }
+        }
+        else if (s_win.st_state == 2u)
+        {
+            if (c >= '0' && c <= '9' && s_win.status < 1000u)
+            {
+                s_win.status = (uint16_t)(s_win.status * 10u + (uint16_t)(c - '0'));
+            }
+            else
+            {
+                s_win.st_state = 0;
+                ESP_HttpWin_OnStatus(s_win.status, now);
+            }
+        }
+        if (s_win.seq_state)
+        {
+            if (c >= '0' && c <= '9')
+            {
+                s_win.seq_val = s_win.seq_val * 10u + (uint32_t)(c - '0');
+                s_win.seq_state = 2;
+                continue;
+            }
+            if (s_win.seq_state == 2u)
+                ESP_HttpWin_OnSeq(s_win.seq_val, now);
+            if (s_win.seq_state == 2u || c != ' ')
+                s_win.seq_state = 0;
+        }
+
+        s_win.m_http = (c == k_http[s_win.m_http]) ? (uint8_t)(s_win.m_http + 1u) : (uint8_t)(c == k_http[0]);
+        if (s_win.m_http == sizeof(k_http) - 1u)
+        {
+            s_win.m_http = 0;
+            s_win.st_state = 1;
+        }
+        s_win.m_seq = (c == k_seq[s_win.m_seq]) ? (uint8_t)(s_win.m_seq + 1u) : (uint8_t)(c == k_seq[0]);
+        if (s_win.m_seq == sizeof(k_seq) - 1u)
+        {
+            s_win.m_seq = 0;
+            s_win.seq_state = 1;
+            s_win.seq_val = 0;
+        }
+    }
+}
+
+/* 接收出错（多为 ORE）：正在收的那个回包多半已经残缺，按丢失出队，解析状态清零 */
+static void ESP_HttpWin_OnRxError(void)
+{
+    if (s_win.count)
+    {
+        ESP_HttpWin_PopLocked(0, HAL_GetTick());
+        s_win_stats.lost++;
+    }
+    s_win.open = 0;
+    s_win.m_http = 0;
+    s_win.m_seq = 0;
+    s_win.st_state = 0;
+    s_win.seq_state = 0;
+}
+
+/* 链路重置（重连 / 强制停 DMA）：在途请求全部作废（在途的补传记失败，之后重发） */
+static void ESP_HttpWin_Reset(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    s_win_stats.lost += s_win.count;
+    while (s_win.count)
+        ESP_HttpWin_PopLocked(0, 0u);
+    memset(&s_win, 0, sizeof(s_win));
+    __set_PRIMASK(primask);
+}
+
+/*
+*********************************************************************************************************
+* 函 数 名: ESP_HttpWin_CanSend
+* 功能说明: 在途请求窗口还有空位时返回 1（顺带处理超时出队与每秒吞吐统计）
+* 形    参: 无
+* 返 回 值: 1=可以开始新请求
+* 说    明: 窗口为 1 时与原来的门控相同：收到回包或超时才发下一个
+*********************************************************************************************************
+*/
+static uint8_t ESP_HttpWin_CanSend(void)
+{
+    uint32_t now = HAL_GetTick();
+    uint32_t to_ms = ESP_CommParams_HttpTimeoutMs();
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (s_win.open && (now - s_win.open_tick) >= ESP_HTTP_SEQ_WAIT_MS)
+    {
+        ESP_HttpWin_PopLocked(1, now);
+        s_win.open = 0;
+    }
+    while (s_win.count && (now - s_win.q[s_win.head].tick) >= to_ms)
+    {
+        ESP_HttpWin_PopLocked(0, now);
+        s_win_stats.timeouts++;
+    }
+    uint8_t free_slot = (s_win.count < ESP_CommParams_HttpWindow()) ? 1u : 0u;
+    __set_PRIMASK(primask);
+
+    if ((now - s_win_stats.rate_tick) >= 1000u)
+    {
+        uint32_t dt = now - s_win_stats.rate_tick;
+        if (dt < 5000u)
+        {
+            s_win_stats.req_per_s = (s_win_stats.acked - s_win_stats.rate_acked0) * 1000u / dt;
+            s_win_stats.bytes_per_s = (uint32_t)((uint64_t)(s_win_stats.acked_bytes - s_win_stats.rate_bytes0) * 1000u / dt);
+        }
+        s_win_stats.rate_tick = now;
+        s_win_stats.rate_acked0 = s_win_stats.acked;
+        s_win_stats.rate_bytes0 = s_win_stats.acked_bytes;
+    }
+    return free_slot;
+}
+
+#endif /* ESP_HTTP_WIN_H */
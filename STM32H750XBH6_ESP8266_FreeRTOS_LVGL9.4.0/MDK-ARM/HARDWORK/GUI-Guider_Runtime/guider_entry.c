@@ -7,6 +7,11 @@
 #include "gui_assets.h"
 #include "src/generated/gui_guider.h"
 #include "esp8266.h"
+#include "ad7606_calib.h"
+#include "ad_trigger.h"
+#include "ad_fault_port.h"
+#include "ad_arc_port.h"
+#include "ad_class_port.h"
 
 lv_ui guider_ui;
 
@@ -85,6 +90,13 @@ void edgewind_ui_on_enter_system(void)
         gui_assets_patch_images(&guider_ui);
         /* 上电读取一次通讯参数（仅加载到 ESP 缓存；若无文件则保持默认值） */
         (void)ESP_CommParams_LoadFromSD();
+        /* 通道标定表、瞬态录波触发配置、本地故障判定规则、电弧检测配置（无文件则沿用编译期默认值） */
+        (void)AD7606_Cal_LoadFromSD();
+        (void)AD_Trig_LoadFromSD();
+        (void)AD_Fault_LoadFromSD();
+        (void)AD_Arc_LoadFromSD();
+        /* 故障分类模型（SD 优先，其次 QSPI；无文件则不推理） */
+        (void)AD_Class_Load();
         guider_initialized = true;
         return;
     }
@@ -18,6 +18,7 @@
 #include "cmsis_os.h"
 #include "main.h"
 #include "../../../ESP8266/esp8266.h"
+#include "ad_acq_buffers.h"
 #include "fatfs.h"
 #include "diskio.h"
 #include "bsp_driver_sd.h"
@@ -1304,12 +1305,14 @@ static FRESULT ui_param_cfg_read_file(char *heartbeat_ms, size_t heartbeat_len,
                                       char *hardreset_s, size_t hardreset_len,
                                       char *downsample_step, size_t downsample_len,
                                       char *chunk_kb, size_t chunk_kb_len,
-                                      char *chunk_delay, size_t chunk_delay_len)
+                                      char *chunk_delay, size_t chunk_delay_len,
+                                      char *acq_profile, size_t acq_profile_len)
 {
-    if (!heartbeat_ms || !sendlimit_ms || !http_timeout_ms || !hardreset_s || !downsample_step || !chunk_kb || !chunk_delay)
+    if (!heartbeat_ms || !sendlimit_ms || !http_timeout_ms || !hardreset_s || !downsample_step || !chunk_kb || !chunk_delay ||
+        !acq_profile)
         return FR_INVALID_OBJECT;
     heartbeat_ms[0] = sendlimit_ms[0] = http_timeout_ms[0] = hardreset_s[0] = downsample_step[0] = '\0';
-    chunk_kb[0] = chunk_delay[0] = '\0';
+    chunk_kb[0] = chunk_delay[0] = acq_profile[0] = '\0';
 
     FRESULT res = ui_sd_mount_with_mkfs();
     if (res != FR_OK) {
@@ -1357,19 +1360,23 @@ static FRESULT ui_param_cfg_read_file(char *heartbeat_ms, size_t heartbeat_len,
         } else if (strncmp(line, "CHUNK_DELAY_MS=", 15) == 0) {
             strncpy(chunk_delay, line + 15, chunk_delay_len - 1);
             chunk_delay[chunk_delay_len - 1] = '\0';
+        } else if (strncmp(line, "ACQ_PROFILE=", 12) == 0) {
+            strncpy(acq_profile, line + 12, acq_profile_len - 1);
+            acq_profile[acq_profile_len - 1] = '\0';
         }
     }
     (void)f_close(&fil);
 
-    printf("[PARAM_UI_CFG] loaded: hb=%s send=%s http=%s reset=%s ds=%s chunk=%s delay=%s\r\n",
-           heartbeat_ms, sendlimit_ms, http_timeout_ms, hardreset_s, downsample_step, chunk_kb, chunk_delay);
+    printf("[PARAM_UI_CFG] loaded: hb=%s send=%s http=%s reset=%s ds=%s chunk=%s delay=%s acq=%s\r\n",
+           heartbeat_ms, sendlimit_ms, http_timeout_ms, hardreset_s, downsample_step, chunk_kb, chunk_delay, acq_profile);
     return FR_OK;
 }
 
 static FRESULT ui_param_cfg_write_file(const char *heartbeat_ms, const char *sendlimit_ms,
                                        const char *http_timeout_ms, const char *hardreset_s,
                                        const char *downsample_step,
-                                       const char *chunk_kb, const char *chunk_delay)
+                                       const char *chunk_kb, const char *chunk_delay,
+                                       uint32_t acq_profile)
 {
     printf("[PARAM_UI_CFG] write_file: start\r\n");
     FRESULT res = ui_sd_mount_with_mkfs();
@@ -1421,16 +1428,21 @@ static FRESULT ui_param_cfg_write_file(const char *heartbeat_ms, const char *sen
     (void)ui_param_cfg_parse_u32(chunk_kb, &ckb_u);
     (void)ui_param_cfg_parse_u32(chunk_delay, &cdly_u);
     if (ds_u < 1u) ds_u = 1u;
-    /* 允许 ckb=0 表示关闭分段 */
+    /* 允许 ckb=0 表示关闭分段；FRAME_FMT / HTTP_CHUNKED / HTTP_WINDOW 界面上没有输入框，沿用当前值
+     * （控制台 bin / tx、局域网/公网预设或手工编辑文件） */
     int n = snprintf(buf, sizeof(buf),
-                     "HEARTBEAT_MS=%lu\nSENDLIMIT_MS=%lu\nHTTP_TIMEOUT_MS=%lu\nHARDRESET_S=%lu\nDOWNSAMPLE_STEP=%lu\nCHUNK_KB=%lu\nCHUNK_DELAY_MS=%lu\n",
+                     "HEARTBEAT_MS=%lu\nSENDLIMIT_MS=%lu\nHTTP_TIMEOUT_MS=%lu\nHARDRESET_S=%lu\nDOWNSAMPLE_STEP=%lu\nCHUNK_KB=%lu\nCHUNK_DELAY_MS=%lu\nACQ_PROFILE=%lu\nFRAME_FMT=%lu\nHTTP_CHUNKED=%lu\nHTTP_WINDOW=%lu\n",
                      (unsigned long)hb_u,
                      (unsigned long)send_u,
                      (unsigned long)http_u,
                      (unsigned long)rst_u,
                      (unsigned long)ds_u,
                      (unsigned long)ckb_u,
-                     (unsigned long)cdly_u);
+                     (unsigned long)cdly_u,
+                     (unsigned long)acq_profile,
+                     (unsigned long)ESP_CommParams_FrameFmt(),
+                     (unsigned long)ESP_CommParams_HttpChunked(),
+                     (unsigned long)ESP_CommParams_HttpWindow());
     UINT bw = 0;
     res = f_write(&fil, buf, (UINT)n, &bw);
     printf("[PARAM_UI_CFG] write_file: f_write res=%d bw=%u\r\n", (int)res, (unsigned)bw);
@@ -1488,8 +1500,9 @@ static void ui_param_cfg_do_load_sync(lv_ui *ui)
 {
     if (!ui) return;
     char hb[24] = {0}, send[24] = {0}, http[24] = {0}, reset[24] = {0}, ds[24] = {0}, ckb[24] = {0}, cdly[24] = {0};
+    char acq[8] = {0};
     FRESULT res = ui_param_cfg_read_file(hb, sizeof(hb), send, sizeof(send), http, sizeof(http), reset, sizeof(reset),
-                                         ds, sizeof(ds), ckb, sizeof(ckb), cdly, sizeof(cdly));
+                                         ds, sizeof(ds), ckb, sizeof(ckb), cdly, sizeof(cdly), acq, sizeof(acq));
     if (res == FR_OK) {
         /* 读取时就“净化”一次：把 =60 / ==60 之类的值纠正为纯数字回写到输入框 */
         uint32_t hb_u = 0, send_u = 0, http_u = 0, rst_u = 0, ds_u = 1, ckb_u = 4, cdly_u = 10;
@@ -1540,6 +1553,16 @@ static void ui_param_cfg_do_load_sync(lv_ui *ui)
         if (ok_ckb)  p.chunk_kb        = ckb_u;
         if (ok_cdly) p.chunk_delay_ms  = cdly_u;
         ESP_CommParams_Apply(&p);
+
+        /* 采样档位：文件里没有该项时保持当前档位 */
+        uint32_t acq_u = 0;
+        if (ui_param_cfg_parse_u32(acq, &acq_u) && acq_u < AD_ACQ_PROFILE_COUNT) {
+            if (acq_u != AD_Acq_ActiveProfile()) {
+                (void)AD_Acq_RequestProfile(acq_u);
+            }
+            if (ui->ParamConfig_dd_acq && lv_obj_is_valid(ui->ParamConfig_dd_acq))
+                lv_dropdown_set_selected(ui->ParamConfig_dd_acq, acq_u);
+        }
     }
     ui_sd_result_to_status(ui, res, ui_param_cfg_set_status, "加载完成");
     (void)ui_param_cfg_validate_and_warn(ui, false);
@@ -1561,9 +1584,10 @@ static void ui_param_cfg_do_save_sync(lv_ui *ui)
     const char *ds    = (ui->ParamConfig_ta_downsample) ? lv_textarea_get_text(ui->ParamConfig_ta_downsample) : "";
     const char *ckb   = (ui->ParamConfig_ta_chunkkb) ? lv_textarea_get_text(ui->ParamConfig_ta_chunkkb) : "";
     const char *cdly  = (ui->ParamConfig_ta_chunkdelay) ? lv_textarea_get_text(ui->ParamConfig_ta_chunkdelay) : "";
+    uint32_t acq      = (ui->ParamConfig_dd_acq) ? lv_dropdown_get_selected(ui->ParamConfig_dd_acq) : AD_Acq_ActiveProfile();
 
     /* 注意：这里仅做 UI->SD 的保存/回读验证，不写入任何实际运行参数。 */
-    FRESULT res = ui_param_cfg_write_file(hb, send, http, reset, ds, ckb, cdly);
+    FRESULT res = ui_param_cfg_write_file(hb, send, http, reset, ds, ckb, cdly, acq);
 
     if (res == FR_OK) {
         /* 保存后立即回读一次，验证保存成功并回显 */
@@ -1589,6 +1613,26 @@ static void ParamConfig_load_timer_cb(lv_timer_t *t)
     ui_param_cfg_do_load_sync(ui);
 }
 
+/* 采样档位下拉框：选中即切换（下一个采样块生效），保存后写入 ACQ_PROFILE 开机沿用 */
+static void ParamConfig_acq_event_handler(lv_event_t *e)
+{
+    if (lv_event_get_code(e) != LV_EVENT_VALUE_CHANGED) {
+        return;
+    }
+    lv_ui *ui = (lv_ui *)lv_event_get_user_data(e);
+    if (!ui || !ui->ParamConfig_dd_acq) return;
+    uint32_t idx = lv_dropdown_get_selected(ui->ParamConfig_dd_acq);
+    const AD_AcqProfile_t *prof = AD_Acq_GetProfile(idx);
+    char msg[96];
+    if (prof && AD_Acq_RequestProfile(idx)) {
+        (void)snprintf(msg, sizeof(msg), "采样档位已切换为 %s（保存后开机沿用）", prof->name);
+        ui_param_cfg_set_status(ui, msg, 0x3dfb00);
+    } else {
+        lv_dropdown_set_selected(ui->ParamConfig_dd_acq, AD_Acq_ActiveProfile());
+        ui_param_cfg_set_status(ui, "采样档位切换失败：转换+读出时间超过采样周期", 0xFF4444);
+    }
+}
+
 static void ParamConfig_screen_event_handler(lv_event_t *e)
 {
     if (lv_event_get_code(e) != LV_EVENT_SCREEN_LOADED) {
@@ -1635,7 +1679,7 @@ static void ParamConfig_kb_event_handler(lv_event_t *e)
 static void ParamConfig_apply_preset(lv_ui *ui,
                                      const char *hb, const char *send, const char *http,
                                      const char *reset, const char *chunkkb, const char *chunkdelay,
-                                     const char *downsample,
+                                     const char *downsample, uint32_t http_window,
                                      const char *status_text)
 {
     if (!ui) return;
@@ -1659,6 +1703,12 @@ static void ParamConfig_apply_preset(lv_ui *ui,
     if (ui->ParamConfig_ta_downsample && lv_obj_is_valid(ui->ParamConfig_ta_downsample))
         lv_textarea_set_text(ui->ParamConfig_ta_downsample, downsample ? downsample : "");
 
+    /* 在途请求窗口没有输入框：直接改运行值，保存时随之写入 HTTP_WINDOW */
+    ESP_CommParams_t cp;
+    ESP_CommParams_Get(&cp);
+    cp.http_window = http_window;
+    ESP_CommParams_Apply(&cp);
+
     ui_param_cfg_set_status(ui, status_text ? status_text : "正在保存...", 0xFFA500);
     lv_obj_update_layout(ui->ParamConfig);
     lv_refr_now(NULL);
@@ -1670,7 +1720,7 @@ static void ParamConfig_preset_lan_event_handler(lv_event_t *e)
     lv_ui *ui = (lv_ui *)lv_event_get_user_data(e);
     ParamConfig_apply_preset(ui,
                              "5000", "200", "1200", "60",
-                             "0", "0", "1",
+                             "0", "0", "1", 2u,
                              "已应用局域网参数，正在保存...");
 }
 
@@ -1679,7 +1729,7 @@ static void ParamConfig_preset_wan_event_handler(lv_event_t *e)
     lv_ui *ui = (lv_ui *)lv_event_get_user_data(e);
     ParamConfig_apply_preset(ui,
                              "120000", "1000", "8000", "60",
-                             "1", "160", "1",
+                             "1", "160", "1", 4u,
                              "已应用公网参数，正在保存...");
 }
 
@@ -1820,6 +1870,19 @@ void events_init_ParamConfig(lv_ui *ui)
     if (ui->ParamConfig_btn_wan) {
         lv_obj_add_event_cb(ui->ParamConfig_btn_wan, ParamConfig_preset_wan_event_handler, LV_EVENT_CLICKED, ui);
     }
+    if (ui->ParamConfig_dd_acq) {
+        char opts[AD_ACQ_PROFILE_COUNT * 24];
+        size_t n = 0;
+        opts[0] = '\0';
+        for (uint32_t i = 0; i < AD_ACQ_PROFILE_COUNT; i++) {
+            int w = snprintf(opts + n, sizeof(opts) - n, (i == 0u) ? "%s" : "\n%s", AD_Acq_GetProfile(i)->name);
+            if (w < 0 || (size_t)w >= sizeof(opts) - n) break;
+            n += (size_t)w;
+        }
+        lv_dropdown_set_options(ui->ParamConfig_dd_acq, opts);
+        lv_dropdown_set_selected(ui->ParamConfig_dd_acq, AD_Acq_ActiveProfile());
+        lv_obj_add_event_cb(ui->ParamConfig_dd_acq, ParamConfig_acq_event_handler, LV_EVENT_VALUE_CHANGED, ui);
+    }
 
     /* 每次切换进入屏幕都自动加载（仅 UI 读写验证，不影响实际参数） */
     lv_obj_add_event_cb(ui->ParamConfig, ParamConfig_screen_event_handler, LV_EVENT_SCREEN_LOADED, ui);
@@ -136,6 +136,8 @@ typedef struct
 	lv_obj_t *ParamConfig_ta_chunkkb;
 	lv_obj_t *ParamConfig_lbl_chunkdelay;
 	lv_obj_t *ParamConfig_ta_chunkdelay;
+	// Extra: Acquisition profile
+	lv_obj_t *ParamConfig_dd_acq;
 	// Quick action: disable chunking
 	lv_obj_t *ParamConfig_btn_nochunk;
 	lv_obj_t *ParamConfig_lbl_nochunk;
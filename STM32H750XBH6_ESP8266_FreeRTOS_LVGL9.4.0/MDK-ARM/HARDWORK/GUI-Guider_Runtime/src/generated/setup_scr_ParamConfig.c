@@ -215,6 +215,17 @@ void setup_scr_ParamConfig(lv_ui *ui)
     lv_obj_set_style_text_font(ui->ParamConfig_lbl_nochunk, gui_assets_get_font_16(), LV_PART_MAIN|LV_STATE_DEFAULT);
     lv_obj_center(ui->ParamConfig_lbl_nochunk);
 
+    // Acquisition profile (sample rate + AD7606 oversampling), right of the no-chunk button
+    ui->ParamConfig_dd_acq = lv_dropdown_create(ui->ParamConfig_cont_panel);
+    lv_obj_align_to(ui->ParamConfig_dd_acq, ui->ParamConfig_btn_nochunk, LV_ALIGN_OUT_RIGHT_MID, 10, 0);
+    lv_obj_set_size(ui->ParamConfig_dd_acq, 160, 24);
+    lv_obj_set_style_pad_ver(ui->ParamConfig_dd_acq, 4, LV_PART_MAIN|LV_STATE_DEFAULT);
+    lv_obj_set_style_text_font(ui->ParamConfig_dd_acq, gui_assets_get_font_12(), LV_PART_MAIN|LV_STATE_DEFAULT);
+    lv_obj_set_style_text_font(lv_dropdown_get_list(ui->ParamConfig_dd_acq), gui_assets_get_font_16(), LV_PART_MAIN|LV_STATE_DEFAULT);
+    lv_obj_set_style_border_width(ui->ParamConfig_dd_acq, 2, LV_PART_MAIN|LV_STATE_DEFAULT);
+    lv_obj_set_style_border_color(ui->ParamConfig_dd_acq, lv_color_hex(0xCCCCCC), LV_PART_MAIN|LV_STATE_DEFAULT);
+    /* 选项由 events_init_ParamConfig() 按采样档位表填充 */
+
     // --- Row 4 (Right): Downsample ---
     ui->ParamConfig_lbl_downsample = lv_label_create(ui->ParamConfig_cont_panel);
     lv_obj_align_to(ui->ParamConfig_lbl_downsample, ui->ParamConfig_btn_nochunk, LV_ALIGN_OUT_BOTTOM_LEFT, 0, 4);
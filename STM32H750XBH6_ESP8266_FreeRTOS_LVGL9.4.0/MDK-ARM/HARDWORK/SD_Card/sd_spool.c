@@ -0,0 +1,681 @@
+#include "sd_spool.h"
+
+#include "SD.h"
+#include "sd_time.h"
+#include "ad_frame.h"
+
+#include "ff.h"
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#define SD_SPOOL_SEG_HDR_LEN ((uint32_t)sizeof(SD_SpoolSegHeader_t))
+#define SD_SPOOL_REC_HDR_LEN ((uint32_t)sizeof(SD_SpoolRecHeader_t))
+
+/* 一级优先级的段串：段号 first..last 连续（中间缺号的跳过），只追加 last，只读 first */
+typedef struct {
+	uint32_t nsegs;
+	uint32_t first;
+	uint32_t last;
+	uint32_t next_id;
+	uint32_t last_size;    /* 最新段的有效长度 = 追加位置 */
+	uint32_t pending;
+	uint32_t pending_bytes;
+	SD_SpoolCursor_t rd;   /* 最早段的读游标（盘上较新那份的内存副本） */
+} sd_spool_q_t;
+
+static sd_spool_q_t s_q[SD_SPOOL_PRIO_NUM];
+static SD_SpoolStats_t s_st;
+static uint32_t s_quota = SD_SPOOL_QUOTA_MB * 1024u * 1024u;
+
+/* 追加中的记录（Begin..End 之间文件保持打开） */
+static struct {
+	FIL fil;
+	uint8_t open;
+	uint8_t prio;
+	uint32_t off;
+	SD_SpoolRecHeader_t h;
+} s_wr;
+
+/* Peek 选中的记录 */
+static struct {
+	uint8_t valid;
+	uint8_t prio;
+	uint32_t seg;
+	uint32_t off;  /* 记录头偏移 */
+	uint32_t len;
+	uint32_t pos;  /* 已读负载字节 */
+} s_rd;
+
+static uint8_t s_buf[512];
+
+static inline uint32_t sd_spool_crc(const void *p, uint32_t n)
+{
+	return AD_Frame_Crc32(0u, p, n);
+}
+
+static void sd_spool_path(char *buf, size_t len, uint8_t prio, uint32_t id)
+{
+	(void)snprintf(buf, len, "%s/%c%08lu.spl", SD_SPOOL_DIR,
+	               (prio == SD_SPOOL_PRIO_EVENT) ? 'e' : 'n', (unsigned long)id);
+}
+
+/* "e00000012.spl" -> prio / 段号 */
+static bool sd_spool_parse_name(const char *name, uint8_t *prio, uint32_t *id)
+{
+	if (!name || (name[0] != 'e' && name[0] != 'n')) {
+		return false;
+	}
+	uint32_t v = 0;
+	for (int i = 1; i <= 8; ++i) {
+		if (name[i] < '0' || name[i] > '9') {
+			return false;
+		}
+		v = v * 10u + (uint32_t)(name[i] - '0');
+	}
+	if (strcmp(name + 9, ".spl") != 0 || v == 0u) {
+		return false;
+	}
+	*prio = (name[0] == 'e') ? SD_SPOOL_PRIO_EVENT : SD_SPOOL_PRIO_NORMAL;
+	*id = v;
+	return true;
+}
+
+static void sd_spool_cursor_seal(SD_SpoolCursor_t *c)
+{
+	c->crc = sd_spool_crc(c, (uint32_t)offsetof(SD_SpoolCursor_t, crc));
+}
+
+static bool sd_spool_cursor_ok(const SD_SpoolCursor_t *c)
+{
+	return c->gen != 0u && c->off >= SD_SPOOL_SEG_HDR_LEN &&
+	       c->crc == sd_spool_crc(c, (uint32_t)offsetof(SD_SpoolCursor_t, crc));
+}
+
+static bool sd_spool_read_at(FIL *fil, uint32_t off, void *buf, uint32_t n)
+{
+	UINT br = 0;
+	if (f_lseek(fil, off) != FR_OK) {
+		return false;
+	}
+	return (f_read(fil, buf, n, &br) == FR_OK && br == n);
+}
+
+static bool sd_spool_write_at(FIL *fil, uint32_t off, const void *buf, uint32_t n)
+{
+	UINT bw = 0;
+	if (f_lseek(fil, off) != FR_OK) {
+		return false;
+	}
+	return (f_write(fil, buf, n, &bw) == FR_OK && bw == n);
+}
+
+/* 读段头并取有效的读游标（两份都坏时从第一条记录读起） */
+static bool sd_spool_load_hdr(FIL *fil, uint8_t prio, uint32_t id, SD_SpoolCursor_t *cur)
+{
+	SD_SpoolSegHeader_t h;
+	if (!sd_spool_read_at(fil, 0u, &h, SD_SPOOL_SEG_HDR_LEN)) {
+		return false;
+	}
+	if (h.magic != SD_SPOOL_SEG_MAGIC || h.version != SD_SPOOL_VERSION || h.prio != prio ||
+	    h.hdr_len != SD_SPOOL_SEG_HDR_LEN || h.seg_id != id ||
+	    h.crc != sd_spool_crc(&h, (uint32_t)offsetof(SD_SpoolSegHeader_t, crc))) {
+		return false;
+	}
+	bool ok0 = sd_spool_cursor_ok(&h.cur[0]);
+	bool ok1 = sd_spool_cursor_ok(&h.cur[1]);
+	if (ok0 && (!ok1 || (int32_t)(h.cur[0].gen - h.cur[1].gen) > 0)) {
+		*cur = h.cur[0];
+	} else if (ok1) {
+		*cur = h.cur[1];
+	} else {
+		memset(cur, 0, sizeof(*cur));
+		cur->off = SD_SPOOL_SEG_HDR_LEN;
+	}
+	return true;
+}
+
+static bool sd_spool_rec_ok(const SD_SpoolRecHeader_t *r, uint32_t off, uint32_t end)
+{
+	return r->magic == SD_SPOOL_REC_MAGIC &&
+	       r->hcrc == sd_spool_crc(r, (uint32_t)offsetof(SD_SpoolRecHeader_t, hcrc)) &&
+	       r->len <= end && off + SD_SPOOL_REC_HDR_LEN <= end - r->len;
+}
+
+/* 从 off 起逐条核对记录头，返回有效部分的结尾；顺带数出记录数/字节数/最大序号 */
+static uint32_t sd_spool_walk(FIL *fil, uint32_t off, uint32_t end, uint32_t *recs, uint32_t *bytes,
+                              uint32_t *max_seq)
+{
+	SD_SpoolRecHeader_t r;
+	while (off + SD_SPOOL_REC_HDR_LEN <= end) {
+		if (!sd_spool_read_at(fil, off, &r, SD_SPOOL_REC_HDR_LEN) || !sd_spool_rec_ok(&r, off, end)) {
+			break;
+		}
+		off += SD_SPOOL_REC_HDR_LEN + r.len;
+		(*recs)++;
+		*bytes += SD_SPOOL_REC_HDR_LEN + r.len;
+		if (max_seq && (int32_t)(r.seq - *max_seq) > 0) {
+			*max_seq = r.seq;
+		}
+	}
+	return off;
+}
+
+static bool sd_spool_seg_exists(uint8_t prio, uint32_t id)
+{
+	char path[40];
+	sd_spool_path(path, sizeof(path), prio, id);
+	return SD_FileExists(path);
+}
+
+static void sd_spool_unlink(uint8_t prio, uint32_t id)
+{
+	char path[40];
+	sd_spool_path(path, sizeof(path), prio, id);
+	if (f_unlink(path) != FR_OK) {
+		s_st.errors++;
+	}
+}
+
+/* 删掉最早段（已读完 / 被配额挤掉 / 段头损坏），读端移到下一个现存段 */
+static void sd_spool_drop_head(uint8_t prio, uint32_t seg_bytes)
+{
+	sd_spool_q_t *q = &s_q[prio];
+	if (s_rd.valid && s_rd.prio == prio && s_rd.seg == q->first) {
+		s_rd.valid = 0;
+	}
+	sd_spool_unlink(prio, q->first);
+	s_st.disk_bytes = (s_st.disk_bytes > seg_bytes) ? s_st.disk_bytes - seg_bytes : 0u;
+	q->nsegs--;
+	memset(&q->rd, 0, sizeof(q->rd));
+	q->rd.off = SD_SPOOL_SEG_HDR_LEN;
+	if (q->nsegs == 0u) {
+		q->first = 0;
+		q->last = 0;
+		q->last_size = 0;
+		q->pending = 0;
+		q->pending_bytes = 0;
+		return;
+	}
+	for (;;) {
+		q->first++;
+		if (q->first == q->last) {
+			break;
+		}
+		if (sd_spool_seg_exists(prio, q->first)) {
+			break;
+		}
+	}
+	char path[40];
+	FIL fil;
+	sd_spool_path(path, sizeof(path), prio, q->first);
+	if (f_open(&fil, path, FA_READ) == FR_OK) {
+		if (!sd_spool_load_hdr(&fil, prio, q->first, &q->rd)) {
+			q->rd.off = SD_SPOOL_SEG_HDR_LEN;
+		}
+		(void)f_close(&fil);
+	}
+}
+
+/* 上电扫描一个段：坏段头删掉，残缺尾部截掉；返回 false 表示该段已删 */
+static bool sd_spool_load_seg(uint8_t prio, uint32_t id, SD_SpoolCursor_t *cur, uint32_t *end_out)
+{
+	char path[40];
+	FIL fil;
+	sd_spool_path(path, sizeof(path), prio, id);
+	if (f_open(&fil, path, FA_READ | FA_WRITE) != FR_OK) {
+		s_st.errors++;
+		return false;
+	}
+	if (!sd_spool_load_hdr(&fil, prio, id, cur)) {
+		(void)f_close(&fil);
+		(void)f_unlink(path);
+		s_st.repaired++;
+		return false;
+	}
+	uint32_t size = (uint32_t)f_size(&fil);
+	uint32_t recs = 0, bytes = 0;
+	uint32_t end = size;
+	if (cur->off <= size) {
+		end = sd_spool_walk(&fil, cur->off, size, &recs, &bytes, &s_st.max_seq);
+	} else {
+		cur->off = size;
+	}
+	if (end < size) {
+		if (f_lseek(&fil, end) != FR_OK || f_truncate(&fil) != FR_OK) {
+			s_st.errors++;
+		}
+		s_st.repaired++;
+	}
+	(void)f_close(&fil);
+	s_q[prio].pending += recs;
+	s_q[prio].pending_bytes += bytes;
+	*end_out = end;
+	return true;
+}
+
+bool SD_Spool_Init(void)
+{
+	if (s_wr.open) {
+		(void)f_close(&s_wr.fil);
+		s_wr.open = 0;
+	}
+	s_rd.valid = 0;
+	memset(s_q, 0, sizeof(s_q));
+	memset(&s_st, 0, sizeof(s_st));
+
+	if (SD_Init() != FR_OK) {
+		return false;
+	}
+	if (SD_MkdirRecursive(SD_SPOOL_DIR) != FR_OK) {
+		return false;
+	}
+
+	uint32_t lo[SD_SPOOL_PRIO_NUM] = {0}, hi[SD_SPOOL_PRIO_NUM] = {0};
+	DIR dj;
+	FILINFO fno;
+	if (f_opendir(&dj, SD_SPOOL_DIR) != FR_OK) {
+		return false;
+	}
+	for (;;) {
+		if (f_readdir(&dj, &fno) != FR_OK || fno.fname[0] == '\0') {
+			break;
+		}
+		uint8_t prio;
+		uint32_t id;
+		if ((fno.fattrib & AM_DIR) || !sd_spool_parse_name(fno.fname, &prio, &id)) {
+			continue;
+		}
+		if (lo[prio] == 0u || id < lo[prio]) {
+			lo[prio] = id;
+		}
+		if (id > hi[prio]) {
+			hi[prio] = id;
+		}
+	}
+	(void)f_closedir(&dj);
+
+	for (uint8_t prio = 0; prio < SD_SPOOL_PRIO_NUM; ++prio) {
+		sd_spool_q_t *q = &s_q[prio];
+		q->next_id = hi[prio] + 1u;
+		q->rd.off = SD_SPOOL_SEG_HDR_LEN;
+		for (uint32_t id = lo[prio]; lo[prio] != 0u && id <= hi[prio]; ++id) {
+			SD_SpoolCursor_t cur;
+			uint32_t end = 0;
+			uint32_t before = q->pending;
+			if (!sd_spool_seg_exists(prio, id) || !sd_spool_load_seg(prio, id, &cur, &end)) {
+				continue;
+			}
+			/* 掉电前已读完、还没来得及删的段 */
+			if (q->pending == before && id != hi[prio]) {
+				sd_spool_unlink(prio, id);
+				continue;
+			}
+			if (q->nsegs == 0u) {
+				q->first = id;
+				q->rd = cur;
+			}
+			q->last = id;
+			q->last_size = end;
+			q->nsegs++;
+			s_st.disk_bytes += end;
+		}
+	}
+	s_st.quota_bytes = s_quota;
+	s_st.ready = 1;
+	return true;
+}
+
+bool SD_Spool_IsReady(void)
+{
+	return s_st.ready != 0u;
+}
+
+void SD_Spool_SetQuotaMb(uint32_t quota_mb)
+{
+	if (quota_mb < 1u) {
+		quota_mb = 1u;
+	}
+	if (quota_mb > 2048u) {
+		quota_mb = 2048u;
+	}
+	s_quota = quota_mb * 1024u * 1024u;
+	s_st.quota_bytes = s_quota;
+}
+
+/* 配额：先挤最早的普通段，没有普通段才挤事件段 */
+static bool sd_spool_make_room(void)
+{
+	while (s_st.disk_bytes + SD_SPOOL_REC_RESERVE > s_quota) {
+		uint8_t prio = (s_q[SD_SPOOL_PRIO_NORMAL].nsegs != 0u) ? SD_SPOOL_PRIO_NORMAL : SD_SPOOL_PRIO_EVENT;
+		sd_spool_q_t *q = &s_q[prio];
+		if (q->nsegs == 0u) {
+			return false;
+		}
+		char path[40];
+		FIL fil;
+		uint32_t size = 0, recs = 0, bytes = 0;
+		sd_spool_path(path, sizeof(path), prio, q->first);
+		if (f_open(&fil, path, FA_READ) == FR_OK) {
+			size = (uint32_t)f_size(&fil);
+			uint32_t end = (q->first == q->last) ? q->last_size : size;
+			(void)sd_spool_walk(&fil, q->rd.off, end, &recs, &bytes, NULL);
+			(void)f_close(&fil);
+		}
+		q->pending = (q->pending > recs) ? q->pending - recs : 0u;
+		q->pending_bytes = (q->pending_bytes > bytes) ? q->pending_bytes - bytes : 0u;
+		s_st.dropped += recs;
+		s_st.dropped_segs++;
+		sd_spool_drop_head(prio, (q->first == q->last) ? q->last_size : size);
+	}
+	return true;
+}
+
+/* 新段：段头（含初始读游标）写完即 f_sync，之后才会有记录 */
+static bool sd_spool_new_seg(uint8_t prio, FIL *fil)
+{
+	sd_spool_q_t *q = &s_q[prio];
+	uint32_t id = q->next_id;
+	char path[40];
+	sd_spool_path(path, sizeof(path), prio, id);
+	if (f_open(fil, path, FA_CREATE_ALWAYS | FA_READ | FA_WRITE) != FR_OK) {
+		return false;
+	}
+	SD_SpoolSegHeader_t h;
+	memset(&h, 0, sizeof(h));
+	h.magic = SD_SPOOL_SEG_MAGIC;
+	h.version = SD_SPOOL_VERSION;
+	h.prio = prio;
+	h.hdr_len = (uint8_t)SD_SPOOL_SEG_HDR_LEN;
+	h.seg_id = id;
+	h.created = SD_Time_GetUnix();
+	h.crc = sd_spool_crc(&h, (uint32_t)offsetof(SD_SpoolSegHeader_t, crc));
+	h.cur[0].gen = 1u;
+	h.cur[0].off = SD_SPOOL_SEG_HDR_LEN;
+	sd_spool_cursor_seal(&h.cur[0]);
+	if (!sd_spool_write_at(fil, 0u, &h, SD_SPOOL_SEG_HDR_LEN) || f_sync(fil) != FR_OK) {
+		(void)f_close(fil);
+		(void)f_unlink(path);
+		return false;
+	}
+	q->next_id++;
+	if (q->nsegs == 0u) {
+		q->first = id;
+		q->rd = h.cur[0];
+	}
+	q->last = id;
+	q->last_size = SD_SPOOL_SEG_HDR_LEN;
+	q->nsegs++;
+	s_st.disk_bytes += SD_SPOOL_SEG_HDR_LEN;
+	return true;
+}
+
+bool SD_Spool_AppendBegin(uint8_t prio, uint32_t seq, uint32_t tick)
+{
+	if (!s_st.ready || s_wr.open || prio >= SD_SPOOL_PRIO_NUM) {
+		return false;
+	}
+	if (!sd_spool_make_room()) {
+		return false;
+	}
+	sd_spool_q_t *q = &s_q[prio];
+	if (q->nsegs == 0u || q->last_size >= SD_SPOOL_SEG_KB * 1024u) {
+		if (!sd_spool_new_seg(prio, &s_wr.fil)) {
+			s_st.errors++;
+			return false;
+		}
+	} else {
+		char path[40];
+		sd_spool_path(path, sizeof(path), prio, q->last);
+		if (f_open(&s_wr.fil, path, FA_READ | FA_WRITE) != FR_OK) {
+			s_st.errors++;
+			return false;
+		}
+		/* 上次 Abort 留下的残缺尾部 */
+		if ((uint32_t)f_size(&s_wr.fil) > q->last_size &&
+		    (f_lseek(&s_wr.fil, q->last_size) != FR_OK || f_truncate(&s_wr.fil) != FR_OK)) {
+			(void)f_close(&s_wr.fil);
+			s_st.errors++;
+			return false;
+		}
+	}
+
+	memset(&s_wr.h, 0, sizeof(s_wr.h));
+	if (!sd_spool_write_at(&s_wr.fil, q->last_size, &s_wr.h, SD_SPOOL_REC_HDR_LEN)) {
+		(void)f_close(&s_wr.fil);
+		s_st.errors++;
+		return false;
+	}
+	s_wr.h.magic = SD_SPOOL_REC_MAGIC;
+	s_wr.h.seq = seq;
+	s_wr.h.tick = tick;
+	s_wr.h.rtc_sec = SD_Time_GetUnix();
+	s_wr.prio = prio;
+	s_wr.off = q->last_size;
+	s_wr.open = 1;
+	return true;
+}
+
+bool SD_Spool_AppendData(const void *data, uint32_t n)
+{
+	if (!s_wr.open) {
+		return false;
+	}
+	UINT bw = 0;
+	if (f_write(&s_wr.fil, data, n, &bw) != FR_OK || bw != n) {
+		s_st.errors++;
+		return false;
+	}
+	s_wr.h.crc = AD_Frame_Crc32(s_wr.h.crc, data, n);
+	s_wr.h.len += n;
+	return true;
+}
+
+bool SD_Spool_AppendEnd(void)
+{
+	if (!s_wr.open) {
+		return false;
+	}
+	/* 负载先落盘，记录头后写：头有效即负载完整 */
+	s_wr.h.hcrc = sd_spool_crc(&s_wr.h, (uint32_t)offsetof(SD_SpoolRecHeader_t, hcrc));
+	bool ok = (f_sync(&s_wr.fil) == FR_OK) &&
+	          sd_spool_write_at(&s_wr.fil, s_wr.off, &s_wr.h, SD_SPOOL_REC_HDR_LEN) &&
+	          (f_sync(&s_wr.fil) == FR_OK);
+	(void)f_close(&s_wr.fil);
+	s_wr.open = 0;
+	if (!ok) {
+		s_st.errors++;
+		return false;
+	}
+	sd_spool_q_t *q = &s_q[s_wr.prio];
+	uint32_t n = SD_SPOOL_REC_HDR_LEN + s_wr.h.len;
+	q->last_size += n;
+	q->pending++;
+	q->pending_bytes += n;
+	s_st.disk_bytes += n;
+	s_st.written++;
+	if ((int32_t)(s_wr.h.seq - s_st.max_seq) > 0) {
+		s_st.max_seq = s_wr.h.seq;
+	}
+	return true;
+}
+
+void SD_Spool_AppendAbort(void)
+{
+	if (!s_wr.open) {
+		return;
+	}
+	(void)f_close(&s_wr.fil);
+	s_wr.open = 0;
+}
+
+/* 负载 CRC 核对（补传前读一遍，坏记录不发） */
+static bool sd_spool_check_payload(FIL *fil, uint32_t off, const SD_SpoolRecHeader_t *r)
+{
+	uint32_t crc = 0;
+	UINT br = 0;
+	if (f_lseek(fil, off) != FR_OK) {
+		return false;
+	}
+	for (uint32_t left = r->len; left > 0u;) {
+		uint32_t n = (left < sizeof(s_buf)) ? left : (uint32_t)sizeof(s_buf);
+		if (f_read(fil, s_buf, n, &br) != FR_OK || br != n) {
+			return false;
+		}
+		crc = AD_Frame_Crc32(crc, s_buf, n);
+		left -= n;
+	}
+	return crc == r->crc;
+}
+
+/* 读游标写进段头（gen 奇偶交替写两份中的一份） */
+static void sd_spool_store_cursor(uint8_t prio)
+{
+	sd_spool_q_t *q = &s_q[prio];
+	char path[40];
+	FIL fil;
+	sd_spool_path(path, sizeof(path), prio, q->first);
+	uint32_t slot = q->rd.gen & 1u;
+	uint32_t off = (uint32_t)offsetof(SD_SpoolSegHeader_t, cur) + slot * (uint32_t)sizeof(SD_SpoolCursor_t);
+	if (f_open(&fil, path, FA_READ | FA_WRITE) != FR_OK) {
+		s_st.errors++;
+		return;
+	}
+	if (!sd_spool_write_at(&fil, off, &q->rd, (uint32_t)sizeof(q->rd)) || f_sync(&fil) != FR_OK) {
+		s_st.errors++;
+	}
+	(void)f_close(&fil);
+}
+
+static void sd_spool_advance(uint8_t prio, uint32_t rec_len, bool delivered)
+{
+	sd_spool_q_t *q = &s_q[prio];
+	uint32_t n = SD_SPOOL_REC_HDR_LEN + rec_len;
+	q->rd.gen++;
+	q->rd.off += n;
+	q->rd.done++;
+	sd_spool_cursor_seal(&q->rd);
+	sd_spool_store_cursor(prio);
+	q->pending = (q->pending > 0u) ? q->pending - 1u : 0u;
+	q->pending_bytes = (q->pending_bytes > n) ? q->pending_bytes - n : 0u;
+	if (delivered) {
+		s_st.replayed++;
+	} else {
+		s_st.dropped++;
+	}
+}
+
+bool SD_Spool_Peek(SD_SpoolRec_t *rec)
+{
+	if (!s_st.ready || s_wr.open || !rec) {
+		return false;
+	}
+	s_rd.valid = 0;
+	for (uint8_t prio = 0; prio < SD_SPOOL_PRIO_NUM; ++prio) {
+		sd_spool_q_t *q = &s_q[prio];
+		while (q->nsegs != 0u) {
+			char path[40];
+			FIL fil;
+			sd_spool_path(path, sizeof(path), prio, q->first);
+			if (f_open(&fil, path, FA_READ) != FR_OK) {
+				/* 段文件不见了（被手动删除）：按坏段处理 */
+				s_st.errors++;
+				s_st.repaired++;
+				sd_spool_drop_head(prio, 0u);
+				continue;
+			}
+			uint32_t size = (uint32_t)f_size(&fil);
+			uint32_t end = (q->first == q->last) ? q->last_size : size;
+			SD_SpoolRecHeader_t r;
+			bool have = (q->rd.off + SD_SPOOL_REC_HDR_LEN <= end) &&
+			            sd_spool_read_at(&fil, q->rd.off, &r, SD_SPOOL_REC_HDR_LEN) &&
+			            sd_spool_rec_ok(&r, q->rd.off, end);
+			if (!have) {
+				(void)f_close(&fil);
+				if (q->rd.off < end) {
+					/* 读游标之后的记录头坏了（上电扫描之后才坏）：这一段剩下的放弃 */
+					s_st.repaired++;
+				}
+				sd_spool_drop_head(prio, size);
+				continue;
+			}
+			bool good = sd_spool_check_payload(&fil, q->rd.off + SD_SPOOL_REC_HDR_LEN, &r);
+			(void)f_close(&fil);
+			if (!good) {
+				s_st.errors++;
+				sd_spool_advance(prio, r.len, false);
+				continue;
+			}
+			s_rd.valid = 1;
+			s_rd.prio = prio;
+			s_rd.seg = q->first;
+			s_rd.off = q->rd.off;
+			s_rd.len = r.len;
+			s_rd.pos = 0;
+			rec->prio = prio;
+			rec->seq = r.seq;
+			rec->tick = r.tick;
+			rec->rtc_sec = r.rtc_sec;
+			rec->len = r.len;
+			return true;
+		}
+	}
+	return false;
+}
+
+uint32_t SD_Spool_Read(void *buf, uint32_t cap)
+{
+	if (!s_rd.valid || !buf || s_rd.pos >= s_rd.len) {
+		return 0u;
+	}
+	uint32_t n = s_rd.len - s_rd.pos;
+	if (n > cap) {
+		n = cap;
+	}
+	char path[40];
+	FIL fil;
+	sd_spool_path(path, sizeof(path), s_rd.prio, s_rd.seg);
+	if (f_open(&fil, path, FA_READ) != FR_OK) {
+		s_st.errors++;
+		return 0u;
+	}
+	bool ok = sd_spool_read_at(&fil, s_rd.off + SD_SPOOL_REC_HDR_LEN + s_rd.pos, buf, n);
+	(void)f_close(&fil);
+	if (!ok) {
+		s_st.errors++;
+		return 0u;
+	}
+	s_rd.pos += n;
+	return n;
+}
+
+bool SD_Spool_Commit(bool delivered)
+{
+	if (!s_rd.valid) {
+		return false;
+	}
+	s_rd.valid = 0;
+	sd_spool_q_t *q = &s_q[s_rd.prio];
+	/* 期间被配额挤掉 / 重新扫描过 */
+	if (q->nsegs == 0u || q->first != s_rd.seg || q->rd.off != s_rd.off) {
+		return false;
+	}
+	sd_spool_advance(s_rd.prio, s_rd.len, delivered);
+	return true;
+}
+
+void SD_Spool_GetStats(SD_SpoolStats_t *st)
+{
+	if (!st) {
+		return;
+	}
+	*st = s_st;
+	st->segs = 0;
+	st->pending_bytes = 0;
+	for (uint32_t i = 0; i < SD_SPOOL_PRIO_NUM; ++i) {
+		st->pending[i] = s_q[i].pending;
+		st->pending_bytes += s_q[i].pending_bytes;
+		st->segs += s_q[i].nsegs;
+	}
+}
@@ -0,0 +1,122 @@
+#ifndef SD_SPOOL_H
+#define SD_SPOOL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* 上报断线缓存（store-and-forward）：链路断开/回包停滞期间把编码好的上报帧追加写进 SD，
+ * 恢复后由上报模块按限速补传。记录对本模块是不透明字节（上报模块写的是 ad_frame 二进制帧）。
+ *
+ * 目录 0:/spool，两级优先级各一串段文件：e<段号>.spl（故障/录波事件帧，先补传）、n<段号>.spl（普通帧）；
+ * 同级段号连续递增，只在最新段尾部追加，补传从最早段读起，读完的段整段删除。
+ *
+ * 段文件 = 段头 SD_SpoolSegHeader_t + 若干条记录（SD_SpoolRecHeader_t + len 字节负载）：
+ * - 段头固定部分建段时写一次并 f_sync；读游标存两份（交替覆盖，gen 大且 CRC 对的有效），
+ *   写游标时掉电最多坏掉正在写的那份，退回上一份 = 多补传一条（服务器按 seq 去重）
+ * - 记录先写全零占位头 + 负载并 f_sync，再回头写真正的记录头并 f_sync：头有效即负载完整；
+ *   掉电留下的残缺尾部上电时按记录头校验截掉
+ * - 配额按段文件总字节算，写新记录前不够就先删最早的普通段，没有普通段才删事件段
+ *
+ * 只在一个任务里调用（上报任务）；FatFs 已开 _FS_REENTRANT，与录波/日志写卡互不干扰 */
+
+#define SD_SPOOL_DIR "0:/spool"
+
+#define SD_SPOOL_SEG_MAGIC 0x534C5053u /* "SPLS" */
+#define SD_SPOOL_REC_MAGIC 0x524C5053u /* "SPLR" */
+#define SD_SPOOL_VERSION 1u
+
+/* 默认配额（SPOOL_QUOTA_MB 可在运行时改） */
+#ifndef SD_SPOOL_QUOTA_MB
+#define SD_SPOOL_QUOTA_MB 64u
+#endif
+
+/* 单个段文件写到这么大就开新段（读完整段删除的粒度） */
+#ifndef SD_SPOOL_SEG_KB
+#define SD_SPOOL_SEG_KB 1024u
+#endif
+
+/* 写一条记录前为它预留的配额（须 ≥ 最大一帧） */
+#ifndef SD_SPOOL_REC_RESERVE
+#define SD_SPOOL_REC_RESERVE (96u * 1024u)
+#endif
+
+enum {
+	SD_SPOOL_PRIO_EVENT = 0, /* 故障/录波事件帧 */
+	SD_SPOOL_PRIO_NORMAL,
+	SD_SPOOL_PRIO_NUM
+};
+
+typedef struct {
+	uint32_t gen;  /* 覆盖次数，大者新 */
+	uint32_t off;  /* 下一条未补传记录的文件偏移 */
+	uint32_t done; /* 本段已补传/丢弃的记录数 */
+	uint32_t crc;  /* 前三个字段的 CRC32 */
+} SD_SpoolCursor_t;
+
+typedef struct {
+	uint32_t magic;
+	uint16_t version;
+	uint8_t prio;
+	uint8_t hdr_len;  /* sizeof(SD_SpoolSegHeader_t) */
+	uint32_t seg_id;
+	uint32_t created; /* SD_Time_GetUnix */
+	uint32_t crc;     /* 以上字段的 CRC32 */
+	SD_SpoolCursor_t cur[2];
+} SD_SpoolSegHeader_t;
+
+typedef struct {
+	uint32_t magic;
+	uint32_t len;     /* 负载字节 */
+	uint32_t seq;     /* 上报序号 */
+	uint32_t tick;    /* 采集时刻 HAL_GetTick() */
+	uint32_t rtc_sec; /* 采集时刻 RTC 秒 */
+	uint32_t crc;     /* 负载 CRC32 */
+	uint32_t hcrc;    /* 以上字段的 CRC32 */
+} SD_SpoolRecHeader_t;
+
+/* 下一条待补传记录 */
+typedef struct {
+	uint8_t prio;
+	uint32_t seq;
+	uint32_t tick;
+	uint32_t rtc_sec;
+	uint32_t len;
+} SD_SpoolRec_t;
+
+typedef struct {
+	uint8_t ready;
+	uint32_t pending[SD_SPOOL_PRIO_NUM]; /* 待补传记录 */
+	uint32_t pending_bytes;
+	uint32_t disk_bytes;                 /* 段文件总字节（配额口径） */
+	uint32_t quota_bytes;
+	uint32_t segs;
+	uint32_t written;
+	uint32_t replayed;
+	uint32_t dropped;      /* 配额挤掉 / 补传多次失败放弃 / 校验不过的记录 */
+	uint32_t dropped_segs; /* 配额挤掉的段 */
+	uint32_t repaired;     /* 上电恢复时截掉的残缺尾部 / 删掉的坏段 */
+	uint32_t errors;       /* SD 读写失败 */
+	uint32_t max_seq;      /* 盘上记录的最大上报序号 */
+} SD_SpoolStats_t;
+
+/* 挂载后扫描 0:/spool、校验段头与记录头、截掉残缺尾部；可重复调用（重新扫描） */
+bool SD_Spool_Init(void);
+bool SD_Spool_IsReady(void);
+void SD_Spool_SetQuotaMb(uint32_t quota_mb);
+
+/* 追加一条记录：Begin 后可多次 Data，End 落盘（Abort 放弃，已写的占位部分留作残缺尾部，下次追加前截掉） */
+bool SD_Spool_AppendBegin(uint8_t prio, uint32_t seq, uint32_t tick);
+bool SD_Spool_AppendData(const void *data, uint32_t n);
+bool SD_Spool_AppendEnd(void);
+void SD_Spool_AppendAbort(void);
+
+/* 取下一条待补传记录（事件级先、同级先进先出），并把读位置放到其负载开头；负载 CRC 不对的记录直接跳过 */
+bool SD_Spool_Peek(SD_SpoolRec_t *rec);
+/* 顺序读当前记录的负载；返回字节数（读完返回 0，出错返回 0 并计 errors） */
+uint32_t SD_Spool_Read(void *buf, uint32_t cap);
+/* 当前记录已送达（delivered = true）或放弃：推进并持久化读游标，段读完即删 */
+bool SD_Spool_Commit(bool delivered);
+
+void SD_Spool_GetStats(SD_SpoolStats_t *st);
+
+#endif /* SD_SPOOL_H */
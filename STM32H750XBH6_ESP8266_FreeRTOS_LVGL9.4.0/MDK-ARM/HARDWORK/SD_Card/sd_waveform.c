@@ -2,9 +2,11 @@
 
 #include "SD.h"
 #include "sd_time.h"
+#include "ad_acq_buffers.h"
 
 #include "ff.h"
 
+#include <stddef.h>
 #include <stdio.h>
 #include <string.h>
 
@@ -49,11 +51,12 @@ bool SD_Wave_SaveBinEx(const char *name, const float *data, uint32_t len, const
 
 	WaveFileHeader_t hdr = {0};
 	hdr.magic = SD_WAVE_MAGIC;
-	hdr.version = 1;
+	hdr.version = SD_WAVE_VERSION;
 	hdr.timestamp = SD_Time_GetUnix();
 	hdr.channel = meta ? meta->channel : 0;
 	hdr.sample_rate = meta ? meta->sample_rate : 0;
 	hdr.count = len;
+	hdr.os_mode = meta ? meta->os_mode : 0;
 
 	FIL fil;
 	FRESULT res = f_open(&fil, name, FA_CREATE_ALWAYS | FA_WRITE);
@@ -85,13 +88,22 @@ bool SD_Wave_LoadBin(const char *name, float *data, uint32_t *len)
 	if (res != FR_OK) {
 		return false;
 	}
+	/* 先读 v1 部分，再按版本补读扩展字段（v1 文件数据紧跟在 count 之后） */
 	WaveFileHeader_t hdr = {0};
+	const UINT v1_size = (UINT)offsetof(WaveFileHeader_t, os_mode);
 	UINT br = 0;
-	res = f_read(&fil, &hdr, sizeof(hdr), &br);
-	if (res != FR_OK || br != sizeof(hdr) || hdr.magic != SD_WAVE_MAGIC) {
+	res = f_read(&fil, &hdr, v1_size, &br);
+	if (res != FR_OK || br != v1_size || hdr.magic != SD_WAVE_MAGIC) {
 		(void)f_close(&fil);
 		return false;
 	}
+	if (hdr.version >= 2u) {
+		res = f_read(&fil, &hdr.os_mode, sizeof(hdr) - v1_size, &br);
+		if (res != FR_OK || br != sizeof(hdr) - v1_size) {
+			(void)f_close(&fil);
+			return false;
+		}
+	}
 	uint32_t count = hdr.count;
 	if (*len < count) {
 		count = *len;
@@ -168,7 +180,125 @@ bool SD_Wave_AutoSave(uint8_t channel, const float *data, uint32_t len, bool csv
 
 	SD_WaveMeta_t meta;
 	meta.channel = channel;
-	meta.sample_rate = 0;
+	meta.sample_rate = AD_Acq_SampleRate();
 	meta.timestamp = SD_Time_GetUnix();
+	meta.os_mode = AD_Acq_OsMode();
 	return SD_Wave_SaveBinEx(file, data, len, &meta);
 }
+
+#if SD_EVENT_COMPRESS
+#define SD_EVENT_Z_MAX_CH 8u
+
+static AD_Codec_t s_evt_codec;
+/* 一块：u16 帧数 + u16 字节数 + 每通道最坏 1 + 2n 字节（int16 输入不会超过） */
+static uint8_t s_evt_chunk[4u + SD_EVENT_Z_MAX_CH * (1u + 2u * AD_CODEC_BLOCK)];
+
+static inline int16_t sd_event_sample(const int16_t *seg0, uint32_t len0, const int16_t *seg1, uint32_t idx)
+{
+	return (idx < len0) ? seg0[idx] : seg1[idx - len0];
+}
+
+/* 按 AD_CODEC_BLOCK 帧一块边编码边写，工作区只有 s_evt_codec + s_evt_chunk */
+static bool sd_write_event_z(FIL *fil, uint32_t nch, const int16_t *seg0, uint32_t len0,
+                             const int16_t *seg1, uint32_t len1)
+{
+	if (nch == 0 || nch > SD_EVENT_Z_MAX_CH) {
+		return false;
+	}
+	uint32_t frames = (len0 + len1) / nch;
+	AD_Codec_Reset(&s_evt_codec);
+	for (uint32_t f0 = 0; f0 < frames; f0 += AD_CODEC_BLOCK) {
+		uint32_t cnt = (frames - f0 < AD_CODEC_BLOCK) ? frames - f0 : AD_CODEC_BLOCK;
+		uint32_t len = 4u;
+		for (uint32_t ch = 0; ch < nch; ch++) {
+			for (uint32_t j = 0; j < cnt; j++) {
+				s_evt_codec.in[j] = sd_event_sample(seg0, len0, seg1, (f0 + j) * nch + ch);
+			}
+			uint32_t nb = AD_Codec_Encode(&s_evt_codec, ch, s_evt_codec.in, cnt,
+			                              s_evt_chunk + len, sizeof(s_evt_chunk) - len);
+			if (nb == 0) {
+				return false;
+			}
+			len += nb;
+		}
+		s_evt_chunk[0] = (uint8_t)cnt;
+		s_evt_chunk[1] = (uint8_t)(cnt >> 8);
+		s_evt_chunk[2] = (uint8_t)(len - 4u);
+		s_evt_chunk[3] = (uint8_t)((len - 4u) >> 8);
+		UINT bw = 0;
+		if (f_write(fil, s_evt_chunk, len, &bw) != FR_OK || bw != len) {
+			return false;
+		}
+	}
+	return true;
+}
+#endif
+
+void SD_Wave_GetEventCodecStats(AD_CodecStats_t *st)
+{
+	if (!st) {
+		return;
+	}
+#if SD_EVENT_COMPRESS
+	*st = s_evt_codec.st;
+#else
+	memset(st, 0, sizeof(*st));
+#endif
+}
+
+bool SD_Wave_SaveEvent(const SD_EventHeader_t *hdr, const int16_t *seg0, uint32_t len0,
+                       const int16_t *seg1, uint32_t len1)
+{
+	if (!hdr || !seg0 || len0 == 0) {
+		return false;
+	}
+	if (SD_Init() != FR_OK) {
+		return false;
+	}
+	char date_path[64];
+	if (!SD_Time_GetDatePath(date_path, sizeof(date_path), "0:/events")) {
+		return false;
+	}
+	if (SD_MkdirRecursive(date_path) != FR_OK) {
+		return false;
+	}
+	char ts[32];
+	if (!SD_Time_GetTimestamp(ts, sizeof(ts))) {
+		return false;
+	}
+	char file[128];
+	if (snprintf(file, sizeof(file), "%s/evt_%s_%s_%lu.bin",
+	             date_path, hdr->fault_code, ts, (unsigned long)hdr->seq) <= 0) {
+		return false;
+	}
+
+	FIL fil;
+	FRESULT res = f_open(&fil, file, FA_CREATE_ALWAYS | FA_WRITE);
+	if (res != FR_OK) {
+		return false;
+	}
+	UINT bw = 0;
+	SD_EventHeader_t h = *hdr;
+#if SD_EVENT_COMPRESS
+	h.magic = SD_EVENT_Z_MAGIC;
+#endif
+	res = f_write(&fil, &h, sizeof(h), &bw);
+	bool ok = (res == FR_OK && bw == sizeof(h));
+#if SD_EVENT_COMPRESS
+	if (ok) {
+		ok = sd_write_event_z(&fil, hdr->channels, seg0, len0, seg1, seg1 ? len1 : 0);
+	}
+#else
+	if (ok) {
+		res = f_write(&fil, seg0, sizeof(int16_t) * len0, &bw);
+		ok = (res == FR_OK && bw == sizeof(int16_t) * len0);
+	}
+	if (ok && seg1 && len1) {
+		res = f_write(&fil, seg1, sizeof(int16_t) * len1, &bw);
+		ok = (res == FR_OK && bw == sizeof(int16_t) * len1);
+	}
+#endif
+	(void)f_sync(&fil);
+	(void)f_close(&fil);
+	return ok;
+}
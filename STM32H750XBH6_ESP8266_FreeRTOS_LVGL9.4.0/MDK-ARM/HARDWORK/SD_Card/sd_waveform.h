@@ -4,7 +4,20 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#include "ad_codec.h"
+
 #define SD_WAVE_MAGIC 0x57415645u /* "WAVE" */
+#define SD_EVENT_MAGIC 0x544E5645u /* "EVNT" */
+#define SD_EVENT_Z_MAGIC 0x5A4E5645u /* "EVNZ"：同一文件头，数据区为无损压缩块 */
+
+/* 录波事件是否无损压缩落盘（1 = EVNZ，0 = EVNT 原样 int16） */
+#ifndef SD_EVENT_COMPRESS
+#define SD_EVENT_COMPRESS 1
+#endif
+
+/* 文件头版本：v2 起记录过采样倍率（os_mode 0..6 = 1x..64x） */
+#define SD_WAVE_VERSION 2u
+#define SD_EVENT_VERSION 2u
 
 typedef struct {
 	uint32_t magic;
@@ -13,18 +26,49 @@ typedef struct {
 	uint32_t channel;
 	uint32_t sample_rate;
 	uint32_t count;
+	uint32_t os_mode; /* v2 新增；v1 文件头到 count 为止 */
 } WaveFileHeader_t;
 
 typedef struct {
 	uint32_t channel;
 	uint32_t sample_rate;
 	uint32_t timestamp;
+	uint32_t os_mode;
 } SD_WaveMeta_t;
 
+/* 瞬态录波事件文件头，其后紧跟 frames × channels 个 int16 原始码（帧内按通道交织）
+ * 工程量 = (code - offset[ch]) * scale[ch]
+ * EVNZ 文件：文件头相同（仅 magic 不同），数据区为若干块，每块 = u16 帧数（≤ AD_CODEC_BLOCK）+ u16 字节数
+ * + 各通道依次一个 ad_codec 块；每通道的预测历史跨块连续，文件末尾不完整的块丢弃即可 */
+typedef struct {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t timestamp;
+	uint32_t seq;
+	uint32_t trig_frame;
+	uint32_t sample_rate;
+	uint32_t pre;
+	uint32_t post;
+	uint32_t frames;
+	uint8_t channels;
+	uint8_t trig_ch;
+	uint8_t trig_type;
+	uint8_t os_mode;       /* v2：v1 中此字节为 fault_code[0] */
+	char fault_code[4];
+	uint8_t ch_id[8];
+	float scale[8];
+	float offset[8];
+} SD_EventHeader_t;
+
 bool SD_Wave_SaveBin(const char *name, const float *data, uint32_t len);
 bool SD_Wave_SaveBinEx(const char *name, const float *data, uint32_t len, const SD_WaveMeta_t *meta);
 bool SD_Wave_LoadBin(const char *name, float *data, uint32_t *len);
 bool SD_Wave_SaveCSV(const char *name, const float *data, uint32_t len);
 bool SD_Wave_AutoSave(uint8_t channel, const float *data, uint32_t len, bool csv);
+/* 数据可分两段（环形缓冲回绕）；文件存放在 0:/events/<日期>/ */
+bool SD_Wave_SaveEvent(const SD_EventHeader_t *hdr, const int16_t *seg0, uint32_t len0,
+                       const int16_t *seg1, uint32_t len1);
+/* 录波压缩累计统计（SD_EVENT_COMPRESS = 1 时有效） */
+void SD_Wave_GetEventCodecStats(AD_CodecStats_t *st);
 
 #endif /* SD_WAVEFORM_H */
@@ -0,0 +1,365 @@
+/*
+ * 故障分类推理主机比对（Core/Src/ad_class.c + ad_stats.c + ad_spec.c，与固件同一份代码、同一套 CMSIS-DSP）
+ *
+ * 两个子命令：
+ *   feats [-n 每类块数] [-s 种子] [evt.bin:E02 ...] > feats.csv
+ *      输出带标签的特征向量（每行：故障码,f0..f31，按 AD_ACQ_CH_MASK=0x0F 的 4 个逻辑通道拼接）：
+ *      - 不给文件：合成正常/交流窜入(E01)/绝缘下降(E02)/电容老化(E03)/母线接地(E05) 各 n 块，每块参数随机
+ *      - 给录波事件文件（SD 0:/events/<日期>/evt_*.bin，EVNT/EVNZ 均可）：按 4096 帧分块，整份文件标为冒号后的故障码
+ *      特征计算路径与板上一致：原始码 -> 工程量 -> AD_Stats_Compute + AD_Spec_MagMulti(2/BINS) -> AD_Class_Features
+ *   check model.bin ref.csv
+ *      用固件的解析/预测函数（CMSIS arm_gaussian_naive_bayes_predict_f32 / arm_svm_rbf_predict_f32）
+ *      对 train_model.py 输出的参考文件逐行预测，与离线参考模型（double 精度）的预测比较；
+ *      参考裕量 < 1e-3 的行（两类几乎等分，float/double 舍入可能翻转）单列为临界，不算不一致。
+ *      输出不一致行数、相对标签的准确率与每次推理的主机耗时；有不一致返回 1
+ *
+ * 训练与比对流程：
+ *   ./class_check feats -n 200 > train.csv && ./class_check feats -n 100 -s 7 > test.csv
+ *   python3 tools/class_check/train_model.py gnb train.csv test.csv ad_class.bin ref.csv
+ *   ./class_check check ad_class.bin ref.csv
+ *   （SVM：train_model.py svm:E02 ...，只用 E00/E02 两类样本训练）
+ *   ad_class.bin 拷到 SD 0:/config/ 或 QSPI 1:/config/，控制台 class reload 生效；
+ *   板上每块的耗时见 [DSP] 行 class= 与 class 命令
+ *
+ * 编译（在工程根目录，CMSIS 源文件同 spec_pair_bench.c，另加 Bayes/SVM）：
+ *   D=MDK-ARM/HARDWORK/CMSIS-DSP/1.16.2
+ *   gcc -O2 -D__GNUC_PYTHON__ -ffunction-sections -fdata-sections -Wl,--gc-sections \
+ *       -ICore/Inc -Itools/common -I$D/Include -I$D/PrivateInclude $(for x in $D/Source/[A-Z]*; do echo -I$x; done) \
+ *       tools/class_check/class_check.c Core/Src/ad_class.c Core/Src/ad_stats.c Core/Src/ad_spec.c Core/Src/ad_codec.c \
+ *       $D/Source/BayesFunctions/BayesFunctions.c $D/Source/SVMFunctions/SVMFunctions.c \
+ *       $D/Source/TransformFunctions/TransformFunctions.c $D/Source/CommonTables/CommonTables.c \
+ *       $D/Source/ComplexMathFunctions/ComplexMathFunctions.c $D/Source/BasicMathFunctions/BasicMathFunctions.c \
+ *       $D/Source/SupportFunctions/SupportFunctions.c $D/Source/FastMathFunctions/FastMathFunctions.c \
+ *       $D/Source/StatisticsFunctions/StatisticsFunctions.c -lm -o class_check
+ *   仓库里的 1.16.2 快照缺 CommonTables/arm_common_tables.c 时追加 -IDrivers/CMSIS/DSP/Source/CommonTables
+ */
+#include "ad_class.h"
+#include "ad_spec.h"
+#include "event_file.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define N       4096u
+#define BINS    (N / 2u)
+#define FS      25600u
+#define NCH     4u     /* AD_ACQ_CH_MASK = 0x0F */
+#define CH_MASK 0x0Fu
+#define DIM     (NCH * AD_CLASS_FEATS_PER_CH)
+
+static float32_t s_wave[NCH][N];
+static float32_t s_spec[NCH][BINS];
+static float32_t s_work[2u * N];
+static AD_SpecKernel_t s_kern;
+static float s_ref[NCH]; /* 统计基准点：各通道上一块均值（同一录波文件内连续；NAN = 内核自选） */
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static double urand(double lo, double hi)
+{
+    return lo + (hi - lo) * (double)rand() / RAND_MAX;
+}
+
+/* 一块 s_wave -> 一行特征（与 AD_Dsp_Service + AD_Class_OnBlock 相同的计算顺序） */
+static void emit_block(const char *code, uint32_t rate)
+{
+    AD_Stats_t st[NCH];
+    const float32_t *in[NCH];
+    float32_t *out[NCH];
+    const float *spec[NCH];
+    float x[DIM];
+
+    for (uint32_t ch = 0; ch < NCH; ch++)
+    {
+        AD_Stats_ComputeRef(s_wave[ch], N, s_ref[ch], &st[ch]);
+        s_ref[ch] = st[ch].mean;
+        in[ch] = s_wave[ch];
+        out[ch] = s_spec[ch];
+        spec[ch] = s_spec[ch];
+    }
+    AD_Spec_MagMulti(&s_kern, in, out, NCH, 2.0f / (float)BINS);
+    for (uint32_t ch = 0; ch < NCH; ch++)
+        s_spec[ch][0] = 0.0f;
+    (void)AD_Class_Features(st, spec, NCH, BINS, rate, x);
+
+    printf("%s", code);
+    for (uint32_t i = 0; i < DIM; i++)
+        printf(",%.9g", (double)x[i]);
+    printf("\n");
+}
+
+static void ref_reset(void)
+{
+    for (uint32_t ch = 0; ch < NCH; ch++)
+        s_ref[ch] = NAN;
+}
+
+/* ---------- 合成样本 ---------- */
+
+/* 通道按物理 0..3：母线(+) V、母线(-) V、负载电流 A、漏电流 mA（同 fault_replay） */
+static void make_block(const char *code, uint32_t blk)
+{
+    double vbus = urand(680.0, 720.0);
+    double vp = vbus / 2.0, vn = -vbus / 2.0;
+    double ripple = urand(1.5, 4.0), ac = 0.0, load = urand(5.0, 40.0);
+    double leak_dc = urand(0.1, 1.0), leak_ac = urand(0.1, 0.5);
+    double ph = urand(0.0, 2.0 * M_PI);
+
+    if (strcmp(code, "E01") == 0)
+        ac = urand(15.0, 60.0); /* 工频交流窜入直流母线（共模） */
+    else if (strcmp(code, "E02") == 0)
+    {
+        leak_dc = urand(6.0, 40.0);
+        leak_ac = urand(1.0, 8.0);
+    }
+    else if (strcmp(code, "E03") == 0)
+        ripple = urand(8.0, 16.0); /* 电容容量下降，100Hz 纹波变大 */
+    else if (strcmp(code, "E05") == 0)
+    {
+        double k = urand(0.75, 0.98); /* 负母线对地电压被拉低 */
+        vp = vbus * k;
+        vn = -vbus * (1.0 - k);
+    }
+
+    for (uint32_t i = 0; i < N; i++)
+    {
+        double t = (double)(blk * N + i) / FS;
+        double r = ripple * sin(2.0 * M_PI * 100.0 * t + ph);
+        double a = ac * sin(2.0 * M_PI * 50.0 * t + ph);
+        s_wave[0][i] = (float)(vp + r + a + 0.4 * urand(-0.5, 0.5));
+        s_wave[1][i] = (float)(vn - r + a + 0.4 * urand(-0.5, 0.5));
+        s_wave[2][i] = (float)(load + 0.1 * load * sin(2.0 * M_PI * 50.0 * t) + 0.1 * urand(-0.5, 0.5));
+        s_wave[3][i] = (float)(leak_dc + leak_ac * sin(2.0 * M_PI * 50.0 * t + ph) + 0.1 * urand(-0.5, 0.5));
+    }
+}
+
+/* ---------- 录波事件文件 ---------- */
+
+static int feats_file(const char *arg)
+{
+    char path[512];
+    EventHeader_t h;
+    int32_t map[NCH];
+
+    strncpy(path, arg, sizeof(path) - 1u);
+    path[sizeof(path) - 1u] = '\0';
+    char *code = strrchr(path, ':');
+    if (!code || strlen(code + 1) != 3u)
+    {
+        fprintf(stderr, "%s: need label, e.g. evt_0001.bin:E02\n", arg);
+        return 1;
+    }
+    *code++ = '\0';
+
+    int16_t *raw;
+    if (Evt_Load(path, &h, &raw) != EVT_OK || h.sample_rate == 0u)
+    {
+        fprintf(stderr, "%s: not an event file\n", path);
+        free(raw);
+        return 1;
+    }
+    for (uint32_t ch = 0; ch < NCH; ch++)
+    {
+        map[ch] = -1;
+        for (uint32_t i = 0; i < h.channels; i++)
+        {
+            if (h.ch_id[i] == ch)
+                map[ch] = (int32_t)i;
+        }
+        if (map[ch] < 0)
+        {
+            fprintf(stderr, "%s: CH%u not recorded\n", path, (unsigned)ch);
+            free(raw);
+            return 1;
+        }
+    }
+
+    uint32_t blocks = 0;
+    ref_reset();
+    for (uint32_t done = 0; done + N <= h.frames; done += N)
+    {
+        const int16_t *x = &raw[(size_t)done * h.channels];
+        for (uint32_t ch = 0; ch < NCH; ch++)
+        {
+            uint32_t k = (uint32_t)map[ch];
+            for (uint32_t i = 0; i < N; i++)
+                s_wave[ch][i] = ((float)x[i * h.channels + k] - h.offset[k]) * h.scale[k];
+        }
+        emit_block(code, h.sample_rate);
+        blocks++;
+    }
+    free(raw);
+    fprintf(stderr, "%s: %u blocks as %s\n", path, (unsigned)blocks, code);
+    return 0;
+}
+
+static int cmd_feats(int argc, char **argv)
+{
+    static const char *const codes[] = {"E00", "E01", "E02", "E03", "E05"};
+    uint32_t per = 200;
+    int files = 0, rc = 0;
+
+    (void)AD_Spec_Init(&s_kern, N, s_work);
+    srand(1);
+    printf("# code");
+    for (uint32_t i = 0; i < DIM; i++)
+        printf(",f%u", (unsigned)i);
+    printf("\n");
+
+    for (int i = 0; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+            per = (uint32_t)strtoul(argv[++i], NULL, 0);
+        else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+            srand((unsigned)strtoul(argv[++i], NULL, 0));
+        else
+        {
+            rc |= feats_file(argv[i]);
+            files++;
+        }
+    }
+    if (files)
+        return rc;
+
+    for (uint32_t c = 0; c < sizeof(codes) / sizeof(codes[0]); c++)
+    {
+        for (uint32_t b = 0; b < per; b++)
+        {
+            make_block(codes[c], b); /* 每块重新抽母线电压等参数，与上一块不连续 */
+            ref_reset();
+            emit_block(codes[c], FS);
+        }
+    }
+    return 0;
+}
+
+/* ---------- 与参考预测比对 ---------- */
+
+static void *read_all(const char *path, uint32_t *len)
+{
+    FILE *fp = fopen(path, "rb");
+    if (!fp)
+        return NULL;
+    fseek(fp, 0, SEEK_END);
+    long n = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    void *buf = malloc((size_t)n + 4u); /* malloc 至少 8 字节对齐 */
+    if (buf && fread(buf, 1, (size_t)n, fp) != (size_t)n)
+    {
+        free(buf);
+        buf = NULL;
+    }
+    fclose(fp);
+    *len = (uint32_t)n;
+    return buf;
+}
+
+static int cmd_check(const char *model_path, const char *ref_path)
+{
+    AD_ClassModel_t m;
+    const char *why = NULL;
+    uint32_t len = 0;
+    static float work[AD_CLASS_WORK_FLOATS];
+    char line[4096];
+
+    void *buf = read_all(model_path, &len);
+    if (!buf || !AD_Class_Parse(&m, buf, len, &why))
+    {
+        fprintf(stderr, "%s: %s\n", model_path, buf ? why : "cannot read");
+        return 2;
+    }
+    if (m.ch_mask != CH_MASK)
+    {
+        fprintf(stderr, "%s: ch_mask 0x%02X, firmware uses 0x%02X\n", model_path, (unsigned)m.ch_mask, CH_MASK);
+        return 2;
+    }
+    printf("%s: %s classes=%u dim=%u sv=%u (%u bytes)\n", model_path, AD_Class_KindName(m.kind), (unsigned)m.nclass,
+           (unsigned)m.dim, (unsigned)m.nsv, (unsigned)len);
+
+    FILE *fp = fopen(ref_path, "r");
+    if (!fp)
+    {
+        fprintf(stderr, "cannot open %s\n", ref_path);
+        return 2;
+    }
+    uint32_t rows = 0, mismatch = 0, ties = 0, correct = 0;
+    double t_ns = 0.0;
+    while (fgets(line, sizeof(line), fp))
+    {
+        char label[8];
+        int ref = -1;
+        double margin = 0.0;
+        float x[AD_CLASS_DIM_MAX];
+        int off = 0;
+
+        if (line[0] == '#' || sscanf(line, "%7[^,],%d,%lf%n", label, &ref, &margin, &off) != 3)
+            continue;
+        const char *p = line + off;
+        uint32_t d = 0;
+        for (; d < m.dim && *p == ','; d++)
+        {
+            char *e;
+            x[d] = strtof(p + 1, &e);
+            p = e;
+        }
+        if (d != m.dim)
+        {
+            fprintf(stderr, "%s: row %u has %u features, model wants %u\n", ref_path, (unsigned)rows, (unsigned)d,
+                    (unsigned)m.dim);
+            fclose(fp);
+            return 2;
+        }
+
+        float score = 0.0f;
+        int32_t got = 0;
+        double t0 = now_ns();
+        for (int r = 0; r < 20; r++)
+            got = AD_Class_Predict(&m, x, work, &score);
+        t_ns += (now_ns() - t0) / 20.0;
+
+        rows++;
+        if (strcmp(m.code[got], label) == 0)
+            correct++;
+        if (got != ref)
+        {
+            if (fabs(margin) < 1e-3)
+                ties++;
+            else
+            {
+                mismatch++;
+                if (mismatch <= 10u)
+                    printf("  row %u: device %d (%s) vs reference %d, margin %.4g\n", (unsigned)rows, (int)got,
+                           m.code[got], ref, margin);
+            }
+        }
+    }
+    fclose(fp);
+    free(buf);
+    if (rows == 0u)
+    {
+        fprintf(stderr, "%s: no rows\n", ref_path);
+        return 2;
+    }
+    printf("rows=%u mismatch=%u ties=%u accuracy(vs label)=%.2f%% host=%.2fus/inference\n", (unsigned)rows,
+           (unsigned)mismatch, (unsigned)ties, 100.0 * correct / rows, t_ns / 1000.0 / rows);
+    printf("%s\n", mismatch ? "FAIL" : "PASS");
+    return mismatch ? 1 : 0;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc >= 2 && strcmp(argv[1], "feats") == 0)
+        return cmd_feats(argc - 2, argv + 2);
+    if (argc == 4 && strcmp(argv[1], "check") == 0)
+        return cmd_check(argv[2], argv[3]);
+    fprintf(stderr, "usage: %s feats [-n per_class] [-s seed] [evt.bin:E02 ...] > feats.csv\n"
+                    "       %s check model.bin ref.csv\n",
+            argv[0], argv[0]);
+    return 2;
+}
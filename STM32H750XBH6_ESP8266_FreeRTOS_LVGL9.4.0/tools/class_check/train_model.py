@@ -0,0 +1,252 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+故障分类离线训练 -> 板上模型文件（Core/Inc/ad_class.h 的 AD_ClassFileHeader_t 格式）+ 参考预测
+
+纯 Python（不依赖 numpy/sklearn），输入是 class_check feats 输出的特征 CSV：
+  python3 train_model.py gnb      train.csv test.csv ad_class.bin ref.csv
+  python3 train_model.py svm:E02  train.csv test.csv ad_class.bin ref.csv
+
+- gnb：高斯朴素贝叶斯，类别 = 训练集中出现的全部故障码（按码排序，最多 8 类）；
+       方差附加量 epsilon = VAR_SMOOTHING × 最大特征方差（同 sklearn 的 var_smoothing，但加在预测时，与 CMSIS 一致）
+- svm:CODE：RBF 核 SVM（简化 SMO），只用 E00 与 CODE 两类样本，类别 0 = E00，类别 1 = CODE；
+       gamma = 1 / 维数（特征已标准化，相当于 sklearn 的 gamma='scale'）
+两者都先按训练集均值/标准差标准化（参数写进模型文件，板上做同样的变换）。
+
+ref.csv 每行：标签,参考预测类别,参考裕量,特征...（测试集）
+  参考裕量：GNB 为最大与次大对数似然之差，SVM 为决策值；
+  参考预测用写进文件的 float32 参数、double 运算，class_check check 用固件代码逐行比对。
+"""
+import math
+import random
+import struct
+import sys
+
+MAGIC = 0x4C434441  # "ADCL"
+VERSION = 1
+KIND_GNB = 1
+KIND_SVM = 2
+FEATS_PER_CH = 8
+MAX_CLASSES = 8
+CH_MASK = 0x0F
+
+VAR_SMOOTHING = 1e-3
+SVM_C = 1.0
+SVM_TOL = 1e-3
+SVM_MAX_PASSES = 5
+
+
+def f32(v):
+    return struct.unpack('<f', struct.pack('<f', v))[0]
+
+
+def load_csv(path):
+    rows = []
+    with open(path, 'r', encoding='utf-8') as fp:
+        for line in fp:
+            line = line.strip()
+            if not line or line.startswith('#'):
+                continue
+            parts = line.split(',')
+            rows.append((parts[0], [float(v) for v in parts[1:]], line[len(parts[0]) + 1:]))
+    return rows
+
+
+def standardize_params(xs):
+    dim = len(xs[0])
+    n = float(len(xs))
+    mu = [sum(x[d] for x in xs) / n for d in range(dim)]
+    inv_sd = []
+    for d in range(dim):
+        var = sum((x[d] - mu[d]) ** 2 for x in xs) / n
+        inv_sd.append(1.0 / math.sqrt(var) if var > 1e-20 else 0.0)
+    return [f32(v) for v in mu], [f32(v) for v in inv_sd]
+
+
+def standardize(x, mu, inv_sd):
+    """与 AD_Class_Predict 相同：float32 的 (x - mu) × inv_sd"""
+    return [f32(f32(x[d] - mu[d]) * inv_sd[d]) for d in range(len(x))]
+
+
+# ---------- 高斯朴素贝叶斯 ----------
+
+def train_gnb(zs, ys, classes):
+    dim = len(zs[0])
+    theta, sigma, prior = [], [], []
+    for c in classes:
+        zc = [z for z, y in zip(zs, ys) if y == c]
+        n = float(len(zc))
+        m = [sum(z[d] for z in zc) / n for d in range(dim)]
+        v = [sum((z[d] - m[d]) ** 2 for z in zc) / n for d in range(dim)]
+        theta.append([f32(a) for a in m])
+        sigma.append([f32(a) for a in v])
+        prior.append(f32(n / len(zs)))
+    all_var = []
+    for d in range(dim):
+        mean = sum(z[d] for z in zs) / len(zs)
+        all_var.append(sum((z[d] - mean) ** 2 for z in zs) / len(zs))
+    eps = f32(VAR_SMOOTHING * max(all_var))
+    return theta, sigma, prior, eps
+
+
+def predict_gnb(z, theta, sigma, prior, eps):
+    ll = []
+    for c in range(len(prior)):
+        acc1 = 0.0
+        acc2 = 0.0
+        for d in range(len(z)):
+            s = sigma[c][d] + eps
+            acc1 += math.log(2.0 * math.pi * s)
+            acc2 += (z[d] - theta[c][d]) ** 2 / s
+        ll.append(-0.5 * acc1 - 0.5 * acc2 + math.log(prior[c]))
+    best = max(range(len(ll)), key=lambda i: ll[i])
+    second = max(ll[i] for i in range(len(ll)) if i != best)
+    return best, ll[best] - second
+
+
+# ---------- RBF SVM（简化 SMO） ----------
+
+def rbf(a, b, gamma):
+    return math.exp(-gamma * sum((p - q) ** 2 for p, q in zip(a, b)))
+
+
+def train_svm(zs, ys, gamma):
+    n = len(zs)
+    K = [[0.0] * n for _ in range(n)]
+    for i in range(n):
+        for j in range(i, n):
+            K[i][j] = K[j][i] = rbf(zs[i], zs[j], gamma)
+    alpha = [0.0] * n
+    b = 0.0
+    rnd = random.Random(1)
+
+    def f(i):
+        return sum(alpha[k] * ys[k] * K[k][i] for k in range(n) if alpha[k] > 0.0) + b
+
+    passes = 0
+    while passes < SVM_MAX_PASSES:
+        changed = 0
+        for i in range(n):
+            Ei = f(i) - ys[i]
+            if (ys[i] * Ei < -SVM_TOL and alpha[i] < SVM_C) or (ys[i] * Ei > SVM_TOL and alpha[i] > 0.0):
+                j = rnd.randrange(n - 1)
+                if j >= i:
+                    j += 1
+                Ej = f(j) - ys[j]
+                ai, aj = alpha[i], alpha[j]
+                if ys[i] != ys[j]:
+                    L, H = max(0.0, aj - ai), min(SVM_C, SVM_C + aj - ai)
+                else:
+                    L, H = max(0.0, ai + aj - SVM_C), min(SVM_C, ai + aj)
+                if L >= H:
+                    continue
+                eta = 2.0 * K[i][j] - K[i][i] - K[j][j]
+                if eta >= 0.0:
+                    continue
+                alpha[j] = min(H, max(L, aj - ys[j] * (Ei - Ej) / eta))
+                if abs(alpha[j] - aj) < 1e-6:
+                    continue
+                alpha[i] = ai + ys[i] * ys[j] * (aj - alpha[j])
+                b1 = b - Ei - ys[i] * (alpha[i] - ai) * K[i][i] - ys[j] * (alpha[j] - aj) * K[i][j]
+                b2 = b - Ej - ys[i] * (alpha[i] - ai) * K[i][j] - ys[j] * (alpha[j] - aj) * K[j][j]
+                if 0.0 < alpha[i] < SVM_C:
+                    b = b1
+                elif 0.0 < alpha[j] < SVM_C:
+                    b = b2
+                else:
+                    b = (b1 + b2) / 2.0
+                changed += 1
+        passes = passes + 1 if changed == 0 else 0
+    sv = [i for i in range(n) if alpha[i] > 1e-8]
+    dual = [f32(alpha[i] * ys[i]) for i in sv]
+    vecs = [[f32(v) for v in zs[i]] for i in sv]
+    return dual, vecs, f32(b)
+
+
+def predict_svm(z, dual, vecs, intercept, gamma):
+    s = intercept + sum(dk * rbf(v, z, gamma) for dk, v in zip(dual, vecs))
+    return (1 if s > 0.0 else 0), s
+
+
+# ---------- 模型文件 ----------
+
+def checksum(words):
+    s = 0
+    for w in words:
+        s = (s * 31 + w) & 0xFFFFFFFF
+    return s
+
+
+def write_model(path, kind, codes, dim, nsv, param, intercept, payload):
+    pay = struct.pack('<%df' % len(payload), *payload)
+    head = struct.pack('<7I2fI', MAGIC, VERSION, kind, len(codes), dim, nsv, CH_MASK, param, intercept, len(pay))
+    words = struct.unpack('<10I', head) + struct.unpack('<%dI' % (len(pay) // 4), pay)
+    code_bytes = b''.join(c.encode('ascii')[:3].ljust(4, b'\0') for c in codes).ljust(4 * MAX_CLASSES, b'\0')
+    with open(path, 'wb') as fp:
+        fp.write(head + struct.pack('<I', checksum(words)) + code_bytes + pay)
+    return len(head) + 4 + len(code_bytes) + len(pay)
+
+
+def main(argv):
+    if len(argv) != 6:
+        print(__doc__)
+        return 2
+    mode, train_path, test_path, model_path, ref_path = argv[1:]
+    train, test = load_csv(train_path), load_csv(test_path)
+    dim = len(train[0][1])
+    if dim != FEATS_PER_CH * bin(CH_MASK).count('1'):
+        print('feature dim %d does not match CH_MASK 0x%02X' % (dim, CH_MASK))
+        return 2
+
+    if mode == 'gnb':
+        codes = sorted(set(r[0] for r in train))
+        if not 2 <= len(codes) <= MAX_CLASSES:
+            print('need 2..%d classes, got %d' % (MAX_CLASSES, len(codes)))
+            return 2
+    elif mode.startswith('svm:'):
+        codes = ['E00', mode[4:]]
+        train = [r for r in train if r[0] in codes]
+        test = [r for r in test if r[0] in codes]
+    else:
+        print('unknown mode %s' % mode)
+        return 2
+
+    mu, inv_sd = standardize_params([r[1] for r in train])
+    zs = [standardize(r[1], mu, inv_sd) for r in train]
+    ys = [codes.index(r[0]) for r in train]
+
+    if mode == 'gnb':
+        theta, sigma, prior, eps = train_gnb(zs, ys, range(len(codes)))
+        payload = mu + inv_sd + sum(theta, []) + sum(sigma, []) + prior
+        size = write_model(model_path, KIND_GNB, codes, dim, 0, eps, 0.0, payload)
+
+        def predict(z):
+            return predict_gnb(z, theta, sigma, prior, eps)
+        desc = 'gnb classes=%s epsilon=%.3g' % (','.join(codes), eps)
+    else:
+        gamma = f32(1.0 / dim)
+        dual, vecs, b = train_svm(zs, [1.0 if y else -1.0 for y in ys], gamma)
+        payload = mu + inv_sd + dual + sum(vecs, [])
+        size = write_model(model_path, KIND_SVM, codes, dim, len(dual), gamma, b, payload)
+
+        def predict(z):
+            return predict_svm(z, dual, vecs, b, gamma)
+        desc = 'svm_rbf classes=%s sv=%d gamma=%.4g intercept=%.4g' % (','.join(codes), len(dual), gamma, b)
+
+    ok_train = sum(1 for z, y in zip(zs, ys) if predict(z)[0] == y)
+    ok_test = 0
+    with open(ref_path, 'w', encoding='utf-8') as fp:
+        fp.write('# label,ref_class,ref_margin,features (%s)\n' % desc)
+        for code, x, text in test:
+            cls, margin = predict(standardize(x, mu, inv_sd))
+            ok_test += 1 if codes[cls] == code else 0
+            fp.write('%s,%d,%.9g,%s\n' % (code, cls, margin, text))
+    print('%s -> %s (%d bytes)' % (desc, model_path, size))
+    print('accuracy: train %.2f%% (%d), test %.2f%% (%d)' %
+          (100.0 * ok_train / len(train), len(train), 100.0 * ok_test / max(len(test), 1), len(test)))
+    print('reference predictions -> %s' % ref_path)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
@@ -0,0 +1,411 @@
+/*
+ * 无损波形编解码主机测试（Core/Src/ad_codec.c，与固件同一份编解码器）
+ *
+ * 输入：瞬态录波事件文件（SD 卡 0:/events/<日期>/evt_*.bin）：
+ *   - EVNT：SD_EventHeader_t + int16 原始码帧内交织，按 sd_waveform.c 的 EVNZ 块格式编码后再解码
+ *   - EVNZ：固件压缩落盘的文件，先解码成原始码（校验块长），再按同样方式重新编码比对
+ *   不给文件时用合成录波（母线 ± 直流 + 100Hz 纹波、负载电流 + 开关纹波、漏电流 + 50Hz 与尖峰，含量化噪声）。
+ * 输出：每文件每通道的压缩比（int16 原样 / 编码后）、块压缩比的最小/最大值、定宽块与逃逸数、
+ *       主机编码/解码吞吐（MB/s，按 int16 原样字节计），以及同一数据做 1 阶差分 + zigzag + varint 的压缩比作对照。
+ *   任何一个样本解码不一致都返回非 0。
+ *   -d：把 EVNZ 输入还原成 EVNT 文件（<输入>.evnt），供只认原样 int16 的脚本使用
+ *       （fault_replay / class_check / fft_engine_bench 经 tools/common/event_file.h 直接读 EVNZ）；
+ *   -z：把 EVNT 输入压缩成与固件落盘相同的 EVNZ 文件（<输入>.evnz）。
+ *
+ * 编译（在工程根目录）：
+ *   gcc -O2 -ICore/Inc tools/codec_bench/codec_bench.c Core/Src/ad_codec.c -lm -o codec_bench
+ * 用法：./codec_bench [-d] [-z] [evt_xxx.bin ...]
+ */
+#include "ad_codec.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MAX_CH 8u
+
+/* 与 sd_waveform.h 中 SD_EventHeader_t 相同（小端、自然对齐） */
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t timestamp;
+    uint32_t seq;
+    uint32_t trig_frame;
+    uint32_t sample_rate;
+    uint32_t pre;
+    uint32_t post;
+    uint32_t frames;
+    uint8_t channels;
+    uint8_t trig_ch;
+    uint8_t trig_type;
+    uint8_t os_mode;
+    char fault_code[4];
+    uint8_t ch_id[8];
+    float scale[8];
+    float offset[8];
+} EventHeader_t;
+
+#define EVENT_MAGIC   0x544E5645u /* "EVNT" */
+#define EVENT_Z_MAGIC 0x5A4E5645u /* "EVNZ" */
+
+static AD_Codec_t s_enc;
+static AD_Codec_t s_dec;
+static AD_CodecStats_t s_ch_st[MAX_CH];
+static double s_total_raw;
+static double s_total_enc;
+static double s_total_varint;
+static double s_enc_ns;
+static double s_dec_ns;
+static double s_bench_bytes;
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static double gauss(void)
+{
+    double u = ((double)rand() + 1.0) / ((double)RAND_MAX + 2.0);
+    double v = ((double)rand() + 1.0) / ((double)RAND_MAX + 2.0);
+    return sqrt(-2.0 * log(u)) * cos(2.0 * M_PI * v);
+}
+
+/* 与 sd_write_event_z 相同的块格式：u16 帧数 + u16 字节数 + 各通道一个 ad_codec 块；返回总字节数，0 = 失败 */
+static size_t encode_evnz(const int16_t *x, uint32_t frames, uint32_t nch, uint8_t *out, size_t cap, int track)
+{
+    size_t len = 0;
+    AD_Codec_Reset(&s_enc);
+    for (uint32_t f0 = 0; f0 < frames; f0 += AD_CODEC_BLOCK)
+    {
+        uint32_t cnt = (frames - f0 < AD_CODEC_BLOCK) ? frames - f0 : AD_CODEC_BLOCK;
+        if (cap - len < 4u)
+            return 0;
+        size_t head = len;
+        len += 4u;
+        for (uint32_t ch = 0; ch < nch; ch++)
+        {
+            for (uint32_t j = 0; j < cnt; j++)
+                s_enc.in[j] = x[(size_t)(f0 + j) * nch + ch];
+            if (track)
+                memset(&s_enc.st, 0, sizeof(s_enc.st));
+            uint32_t nb = AD_Codec_Encode(&s_enc, ch, s_enc.in, cnt, out + len, (uint32_t)(cap - len));
+            if (nb == 0u)
+                return 0;
+            if (track)
+            {
+                AD_CodecStats_t *st = &s_ch_st[ch];
+                if (st->blocks == 0u || s_enc.st.last_ratio < st->min_ratio)
+                    st->min_ratio = s_enc.st.last_ratio;
+                if (st->blocks == 0u || s_enc.st.last_ratio > st->max_ratio)
+                    st->max_ratio = s_enc.st.last_ratio;
+                st->blocks++;
+                st->samples += cnt;
+                st->bytes_out += nb;
+                st->fixed_blocks += s_enc.st.fixed_blocks;
+                st->escapes += s_enc.st.escapes;
+                for (int o = 0; o < 3; o++)
+                    st->order_hist[o] += s_enc.st.order_hist[o];
+            }
+            len += nb;
+        }
+        uint32_t body = (uint32_t)(len - head - 4u);
+        out[head] = (uint8_t)cnt;
+        out[head + 1u] = (uint8_t)(cnt >> 8);
+        out[head + 2u] = (uint8_t)body;
+        out[head + 3u] = (uint8_t)(body >> 8);
+    }
+    return len;
+}
+
+/* 解 EVNZ 数据区；返回解出的帧数（块长对不上或数据损坏时提前结束） */
+static uint32_t decode_evnz(const uint8_t *in, size_t len, uint32_t nch, int16_t *x, uint32_t max_frames)
+{
+    static int32_t tmp[AD_CODEC_BLOCK];
+    size_t pos = 0;
+    uint32_t frames = 0;
+
+    AD_Codec_Reset(&s_dec);
+    while (pos + 4u <= len)
+    {
+        uint32_t cnt = (uint32_t)in[pos] | ((uint32_t)in[pos + 1u] << 8);
+        uint32_t body = (uint32_t)in[pos + 2u] | ((uint32_t)in[pos + 3u] << 8);
+        pos += 4u;
+        if (cnt == 0u || cnt > AD_CODEC_BLOCK || frames + cnt > max_frames || pos + body > len)
+            break;
+        uint32_t used = 0;
+        for (uint32_t ch = 0; ch < nch; ch++)
+        {
+            uint32_t nb = AD_Codec_Decode(&s_dec, ch, in + pos + used, body - used, tmp, cnt);
+            if (nb == 0u)
+                return frames;
+            for (uint32_t j = 0; j < cnt; j++)
+                x[(size_t)(frames + j) * nch + ch] = (int16_t)tmp[j];
+            used += nb;
+        }
+        if (used != body)
+            return frames;
+        pos += body;
+        frames += cnt;
+    }
+    return frames;
+}
+
+/* 对照：1 阶差分 + zigzag + LEB128 varint */
+static size_t varint_size(const int16_t *x, uint32_t frames, uint32_t nch)
+{
+    size_t n = 0;
+    for (uint32_t ch = 0; ch < nch; ch++)
+    {
+        int32_t prev = 0;
+        for (uint32_t f = 0; f < frames; f++)
+        {
+            int32_t v = x[(size_t)f * nch + ch];
+            int32_t r = v - prev;
+            uint32_t z = ((uint32_t)r << 1) ^ (uint32_t)(r >> 31);
+            prev = v;
+            do
+            {
+                n++;
+                z >>= 7;
+            } while (z);
+        }
+    }
+    return n;
+}
+
+/* 编码 + 解码 + 逐点比对 + 计时；返回 1 = 无损 */
+static int bench_capture(const char *name, const int16_t *x, uint32_t frames, uint32_t nch)
+{
+    size_t raw = (size_t)frames * nch * sizeof(int16_t);
+    size_t cap = 4u * ((frames + AD_CODEC_BLOCK - 1u) / AD_CODEC_BLOCK) + (size_t)nch * AD_CODEC_WORST_BYTES(frames);
+    uint8_t *enc = malloc(cap);
+    int16_t *dec = malloc(raw);
+    if (!enc || !dec)
+    {
+        free(enc);
+        free(dec);
+        return 0;
+    }
+
+    memset(s_ch_st, 0, sizeof(s_ch_st));
+    size_t n = encode_evnz(x, frames, nch, enc, cap, 1);
+    uint32_t got = n ? decode_evnz(enc, n, nch, dec, frames) : 0u;
+    int ok = (n != 0u && got == frames && memcmp(x, dec, raw) == 0);
+
+    /* 吞吐：各自重复到 ≥ 0.2 s */
+    uint32_t reps = 0;
+    double t0 = now_ns();
+    double t;
+    do
+    {
+        (void)encode_evnz(x, frames, nch, enc, cap, 0);
+        reps++;
+        t = now_ns() - t0;
+    } while (t < 2e8);
+    double enc_mbs = (double)raw * reps / t * 1e3;
+    s_enc_ns += t / reps;
+    reps = 0;
+    t0 = now_ns();
+    do
+    {
+        (void)decode_evnz(enc, n, nch, dec, frames);
+        reps++;
+        t = now_ns() - t0;
+    } while (t < 2e8);
+    double dec_mbs = (double)raw * reps / t * 1e3;
+    s_dec_ns += t / reps;
+    s_bench_bytes += (double)raw;
+
+    size_t vb = varint_size(x, frames, nch);
+    s_total_raw += (double)raw;
+    s_total_enc += (double)n;
+    s_total_varint += (double)vb;
+
+    printf("%s: %u 通道 × %u 帧，%zu -> %zu 字节 x%.2f（varint x%.2f），编码 %.1f MB/s，解码 %.1f MB/s，%s\n", name,
+           (unsigned)nch, (unsigned)frames, raw, n, n ? (double)raw / n : 0.0, (double)raw / vb, enc_mbs, dec_mbs,
+           ok ? "无损" : "解码不一致");
+    for (uint32_t ch = 0; ch < nch; ch++)
+    {
+        const AD_CodecStats_t *st = &s_ch_st[ch];
+        printf("  ch%u: x%.2f（块 %.2f..%.2f），定宽块 %u/%u，逃逸 %u，预测阶 %u/%u/%u\n", (unsigned)ch,
+               (double)AD_Codec_Ratio(st), (double)st->min_ratio, (double)st->max_ratio, (unsigned)st->fixed_blocks,
+               (unsigned)st->blocks, (unsigned)st->escapes, (unsigned)st->order_hist[0], (unsigned)st->order_hist[1],
+               (unsigned)st->order_hist[2]);
+    }
+    free(enc);
+    free(dec);
+    return ok;
+}
+
+/* z = 0：写 EVNT（原样 int16）；z = 1：写 EVNZ */
+static int write_event(const char *path, const EventHeader_t *h, const int16_t *x, uint32_t frames, int z)
+{
+    char out[1024];
+    EventHeader_t hh = *h;
+    hh.magic = z ? EVENT_Z_MAGIC : EVENT_MAGIC;
+    hh.frames = frames;
+    snprintf(out, sizeof(out), "%s.%s", path, z ? "evnz" : "evnt");
+    FILE *f = fopen(out, "wb");
+    size_t n = (size_t)frames * h->channels;
+    int ok = f && fwrite(&hh, sizeof(hh), 1, f) == 1;
+    if (ok && z)
+    {
+        size_t cap =
+            4u * ((frames + AD_CODEC_BLOCK - 1u) / AD_CODEC_BLOCK) + (size_t)h->channels * AD_CODEC_WORST_BYTES(frames);
+        uint8_t *buf = malloc(cap);
+        size_t len = buf ? encode_evnz(x, frames, h->channels, buf, cap, 0) : 0u;
+        ok = len && fwrite(buf, 1, len, f) == len;
+        free(buf);
+    }
+    else if (ok)
+        ok = fwrite(x, sizeof(int16_t), n, f) == n;
+    if (f)
+        fclose(f);
+    printf("  -> %s%s\n", out, ok ? "" : "（写入失败）");
+    return ok;
+}
+
+/* 返回 1 = 通过，0 = 读不了，-1 = 不一致 */
+static int bench_event_file(const char *path, int to_evnt, int to_evnz)
+{
+    FILE *f = fopen(path, "rb");
+    EventHeader_t h;
+    if (!f)
+    {
+        fprintf(stderr, "%s: 打不开\n", path);
+        return 0;
+    }
+    if (fread(&h, sizeof(h), 1, f) != 1 || (h.magic != EVENT_MAGIC && h.magic != EVENT_Z_MAGIC) ||
+        h.channels == 0u || h.channels > MAX_CH || h.frames == 0u)
+    {
+        fprintf(stderr, "%s: 不是录波事件文件\n", path);
+        fclose(f);
+        return 0;
+    }
+    size_t total = (size_t)h.frames * h.channels;
+    int16_t *x = malloc(total * sizeof(int16_t));
+    if (!x)
+    {
+        fclose(f);
+        return 0;
+    }
+    uint32_t frames = h.frames;
+    if (h.magic == EVENT_MAGIC)
+    {
+        if (fread(x, sizeof(int16_t), total, f) != total)
+        {
+            fprintf(stderr, "%s: 数据不完整\n", path);
+            free(x);
+            fclose(f);
+            return 0;
+        }
+    }
+    else
+    {
+        long start = ftell(f);
+        fseek(f, 0, SEEK_END);
+        long end = ftell(f);
+        fseek(f, start, SEEK_SET);
+        size_t len = (size_t)(end - start);
+        uint8_t *z = malloc(len ? len : 1u);
+        if (!z || fread(z, 1, len, f) != len)
+        {
+            fprintf(stderr, "%s: 读取失败\n", path);
+            free(z);
+            free(x);
+            fclose(f);
+            return 0;
+        }
+        frames = decode_evnz(z, len, h.channels, x, h.frames);
+        printf("%s: EVNZ %zu 字节，解出 %u/%u 帧（文件内 x%.2f）\n", path, len, (unsigned)frames, (unsigned)h.frames,
+               (double)frames * h.channels * 2.0 / (double)len);
+        free(z);
+        if (frames == 0u)
+        {
+            free(x);
+            fclose(f);
+            return 0;
+        }
+        if (to_evnt)
+            (void)write_event(path, &h, x, frames, 0);
+    }
+    fclose(f);
+    if (h.magic == EVENT_MAGIC && to_evnz)
+        (void)write_event(path, &h, x, frames, 1);
+    int ok = bench_capture(path, x, frames, h.channels);
+    free(x);
+    return ok ? 1 : -1;
+}
+
+static int bench_synthetic(void)
+{
+    const uint32_t frames = 4096u * 8u;
+    const uint32_t nch = 4u;
+    const double fs = 25600.0;
+    int16_t *x = malloc((size_t)frames * nch * sizeof(int16_t));
+    if (!x)
+        return 0;
+
+    srand(1);
+    for (uint32_t f = 0; f < frames; f++)
+    {
+        double t = (double)f / fs;
+        double c[4];
+        /* 原始码：母线 ±（直流 + 100Hz 纹波）、负载电流（直流 + 100Hz + 10kHz 开关纹波）、漏电流（50Hz + 尖峰） */
+        c[0] = 20000.0 + 110.0 * sin(2.0 * M_PI * 100.0 * t) + 3.0 * gauss();
+        c[1] = -19700.0 + 110.0 * sin(2.0 * M_PI * 100.0 * t + 0.3) + 3.0 * gauss();
+        c[2] = 6000.0 + 150.0 * sin(2.0 * M_PI * 100.0 * t) + 40.0 * sin(2.0 * M_PI * 10000.0 * t) + 2.0 * gauss();
+        c[3] = 300.0 * sin(2.0 * M_PI * 50.0 * t) + 4.0 * gauss() + ((f % 9973u) < 6u ? 9000.0 : 0.0);
+        for (uint32_t ch = 0; ch < nch; ch++)
+            x[(size_t)f * nch + ch] = (int16_t)lrint(c[ch]);
+    }
+    int ok = bench_capture("合成录波", x, frames, nch);
+    free(x);
+    return ok ? 1 : -1;
+}
+
+int main(int argc, char **argv)
+{
+    int to_evnt = 0;
+    int to_evnz = 0;
+    int files = 0;
+    int bad = 0;
+    int any = 0;
+
+    AD_Codec_Init(&s_enc);
+    AD_Codec_Init(&s_dec);
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-d") == 0)
+        {
+            to_evnt = 1;
+            continue;
+        }
+        if (strcmp(argv[i], "-z") == 0)
+        {
+            to_evnz = 1;
+            continue;
+        }
+        files++;
+        int r = bench_event_file(argv[i], to_evnt, to_evnz);
+        any |= (r != 0);
+        bad |= (r < 0);
+    }
+    if (files == 0)
+    {
+        int r = bench_synthetic();
+        any = (r != 0);
+        bad = (r < 0);
+    }
+    if (!any)
+        return 1;
+
+    printf("\n合计：%.0f -> %.0f 字节 x%.2f（varint x%.2f），编码 %.1f MB/s，解码 %.1f MB/s，工作区 %u 字节/实例\n",
+           s_total_raw, s_total_enc, s_total_raw / s_total_enc, s_total_raw / s_total_varint,
+           s_bench_bytes / s_enc_ns * 1e3, s_bench_bytes / s_dec_ns * 1e3, (unsigned)sizeof(AD_Codec_t));
+    return bad ? 1 : 0;
+}
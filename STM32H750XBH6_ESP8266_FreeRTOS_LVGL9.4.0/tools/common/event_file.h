@@ -0,0 +1,138 @@
+#ifndef TOOLS_EVENT_FILE_H
+#define TOOLS_EVENT_FILE_H
+
+/*
+ * 主机工具共用：读取瞬态录波事件文件（SD 卡 0:/events/<日期>/evt_*.bin）
+ *   - EVNT：SD_EventHeader_t + frames × channels 个 int16 原始码（帧内按通道交织）
+ *   - EVNZ：文件头相同（仅 magic 不同），数据区为 sd_waveform.c 写出的压缩块，
+ *           用与固件同一份 Core/Src/ad_codec.c 解码；SD_EVENT_COMPRESS=1（默认）时固件只写这种
+ * 两种格式都还原成 EVNT 的内存布局交给调用方，工具本身不区分。
+ * 使用的工具编译时加 -Itools/common -ICore/Inc 并链接 Core/Src/ad_codec.c
+ * （fault_replay、class_check、fft_engine_bench）
+ */
+#include "ad_codec.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* 与 sd_waveform.h 中 SD_EventHeader_t 相同（小端、自然对齐） */
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t timestamp;
+    uint32_t seq;
+    uint32_t trig_frame;
+    uint32_t sample_rate;
+    uint32_t pre;
+    uint32_t post;
+    uint32_t frames;
+    uint8_t channels;
+    uint8_t trig_ch;
+    uint8_t trig_type;
+    uint8_t os_mode;
+    char fault_code[4];
+    uint8_t ch_id[8];
+    float scale[8];
+    float offset[8];
+} EventHeader_t;
+
+#define EVENT_MAGIC   0x544E5645u /* "EVNT" */
+#define EVENT_Z_MAGIC 0x5A4E5645u /* "EVNZ" */
+
+typedef enum
+{
+    EVT_OK = 0,
+    EVT_ERR_OPEN,    /* 打不开 */
+    EVT_ERR_FORMAT,  /* 不是录波事件文件 */
+    EVT_ERR_DATA,    /* 数据不完整（EVNT 短于文件头帧数，或 EVNZ 一块也解不出） */
+} EvtResult_t;
+
+/* 解 EVNZ 数据区；返回解出的帧数（块长对不上或数据损坏时提前结束，与固件“末尾不完整的块丢弃”一致） */
+static uint32_t Evt_DecodeZ(const uint8_t *in, size_t len, uint32_t nch, int16_t *x, uint32_t max_frames)
+{
+    static AD_Codec_t dec;
+    static int32_t tmp[AD_CODEC_BLOCK];
+    size_t pos = 0;
+    uint32_t frames = 0;
+
+    AD_Codec_Init(&dec);
+    while (pos + 4u <= len)
+    {
+        uint32_t cnt = (uint32_t)in[pos] | ((uint32_t)in[pos + 1u] << 8);
+        uint32_t body = (uint32_t)in[pos + 2u] | ((uint32_t)in[pos + 3u] << 8);
+        pos += 4u;
+        if (cnt == 0u || cnt > AD_CODEC_BLOCK || frames + cnt > max_frames || pos + body > len)
+            break;
+        uint32_t used = 0;
+        for (uint32_t ch = 0; ch < nch; ch++)
+        {
+            uint32_t nb = AD_Codec_Decode(&dec, ch, in + pos + used, body - used, tmp, cnt);
+            if (nb == 0u)
+                return frames;
+            for (uint32_t j = 0; j < cnt; j++)
+                x[(size_t)(frames + j) * nch + ch] = (int16_t)tmp[j];
+            used += nb;
+        }
+        if (used != body)
+            return frames;
+        pos += body;
+        frames += cnt;
+    }
+    return frames;
+}
+
+/*
+ * 读入整个事件文件：h = 文件头（h->frames 改为实际可用帧数），*x = frames × channels 个 int16（帧内交织，
+ * 调用方 free）；channels 须为 1..8。失败时 *x = NULL
+ */
+static EvtResult_t Evt_Load(const char *path, EventHeader_t *h, int16_t **x)
+{
+    FILE *f = fopen(path, "rb");
+
+    *x = NULL;
+    if (!f)
+        return EVT_ERR_OPEN;
+    if (fread(h, sizeof(*h), 1, f) != 1 || (h->magic != EVENT_MAGIC && h->magic != EVENT_Z_MAGIC) ||
+        h->channels == 0u || h->channels > 8u)
+    {
+        fclose(f);
+        return EVT_ERR_FORMAT;
+    }
+
+    size_t total = (size_t)h->frames * h->channels;
+    int16_t *buf = malloc(total ? total * sizeof(int16_t) : 1u);
+    EvtResult_t rc = buf ? EVT_OK : EVT_ERR_DATA;
+    if (rc == EVT_OK && h->magic == EVENT_MAGIC)
+    {
+        if (fread(buf, sizeof(int16_t), total, f) != total)
+            rc = EVT_ERR_DATA;
+    }
+    else if (rc == EVT_OK)
+    {
+        long start = ftell(f);
+        fseek(f, 0, SEEK_END);
+        long end = ftell(f);
+        fseek(f, start, SEEK_SET);
+        size_t len = (end > start) ? (size_t)(end - start) : 0u;
+        uint8_t *z = malloc(len ? len : 1u);
+        if (!z || fread(z, 1, len, f) != len)
+            rc = EVT_ERR_DATA;
+        else
+        {
+            h->frames = Evt_DecodeZ(z, len, h->channels, buf, h->frames);
+            if (h->frames == 0u)
+                rc = EVT_ERR_DATA;
+        }
+        free(z);
+    }
+    fclose(f);
+    if (rc != EVT_OK)
+    {
+        free(buf);
+        return rc;
+    }
+    *x = buf;
+    return EVT_OK;
+}
+
+#endif /* TOOLS_EVENT_FILE_H */
@@ -0,0 +1,224 @@
+/*
+ * AD7606 批量换算主机测试（MDK-ARM/HARDWORK/AD7606/ad7606_conv.c，与固件同一份代码）
+ *
+ * 固件里 AD7606_RawBlockToVoltsF / AD7606_RawBlockToQ15 只是按当前量程调用这里的内核，
+ * 以逐点换算 AD7606_ConvCodeToVoltsF（AD7606_RawToVoltsF 用的同一个函数）为基准，检查：
+ *   - 全部 65536 个原始码：gain = 1、offset = 0 时批量结果与逐点逐位相同；
+ *     满量程两端 -32768 -> -FS、+32767 -> FS - 1LSB
+ *   - 量程切换：RANGE = ±5V（2 × Vref）与 ±10V（4 × Vref），前端增益 1.0 / 0.5，各自与逐点一致
+ *   - 带通道增益与小数零点时与 (code - offset) × LSB × gain 的 double 值相差不超过 2 个 float ulp（相对满量程）
+ *   - 8 点展开的尾部（n 不是 8 的倍数）与非 4 字节对齐的输入
+ *   - Q15：扣整数零点、增益缩放、饱和到 int16，与逐点换算最多差 1 LSB；满量程加零点/增益溢出时饱和不回绕；
+ *     dst 与 src 相同（就地）结果不变；q15 × 满量程/32768 / 前端增益与同参数的 VoltsF 一致（两个量程都验）
+ *
+ * 编译（在工程根目录，CMSIS 源文件同 stats_bench.c）：
+ *   D=MDK-ARM/HARDWORK/CMSIS-DSP/1.16.2
+ *   gcc -O2 -Wall -D__GNUC_PYTHON__ -ffunction-sections -fdata-sections -Wl,--gc-sections \
+ *       -IMDK-ARM/HARDWORK/AD7606 -I$D/Include -I$D/PrivateInclude \
+ *       tools/conv_check/conv_check.c MDK-ARM/HARDWORK/AD7606/ad7606_conv.c \
+ *       $D/Source/BasicMathFunctions/BasicMathFunctions.c $D/Source/SupportFunctions/SupportFunctions.c \
+ *       -lm -o conv_check
+ * 用法：./conv_check
+ * 全部通过返回 0
+ */
+#include "ad7606_conv.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define VREF  2.5f   /* AD7606_VREF_VOLTS */
+#define NCODE 65536u
+
+static int16_t s_code[NCODE + 8u];
+static int16_t s_q15[NCODE + 8u];
+static float s_volt[NCODE + 8u];
+static int g_fails;
+
+static void check(const char *name, int ok)
+{
+    printf("  %-60s %s\n", name, ok ? "PASS" : "FAIL");
+    if (!ok)
+        g_fails++;
+}
+
+/* s_code[base + i] = -32768 + i，共 n 个 */
+static const int16_t *codes(uint32_t base, uint32_t n)
+{
+    for (uint32_t i = 0; i < n; i++)
+        s_code[base + i] = (int16_t)(-32768 + (int32_t)i);
+    return &s_code[base];
+}
+
+static int32_t sat16(double v)
+{
+    return (v > 32767.0) ? 32767 : ((v < -32768.0) ? -32768 : (int32_t)v);
+}
+
+/* 批量 VoltsF 对逐点：gain = 1 / offset = 0 逐位相同，否则对 double 值的误差在 2 ulp（满量程）内 */
+static void test_volts(float fs_v, float fe_gain)
+{
+    char name[96];
+
+    /* 全部原始码，对齐输入，n = 65536（8 的倍数） */
+    const int16_t *src = codes(0u, NCODE);
+    AD7606_ConvBlockToVoltsF(src, s_volt, NCODE, fs_v, fe_gain, 1.0f, 0.0f);
+    uint32_t bad = 0;
+    for (uint32_t i = 0; i < NCODE; i++)
+    {
+        if (s_volt[i] != AD7606_ConvCodeToVoltsF(src[i], fs_v, fe_gain))
+            bad++;
+    }
+    snprintf(name, sizeof(name), "all codes == scalar (bit exact), %u mismatches", (unsigned)bad);
+    check(name, bad == 0u);
+    check("-32768 -> -FS / fe_gain", s_volt[0] == -fs_v / fe_gain);
+    check("+32767 -> (FS - 1LSB) / fe_gain", s_volt[NCODE - 1u] == (fs_v - fs_v / 32768.0f) / fe_gain);
+    check("0 -> 0", s_volt[32768] == 0.0f);
+
+    /* 奇数起点（非 4 字节对齐）+ 非 8 倍数长度 */
+    static const uint32_t lens[] = {1u, 7u, 9u, 15u, 4099u};
+    for (uint32_t l = 0; l < sizeof(lens) / sizeof(lens[0]); l++)
+    {
+        const int16_t *u = codes(1u, lens[l]);
+        memset(s_volt, 0, sizeof(s_volt));
+        s_volt[lens[l]] = 12345.0f;
+        AD7606_ConvBlockToVoltsF(u, s_volt, lens[l], fs_v, fe_gain, 1.0f, 0.0f);
+        int ok = s_volt[lens[l]] == 12345.0f; /* 不越界写 */
+        for (uint32_t i = 0; i < lens[l]; i++)
+            ok &= s_volt[i] == AD7606_ConvCodeToVoltsF(u[i], fs_v, fe_gain);
+        snprintf(name, sizeof(name), "unaligned src, n = %u (tail), no overrun", (unsigned)lens[l]);
+        check(name, ok);
+    }
+
+    /* 通道增益 + 小数零点（标定表的典型值） */
+    static const struct
+    {
+        float gain;
+        float offset;
+    } gc[] = {{0.98468f, -3.5f}, {1.0f, 12.25f}, {100.0f, 0.4f}, {0.001f, -32768.0f}};
+    for (uint32_t g = 0; g < sizeof(gc) / sizeof(gc[0]); g++)
+    {
+        src = codes(0u, NCODE);
+        AD7606_ConvBlockToVoltsF(src, s_volt, NCODE, fs_v, fe_gain, gc[g].gain, gc[g].offset);
+        double worst = 0.0;
+        for (uint32_t i = 0; i < NCODE; i++)
+        {
+            double ref = ((double)src[i] - gc[g].offset) * (double)fs_v / 32768.0 / fe_gain * gc[g].gain;
+            double e = fabs((double)s_volt[i] - ref);
+            if (e > worst)
+                worst = e;
+        }
+        double tol = 2.0 * ldexp((double)fs_v / fe_gain * fabs(gc[g].gain), -23);
+        snprintf(name, sizeof(name), "gain %g offset %g: max err %.2e (<= %.2e)", (double)gc[g].gain,
+                 (double)gc[g].offset, worst, tol);
+        check(name, worst <= tol);
+    }
+}
+
+/* 批量 Q15 对逐点：(code - round(offset)) × gain，饱和；arm_scale_q15 截断，允许 1 LSB */
+static void test_q15(void)
+{
+    char name[96];
+    static const struct
+    {
+        float gain;
+        float offset;
+    } gc[] = {{1.0f, 0.0f}, {1.0f, -3.5f}, {1.0f, 3.4f}, {1.0f, 100.0f}, {1.0f, -100.0f},
+              {0.5f, 0.0f}, {0.98468f, -3.5f}, {2.5f, 7.0f}, {1.5f, -0.6f}, {0.0f, 5.0f}, {-1.0f, 0.0f}};
+
+    for (uint32_t g = 0; g < sizeof(gc) / sizeof(gc[0]); g++)
+    {
+        const int16_t *src = codes(0u, NCODE);
+        AD7606_ConvBlockToQ15(src, s_q15, NCODE, gc[g].gain, gc[g].offset);
+        double o = gc[g].offset; /* 零点按整数 LSB（.5 远离 0） */
+        double off = (o >= 0.0) ? floor(o + 0.5) : ceil(o - 0.5);
+        double gain = (gc[g].gain < 0.0f) ? 0.0 : gc[g].gain;
+        int32_t worst = 0;
+        for (uint32_t i = 0; i < NCODE; i++)
+        {
+            double shifted = (double)sat16((double)src[i] - off); /* arm_offset_q15 先饱和 */
+            int32_t want = sat16(floor(shifted * gain));
+            int32_t e = abs((int32_t)s_q15[i] - want);
+            if (e > worst)
+                worst = e;
+        }
+        snprintf(name, sizeof(name), "q15 gain %g offset %g: max err %d LSB", (double)gc[g].gain,
+                 (double)gc[g].offset, (int)worst);
+        check(name, worst <= 1);
+    }
+
+    /* 满量程边界饱和（不回绕） */
+    int16_t fs[4] = {32767, -32768, 32767, -32768};
+    AD7606_ConvBlockToQ15(fs, s_q15, 4u, 1.0f, -100.0f);
+    check("+FS with offset -100 saturates at 32767", s_q15[0] == 32767 && s_q15[2] == 32767);
+    AD7606_ConvBlockToQ15(fs, s_q15, 4u, 1.0f, 100.0f);
+    check("-FS with offset +100 saturates at -32768", s_q15[1] == -32768 && s_q15[3] == -32768);
+    AD7606_ConvBlockToQ15(fs, s_q15, 4u, 3.0f, 0.0f);
+    check("gain 3 on full scale saturates both ends",
+          s_q15[0] == 32767 && s_q15[1] == -32768 && s_q15[2] == 32767 && s_q15[3] == -32768);
+
+    /* 就地：dst == src */
+    const int16_t *src = codes(0u, NCODE);
+    AD7606_ConvBlockToQ15(src, s_q15, NCODE, 0.98468f, -3.5f);
+    AD7606_ConvBlockToQ15(s_code, s_code, NCODE, 0.98468f, -3.5f);
+    check("in place (dst == src) matches out of place", memcmp(s_code, s_q15, NCODE * sizeof(int16_t)) == 0);
+
+    /* 非对齐 + 尾部 */
+    src = codes(1u, 4099u);
+    s_q15[4099] = 0x1234;
+    AD7606_ConvBlockToQ15(src, s_q15, 4099u, 0.75f, 2.0f);
+    int ok = s_q15[4099] == 0x1234;
+    for (uint32_t i = 0; i < 4099u; i++)
+        ok &= abs((int32_t)s_q15[i] - sat16(floor(sat16((double)src[i] - 2.0) * 0.75))) <= 1;
+    check("q15 unaligned src, n = 4099, no overrun", ok);
+}
+
+/* 量程切换：q15 与量程无关，乘当前量程的 LSB 后应与同参数 VoltsF 一致 */
+static void test_q15_vs_volts(float fs_v, float fe_gain)
+{
+    char name[96];
+    const float gain = 1.0f;
+    const float offset = -3.0f; /* 整数零点：两条路径的零点相同 */
+    const double lsb = (double)fs_v / 32768.0 / fe_gain;
+
+    const int16_t *src = codes(0u, NCODE);
+    AD7606_ConvBlockToQ15(src, s_q15, NCODE, gain, offset);
+    AD7606_ConvBlockToVoltsF(src, s_volt, NCODE, fs_v, fe_gain, gain, offset);
+    double worst = 0.0;
+    for (uint32_t i = 0; i < NCODE - 4u; i++) /* 末尾 3 个码在 q15 里饱和，VoltsF 不饱和 */
+    {
+        double e = fabs((double)s_q15[i] * lsb - (double)s_volt[i]);
+        if (e > worst)
+            worst = e;
+    }
+    snprintf(name, sizeof(name), "q15 x LSB == VoltsF: max err %.2e V (<= 1e-3 LSB)", worst);
+    check(name, worst <= 1e-3 * lsb);
+    check("q15 saturates where VoltsF exceeds +FS", s_q15[NCODE - 1u] == 32767 && s_volt[NCODE - 1u] > fs_v / fe_gain - lsb);
+}
+
+int main(void)
+{
+    static const struct
+    {
+        const char *name;
+        float fs_v;
+        float fe_gain;
+    } ranges[] = {
+        {"RANGE +-10V (4 x Vref), front-end 1.0", 4.0f * VREF, 1.0f},
+        {"RANGE +-5V (2 x Vref), front-end 1.0", 2.0f * VREF, 1.0f},
+        {"RANGE +-10V, front-end 0.5 (1/2 divider)", 4.0f * VREF, 0.5f},
+        {"RANGE +-5V, front-end 0.5", 2.0f * VREF, 0.5f},
+    };
+
+    for (uint32_t r = 0; r < sizeof(ranges) / sizeof(ranges[0]); r++)
+    {
+        printf("%s:\n", ranges[r].name);
+        test_volts(ranges[r].fs_v, ranges[r].fe_gain);
+        test_q15_vs_volts(ranges[r].fs_v, ranges[r].fe_gain);
+    }
+    printf("Q15:\n");
+    test_q15();
+
+    printf("%s\n", g_fails ? "FAILED" : "ALL PASS");
+    return g_fails ? 1 : 0;
+}
@@ -0,0 +1,259 @@
+/*
+ * 频谱引擎主机对比：F32 / Q15 / Q31（与 Core/Src/ad_dsp.c 的 AD_DSP_FFT_ENGINE 三条路径同一算法、同一标度）
+ *
+ * 输入：瞬态录波事件文件（SD 卡 0:/events/<日期>/evt_*.bin，EVNT 原样或 EVNZ 压缩，见 tools/common/event_file.h）；
+ *       不给文件时用合成波形（直流 + 50Hz 及谐波 + 白噪声，幅度从满量程到 0.1% 满量程各一组）。
+ * 输出：每个引擎相对双精度参考谱的 SNR（dB，bin 1..N/2-1）、主机上单次耗时、工作区内存。
+ *       主机耗时只用于相对比较；目标板上的 Cortex-M7 周期数看串口 [DSP] 行的 fft(...)=cyc。
+ *
+ * 编译（在工程根目录）：
+ *   D=MDK-ARM/HARDWORK/CMSIS-DSP/1.16.2
+ *   gcc -O2 -D__GNUC_PYTHON__ -ffunction-sections -fdata-sections -Wl,--gc-sections \
+ *       -ICore/Inc -Itools/common -I$D/Include -I$D/PrivateInclude $(for x in $D/Source/[A-Z]*; do echo -I$x; done) \
+ *       tools/dsp_bench/fft_engine_bench.c Core/Src/ad_codec.c \
+ *       $D/Source/TransformFunctions/TransformFunctions.c $D/Source/CommonTables/CommonTables.c \
+ *       $D/Source/ComplexMathFunctions/ComplexMathFunctions.c $D/Source/BasicMathFunctions/BasicMathFunctions.c \
+ *       $D/Source/SupportFunctions/SupportFunctions.c $D/Source/FastMathFunctions/FastMathFunctions.c \
+ *       -lm -o fft_engine_bench
+ *   仓库里的 1.16.2 快照缺 CommonTables/arm_common_tables.c 时：追加 -IDrivers/CMSIS/DSP/Source/CommonTables，
+ *   并把 FastMathFunctions.c 换成 Drivers/CMSIS/DSP/Source/FastMathFunctions/arm_sqrt_q15.c、arm_sqrt_q31.c
+ *
+ * 用法：./fft_engine_bench [evt_xxx.bin ...]
+ */
+#include "arm_math.h"
+#include "event_file.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define N    4096u
+#define BINS (N / 2u)
+
+typedef struct {
+    const char *name;
+    double err2;
+    double ref2;
+    double ns;
+    uint32_t runs;
+    uint32_t mem_bytes;
+} Engine_t;
+
+enum { ENG_F32 = 0, ENG_Q15, ENG_Q31, ENG_COUNT };
+
+static Engine_t s_eng[ENG_COUNT] = {
+    {"f32", 0, 0, 0, 0, (N + N) * sizeof(float32_t)},
+    {"q15", 0, 0, 0, 0, (N + 2u * N) * sizeof(q15_t)},
+    {"q31", 0, 0, 0, 0, (N + 2u * N) * sizeof(q31_t)},
+};
+
+static arm_rfft_fast_instance_f32 s_rf32;
+static arm_rfft_instance_q15 s_rq15;
+static arm_rfft_instance_q31 s_rq31;
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+/* 双精度参考：迭代基 2 FFT，输出单边幅值谱（与引擎同标度 |X|/(N/2)×2） */
+static void ref_spectrum(const double *x, double *spec)
+{
+    static double re[N], im[N];
+    for (uint32_t i = 0; i < N; i++)
+    {
+        uint32_t j = 0;
+        for (uint32_t b = 1; b < N; b <<= 1)
+            j = (j << 1) | ((i & b) ? 1u : 0u);
+        re[j] = x[i];
+        im[j] = 0.0;
+    }
+    for (uint32_t len = 2; len <= N; len <<= 1)
+    {
+        double ang = -2.0 * M_PI / (double)len;
+        for (uint32_t i = 0; i < N; i += len)
+        {
+            for (uint32_t k = 0; k < len / 2u; k++)
+            {
+                double wr = cos(ang * k), wi = sin(ang * k);
+                uint32_t a = i + k, b = i + k + len / 2u;
+                double tr = re[b] * wr - im[b] * wi;
+                double ti = re[b] * wi + im[b] * wr;
+                re[b] = re[a] - tr;
+                im[b] = im[a] - ti;
+                re[a] += tr;
+                im[a] += ti;
+            }
+        }
+    }
+    spec[0] = 0.0;
+    for (uint32_t k = 1; k < BINS; k++)
+        spec[k] = 4.0 * sqrt(re[k] * re[k] + im[k] * im[k]) / (double)N;
+}
+
+static void eng_f32(const int16_t *code, float scale, float offset, float *spec)
+{
+    static float32_t in[N], out[N];
+    for (uint32_t i = 0; i < N; i++)
+        in[i] = ((float)code[i] - offset) * scale;
+    arm_rfft_fast_f32(&s_rf32, in, out, 0);
+    arm_cmplx_mag_f32(out, spec, BINS);
+    arm_scale_f32(spec, 2.0f / (float)BINS, spec, BINS);
+    spec[0] = 0.0f;
+}
+
+static void eng_q15(const int16_t *code, float scale, float offset, float *spec)
+{
+    static q15_t in[N], out[2u * N];
+    q15_t off = (q15_t)lrintf(offset);
+    arm_offset_q15((const q15_t *)code, (q15_t)-off, in, N);
+    arm_rfft_q15(&s_rq15, in, out);
+    arm_cmplx_mag_q15(out, in, BINS);
+    arm_q15_to_float(in, spec, BINS);
+    arm_scale_f32(spec, 8.0f * scale * 32768.0f, spec, BINS);
+    spec[0] = 0.0f;
+}
+
+static void eng_q31(const int16_t *code, float scale, float offset, float *spec)
+{
+    static q31_t in[N], out[2u * N];
+    q15_t *tmp = (q15_t *)&out[N];
+    q15_t off = (q15_t)lrintf(offset);
+    arm_offset_q15((const q15_t *)code, (q15_t)-off, tmp, N);
+    arm_q15_to_q31(tmp, in, N);
+    arm_rfft_q31(&s_rq31, in, out);
+    arm_cmplx_mag_q31(out, in, BINS);
+    arm_q31_to_float(in, spec, BINS);
+    arm_scale_f32(spec, 8.0f * scale * 32768.0f, spec, BINS);
+    spec[0] = 0.0f;
+}
+
+typedef void (*eng_fn_t)(const int16_t *, float, float, float *);
+static const eng_fn_t s_fn[ENG_COUNT] = {eng_f32, eng_q15, eng_q31};
+
+/* 一个 N 点窗口：三个引擎各跑一次，累计误差能量与耗时 */
+static void bench_window(const int16_t *code, float scale, float offset)
+{
+    static double x[N], ref[BINS];
+    static float spec[BINS];
+
+    for (uint32_t i = 0; i < N; i++)
+        x[i] = ((double)code[i] - (double)offset) * (double)scale;
+    ref_spectrum(x, ref);
+
+    for (int e = 0; e < ENG_COUNT; e++)
+    {
+        double t0 = now_ns();
+        s_fn[e](code, scale, offset, spec);
+        s_eng[e].ns += now_ns() - t0;
+        s_eng[e].runs++;
+        for (uint32_t k = 1; k < BINS; k++)
+        {
+            double d = (double)spec[k] - ref[k];
+            s_eng[e].err2 += d * d;
+            s_eng[e].ref2 += ref[k] * ref[k];
+        }
+    }
+}
+
+static int bench_event_file(const char *path)
+{
+    EventHeader_t h;
+    int16_t *frames;
+    EvtResult_t rc = Evt_Load(path, &h, &frames);
+    if (rc != EVT_OK)
+    {
+        fprintf(stderr, "%s: %s\n", path,
+                rc == EVT_ERR_OPEN ? "打不开" : (rc == EVT_ERR_FORMAT ? "不是录波事件文件" : "数据不完整"));
+        return 0;
+    }
+    int16_t *col = malloc(N * sizeof(int16_t));
+    if (!col)
+    {
+        free(frames);
+        return 0;
+    }
+
+    uint32_t windows = 0;
+    for (uint32_t ch = 0; ch < h.channels; ch++)
+    {
+        for (uint32_t s = 0; s + N <= h.frames; s += N)
+        {
+            for (uint32_t i = 0; i < N; i++)
+                col[i] = frames[(size_t)(s + i) * h.channels + ch];
+            bench_window(col, h.scale[ch], h.offset[ch]);
+            windows++;
+        }
+    }
+    printf("%s: %u 通道 × %u 帧 @ %uHz，%u 个 %u 点窗口\n", path, (unsigned)h.channels, (unsigned)h.frames,
+           (unsigned)h.sample_rate, (unsigned)windows, (unsigned)N);
+    free(frames);
+    free(col);
+    return windows != 0u;
+}
+
+static void bench_synthetic(void)
+{
+    static int16_t code[N];
+    const double fs = 25600.0;
+    const double levels[] = {1.0, 0.1, 0.01, 0.001}; /* 相对满量程的交流幅度 */
+    const float scale = 10.0f / 32768.0f;             /* ±10V 档 */
+    const float offset = 3.0f;
+
+    srand(1);
+    for (size_t l = 0; l < sizeof(levels) / sizeof(levels[0]); l++)
+    {
+        for (uint32_t i = 0; i < N; i++)
+        {
+            double t = (double)i / fs;
+            double v = 0.2 + levels[l] * 0.7 * (sin(2.0 * M_PI * 50.0 * t) + 0.2 * sin(2.0 * M_PI * 150.0 * t) +
+                                               0.05 * sin(2.0 * M_PI * 1250.0 * t));
+            double c = v * 32767.0 + offset + ((double)rand() / RAND_MAX - 0.5) * 2.0;
+            code[i] = (int16_t)lrint(c > 32767.0 ? 32767.0 : (c < -32768.0 ? -32768.0 : c));
+        }
+        bench_window(code, scale, offset);
+        printf("合成波形 交流幅度 %.1f%% 满量程：", levels[l] * 100.0);
+        for (int e = 0; e < ENG_COUNT; e++)
+        {
+            printf(" %s %.1fdB", s_eng[e].name, 10.0 * log10(s_eng[e].ref2 / (s_eng[e].err2 + 1e-30)));
+            s_eng[e].err2 = 0;
+            s_eng[e].ref2 = 0;
+        }
+        printf("\n");
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int any = 0;
+
+    arm_rfft_fast_init_f32(&s_rf32, N);
+    arm_rfft_init_q15(&s_rq15, N, 0, 1);
+    arm_rfft_init_q31(&s_rq31, N, 0, 1);
+
+    if (argc < 2)
+    {
+        bench_synthetic();
+        any = 1;
+    }
+    for (int i = 1; i < argc; i++)
+        any |= bench_event_file(argv[i]);
+    if (!any)
+        return 1;
+
+    printf("\n引擎  SNR(dB)  主机耗时(us/次)  工作区(字节)\n");
+    for (int e = 0; e < ENG_COUNT; e++)
+    {
+        double snr = (s_eng[e].ref2 > 0.0) ? 10.0 * log10(s_eng[e].ref2 / (s_eng[e].err2 + 1e-30)) : 0.0;
+        double us = s_eng[e].ns / 1000.0 / (double)(s_eng[e].runs ? s_eng[e].runs : 1u);
+        if (argc < 2)
+            printf("%-4s  %7s  %15.2f  %12u\n", s_eng[e].name, "-", us, (unsigned)s_eng[e].mem_bytes);
+        else
+            printf("%-4s  %7.1f  %15.2f  %12u\n", s_eng[e].name, snr, us, (unsigned)s_eng[e].mem_bytes);
+    }
+    if (argc < 2)
+        printf("（合成波形的 SNR 见上面分档结果）\n");
+    return 0;
+}
@@ -0,0 +1,117 @@
+/*
+ * 成对频谱内核主机对比：逐通道 rfft（原做法） vs 两通道打包一次复 FFT（Core/Src/ad_spec.c）
+ *
+ * 对 2/4/8 通道各跑若干块合成波形（各通道频率/幅度/直流不同 + 噪声），输出：
+ *   - 两种做法每块的主机耗时与加速比（只作相对比较；目标板周期数见 AD_DSP_SPEC_BENCH 的 [DSP] bench 行）
+ *   - 幅值谱最大偏差（相对该通道谱峰）与逐位相同的 bin 比例
+ *
+ * 编译（在工程根目录，CMSIS 源文件同 fft_engine_bench.c）：
+ *   D=MDK-ARM/HARDWORK/CMSIS-DSP/1.16.2
+ *   gcc -O2 -D__GNUC_PYTHON__ -ffunction-sections -fdata-sections -Wl,--gc-sections \
+ *       -ICore/Inc -I$D/Include -I$D/PrivateInclude $(for x in $D/Source/[A-Z]*; do echo -I$x; done) \
+ *       tools/dsp_bench/spec_pair_bench.c Core/Src/ad_spec.c \
+ *       $D/Source/TransformFunctions/TransformFunctions.c $D/Source/CommonTables/CommonTables.c \
+ *       $D/Source/ComplexMathFunctions/ComplexMathFunctions.c $D/Source/BasicMathFunctions/BasicMathFunctions.c \
+ *       $D/Source/SupportFunctions/SupportFunctions.c $D/Source/FastMathFunctions/FastMathFunctions.c \
+ *       -lm -o spec_pair_bench
+ *
+ * 用法：./spec_pair_bench [块数，默认 200]
+ */
+#include "ad_spec.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define N       4096u
+#define BINS    (N / 2u)
+#define MAX_CH  8u
+
+static float32_t s_work[2u * N];
+static float32_t s_wave[MAX_CH][N];
+static float32_t s_ref[MAX_CH][BINS];
+static float32_t s_pair[MAX_CH][BINS];
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static void make_block(uint32_t nch, uint32_t blk)
+{
+    for (uint32_t ch = 0; ch < nch; ch++)
+    {
+        double f = 50.0 * (1.0 + ch) + 0.37 * blk;
+        double amp = 1.0 / (1.0 + ch);
+        for (uint32_t i = 0; i < N; i++)
+        {
+            double t = (double)i / 25600.0;
+            s_wave[ch][i] = (float32_t)(0.1 * ch + amp * sin(2.0 * M_PI * f * t) +
+                                        0.2 * amp * sin(2.0 * M_PI * 3.0 * f * t + ch) +
+                                        1e-3 * ((double)rand() / RAND_MAX - 0.5));
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    static const uint32_t nchs[] = {2u, 4u, 8u};
+    uint32_t blocks = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 0) : 200u;
+    const float32_t scale = 2.0f / (float32_t)BINS;
+    AD_SpecKernel_t k;
+    const float32_t *in[MAX_CH];
+    float32_t *out[MAX_CH];
+
+    if (blocks == 0u || !AD_Spec_Init(&k, N, s_work))
+        return 1;
+    for (uint32_t ch = 0; ch < MAX_CH; ch++)
+    {
+        in[ch] = s_wave[ch];
+        out[ch] = s_pair[ch];
+    }
+
+    printf("通道  逐通道(us/块)  成对(us/块)  加速比  最大偏差/谱峰  逐位相同\n");
+    for (size_t c = 0; c < sizeof(nchs) / sizeof(nchs[0]); c++)
+    {
+        uint32_t nch = nchs[c];
+        double t_ref = 0.0, t_pair = 0.0, worst = 0.0;
+        uint64_t same = 0, total = 0;
+
+        srand(1);
+        for (uint32_t b = 0; b < blocks; b++)
+        {
+            make_block(nch, b);
+
+            double t0 = now_ns();
+            for (uint32_t ch = 0; ch < nch; ch++)
+                AD_Spec_MagSingle(&k, s_wave[ch], s_ref[ch], scale);
+            double t1 = now_ns();
+            AD_Spec_MagMulti(&k, in, out, nch, scale);
+            double t2 = now_ns();
+            t_ref += t1 - t0;
+            t_pair += t2 - t1;
+
+            for (uint32_t ch = 0; ch < nch; ch++)
+            {
+                double peak = 0.0, diff = 0.0;
+                for (uint32_t i = 0; i < BINS; i++)
+                {
+                    double d = fabs((double)s_pair[ch][i] - (double)s_ref[ch][i]);
+                    if (s_ref[ch][i] > peak)
+                        peak = s_ref[ch][i];
+                    if (d > diff)
+                        diff = d;
+                    same += (memcmp(&s_pair[ch][i], &s_ref[ch][i], sizeof(float32_t)) == 0);
+                    total++;
+                }
+                if (peak > 0.0 && diff / peak > worst)
+                    worst = diff / peak;
+            }
+        }
+        printf("%4u  %13.1f  %11.1f  %6.2f  %13.2e  %7.1f%%\n", (unsigned)nch, t_ref / 1000.0 / blocks,
+               t_pair / 1000.0 / blocks, t_ref / t_pair, worst, 100.0 * (double)same / (double)total);
+    }
+    return 0;
+}
@@ -0,0 +1,182 @@
+/*
+ * 单趟统计内核主机对比：arm_mean/arm_rms/arm_min/arm_max 四趟（原做法） vs AD_Stats_ComputeRef 一趟（Core/Src/ad_stats.c）
+ *
+ * 五类合成波形各跑若干块（4096 点）：
+ *   dcbus  : 700V 直流 + 5V 50Hz/150Hz 纹波 + 噪声（大直流小纹波，考验累加精度）
+ *   leak   : 零均值小噪声 + 稀疏尖峰（漏电流，考验峭度/峰值因数）
+ *   sine   : 零均值正弦（峰值因数 √2、峭度 1.5 的理论值可直接核对）
+ *   dcspk  : dcbus，但块首是 +60V 尖峰
+ *   lkspk  : leak，但块首是尖峰
+ * 内核按固件用法逐块传上一块均值作基准点（首块自选）；另以块首 x[0] 作基准跑一遍（旧做法），
+ * 对比块首尖峰时 std/kurt 的精度。
+ * 输出：两种做法每块的主机耗时（只作相对比较；目标板周期数见 [DSP] 行的 stats=）、
+ *       各统计量相对 double 参考值的最大相对误差，以及内核算出的 crest/skew/kurt
+ *
+ * 编译（在工程根目录，CMSIS 源文件同 fft_engine_bench.c）：
+ *   D=MDK-ARM/HARDWORK/CMSIS-DSP/1.16.2
+ *   gcc -O2 -D__GNUC_PYTHON__ -ffunction-sections -fdata-sections -Wl,--gc-sections \
+ *       -ICore/Inc -I$D/Include -I$D/PrivateInclude $(for x in $D/Source/[A-Z]*; do echo -I$x; done) \
+ *       tools/dsp_bench/stats_bench.c Core/Src/ad_stats.c \
+ *       $D/Source/StatisticsFunctions/StatisticsFunctions.c $D/Source/FastMathFunctions/FastMathFunctions.c \
+ *       $D/Source/BasicMathFunctions/BasicMathFunctions.c $D/Source/CommonTables/CommonTables.c \
+ *       -lm -o stats_bench
+ *
+ * 用法：./stats_bench [块数，默认 500]
+ */
+#include "ad_stats.h"
+#include "arm_math.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define N 4096u
+
+static float32_t s_x[N];
+
+typedef struct
+{
+    double mean, rms, min, max, std, crest, skew, kurt;
+} RefStats_t;
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static double noise(void)
+{
+    return (double)rand() / RAND_MAX - 0.5;
+}
+
+static void make_block(int kind, uint32_t blk)
+{
+    int base = (kind == 3) ? 0 : ((kind == 4) ? 1 : kind); /* 块首尖峰两类的底波形 */
+    for (uint32_t i = 0; i < N; i++)
+    {
+        double t = (double)i / 25600.0;
+        double ph = 0.13 * blk;
+        double v;
+        if (base == 0)
+            v = 700.0 + 5.0 * sin(2.0 * M_PI * 50.0 * t + ph) + 1.5 * sin(2.0 * M_PI * 150.0 * t) + 0.05 * noise();
+        else if (base == 1)
+            v = 0.002 * noise() + (((rand() % 512) == 0) ? 0.05 : 0.0);
+        else
+            v = 2.0 * sin(2.0 * M_PI * 50.0 * t + ph);
+        s_x[i] = (float32_t)v;
+    }
+    if (kind == 3)
+        s_x[0] += 60.0f;
+    else if (kind == 4)
+        s_x[0] += 0.05f;
+}
+
+/* 两趟 double 参考值 */
+static void ref_stats(const float32_t *x, RefStats_t *r)
+{
+    double s = 0.0, sq = 0.0, m2 = 0.0, m3 = 0.0, m4 = 0.0;
+    r->min = r->max = x[0];
+    for (uint32_t i = 0; i < N; i++)
+    {
+        s += x[i];
+        sq += (double)x[i] * x[i];
+        if (x[i] < r->min)
+            r->min = x[i];
+        if (x[i] > r->max)
+            r->max = x[i];
+    }
+    r->mean = s / N;
+    r->rms = sqrt(sq / N);
+    for (uint32_t i = 0; i < N; i++)
+    {
+        double d = x[i] - r->mean;
+        m2 += d * d;
+        m3 += d * d * d;
+        m4 += d * d * d * d;
+    }
+    m2 /= N;
+    m3 /= N;
+    m4 /= N;
+    r->std = sqrt(m2);
+    r->crest = fmax(fabs(r->min), fabs(r->max)) / r->rms;
+    r->skew = (m2 > 0.0) ? m3 / (m2 * r->std) : 0.0;
+    r->kurt = (m2 > 0.0) ? m4 / (m2 * m2) : 0.0;
+}
+
+/* 相对误差；参考值接近 0 时（均值/偏度）按 1 归一化 */
+static double rel(double v, double ref)
+{
+    double d = fabs(v - ref);
+    return d / fmax(fabs(ref), 1.0);
+}
+
+static void upd(double *worst, double e)
+{
+    if (e > *worst)
+        *worst = e;
+}
+
+int main(int argc, char **argv)
+{
+    static const char *names[] = {"dcbus", "leak", "sine", "dcspk", "lkspk"};
+    uint32_t blocks = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 0) : 500u;
+    volatile float32_t sink = 0.0f;
+
+    if (blocks == 0u)
+        return 1;
+
+    printf("波形    四趟(us/块)  单趟(us/块)  加速比  |  最大相对误差: mean(arm)  mean   rms(arm)  rms    std    kurt   "
+           "std(x0)  kurt(x0)  |  crest  skew   kurt\n");
+    for (int kind = 0; kind < 5; kind++)
+    {
+        double t_ref = 0.0, t_one = 0.0;
+        double e_mean_a = 0.0, e_mean = 0.0, e_rms_a = 0.0, e_rms = 0.0, e_std = 0.0, e_kurt = 0.0;
+        double e_std0 = 0.0, e_kurt0 = 0.0;
+        AD_Stats_t st, st0;
+        float ref = NAN;
+
+        srand(1);
+        for (uint32_t b = 0; b < blocks; b++)
+        {
+            float32_t mean, rms, mn, mx;
+            uint32_t idx;
+            RefStats_t r;
+
+            make_block(kind, b);
+            ref_stats(s_x, &r);
+
+            double t0 = now_ns();
+            arm_mean_f32(s_x, N, &mean);
+            arm_rms_f32(s_x, N, &rms);
+            arm_min_f32(s_x, N, &mn, &idx);
+            arm_max_f32(s_x, N, &mx, &idx);
+            double t1 = now_ns();
+            AD_Stats_ComputeRef(s_x, N, ref, &st);
+            double t2 = now_ns();
+            ref = st.mean;
+            AD_Stats_ComputeRef(s_x, N, s_x[0], &st0);
+            t_ref += t1 - t0;
+            t_one += t2 - t1;
+            sink += mean + rms + mn + mx;
+
+            if (st.min != mn || st.max != mx)
+                printf("  [%s] 块 %u 极值不一致\n", names[kind], (unsigned)b);
+            upd(&e_mean_a, rel(mean, r.mean));
+            upd(&e_mean, rel(st.mean, r.mean));
+            upd(&e_rms_a, rel(rms, r.rms));
+            upd(&e_rms, rel(st.rms, r.rms));
+            upd(&e_std, rel(st.std, r.std));
+            upd(&e_kurt, rel(st.kurt, r.kurt));
+            upd(&e_std0, rel(st0.std, r.std));
+            upd(&e_kurt0, rel(st0.kurt, r.kurt));
+        }
+        printf("%-6s  %11.2f  %11.2f  %6.2f  |  %23.1e  %5.1e  %8.1e  %5.1e  %5.1e  %5.1e  %7.1e  %8.1e  |  %5.3f  %5.3f  "
+               "%6.3f\n",
+               names[kind], t_ref / 1000.0 / blocks, t_one / 1000.0 / blocks, t_ref / t_one, e_mean_a, e_mean,
+               e_rms_a, e_rms, e_std, e_kurt, e_std0, e_kurt0, (double)st.crest, (double)st.skew, (double)st.kurt);
+    }
+    (void)sink;
+    return 0;
+}
@@ -0,0 +1,111 @@
+/*
+ * AD7606 双线串行拆位主机测试（MDK-ARM/HARDWORK/AD7606/ad7606_dual.h，与固件同一份代码）
+ *
+ * 按 AD7606 串行时序建模：DOUTA 依次移出 V1~V4、DOUTB 同时移出 V5~V8，每通道 16 位 MSB 在前，
+ * 每个 SCLK 给出一个 IDR 值（两条线各占一个引脚位，其余引脚填随机噪声），交给 AD7606_DualDeinterleave，检查：
+ *   - 8 个通道全部还原，顺序为 raw[0..3] = V1~V4、raw[4..7] = V5~V8
+ *   - 符号位：0x8000(-32768)、0xFFFF(-1)、0x7FFF(32767) 等按 int16 解释后与原码一致
+ *   - 引脚掩码不写死：默认 PA0/PA1、两线对调、高位引脚，结果都正确；其他引脚的噪声不影响结果
+ *
+ * 编译（在工程根目录）：
+ *   gcc -O2 -Wall -IMDK-ARM/HARDWORK/AD7606 tools/dual_check/dual_check.c -o dual_check
+ * 用法：./dual_check
+ * 全部通过返回 0
+ */
+#include "ad7606_dual.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+/* AD7606 一帧串行输出：codes[0..7] = V1~V8 */
+static void model_frame(const int16_t codes[8], uint32_t pin_a, uint32_t pin_b, uint16_t idr[AD7606_DUAL_SCLKS])
+{
+    for (uint32_t k = 0; k < AD7606_DUAL_SCLKS; k++)
+    {
+        uint32_t ch = k / 16u;
+        uint32_t bit = 15u - (k % 16u);
+        uint16_t a = (uint16_t)codes[ch];
+        uint16_t b = (uint16_t)codes[ch + 4u];
+        uint32_t v = (uint32_t)rand() & 0xFFFFu & ~(pin_a | pin_b); /* 同端口其他引脚的电平 */
+        if ((a >> bit) & 1u)
+            v |= pin_a;
+        if ((b >> bit) & 1u)
+            v |= pin_b;
+        idr[k] = (uint16_t)v;
+    }
+}
+
+static int check(const char *name, const int16_t codes[8], uint32_t pin_a, uint32_t pin_b, int verbose)
+{
+    uint16_t idr[AD7606_DUAL_SCLKS];
+    uint16_t raw[8];
+
+    model_frame(codes, pin_a, pin_b, idr);
+    AD7606_DualDeinterleave(idr, pin_a, pin_b, raw);
+    for (uint32_t ch = 0; ch < 8u; ch++)
+    {
+        if ((int16_t)raw[ch] != codes[ch])
+        {
+            printf("  %-24s FAIL V%u = %d (0x%04X), expect %d\n", name, (unsigned)(ch + 1u), (int16_t)raw[ch],
+                   raw[ch], codes[ch]);
+            return 0;
+        }
+    }
+    if (verbose)
+        printf("  %-24s PASS\n", name);
+    return 1;
+}
+
+int main(void)
+{
+    static const struct
+    {
+        const char *name;
+        int16_t codes[8];
+    } cases[] = {
+        {"channel order", {1, 2, 3, 4, 5, 6, 7, 8}},
+        {"sign: full scale", {-32768, 32767, -1, 0, 32767, -32768, 0, -1}},
+        {"sign: A neg / B pos", {-1, -2, -3, -4, 1, 2, 3, 4}},
+        {"bit patterns", {(int16_t)0xAAAA, 0x5555, (int16_t)0xFF00, 0x00FF, 0x5555, (int16_t)0xAAAA, 0x00FF, (int16_t)0xFF00}},
+        {"single bits", {(int16_t)0x8000, 0x4000, 0x0100, 0x0001, 0x0002, 0x0080, 0x2000, (int16_t)0x8001}},
+    };
+    static const struct
+    {
+        const char *name;
+        uint32_t pin_a;
+        uint32_t pin_b;
+    } pins[] = {
+        {"PA0/PA1", 1u << 0, 1u << 1},
+        {"swapped PA1/PA0", 1u << 1, 1u << 0},
+        {"high pins P15/P14", 1u << 15, 1u << 14},
+    };
+    int fail = 0;
+
+    srand(7);
+    for (uint32_t p = 0; p < sizeof(pins) / sizeof(pins[0]); p++)
+    {
+        printf("%s:\n", pins[p].name);
+        for (uint32_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++)
+        {
+            if (!check(cases[c].name, cases[c].codes, pins[p].pin_a, pins[p].pin_b, 1))
+                fail = 1;
+        }
+
+        uint32_t bad = 0;
+        for (uint32_t n = 0; n < 100000u; n++)
+        {
+            int16_t codes[8];
+            for (uint32_t ch = 0; ch < 8u; ch++)
+                codes[ch] = (int16_t)(rand() & 0xFFFF);
+            if (!check("random", codes, pins[p].pin_a, pins[p].pin_b, 0))
+                bad++;
+            if (bad >= 3u)
+                break;
+        }
+        printf("  %-24s %s\n", "random x100000", bad ? "FAIL" : "PASS");
+        if (bad)
+            fail = 1;
+    }
+
+    printf("%s\n", fail ? "FAILED" : "ALL PASS");
+    return fail;
+}
@@ -0,0 +1,389 @@
+/*
+ * 本地故障判定主机回放（Core/Src/ad_fault.c + ad_stats.c + ad_iso.c，与固件同一份代码）
+ *
+ * 两种用法：
+ *   1) 回放录波事件文件（SD 卡 0:/events/<日期>/evt_*.bin，EVNT 原样或 EVNZ 压缩均可，见 tools/common/event_file.h）：
+ *      按文件头的 scale/offset 换算工程量，按 4096 帧分块（尾块 ≥ 1024 帧也判），逐块打印特征与故障码变化；
+ *      给 -x E02 时检查是否判出该故障码，不符返回 1
+ *   2) 不给文件：跑内置合成场景（正常/单块毛刺/母线接地/漏电流超限/漏电尖峰/绝缘下降/纹波增长），
+ *      检查判出的故障码、判定延迟（块）与故障消失后的恢复，全部通过返回 0（期望值按编译期默认规则）；
+ *      另跑绝缘电阻估计：不平衡电桥法按电桥网络模型合成各桥臂状态下的 U+ / U−，检查 R+ / R− 与变化率
+ *   -c ad_fault.cfg：先加载与 SD 相同格式的规则文件（缺省项为编译期默认值）
+ *
+ * 编译（在工程根目录）：
+ *   gcc -O2 -Wall -ICore/Inc -Itools/common tools/fault_replay/fault_replay.c Core/Src/ad_fault.c Core/Src/ad_stats.c \
+ *       Core/Src/ad_iso.c Core/Src/ad_codec.c -lm -o fault_replay
+ *
+ * 用法：./fault_replay [-c ad_fault.cfg] [-x E02] [evt_xxx.bin ...]
+ */
+#include "ad_fault.h"
+#include "event_file.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define N      4096u
+#define FS     25600u
+#define MAX_CH 8u
+
+static AD_FaultConfig_t s_cfg;
+static float s_wave[MAX_CH][N];
+static AD_Stats_t s_st[MAX_CH];
+static bool s_st_ok; /* s_st 里是上一块的结果：与固件一样拿上一块均值作统计基准点 */
+
+static bool load_cfg(const char *path)
+{
+    char line[128];
+    FILE *fp = fopen(path, "r");
+    if (!fp)
+        return false;
+    AD_Fault_DefaultConfig(&s_cfg);
+    while (fgets(line, sizeof(line), fp))
+    {
+        size_t n = strlen(line);
+        while (n > 0 && (line[n - 1] == '\r' || line[n - 1] == '\n' || line[n - 1] == ' ' || line[n - 1] == '\t'))
+            line[--n] = '\0';
+        char *val = strchr(line, '=');
+        if (line[0] == '#' || !val)
+            continue;
+        *val++ = '\0';
+        if (!AD_Fault_ParseKV(&s_cfg, line, val))
+            fprintf(stderr, "%s: unknown key %s\n", path, line);
+    }
+    fclose(fp);
+    return true;
+}
+
+/* 主机回放单线程，配置交接不需要临界区 */
+uint32_t AD_Fault_Lock(void)
+{
+    return 0u;
+}
+
+void AD_Fault_Unlock(uint32_t key)
+{
+    (void)key;
+}
+
+static void engine_reset(void)
+{
+    AD_Fault_Init();
+    s_st_ok = false;
+    if (!AD_Fault_SetConfig(&s_cfg))
+    {
+        fprintf(stderr, "invalid rule table\n");
+        exit(2);
+    }
+}
+
+/* 物理通道 -> 本块的通道下标 */
+static int32_t role(const uint8_t *ch_id, uint32_t nch, uint8_t phys)
+{
+    for (uint32_t i = 0; i < nch; i++)
+    {
+        if (ch_id[i] == phys)
+            return (int32_t)i;
+    }
+    return -1;
+}
+
+/* 判定一块（s_wave 前 nch 个通道、n 点） */
+static void eval_block(const uint8_t *ch_id, uint32_t nch, uint32_t n, uint32_t rate, AD_FaultFeatures_t *f,
+                       AD_FaultVerdict_t *v)
+{
+    AD_FaultInput_t in;
+    AD_FaultConfig_t cfg;
+
+    for (uint32_t ch = 0; ch < nch; ch++)
+        AD_Stats_ComputeRef(s_wave[ch], n, s_st_ok ? s_st[ch].mean : NAN, &s_st[ch]);
+    s_st_ok = true;
+    AD_Fault_BeginBlock(&cfg);
+    int32_t bp = role(ch_id, nch, cfg.ch_bus_p);
+    int32_t bn = role(ch_id, nch, cfg.ch_bus_n);
+    int32_t lk = role(ch_id, nch, cfg.ch_leak);
+    memset(&in, 0, sizeof(in));
+    in.bus_p = (bp >= 0) ? &s_st[bp] : NULL;
+    in.bus_n = (bn >= 0) ? &s_st[bn] : NULL;
+    in.leak = (lk >= 0) ? &s_st[lk] : NULL;
+    in.leak_wave = (lk >= 0) ? s_wave[lk] : NULL;
+    in.n = n;
+    in.sample_rate = rate;
+    in.dt_s = (float)n / (float)rate;
+    AD_Fault_Extract(&in, f, NULL);
+    AD_Fault_Eval(f, in.dt_s, v);
+}
+
+static void print_feat(const AD_FaultFeatures_t *f)
+{
+    for (uint32_t i = 0; i < AD_FEAT_COUNT; i++)
+        printf(" %s=%.3g", AD_Fault_FeatName((uint8_t)i), (double)f->v[i]);
+    printf("\n");
+}
+
+/* ---------- 录波事件回放 ---------- */
+
+static int replay_file(const char *path, const char *expect)
+{
+    EventHeader_t h;
+    int16_t *raw;
+    int seen = 0;
+
+    if (Evt_Load(path, &h, &raw) != EVT_OK || h.channels > MAX_CH || h.sample_rate == 0u)
+    {
+        fprintf(stderr, "%s: not an event file\n", path);
+        free(raw);
+        return 1;
+    }
+    printf("%s: %u ch, %u frames @ %uHz, trig CH%u, recorded code %.3s\n", path, (unsigned)h.channels,
+           (unsigned)h.frames, (unsigned)h.sample_rate, (unsigned)h.trig_ch, h.fault_code);
+
+    engine_reset();
+    for (uint32_t done = 0, blk = 0; done < h.frames; blk++)
+    {
+        uint32_t n = h.frames - done;
+        if (n > N)
+            n = N;
+        const int16_t *x = &raw[(size_t)done * h.channels];
+        done += n;
+        if (n < N / 4u)
+            break;
+        for (uint32_t i = 0; i < n; i++)
+            for (uint32_t ch = 0; ch < h.channels; ch++)
+                s_wave[ch][i] = ((float)x[i * h.channels + ch] - h.offset[ch]) * h.scale[ch];
+
+        AD_FaultFeatures_t f;
+        AD_FaultVerdict_t v;
+        eval_block(h.ch_id, h.channels, n, h.sample_rate, &f, &v);
+        printf("  blk%-3u %s%s rule=%d active=0x%02X", (unsigned)blk, v.code, v.changed ? "*" : " ", (int)v.rule,
+               (unsigned)v.active);
+        print_feat(&f);
+        if (expect && strcmp(v.code, expect) == 0)
+            seen = 1;
+    }
+    free(raw);
+    if (!expect)
+        return 0;
+    printf("  expect %s: %s\n", expect, seen ? "PASS" : "FAIL");
+    return seen ? 0 : 1;
+}
+
+/* ---------- 合成场景 ---------- */
+
+typedef enum
+{
+    SC_NORMAL = 0,
+    SC_GLITCH,
+    SC_GROUND,
+    SC_LEAK_RMS,
+    SC_LEAK_SPIKE,
+    SC_ISO,
+    SC_RIPPLE,
+    SC_COUNT
+} Scenario_t;
+
+typedef struct
+{
+    const char *name;
+    uint32_t blocks;
+    uint32_t onset;      /* 故障开始块 */
+    uint32_t end;        /* 故障结束块（之后恢复正常） */
+    const char *code;    /* 应判出的故障码（E00 = 不应报警） */
+    uint32_t max_delay;  /* 判定延迟上限（块） */
+} ScenarioDef_t;
+
+static const ScenarioDef_t s_sc[SC_COUNT] = {
+    {"normal", 60, 0, 0, "E00", 0},
+    {"glitch(1 block imbalance)", 30, 10, 11, "E00", 0},
+    {"bus ground", 60, 10, 25, "E05", 2},
+    {"leak rms", 60, 10, 25, "E02", 2},
+    {"leak spikes", 80, 10, 25, "E02", 2},
+    {"insulation", 60, 10, 25, "E02", 3},
+    {"ripple growth", 200, 100, 130, "E03", 5},
+};
+
+static double noise(void)
+{
+    return (double)rand() / RAND_MAX - 0.5;
+}
+
+/* 通道按物理 0..3：母线(+) V、母线(-) V、负载电流 A、漏电流 mA */
+static void make_block(Scenario_t sc, uint32_t blk, bool fault)
+{
+    double vp = 350.0, vn = -350.0, ripple = 3.0, leak_dc = 0.5, leak_ac = 0.3;
+    uint32_t spike_every = 0;
+
+    if (fault || (sc == SC_GLITCH && blk == s_sc[sc].onset))
+    {
+        switch (sc)
+        {
+        case SC_GLITCH:
+        case SC_GROUND:
+            vp = 600.0;
+            vn = -100.0;
+            break;
+        case SC_LEAK_RMS:
+            leak_dc = 35.0;
+            leak_ac = 10.0;
+            break;
+        case SC_LEAK_SPIKE:
+            spike_every = FS / 10u; /* 10 次/秒 */
+            break;
+        case SC_ISO:
+            leak_dc = 9.0; /* 700V / 9mA = 78kΩ */
+            break;
+        case SC_RIPPLE:
+            ripple = 9.0;
+            break;
+        default:
+            break;
+        }
+    }
+
+    for (uint32_t i = 0; i < N; i++)
+    {
+        double t = (double)(blk * N + i) / FS;
+        double r = ripple * sin(2.0 * M_PI * 100.0 * t);
+        s_wave[0][i] = (float)(vp + r + 0.2 * noise());
+        s_wave[1][i] = (float)(vn - r + 0.2 * noise());
+        s_wave[2][i] = (float)(20.0 + 2.0 * sin(2.0 * M_PI * 50.0 * t) + 0.1 * noise());
+        s_wave[3][i] = (float)(leak_dc + leak_ac * sin(2.0 * M_PI * 50.0 * t) + 0.1 * noise());
+        if (spike_every && ((blk * N + i) % spike_every) < 8u)
+            s_wave[3][i] += 12.0f;
+    }
+}
+
+/* ---------- 绝缘电阻估计（电桥法） ---------- */
+
+/* 电桥网络：大地节点 KCL，U+ (G+ + Gb + Gs正) = U− (G− + Gb + Gs负)，U+ + U− = Vbus */
+static void iso_network(const AD_IsoConfig_t *c, uint8_t bridge, double rp, double rn, double vbus, AD_IsoInput_t *in)
+{
+    double gb = (c->r_bridge_kohm > 0.0f) ? 1.0 / c->r_bridge_kohm : 0.0;
+    double gs = 1.0 / c->r_switch_kohm;
+    double gtp = 1.0 / rp + gb + ((bridge == AD_ISO_BRIDGE_POS) ? gs : 0.0);
+    double gtn = 1.0 / rn + gb + ((bridge == AD_ISO_BRIDGE_NEG) ? gs : 0.0);
+    double up = vbus * gtn / (gtp + gtn);
+    in->u_p = (float)(up + 0.05 * noise());
+    in->u_n = (float)(vbus - up + 0.05 * noise());
+    in->i_leak = (float)(up / rp - (vbus - up) / rn);
+    in->powered = 1u;
+    in->bridge_hw = 1u;
+}
+
+static int run_iso(void)
+{
+    AD_IsoConfig_t c;
+    AD_IsoInput_t in;
+    AD_IsoResult_t r;
+    int fails = 0;
+
+    AD_Iso_DefaultConfig(&c);
+    c.r_bridge_kohm = 1000.0f;
+
+    /* 静态：R+ = 300kΩ、R− = 50kΩ，每块 0.16s */
+    srand(1);
+    AD_Iso_Reset();
+    memset(&r, 0, sizeof(r));
+    for (uint32_t b = 0; b < 200u; b++)
+    {
+        iso_network(&c, r.bridge, 300.0, 50.0, 700.0, &in);
+        in.dt_s = (float)N / (float)FS;
+        AD_Iso_Update(&c, &in, &r);
+    }
+    bool ok = r.valid && fabsf(r.r_p_kohm - 300.0f) < 15.0f && fabsf(r.r_n_kohm - 50.0f) < 2.5f && r.rejected == 0u;
+    printf("%-26s R+ %.1f R- %.1f (truth 300/50 kOhm) updates %u rejected %u -> %s\n", "iso bridge static",
+           (double)r.r_p_kohm, (double)r.r_n_kohm, (unsigned)r.updates, (unsigned)r.rejected, ok ? "PASS" : "FAIL");
+    fails += ok ? 0 : 1;
+
+    /* 指数下降：R(t) = R0 exp(−k t)，相对变化率 −30 %/h；每块 1s 跑 1.5h */
+    const double k = 0.30 / 3600.0;
+    srand(1);
+    AD_Iso_Reset();
+    memset(&r, 0, sizeof(r));
+    for (uint32_t t = 0; t < 5400u; t++)
+    {
+        double s = exp(-k * t);
+        iso_network(&c, r.bridge, 800.0 * s, 400.0 * s, 700.0, &in);
+        in.dt_s = 1.0f;
+        AD_Iso_Update(&c, &in, &r);
+    }
+    ok = r.valid && fabsf(r.rate_pct_h + 30.0f) < 6.0f;
+    printf("%-26s rate %.1f %%/h (truth -30) trend %.1f kOhm -> %s\n", "iso bridge decline", (double)r.rate_pct_h,
+           (double)r.trend_kohm, ok ? "PASS" : "FAIL");
+    fails += ok ? 0 : 1;
+    return fails;
+}
+
+static int run_scenarios(void)
+{
+    static const uint8_t ch_id[4] = {0, 1, 2, 3};
+    int fails = 0;
+
+    for (uint32_t sc = 0; sc < SC_COUNT; sc++)
+    {
+        const ScenarioDef_t *d = &s_sc[sc];
+        int32_t first = -1;
+        char first_code[4] = "E00";
+        AD_FaultVerdict_t v;
+        AD_FaultFeatures_t f;
+
+        srand(1);
+        engine_reset();
+        for (uint32_t b = 0; b < d->blocks; b++)
+        {
+            bool fault = (b >= d->onset && b < d->end && d->end > d->onset + 1u);
+            make_block((Scenario_t)sc, b, fault);
+            eval_block(ch_id, 4u, N, FS, &f, &v);
+            if (first < 0 && strcmp(v.code, "E00") != 0)
+            {
+                first = (int32_t)b;
+                memcpy(first_code, v.code, 4);
+            }
+        }
+
+        bool expect_fault = (strcmp(d->code, "E00") != 0);
+        /* LATCH=1 时故障码保持到复位，最后一块仍应是该故障码 */
+        bool ok = (strcmp(first_code, d->code) == 0) && strcmp(v.code, s_cfg.latch ? d->code : "E00") == 0;
+        if (expect_fault)
+            ok = ok && first >= (int32_t)d->onset && (uint32_t)first - d->onset < d->max_delay;
+        printf("%-26s expect %s got %s", d->name, d->code, first_code);
+        if (first >= 0)
+            printf(" at blk %d (onset %u, delay %d)", (int)first, (unsigned)d->onset, (int)(first - (int32_t)d->onset));
+        printf(", final %s -> %s\n", v.code, ok ? "PASS" : "FAIL");
+        if (!ok)
+        {
+            printf("  last block:");
+            print_feat(&f);
+        }
+        fails += ok ? 0 : 1;
+    }
+    fails += run_iso();
+    return fails ? 1 : 0;
+}
+
+int main(int argc, char **argv)
+{
+    const char *expect = NULL;
+    int rc = 0, files = 0;
+
+    AD_Fault_DefaultConfig(&s_cfg);
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-c") == 0 && i + 1 < argc)
+        {
+            if (!load_cfg(argv[++i]))
+            {
+                fprintf(stderr, "cannot open %s\n", argv[i]);
+                return 2;
+            }
+        }
+        else if (strcmp(argv[i], "-x") == 0 && i + 1 < argc)
+            expect = argv[++i];
+        else
+        {
+            rc |= replay_file(argv[i], expect);
+            files++;
+        }
+    }
+    return files ? rc : run_scenarios();
+}
@@ -0,0 +1,427 @@
+/*
+ * 二进制遥测帧主机往返测试（Core/Src/ad_frame.c，与固件同一份编码器）
+ *
+ * 合成一块 4 通道数据（母线 ± 380V + 100Hz 纹波、负载电流 20A + 开关纹波、漏电流 0.8mA + 50Hz 分量与尖峰），
+ * 按 ESP_Post_Data 的内容与顺序分别生成：
+ *   frame.bin  ：二进制帧（CHAN/WAVE/SPEC/HARM × 通道 + CLASS + ISO + EVENT，段序与固件上报生成器相同）
+ *   frame.json ：同一份数据的 JSON 上报体（与 ESP_Post_Data 的字段/数值格式相同：×200 取整、频谱 1 位小数）
+ * 然后用服务器的参考解码器比对两者（frame_roundtrip.py），并打印两种格式的大小与编码耗时。
+ * 另用流式接口（AD_Frame_BeginStream / Rebase / EndStream，固件按乒乓段发送时的用法）按几种段尺寸重新生成，
+ * 拼起来须与整帧逐字节相同。
+ * -z：波形/录波改走无损压缩段 WAVE_Z / EVENT_Z（与 ESP_FRAME_WAVE_CODEC = 1 时的固件相同），波形须与 JSON 逐点一致。
+ *
+ * 编译（在工程根目录）：
+ *   gcc -O2 -ICore/Inc tools/frame_check/frame_check.c Core/Src/ad_frame.c Core/Src/ad_codec.c Core/Src/ad_stats.c \
+ *       -lm -o frame_check
+ * 用法：
+ *   ./frame_check [-o 输出目录] [-s wave_step] [-z]
+ *   python3 tools/frame_check/frame_roundtrip.py [输出目录] [Edge_Wind_System 目录]
+ * 全部通过返回 0
+ */
+#include "ad_frame.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define N      4096u
+#define BINS   (N / 2u)
+#define NCH    4u    /* AD_ACQ_CH_MASK = 0x0F */
+#define HARM   8u    /* AD_PSD_HARMONICS */
+#define FS     25600u
+#define SCALE  200   /* ESP_UPLOAD_SCALE */
+#define EV_FRAMES 4096u
+#define EV_MAX_POINTS 1024u /* ESP_EVENT_MAX_POINTS */
+
+static const struct
+{
+    const char *label;
+    const char *unit;
+} s_meta[NCH] = {
+    {"直流母线(+)", "V"},
+    {"直流母线(-)", "V"},
+    {"负载电流", "A"},
+    {"漏电流", "mA"},
+};
+
+static float s_wave[NCH][N];
+static float s_spec[NCH][BINS];
+static float s_harm[NCH][HARM];
+static AD_Stats_t s_stats[NCH];
+static int16_t s_ev[EV_FRAMES][NCH];
+static const float s_ev_k[NCH] = {0.0125f, 0.0125f, 0.0021f, 0.00008f};
+static const float s_ev_off[NCH] = {3.5f, -2.0f, 1.0f, 0.25f};
+static uint8_t s_bin[1u << 20];
+static AD_Codec_t s_codec;
+static int s_z;
+static char s_json[1u << 20];
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static double gauss(void)
+{
+    double u = ((double)rand() + 1.0) / ((double)RAND_MAX + 2.0);
+    double v = ((double)rand() + 1.0) / ((double)RAND_MAX + 2.0);
+    return sqrt(-2.0 * log(u)) * cos(2.0 * M_PI * v);
+}
+
+/* 单边幅值谱，标度同 DSP 任务：|X[k]| / (N/2)，bin0 置 0 */
+static void make_spectrum(const float *x, float *s)
+{
+    static double c[N], sn[N];
+    for (uint32_t i = 0; i < N; i++)
+    {
+        c[i] = cos(2.0 * M_PI * i / N);
+        sn[i] = sin(2.0 * M_PI * i / N);
+    }
+    s[0] = 0.0f;
+    for (uint32_t k = 1; k < BINS; k++)
+    {
+        double re = 0.0, im = 0.0;
+        uint32_t idx = 0;
+        for (uint32_t i = 0; i < N; i++)
+        {
+            re += x[i] * c[idx];
+            im -= x[i] * sn[idx];
+            idx = (idx + k) & (N - 1u);
+        }
+        s[k] = (float)(sqrt(re * re + im * im) / (N / 2.0));
+    }
+}
+
+static void make_data(void)
+{
+    srand(1);
+    for (uint32_t i = 0; i < N; i++)
+    {
+        double t = (double)i / FS;
+        s_wave[0][i] = (float)(380.0 + 2.0 * sin(2.0 * M_PI * 100.0 * t) + 0.05 * gauss());
+        s_wave[1][i] = (float)(375.0 + 2.0 * sin(2.0 * M_PI * 100.0 * t + 0.3) + 0.05 * gauss());
+        s_wave[2][i] = (float)(20.0 + 0.5 * sin(2.0 * M_PI * 100.0 * t) + 0.05 * sin(2.0 * M_PI * 10000.0 * t) +
+                               0.002 * gauss());
+        s_wave[3][i] = (float)(0.8 + 0.3 * sin(2.0 * M_PI * 50.0 * t) + 0.01 * gauss() + ((i % 997u) < 3u ? 2.0 : 0.0));
+    }
+    for (uint32_t ch = 0; ch < NCH; ch++)
+    {
+        AD_Stats_Compute(s_wave[ch], N, &s_stats[ch]);
+        make_spectrum(s_wave[ch], s_spec[ch]);
+        for (uint32_t h = 0; h < HARM; h++)
+            s_harm[ch][h] = s_spec[ch][(h + 1u) * 16u]; /* 100Hz 基波 = bin 16 */
+    }
+    for (uint32_t f = 0; f < EV_FRAMES; f++)
+    {
+        for (uint32_t ch = 0; ch < NCH; ch++)
+            s_ev[f][ch] = (int16_t)(8000.0 * sin(2.0 * M_PI * (ch + 1u) * f / 512.0) + 30.0 * gauss() +
+                                    ((f > 1024u && ch == 3u) ? -12000 : 0));
+    }
+}
+
+#define NSEC (NCH * 4u + 3u) /* CHAN/WAVE/SPEC/HARM × 通道 + CLASS + ISO + EVENT */
+
+static void make_header(AD_FrameHeader_t *h)
+{
+    memset(h, 0, sizeof(*h));
+    h->seq = 42u;
+    h->sample_rate = FS;
+    h->tick_ms = 123456u;
+    h->ch_count = NCH;
+    h->ch_mask = 0x0Fu;
+    memcpy(h->fault_code, "E02", 4u);
+}
+
+/* 第 k 段（0..NSEC-1）：与固件上报生成器相同的段序与布局 */
+static void put_section(AD_FrameWriter_t *w, uint32_t k, uint32_t step)
+{
+    if (k < NCH * 4u)
+    {
+        uint8_t ch = (uint8_t)(k / 4u);
+        switch (k % 4u)
+        {
+        case 0:
+            AD_Frame_AddChan(w, ch, s_stats[ch].rms, &s_stats[ch]);
+            break;
+        case 1:
+            if (s_z)
+                AD_Frame_AddWaveZ(w, &s_codec, ch, s_wave[ch], N, step, (float)SCALE);
+            else
+                AD_Frame_AddWave(w, ch, s_wave[ch], N, step);
+            break;
+        case 2:
+            AD_Frame_AddSpec(w, ch, s_spec[ch], BINS, 1u);
+            break;
+        default:
+            AD_Frame_AddFloats(w, AD_FRAME_SEC_HARM, ch, s_harm[ch], HARM);
+            break;
+        }
+        return;
+    }
+
+    if (k == NCH * 4u)
+    {
+        AD_Frame_SecBegin(w, AD_FRAME_SEC_CLASS, AD_FRAME_CH_NONE);
+        AD_Frame_PutU8(w, 2u);
+        AD_Frame_PutBytes(w, "E02", 4u);
+        AD_Frame_PutU8(w, 0u);
+        AD_Frame_PutF32(w, 12.5f);
+        AD_Frame_PutU32(w, 5120u);
+        AD_Frame_SecEnd(w);
+        return;
+    }
+
+    if (k == NCH * 4u + 1u)
+    {
+        AD_Frame_SecBegin(w, AD_FRAME_SEC_ISO, AD_FRAME_CH_NONE);
+        AD_Frame_PutU8(w, 1u);
+        AD_Frame_PutU8(w, 0u);
+        AD_Frame_PutU16(w, 0u);
+        AD_Frame_PutF32(w, 300.0f);
+        AD_Frame_PutF32(w, 50.0f);
+        AD_Frame_PutF32(w, 42.9f);
+        AD_Frame_PutF32(w, 43.1f);
+        AD_Frame_PutF32(w, NAN);
+        AD_Frame_SecEnd(w);
+        return;
+    }
+
+    uint32_t ev_step = (EV_FRAMES + EV_MAX_POINTS - 1u) / EV_MAX_POINTS;
+    AD_Frame_SecBegin(w, s_z ? AD_FRAME_SEC_EVENT_Z : AD_FRAME_SEC_EVENT, 3u);
+    AD_Frame_PutU32(w, 7u);
+    AD_Frame_PutU32(w, FS);
+    AD_Frame_PutU32(w, 1024u);
+    AD_Frame_PutU32(w, EV_FRAMES - 1025u);
+    AD_Frame_PutU32(w, EV_FRAMES);
+    AD_Frame_PutU32(w, ev_step);
+    AD_Frame_PutU8(w, 3u);
+    AD_Frame_PutU8(w, 6u);
+    AD_Frame_PutU8(w, 0u);
+    AD_Frame_PutU8(w, NCH);
+    AD_Frame_PutBytes(w, "E02", 4u);
+    if (s_z)
+    {
+        AD_Frame_PutU16(w, (uint16_t)AD_CODEC_BLOCK);
+        AD_Frame_PutU16(w, 0u);
+    }
+    for (uint8_t ch = 0; ch < NCH; ch++)
+    {
+        AD_Frame_PutU8(w, ch);
+        AD_Frame_PutU8(w, 0u);
+        AD_Frame_PutU16(w, 0u);
+        AD_Frame_PutF32(w, s_ev_k[ch]);
+        AD_Frame_PutF32(w, -s_ev_off[ch] * s_ev_k[ch]);
+        if (!s_z)
+        {
+            for (uint32_t f = 0; f < EV_FRAMES; f += ev_step)
+                AD_Frame_PutU16(w, (uint16_t)s_ev[f][ch]);
+            continue;
+        }
+        /* 与 ESP_Frame_AddTrigEvent 相同：u32 nbytes 占位回填，每通道独立码流 */
+        uint32_t nb_off = w->len;
+        uint32_t nbytes = 0u;
+        AD_Frame_PutU32(w, 0u);
+        AD_Codec_Reset(&s_codec);
+        for (uint32_t f = 0; w->ok && f < EV_FRAMES;)
+        {
+            uint32_t cnt = 0u;
+            for (; cnt < AD_CODEC_BLOCK && f < EV_FRAMES; f += ev_step)
+                s_codec.in[cnt++] = s_ev[f][ch];
+            nbytes += AD_Frame_PutCodecBlock(w, &s_codec, 0u, s_codec.in, cnt);
+        }
+        if (w->ok)
+            memcpy(w->buf + nb_off, &nbytes, 4u); /* 主机小端 */
+    }
+    AD_Frame_SecEnd(w);
+}
+
+static uint32_t build_bin(uint32_t step)
+{
+    AD_FrameWriter_t w;
+    AD_FrameHeader_t h;
+
+    make_header(&h);
+    AD_Frame_Begin(&w, s_bin, sizeof(s_bin), &h, "STM32_H7_Node");
+    for (uint32_t k = 0; k < NSEC; k++)
+        put_section(&w, k, step);
+    return AD_Frame_End(&w);
+}
+
+/* 流式输出（与固件上报的乒乓段相同的用法）：段写不下时恢复写入器、换一块空段重写；
+ * 各段依次拼进 s_bin_stream，须与 build_bin 的整帧逐字节相同。返回帧长，段数记入 *segs */
+static uint8_t s_bin_stream[1u << 20];
+static uint8_t s_seg[2][65536];
+
+static uint32_t build_bin_stream(uint32_t step, uint32_t seg_size, uint32_t *segs)
+{
+    AD_FrameWriter_t w, saved;
+    AD_FrameHeader_t h;
+    uint32_t out = 0u, cur = 0u, k = 0u;
+
+    make_header(&h);
+    *segs = 1u;
+    AD_Frame_BeginStream(&w, s_seg[cur], seg_size, &h, "STM32_H7_Node", (uint16_t)NSEC);
+    while (w.ok && k <= NSEC)
+    {
+        saved = w;
+        uint32_t n = 0u;
+        if (k < NSEC)
+            put_section(&w, k, step);
+        else
+            n = AD_Frame_EndStream(&w);
+        if (w.ok && (k < NSEC || n != 0u))
+        {
+            k++;
+            continue;
+        }
+        /* 本段放不下：已写的交出去，换空段重写；空段也放不下说明段尺寸小于最大的帧段 */
+        if (saved.len == 0u)
+            return 0u;
+        w = saved;
+        memcpy(s_bin_stream + out, w.buf, w.len);
+        out += w.len;
+        cur ^= 1u;
+        AD_Frame_Rebase(&w, s_seg[cur], seg_size);
+        (*segs)++;
+    }
+    if (!w.ok)
+        return 0u;
+    memcpy(s_bin_stream + out, w.buf, w.len);
+    return out + w.len;
+}
+
+static long scaled(float v)
+{
+    float x = v * (float)SCALE;
+    return (long)((x >= 0.0f) ? (x + 0.5f) : (x - 0.5f));
+}
+
+#define APP(...) (p += snprintf(p, (size_t)(end - p), __VA_ARGS__))
+
+/* 与 ESP_Post_Data 相同的 JSON 字段与数值格式 */
+static uint32_t build_json(uint32_t step)
+{
+    char *p = s_json;
+    const char *end = s_json + sizeof(s_json);
+
+    APP("{\"node_id\":\"%s\",\"status\":\"online\",\"fault_code\":\"%s\",\"seq\":%lu,"
+        "\"sample_rate\":%lu,\"os_mode\":%u,\"acq_profile\":%u,\"channels\":[",
+        "STM32_H7_Node", "E02", 42ul, (unsigned long)FS, 0u, 0u);
+    for (uint32_t ch = 0; ch < NCH; ch++)
+    {
+        long v = scaled(s_stats[ch].rms);
+        APP("{\"id\":%u,\"channel_id\":%u,\"label\":\"%s\",\"name\":\"%s\",\"value\":%ld,\"current_value\":%ld,"
+            "\"unit\":\"%s\",\"waveform\":[",
+            (unsigned)ch, (unsigned)ch, s_meta[ch].label, s_meta[ch].label, v, v, s_meta[ch].unit);
+        for (uint32_t i = 0; i < N; i += step)
+            APP(i ? ",%ld" : "%ld", scaled(s_wave[ch][i]));
+        APP("],\"fft_spectrum\":[");
+        for (uint32_t k = 0; k < BINS; k++)
+            APP(k ? ",%.1f" : "%.1f", (double)s_spec[ch][k]);
+        APP("],\"harmonics\":[");
+        for (uint32_t hh = 0; hh < HARM; hh++)
+            APP(hh ? ",%.4f" : "%.4f", (double)s_harm[ch][hh]);
+        APP("]}%s", (ch + 1u < NCH) ? "," : "");
+    }
+    APP("],\"class\":{\"code\":\"E02\",\"idx\":2,\"score\":12.500,\"cyc\":5120}");
+    APP(",\"iso\":{\"mode\":\"bridge\",\"rp\":300.0,\"rn\":50.0,\"r\":42.9,\"trend\":43.1,\"rate\":null}");
+
+    uint32_t ev_step = (EV_FRAMES + EV_MAX_POINTS - 1u) / EV_MAX_POINTS;
+    APP(",\"event\":{\"seq\":7,\"fault_code\":\"E02\",\"trig_ch\":3,\"trig_type\":\"spike\",\"fs\":%lu,\"os_mode\":0,"
+        "\"pre\":1024,\"post\":%lu,\"frames\":%lu,\"step\":%lu,\"channels\":[",
+        (unsigned long)FS, (unsigned long)(EV_FRAMES - 1025u), (unsigned long)EV_FRAMES, (unsigned long)ev_step);
+    for (uint32_t ch = 0; ch < NCH; ch++)
+    {
+        APP("%s{\"id\":%u,\"label\":\"%s\",\"unit\":\"%s\",\"waveform\":[", ch ? "," : "", (unsigned)ch,
+            s_meta[ch].label, s_meta[ch].unit);
+        for (uint32_t f = 0; f < EV_FRAMES; f += ev_step)
+            APP(f ? ",%ld" : "%ld", scaled(((float)s_ev[f][ch] - s_ev_off[ch]) * s_ev_k[ch]));
+        APP("]}");
+    }
+    APP("]}}");
+    return (p < end) ? (uint32_t)(p - s_json) : 0u;
+}
+
+static int write_file(const char *dir, const char *name, const void *p, size_t n)
+{
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    FILE *fp = fopen(path, "wb");
+    if (!fp || fwrite(p, 1, n, fp) != n)
+    {
+        fprintf(stderr, "cannot write %s\n", path);
+        if (fp)
+            fclose(fp);
+        return 0;
+    }
+    fclose(fp);
+    return 1;
+}
+
+int main(int argc, char **argv)
+{
+    const char *dir = ".";
+    uint32_t step = 1u;
+    const uint32_t reps = 200u;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+            dir = argv[++i];
+        else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+            step = (uint32_t)strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "-z") == 0)
+            s_z = 1;
+    }
+    if (step == 0u)
+        step = 1u;
+
+    make_data();
+
+    uint32_t nb = build_bin(step);
+    uint32_t nj = build_json(step);
+    if (nb == 0u || nj == 0u)
+    {
+        fprintf(stderr, "buffer too small\n");
+        return 1;
+    }
+
+    /* 流式输出：几种段尺寸（20480 = 固件 ESP_TX_SEG_SIZE）都须与整帧逐字节相同 */
+    static const uint32_t seg_sizes[] = {12000u, 16384u, 20480u, 32768u, 65536u};
+    for (uint32_t i = 0; i < sizeof(seg_sizes) / sizeof(seg_sizes[0]); i++)
+    {
+        uint32_t segs = 0u;
+        uint32_t ns = build_bin_stream(step, seg_sizes[i], &segs);
+        if (ns == 0u && seg_sizes[i] < 20480u)
+        {
+            printf("stream seg %5u: a section does not fit (expected for small segments)\n", (unsigned)seg_sizes[i]);
+            continue;
+        }
+        if (ns != nb || memcmp(s_bin_stream, s_bin, nb) != 0)
+        {
+            fprintf(stderr, "stream seg %u: output differs from one-shot frame (%u / %u bytes)\n",
+                    (unsigned)seg_sizes[i], (unsigned)ns, (unsigned)nb);
+            return 1;
+        }
+        printf("stream seg %5u: %u segments, identical to one-shot frame\n", (unsigned)seg_sizes[i], (unsigned)segs);
+    }
+
+    double t0 = now_ns();
+    for (uint32_t r = 0; r < reps; r++)
+        (void)build_bin(step);
+    double t_bin = (now_ns() - t0) / reps;
+    t0 = now_ns();
+    for (uint32_t r = 0; r < reps; r++)
+        (void)build_json(step);
+    double t_json = (now_ns() - t0) / reps;
+
+    if (!write_file(dir, "frame.bin", s_bin, nb) || !write_file(dir, "frame.json", s_json, nj))
+        return 1;
+    printf("wave_step %u%s: binary %u bytes, JSON %u bytes (x%.2f)\n", (unsigned)step, s_z ? " (codec)" : "",
+           (unsigned)nb, (unsigned)nj, (double)nj / nb);
+    printf("encode per frame (host): binary %.1fus, JSON %.1fus (x%.1f)\n", t_bin / 1e3, t_json / 1e3, t_json / t_bin);
+    return 0;
+}
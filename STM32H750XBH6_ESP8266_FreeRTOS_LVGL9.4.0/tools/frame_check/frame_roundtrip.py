@@ -0,0 +1,117 @@
+"""
+二进制遥测帧往返比对：用服务器参考解码器（Edge_Wind_System/edgewind/binframe.py）解 frame_check 生成的 frame.bin，
+转换成心跳 JSON 结构后与同一份数据的 frame.json（ESP_Post_Data 格式）逐字段比较：
+  - 元数据/通道标签/谐波/分类/绝缘：相同（浮点按 JSON 的小数位比较）
+  - 波形：差值 ≤ 量化误差（半峰峰值 / 32767 / 2，×200 后）+ 1（两边各自取整）；WAVE_Z 压缩段须逐点相同
+  - 频谱：差值 ≤ 0.1 + 3%（0.5 dB 对数量化 + JSON 1 位小数）
+  - 录波事件：原始码无损，差值 ≤ 1（×200 后取整）
+另测：改一个字节 -> CRC 拒收；插入未知段 -> 跳过且其余内容不变；SPOOL / TIME 段与 FLAG_SPOOL 解码。
+
+用法：python3 tools/frame_check/frame_roundtrip.py [frame_check 输出目录] [Edge_Wind_System 目录]
+全部通过返回 0
+"""
+import json
+import math
+import os
+import struct
+import sys
+import zlib
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+OUT = sys.argv[1] if len(sys.argv) > 1 else "."
+SERVER = sys.argv[2] if len(sys.argv) > 2 else os.path.join(HERE, "..", "..", "..", "Edge_Wind_System")
+sys.path.insert(0, os.path.abspath(SERVER))
+
+from edgewind.binframe import FrameError, decode_frame, to_heartbeat_payload  # noqa: E402
+
+fails = 0
+
+
+def check(name, ok, detail=""):
+    global fails
+    print(f"{name:<28} {'PASS' if ok else 'FAIL'} {detail}")
+    if not ok:
+        fails += 1
+
+
+with open(os.path.join(OUT, "frame.bin"), "rb") as f:
+    raw = f.read()
+with open(os.path.join(OUT, "frame.json"), "rb") as f:
+    ref_text = f.read()
+ref = json.loads(ref_text)
+
+frame = decode_frame(raw)
+got = to_heartbeat_payload(frame)
+
+meta_keys = ("node_id", "status", "fault_code", "seq", "sample_rate", "os_mode", "acq_profile")
+check("header", all(got[k] == ref[k] for k in meta_keys), str({k: got[k] for k in meta_keys}))
+
+for rc, gc in zip(ref["channels"], got["channels"]):
+    tag = f"ch{rc['id']} {rc['unit']}"
+    same = all(gc[k] == rc[k] for k in ("id", "channel_id", "label", "name", "unit"))
+    check(f"{tag} meta", same and abs(gc["value"] - rc["value"]) <= 1, f"value {gc['value']} / {rc['value']}")
+
+    rw, gw = rc["waveform"], gc["waveform"]
+    lossless = frame['channels'][rc['id']].get('wave_codec', False)
+    tol = 0.0 if lossless else (max(rw) - min(rw)) / 65534.0 / 2.0 + 1.0
+    err = max(abs(a - b) for a, b in zip(rw, gw)) if len(rw) == len(gw) else math.inf
+    check(f"{tag} waveform", err <= tol,
+          f"{len(gw)} pts, max err {err:.1f} (tol {tol:.1f}, x200 units{', codec' if lossless else ''})")
+
+    rs, gs = rc["fft_spectrum"], gc["fft_spectrum"]
+    worst = 0.0
+    for a, b in zip(rs, gs):
+        worst = max(worst, abs(a - b) / (0.1 + 0.03 * abs(a)))
+    check(f"{tag} spectrum", len(rs) == len(gs) and worst <= 1.0, f"{len(gs)} bins, worst err / tol {worst:.2f}")
+
+    herr = max(abs(a - b) for a, b in zip(rc["harmonics"], gc["harmonics"]))
+    check(f"{tag} harmonics", len(rc["harmonics"]) == len(gc["harmonics"]) and herr <= 1.5e-4, f"max err {herr:.2e}")
+
+rc_cls, gc_cls = ref["class"], got["class"]
+check("class", rc_cls["code"] == gc_cls["code"] and rc_cls["idx"] == gc_cls["idx"]
+      and abs(rc_cls["score"] - gc_cls["score"]) < 1e-3 and rc_cls["cyc"] == gc_cls["cyc"], str(gc_cls))
+ri, gi = ref["iso"], got["iso"]
+check("iso", ri["mode"] == gi["mode"] and gi["rate"] is None
+      and all(abs(ri[k] - gi[k]) < 0.05 for k in ("rp", "rn", "r", "trend")), str(gi))
+
+re_, ge = ref["event"], got["event"]
+same = all(re_[k] == ge[k] for k in ("seq", "fault_code", "trig_ch", "trig_type", "fs", "os_mode", "pre", "post",
+                                      "frames", "step"))
+everr = max(max(abs(a - b) for a, b in zip(r["waveform"], g["waveform"]))
+            for r, g in zip(re_["channels"], ge["channels"]))
+check("event", same and everr <= 1, f"{ge['frames']} frames step {ge['step']}, max err {everr}")
+
+# 损坏检测
+bad = bytearray(raw)
+bad[len(bad) // 2] ^= 0x40
+try:
+    decode_frame(bytes(bad))
+    check("corrupted frame rejected", False)
+except FrameError as e:
+    check("corrupted frame rejected", True, str(e))
+
+# 未知段：插在 CRC 之前，段数 +1，重算 CRC
+body = bytearray(raw[:-4]) + struct.pack("<BBHI", 0x7E, 0xFF, 0, 5) + b"hello"
+struct.pack_into("<H", body, 28, struct.unpack_from("<H", body, 28)[0] + 1)
+body += struct.pack("<I", zlib.crc32(body))
+fr = decode_frame(bytes(body))
+check("unknown section skipped", fr["unknown_sections"] == 1 and to_heartbeat_payload(fr) == got)
+
+# 断线缓存：实时帧附 SPOOL 段（补传进度，进心跳 JSON 的 "spool"）；缓存帧 flags 置位并附 TIME 段（采集 RTC 秒）
+body = bytearray(raw[:-4]) + struct.pack("<BBHI", 0x0A, 0xFF, 0, 24) + struct.pack("<IIIIIB3x", 12, 3, 640, 7, 1, 1)
+struct.pack_into("<H", body, 28, struct.unpack_from("<H", body, 28)[0] + 1)
+body += struct.pack("<I", zlib.crc32(body))
+fr = decode_frame(bytes(body))
+pl = to_heartbeat_payload(fr)
+sp = pl.pop("spool", None)
+check("spool progress section", not fr["spooled"] and pl == got and
+      sp == {"pending": 12, "pending_ev": 3, "kb": 640, "replayed": 7, "dropped": 1, "replaying": 1})
+body = bytearray(raw[:-4]) + struct.pack("<BBHI", 0x0B, 0xFF, 0, 8) + struct.pack("<II", 1767225600, 0)
+body[7] |= 0x01
+struct.pack_into("<H", body, 28, struct.unpack_from("<H", body, 28)[0] + 1)
+body += struct.pack("<I", zlib.crc32(body))
+fr = decode_frame(bytes(body))
+check("spooled frame flag + time", fr["spooled"] and fr["rtc_ts"] == 1767225600 and to_heartbeat_payload(fr) == got)
+
+print(f"binary {len(raw)} bytes, JSON {len(ref_text)} bytes -> x{len(ref_text) / len(raw):.2f} smaller")
+sys.exit(1 if fails else 0)
@@ -0,0 +1,283 @@
+/*
+ * 流水线上报在途窗口与回包解析主机测试（MDK-ARM/HARDWORK/ESP8266/esp_http_win.h，与固件同一份代码）
+ *
+ * 模拟请求入队（ESP_HttpWin_PushLocked）与 USART2 接收（ESP_HttpWin_RxFeed，可任意切块），检查：
+ *   - 状态行与 "seq":N 被切到任意两次接收之间（含逐字节送入）仍能识别，"seq": 后带空格也行
+ *   - 乱序：窗口里 1,2,3，先回 2 -> 1 记丢失、2 确认、3 保留；之后迟到的 1 记 late
+ *   - seq 对不上：回包序号不在窗口里记 late，请求留到超时出队（CanSend 里记 timeouts）
+ *   - 窗口满：HTTP_WINDOW 个在途时 CanSend 返回 0，回一个后恢复；超过 ESP_HTTP_WINDOW_MAX 挤掉最早的记丢失
+ *   - 非 2xx 对上最早的一个记 errors；不带 seq 的 2xx 等 ESP_HTTP_SEQ_WAIT_MS 或下一条状态行后按顺序确认；
+ *     心跳（seq 0）收到状态行即确认；接收出错 / 链路重置按丢失出队
+ *   - 每次出队都经 ESP_HttpWin_OnRetire 回调（固件给断线补传记结果），回调的 seq / ok 与预期一致
+ *
+ * 编译（在工程根目录）：
+ *   gcc -O2 -Wall -IMDK-ARM/HARDWORK/ESP8266 tools/httpwin_check/httpwin_check.c -o httpwin_check
+ * 用法：./httpwin_check
+ * 全部通过返回 0
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/* ================= 固件环境替身 ================= */
+
+#define ESP_HTTP_WINDOW_MAX 4 /* 与 esp8266.h 默认相同 */
+
+static uint32_t g_now;
+static uint32_t g_window = 2u;
+static const uint32_t g_timeout_ms = 1200u; /* ESP_HTTP_TIMEOUT_MS_DEFAULT */
+
+static uint32_t HAL_GetTick(void)
+{
+    return g_now;
+}
+
+static uint32_t __get_PRIMASK(void)
+{
+    return 0;
+}
+
+static void __disable_irq(void)
+{
+}
+
+static void __set_PRIMASK(uint32_t primask)
+{
+    (void)primask;
+}
+
+uint32_t ESP_CommParams_HttpTimeoutMs(void)
+{
+    return g_timeout_ms;
+}
+
+uint32_t ESP_CommParams_HttpWindow(void)
+{
+    return g_window;
+}
+
+#include "esp_http_win.h"
+
+/* 出队记录：seq，ok 在最高位 */
+#define RETIRE_OK 0x80000000u
+static uint32_t g_retired[32];
+static uint32_t g_retired_n;
+
+static void ESP_HttpWin_OnRetire(const esp_http_req_t *r, uint8_t ok, uint32_t now)
+{
+    (void)now;
+    if (g_retired_n < sizeof(g_retired) / sizeof(g_retired[0]))
+        g_retired[g_retired_n++] = r->seq | (ok ? RETIRE_OK : 0u);
+}
+
+/* ================= 测试 ================= */
+
+static int g_fails;
+
+static void check(const char *name, int ok)
+{
+    printf("  %-52s %s\n", name, ok ? "PASS" : "FAIL");
+    if (!ok)
+        g_fails++;
+}
+
+static void begin(const char *name, uint32_t window)
+{
+    if (name)
+        printf("%s:\n", name);
+    ESP_HttpWin_Reset();
+    memset(&s_win_stats, 0, sizeof(s_win_stats));
+    memset(g_retired, 0, sizeof(g_retired));
+    g_retired_n = 0;
+    g_window = window;
+    g_now = 1000u;
+}
+
+static void push(uint32_t seq)
+{
+    ESP_HttpWin_PushLocked(seq, 100u + seq, g_now);
+}
+
+/* 一次接收送入整段 */
+static void feed(const char *s)
+{
+    ESP_HttpWin_RxFeed((const uint8_t *)s, (uint16_t)strlen(s));
+}
+
+/* 每 step 字节切一块送入（step = 1 即逐字节） */
+static void feed_split(const char *s, uint32_t step)
+{
+    uint32_t len = (uint32_t)strlen(s);
+    for (uint32_t i = 0; i < len; i += step)
+    {
+        uint32_t n = (len - i < step) ? len - i : step;
+        ESP_HttpWin_RxFeed((const uint8_t *)s + i, (uint16_t)n);
+    }
+}
+
+/* 出队记录与期望完全一致（期望同样用 seq | RETIRE_OK） */
+static int retired_is(const uint32_t *want, uint32_t n)
+{
+    return g_retired_n == n && memcmp(g_retired, want, n * sizeof(uint32_t)) == 0;
+}
+
+static const char *resp(uint32_t seq)
+{
+    static char buf[160];
+    snprintf(buf, sizeof(buf),
+             "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: 28\r\n\r\n{\"ok\":true,\"seq\":%u}",
+             (unsigned)seq);
+    return buf;
+}
+
+static void test_split(void)
+{
+    begin("split status line / seq", 4u);
+    push(7);
+    feed("HTT");
+    feed("P/1.1 2");
+    feed("00 OK\r\nContent-Length: 20\r\n\r\n{\"se");
+    check("status line split: request still open", s_win.count == 1u && s_win.open);
+    feed("q\":");
+    feed("7");
+    check("seq digits not yet terminated: not retired", s_win.count == 1u);
+    feed("}");
+    const uint32_t w1[] = {7u | RETIRE_OK};
+    check("seq split across three reads -> acked", retired_is(w1, 1) && s_win.count == 0u && s_win_stats.acked == 1u);
+
+    for (uint32_t step = 1; step <= 9u; step++)
+    {
+        begin(step == 1u ? "split responses" : NULL, 4u);
+        push(11);
+        push(12);
+        feed_split(resp(11), step);
+        feed_split(resp(12), step);
+        const uint32_t w[] = {11u | RETIRE_OK, 12u | RETIRE_OK};
+        char name[64];
+        snprintf(name, sizeof(name), "two responses fed %u byte(s) at a time", (unsigned)step);
+        check(name, retired_is(w, 2) && s_win_stats.acked == 2u && s_win_stats.lost == 0u && s_win_stats.late == 0u);
+    }
+
+    begin("seq with space", 4u);
+    push(30);
+    feed("HTTP/1.1 201 Created\r\n\r\n{\"seq\": 30}");
+    const uint32_t w2[] = {30u | RETIRE_OK};
+    check("\"seq\": 30 -> acked", retired_is(w2, 1));
+}
+
+static void test_out_of_order(void)
+{
+    begin("out of order", 4u);
+    push(1);
+    push(2);
+    push(3);
+    g_now += 40u;
+    feed(resp(2));
+    const uint32_t w1[] = {1u, 2u | RETIRE_OK};
+    check("reply for 2 first: 1 lost, 2 acked", retired_is(w1, 2) && s_win_stats.lost == 1u && s_win_stats.acked == 1u);
+    check("3 still in flight", s_win.count == 1u && s_win.q[s_win.head].seq == 3u);
+    check("rtt measured from push", s_win_stats.rtt_last == 40u);
+
+    feed(resp(1));
+    check("late reply for 1 -> late, 3 untouched", s_win_stats.late == 1u && s_win.count == 1u && g_retired_n == 2u);
+    feed(resp(3));
+    const uint32_t w2[] = {1u, 2u | RETIRE_OK, 3u | RETIRE_OK};
+    check("reply for 3 -> acked", retired_is(w2, 3) && s_win.count == 0u);
+}
+
+static void test_seq_mismatch(void)
+{
+    begin("seq mismatch", 4u);
+    push(5);
+    feed(resp(9));
+    check("unknown seq -> late, request kept", s_win_stats.late == 1u && s_win.count == 1u && g_retired_n == 0u);
+    check("seq wait closed (no FIFO ack later)", !s_win.open);
+    g_now += ESP_HTTP_SEQ_WAIT_MS + 1u;
+    (void)ESP_HttpWin_CanSend();
+    check("not acked by seq-wait grace", s_win.count == 1u && s_win_stats.acked == 0u);
+    g_now += g_timeout_ms;
+    (void)ESP_HttpWin_CanSend();
+    const uint32_t w[] = {5u};
+    check("times out after HTTP_TIMEOUT_MS", retired_is(w, 1) && s_win_stats.timeouts == 1u && s_win.count == 0u);
+    feed(resp(5));
+    check("reply after timeout -> late", s_win_stats.late == 2u && g_retired_n == 1u);
+}
+
+static void test_full_window(void)
+{
+    begin("full window", 2u);
+    check("empty: can send", ESP_HttpWin_CanSend() == 1u);
+    push(1);
+    check("1 of 2: can send", ESP_HttpWin_CanSend() == 1u);
+    push(2);
+    check("2 of 2: blocked", ESP_HttpWin_CanSend() == 0u);
+    feed(resp(1));
+    check("reply frees a slot", ESP_HttpWin_CanSend() == 1u && s_win.count == 1u);
+
+    begin("window of 1", 1u);
+    push(1);
+    check("1 of 1: blocked", ESP_HttpWin_CanSend() == 0u);
+    g_now += g_timeout_ms;
+    check("timeout frees the slot", ESP_HttpWin_CanSend() == 1u && s_win_stats.timeouts == 1u);
+
+    begin("overflow beyond ESP_HTTP_WINDOW_MAX", ESP_HTTP_WINDOW_MAX);
+    for (uint32_t s = 1; s <= ESP_HTTP_WINDOW_MAX + 1u; s++)
+        push(s);
+    const uint32_t w[] = {1u};
+    check("oldest evicted as lost", retired_is(w, 1) && s_win_stats.lost == 1u && s_win.count == ESP_HTTP_WINDOW_MAX);
+    check("inflight_max capped", s_win_stats.inflight_max == ESP_HTTP_WINDOW_MAX);
+    feed(resp(ESP_HTTP_WINDOW_MAX + 1u));
+    check("reply for newest retires everything", s_win.count == 0u && s_win_stats.lost == ESP_HTTP_WINDOW_MAX);
+}
+
+static void test_misc(void)
+{
+    begin("non-2xx / no seq / heartbeat", 4u);
+    push(1);
+    push(2);
+    feed("HTTP/1.1 503 Service Unavailable\r\n\r\n");
+    const uint32_t w1[] = {1u};
+    check("503 retires oldest as error", retired_is(w1, 1) && s_win_stats.errors == 1u);
+    feed("HTTP/1.1 200 OK\r\n\r\n{\"ok\":true}");
+    check("2xx without seq waits", s_win.count == 1u && s_win.open);
+    g_now += ESP_HTTP_SEQ_WAIT_MS;
+    (void)ESP_HttpWin_CanSend();
+    const uint32_t w2[] = {1u, 2u | RETIRE_OK};
+    check("acked in order after seq wait", retired_is(w2, 2) && s_win.count == 0u);
+
+    push(3);
+    push(4);
+    feed("HTTP/1.1 200 OK\r\n\r\n{}");
+    feed("HTTP/1.1 200 OK\r\n\r\n{\"seq\":4}");
+    const uint32_t w3[] = {1u, 2u | RETIRE_OK, 3u | RETIRE_OK, 4u | RETIRE_OK};
+    check("next status line acks the seq-less one", retired_is(w3, 4) && s_win_stats.lost == 0u);
+
+    push(0);
+    feed("HTTP/1.1 200 OK\r\n");
+    check("heartbeat (seq 0) acked on status line", s_win.count == 0u && g_retired[4] == RETIRE_OK);
+
+    begin("rx error / reset", 4u);
+    push(1);
+    push(2);
+    push(3);
+    feed("HTTP/1.1 2");
+    ESP_HttpWin_OnRxError();
+    const uint32_t w4[] = {1u};
+    check("rx error: oldest lost, parser cleared", retired_is(w4, 1) && s_win_stats.lost == 1u && s_win.st_state == 0u);
+    feed("00 OK\r\n\r\n{\"seq\":2}");
+    check("tail of broken reply ignored", s_win.count == 2u && s_win_stats.acked == 0u);
+    ESP_HttpWin_Reset();
+    const uint32_t w5[] = {1u, 2u, 3u};
+    check("reset: all in-flight lost", retired_is(w5, 3) && s_win_stats.lost == 3u && s_win.count == 0u);
+}
+
+int main(void)
+{
+    test_split();
+    test_out_of_order();
+    test_seq_mismatch();
+    test_full_window();
+    test_misc();
+    printf("%s\n", g_fails ? "FAILED" : "ALL PASS");
+    return g_fails ? 1 : 0;
+}
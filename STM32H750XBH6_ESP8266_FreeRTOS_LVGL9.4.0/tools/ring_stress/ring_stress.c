@@ -0,0 +1,325 @@
+/*
+ * 采样块环多线程压力测试（Core/Src/ad_acq_buffers.c，与固件同一份代码，走 ad_atomic.h 的 C11 <stdatomic.h> 分支）
+ *
+ * 一个生产者线程全速 AD_Acq_PushFrame（模拟采样中断），若干消费者线程并发取块：
+ *   - latest：AD_Acq_AcquireLatest（DSP 任务的用法）
+ *   - next  ：AD_Acq_AcquireNext（需要连续数据的用法）
+ *   - slow  ：AcquireNext 后长时间持有（模拟被抢占的低优先级消费者），逼生产者丢帧
+ * 检查：
+ *   - 每个消费者取到的块序号严格递增；rd.skipped = 实际观察到的序号缺口之和
+ *   - 持有期间槽不被改写：每帧样本 = f(全局帧号, 通道)，取得时与释放前各核对一遍并比对槽校验和，
+ *     且槽的 seq 始终等于持有的块序号
+ *   - 块连续性：块内帧号连续；相邻块首帧号之差 - 块长 = 两块之间丢的帧，
+ *     累加（含上电过渡帧之后、第一个块之前的丢帧）必须等于 dropped_frames，
+ *     出现丢帧的块间隔数 ≤ drop_events ≤ blocks
+ *   - frames = 块内帧 + 过渡帧 + 丢帧 + 未写满的尾块帧
+ *
+ * 编译（在工程根目录；-DAD_ACQ_CH_MASK=0xFF 换成 8 通道 2 槽的配置再跑一遍）：
+ *   gcc -std=c11 -O2 -Wall -pthread -DAD_ACQ_POINTS=256 -ICore/Inc -IMDK-ARM/HARDWORK/AD7606 \
+ *       -IMiddlewares/Third_Party/FreeRTOS/Source/CMSIS_RTOS_V2 tools/ring_stress/ring_stress.c -o ring_stress
+ * 用法：./ring_stress [秒数，默认 2]
+ * 全部通过返回 0
+ */
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* ================= 最小 HAL/RTOS 替身（挡掉 main.h / SPI_AD7606.h / cmsis_os.h，ad_acq_buffers.c 直接包含进来） ================= */
+#define __MAIN_H
+#define _SPI_AD7606_H
+#define CMSIS_OS_H_
+
+#define __weak __attribute__((weak))
+
+/* 测试里不调用 AD_Acq_RequestProfile，GetStats 在线程全部退出后才读，关中断换成空操作即可 */
+static inline uint32_t __get_PRIMASK(void)
+{
+    return 0u;
+}
+static inline void __disable_irq(void)
+{
+}
+static inline void __set_PRIMASK(uint32_t m)
+{
+    (void)m;
+}
+
+static uint32_t HAL_GetTick(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000u + ts.tv_nsec / 1000000u);
+}
+
+static void osDelay(uint32_t ms)
+{
+    usleep(ms * 1000u);
+}
+
+typedef struct
+{
+    uint32_t arr;
+    uint32_t rate_hz;
+    uint8_t os_mode;
+} AD7606_Timing_t;
+
+static uint8_t AD7606_TimingPrepare(uint32_t rate_hz, uint8_t os_mode, AD7606_Timing_t *t)
+{
+    t->arr = 0u;
+    t->rate_hz = rate_hz;
+    t->os_mode = os_mode;
+    return 1u;
+}
+
+static void AD7606_TimingApply(const AD7606_Timing_t *t)
+{
+    (void)t;
+}
+
+#include "ad7606_calib.h"
+
+void AD7606_Cal_ApplyF(uint32_t ch, const int16_t *src, float *dst, uint32_t n)
+{
+    (void)ch;
+    for (uint32_t i = 0; i < n; i++)
+        dst[i] = (float)src[i];
+}
+
+void AD7606_Cal_ApplyQ15(uint32_t ch, const int16_t *src, int16_t *dst, uint32_t n)
+{
+    (void)ch;
+    memcpy(dst, src, n * sizeof(int16_t));
+}
+
+bool AD7606_Cal_SetOffsets(uint32_t ch_mask, const float offset[AD7606_CAL_CHANNELS])
+{
+    (void)ch_mask;
+    (void)offset;
+    return true;
+}
+
+#include "../../Core/Src/ad_acq_buffers.c"
+
+#if !defined(__STDC_VERSION__) || (__STDC_VERSION__ < 201112L) || defined(__STDC_NO_ATOMICS__)
+#error "ring_stress 需要 C11 原子（gcc -std=c11）"
+#endif
+
+/* ================= 测试 ================= */
+
+#define MAX_SEQ (1u << 22)
+
+/* 全局帧号 f 在物理通道 n 上的样本（帧号每 2^15 回绕，块长远小于此，足以识别改写） */
+static int16_t sample_of(uint32_t f, uint32_t n)
+{
+    return (int16_t)(((f * 7u) + (n * 4099u)) & 0x7FFFu);
+}
+
+static atomic_int g_stop;                   /* 线程间停止标志 */
+static uint32_t g_pushed;                  /* 生产者 PushFrame 次数 */
+static uint32_t g_settle;                  /* 返回 0 的过渡帧 */
+static uint32_t *g_first;                  /* g_first[seq] = 块首帧号（生产者发布时记录） */
+static uint32_t g_last_seq;
+
+typedef struct
+{
+    const char *name;
+    int latest;          /* 1=AcquireLatest，0=AcquireNext */
+    uint32_t hold_us;    /* 持有时长 */
+    AD_AcqReader_t rd;
+    uint32_t got;
+    uint32_t gaps;       /* 观察到的序号缺口之和 */
+    uint32_t first_seq;
+    uint32_t errors;
+} Consumer_t;
+
+static void *producer(void *arg)
+{
+    uint16_t raw[8];
+    uint32_t seen = 0;
+    (void)arg;
+
+    while (!atomic_load(&g_stop))
+    {
+        uint32_t f = s_frame_no; /* PushFrame 给这一帧分配的全局帧号 */
+        for (uint32_t n = 0; n < 8u; n++)
+            raw[n] = (uint16_t)sample_of(f, n);
+        if (!AD_Acq_PushFrame(raw))
+            g_settle++;
+        g_pushed++;
+        if (s_seq != seen)
+        {
+            seen = s_seq;
+            if (seen >= MAX_SEQ)
+                break;
+            g_first[seen] = s_slot[ACQ_LOAD(&s_pub_slot)].first_frame;
+            g_last_seq = seen;
+        }
+    }
+    atomic_store(&g_stop, 1);
+    return NULL;
+}
+
+/* 校验块内容：帧号连续、每个样本与帧号吻合；返回槽校验和，内容不符返回 ~0 并计错 */
+static uint32_t check_block(Consumer_t *c, const AD_AcqBlock_t *blk)
+{
+    uint32_t sum = 0;
+    for (uint32_t ch = 0; ch < AD_ACQ_CHANNELS; ch++)
+    {
+        uint32_t n = AD_Acq_PhysChannel(ch);
+        const int16_t *p = blk->data[ch];
+        for (uint32_t i = 0; i < AD_ACQ_POINTS; i++)
+        {
+            if (p[i] != sample_of(blk->first_frame + i, n))
+            {
+                if (c->errors++ < 5u)
+                    fprintf(stderr, "%s: seq %u ch %u [%u] = %d, expect %d\n", c->name, (unsigned)blk->seq,
+                            (unsigned)ch, (unsigned)i, p[i], sample_of(blk->first_frame + i, n));
+                return ~0u;
+            }
+            sum = (sum * 31u) ^ (uint16_t)p[i];
+        }
+    }
+    return sum;
+}
+
+static void *consumer(void *arg)
+{
+    Consumer_t *c = (Consumer_t *)arg;
+    AD_AcqBlock_t blk;
+
+    while (!atomic_load(&g_stop))
+    {
+        uint32_t prev = c->rd.last_seq;
+        int ok = c->latest ? AD_Acq_AcquireLatest(&c->rd, &blk) : AD_Acq_AcquireNext(&c->rd, &blk);
+        if (!ok)
+        {
+            sched_yield();
+            continue;
+        }
+
+        if (blk.seq <= prev)
+        {
+            if (c->errors++ < 5u)
+                fprintf(stderr, "%s: seq %u after %u\n", c->name, (unsigned)blk.seq, (unsigned)prev);
+        }
+        if (prev != 0u)
+            c->gaps += blk.seq - prev - 1u;
+        else
+            c->first_seq = blk.seq;
+        c->got++;
+
+        uint32_t a = check_block(c, &blk);
+        if (c->hold_us != 0u)
+            usleep(c->hold_us);
+        else
+            sched_yield();
+        uint32_t b = check_block(c, &blk);
+        if (a != b || ACQ_LOAD(&s_slot[blk.slot].seq) != blk.seq)
+        {
+            if (c->errors++ < 5u)
+                fprintf(stderr, "%s: slot %u rewritten while holding seq %u\n", c->name, (unsigned)blk.slot,
+                        (unsigned)blk.seq);
+        }
+        AD_Acq_Release(&blk);
+    }
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    double secs = (argc > 1) ? atof(argv[1]) : 2.0;
+    Consumer_t cons[] = {
+        {"latest", 1, 0u, {0, 0}, 0, 0, 0, 0},
+        {"next", 0, 0u, {0, 0}, 0, 0, 0, 0},
+        {"slow", 0, 2000u, {0, 0}, 0, 0, 0, 0},
+    };
+    const uint32_t nc = (uint32_t)(sizeof(cons) / sizeof(cons[0]));
+    pthread_t th[8];
+    int fail = 0;
+
+    g_first = calloc(MAX_SEQ + 1u, sizeof(uint32_t));
+    if (!g_first)
+        return 2;
+
+    AD_Acq_Init();
+    printf("ring_stress: %u ch x %u pts, %u slots, %u consumers, %.1f s\n", (unsigned)AD_ACQ_CHANNELS,
+           (unsigned)AD_ACQ_POINTS, (unsigned)AD_ACQ_RING_SLOTS, (unsigned)nc, secs);
+
+    for (uint32_t i = 0; i < nc; i++)
+        pthread_create(&th[i], NULL, consumer, &cons[i]);
+    pthread_create(&th[nc], NULL, producer, NULL);
+    usleep((useconds_t)(secs * 1e6));
+    atomic_store(&g_stop, 1);
+    for (uint32_t i = 0; i <= nc; i++)
+        pthread_join(th[i], NULL);
+
+    AD_AcqStats_t st;
+    AD_Acq_GetStats(&st);
+
+    /* 生产者侧：由块首帧号还原丢帧 */
+    uint32_t lost = 0, lost_gaps = 0;
+    uint32_t expect = g_settle; /* 上电档位生效后的第一个可用帧号 */
+    for (uint32_t s = 1; s <= g_last_seq; s++)
+    {
+        uint32_t d = g_first[s] - expect;
+        lost += d;
+        if (d != 0u)
+            lost_gaps++;
+        expect = g_first[s] + AD_ACQ_POINTS;
+    }
+    /* 最后一个块之后：未写满的尾块从 s_wr_first_frame 起，其前的帧都被丢弃；s_wr_slot<0 时尾部全丢 */
+    uint32_t tail = (s_wr_slot >= 0 && s_wr_pos != 0u) ? s_wr_pos : 0u;
+    lost += (tail != 0u) ? (s_wr_first_frame - expect) : (s_frame_no - expect);
+
+    printf("  producer: frames %u, blocks %u, dropped %u frames in %u events (observed %u frames, %u gaps)\n",
+           (unsigned)st.frames, (unsigned)st.blocks, (unsigned)st.dropped_frames, (unsigned)st.drop_events,
+           (unsigned)lost, (unsigned)lost_gaps);
+
+    if (st.frames != g_pushed || st.blocks != g_last_seq)
+    {
+        printf("  FAIL frames/blocks %u/%u, pushed %u/%u\n", (unsigned)st.frames, (unsigned)st.blocks,
+               (unsigned)g_pushed, (unsigned)g_last_seq);
+        fail = 1;
+    }
+    if (st.dropped_frames != lost)
+    {
+        printf("  FAIL dropped_frames %u != observed %u\n", (unsigned)st.dropped_frames, (unsigned)lost);
+        fail = 1;
+    }
+    if (lost_gaps > st.drop_events || st.drop_events > st.blocks)
+    {
+        printf("  FAIL drop_events %u (gaps %u, blocks %u)\n", (unsigned)st.drop_events, (unsigned)lost_gaps,
+               (unsigned)st.blocks);
+        fail = 1;
+    }
+    if (st.frames != st.blocks * AD_ACQ_POINTS + g_settle + st.dropped_frames + tail)
+    {
+        printf("  FAIL frame accounting\n");
+        fail = 1;
+    }
+    if (st.dropped_frames == 0u)
+    {
+        printf("  FAIL slow consumer never forced a drop (test did not exercise the full ring)\n");
+        fail = 1;
+    }
+
+    for (uint32_t i = 0; i < nc; i++)
+    {
+        Consumer_t *c = &cons[i];
+        int ok = (c->errors == 0u && c->got != 0u && c->rd.skipped == c->gaps);
+        printf("  %-6s %s got %u blocks seq %u..%u, skipped %u (observed %u), errors %u\n", c->name,
+               ok ? "PASS" : "FAIL", (unsigned)c->got, (unsigned)c->first_seq, (unsigned)c->rd.last_seq,
+               (unsigned)c->rd.skipped, (unsigned)c->gaps, (unsigned)c->errors);
+        if (!ok)
+            fail = 1;
+    }
+
+    free(g_first);
+    printf("%s\n", fail ? "FAILED" : "ALL PASS");
+    return fail;
+}
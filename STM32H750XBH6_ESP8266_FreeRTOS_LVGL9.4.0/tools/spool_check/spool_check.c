@@ -0,0 +1,486 @@
+/*
+ * SD 断线缓存主机测试（MDK-ARM/HARDWORK/SD_Card/sd_spool.c，与固件同一份代码）
+ *
+ * 用 POSIX 文件在临时目录里模拟 FatFs（只实现 sd_spool.c 用到的几个 f_* 接口），检查：
+ *   - 先进先出与优先级：事件级记录先补传，同级按写入顺序；分块读出的负载与写入逐字节相同
+ *   - 掉电恢复：追加到一半掉电（残缺尾部）、尾部混入垃圾 -> 上电扫描截掉，之前的记录不丢
+ *   - 读游标：两份交替覆盖，写游标时掉电坏掉较新的一份 -> 退回上一份（多补传一条，不丢）
+ *   - 负载 CRC 不对的记录跳过并计 dropped；读完的段删除
+ *   - 配额：超出时先挤最早的普通段，事件段保留，剩下的是最新的连续记录
+ *
+ * 编译（在工程根目录，段长改小以便测多段与配额）：
+ *   gcc -O2 -Wall -DSD_SPOOL_SEG_KB=64 -ICore/Inc -IMDK-ARM/HARDWORK/SD_Card -IMiddlewares/Third_Party/FatFs/src \
+ *       tools/spool_check/spool_check.c Core/Src/ad_frame.c Core/Src/ad_codec.c Core/Src/ad_stats.c -lm -o spool_check
+ * 用法：./spool_check
+ * 全部通过返回 0
+ */
+#define _GNU_SOURCE
+#include <dirent.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* ================= 最小 FatFs 替身（挡掉 ff.h / SD.h，sd_spool.c 直接包含进来） ================= */
+#define _FATFS 1
+#define SD_H
+
+typedef unsigned int UINT;
+typedef char TCHAR;
+typedef uint32_t FSIZE_t;
+
+typedef enum {
+	FR_OK = 0,
+	FR_DISK_ERR,
+	FR_NO_FILE,
+	FR_DENIED,
+} FRESULT;
+
+typedef struct {
+	FILE *fp;
+} FIL;
+
+typedef struct {
+	DIR *d;
+} FF_DIR;
+#define DIR FF_DIR
+
+typedef struct {
+	uint8_t fattrib;
+	char fname[256];
+} FILINFO;
+
+#define FA_READ          0x01
+#define FA_WRITE         0x02
+#define FA_CREATE_ALWAYS 0x08
+#define AM_DIR           0x10
+
+static char g_root[256];
+static int g_fail_sync; /* 置 1 时 f_sync 失败（模拟 SD 写错误） */
+
+static void host_path(char *out, size_t len, const char *path)
+{
+	if (strncmp(path, "0:", 2) == 0) {
+		path += 2;
+	}
+	(void)snprintf(out, len, "%s%s", g_root, path);
+}
+
+static FRESULT f_open(FIL *fil, const char *path, uint8_t mode)
+{
+	char p[512];
+	host_path(p, sizeof(p), path);
+	const char *m = (mode & FA_CREATE_ALWAYS) ? "w+b" : ((mode & FA_WRITE) ? "r+b" : "rb");
+	fil->fp = fopen(p, m);
+	return fil->fp ? FR_OK : FR_NO_FILE;
+}
+
+static FRESULT f_close(FIL *fil)
+{
+	if (fil->fp) {
+		fclose(fil->fp);
+		fil->fp = NULL;
+	}
+	return FR_OK;
+}
+
+static FRESULT f_lseek(FIL *fil, FSIZE_t off)
+{
+	return (fseek(fil->fp, (long)off, SEEK_SET) == 0) ? FR_OK : FR_DISK_ERR;
+}
+
+static FRESULT f_read(FIL *fil, void *buf, UINT n, UINT *br)
+{
+	*br = (UINT)fread(buf, 1, n, fil->fp);
+	return ferror(fil->fp) ? FR_DISK_ERR : FR_OK;
+}
+
+static FRESULT f_write(FIL *fil, const void *buf, UINT n, UINT *bw)
+{
+	*bw = (UINT)fwrite(buf, 1, n, fil->fp);
+	return (*bw == n) ? FR_OK : FR_DISK_ERR;
+}
+
+static FRESULT f_sync(FIL *fil)
+{
+	return (!g_fail_sync && fflush(fil->fp) == 0) ? FR_OK : FR_DISK_ERR;
+}
+
+static FRESULT f_truncate(FIL *fil)
+{
+	fflush(fil->fp);
+	return (ftruncate(fileno(fil->fp), ftell(fil->fp)) == 0) ? FR_OK : FR_DISK_ERR;
+}
+
+static FSIZE_t f_size_host(FIL *fil)
+{
+	struct stat st;
+	fflush(fil->fp);
+	return (fstat(fileno(fil->fp), &st) == 0) ? (FSIZE_t)st.st_size : 0u;
+}
+#define f_size(fil) f_size_host(fil)
+
+static FRESULT f_unlink(const char *path)
+{
+	char p[512];
+	host_path(p, sizeof(p), path);
+	return (unlink(p) == 0) ? FR_OK : FR_NO_FILE;
+}
+
+static FRESULT f_opendir(DIR *dj, const char *path)
+{
+	char p[512];
+	host_path(p, sizeof(p), path);
+	dj->d = opendir(p);
+	return dj->d ? FR_OK : FR_NO_FILE;
+}
+
+static FRESULT f_readdir(DIR *dj, FILINFO *fno)
+{
+	struct dirent *e;
+	do {
+		e = readdir(dj->d);
+	} while (e && e->d_name[0] == '.');
+	fno->fname[0] = '\0';
+	fno->fattrib = 0;
+	if (e) {
+		(void)snprintf(fno->fname, sizeof(fno->fname), "%s", e->d_name);
+		fno->fattrib = (e->d_type == DT_DIR) ? AM_DIR : 0;
+	}
+	return FR_OK;
+}
+
+static FRESULT f_closedir(DIR *dj)
+{
+	closedir(dj->d);
+	return FR_OK;
+}
+
+static FRESULT SD_Init(void)
+{
+	return FR_OK;
+}
+
+static FRESULT SD_MkdirRecursive(const char *path)
+{
+	char p[512];
+	host_path(p, sizeof(p), path);
+	return (mkdir(p, 0755) == 0 || access(p, F_OK) == 0) ? FR_OK : FR_DENIED;
+}
+
+static bool SD_FileExists(const char *path)
+{
+	char p[512];
+	host_path(p, sizeof(p), path);
+	return access(p, F_OK) == 0;
+}
+
+uint32_t SD_Time_GetUnix(void)
+{
+	return 1767225600u;
+}
+
+#include "sd_spool.c"
+
+/* ================= 测试 ================= */
+
+static int g_fails;
+
+static void check(const char *name, int ok, const char *detail)
+{
+	printf("%-36s %s %s\n", name, ok ? "PASS" : "FAIL", detail ? detail : "");
+	if (!ok) {
+		g_fails++;
+	}
+}
+
+/* 记录负载由 seq 决定（长度与内容），读回时可重算核对 */
+static uint32_t rec_len(uint32_t seq)
+{
+	return 200u + (seq * 7919u) % 30000u;
+}
+
+static uint8_t rec_byte(uint32_t seq, uint32_t i)
+{
+	return (uint8_t)(seq * 31u + i * 17u + (i >> 8));
+}
+
+static bool append(uint8_t prio, uint32_t seq)
+{
+	static uint8_t buf[4096];
+	uint32_t n = rec_len(seq);
+	if (!SD_Spool_AppendBegin(prio, seq, seq * 10u)) {
+		return false;
+	}
+	for (uint32_t off = 0; off < n;) {
+		uint32_t k = (n - off < sizeof(buf)) ? n - off : (uint32_t)sizeof(buf);
+		for (uint32_t i = 0; i < k; ++i) {
+			buf[i] = rec_byte(seq, off + i);
+		}
+		if (!SD_Spool_AppendData(buf, k)) {
+			SD_Spool_AppendAbort();
+			return false;
+		}
+		off += k;
+	}
+	return SD_Spool_AppendEnd();
+}
+
+/* 取下一条并核对负载（按 3000 字节分块读，与发送段不对齐）；返回 seq，没有返回 0，负载不符返回 ~0 */
+static uint32_t take(bool commit)
+{
+	static uint8_t buf[3000];
+	SD_SpoolRec_t r;
+	if (!SD_Spool_Peek(&r)) {
+		return 0u;
+	}
+	uint32_t got = 0, n;
+	bool same = (r.len == rec_len(r.seq)) && (r.tick == r.seq * 10u);
+	while ((n = SD_Spool_Read(buf, sizeof(buf))) > 0u) {
+		for (uint32_t i = 0; i < n; ++i) {
+			same = same && (buf[i] == rec_byte(r.seq, got + i));
+		}
+		got += n;
+	}
+	if (!same || got != r.len) {
+		return ~0u;
+	}
+	if (commit) {
+		(void)SD_Spool_Commit(true);
+	}
+	return r.seq;
+}
+
+static uint32_t pending(void)
+{
+	SD_SpoolStats_t st;
+	SD_Spool_GetStats(&st);
+	return st.pending[SD_SPOOL_PRIO_EVENT] + st.pending[SD_SPOOL_PRIO_NORMAL];
+}
+
+static void wipe(void)
+{
+	char cmd[600];
+	(void)snprintf(cmd, sizeof(cmd), "rm -rf '%s/spool'", g_root);
+	(void)system(cmd);
+	SD_Spool_SetQuotaMb(SD_SPOOL_QUOTA_MB);
+	(void)SD_Spool_Init();
+}
+
+/* 当前最早普通段的文件路径（用于直接改盘上内容） */
+static void head_path(char *out, size_t len, uint8_t prio)
+{
+	char p[40];
+	sd_spool_path(p, sizeof(p), prio, s_q[prio].first);
+	host_path(out, len, p);
+}
+
+static void test_order(void)
+{
+	char d[96];
+	wipe();
+	bool ok = true;
+	for (uint32_t s = 1; s <= 10; ++s) {
+		ok = ok && append(SD_SPOOL_PRIO_NORMAL, s);
+	}
+	for (uint32_t s = 11; s <= 13; ++s) {
+		ok = ok && append(SD_SPOOL_PRIO_EVENT, s);
+	}
+	SD_SpoolStats_t st;
+	SD_Spool_GetStats(&st);
+	(void)snprintf(d, sizeof(d), "%lu segs, max_seq %lu", (unsigned long)st.segs, (unsigned long)st.max_seq);
+	check("append 13 records", ok && pending() == 13u && st.segs > 2u && st.max_seq == 13u, d);
+
+	static const uint32_t want[] = {11, 12, 13, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+	ok = true;
+	for (uint32_t i = 0; i < 13u; ++i) {
+		ok = ok && take(true) == want[i];
+	}
+	SD_Spool_GetStats(&st);
+	(void)snprintf(d, sizeof(d), "replayed %lu, segs left %lu", (unsigned long)st.replayed, (unsigned long)st.segs);
+	check("events first, then FIFO, payload ok", ok && take(false) == 0u && st.replayed == 13u && st.segs <= 2u, d);
+}
+
+static void test_torn_tail(void)
+{
+	char d[96];
+	wipe();
+	bool ok = true;
+	for (uint32_t s = 1; s <= 5; ++s) {
+		ok = ok && append(SD_SPOOL_PRIO_NORMAL, s);
+	}
+	/* 第 6 条写到一半掉电：占位头 + 部分负载已在盘上，记录头没写 */
+	static uint8_t junk[5000];
+	memset(junk, 0x5A, sizeof(junk));
+	ok = ok && SD_Spool_AppendBegin(SD_SPOOL_PRIO_NORMAL, 6u, 60u) && SD_Spool_AppendData(junk, sizeof(junk));
+	(void)f_close(&s_wr.fil);
+	s_wr.open = 0;
+
+	ok = ok && SD_Spool_Init();
+	SD_SpoolStats_t st;
+	SD_Spool_GetStats(&st);
+	(void)snprintf(d, sizeof(d), "pending %lu, repaired %lu", (unsigned long)pending(), (unsigned long)st.repaired);
+	check("power loss mid-append: tail cut", ok && pending() == 5u && st.repaired == 1u, d);
+
+	/* 截完之后照常追加，尾部再混进一段垃圾（不是完整记录头） */
+	ok = append(SD_SPOOL_PRIO_NORMAL, 7u);
+	char p[512];
+	{
+		char sp[40];
+		sd_spool_path(sp, sizeof(sp), SD_SPOOL_PRIO_NORMAL, s_q[SD_SPOOL_PRIO_NORMAL].last);
+		host_path(p, sizeof(p), sp);
+	}
+	FILE *fp = fopen(p, "ab");
+	ok = ok && fp && fwrite(junk, 1, 100, fp) == 100u;
+	if (fp) {
+		fclose(fp);
+	}
+	ok = ok && SD_Spool_Init();
+	static const uint32_t want[] = {1, 2, 3, 4, 5, 7};
+	for (uint32_t i = 0; i < 6u; ++i) {
+		ok = ok && take(true) == want[i];
+	}
+	check("garbage tail cut, records intact", ok && take(false) == 0u, NULL);
+}
+
+static void test_cursor(void)
+{
+	char d[96];
+	wipe();
+	bool ok = true;
+	for (uint32_t s = 1; s <= 5; ++s) {
+		ok = ok && append(SD_SPOOL_PRIO_NORMAL, s);
+	}
+	ok = ok && take(true) == 1u && take(true) == 2u;
+	ok = ok && SD_Spool_Init();
+	(void)snprintf(d, sizeof(d), "pending %lu", (unsigned long)pending());
+	check("cursor survives reboot", ok && pending() == 3u && take(false) == 3u, d);
+
+	/* 写第 3 次游标时掉电：较新的一份（gen 3，slot 1）坏掉 -> 退回 gen 2 */
+	ok = take(true) == 3u;
+	uint32_t slot = s_q[SD_SPOOL_PRIO_NORMAL].rd.gen & 1u;
+	char p[512];
+	head_path(p, sizeof(p), SD_SPOOL_PRIO_NORMAL);
+	FILE *fp = fopen(p, "r+b");
+	long off = (long)(offsetof(SD_SpoolSegHeader_t, cur) + slot * sizeof(SD_SpoolCursor_t) + 4u);
+	ok = ok && fp && fseek(fp, off, SEEK_SET) == 0 && fputc(0xEE, fp) != EOF;
+	if (fp) {
+		fclose(fp);
+	}
+	ok = ok && SD_Spool_Init();
+	(void)snprintf(d, sizeof(d), "pending %lu", (unsigned long)pending());
+	check("torn cursor: falls back one record", ok && pending() == 3u && take(true) == 3u && take(true) == 4u, d);
+}
+
+static void test_bad_payload(void)
+{
+	char d[96];
+	wipe();
+	bool ok = true;
+	for (uint32_t s = 1; s <= 3; ++s) {
+		ok = ok && append(SD_SPOOL_PRIO_NORMAL, s);
+	}
+	/* 改第 2 条负载中间一个字节（记录头不变，上电扫描查不出，补传前校验负载时发现） */
+	char p[512];
+	head_path(p, sizeof(p), SD_SPOOL_PRIO_NORMAL);
+	long off = (long)(SD_SPOOL_SEG_HDR_LEN + SD_SPOOL_REC_HDR_LEN + rec_len(1u) + SD_SPOOL_REC_HDR_LEN + 50u);
+	FILE *fp = fopen(p, "r+b");
+	ok = ok && fp && fseek(fp, off, SEEK_SET) == 0 && fputc(~rec_byte(2u, 50u) & 0xFF, fp) != EOF;
+	if (fp) {
+		fclose(fp);
+	}
+	ok = ok && take(true) == 1u && take(true) == 3u && take(false) == 0u;
+	SD_SpoolStats_t st;
+	SD_Spool_GetStats(&st);
+	(void)snprintf(d, sizeof(d), "dropped %lu", (unsigned long)st.dropped);
+	check("bad payload skipped", ok && st.dropped == 1u, d);
+}
+
+static void test_quota(void)
+{
+	char d[128];
+	wipe();
+	SD_Spool_SetQuotaMb(1u);
+	bool ok = true;
+	for (uint32_t s = 1; s <= 4; ++s) {
+		ok = ok && append(SD_SPOOL_PRIO_EVENT, s);
+	}
+	uint32_t s = 5;
+	for (; s <= 200; ++s) {
+		ok = ok && append(SD_SPOOL_PRIO_NORMAL, s);
+	}
+	SD_SpoolStats_t st;
+	SD_Spool_GetStats(&st);
+	(void)snprintf(d, sizeof(d), "disk %lu KB / %lu KB, dropped %lu recs %lu segs", (unsigned long)(st.disk_bytes / 1024u),
+	               (unsigned long)(st.quota_bytes / 1024u), (unsigned long)st.dropped, (unsigned long)st.dropped_segs);
+	check("quota enforced", ok && st.disk_bytes <= st.quota_bytes && st.dropped > 0u, d);
+
+	/* 事件全部保留，普通记录是最新的一段连续序号，一直到最后写的那条 */
+	ok = true;
+	for (uint32_t e = 1; e <= 4; ++e) {
+		ok = ok && take(true) == e;
+	}
+	uint32_t first = take(true), prev = first, n = 1, q;
+	while ((q = take(true)) != 0u) {
+		ok = ok && q == prev + 1u;
+		prev = q;
+		n++;
+	}
+	(void)snprintf(d, sizeof(d), "kept seq %lu..%lu (%lu)", (unsigned long)first, (unsigned long)prev, (unsigned long)n);
+	check("events kept, oldest normal evicted", ok && prev == 200u && first > 5u && n + st.dropped == 196u, d);
+
+	/* 只剩事件时配额不够：挤事件段 */
+	wipe();
+	SD_Spool_SetQuotaMb(1u);
+	ok = true;
+	for (s = 1; s <= 100; ++s) {
+		ok = ok && append(SD_SPOOL_PRIO_EVENT, s);
+	}
+	SD_Spool_GetStats(&st);
+	(void)snprintf(d, sizeof(d), "disk %lu KB, dropped %lu", (unsigned long)(st.disk_bytes / 1024u), (unsigned long)st.dropped);
+	check("events-only quota", ok && st.disk_bytes <= st.quota_bytes && st.dropped > 0u && take(false) > 1u, d);
+}
+
+static void test_sync_fail(void)
+{
+	wipe();
+	bool ok = append(SD_SPOOL_PRIO_NORMAL, 1u);
+	g_fail_sync = 1;
+	bool bad = append(SD_SPOOL_PRIO_NORMAL, 2u);
+	g_fail_sync = 0;
+	ok = ok && !bad && append(SD_SPOOL_PRIO_NORMAL, 3u);
+	ok = ok && SD_Spool_Init() && take(true) == 1u;
+	uint32_t t = take(true);
+	/* 同步失败的那条：记录头可能已写上（宿主机文件其实写成功了），有就照常补传 */
+	if (t == 2u) {
+		t = take(true);
+	}
+	check("write error does not corrupt", ok && t == 3u && take(false) == 0u, NULL);
+}
+
+int main(void)
+{
+	char tmpl[] = "/tmp/spool_check.XXXXXX";
+	if (!mkdtemp(tmpl)) {
+		perror("mkdtemp");
+		return 2;
+	}
+	(void)snprintf(g_root, sizeof(g_root), "%s", tmpl);
+	printf("segment %u KB, record reserve %u KB, dir %s\n", (unsigned)SD_SPOOL_SEG_KB,
+	       (unsigned)(SD_SPOOL_REC_RESERVE / 1024u), g_root);
+
+	test_order();
+	test_torn_tail();
+	test_cursor();
+	test_bad_payload();
+	test_quota();
+	test_sync_fail();
+
+	char cmd[300];
+	(void)snprintf(cmd, sizeof(cmd), "rm -rf '%s'", g_root);
+	(void)system(cmd);
+	return g_fails ? 1 : 0;
+}